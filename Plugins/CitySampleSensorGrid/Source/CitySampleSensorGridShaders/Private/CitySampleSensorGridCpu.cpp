@@ -0,0 +1,948 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CitySampleSensorGridCpu.h"
+
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+
+namespace CitySampleSensorGridCpu
+{
+	static const uint32 InvalidLeafIndex = 0xFFFFFFFF;
+	static const uint32 ClearedDistanceUint = 0x7F000000;
+	static const int32 TraversalChunkSize = 64;
+
+	// number of source sensors that are traversed together, one per lane of a vector register
+	static const uint32 SensorsPerPacket = 4;
+
+	static uint32 AsUint(float Value)
+	{
+		uint32 Result;
+		FMemory::Memcpy(&Result, &Value, sizeof(Result));
+		return Result;
+	}
+
+	static float AsFloat(uint32 Value)
+	{
+		float Result;
+		FMemory::Memcpy(&Result, &Value, sizeof(Result));
+		return Result;
+	}
+
+	// Expands a 10-bit integer into 30 bits
+	// by inserting 2 zeros after each bit.
+	static uint32 ExpandBits(uint32 v)
+	{
+		v = (v * 0x00010001u) & 0xFF0000FFu;
+		v = (v * 0x00000101u) & 0x0F00F00Fu;
+		v = (v * 0x00000011u) & 0xC30C30C3u;
+		v = (v * 0x00000005u) & 0x49249249u;
+		return v;
+	}
+
+	// matches clamp(Value * 512.0f, 0.0f, 511.0f) followed by the cast to uint in the shader, NaN ends up in the first bucket
+	static uint32 ToBucket(float Value)
+	{
+		const float Scaled = Value * 512.0f;
+		if (!(Scaled > 0.0f))
+		{
+			return 0;
+		}
+		return Scaled < 511.0f ? (uint32)Scaled : 511u;
+	}
+
+	static float MaxZero(float Value)
+	{
+		return Value > 0.0f ? Value : 0.0f;
+	}
+
+	static float MinFloat(float A, float B)
+	{
+		return A < B ? A : B;
+	}
+
+	static float MaxFloat(float A, float B)
+	{
+		return A > B ? A : B;
+	}
+
+	// the squares are computed as separate statements so that the compiler can't fuse them into FMAs, which
+	// keeps the scalar and vectorized paths in agreement
+	static float SumOfSquares(float X, float Y, float Z)
+	{
+		const float XX = X * X;
+		const float YY = Y * Y;
+		const float ZZ = Z * Z;
+		return (XX + YY) + ZZ;
+	}
+
+	// lane wise equivalent of SumOfSquares, the operations are done in the same order so every lane matches the scalar result
+	static VectorRegister4Float SumOfSquares(const VectorRegister4Float& X, const VectorRegister4Float& Y, const VectorRegister4Float& Z)
+	{
+		return VectorAdd(VectorAdd(VectorMultiply(X, X), VectorMultiply(Y, Y)), VectorMultiply(Z, Z));
+	}
+
+	static VectorRegister4Float MaxZero(const VectorRegister4Float& Value)
+	{
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		return VectorSelect(VectorCompareGT(Value, Zero), Value, Zero);
+	}
+
+	// mirrors CountLeadingZeroes in the shader, which is based on firstbithigh and so returns one more than the usual count
+	static int32 CountLeadingZeroes(uint32 Value)
+	{
+		const int32 FirstBitHigh = Value ? (int32)FMath::FloorLog2(Value) : -1;
+		return 32 - FirstBitHigh;
+	}
+
+	static int32 DeltaFunction(const TArray<uint32>& MortonCodes, uint32 I, uint32 MortonI, int32 J)
+	{
+		if (J < 0 || J > MortonCodes.Num() - 1)
+		{
+			return -1;
+		}
+
+		const uint32 MortonJ = MortonCodes[J];
+
+		if (MortonI == MortonJ)
+		{
+			return 32 + CountLeadingZeroes(I ^ (uint32)J);
+		}
+
+		return CountLeadingZeroes(MortonI ^ MortonJ);
+	}
+
+	static FUintVector2 DetermineRange(const TArray<uint32>& MortonCodes, int32 LocalNodeIndex, uint32 CurrentKey)
+	{
+		const int32 ReverseCount = DeltaFunction(MortonCodes, LocalNodeIndex, CurrentKey, LocalNodeIndex - 1);
+		const int32 ForwardCount = DeltaFunction(MortonCodes, LocalNodeIndex, CurrentKey, LocalNodeIndex + 1);
+
+		const bool ForwardSearch = (ForwardCount > ReverseCount);
+		const int32 Dir = ForwardSearch ? 1 : -1;
+		const int32 MinCount = ForwardSearch ? ReverseCount : ForwardCount;
+
+		int32 GrowthStride = 2;
+		while (DeltaFunction(MortonCodes, LocalNodeIndex, CurrentKey, LocalNodeIndex + Dir * GrowthStride) > MinCount)
+		{
+			GrowthStride <<= 4;
+		}
+
+		int32 Increment = 0;
+		for (int32 ShrinkStride = GrowthStride >> 1; ShrinkStride > 0; ShrinkStride >>= 1)
+		{
+			if (DeltaFunction(MortonCodes, LocalNodeIndex, CurrentKey, LocalNodeIndex + Dir * (ShrinkStride + Increment)) > MinCount)
+			{
+				Increment += ShrinkStride;
+			}
+		}
+
+		if (ForwardSearch)
+		{
+			return FUintVector2(LocalNodeIndex, LocalNodeIndex + Increment);
+		}
+		return FUintVector2(LocalNodeIndex - Increment, LocalNodeIndex);
+	}
+
+	static uint32 FindSplit(const TArray<uint32>& MortonCodes, uint32 LeftIndex, uint32 RightIndex)
+	{
+		const uint32 LeftKey = MortonCodes[LeftIndex];
+		const uint32 RightKey = MortonCodes[RightIndex];
+
+		if (LeftKey == RightKey)
+		{
+			return (LeftIndex + RightIndex) >> 1;
+		}
+
+		const int32 PrefixCount = CountLeadingZeroes(LeftKey ^ RightKey);
+
+		uint32 Split = LeftIndex;
+		uint32 Stride = RightIndex - LeftIndex;
+
+		do
+		{
+			Stride = (Stride + 1) >> 1;
+			if (Split + Stride < RightIndex)
+			{
+				if (DeltaFunction(MortonCodes, LeftIndex, LeftKey, Split + Stride) > PrefixCount)
+				{
+					Split += Stride;
+				}
+			}
+		}
+		while (Stride > 1);
+
+		return Split;
+	}
+
+	static void AggregateBounds(const FVector4f* Sensors, const TArray<FCitySampleSensorGridCpuHelper::FInternalNode>& InternalNodes, int32 ChildIndex, FVector3f& BoundsMin, FVector3f& BoundsMax)
+	{
+		if (ChildIndex < 0)
+		{
+			const FVector4f& SensorLocation = Sensors[~ChildIndex];
+			if (SensorLocation.W >= 0.0f)
+			{
+				BoundsMin = FVector3f(MinFloat(SensorLocation.X - SensorLocation.W, BoundsMin.X), MinFloat(SensorLocation.Y - SensorLocation.W, BoundsMin.Y), MinFloat(SensorLocation.Z - SensorLocation.W, BoundsMin.Z));
+				BoundsMax = FVector3f(MaxFloat(SensorLocation.X + SensorLocation.W, BoundsMax.X), MaxFloat(SensorLocation.Y + SensorLocation.W, BoundsMax.Y), MaxFloat(SensorLocation.Z + SensorLocation.W, BoundsMax.Z));
+			}
+		}
+		else if (ChildIndex)
+		{
+			const FCitySampleSensorGridCpuHelper::FInternalNode& Child = InternalNodes[ChildIndex];
+			BoundsMin = FVector3f(MinFloat(Child.BoundsMin.X, BoundsMin.X), MinFloat(Child.BoundsMin.Y, BoundsMin.Y), MinFloat(Child.BoundsMin.Z, BoundsMin.Z));
+			BoundsMax = FVector3f(MaxFloat(Child.BoundsMax.X, BoundsMax.X), MaxFloat(Child.BoundsMax.Y, BoundsMax.Y), MaxFloat(Child.BoundsMax.Z, BoundsMax.Z));
+		}
+	}
+
+	static bool TestOverlap(const FCitySampleSensorGridCpuHelper::FInternalNode& Node, const FVector4f& SensorLocation, uint32 RadiusSqrUint)
+	{
+		const FVector3f NodeBoundsCenter(0.5f * (Node.BoundsMin.X + Node.BoundsMax.X), 0.5f * (Node.BoundsMin.Y + Node.BoundsMax.Y), 0.5f * (Node.BoundsMin.Z + Node.BoundsMax.Z));
+		const FVector3f NodeBoundsExtent = NodeBoundsCenter - Node.BoundsMin;
+
+		const float AxisDistanceX = MaxZero(FMath::Abs(SensorLocation.X - NodeBoundsCenter.X) - NodeBoundsExtent.X);
+		const float AxisDistanceY = MaxZero(FMath::Abs(SensorLocation.Y - NodeBoundsCenter.Y) - NodeBoundsExtent.Y);
+		const float AxisDistanceZ = MaxZero(FMath::Abs(SensorLocation.Z - NodeBoundsCenter.Z) - NodeBoundsExtent.Z);
+
+		return AsUint(SumOfSquares(AxisDistanceX, AxisDistanceY, AxisDistanceZ)) < RadiusSqrUint;
+	}
+
+	// TestOverlap for a packet of sensors held in SoA registers, returns one bit per lane that overlaps the node
+	static uint32 TestOverlapPacket(const FCitySampleSensorGridCpuHelper::FInternalNode& Node, const VectorRegister4Float& SensorX, const VectorRegister4Float& SensorY, const VectorRegister4Float& SensorZ, const uint32* RadiusSqrUint)
+	{
+		// the center and extent are computed once per node exactly as in the scalar test, then compared against all the lanes
+		const FVector3f NodeBoundsCenter(0.5f * (Node.BoundsMin.X + Node.BoundsMax.X), 0.5f * (Node.BoundsMin.Y + Node.BoundsMax.Y), 0.5f * (Node.BoundsMin.Z + Node.BoundsMax.Z));
+		const FVector3f NodeBoundsExtent = NodeBoundsCenter - Node.BoundsMin;
+
+		const VectorRegister4Float AxisDistanceX = MaxZero(VectorSubtract(VectorAbs(VectorSubtract(SensorX, VectorSetFloat1(NodeBoundsCenter.X))), VectorSetFloat1(NodeBoundsExtent.X)));
+		const VectorRegister4Float AxisDistanceY = MaxZero(VectorSubtract(VectorAbs(VectorSubtract(SensorY, VectorSetFloat1(NodeBoundsCenter.Y))), VectorSetFloat1(NodeBoundsExtent.Y)));
+		const VectorRegister4Float AxisDistanceZ = MaxZero(VectorSubtract(VectorAbs(VectorSubtract(SensorZ, VectorSetFloat1(NodeBoundsCenter.Z))), VectorSetFloat1(NodeBoundsExtent.Z)));
+
+		// the distances are compared as uints like the shader does, which also keeps NaNs behaving the same as in the scalar test
+		alignas(16) float DistanceSqr[SensorsPerPacket];
+		VectorStoreAligned(SumOfSquares(AxisDistanceX, AxisDistanceY, AxisDistanceZ), DistanceSqr);
+
+		uint32 OverlapMask = 0;
+		for (uint32 Lane = 0; Lane < SensorsPerPacket; ++Lane)
+		{
+			OverlapMask |= (AsUint(DistanceSqr[Lane]) < RadiusSqrUint[Lane]) ? (1u << Lane) : 0u;
+		}
+		return OverlapMask;
+	}
+};
+
+FCitySampleSensorGridCpuHelper::FCitySampleSensorGridCpuHelper(const FUintVector4& InSensorGridDimensions, EExecutionMode InExecutionMode)
+	: SensorGridDimensions(InSensorGridDimensions)
+	, ExecutionMode(InExecutionMode)
+	, TraversalStackSize(FCitySampleSensorGridHelper::GetTraversalStackSize((1 << InSensorGridDimensions.X) * (1 << InSensorGridDimensions.Y)))
+{
+}
+
+uint32 FCitySampleSensorGridCpuHelper::GetSensorsPerOwner() const
+{
+	return (1 << SensorGridDimensions.X) * (1 << SensorGridDimensions.Y);
+}
+
+uint32 FCitySampleSensorGridCpuHelper::Morton3d(const FVector3f& Location, uint32 OwnerIndex, uint32 OwnerBitCount)
+{
+	using namespace CitySampleSensorGridCpu;
+
+	const uint32 OwnerMask = (1 << OwnerBitCount) - 1;
+	const uint32 OwnerShift = 32 - OwnerBitCount;
+	const uint32 PositionMask = ~(OwnerMask << OwnerShift);
+
+	const uint32 BucketX = ToBucket(Location.X);
+	const uint32 BucketY = ToBucket(Location.Y);
+	const uint32 BucketZ = ToBucket(Location.Z);
+
+	const uint32 PositionMortonCode = ExpandBits(BucketZ) + (ExpandBits(BucketY) + (ExpandBits(BucketX) * 2) * 2);
+
+	return (PositionMortonCode & PositionMask) | ((OwnerIndex & OwnerMask) << OwnerShift);
+}
+
+uint32 FCitySampleSensorGridCpuHelper::InvalidMorton3d(uint32 OwnerIndex, uint32 OwnerBitCount)
+{
+	const uint32 OwnerMask = (1 << OwnerBitCount) - 1;
+	const uint32 OwnerShift = 32 - OwnerBitCount;
+	const uint32 PositionMask = ~(OwnerMask << OwnerShift);
+
+	return PositionMask | ((OwnerIndex & OwnerMask) << OwnerShift);
+}
+
+bool FCitySampleSensorGridCpuHelper::IsMortonCodeValid(uint32 MortonCode, uint32 OwnerBitCount)
+{
+	const uint32 OwnerMask = (1 << OwnerBitCount) - 1;
+	const uint32 OwnerShift = 32 - OwnerBitCount;
+	const uint32 PositionMask = ~(OwnerMask << OwnerShift);
+
+	return (MortonCode & PositionMask) != PositionMask;
+}
+
+uint32 FCitySampleSensorGridCpuHelper::LeafDistanceSqrUint(const FVector4f& TargetSensor, const FVector3f& SourceLocation)
+{
+	using namespace CitySampleSensorGridCpu;
+
+	const float DistanceSqr = SumOfSquares(TargetSensor.X - SourceLocation.X, TargetSensor.Y - SourceLocation.Y, TargetSensor.Z - SourceLocation.Z);
+	return AsUint(MaxZero(DistanceSqr - TargetSensor.W));
+}
+
+uint32 FCitySampleSensorGridCpuHelper::InitialDistanceSqrUint(const FVector4f& SourceSensor, float MaxDistance)
+{
+	const float RangeSqr = SourceSensor.W * SourceSensor.W;
+	const float MaxDistanceSqr = MaxDistance * MaxDistance;
+	return CitySampleSensorGridCpu::AsUint(RangeSqr + MaxDistanceSqr);
+}
+
+void FCitySampleSensorGridCpuHelper::NearestSensors(TConstArrayView<FVector4f> SensorLocations, const FVector2D& GlobalSensorRange, TArray<FCitySampleSensorGridHelper::FSensorInfo>& OutResults)
+{
+	const uint32 SensorsPerOwner = GetSensorsPerOwner();
+	const uint32 OwnerCount = GetOwnerCount();
+	const int32 SensorCount = SensorsPerOwner * OwnerCount;
+
+	if (!ensure(SensorLocations.Num() == SensorCount))
+	{
+		OutResults.Reset();
+		return;
+	}
+
+	// ClearNearestSensors
+	FCitySampleSensorGridHelper::FSensorInfo ClearedSensorInfo;
+	ClearedSensorInfo.Location = FVector::ZeroVector;
+	ClearedSensorInfo.DistanceUint = CitySampleSensorGridCpu::ClearedDistanceUint;
+	ClearedSensorInfo.HitIndex = FIntVector(-1, -1, -1);
+	ClearedSensorInfo.SearchCount = 0;
+
+	OutResults.Init(ClearedSensorInfo, SensorCount);
+
+	// same conditions as the GPU, which only allocates its buffers for more than one sensor
+	if (OwnerCount <= 1 || SensorsPerOwner <= 1)
+	{
+		return;
+	}
+
+	BuildBvhs(SensorLocations);
+
+	const float MaxDistance = GlobalSensorRange.Y;
+
+	if (ExecutionMode == EExecutionMode::Parallel)
+	{
+		const int32 ChunkCount = FMath::DivideAndRoundUp(SensorCount, CitySampleSensorGridCpu::TraversalChunkSize);
+
+		// packets never straddle two owners, sensors per owner is a power of two so that only rules out owners of two sensors
+		const bool bUsePackets = (SensorsPerOwner % CitySampleSensorGridCpu::SensorsPerPacket) == 0;
+
+		FSensorColumns SensorColumns;
+		if (bUsePackets)
+		{
+			SensorColumns.Init(SensorLocations);
+		}
+
+		ParallelFor(ChunkCount, [&](int32 ChunkIndex)
+		{
+			const int32 ChunkStart = ChunkIndex * CitySampleSensorGridCpu::TraversalChunkSize;
+			const int32 ChunkEnd = FMath::Min(ChunkStart + CitySampleSensorGridCpu::TraversalChunkSize, SensorCount);
+
+			if (bUsePackets)
+			{
+				for (int32 GlobalSensorIndex = ChunkStart; GlobalSensorIndex < ChunkEnd; GlobalSensorIndex += CitySampleSensorGridCpu::SensorsPerPacket)
+				{
+					RunTraversalPacket(GlobalSensorIndex % SensorsPerOwner, GlobalSensorIndex / SensorsPerOwner, MaxDistance, SensorColumns, SensorLocations, &OutResults[GlobalSensorIndex]);
+				}
+			}
+			else
+			{
+				for (int32 GlobalSensorIndex = ChunkStart; GlobalSensorIndex < ChunkEnd; ++GlobalSensorIndex)
+				{
+					RunTraversal(GlobalSensorIndex % SensorsPerOwner, GlobalSensorIndex / SensorsPerOwner, MaxDistance, SensorLocations, OutResults[GlobalSensorIndex]);
+				}
+			}
+		});
+	}
+	else
+	{
+		for (int32 GlobalSensorIndex = 0; GlobalSensorIndex < SensorCount; ++GlobalSensorIndex)
+		{
+			RunTraversal(GlobalSensorIndex % SensorsPerOwner, GlobalSensorIndex / SensorsPerOwner, MaxDistance, SensorLocations, OutResults[GlobalSensorIndex]);
+		}
+	}
+}
+
+void FCitySampleSensorGridCpuHelper::FSensorColumns::Init(TConstArrayView<FVector4f> SensorLocations)
+{
+	const int32 SensorCount = SensorLocations.Num();
+
+	X.SetNumUninitialized(SensorCount);
+	Y.SetNumUninitialized(SensorCount);
+	Z.SetNumUninitialized(SensorCount);
+
+	for (int32 SensorIndex = 0; SensorIndex < SensorCount; ++SensorIndex)
+	{
+		const FVector4f& SensorLocation = SensorLocations[SensorIndex];
+		X[SensorIndex] = SensorLocation.X;
+		Y[SensorIndex] = SensorLocation.Y;
+		Z[SensorIndex] = SensorLocation.Z;
+	}
+}
+
+void FCitySampleSensorGridCpuHelper::BuildBvhs(TConstArrayView<FVector4f> SensorLocations)
+{
+	const uint32 OwnerCount = GetOwnerCount();
+
+	check(SensorLocations.Num() == GetSensorsPerOwner() * OwnerCount);
+
+	OwnerBvhs.SetNum(OwnerCount);
+
+	if (ExecutionMode == EExecutionMode::Parallel)
+	{
+		ParallelFor(OwnerCount, [&](int32 OwnerIndex)
+		{
+			BuildOwnerBvh(OwnerIndex, SensorLocations);
+		});
+	}
+	else
+	{
+		for (uint32 OwnerIndex = 0; OwnerIndex < OwnerCount; ++OwnerIndex)
+		{
+			BuildOwnerBvh(OwnerIndex, SensorLocations);
+		}
+	}
+}
+
+void FCitySampleSensorGridCpuHelper::BuildOwnerBvh(uint32 OwnerIndex, TConstArrayView<FVector4f> SensorLocations)
+{
+	const uint32 SensorsPerOwner = GetSensorsPerOwner();
+	TConstArrayView<FVector4f> OwnerSensors = SensorLocations.Slice(OwnerIndex * SensorsPerOwner, SensorsPerOwner);
+
+	FOwnerBvh& Bvh = OwnerBvhs[OwnerIndex];
+
+	GenerateOwnerBounds(Bvh, OwnerSensors);
+	GenerateSortedLeaves(OwnerIndex, Bvh, OwnerSensors);
+	GenerateHierarchy(Bvh, OwnerSensors);
+}
+
+void FCitySampleSensorGridCpuHelper::GenerateOwnerBounds(FOwnerBvh& Bvh, TConstArrayView<FVector4f> OwnerSensors) const
+{
+	using namespace CitySampleSensorGridCpu;
+
+	// PrimeBounds & FinalizeBounds, min and max don't depend on the order of evaluation so a linear pass gives the same result
+	FVector3f AccumulatedMin(std::numeric_limits<float>::infinity());
+	FVector3f AccumulatedMax(-std::numeric_limits<float>::infinity());
+
+	if (ExecutionMode == EExecutionMode::Parallel)
+	{
+		VectorRegister4Float VectorMin = VectorSetFloat1(std::numeric_limits<float>::infinity());
+		VectorRegister4Float VectorMax = VectorSetFloat1(-std::numeric_limits<float>::infinity());
+
+		for (const FVector4f& SensorLocation : OwnerSensors)
+		{
+			if (SensorLocation.W >= 0.0f)
+			{
+				const VectorRegister4Float Location = VectorLoad(&SensorLocation.X);
+				const VectorRegister4Float Range = VectorReplicate(Location, 3);
+				const VectorRegister4Float LocationMin = VectorSubtract(Location, Range);
+				const VectorRegister4Float LocationMax = VectorAdd(Location, Range);
+
+				VectorMin = VectorSelect(VectorCompareLT(LocationMin, VectorMin), LocationMin, VectorMin);
+				VectorMax = VectorSelect(VectorCompareGT(LocationMax, VectorMax), LocationMax, VectorMax);
+			}
+		}
+
+		VectorStoreFloat3(VectorMin, &AccumulatedMin.X);
+		VectorStoreFloat3(VectorMax, &AccumulatedMax.X);
+	}
+	else
+	{
+		for (const FVector4f& SensorLocation : OwnerSensors)
+		{
+			if (SensorLocation.W >= 0.0f)
+			{
+				AccumulatedMin = FVector3f(MinFloat(SensorLocation.X - SensorLocation.W, AccumulatedMin.X), MinFloat(SensorLocation.Y - SensorLocation.W, AccumulatedMin.Y), MinFloat(SensorLocation.Z - SensorLocation.W, AccumulatedMin.Z));
+				AccumulatedMax = FVector3f(MaxFloat(SensorLocation.X + SensorLocation.W, AccumulatedMax.X), MaxFloat(SensorLocation.Y + SensorLocation.W, AccumulatedMax.Y), MaxFloat(SensorLocation.Z + SensorLocation.W, AccumulatedMax.Z));
+			}
+		}
+	}
+
+	Bvh.BoundsMin = AccumulatedMin;
+	Bvh.BoundsExtent = AccumulatedMax - AccumulatedMin;
+}
+
+void FCitySampleSensorGridCpuHelper::GenerateSortedLeaves(uint32 OwnerIndex, FOwnerBvh& Bvh, TConstArrayView<FVector4f> OwnerSensors) const
+{
+	using namespace CitySampleSensorGridCpu;
+
+	const uint32 OwnerBitCount = FCitySampleSensorGridHelper::GetMortonCodeOwnerBitCount();
+	const bool bVectorized = ExecutionMode == EExecutionMode::Parallel;
+
+	const VectorRegister4Float BoundsMin = VectorLoadFloat3_W0(&Bvh.BoundsMin.X);
+	const VectorRegister4Float BoundsExtent = VectorLoadFloat3_W1(&Bvh.BoundsExtent.X);
+
+	// MortonGeneration, with the leaf index in the low bits so that sorting the keys gives the same order as the
+	// stable radix sort used on the GPU
+	TArray<uint64> SortKeys;
+	SortKeys.SetNumUninitialized(OwnerSensors.Num());
+
+	for (int32 InputIndex = 0; InputIndex < OwnerSensors.Num(); ++InputIndex)
+	{
+		const FVector4f& SensorLocation = OwnerSensors[InputIndex];
+
+		uint32 MortonCode = InvalidMorton3d(OwnerIndex, OwnerBitCount);
+		uint32 LeafIndex = InvalidLeafIndex;
+
+		if (SensorLocation.W >= 0.0f)
+		{
+			// normalize the sensor's location based on it's AABB
+			FVector3f NormalizedLocation;
+			if (bVectorized)
+			{
+				alignas(16) float Normalized[4];
+				VectorStoreAligned(VectorDivide(VectorSubtract(VectorLoad(&SensorLocation.X), BoundsMin), BoundsExtent), Normalized);
+				NormalizedLocation = FVector3f(Normalized[0], Normalized[1], Normalized[2]);
+			}
+			else
+			{
+				NormalizedLocation = FVector3f(
+					(SensorLocation.X - Bvh.BoundsMin.X) / Bvh.BoundsExtent.X,
+					(SensorLocation.Y - Bvh.BoundsMin.Y) / Bvh.BoundsExtent.Y,
+					(SensorLocation.Z - Bvh.BoundsMin.Z) / Bvh.BoundsExtent.Z);
+			}
+
+			MortonCode = Morton3d(NormalizedLocation, OwnerIndex, OwnerBitCount);
+			LeafIndex = InputIndex;
+		}
+
+		SortKeys[InputIndex] = ((uint64)MortonCode << 32) | LeafIndex;
+	}
+
+	Algo::Sort(SortKeys);
+
+	// MortonCompaction, BuildCopyCommands & MortonShuffleData: keep the first sensor of each run of identical codes
+	Bvh.MortonCodes.Reset(OwnerSensors.Num());
+	Bvh.LeafIndices.Reset(OwnerSensors.Num());
+
+	for (const uint64 SortKey : SortKeys)
+	{
+		const uint32 MortonCode = (uint32)(SortKey >> 32);
+
+		if (!IsMortonCodeValid(MortonCode, OwnerBitCount))
+		{
+			continue;
+		}
+
+		if (Bvh.MortonCodes.Num() && Bvh.MortonCodes.Last() == MortonCode)
+		{
+			continue;
+		}
+
+		Bvh.MortonCodes.Add(MortonCode);
+		Bvh.LeafIndices.Add((uint32)SortKey);
+	}
+}
+
+void FCitySampleSensorGridCpuHelper::GenerateHierarchy(FOwnerBvh& Bvh, TConstArrayView<FVector4f> OwnerSensors) const
+{
+	using namespace CitySampleSensorGridCpu;
+
+	const int32 LeafCount = Bvh.MortonCodes.Num();
+
+	FInternalNode EmptyNode;
+	EmptyNode.BoundsMin = FVector3f(std::numeric_limits<float>::infinity());
+	EmptyNode.LeftChild = 0;
+	EmptyNode.BoundsMax = FVector3f(-std::numeric_limits<float>::infinity());
+	EmptyNode.RightChild = 0;
+
+	Bvh.InternalNodes.Reset();
+
+	if (!LeafCount)
+	{
+		// make an empty root node
+		Bvh.InternalNodes.Add(EmptyNode);
+		return;
+	}
+
+	if (LeafCount == 1)
+	{
+		// the shaders don't produce any internal node in this case and leave the root untouched, use a root that
+		// holds the single leaf instead
+		FInternalNode& RootNode = Bvh.InternalNodes.Add_GetRef(EmptyNode);
+		RootNode.LeftChild = (int32)~Bvh.LeafIndices[0];
+		AggregateBounds(OwnerSensors.GetData(), Bvh.InternalNodes, RootNode.LeftChild, RootNode.BoundsMin, RootNode.BoundsMax);
+		return;
+	}
+
+	// HierarchyGeneration_TopDown
+	const int32 InternalNodeCount = LeafCount - 1;
+	const uint32 InternalNodeParentOffset = LeafCount;
+
+	Bvh.InternalNodes.Init(EmptyNode, InternalNodeCount);
+
+	TArray<uint32> ParentIndices;
+	ParentIndices.SetNumUninitialized(LeafCount + InternalNodeCount);
+	ParentIndices[InternalNodeParentOffset] = InvalidLeafIndex;
+
+	for (int32 LocalNodeIndex = 0; LocalNodeIndex < InternalNodeCount; ++LocalNodeIndex)
+	{
+		FInternalNode& Node = Bvh.InternalNodes[LocalNodeIndex];
+
+		const uint32 CurrentKey = Bvh.MortonCodes[LocalNodeIndex];
+
+		const FUintVector2 Range = LocalNodeIndex
+			? DetermineRange(Bvh.MortonCodes, LocalNodeIndex, CurrentKey)
+			: FUintVector2(0, InternalNodeCount);
+
+		const uint32 SplitIndex = FindSplit(Bvh.MortonCodes, Range.X, Range.Y);
+
+		if (SplitIndex == Range.X)
+		{
+			// leaf
+			const uint32 LeafIndex = Bvh.LeafIndices[SplitIndex];
+			Node.LeftChild = (int32)((LeafIndex == InvalidLeafIndex) ? 0 : ~LeafIndex);
+			ParentIndices[SplitIndex] = LocalNodeIndex;
+		}
+		else
+		{
+			// internal node
+			Node.LeftChild = SplitIndex;
+			ParentIndices[InternalNodeParentOffset + SplitIndex] = LocalNodeIndex;
+		}
+
+		if ((SplitIndex + 1) == Range.Y)
+		{
+			// leaf
+			const uint32 LeafIndex = Bvh.LeafIndices[SplitIndex + 1];
+			Node.RightChild = (int32)((LeafIndex == InvalidLeafIndex) ? 0 : ~LeafIndex);
+			ParentIndices[SplitIndex + 1] = LocalNodeIndex;
+		}
+		else
+		{
+			// internal node
+			Node.RightChild = SplitIndex + 1;
+			ParentIndices[InternalNodeParentOffset + SplitIndex + 1] = LocalNodeIndex;
+		}
+	}
+
+	// BoundsGeneration_BottomUp, each leaf walks up the tree and the last child to reach a node completes its bounds
+	TArray<uint8> AccumulationGates;
+	AccumulationGates.SetNumZeroed(InternalNodeCount);
+
+	for (int32 LeafNodeIndex = 0; LeafNodeIndex < LeafCount; ++LeafNodeIndex)
+	{
+		uint32 ParentIndex = ParentIndices[LeafNodeIndex];
+
+		do
+		{
+			if (AccumulationGates[ParentIndex]++ == 0)
+			{
+				break;
+			}
+
+			FInternalNode& Node = Bvh.InternalNodes[ParentIndex];
+
+			FVector3f ChildBoundsMin(std::numeric_limits<float>::infinity());
+			FVector3f ChildBoundsMax(-std::numeric_limits<float>::infinity());
+
+			AggregateBounds(OwnerSensors.GetData(), Bvh.InternalNodes, Node.LeftChild, ChildBoundsMin, ChildBoundsMax);
+			AggregateBounds(OwnerSensors.GetData(), Bvh.InternalNodes, Node.RightChild, ChildBoundsMin, ChildBoundsMax);
+
+			Node.BoundsMin = ChildBoundsMin;
+			Node.BoundsMax = ChildBoundsMax;
+
+			if (ParentIndex == 0)
+			{
+				break;
+			}
+
+			ParentIndex = ParentIndices[InternalNodeParentOffset + ParentIndex];
+		} while (ParentIndex != InvalidLeafIndex);
+	}
+}
+
+void FCitySampleSensorGridCpuHelper::RunTraversal(uint32 SensorIndex, uint32 OwnerIndex, float MaxDistance, TConstArrayView<FVector4f> SensorLocations, FCitySampleSensorGridHelper::FSensorInfo& OutResult) const
+{
+	using namespace CitySampleSensorGridCpu;
+
+	const uint32 SensorsPerOwner = GetSensorsPerOwner();
+	const uint32 OwnerCount = GetOwnerCount();
+
+	const FVector4f& SourceSensor = SensorLocations[OwnerIndex * SensorsPerOwner + SensorIndex];
+	if (SourceSensor.W < 0.0f)
+	{
+		return;
+	}
+
+	FClosestSensorInfo ClosestSensorInfo;
+	ClosestSensorInfo.DistanceSqrUint = InitialDistanceSqrUint(SourceSensor, MaxDistance);
+	ClosestSensorInfo.SensorIndex = 0;
+	ClosestSensorInfo.OwnerIndex = OwnerIndex;
+
+	for (uint32 OwnerOffset = 1; OwnerOffset < OwnerCount; ++OwnerOffset)
+	{
+		const uint32 TargetOwner = (OwnerIndex + OwnerOffset) >= OwnerCount ? (OwnerIndex + OwnerOffset - OwnerCount) : OwnerIndex + OwnerOffset;
+
+		TraverseBvh(SourceSensor, TargetOwner, SensorLocations, ClosestSensorInfo);
+	}
+
+	if (ClosestSensorInfo.OwnerIndex != OwnerIndex)
+	{
+		WriteResult(ClosestSensorInfo, SensorLocations, OutResult);
+	}
+}
+
+void FCitySampleSensorGridCpuHelper::RunTraversalPacket(uint32 FirstSensorIndex, uint32 OwnerIndex, float MaxDistance, const FSensorColumns& SensorColumns, TConstArrayView<FVector4f> SensorLocations, FCitySampleSensorGridHelper::FSensorInfo* OutResults) const
+{
+	using namespace CitySampleSensorGridCpu;
+
+	const uint32 OwnerCount = GetOwnerCount();
+	const uint32 FirstGlobalIndex = OwnerIndex * GetSensorsPerOwner() + FirstSensorIndex;
+
+	FClosestSensorPacket ClosestSensors;
+	ClosestSensors.ActiveMask = 0;
+
+	for (uint32 Lane = 0; Lane < SensorsPerPacket; ++Lane)
+	{
+		const FVector4f& SourceSensor = SensorLocations[FirstGlobalIndex + Lane];
+		if (SourceSensor.W >= 0.0f)
+		{
+			ClosestSensors.ActiveMask |= 1u << Lane;
+		}
+
+		ClosestSensors.Info[Lane].DistanceSqrUint = InitialDistanceSqrUint(SourceSensor, MaxDistance);
+		ClosestSensors.Info[Lane].SensorIndex = 0;
+		ClosestSensors.Info[Lane].OwnerIndex = OwnerIndex;
+	}
+
+	if (!ClosestSensors.ActiveMask)
+	{
+		return;
+	}
+
+	const VectorRegister4Float SourceX = VectorLoad(&SensorColumns.X[FirstGlobalIndex]);
+	const VectorRegister4Float SourceY = VectorLoad(&SensorColumns.Y[FirstGlobalIndex]);
+	const VectorRegister4Float SourceZ = VectorLoad(&SensorColumns.Z[FirstGlobalIndex]);
+
+	for (uint32 OwnerOffset = 1; OwnerOffset < OwnerCount; ++OwnerOffset)
+	{
+		const uint32 TargetOwner = (OwnerIndex + OwnerOffset) >= OwnerCount ? (OwnerIndex + OwnerOffset - OwnerCount) : OwnerIndex + OwnerOffset;
+
+		TraverseBvhPacket(SourceX, SourceY, SourceZ, TargetOwner, SensorLocations, ClosestSensors);
+	}
+
+	for (uint32 Lane = 0; Lane < SensorsPerPacket; ++Lane)
+	{
+		if ((ClosestSensors.ActiveMask & (1u << Lane)) && ClosestSensors.Info[Lane].OwnerIndex != OwnerIndex)
+		{
+			WriteResult(ClosestSensors.Info[Lane], SensorLocations, OutResults[Lane]);
+		}
+	}
+}
+
+void FCitySampleSensorGridCpuHelper::WriteResult(const FClosestSensorInfo& ClosestSensorInfo, TConstArrayView<FVector4f> SensorLocations, FCitySampleSensorGridHelper::FSensorInfo& OutResult) const
+{
+	using namespace CitySampleSensorGridCpu;
+
+	const uint32 SensorMask = (1 << SensorGridDimensions.X) - 1;
+	const FVector4f& HitSensor = SensorLocations[ClosestSensorInfo.OwnerIndex * GetSensorsPerOwner() + ClosestSensorInfo.SensorIndex];
+
+	// write out the result
+	OutResult.Location = FVector(HitSensor.X, HitSensor.Y, HitSensor.Z);
+	OutResult.DistanceUint = AsUint(FMath::Sqrt(AsFloat(ClosestSensorInfo.DistanceSqrUint)));
+	OutResult.HitIndex = FIntVector(
+		ClosestSensorInfo.SensorIndex & SensorMask,
+		ClosestSensorInfo.SensorIndex >> SensorGridDimensions.X,
+		ClosestSensorInfo.OwnerIndex);
+	OutResult.SearchCount = 0;
+}
+
+void FCitySampleSensorGridCpuHelper::TraverseBvh(const FVector4f& SourceSensor, uint32 TargetOwner, TConstArrayView<FVector4f> SensorLocations, FClosestSensorInfo& ResultsInfo) const
+{
+	using namespace CitySampleSensorGridCpu;
+
+	const FOwnerBvh& Bvh = OwnerBvhs[TargetOwner];
+
+	// the GPU would only visit the empty root node, which can't produce a result
+	if (Bvh.LeafIndices.IsEmpty())
+	{
+		return;
+	}
+
+	const FVector4f* TargetSensors = SensorLocations.GetData() + TargetOwner * GetSensorsPerOwner();
+	const FVector3f SourceLocation(SourceSensor.X, SourceSensor.Y, SourceSensor.Z);
+
+	// same limited stack as the shader, subtrees that don't fit are skipped
+	TArray<uint32, TInlineAllocator<32>> DepthFirstStack;
+	DepthFirstStack.SetNumUninitialized(TraversalStackSize);
+	uint32 StackIndex = 0;
+
+	uint32 CurrentNodeIndex = 0; // RootNode
+
+	auto TestLeaf = [&](uint32 TargetLeafIndex)
+	{
+		const FVector4f& TargetSensorLocation = TargetSensors[TargetLeafIndex];
+
+		if (TargetSensorLocation.W >= 0.0f)
+		{
+			const uint32 DeltaSqrUint = LeafDistanceSqrUint(TargetSensorLocation, SourceLocation);
+
+			if (DeltaSqrUint < ResultsInfo.DistanceSqrUint)
+			{
+				ResultsInfo.DistanceSqrUint = DeltaSqrUint;
+				ResultsInfo.SensorIndex = TargetLeafIndex;
+				ResultsInfo.OwnerIndex = TargetOwner;
+			}
+		}
+	};
+
+	while (true)
+	{
+		const FInternalNode& CurrentNode = Bvh.InternalNodes[CurrentNodeIndex];
+
+		if (TestOverlap(CurrentNode, SourceSensor, ResultsInfo.DistanceSqrUint))
+		{
+			if (CurrentNode.LeftChild < 0)
+			{
+				TestLeaf((uint32)~CurrentNode.LeftChild);
+			}
+			else if (CurrentNode.LeftChild && StackIndex < TraversalStackSize)
+			{
+				DepthFirstStack[StackIndex++] = (uint32)CurrentNode.LeftChild;
+			}
+
+			if (CurrentNode.RightChild < 0)
+			{
+				TestLeaf((uint32)~CurrentNode.RightChild);
+			}
+			else if (CurrentNode.RightChild && StackIndex < TraversalStackSize)
+			{
+				DepthFirstStack[StackIndex++] = (uint32)CurrentNode.RightChild;
+			}
+		}
+
+		if (StackIndex == 0)
+		{
+			break;
+		}
+
+		CurrentNodeIndex = DepthFirstStack[--StackIndex];
+	}
+}
+
+void FCitySampleSensorGridCpuHelper::TraverseBvhPacket(const VectorRegister4Float& SourceX, const VectorRegister4Float& SourceY, const VectorRegister4Float& SourceZ, uint32 TargetOwner, TConstArrayView<FVector4f> SensorLocations, FClosestSensorPacket& Results) const
+{
+	using namespace CitySampleSensorGridCpu;
+
+	const FOwnerBvh& Bvh = OwnerBvhs[TargetOwner];
+
+	if (Bvh.LeafIndices.IsEmpty())
+	{
+		return;
+	}
+
+	const FVector4f* TargetSensors = SensorLocations.GetData() + TargetOwner * GetSensorsPerOwner();
+
+	// every lane follows the same path it would take on its own: a node is only visited by the lanes that pushed it, and a lane
+	// skips the subtrees that don't fit in its own share of the limited stack, so the results match TraverseBvh bit for bit
+	struct FStackEntry
+	{
+		uint32 NodeIndex;
+		uint32 LaneMask;
+	};
+
+	TArray<FStackEntry, TInlineAllocator<64>> DepthFirstStack;
+	uint32 LaneStackSizes[SensorsPerPacket] = {};
+
+	uint32 CurrentNodeIndex = 0; // RootNode
+	uint32 CurrentLaneMask = Results.ActiveMask;
+
+	auto TestLeaf = [&](uint32 TargetLeafIndex, uint32 LaneMask)
+	{
+		const FVector4f& TargetSensorLocation = TargetSensors[TargetLeafIndex];
+
+		if (TargetSensorLocation.W < 0.0f)
+		{
+			return;
+		}
+
+		const VectorRegister4Float DeltaX = VectorSubtract(VectorSetFloat1(TargetSensorLocation.X), SourceX);
+		const VectorRegister4Float DeltaY = VectorSubtract(VectorSetFloat1(TargetSensorLocation.Y), SourceY);
+		const VectorRegister4Float DeltaZ = VectorSubtract(VectorSetFloat1(TargetSensorLocation.Z), SourceZ);
+
+		alignas(16) float DeltaSqr[SensorsPerPacket];
+		VectorStoreAligned(MaxZero(VectorSubtract(SumOfSquares(DeltaX, DeltaY, DeltaZ), VectorSetFloat1(TargetSensorLocation.W))), DeltaSqr);
+
+		for (uint32 Lane = 0; Lane < SensorsPerPacket; ++Lane)
+		{
+			FClosestSensorInfo& ResultsInfo = Results.Info[Lane];
+			const uint32 DeltaSqrUint = AsUint(DeltaSqr[Lane]);
+
+			if ((LaneMask & (1u << Lane)) && DeltaSqrUint < ResultsInfo.DistanceSqrUint)
+			{
+				ResultsInfo.DistanceSqrUint = DeltaSqrUint;
+				ResultsInfo.SensorIndex = TargetLeafIndex;
+				ResultsInfo.OwnerIndex = TargetOwner;
+			}
+		}
+	};
+
+	auto PushChild = [&](uint32 ChildIndex, uint32 LaneMask)
+	{
+		uint32 PushMask = 0;
+		for (uint32 Lane = 0; Lane < SensorsPerPacket; ++Lane)
+		{
+			if ((LaneMask & (1u << Lane)) && LaneStackSizes[Lane] < TraversalStackSize)
+			{
+				++LaneStackSizes[Lane];
+				PushMask |= 1u << Lane;
+			}
+		}
+
+		if (PushMask)
+		{
+			DepthFirstStack.Add({ ChildIndex, PushMask });
+		}
+	};
+
+	while (true)
+	{
+		const FInternalNode& CurrentNode = Bvh.InternalNodes[CurrentNodeIndex];
+
+		uint32 RadiusSqrUint[SensorsPerPacket];
+		for (uint32 Lane = 0; Lane < SensorsPerPacket; ++Lane)
+		{
+			RadiusSqrUint[Lane] = Results.Info[Lane].DistanceSqrUint;
+		}
+
+		const uint32 OverlapMask = CurrentLaneMask & TestOverlapPacket(CurrentNode, SourceX, SourceY, SourceZ, RadiusSqrUint);
+
+		if (OverlapMask)
+		{
+			if (CurrentNode.LeftChild < 0)
+			{
+				TestLeaf((uint32)~CurrentNode.LeftChild, OverlapMask);
+			}
+			else if (CurrentNode.LeftChild)
+			{
+				PushChild((uint32)CurrentNode.LeftChild, OverlapMask);
+			}
+
+			if (CurrentNode.RightChild < 0)
+			{
+				TestLeaf((uint32)~CurrentNode.RightChild, OverlapMask);
+			}
+			else if (CurrentNode.RightChild)
+			{
+				PushChild((uint32)CurrentNode.RightChild, OverlapMask);
+			}
+		}
+
+		if (DepthFirstStack.IsEmpty())
+		{
+			break;
+		}
+
+		const FStackEntry Entry = DepthFirstStack.Pop(EAllowShrinking::No);
+		for (uint32 Lane = 0; Lane < SensorsPerPacket; ++Lane)
+		{
+			LaneStackSizes[Lane] -= (Entry.LaneMask >> Lane) & 1u;
+		}
+
+		CurrentNodeIndex = Entry.NodeIndex;
+		CurrentLaneMask = Entry.LaneMask;
+	}
+}
@@ -168,7 +168,9 @@ class FCitySampleSensorGridMortonCompactionCs : public FGlobalShader
 public:
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, CITYSAMPLESENSORGRIDSHADERS_API)
 		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, InputValues)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, InputIndices)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, OutputValues)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, OutputIndices)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, DuplicateCounts)
 		SHADER_PARAMETER(uint32, ValueCount)
 		SHADER_PARAMETER(uint32, OwnerBitCount)
@@ -348,6 +350,18 @@ uint32 FCitySampleSensorGridHelper::GetMaxOwnerCount()
 	return (1 << CitySampleSensorGridShaders::MortonCodeBitsReservedForOwner) - 1;
 }
 
+uint32 FCitySampleSensorGridHelper::GetMortonCodeOwnerBitCount()
+{
+	return CitySampleSensorGridShaders::MortonCodeBitsReservedForOwner;
+}
+
+uint32 FCitySampleSensorGridHelper::GetTraversalStackSize(uint32 SensorsPerOwner)
+{
+	// matches BVH_TRAVERSAL_STACK_SIZE for the permutation selected in RunTraversals
+	const uint32 SensorsPerOwnerLogTwo = FMath::Max(FCitySampleSensorGridBvhTraversalCs::MinSensorCountLogTwo, FMath::CeilLogTwo(SensorsPerOwner));
+	return SensorsPerOwnerLogTwo + FCitySampleSensorGridBvhTraversalCs::SlackSize;
+}
+
 FCitySampleSensorGridHelper::FCitySampleSensorGridHelper(ERHIFeatureLevel::Type InFeatureLevel, const FUintVector4& InSensorGridDimensions, uint32 FrameIndex)
 	: FeatureLevel(InFeatureLevel)
 	, SensorGridDimensions(InSensorGridDimensions)
@@ -606,11 +620,14 @@ void FCitySampleSensorGridHelper::GenerateSortedLeaves(
 		);
 	}
 
-	// go through the sorted buffer and find (and get rid of) duplicates
+	// go through the sorted buffer and find (and get rid of) duplicates, the leaf indices need to be compacted the same way
+	// so that they stay paired with their morton code
 	{
 		FCitySampleSensorGridMortonCompactionCs::FParameters* PassParameters = GraphBuilder.AllocParameters<FCitySampleSensorGridMortonCompactionCs::FParameters>();
 		PassParameters->InputValues = GraphBuilder.CreateSRV(TransientResources.MortonCodes[0], PF_R32_UINT);
+		PassParameters->InputIndices = GraphBuilder.CreateSRV(TransientResources.LeafIndices[1], PF_R32_UINT);
 		PassParameters->OutputValues = GraphBuilder.CreateUAV(TransientResources.MortonCodes[1], PF_R32_UINT);
+		PassParameters->OutputIndices = GraphBuilder.CreateUAV(TransientResources.LeafIndices[0], PF_R32_UINT);
 		PassParameters->DuplicateCounts = GraphBuilder.CreateUAV(TransientResources.DuplicateCounts, PF_R32_UINT);
 		PassParameters->ValueCount = SensorsPerOwner * SensorGridDimensions.Z;
 		PassParameters->OwnerBitCount = CitySampleSensorGridShaders::MortonCodeBitsReservedForOwner;
@@ -658,9 +675,9 @@ void FCitySampleSensorGridHelper::GenerateSortedLeaves(
 			FIntVector(DuplicateCountBlocks, 1, 1));
 
 		FCitySampleSensorGridShuffleDataCs::FParameters* ShuffleIndicesParameters = GraphBuilder.AllocParameters<FCitySampleSensorGridShuffleDataCs::FParameters>();
-		ShuffleIndicesParameters->InputValues = GraphBuilder.CreateSRV(TransientResources.LeafIndices[1], PF_R32_UINT);
+		ShuffleIndicesParameters->InputValues = GraphBuilder.CreateSRV(TransientResources.LeafIndices[0], PF_R32_UINT);
 		ShuffleIndicesParameters->CopyCommands = GraphBuilder.CreateSRV(TransientResources.CopyCommands, PF_R32G32B32A32_UINT);
-		ShuffleIndicesParameters->OutputValues = GraphBuilder.CreateUAV(TransientResources.LeafIndices[0], PF_R32_UINT);
+		ShuffleIndicesParameters->OutputValues = GraphBuilder.CreateUAV(TransientResources.LeafIndices[1], PF_R32_UINT);
 
 		FComputeShaderUtils::AddPass(
 			GraphBuilder,
@@ -689,7 +706,7 @@ void FCitySampleSensorGridHelper::GenerateBvh(
 
 		FCitySampleSensorGridBvhGenTopDownCs::FParameters* PassParameters = GraphBuilder.AllocParameters<FCitySampleSensorGridBvhGenTopDownCs::FParameters>();
 		PassParameters->LeafCounts = GraphBuilder.CreateSRV(TransientResources.SensorCounts, PF_R32_UINT);
-		PassParameters->LeafIndices = GraphBuilder.CreateSRV(TransientResources.LeafIndices[0], PF_R32_UINT);
+		PassParameters->LeafIndices = GraphBuilder.CreateSRV(TransientResources.LeafIndices[1], PF_R32_UINT);
 		PassParameters->MortonCodes = GraphBuilder.CreateSRV(TransientResources.MortonCodes[0], PF_R32_UINT);
 		PassParameters->InternalNodes = GraphBuilder.CreateUAV(TransientResources.InternalNodes, PF_Unknown);
 		PassParameters->ParentIndices = GraphBuilder.CreateUAV(TransientResources.ParentIndices, PF_R32_UINT);
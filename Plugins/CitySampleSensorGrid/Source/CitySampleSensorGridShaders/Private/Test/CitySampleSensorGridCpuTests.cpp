@@ -0,0 +1,295 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#include "CitySampleSensorGridCpu.h"
+
+namespace CitySampleSensorGridCpuTests
+{
+	// roughly the size of a city block, in cm
+	static const float WorldExtent = 20000.0f;
+
+	static void GenerateSensors(FRandomStream& Random, uint32 SensorCount, float InvalidFraction, TArray<FVector4f>& OutSensors)
+	{
+		OutSensors.SetNumUninitialized(SensorCount);
+
+		for (FVector4f& Sensor : OutSensors)
+		{
+			Sensor.X = Random.FRandRange(-WorldExtent, WorldExtent);
+			Sensor.Y = Random.FRandRange(-WorldExtent, WorldExtent);
+			Sensor.Z = Random.FRandRange(0.0f, 2000.0f);
+			Sensor.W = (Random.FRand() < InvalidFraction) ? -1.0f : Random.FRandRange(1.0f, 500.0f);
+		}
+	}
+
+	// exhaustive search over the leaves that survived the compaction of every other owner, using the same distance
+	// metric as the traversal
+	static FCitySampleSensorGridHelper::FSensorInfo BruteForceNearestSensor(const FCitySampleSensorGridCpuHelper& Helper, TConstArrayView<FVector4f> Sensors, uint32 GlobalSensorIndex, float MaxDistance)
+	{
+		const uint32 SensorsPerOwner = Helper.GetSensorsPerOwner();
+		const uint32 OwnerIndex = GlobalSensorIndex / SensorsPerOwner;
+		const FVector4f& SourceSensor = Sensors[GlobalSensorIndex];
+
+		FCitySampleSensorGridHelper::FSensorInfo Result;
+		Result.DistanceUint = 0x7F000000;
+		Result.HitIndex = FIntVector(-1, -1, -1);
+
+		if (SourceSensor.W < 0.0f)
+		{
+			return Result;
+		}
+
+		uint32 BestDistanceSqrUint = FCitySampleSensorGridCpuHelper::InitialDistanceSqrUint(SourceSensor, MaxDistance);
+		bool bFound = false;
+
+		for (uint32 TargetOwner = 0; TargetOwner < Helper.GetOwnerCount(); ++TargetOwner)
+		{
+			if (TargetOwner == OwnerIndex)
+			{
+				continue;
+			}
+
+			for (const uint32 LeafIndex : Helper.GetOwnerBvh(TargetOwner).LeafIndices)
+			{
+				const uint32 DistanceSqrUint = FCitySampleSensorGridCpuHelper::LeafDistanceSqrUint(Sensors[TargetOwner * SensorsPerOwner + LeafIndex], FVector3f(SourceSensor));
+				if (DistanceSqrUint < BestDistanceSqrUint)
+				{
+					BestDistanceSqrUint = DistanceSqrUint;
+					Result.HitIndex = FIntVector(LeafIndex, 0, TargetOwner);
+					bFound = true;
+				}
+			}
+		}
+
+		if (bFound)
+		{
+			float DistanceSqr;
+			FMemory::Memcpy(&DistanceSqr, &BestDistanceSqrUint, sizeof(DistanceSqr));
+			const float Distance = FMath::Sqrt(DistanceSqr);
+			FMemory::Memcpy(&Result.DistanceUint, &Distance, sizeof(Distance));
+		}
+
+		return Result;
+	}
+
+	static bool ResultsMatch(const FCitySampleSensorGridHelper::FSensorInfo& A, const FCitySampleSensorGridHelper::FSensorInfo& B)
+	{
+		return A.Location == B.Location && A.DistanceUint == B.DistanceUint && A.HitIndex == B.HitIndex && A.SearchCount == B.SearchCount;
+	}
+
+	// every internal node encloses its children and every compacted leaf is reachable exactly once
+	static bool ValidateHierarchy(const FCitySampleSensorGridCpuHelper::FOwnerBvh& Bvh, TConstArrayView<FVector4f> OwnerSensors)
+	{
+		TArray<int32> LeafVisits;
+		LeafVisits.SetNumZeroed(OwnerSensors.Num());
+
+		auto Encloses = [](const FCitySampleSensorGridCpuHelper::FInternalNode& Node, const FVector3f& Min, const FVector3f& Max)
+		{
+			return Node.BoundsMin.X <= Min.X && Node.BoundsMin.Y <= Min.Y && Node.BoundsMin.Z <= Min.Z
+				&& Node.BoundsMax.X >= Max.X && Node.BoundsMax.Y >= Max.Y && Node.BoundsMax.Z >= Max.Z;
+		};
+
+		for (const FCitySampleSensorGridCpuHelper::FInternalNode& Node : Bvh.InternalNodes)
+		{
+			for (const int32 Child : { Node.LeftChild, Node.RightChild })
+			{
+				if (Child < 0)
+				{
+					const FVector4f& Sensor = OwnerSensors[~Child];
+					++LeafVisits[~Child];
+
+					if (!Encloses(Node, FVector3f(Sensor) - Sensor.W, FVector3f(Sensor) + Sensor.W))
+					{
+						return false;
+					}
+				}
+				else if (Child)
+				{
+					const FCitySampleSensorGridCpuHelper::FInternalNode& ChildNode = Bvh.InternalNodes[Child];
+					if (!Encloses(Node, ChildNode.BoundsMin, ChildNode.BoundsMax))
+					{
+						return false;
+					}
+				}
+			}
+		}
+
+		for (int32 SensorIndex = 0; SensorIndex < OwnerSensors.Num(); ++SensorIndex)
+		{
+			const int32 ExpectedVisits = Bvh.LeafIndices.Contains(SensorIndex) ? 1 : 0;
+			if (LeafVisits[SensorIndex] != ExpectedVisits)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCitySampleSensorGridCpuValidationTest, "CitySampleSensorGrid.Cpu.Validation", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FCitySampleSensorGridCpuValidationTest::RunTest(const FString& Parameters)
+{
+	using namespace CitySampleSensorGridCpuTests;
+	using EExecutionMode = FCitySampleSensorGridCpuHelper::EExecutionMode;
+
+	const uint32 OwnerBitCount = FCitySampleSensorGridHelper::GetMortonCodeOwnerBitCount();
+
+	// morton codes interleave x, y and z (from the most significant bit) and store the owner in the top bits
+	const float FirstBucket = 1.5f / 512.0f;
+	TestEqual("Morton code of x", FCitySampleSensorGridCpuHelper::Morton3d(FVector3f(FirstBucket, 0.0f, 0.0f), 0, OwnerBitCount), 4u);
+	TestEqual("Morton code of y", FCitySampleSensorGridCpuHelper::Morton3d(FVector3f(0.0f, FirstBucket, 0.0f), 0, OwnerBitCount), 2u);
+	TestEqual("Morton code of z", FCitySampleSensorGridCpuHelper::Morton3d(FVector3f(0.0f, 0.0f, FirstBucket), 0, OwnerBitCount), 1u);
+	TestEqual("Morton code of owner", FCitySampleSensorGridCpuHelper::Morton3d(FVector3f::ZeroVector, 3, OwnerBitCount), 3u << (32 - OwnerBitCount));
+	TestFalse("Invalid morton code", FCitySampleSensorGridCpuHelper::IsMortonCodeValid(FCitySampleSensorGridCpuHelper::InvalidMorton3d(3, OwnerBitCount), OwnerBitCount));
+	TestTrue("Valid morton code", FCitySampleSensorGridCpuHelper::IsMortonCodeValid(FCitySampleSensorGridCpuHelper::Morton3d(FVector3f(0.99f), 3, OwnerBitCount), OwnerBitCount));
+
+	const FVector2D GlobalSensorRange(0.0, 5000.0);
+
+	struct FTestCase
+	{
+		FUintVector4 Dimensions;
+		float InvalidFraction;
+	};
+
+	const FTestCase TestCases[] =
+	{
+		{ FUintVector4(4, 4, 2, 0), 0.0f },
+		{ FUintVector4(4, 4, 8, 0), 0.25f },
+		{ FUintVector4(3, 5, 5, 0), 0.9f },
+		{ FUintVector4(5, 5, 4, 0), 0.1f },
+		{ FUintVector4(1, 0, 6, 0), 0.1f }, // two sensors per owner, too few to traverse as packets
+	};
+
+	FRandomStream Random(0x5E115);
+
+	for (const FTestCase& TestCase : TestCases)
+	{
+		const FString CaseName = FString::Printf(TEXT("%ux%u sensors, %u owners"), 1 << TestCase.Dimensions.X, 1 << TestCase.Dimensions.Y, TestCase.Dimensions.Z);
+
+		FCitySampleSensorGridCpuHelper ScalarHelper(TestCase.Dimensions, EExecutionMode::Scalar);
+		FCitySampleSensorGridCpuHelper ParallelHelper(TestCase.Dimensions, EExecutionMode::Parallel);
+
+		TArray<FVector4f> Sensors;
+		GenerateSensors(Random, ScalarHelper.GetSensorsPerOwner() * ScalarHelper.GetOwnerCount(), TestCase.InvalidFraction, Sensors);
+
+		// make sure the compaction has duplicate codes to deal with
+		for (int32 SensorIndex = 1; SensorIndex < Sensors.Num(); SensorIndex += 7)
+		{
+			Sensors[SensorIndex] = Sensors[SensorIndex - 1];
+		}
+
+		TArray<FCitySampleSensorGridHelper::FSensorInfo> ScalarResults;
+		TArray<FCitySampleSensorGridHelper::FSensorInfo> ParallelResults;
+		ScalarHelper.NearestSensors(Sensors, GlobalSensorRange, ScalarResults);
+		ParallelHelper.NearestSensors(Sensors, GlobalSensorRange, ParallelResults);
+
+		bool bModesMatch = ScalarResults.Num() == ParallelResults.Num();
+		for (int32 ResultIndex = 0; bModesMatch && ResultIndex < ScalarResults.Num(); ++ResultIndex)
+		{
+			bModesMatch = ResultsMatch(ScalarResults[ResultIndex], ParallelResults[ResultIndex]);
+		}
+		TestTrue(FString::Printf(TEXT("%s: scalar and parallel results match"), *CaseName), bModesMatch);
+
+		bool bHierarchiesValid = true;
+		bool bLeavesMatch = true;
+		for (uint32 OwnerIndex = 0; OwnerIndex < ScalarHelper.GetOwnerCount(); ++OwnerIndex)
+		{
+			const FCitySampleSensorGridCpuHelper::FOwnerBvh& ScalarBvh = ScalarHelper.GetOwnerBvh(OwnerIndex);
+			const FCitySampleSensorGridCpuHelper::FOwnerBvh& ParallelBvh = ParallelHelper.GetOwnerBvh(OwnerIndex);
+
+			bLeavesMatch &= ScalarBvh.MortonCodes == ParallelBvh.MortonCodes && ScalarBvh.LeafIndices == ParallelBvh.LeafIndices;
+			bHierarchiesValid &= ValidateHierarchy(ScalarBvh, TConstArrayView<FVector4f>(Sensors).Slice(OwnerIndex * ScalarHelper.GetSensorsPerOwner(), ScalarHelper.GetSensorsPerOwner()));
+		}
+		TestTrue(FString::Printf(TEXT("%s: scalar and parallel leaves match"), *CaseName), bLeavesMatch);
+		TestTrue(FString::Printf(TEXT("%s: hierarchies are valid"), *CaseName), bHierarchiesValid);
+
+		int32 Mismatches = 0;
+		int32 FoundCount = 0;
+		for (int32 SensorIndex = 0; SensorIndex < Sensors.Num(); ++SensorIndex)
+		{
+			const FCitySampleSensorGridHelper::FSensorInfo Expected = BruteForceNearestSensor(ScalarHelper, Sensors, SensorIndex, GlobalSensorRange.Y);
+			const FCitySampleSensorGridHelper::FSensorInfo& Actual = ScalarResults[SensorIndex];
+
+			// sensors at the same distance can be picked in a different order, only the distance has to match
+			const bool bExpectedFound = Expected.HitIndex.Z >= 0;
+			const bool bActualFound = Actual.HitIndex.Z >= 0;
+			if (bExpectedFound != bActualFound || Expected.DistanceUint != Actual.DistanceUint)
+			{
+				++Mismatches;
+			}
+			FoundCount += bActualFound ? 1 : 0;
+		}
+
+		TestEqual(FString::Printf(TEXT("%s: mismatches against brute force"), *CaseName), Mismatches, 0);
+		TestTrue(FString::Printf(TEXT("%s: some sensors found a neighbor"), *CaseName), TestCase.InvalidFraction >= 0.9f || FoundCount > 0);
+	}
+
+	// a single owner has nobody to find and everything stays cleared
+	{
+		FCitySampleSensorGridCpuHelper Helper(FUintVector4(4, 4, 1, 0));
+
+		TArray<FVector4f> Sensors;
+		GenerateSensors(Random, Helper.GetSensorsPerOwner(), 0.0f, Sensors);
+
+		TArray<FCitySampleSensorGridHelper::FSensorInfo> Results;
+		Helper.NearestSensors(Sensors, GlobalSensorRange, Results);
+
+		TestEqual("Single owner result count", Results.Num(), Sensors.Num());
+		TestTrue("Single owner results are cleared", Results.Num() && Results[0].HitIndex == FIntVector(-1, -1, -1));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCitySampleSensorGridCpuBenchmark, "CitySampleSensorGrid.Cpu.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+// Compare the scalar and parallel paths against a brute force search as the number of sensors per owner grows
+bool FCitySampleSensorGridCpuBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace CitySampleSensorGridCpuTests;
+	using EExecutionMode = FCitySampleSensorGridCpuHelper::EExecutionMode;
+
+	const FVector2D GlobalSensorRange(0.0, 5000.0);
+	const uint32 OwnerCount = 8;
+
+	FRandomStream Random(0xBE7C4);
+
+	for (uint32 DimensionLog2 = 4; DimensionLog2 <= 7; ++DimensionLog2)
+	{
+		const FUintVector4 Dimensions(DimensionLog2, DimensionLog2, OwnerCount, 0);
+
+		FCitySampleSensorGridCpuHelper ScalarHelper(Dimensions, EExecutionMode::Scalar);
+		FCitySampleSensorGridCpuHelper ParallelHelper(Dimensions, EExecutionMode::Parallel);
+
+		TArray<FVector4f> Sensors;
+		GenerateSensors(Random, ScalarHelper.GetSensorsPerOwner() * OwnerCount, 0.1f, Sensors);
+
+		TArray<FCitySampleSensorGridHelper::FSensorInfo> Results;
+
+		double StartTime = FPlatformTime::Seconds();
+		ScalarHelper.NearestSensors(Sensors, GlobalSensorRange, Results);
+		const double ScalarTime = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		ParallelHelper.NearestSensors(Sensors, GlobalSensorRange, Results);
+		const double ParallelTime = FPlatformTime::Seconds() - StartTime;
+
+		// sum the distances so the brute force search can't be optimized away
+		uint64 Checksum = 0;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 SensorIndex = 0; SensorIndex < Sensors.Num(); ++SensorIndex)
+		{
+			Checksum += BruteForceNearestSensor(ParallelHelper, Sensors, SensorIndex, GlobalSensorRange.Y).DistanceUint;
+		}
+		const double BruteForceTime = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(TEXT("%d sensors (%u owners): scalar %.3fms, parallel %.3fms (%.2fx), brute force %.3fms (checksum %llu)"),
+			Sensors.Num(), OwnerCount, ScalarTime * 1000.0, ParallelTime * 1000.0, ParallelTime > 0.0 ? ScalarTime / ParallelTime : 0.0, BruteForceTime * 1000.0, Checksum));
+	}
+
+	return true;
+}
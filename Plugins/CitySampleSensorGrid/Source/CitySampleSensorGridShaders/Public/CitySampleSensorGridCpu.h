@@ -0,0 +1,121 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "CitySampleSensorGridShaders.h"
+
+/**
+ * CPU implementation of the BVH build and nearest sensor search that FCitySampleSensorGridHelper runs on the GPU.
+ * Every step mirrors its compute shader in CitySampleSensorGridBvh.usf (owner bounds, MortonGeneration, sort and
+ * compaction, HierarchyGeneration_TopDown, BoundsGeneration_BottomUp, BvhTraversal) so that the sensor grid can be
+ * evaluated where there is no GPU and its results can be validated.
+ */
+class CITYSAMPLESENSORGRIDSHADERS_API FCitySampleSensorGridCpuHelper
+{
+public:
+	// c++ mirror of the FInternalNode struct defined in CitySampleSensorGridBvh.usf
+	struct alignas(16) FInternalNode
+	{
+		FVector3f BoundsMin;
+		int32 LeftChild; // negative value indicates it's a leaf node: ~LeftChild is the sensor index, 0 means there is no child
+
+		FVector3f BoundsMax;
+		int32 RightChild; // negative value indicates it's a leaf node: ~RightChild is the sensor index, 0 means there is no child
+	};
+
+	// BVH built over the sensors of a single owner
+	struct FOwnerBvh
+	{
+		FVector3f BoundsMin = FVector3f::ZeroVector;
+		FVector3f BoundsExtent = FVector3f::ZeroVector;
+
+		// sorted leaves, one per unique morton code, along with the index of the sensor they represent
+		TArray<uint32> MortonCodes;
+		TArray<uint32> LeafIndices;
+
+		// node 0 is the root
+		TArray<FInternalNode> InternalNodes;
+	};
+
+	enum class EExecutionMode : uint8
+	{
+		// straight translation of the shaders on a single thread, used as the reference
+		Scalar,
+
+		// owners and traversals spread over worker threads, with the traversals testing four source sensors per vector register
+		Parallel,
+	};
+
+	FCitySampleSensorGridCpuHelper(const FUintVector4& InSensorGridDimensions, EExecutionMode InExecutionMode = EExecutionMode::Parallel);
+
+	/**
+	 * CPU equivalent of FCitySampleSensorGridHelper::NearestSensors.
+	 * SensorLocations holds SensorsPerOwner entries for each owner (xyz for the location, w for the range, negative
+	 * for unused sensors). OutResults gets one entry per sensor, laid out the same way as the GPU results.
+	 * Both execution modes produce the same results, bit for bit.
+	 */
+	void NearestSensors(TConstArrayView<FVector4f> SensorLocations, const FVector2D& GlobalSensorRange, TArray<FCitySampleSensorGridHelper::FSensorInfo>& OutResults);
+
+	/** Builds the BVH of every owner, NearestSensors calls this before running the traversals */
+	void BuildBvhs(TConstArrayView<FVector4f> SensorLocations);
+
+	uint32 GetSensorsPerOwner() const;
+	uint32 GetOwnerCount() const { return SensorGridDimensions.Z; }
+	const FOwnerBvh& GetOwnerBvh(uint32 OwnerIndex) const { return OwnerBvhs[OwnerIndex]; }
+
+	/** Morton3d from CitySampleSensorGridBvh.usf, each component of Location is expected to be in [0..1) */
+	static uint32 Morton3d(const FVector3f& Location, uint32 OwnerIndex, uint32 OwnerBitCount);
+	static uint32 InvalidMorton3d(uint32 OwnerIndex, uint32 OwnerBitCount);
+	static bool IsMortonCodeValid(uint32 MortonCode, uint32 OwnerBitCount);
+
+	/** Distance metric used when comparing a sensor against a leaf, as the bits of a positive float */
+	static uint32 LeafDistanceSqrUint(const FVector4f& TargetSensor, const FVector3f& SourceLocation);
+
+	/** Distance used to initialize the search for the given sensor, as the bits of a positive float */
+	static uint32 InitialDistanceSqrUint(const FVector4f& SourceSensor, float MaxDistance);
+
+private:
+	struct FClosestSensorInfo
+	{
+		uint32 DistanceSqrUint;
+		uint32 SensorIndex;
+		uint32 OwnerIndex;
+	};
+
+	// closest sensors found so far for a packet of four consecutive sensors of the same owner
+	struct FClosestSensorPacket
+	{
+		FClosestSensorInfo Info[4];
+		uint32 ActiveMask; // one bit per sensor that has a valid range and is being searched for
+	};
+
+	// the sensor locations split into one array per component, so that consecutive sensors can be loaded into the lanes of a register
+	struct FSensorColumns
+	{
+		TArray<float> X;
+		TArray<float> Y;
+		TArray<float> Z;
+
+		void Init(TConstArrayView<FVector4f> SensorLocations);
+	};
+
+	void BuildOwnerBvh(uint32 OwnerIndex, TConstArrayView<FVector4f> SensorLocations);
+	void GenerateOwnerBounds(FOwnerBvh& Bvh, TConstArrayView<FVector4f> OwnerSensors) const;
+	void GenerateSortedLeaves(uint32 OwnerIndex, FOwnerBvh& Bvh, TConstArrayView<FVector4f> OwnerSensors) const;
+	void GenerateHierarchy(FOwnerBvh& Bvh, TConstArrayView<FVector4f> OwnerSensors) const;
+
+	void RunTraversal(uint32 SensorIndex, uint32 OwnerIndex, float MaxDistance, TConstArrayView<FVector4f> SensorLocations, FCitySampleSensorGridHelper::FSensorInfo& OutResult) const;
+	void TraverseBvh(const FVector4f& SourceSensor, uint32 TargetOwner, TConstArrayView<FVector4f> SensorLocations, FClosestSensorInfo& ResultsInfo) const;
+
+	void RunTraversalPacket(uint32 FirstSensorIndex, uint32 OwnerIndex, float MaxDistance, const FSensorColumns& SensorColumns, TConstArrayView<FVector4f> SensorLocations, FCitySampleSensorGridHelper::FSensorInfo* OutResults) const;
+	void TraverseBvhPacket(const VectorRegister4Float& SourceX, const VectorRegister4Float& SourceY, const VectorRegister4Float& SourceZ, uint32 TargetOwner, TConstArrayView<FVector4f> SensorLocations, FClosestSensorPacket& Results) const;
+
+	void WriteResult(const FClosestSensorInfo& ClosestSensorInfo, TConstArrayView<FVector4f> SensorLocations, FCitySampleSensorGridHelper::FSensorInfo& OutResult) const;
+
+	const FUintVector4 SensorGridDimensions;
+	const EExecutionMode ExecutionMode;
+	const uint32 TraversalStackSize;
+
+	TArray<FOwnerBvh> OwnerBvhs;
+};
@@ -70,6 +70,8 @@ public:
 
 	static uint32 GetMaxSensorDensity();
 	static uint32 GetMaxOwnerCount();
+	static uint32 GetMortonCodeOwnerBitCount();
+	static uint32 GetTraversalStackSize(uint32 SensorsPerOwner);
 
 	void NearestSensors(
 		FRDGBuilder& GraphBuilder,
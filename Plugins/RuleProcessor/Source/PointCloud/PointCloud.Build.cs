@@ -21,6 +21,13 @@ namespace UnrealBuildTool.Rules
 					"StructUtils"
 				});
 
+			PrivateDependencyModuleNames.AddRange(
+				new string[]
+				{
+					"Json",
+				}
+			);
+
 			if (Target.bBuildEditor)
 			{
 				PrivateDependencyModuleNames.AddRange(
@@ -0,0 +1,319 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PointCloudAttributeIndex.h"
+#include "PointCloudSpatialIndex.h"
+
+namespace PointCloudAttributeIndexPrivate
+{
+	int32 GetNumWords(const TBitArray<>& Bits)
+	{
+		return FMath::DivideAndRoundUp(Bits.Num(), (int32)NumBitsPerDWORD);
+	}
+
+	// Number of bits set in both arrays, bits past the end of an array are always clear
+	int32 CountBitsInBoth(const TBitArray<>& A, const TBitArray<>& B)
+	{
+		check(A.Num() == B.Num());
+
+		const uint32* WordsA = A.GetData();
+		const uint32* WordsB = B.GetData();
+
+		int32 Count = 0;
+		for (int32 WordIndex = 0, NumWords = GetNumWords(A); WordIndex < NumWords; ++WordIndex)
+		{
+			Count += FMath::CountBits(WordsA[WordIndex] & WordsB[WordIndex]);
+		}
+
+		return Count;
+	}
+}
+
+FPointCloudMetadataFilter FPointCloudMetadataFilter::MakeValue(const FString& InKey, const FString& InValue, bool bInInvert)
+{
+	FPointCloudMetadataFilter Filter;
+	Filter.Key = InKey;
+	Filter.Value = InValue;
+	Filter.bInvert = bInInvert;
+	return Filter;
+}
+
+FPointCloudMetadataFilter FPointCloudMetadataFilter::MakePattern(const FString& InKey, const FString& InPattern, bool bInInvert)
+{
+	FPointCloudMetadataFilter Filter = MakeValue(InKey, InPattern, bInInvert);
+	Filter.bGlob = true;
+	return Filter;
+}
+
+bool FPointCloudMetadataFilter::Matches(const FString& InValue) const
+{
+	const bool bMatches = bGlob ? MatchesGlob(*Value, *InValue) : InValue.Equals(Value, ESearchCase::CaseSensitive);
+	return bMatches != bInvert;
+}
+
+bool FPointCloudMetadataFilter::MatchesGlob(const TCHAR* Pattern, const TCHAR* InValue)
+{
+	// Follows patternCompare in sqlite, so that the native and SQL filters agree on every pattern, including malformed ones
+	while (*Pattern)
+	{
+		const TCHAR PatternChar = *Pattern++;
+
+		if (PatternChar == TEXT('*'))
+		{
+			while (*Pattern == TEXT('*'))
+			{
+				++Pattern;
+			}
+
+			if (*Pattern == 0)
+			{
+				return true;
+			}
+
+			for (; *InValue; ++InValue)
+			{
+				if (MatchesGlob(Pattern, InValue))
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		const TCHAR ValueChar = *InValue++;
+
+		if (ValueChar == 0)
+		{
+			return false;
+		}
+
+		if (PatternChar == TEXT('?'))
+		{
+			continue;
+		}
+
+		if (PatternChar == TEXT('['))
+		{
+			bool bSeen = false;
+			bool bInvertSet = false;
+			TCHAR PriorChar = 0;
+			TCHAR SetChar = *Pattern++;
+
+			if (SetChar == TEXT('^'))
+			{
+				bInvertSet = true;
+				SetChar = *Pattern++;
+			}
+
+			// A ] straight after the opening bracket is part of the set
+			if (SetChar == TEXT(']'))
+			{
+				bSeen = ValueChar == TEXT(']');
+				SetChar = *Pattern++;
+			}
+
+			while (SetChar && SetChar != TEXT(']'))
+			{
+				if (SetChar == TEXT('-') && *Pattern != TEXT(']') && *Pattern != 0 && PriorChar > 0)
+				{
+					SetChar = *Pattern++;
+					bSeen |= ValueChar >= PriorChar && ValueChar <= SetChar;
+					PriorChar = 0;
+				}
+				else
+				{
+					bSeen |= ValueChar == SetChar;
+					PriorChar = SetChar;
+				}
+
+				SetChar = *Pattern++;
+			}
+
+			// An unterminated set never matches
+			if (SetChar == 0 || bSeen == bInvertSet)
+			{
+				return false;
+			}
+
+			continue;
+		}
+
+		if (PatternChar != ValueChar)
+		{
+			return false;
+		}
+	}
+
+	return *InValue == 0;
+}
+
+FPointCloudAttributeIndex::FPointCloudAttributeIndex(const TSharedPtr<const FPointCloudSpatialIndex>& InSpatialIndex, const TArray<int32>& InRowIds, const TArray<int32>& InValueIds, const TMap<int32, FString>& InValues)
+	: SpatialIndex(InSpatialIndex)
+{
+	check(SpatialIndex.IsValid());
+	check(InRowIds.Num() == InValueIds.Num());
+
+	InValues.GenerateKeyArray(ValueIds);
+	ValueIds.Sort();
+
+	TMap<int32, int32> ValueIndexFromId;
+	ValueIndexFromId.Reserve(ValueIds.Num());
+
+	bNumeric = ValueIds.Num() > 0;
+
+	for (int32 ValueIndex = 0; ValueIndex < ValueIds.Num(); ++ValueIndex)
+	{
+		const FString& Value = InValues[ValueIds[ValueIndex]];
+
+		ValueIndexFromId.Add(ValueIds[ValueIndex], ValueIndex);
+		Values.Add(Value);
+
+		// Non numeric values convert to their leading number, or zero, as they do when SQL reads them as numbers
+		ValueNumbers.Add(FCString::Atod(*Value));
+		bNumeric &= FCString::IsNumeric(*Value);
+	}
+
+	ValueCounts.SetNumZeroed(Values.Num());
+	ValueIndices.Init(INDEX_NONE, SpatialIndex->Num());
+
+	for (int32 Row = 0; Row < InRowIds.Num(); ++Row)
+	{
+		const int32 PointIndex = SpatialIndex->GetIndexFromRowId(InRowIds[Row]);
+		const int32* ValueIndex = ValueIndexFromId.Find(InValueIds[Row]);
+
+		if (PointIndex == INDEX_NONE || ValueIndex == nullptr)
+		{
+			continue;
+		}
+
+		if (ValueIndices[PointIndex] != INDEX_NONE)
+		{
+			--ValueCounts[ValueIndices[PointIndex]];
+		}
+
+		ValueIndices[PointIndex] = *ValueIndex;
+		++ValueCounts[*ValueIndex];
+	}
+
+	if (Values.Num() <= MaxBitmapValues)
+	{
+		Bitmaps.Init(TBitArray<>(false, Num()), Values.Num());
+
+		for (int32 PointIndex = 0; PointIndex < Num(); ++PointIndex)
+		{
+			if (ValueIndices[PointIndex] != INDEX_NONE)
+			{
+				Bitmaps[ValueIndices[PointIndex]][PointIndex] = true;
+			}
+		}
+	}
+
+	if (bNumeric)
+	{
+		PointNumbers.SetNumZeroed(Num());
+
+		for (int32 PointIndex = 0; PointIndex < Num(); ++PointIndex)
+		{
+			if (ValueIndices[PointIndex] != INDEX_NONE)
+			{
+				PointNumbers[PointIndex] = ValueNumbers[ValueIndices[PointIndex]];
+			}
+		}
+	}
+}
+
+TBitArray<> FPointCloudAttributeIndex::MatchValues(const FPointCloudMetadataFilter& Filter) const
+{
+	// Each distinct value is tested once, however many points hold it
+	TBitArray<> Matches(false, Values.Num());
+
+	for (int32 ValueIndex = 0; ValueIndex < Values.Num(); ++ValueIndex)
+	{
+		Matches[ValueIndex] = Filter.Matches(Values[ValueIndex]);
+	}
+
+	return Matches;
+}
+
+void FPointCloudAttributeIndex::Intersect(const FPointCloudMetadataFilter& Filter, TBitArray<>& InOutBits) const
+{
+	using namespace PointCloudAttributeIndexPrivate;
+
+	check(InOutBits.Num() == Num());
+
+	const TBitArray<> Matches = MatchValues(Filter);
+
+	if (HasBitmaps())
+	{
+		TBitArray<> Keep(false, Num());
+
+		for (TConstSetBitIterator<> It(Matches); It; ++It)
+		{
+			Keep.CombineWithBitwiseOR(Bitmaps[It.GetIndex()], EBitwiseOperatorFlags::MaintainSize);
+		}
+
+		InOutBits.CombineWithBitwiseAND(Keep, EBitwiseOperatorFlags::MaintainSize);
+		return;
+	}
+
+	// Only the points still in the result set are looked at, a word at a time
+	uint32* Words = InOutBits.GetData();
+
+	for (int32 WordIndex = 0, NumWords = GetNumWords(InOutBits); WordIndex < NumWords; ++WordIndex)
+	{
+		uint32 Word = Words[WordIndex];
+		uint32 Keep = 0;
+
+		while (Word)
+		{
+			const uint32 Bit = FMath::CountTrailingZeros(Word);
+			const int32 ValueIndex = ValueIndices[WordIndex * NumBitsPerDWORD + Bit];
+
+			if (ValueIndex != INDEX_NONE && Matches[ValueIndex])
+			{
+				Keep |= 1u << Bit;
+			}
+
+			Word &= Word - 1;
+		}
+
+		Words[WordIndex] = Keep;
+	}
+}
+
+TArray<int32> FPointCloudAttributeIndex::CountValues(const TBitArray<>* Bits) const
+{
+	using namespace PointCloudAttributeIndexPrivate;
+
+	if (Bits == nullptr)
+	{
+		return ValueCounts;
+	}
+
+	check(Bits->Num() == Num());
+
+	TArray<int32> Counts;
+	Counts.SetNumZeroed(Values.Num());
+
+	if (HasBitmaps())
+	{
+		for (int32 ValueIndex = 0; ValueIndex < Values.Num(); ++ValueIndex)
+		{
+			Counts[ValueIndex] = CountBitsInBoth(*Bits, Bitmaps[ValueIndex]);
+		}
+
+		return Counts;
+	}
+
+	for (TConstSetBitIterator<> It(*Bits); It; ++It)
+	{
+		const int32 ValueIndex = ValueIndices[It.GetIndex()];
+
+		if (ValueIndex != INDEX_NONE)
+		{
+			++Counts[ValueIndex];
+		}
+	}
+
+	return Counts;
+}
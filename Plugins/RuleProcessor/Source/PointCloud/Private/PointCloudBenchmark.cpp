@@ -0,0 +1,409 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PointCloudBenchmark.h"
+#include "PointCloudConfig.h"
+#include "PointCloudImpl.h"
+#include "PointCloudTilePartition.h"
+#include "PointCloudView.h"
+
+#include "Dom/JsonObject.h"
+#include "Math/RandomStream.h"
+#include "Misc/App.h"
+#include "Misc/EngineVersion.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/Package.h"
+
+namespace PointCloudBenchmarkPrivate
+{
+	// Average distance between neighbouring points, the synthetic clouds grow in area rather than in density
+	static constexpr double PointSpacing = 10.0;
+
+	// Number of points that share a value of the Name key
+	static constexpr int32 PointsPerName = 100;
+
+	/** Records the time spent in a stage of the benchmark as "Benchmark <Stage>" */
+	class FStageTimer
+	{
+	public:
+		FStageTimer(const FPointCloudStatsPtr& InStats, const TCHAR* InStageName)
+			: Stats(InStats), StageName(InStageName), StartTime(FPlatformTime::Seconds())
+		{
+		}
+
+		~FStageTimer()
+		{
+			Stats->AddTimingToEvent(FString::Printf(TEXT("Benchmark %s"), StageName), FTimespan::FromSeconds(FPlatformTime::Seconds() - StartTime));
+		}
+
+	private:
+		FPointCloudStatsPtr Stats;
+		const TCHAR* StageName;
+		double StartTime;
+	};
+
+	/** Point cloud that is kept from garbage collection while the benchmark uses it */
+	class FScopedPointCloud
+	{
+	public:
+		explicit FScopedPointCloud(const FPointCloudStatsPtr& Stats)
+			: PointCloud(NewObject<UPointCloudImpl>(GetTransientPackage(), NAME_None, RF_Transient))
+		{
+			PointCloud->AddToRoot();
+			PointCloud->SetStats(Stats);
+		}
+
+		~FScopedPointCloud()
+		{
+			PointCloud->SetStats(nullptr);
+			PointCloud->ClearRootViews();
+			PointCloud->RemoveFromRoot();
+			PointCloud->MarkAsGarbage();
+		}
+
+		UPointCloudImpl* operator->() const { return PointCloud; }
+		UPointCloudImpl* Get() const { return PointCloud; }
+
+	private:
+		UPointCloudImpl* PointCloud;
+	};
+
+	/** Run a filter on a new view and record the number of points that pass it as "Benchmark <Stage> Points" */
+	void RunFilter(const FPointCloudStatsPtr& Stats, UPointCloudImpl* PointCloud, const TCHAR* StageName, TFunctionRef<void(UPointCloudView*)> ApplyFilter)
+	{
+		FStageTimer Timer(Stats, StageName);
+
+		UPointCloudView* View = PointCloud->MakeView();
+		ApplyFilter(View);
+
+		TArray<int32> Ids;
+		View->GetIndexes(Ids);
+
+		Stats->AddToCounter(FString::Printf(TEXT("Benchmark %s Points"), StageName), Ids.Num());
+	}
+
+	TSharedRef<FJsonObject> MakeTimersObject(const FPointCloudStats& Stats)
+	{
+		TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+
+		TArray<FString> Names = Stats.GetTimerNames().Array();
+		Names.Sort();
+
+		for (const FString& Name : Names)
+		{
+			Object->SetNumberField(Name, Stats.GetTimerValue(Name).GetTotalSeconds());
+		}
+
+		return Object;
+	}
+
+	TSharedRef<FJsonObject> MakeCountersObject(const FPointCloudStats& Stats)
+	{
+		TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+
+		TArray<FString> Names = Stats.GetCounterNames().Array();
+		Names.Sort();
+
+		for (const FString& Name : Names)
+		{
+			Object->SetNumberField(Name, (double)Stats.GetCounterValue(Name));
+		}
+
+		return Object;
+	}
+}
+
+void FPointCloudBenchmark::MakeSyntheticCloud(int32 NumPoints, int32 Seed,
+	TArray<FTransform>& OutTransforms,
+	TArray<FString>& OutMetadataColumnNames,
+	TArray<int>& OutMetadataCountPerVertex,
+	TArray<TPair<int, FString>>& OutPreparedMetadata)
+{
+	using namespace PointCloudBenchmarkPrivate;
+
+	FRandomStream Random(Seed);
+
+	const double Extent = FMath::Sqrt((double)NumPoints) * PointSpacing;
+
+	OutMetadataColumnNames = { TEXT("Group"), TEXT("Height"), TEXT("Name") };
+
+	OutTransforms.Reset(NumPoints);
+	OutMetadataCountPerVertex.Reset(NumPoints);
+	OutPreparedMetadata.Reset(NumPoints * OutMetadataColumnNames.Num());
+
+	for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+	{
+		const FVector Location(Random.FRandRange(0.0, Extent), Random.FRandRange(0.0, Extent), Random.FRandRange(0.0, 100.0));
+		const FRotator Rotation(0.0, Random.FRandRange(0.0, 360.0), 0.0);
+		const float Height = Random.FRandRange(1.0, 50.0);
+
+		OutTransforms.Emplace(Rotation, Location, FVector(1.0, 1.0, Height / 10.0));
+
+		OutPreparedMetadata.Emplace(0, FString::FromInt(Random.RandHelper(16)));
+		OutPreparedMetadata.Emplace(1, FString::SanitizeFloat(Height));
+		OutPreparedMetadata.Emplace(2, FString::Printf(TEXT("Building_%d"), PointIndex / PointsPerName));
+		OutMetadataCountPerVertex.Add(OutMetadataColumnNames.Num());
+	}
+}
+
+FPointCloudBenchmark::FRun FPointCloudBenchmark::RunSize(const FSettings& Settings, int32 NumPoints)
+{
+	using namespace PointCloudBenchmarkPrivate;
+
+	FRun Run;
+	Run.NumPoints = NumPoints;
+	Run.Stats = MakeShared<FPointCloudStats>();
+
+	const FPointCloudStatsPtr& Stats = Run.Stats;
+
+	TArray<FTransform> Transforms;
+	TArray<FString> MetadataColumnNames;
+	TArray<int> MetadataCountPerVertex;
+	TArray<TPair<int, FString>> PreparedMetadata;
+
+	{
+		FStageTimer Timer(Stats, TEXT("Generate"));
+		MakeSyntheticCloud(NumPoints, Settings.Seed, Transforms, MetadataColumnNames, MetadataCountPerVertex, PreparedMetadata);
+	}
+
+	FScopedPointCloud PointCloud(Stats);
+
+	{
+		FStageTimer Timer(Stats, TEXT("Load"));
+
+		if (!PointCloud->InitFromPreparedData(TEXT("Benchmark"), Transforms, MetadataColumnNames, MetadataCountPerVertex, PreparedMetadata, FBox(EForceInit::ForceInit)))
+		{
+			UE_LOG(PointCloudLog, Error, TEXT("Failed to load the %d point benchmark cloud"), NumPoints);
+			return Run;
+		}
+	}
+
+	// The prepared data is no longer needed, and holds far more memory than the database
+	Transforms.Empty();
+	PreparedMetadata.Empty();
+
+	{
+		PointCloud->InvalidateHash(/*bContentChanged=*/true);
+
+		FStageTimer Timer(Stats, TEXT("Hash Full"));
+		PointCloud->GetHashAsString();
+	}
+
+	{
+		PointCloud->InvalidateHash();
+
+		FStageTimer Timer(Stats, TEXT("Hash Incremental"));
+		PointCloud->GetHashAsString();
+	}
+
+	{
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes, /*bIsPersistent=*/true);
+
+		{
+			FStageTimer Timer(Stats, TEXT("Serialize"));
+			PointCloud->Serialize(Writer);
+		}
+
+		FScopedPointCloud LoadedCloud(Stats);
+
+		FMemoryReader Reader(Bytes, /*bIsPersistent=*/true);
+		Reader.SetCustomVersions(Writer.GetCustomVersions());
+
+		{
+			FStageTimer Timer(Stats, TEXT("Deserialize"));
+			LoadedCloud->Serialize(Reader);
+		}
+
+		Stats->AddToCounter(TEXT("Benchmark Serialized Bytes"), Bytes.Num());
+		Stats->AddToCounter(TEXT("Benchmark Deserialized Points"), LoadedCloud->GetCount());
+	}
+
+	const FBox Bounds = PointCloud->GetBounds();
+	const FVector Center = Bounds.GetCenter();
+	const FVector Extent = Bounds.GetExtent();
+
+	// Spatial filters that each keep about a quarter of the points, then metadata filters
+	RunFilter(Stats, PointCloud.Get(), TEXT("Filter Box"), [&](UPointCloudView* View) { View->FilterOnBoundingBox(FBox(Bounds.Min, Center), false); });
+	RunFilter(Stats, PointCloud.Get(), TEXT("Filter Sphere"), [&](UPointCloudView* View) { View->FilterOnBoundingSphere(Center, Extent.Size2D() * 0.4); });
+	RunFilter(Stats, PointCloud.Get(), TEXT("Filter Oriented Box"), [&](UPointCloudView* View) { View->FilterOnOrientedBoundingBox(FTransform(FRotator(0, 30, 0), Center, Extent * FVector(0.5, 0.5, 1.0)), false); });
+	RunFilter(Stats, PointCloud.Get(), TEXT("Filter Expression"), [&](UPointCloudView* View) { View->FilterOnPointExpression(FString::Printf(TEXT("Minz > %f"), Center.Z)); });
+	RunFilter(Stats, PointCloud.Get(), TEXT("Filter Metadata"), [&](UPointCloudView* View) { View->FilterOnMetadata(TEXT("Group"), TEXT("3")); });
+	RunFilter(Stats, PointCloud.Get(), TEXT("Filter Metadata Pattern"), [&](UPointCloudView* View) { View->FilterOnMetadataPattern(TEXT("Name"), TEXT("Building_1*")); });
+	RunFilter(Stats, PointCloud.Get(), TEXT("Filter Box And Metadata"), [&](UPointCloudView* View)
+		{
+			View->FilterOnBoundingBox(FBox(Bounds.Min, Center), false);
+			View->FilterOnMetadata(TEXT("Group"), TEXT("3"));
+		});
+
+	{
+		FStageTimer Timer(Stats, TEXT("Metadata Counts"));
+
+		UPointCloudView* View = PointCloud->MakeView();
+		Stats->AddToCounter(TEXT("Benchmark Metadata Counts Values"), View->GetUniqueMetadataValuesAndCounts(TEXT("Name")).Num());
+
+		View->FilterOnBoundingBox(FBox(Bounds.Min, Center), false);
+		Stats->AddToCounter(TEXT("Benchmark Metadata Counts Filtered Values"), View->GetUniqueMetadataValuesAndCounts({ TEXT("Group"), TEXT("Name") }).Num());
+	}
+
+	{
+		FStageTimer Timer(Stats, TEXT("Metadata Values"));
+
+		UPointCloudView* View = PointCloud->MakeView();
+		View->FilterOnMetadata(TEXT("Group"), TEXT("3"));
+		Stats->AddToCounter(TEXT("Benchmark Metadata Values Points"), View->GetMetadataValuesArrayAsFloat(TEXT("Height")).Num());
+	}
+
+	// Tiles of a parent view, in the way slice and dice rules split a point cloud
+	{
+		FStageTimer Timer(Stats, TEXT("Tiles"));
+
+		UPointCloudView* View = PointCloud->MakeView();
+		const int32 NumTiles = FMath::Max(Settings.NumTilesPerAxis, 1);
+
+		for (int32 TileY = 0; TileY < NumTiles; ++TileY)
+		{
+			for (int32 TileX = 0; TileX < NumTiles; ++TileX)
+			{
+				UPointCloudView* Tile = View->MakeChildView();
+				Tile->FilterOnTile(Bounds, NumTiles, NumTiles, 1, TileX, TileY, 0, false);
+
+				Stats->AddToCounter(TEXT("Benchmark Tiles Points"), Tile->GetPerIdTransforms().Num());
+				View->RemoveChildView(Tile);
+			}
+		}
+	}
+
+	// The same tiles, with the points of the parent view partitioned once the way the tile iterator does. Only the points are counted,
+	// reading their transforms back from the database would take far longer than the filters being measured
+	{
+		FStageTimer Timer(Stats, TEXT("Tiles Partitioned"));
+
+		UPointCloudView* View = PointCloud->MakeView();
+		const int32 NumTiles = FMath::Max(Settings.NumTilesPerAxis, 1);
+
+		TSharedPtr<const FPointCloudTilePartition> Partition;
+
+		for (int32 TileY = 0; TileY < NumTiles; ++TileY)
+		{
+			for (int32 TileX = 0; TileX < NumTiles; ++TileX)
+			{
+				UPointCloudView* Tile = View->MakeChildView();
+
+				if (!Partition.IsValid())
+				{
+					Partition = Tile->MakeTilePartition(Bounds, NumTiles, NumTiles, 1);
+				}
+
+				if (Partition.IsValid())
+				{
+					Tile->FilterOnTile(Partition, TileX, TileY, 0);
+				}
+				else
+				{
+					Tile->FilterOnTile(Bounds, NumTiles, NumTiles, 1, TileX, TileY, 0, false);
+				}
+
+				Stats->AddToCounter(TEXT("Benchmark Tiles Partitioned Points"), Tile->GetCount());
+				View->RemoveChildView(Tile);
+			}
+		}
+	}
+
+	// Per point rules make a view for each point of a tile and read its transform and metadata
+	{
+		FStageTimer Timer(Stats, TEXT("Rule Iteration"));
+
+		UPointCloudView* View = PointCloud->MakeView();
+		View->FilterOnBoundingBox(FBox(Bounds.Min, Center), false);
+
+		const TSharedPtr<const FPointCloudViewPoints> Points = MakeShared<FPointCloudViewPoints>(View);
+		const int32 NumPointViews = FMath::Min(Settings.NumPointViews, Points->Num());
+
+		for (int32 PointIndex = 0; PointIndex < NumPointViews; ++PointIndex)
+		{
+			UPointCloudView* PointView = View->MakePointView(Points, PointIndex);
+
+			Stats->AddToCounter(TEXT("Benchmark Rule Iteration Points"), PointView->GetTransforms().Num());
+			Stats->AddToCounter(TEXT("Benchmark Rule Iteration Values"), PointView->GetUniqueMetadataValues(TEXT("Name")).Num());
+
+			View->RemoveChildView(PointView);
+		}
+	}
+
+	Run.bSuccess = true;
+
+	return Run;
+}
+
+TArray<FPointCloudBenchmark::FRun> FPointCloudBenchmark::Run(const FSettings& Settings)
+{
+	TArray<FRun> Runs;
+
+	for (const int32 NumPoints : Settings.Sizes)
+	{
+		UE_LOG(PointCloudLog, Display, TEXT("Running the point cloud benchmark on %d points"), NumPoints);
+
+		Runs.Add(RunSize(Settings, NumPoints));
+
+		// Release the views and point clouds of this run before the next, larger, one
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	return Runs;
+}
+
+FString FPointCloudBenchmark::MakeReport(const FSettings& Settings, const TArray<FRun>& Runs)
+{
+	using namespace PointCloudBenchmarkPrivate;
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetNumberField(TEXT("Version"), ReportVersion);
+
+	TSharedRef<FJsonObject> Build = MakeShared<FJsonObject>();
+	Build->SetStringField(TEXT("EngineVersion"), FEngineVersion::Current().ToString());
+	Build->SetStringField(TEXT("BuildVersion"), FApp::GetBuildVersion());
+	Build->SetStringField(TEXT("Configuration"), LexToString(FApp::GetBuildConfiguration()));
+	Build->SetStringField(TEXT("Platform"), FPlatformProperties::IniPlatformName());
+	Build->SetNumberField(TEXT("Cores"), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+	Build->SetStringField(TEXT("Date"), FDateTime::UtcNow().ToIso8601());
+	Report->SetObjectField(TEXT("Build"), Build);
+
+	TArray<TSharedPtr<FJsonValue>> Sizes;
+	for (const int32 NumPoints : Settings.Sizes)
+	{
+		Sizes.Add(MakeShared<FJsonValueNumber>(NumPoints));
+	}
+
+	TSharedRef<FJsonObject> SettingsObject = MakeShared<FJsonObject>();
+	SettingsObject->SetArrayField(TEXT("Sizes"), Sizes);
+	SettingsObject->SetNumberField(TEXT("Seed"), Settings.Seed);
+	SettingsObject->SetNumberField(TEXT("NumTilesPerAxis"), Settings.NumTilesPerAxis);
+	SettingsObject->SetNumberField(TEXT("NumPointViews"), Settings.NumPointViews);
+	Report->SetObjectField(TEXT("Settings"), SettingsObject);
+
+	TArray<TSharedPtr<FJsonValue>> RunValues;
+	for (const FRun& Run : Runs)
+	{
+		TSharedRef<FJsonObject> RunObject = MakeShared<FJsonObject>();
+		RunObject->SetNumberField(TEXT("NumPoints"), Run.NumPoints);
+		RunObject->SetBoolField(TEXT("Success"), Run.bSuccess);
+
+		if (Run.Stats.IsValid())
+		{
+			RunObject->SetObjectField(TEXT("Timers"), MakeTimersObject(*Run.Stats));
+			RunObject->SetObjectField(TEXT("Counters"), MakeCountersObject(*Run.Stats));
+		}
+
+		RunValues.Add(MakeShared<FJsonValueObject>(RunObject));
+	}
+	Report->SetArrayField(TEXT("Runs"), RunValues);
+
+	FString Result;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Result);
+	FJsonSerializer::Serialize(Report, Writer);
+
+	return Result;
+}
@@ -0,0 +1,67 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PointCloudBenchmarkCommandlet.h"
+#include "PointCloudBenchmark.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY(LogPointCloudBenchmark);
+
+int32 UPointCloudBenchmarkCommandlet::Main(const FString& Params)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UPointCloudBenchmarkCommandlet::Main);
+
+	FPointCloudBenchmark::FSettings Settings;
+
+	FString SizesParam;
+	if (FParse::Value(*Params, TEXT("Sizes="), SizesParam, /*bShouldStopOnSeparator=*/false))
+	{
+		TArray<FString> SizeStrings;
+		SizesParam.ParseIntoArray(SizeStrings, TEXT(","));
+
+		Settings.Sizes.Reset();
+		for (const FString& SizeString : SizeStrings)
+		{
+			const int32 Size = FCString::Atoi(*SizeString);
+
+			if (Size <= 0)
+			{
+				UE_LOG(LogPointCloudBenchmark, Error, TEXT("Invalid size '%s'"), *SizeString);
+				return 1;
+			}
+
+			Settings.Sizes.Add(Size);
+		}
+	}
+
+	FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+	FParse::Value(*Params, TEXT("Tiles="), Settings.NumTilesPerAxis);
+	FParse::Value(*Params, TEXT("PointViews="), Settings.NumPointViews);
+
+	FString OutputPath;
+	if (!FParse::Value(*Params, TEXT("Output="), OutputPath))
+	{
+		OutputPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("PointCloudBenchmark"), FString::Printf(TEXT("PointCloudBenchmark-%s.json"), *FDateTime::Now().ToString()));
+	}
+
+	const TArray<FPointCloudBenchmark::FRun> Runs = FPointCloudBenchmark::Run(Settings);
+
+	if (!FFileHelper::SaveStringToFile(FPointCloudBenchmark::MakeReport(Settings, Runs), *OutputPath))
+	{
+		UE_LOG(LogPointCloudBenchmark, Error, TEXT("Failed to write the report to '%s'"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogPointCloudBenchmark, Display, TEXT("Wrote the point cloud benchmark report to '%s'"), *OutputPath);
+
+	for (const FPointCloudBenchmark::FRun& Run : Runs)
+	{
+		if (!Run.bSuccess)
+		{
+			UE_LOG(LogPointCloudBenchmark, Error, TEXT("The %d point run failed"), Run.NumPoints);
+			return 1;
+		}
+	}
+
+	return 0;
+}
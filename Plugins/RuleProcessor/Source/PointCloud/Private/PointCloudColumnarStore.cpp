@@ -0,0 +1,537 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PointCloudColumnarStore.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "PointCloudConfig.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace PointCloudColumnarStorePrivate
+{
+	// Magic, Version and Header size
+	constexpr int64 PreambleSize = sizeof(uint32) + sizeof(uint32) + sizeof(uint64);
+
+	uint64 Align(uint64 Offset)
+	{
+		constexpr uint64 Alignment = FPointCloudColumnarStore::ColumnAlignment;
+		return (Offset + Alignment - 1) & ~(Alignment - 1);
+	}
+
+	/** Largest number of metadata attributes accepted when reading a file */
+	constexpr int32 MaxAttributes = 64 * 1024;
+
+	/**
+	* Serialize an array of strings. When loading, the number of strings and the length of each string are checked against MaxNum and the
+	* bytes left in the archive before anything is allocated, so a corrupt header cannot request more memory than the file could describe
+	*/
+	void SerializeStrings(FArchive& Ar, TArray<FString>& Strings, int32 MaxNum = MAX_int32)
+	{
+		if (!Ar.IsLoading())
+		{
+			Ar << Strings;
+			return;
+		}
+
+		int32 Num = 0;
+		Ar << Num;
+
+		// Every string is at least its length prefix
+		if (Ar.IsError() || Num < 0 || Num > MaxNum || Num > (Ar.TotalSize() - Ar.Tell()) / (int64)sizeof(int32))
+		{
+			Ar.SetError();
+			return;
+		}
+
+		Strings.Empty(Num);
+
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			const int64 LengthOffset = Ar.Tell();
+			int32 Length = 0;
+			Ar << Length;
+			Ar.Seek(LengthOffset);
+
+			// A negative length marks a UTF-16 string
+			const int64 NumBytes = Length < 0 ? -(int64)Length * (int64)sizeof(UTF16CHAR) : (int64)Length;
+
+			if (Ar.IsError() || NumBytes > Ar.TotalSize() - LengthOffset - (int64)sizeof(int32))
+			{
+				Ar.SetError();
+				return;
+			}
+
+			Ar << Strings.AddDefaulted_GetRef();
+		}
+	}
+
+	/** Everything in the file that isn't column data */
+	struct FHeader
+	{
+		int32 NumPoints = 0;
+		TArray<FString> AttributeNames;
+		TArray<TArray<FString>> Dictionaries;
+		uint64 PositionsOffset = 0;
+		uint64 OrientationsOffset = 0;
+		uint64 ScalesOffset = 0;
+		TArray<uint64> ValueIdOffsets;
+
+		void Serialize(FArchive& Ar)
+		{
+			Ar << NumPoints;
+			SerializeStrings(Ar, AttributeNames, MaxAttributes);
+
+			int32 NumDictionaries = Dictionaries.Num();
+			Ar << NumDictionaries;
+
+			if (Ar.IsLoading())
+			{
+				if (Ar.IsError() || NumDictionaries != AttributeNames.Num() || NumDictionaries > MaxAttributes)
+				{
+					Ar.SetError();
+					return;
+				}
+
+				Dictionaries.SetNum(NumDictionaries);
+			}
+
+			for (TArray<FString>& Dictionary : Dictionaries)
+			{
+				SerializeStrings(Ar, Dictionary);
+
+				if (Ar.IsError())
+				{
+					return;
+				}
+			}
+
+			Ar << PositionsOffset;
+			Ar << OrientationsOffset;
+			Ar << ScalesOffset;
+
+			// One offset per attribute, read element by element so the count is checked before it is allocated
+			int32 NumValueIdOffsets = ValueIdOffsets.Num();
+			Ar << NumValueIdOffsets;
+
+			if (Ar.IsLoading())
+			{
+				if (Ar.IsError() || NumValueIdOffsets != AttributeNames.Num())
+				{
+					Ar.SetError();
+					return;
+				}
+
+				ValueIdOffsets.SetNum(NumValueIdOffsets);
+			}
+
+			for (uint64& ValueIdOffset : ValueIdOffsets)
+			{
+				Ar << ValueIdOffset;
+			}
+		}
+	};
+
+	bool IsColumnInImage(uint64 Offset, uint64 Size, int64 ImageSize)
+	{
+		return (Offset % FPointCloudColumnarStore::ColumnAlignment) == 0 && Offset <= (uint64)ImageSize && Size <= (uint64)ImageSize - Offset;
+	}
+
+	void WritePadding(FArchive& Ar, uint64 TargetOffset)
+	{
+		static const uint8 Zeros[FPointCloudColumnarStore::ColumnAlignment] = { 0 };
+		const uint64 Padding = TargetOffset - (uint64)Ar.Tell();
+		check(Padding < FPointCloudColumnarStore::ColumnAlignment);
+		Ar.Serialize((void*)Zeros, Padding);
+	}
+}
+
+FPointCloudColumnarStore::FPointCloudColumnarStore()
+	: NumPoints(0)
+{
+}
+
+FPointCloudColumnarStore::~FPointCloudColumnarStore()
+{
+	Reset();
+}
+
+void FPointCloudColumnarStore::Reset()
+{
+	Positions = TArrayView<const FVector3f>();
+	Orientations = TArrayView<const FVector4f>();
+	Scales = TArrayView<const FVector3f>();
+	ValueIds.Empty();
+
+	OwnedPositions.Empty();
+	OwnedOrientations.Empty();
+	OwnedScales.Empty();
+	OwnedValueIds.Empty();
+	OwnedImage.Empty();
+
+	// The region must be released before the handle that owns it
+	MappedRegion.Reset();
+	MappedFile.Reset();
+
+	Attributes.Empty();
+	NumPoints = 0;
+}
+
+bool FPointCloudColumnarStore::InitFromPreparedData(const TArray<FTransform>& Transforms,
+	const TArray<FString>& MetadataColumnNames,
+	const TArray<int>& MetadataCountPerVertex,
+	const TArray<TPair<int, FString>>& PreparedMetadata)
+{
+	Reset();
+
+	if (Transforms.Num() != MetadataCountPerVertex.Num())
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Columnar Store : Incorrect number of metadata entries %d vs %d expected Points"), MetadataCountPerVertex.Num(), Transforms.Num());
+		return false;
+	}
+
+	NumPoints = Transforms.Num();
+
+	OwnedPositions.SetNumUninitialized(NumPoints);
+	OwnedOrientations.SetNumUninitialized(NumPoints);
+	OwnedScales.SetNumUninitialized(NumPoints);
+
+	for (int32 i = 0; i < NumPoints; ++i)
+	{
+		const FTransform& Transform = Transforms[i];
+		const FQuat Rotation = Transform.GetRotation();
+
+		OwnedPositions[i] = FVector3f(Transform.GetTranslation());
+		OwnedOrientations[i] = FVector4f(Rotation.X, Rotation.Y, Rotation.Z, Rotation.W);
+		OwnedScales[i] = FVector3f(Transform.GetScale3D());
+	}
+
+	Attributes.SetNum(MetadataColumnNames.Num());
+	OwnedValueIds.SetNum(MetadataColumnNames.Num());
+
+	TArray<TMap<FString, int32>> DictionaryLookup;
+	DictionaryLookup.SetNum(MetadataColumnNames.Num());
+
+	for (int32 AttributeIndex = 0; AttributeIndex < MetadataColumnNames.Num(); ++AttributeIndex)
+	{
+		Attributes[AttributeIndex].Name = MetadataColumnNames[AttributeIndex];
+		OwnedValueIds[AttributeIndex].Init(NoValue, NumPoints);
+	}
+
+	int32 MetadataIndex = 0;
+	for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+	{
+		for (int32 Entry = 0; Entry < MetadataCountPerVertex[PointIndex]; ++Entry, ++MetadataIndex)
+		{
+			if (!PreparedMetadata.IsValidIndex(MetadataIndex))
+			{
+				UE_LOG(PointCloudLog, Warning, TEXT("Columnar Store : Metadata count per vertex exceeds the %d metadata entries provided"), PreparedMetadata.Num());
+				Reset();
+				return false;
+			}
+
+			const TPair<int, FString>& Metadata = PreparedMetadata[MetadataIndex];
+
+			if (!Attributes.IsValidIndex(Metadata.Key))
+			{
+				UE_LOG(PointCloudLog, Warning, TEXT("Columnar Store : Invalid metadata column index %d"), Metadata.Key);
+				Reset();
+				return false;
+			}
+
+			int32* ValueId = DictionaryLookup[Metadata.Key].Find(Metadata.Value);
+			if (ValueId == nullptr)
+			{
+				const int32 NewId = Attributes[Metadata.Key].Dictionary.Add(Metadata.Value);
+				ValueId = &DictionaryLookup[Metadata.Key].Add(Metadata.Value, NewId);
+			}
+
+			OwnedValueIds[Metadata.Key][PointIndex] = *ValueId;
+		}
+	}
+
+	BindOwnedColumns();
+
+	return true;
+}
+
+bool FPointCloudColumnarStore::ToPreparedData(TArray<FTransform>& OutTransforms,
+	TArray<FString>& OutMetadataColumnNames,
+	TArray<int>& OutMetadataCountPerVertex,
+	TArray<TPair<int, FString>>& OutPreparedMetadata) const
+{
+	if (NumPoints == 0)
+	{
+		return false;
+	}
+
+	OutTransforms.SetNum(NumPoints);
+	OutMetadataCountPerVertex.SetNumZeroed(NumPoints);
+	OutMetadataColumnNames.Empty(Attributes.Num());
+	OutPreparedMetadata.Empty();
+
+	for (const FAttributeColumn& Attribute : Attributes)
+	{
+		OutMetadataColumnNames.Add(Attribute.Name);
+	}
+
+	for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+	{
+		OutTransforms[PointIndex] = GetTransform(PointIndex);
+
+		for (int32 AttributeIndex = 0; AttributeIndex < Attributes.Num(); ++AttributeIndex)
+		{
+			const int32 ValueId = ValueIds[AttributeIndex][PointIndex];
+
+			if (ValueId != NoValue)
+			{
+				OutPreparedMetadata.Emplace(AttributeIndex, Attributes[AttributeIndex].Dictionary[ValueId]);
+				OutMetadataCountPerVertex[PointIndex]++;
+			}
+		}
+	}
+
+	return true;
+}
+
+FTransform FPointCloudColumnarStore::GetTransform(int32 PointIndex) const
+{
+	const FVector4f& Orientation = Orientations[PointIndex];
+
+	return FTransform(FQuat(Orientation.X, Orientation.Y, Orientation.Z, Orientation.W), FVector(Positions[PointIndex]), FVector(Scales[PointIndex]));
+}
+
+bool FPointCloudColumnarStore::SaveToFile(const FString& FileName) const
+{
+	using namespace PointCloudColumnarStorePrivate;
+
+	FHeader Header;
+	Header.NumPoints = NumPoints;
+
+	for (const FAttributeColumn& Attribute : Attributes)
+	{
+		Header.AttributeNames.Add(Attribute.Name);
+		Header.Dictionaries.Add(Attribute.Dictionary);
+	}
+
+	Header.ValueIdOffsets.SetNumZeroed(Attributes.Num());
+
+	// The offsets are fixed size, so the header size can be measured before they are known
+	TArray<uint8> HeaderBytes;
+	{
+		FMemoryWriter Writer(HeaderBytes);
+		Header.Serialize(Writer);
+	}
+
+	uint64 Offset = Align(PreambleSize + HeaderBytes.Num());
+	Header.PositionsOffset = Offset;
+	Offset = Align(Offset + Positions.NumBytes());
+	Header.OrientationsOffset = Offset;
+	Offset = Align(Offset + Orientations.NumBytes());
+	Header.ScalesOffset = Offset;
+	Offset = Align(Offset + Scales.NumBytes());
+
+	for (int32 AttributeIndex = 0; AttributeIndex < Attributes.Num(); ++AttributeIndex)
+	{
+		Header.ValueIdOffsets[AttributeIndex] = Offset;
+		Offset = Align(Offset + ValueIds[AttributeIndex].NumBytes());
+	}
+
+	HeaderBytes.Reset();
+	{
+		FMemoryWriter Writer(HeaderBytes);
+		Header.Serialize(Writer);
+	}
+
+	TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*FileName));
+
+	if (!Ar)
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Columnar Store : Cannot open %s for writing"), *FileName);
+		return false;
+	}
+
+	uint32 Magic = FileMagic;
+	uint32 Version = LatestVersion;
+	uint64 HeaderSize = HeaderBytes.Num();
+
+	*Ar << Magic;
+	*Ar << Version;
+	*Ar << HeaderSize;
+	Ar->Serialize(HeaderBytes.GetData(), HeaderBytes.Num());
+
+	WritePadding(*Ar, Header.PositionsOffset);
+	Ar->Serialize((void*)Positions.GetData(), Positions.NumBytes());
+	WritePadding(*Ar, Header.OrientationsOffset);
+	Ar->Serialize((void*)Orientations.GetData(), Orientations.NumBytes());
+	WritePadding(*Ar, Header.ScalesOffset);
+	Ar->Serialize((void*)Scales.GetData(), Scales.NumBytes());
+
+	for (int32 AttributeIndex = 0; AttributeIndex < Attributes.Num(); ++AttributeIndex)
+	{
+		WritePadding(*Ar, Header.ValueIdOffsets[AttributeIndex]);
+		Ar->Serialize((void*)ValueIds[AttributeIndex].GetData(), ValueIds[AttributeIndex].NumBytes());
+	}
+
+	const bool bSuccess = !Ar->IsError() && Ar->Close();
+
+	if (!bSuccess)
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Columnar Store : Failed to write %s"), *FileName);
+	}
+
+	return bSuccess;
+}
+
+bool FPointCloudColumnarStore::LoadFromFile(const FString& FileName)
+{
+	Reset();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	MappedFile.Reset(PlatformFile.OpenMapped(*FileName));
+
+	if (MappedFile.IsValid())
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	}
+
+	const uint8* Image = nullptr;
+	int64 ImageSize = 0;
+
+	if (MappedRegion.IsValid())
+	{
+		Image = MappedRegion->GetMappedPtr();
+		ImageSize = MappedRegion->GetMappedSize();
+	}
+	else
+	{
+		// Fall back to reading the whole file, the columns then reference the loaded image
+		MappedFile.Reset();
+
+		if (!FFileHelper::LoadFileToArray(OwnedImage, *FileName))
+		{
+			UE_LOG(PointCloudLog, Warning, TEXT("Columnar Store : Cannot open %s"), *FileName);
+			return false;
+		}
+
+		Image = OwnedImage.GetData();
+		ImageSize = OwnedImage.Num();
+	}
+
+	if (!BindColumns(Image, ImageSize))
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Columnar Store : %s is not a valid columnar point cloud file"), *FileName);
+		Reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool FPointCloudColumnarStore::BindColumns(const uint8* Image, int64 ImageSize)
+{
+	using namespace PointCloudColumnarStorePrivate;
+
+	if (Image == nullptr || ImageSize < PreambleSize)
+	{
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = VERSION_INVALID;
+	uint64 HeaderSize = 0;
+
+	FMemoryReaderView Preamble(MakeArrayView(Image, PreambleSize));
+	Preamble << Magic;
+	Preamble << Version;
+	Preamble << HeaderSize;
+
+	if (Magic != FileMagic)
+	{
+		return false;
+	}
+
+	if (Version == VERSION_INVALID || Version > LatestVersion)
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Columnar Store : Unsupported version %u, latest supported version is %u"), Version, (uint32)LatestVersion);
+		return false;
+	}
+
+	// The header is read through an array view, which can only address MAX_int32 bytes
+	if (HeaderSize > (uint64)(ImageSize - PreambleSize) || HeaderSize > (uint64)MAX_int32)
+	{
+		return false;
+	}
+
+	FHeader Header;
+	FMemoryReaderView HeaderReader(MakeArrayView(Image + PreambleSize, static_cast<int32>(HeaderSize)));
+	Header.Serialize(HeaderReader);
+
+	if (HeaderReader.IsError()
+		|| Header.NumPoints < 0
+		|| Header.AttributeNames.Num() != Header.Dictionaries.Num()
+		|| Header.AttributeNames.Num() != Header.ValueIdOffsets.Num())
+	{
+		return false;
+	}
+
+	const uint64 Count = Header.NumPoints;
+
+	if (!IsColumnInImage(Header.PositionsOffset, Count * sizeof(FVector3f), ImageSize)
+		|| !IsColumnInImage(Header.OrientationsOffset, Count * sizeof(FVector4f), ImageSize)
+		|| !IsColumnInImage(Header.ScalesOffset, Count * sizeof(FVector3f), ImageSize))
+	{
+		return false;
+	}
+
+	for (uint64 ValueIdOffset : Header.ValueIdOffsets)
+	{
+		if (!IsColumnInImage(ValueIdOffset, Count * sizeof(int32), ImageSize))
+		{
+			return false;
+		}
+	}
+
+	NumPoints = Header.NumPoints;
+	Positions = MakeArrayView(reinterpret_cast<const FVector3f*>(Image + Header.PositionsOffset), NumPoints);
+	Orientations = MakeArrayView(reinterpret_cast<const FVector4f*>(Image + Header.OrientationsOffset), NumPoints);
+	Scales = MakeArrayView(reinterpret_cast<const FVector3f*>(Image + Header.ScalesOffset), NumPoints);
+
+	Attributes.SetNum(Header.AttributeNames.Num());
+	ValueIds.SetNum(Header.AttributeNames.Num());
+
+	for (int32 AttributeIndex = 0; AttributeIndex < Attributes.Num(); ++AttributeIndex)
+	{
+		Attributes[AttributeIndex].Name = MoveTemp(Header.AttributeNames[AttributeIndex]);
+		Attributes[AttributeIndex].Dictionary = MoveTemp(Header.Dictionaries[AttributeIndex]);
+		ValueIds[AttributeIndex] = MakeArrayView(reinterpret_cast<const int32*>(Image + Header.ValueIdOffsets[AttributeIndex]), NumPoints);
+
+		// Validate the ids up front so accessors can index the dictionary without checks
+		const int32 DictionarySize = Attributes[AttributeIndex].Dictionary.Num();
+		for (int32 ValueId : ValueIds[AttributeIndex])
+		{
+			if (ValueId != NoValue && (ValueId < 0 || ValueId >= DictionarySize))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void FPointCloudColumnarStore::BindOwnedColumns()
+{
+	Positions = OwnedPositions;
+	Orientations = OwnedOrientations;
+	Scales = OwnedScales;
+
+	ValueIds.SetNum(OwnedValueIds.Num());
+	for (int32 AttributeIndex = 0; AttributeIndex < OwnedValueIds.Num(); ++AttributeIndex)
+	{
+		ValueIds[AttributeIndex] = OwnedValueIds[AttributeIndex];
+	}
+}
@@ -3,6 +3,7 @@
 #include "PointCloudCsv.h"
 #include "PointCloud.h"
 #include "PointCloudUtils.h"
+#include "Hash/CityHash.h"
 #include "Runtime/Core/Public/Async/ParallelFor.h"
 #include "Misc/FileHelper.h"
 
@@ -114,6 +115,369 @@ FPointCloudCsv FPointCloudCsv::Open(const FString& Name, FFeedbackContext* Warn)
 	return FPointCloudCsv(InStrings,Warn);
 }
 
+namespace PointCloudCsvPrivate
+{
+	/** Size in bytes of the chunks the file is split into for parsing */
+	constexpr int64 ChunkSize = 1024 * 1024;
+
+	/** A token in the file buffer. Tokens reference the buffer directly and are only copied into strings once interned */
+	struct FToken
+	{
+		const ANSICHAR* Data = nullptr;
+		int32 Length = 0;
+
+		bool operator==(const FToken& Other) const
+		{
+			return Length == Other.Length && FMemory::Memcmp(Data, Other.Data, Length) == 0;
+		}
+
+		friend uint32 GetTypeHash(const FToken& Token)
+		{
+			return CityHash32(Token.Data, Token.Length);
+		}
+
+		FString ToString() const
+		{
+			return FString(Length, Data);
+		}
+	};
+
+	/** The output of parsing a single chunk */
+	struct FChunk
+	{
+		int64 Begin = 0;
+		int64 End = 0;
+		int32 RowCount = 0;
+		int32 MalformedCount = 0;
+
+		// One entry per numeric column
+		TArray<TArray<float>> Numbers;
+
+		// One entry per interned column, the ids are local to the chunk
+		TArray<TArray<int32>> ValueIds;
+		TArray<TArray<FToken>> Values;
+	};
+
+	float ParseFloat(const FToken& Token)
+	{
+		// Atof needs a terminated string, numbers longer than this are not meaningful as floats anyway
+		ANSICHAR Buffer[64];
+		const int32 Length = FMath::Min(Token.Length, (int32)UE_ARRAY_COUNT(Buffer) - 1);
+		FMemory::Memcpy(Buffer, Token.Data, Length);
+		Buffer[Length] = '\0';
+		return FCStringAnsi::Atof(Buffer);
+	}
+
+	/** Return the offset of the first byte after the next line break at or after Offset, or End */
+	int64 SkipLine(const uint8* Data, int64 Offset, int64 End)
+	{
+		while (Offset < End && Data[Offset] != '\n')
+		{
+			++Offset;
+		}
+
+		return FMath::Min(Offset + 1, End);
+	}
+
+	/** Split a line into tokens, returns the number of tokens found */
+	int32 Tokenize(const ANSICHAR* Line, int32 Length, TArray<FToken>& OutTokens)
+	{
+		OutTokens.Reset();
+
+		int32 TokenStart = 0;
+		for (int32 i = 0; i <= Length; ++i)
+		{
+			if (i == Length || Line[i] == ',')
+			{
+				OutTokens.Add({ Line + TokenStart, i - TokenStart });
+				TokenStart = i + 1;
+			}
+		}
+
+		return OutTokens.Num();
+	}
+
+	/** Parse the complete lines in [Chunk.Begin, Chunk.End) */
+	void ParseChunk(const uint8* Data, const TArray<int32>& NumericSlot, const TArray<int32>& InternedSlot, FChunk& Chunk)
+	{
+		const int32 ColumnCount = NumericSlot.Num();
+		const int32 ExpectedRows = (int32)((Chunk.End - Chunk.Begin) / 64);
+
+		for (TArray<float>& Column : Chunk.Numbers)
+		{
+			Column.Reserve(ExpectedRows);
+		}
+
+		for (TArray<int32>& Column : Chunk.ValueIds)
+		{
+			Column.Reserve(ExpectedRows);
+		}
+
+		TArray<TMap<FToken, int32>> LocalDictionaries;
+		LocalDictionaries.SetNum(Chunk.Values.Num());
+
+		TArray<FToken> Tokens;
+		Tokens.Reserve(ColumnCount);
+
+		int64 Offset = Chunk.Begin;
+		while (Offset < Chunk.End)
+		{
+			const int64 LineEnd = SkipLine(Data, Offset, Chunk.End);
+			int32 Length = (int32)(LineEnd - Offset);
+
+			// Trim the line break
+			while (Length > 0 && (Data[Offset + Length - 1] == '\n' || Data[Offset + Length - 1] == '\r'))
+			{
+				--Length;
+			}
+
+			const ANSICHAR* Line = reinterpret_cast<const ANSICHAR*>(Data + Offset);
+			Offset = LineEnd;
+
+			if (Length == 0)
+			{
+				continue;
+			}
+
+			if (Tokenize(Line, Length, Tokens) != ColumnCount)
+			{
+				++Chunk.MalformedCount;
+				continue;
+			}
+
+			for (int32 c = 0; c < ColumnCount; ++c)
+			{
+				if (NumericSlot[c] != INDEX_NONE)
+				{
+					Chunk.Numbers[NumericSlot[c]].Add(ParseFloat(Tokens[c]));
+				}
+				else
+				{
+					const int32 Slot = InternedSlot[c];
+					int32* Id = LocalDictionaries[Slot].Find(Tokens[c]);
+
+					if (Id == nullptr)
+					{
+						Id = &LocalDictionaries[Slot].Add(Tokens[c], Chunk.Values[Slot].Add(Tokens[c]));
+					}
+
+					Chunk.ValueIds[Slot].Add(*Id);
+				}
+			}
+
+			++Chunk.RowCount;
+		}
+	}
+}
+
+FPointCloudCsv FPointCloudCsv::OpenStreaming(const FString& Name, const TSet<FString>& InNumericColumns, FFeedbackContext* Warn)
+{
+	TArray64<uint8> Buffer;
+
+	PointCloud::UtilityTimer Timer;
+
+	if (!FFileHelper::LoadFileToArray(Buffer, *Name))
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Cannot open file CSV: %s\n"), *Name);
+		return FPointCloudCsv();
+	}
+
+	Timer.Report(TEXT("Load PSV From Disk"));
+
+	return ParseStreaming(Buffer, InNumericColumns, Warn);
+}
+
+FPointCloudCsv FPointCloudCsv::ParseStreaming(TArrayView64<const uint8> Buffer, const TSet<FString>& InNumericColumns, FFeedbackContext* Warn)
+{
+	using namespace PointCloudCsvPrivate;
+
+	PointCloud::UtilityTimer Timer;
+
+	FPointCloudCsv Result;
+
+	const uint8* Data = Buffer.GetData();
+	const int64 Size = Buffer.Num();
+
+	// Skip the UTF-8 byte order mark if there is one
+	int64 Begin = 0;
+	if (Size >= 3 && Data[0] == 0xEF && Data[1] == 0xBB && Data[2] == 0xBF)
+	{
+		Begin = 3;
+	}
+
+	// read in the column names
+	const int64 HeaderEnd = SkipLine(Data, Begin, Size);
+	FString HeaderLine((int32)(HeaderEnd - Begin), reinterpret_cast<const ANSICHAR*>(Data + Begin));
+	HeaderLine.TrimEndInline();
+
+	if (HeaderLine.ParseIntoArray(Result.ColumnNames, TEXT(","), true) == 0)
+	{
+		// if we don't have at least one column name then consider this file invalid
+		UE_LOG(PointCloudLog, Warning, TEXT("Malformed CSV. Cannot Read Column Names From Line 0\n"));
+		return Result;
+	}
+
+	const int32 ColumnCount = Result.GetColumnCount();
+
+	// Assign each column a slot in either the numeric or the interned column lists
+	TArray<int32> NumericSlot;
+	TArray<int32> InternedSlot;
+	TArray<int32> NumericColumnIndex;
+	TArray<int32> InternedColumnIndex;
+	NumericSlot.Init(INDEX_NONE, ColumnCount);
+	InternedSlot.Init(INDEX_NONE, ColumnCount);
+
+	for (int32 c = 0; c < ColumnCount; ++c)
+	{
+		if (InNumericColumns.Contains(Result.ColumnNames[c]))
+		{
+			NumericSlot[c] = NumericColumnIndex.Add(c);
+		}
+		else
+		{
+			InternedSlot[c] = InternedColumnIndex.Add(c);
+		}
+	}
+
+	// Split the data into chunks that each start at the beginning of a line
+	TArray<FChunk> Chunks;
+	for (int64 ChunkBegin = HeaderEnd; ChunkBegin < Size;)
+	{
+		const int64 ChunkEnd = ChunkBegin + ChunkSize < Size ? SkipLine(Data, ChunkBegin + ChunkSize, Size) : Size;
+
+		FChunk& Chunk = Chunks.AddDefaulted_GetRef();
+		Chunk.Begin = ChunkBegin;
+		Chunk.End = ChunkEnd;
+		Chunk.Numbers.SetNum(NumericColumnIndex.Num());
+		Chunk.ValueIds.SetNum(InternedColumnIndex.Num());
+		Chunk.Values.SetNum(InternedColumnIndex.Num());
+
+		ChunkBegin = ChunkEnd;
+	}
+
+	ParallelFor(Chunks.Num(), [&](int32 ChunkIndex)
+	{
+		ParseChunk(Data, NumericSlot, InternedSlot, Chunks[ChunkIndex]);
+	});
+
+	Timer.Report(TEXT("Tokenize PSV"));
+
+	// Work out where each chunk's rows go in the final columns
+	TArray<int32> RowOffsets;
+	RowOffsets.SetNum(Chunks.Num());
+
+	int32 MalformedCount = 0;
+	for (int32 ChunkIndex = 0; ChunkIndex < Chunks.Num(); ++ChunkIndex)
+	{
+		RowOffsets[ChunkIndex] = Result.RowCount;
+		Result.RowCount += Chunks[ChunkIndex].RowCount;
+		MalformedCount += Chunks[ChunkIndex].MalformedCount;
+	}
+
+	if (MalformedCount > 0)
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Malformed CSV, skipped %d Lines\n"), MalformedCount);
+	}
+
+	// if we don't have at least one data line, consider this file invalid
+	if (Result.RowCount == 0)
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Malformed CSV. Less than 2 Lines\n"));
+		return Result;
+	}
+
+	// Allocate the final columns up front, each column is then merged independently in parallel
+	for (int32 c = 0; c < ColumnCount; ++c)
+	{
+		if (NumericSlot[c] != INDEX_NONE)
+		{
+			Result.NumericColumns.Add(Result.ColumnNames[c]).SetNumUninitialized(Result.RowCount);
+		}
+		else
+		{
+			Result.InternedColumns.Add(Result.ColumnNames[c]).ValueIds.SetNumUninitialized(Result.RowCount);
+		}
+	}
+
+	ParallelFor(ColumnCount, [&](int32 c)
+	{
+		if (NumericSlot[c] != INDEX_NONE)
+		{
+			TArray<float>& Column = Result.NumericColumns[Result.ColumnNames[c]];
+
+			for (int32 ChunkIndex = 0; ChunkIndex < Chunks.Num(); ++ChunkIndex)
+			{
+				const TArray<float>& ChunkColumn = Chunks[ChunkIndex].Numbers[NumericSlot[c]];
+				FMemory::Memcpy(Column.GetData() + RowOffsets[ChunkIndex], ChunkColumn.GetData(), ChunkColumn.NumBytes());
+			}
+		}
+		else
+		{
+			FInternedColumn& Column = Result.InternedColumns[Result.ColumnNames[c]];
+			TMap<FToken, int32> Dictionary;
+			TArray<int32> LocalToGlobal;
+
+			for (int32 ChunkIndex = 0; ChunkIndex < Chunks.Num(); ++ChunkIndex)
+			{
+				const FChunk& Chunk = Chunks[ChunkIndex];
+				const TArray<FToken>& ChunkValues = Chunk.Values[InternedSlot[c]];
+				const TArray<int32>& ChunkIds = Chunk.ValueIds[InternedSlot[c]];
+
+				LocalToGlobal.SetNumUninitialized(ChunkValues.Num());
+				for (int32 LocalId = 0; LocalId < ChunkValues.Num(); ++LocalId)
+				{
+					int32* GlobalId = Dictionary.Find(ChunkValues[LocalId]);
+
+					if (GlobalId == nullptr)
+					{
+						GlobalId = &Dictionary.Add(ChunkValues[LocalId], Column.Values.Add(ChunkValues[LocalId].ToString()));
+					}
+
+					LocalToGlobal[LocalId] = *GlobalId;
+				}
+
+				int32* Out = Column.ValueIds.GetData() + RowOffsets[ChunkIndex];
+				for (int32 Row = 0; Row < ChunkIds.Num(); ++Row)
+				{
+					Out[Row] = LocalToGlobal[ChunkIds[Row]];
+				}
+			}
+		}
+	});
+
+	Result.IsOpen = true;
+
+	UE_LOG(PointCloudLog, Log, TEXT("Row Count %d\n"), Result.RowCount);
+
+	Timer.Report(TEXT("Process PSV"));
+
+	return Result;
+}
+
+const TArray<float>* FPointCloudCsv::GetNumericColumn(const FString& Name) const
+{
+	return NumericColumns.Find(Name);
+}
+
+TArray<float>* FPointCloudCsv::GetNumericColumn(const FString& Name)
+{
+	return NumericColumns.Find(Name);
+}
+
+bool FPointCloudCsv::GetInternedColumn(const FString& Name, const TArray<int32>*& OutValueIds, const TArray<FString>*& OutValues) const
+{
+	const FInternedColumn* Column = InternedColumns.Find(Name);
+
+	if (Column == nullptr)
+	{
+		return false;
+	}
+
+	OutValueIds = &Column->ValueIds;
+	OutValues = &Column->Values;
+	return true;
+}
+
 bool FPointCloudCsv::GetIsOpen()
 {
 	return IsOpen;
@@ -131,6 +495,30 @@ TArray<FString> * FPointCloudCsv::GetColumn(const FString &Name)
 		UE_LOG(PointCloudLog, Warning, TEXT("Requested column (%s) Not Found"), *Name);
 		return nullptr;
 	}
+
+	// Documents opened with OpenStreaming hold typed columns, convert them to strings the first time they are requested
+	if (!Columns.Contains(Name))
+	{
+		if (const TArray<float>* Numbers = NumericColumns.Find(Name))
+		{
+			TArray<FString>& Column = Columns.Add(Name);
+			Column.SetNum(Numbers->Num());
+			ParallelFor(Numbers->Num(), [&](int32 i)
+			{
+				Column[i] = FString::SanitizeFloat((*Numbers)[i]);
+			});
+		}
+		else if (const FInternedColumn* Interned = InternedColumns.Find(Name))
+		{
+			TArray<FString>& Column = Columns.Add(Name);
+			Column.SetNum(Interned->ValueIds.Num());
+			ParallelFor(Interned->ValueIds.Num(), [&](int32 i)
+			{
+				Column[i] = Interned->Values[Interned->ValueIds[i]];
+			});
+		}
+	}
+
 	return Columns.Find(Name);
 }
 
@@ -0,0 +1,9 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PointCloudCustomVersion.h"
+#include "Serialization/CustomVersion.h"
+
+const FGuid FPointCloudCustomVersion::GUID(0x6E3B8A41, 0x2C7F4D95, 0xA1D05B37, 0x94F2C6E8);
+
+// Register the custom version with core
+FCustomVersionRegistration GRegisterPointCloudCustomVersion(FPointCloudCustomVersion::GUID, FPointCloudCustomVersion::LatestVersion, TEXT("PointCloudVer"));
@@ -0,0 +1,271 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PointCloudDatabaseStream.h"
+
+#include "Async/ParallelFor.h"
+#include "Misc/Compression.h"
+#include "PointCloudConfig.h"
+
+#include <atomic>
+
+namespace PointCloudDatabaseStreamPrivate
+{
+	int32 GetChunkSize(const FPointCloudDatabaseStream::FHeader& Header, int32 ChunkIndex)
+	{
+		return (int32)FMath::Min<int64>(Header.ChunkSize, Header.Size - (int64)ChunkIndex * Header.ChunkSize);
+	}
+
+	int32 GetCompressedBound(const FPointCloudDatabaseStream::FHeader& Header)
+	{
+		return Header.CompressionFormat.IsNone() ? 0 : FCompression::CompressMemoryBound(Header.CompressionFormat, Header.ChunkSize);
+	}
+
+	bool IsChunkLayoutValid(int64 Size, int32 ChunkSize)
+	{
+		return Size >= 0
+			&& ChunkSize > 0
+			&& ChunkSize <= FPointCloudDatabaseStream::MaxChunkSize
+			&& FMath::DivideAndRoundUp<int64>(Size, ChunkSize) <= FPointCloudDatabaseStream::MaxNumChunks;
+	}
+
+	// The smallest number of bytes the chunks of a stream can take in the archive: every chunk has its size and at least one byte of data,
+	// and chunks that are stored as they are take their full size
+	int64 GetMinStreamBytes(const FPointCloudDatabaseStream::FHeader& Header)
+	{
+		const int64 NumChunks = Header.GetNumChunks();
+		return NumChunks * (int64)sizeof(int32) + (Header.CompressionFormat.IsNone() ? Header.Size : NumChunks);
+	}
+}
+
+int32 FPointCloudDatabaseStream::FHeader::GetNumChunks() const
+{
+	return ChunkSize > 0 ? (int32)FMath::DivideAndRoundUp<int64>(Size, ChunkSize) : 0;
+}
+
+int64 FPointCloudDatabaseStream::GetScratchBudget(const FSettings& Settings)
+{
+	FHeader Header;
+	Header.ChunkSize = Settings.ChunkSize;
+	Header.CompressionFormat = Settings.CompressionFormat;
+
+	return (int64)FMath::Max(Settings.MaxChunksInFlight, 1) * PointCloudDatabaseStreamPrivate::GetCompressedBound(Header);
+}
+
+bool FPointCloudDatabaseStream::Save(FArchive& Ar, const uint8* Data, int64 Size, const FSettings& Settings, FStreamStats* OutStats)
+{
+	using namespace PointCloudDatabaseStreamPrivate;
+
+	check(Ar.IsSaving());
+
+	if (!IsChunkLayoutValid(Size, Settings.ChunkSize) || (Data == nullptr && Size > 0))
+	{
+		return false;
+	}
+
+	FHeader Header;
+	Header.Size = Size;
+	Header.ChunkSize = Settings.ChunkSize;
+	Header.CompressionFormat = Settings.CompressionFormat;
+
+	Ar << Header.Size;
+	Ar << Header.ChunkSize;
+	Ar << Header.CompressionFormat;
+
+	const int32 NumChunks = Header.GetNumChunks();
+	const int32 BatchSize = FMath::Max(Settings.MaxChunksInFlight, 1);
+	const int32 CompressedBound = GetCompressedBound(Header);
+
+	// Scratch buffers are reused from one batch to the next, chunks that don't compress are written straight from the image
+	TArray<TArray<uint8>> Scratch;
+	TArray<int32> CompressedSizes;
+	Scratch.SetNum(FMath::Min(BatchSize, NumChunks));
+	CompressedSizes.SetNum(Scratch.Num());
+
+	if (CompressedBound > 0)
+	{
+		for (TArray<uint8>& Buffer : Scratch)
+		{
+			Buffer.Reserve(CompressedBound);
+		}
+	}
+
+	FStreamStats Stats;
+	Stats.NumChunks = NumChunks;
+
+	for (int32 FirstChunk = 0; FirstChunk < NumChunks; FirstChunk += BatchSize)
+	{
+		const int32 NumInBatch = FMath::Min(BatchSize, NumChunks - FirstChunk);
+
+		ParallelFor(NumInBatch, [&](int32 BatchIndex)
+			{
+				const int32 ChunkIndex = FirstChunk + BatchIndex;
+				const int32 ChunkSize = GetChunkSize(Header, ChunkIndex);
+
+				// A compressed size equal to the chunk size means the chunk is stored as it is
+				CompressedSizes[BatchIndex] = ChunkSize;
+
+				if (CompressedBound > 0)
+				{
+					TArray<uint8>& Buffer = Scratch[BatchIndex];
+					Buffer.SetNumUninitialized(CompressedBound, EAllowShrinking::No);
+
+					int32 CompressedSize = CompressedBound;
+					if (FCompression::CompressMemory(Header.CompressionFormat, Buffer.GetData(), CompressedSize, Data + (int64)ChunkIndex * Header.ChunkSize, ChunkSize)
+						&& CompressedSize < ChunkSize)
+					{
+						CompressedSizes[BatchIndex] = CompressedSize;
+					}
+				}
+			}, Settings.bParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+		for (int32 BatchIndex = 0; BatchIndex < NumInBatch; ++BatchIndex)
+		{
+			const int32 ChunkIndex = FirstChunk + BatchIndex;
+			const int32 ChunkSize = GetChunkSize(Header, ChunkIndex);
+
+			Ar << CompressedSizes[BatchIndex];
+
+			if (CompressedSizes[BatchIndex] == ChunkSize)
+			{
+				Ar.Serialize(const_cast<uint8*>(Data + (int64)ChunkIndex * Header.ChunkSize), ChunkSize);
+			}
+			else
+			{
+				Ar.Serialize(Scratch[BatchIndex].GetData(), CompressedSizes[BatchIndex]);
+			}
+
+			Stats.CompressedBytes += CompressedSizes[BatchIndex];
+		}
+
+		int64 ScratchBytes = 0;
+		for (const TArray<uint8>& Buffer : Scratch)
+		{
+			ScratchBytes += Buffer.Num();
+		}
+		Stats.PeakScratchBytes = FMath::Max(Stats.PeakScratchBytes, ScratchBytes);
+	}
+
+	if (OutStats)
+	{
+		*OutStats = Stats;
+	}
+
+	return !Ar.IsError();
+}
+
+bool FPointCloudDatabaseStream::LoadHeader(FArchive& Ar, FHeader& OutHeader)
+{
+	using namespace PointCloudDatabaseStreamPrivate;
+
+	check(Ar.IsLoading());
+
+	Ar << OutHeader.Size;
+	Ar << OutHeader.ChunkSize;
+	Ar << OutHeader.CompressionFormat;
+
+	// Archives that can't tell their size report a negative one, the chunks are still checked one by one as they are read
+	const int64 RemainingBytes = Ar.TotalSize() >= 0 ? Ar.TotalSize() - Ar.Tell() : MAX_int64;
+
+	if (Ar.IsError() || !IsChunkLayoutValid(OutHeader.Size, OutHeader.ChunkSize) || GetMinStreamBytes(OutHeader) > RemainingBytes)
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Invalid Point Cloud Database Stream Header"));
+		Ar.SetError();
+		return false;
+	}
+
+	return true;
+}
+
+bool FPointCloudDatabaseStream::LoadChunks(FArchive& Ar, const FHeader& Header, uint8* OutData, int32 MaxChunksInFlight, FStreamStats* OutStats)
+{
+	using namespace PointCloudDatabaseStreamPrivate;
+
+	check(Ar.IsLoading());
+
+	const int32 NumChunks = Header.GetNumChunks();
+	const int32 BatchSize = FMath::Max(MaxChunksInFlight, 1);
+
+	TArray<TArray<uint8>> Scratch;
+	TArray<int32> CompressedSizes;
+	Scratch.SetNum(FMath::Min(BatchSize, NumChunks));
+	CompressedSizes.SetNum(Scratch.Num());
+
+	FStreamStats Stats;
+	Stats.NumChunks = NumChunks;
+
+	for (int32 FirstChunk = 0; FirstChunk < NumChunks; FirstChunk += BatchSize)
+	{
+		const int32 NumInBatch = FMath::Min(BatchSize, NumChunks - FirstChunk);
+
+		// Chunks stored as they are go straight into the image, compressed chunks are gathered for the batch
+		for (int32 BatchIndex = 0; BatchIndex < NumInBatch; ++BatchIndex)
+		{
+			const int32 ChunkIndex = FirstChunk + BatchIndex;
+			const int32 ChunkSize = GetChunkSize(Header, ChunkIndex);
+
+			int32& CompressedSize = CompressedSizes[BatchIndex];
+			Ar << CompressedSize;
+
+			if (Ar.IsError() || CompressedSize <= 0 || CompressedSize > ChunkSize || (CompressedSize < ChunkSize && Header.CompressionFormat.IsNone()))
+			{
+				UE_LOG(PointCloudLog, Warning, TEXT("Invalid Point Cloud Database Stream Chunk %d"), ChunkIndex);
+				Ar.SetError();
+				return false;
+			}
+
+			if (CompressedSize == ChunkSize)
+			{
+				Ar.Serialize(OutData + (int64)ChunkIndex * Header.ChunkSize, ChunkSize);
+			}
+			else
+			{
+				// Compressed chunks are never larger than a chunk, reserving that up front keeps the buffer from growing past it
+				Scratch[BatchIndex].Reserve(Header.ChunkSize);
+				Scratch[BatchIndex].SetNumUninitialized(CompressedSize, EAllowShrinking::No);
+				Ar.Serialize(Scratch[BatchIndex].GetData(), CompressedSize);
+			}
+
+			Stats.CompressedBytes += CompressedSize;
+		}
+
+		if (Ar.IsError())
+		{
+			return false;
+		}
+
+		std::atomic<bool> bFailed(false);
+
+		ParallelFor(NumInBatch, [&](int32 BatchIndex)
+			{
+				const int32 ChunkIndex = FirstChunk + BatchIndex;
+				const int32 ChunkSize = GetChunkSize(Header, ChunkIndex);
+
+				if (CompressedSizes[BatchIndex] < ChunkSize
+					&& !FCompression::UncompressMemory(Header.CompressionFormat, OutData + (int64)ChunkIndex * Header.ChunkSize, ChunkSize, Scratch[BatchIndex].GetData(), CompressedSizes[BatchIndex]))
+				{
+					bFailed = true;
+				}
+			});
+
+		if (bFailed)
+		{
+			UE_LOG(PointCloudLog, Warning, TEXT("Failed To Decompress Point Cloud Database Stream"));
+			Ar.SetError();
+			return false;
+		}
+
+		int64 ScratchBytes = 0;
+		for (const TArray<uint8>& Buffer : Scratch)
+		{
+			ScratchBytes += Buffer.Num();
+		}
+		Stats.PeakScratchBytes = FMath::Max(Stats.PeakScratchBytes, ScratchBytes);
+	}
+
+	if (OutStats)
+	{
+		*OutStats = Stats;
+	}
+
+	return true;
+}
@@ -3,14 +3,20 @@
 #include "PointCloudImpl.h"
 
 #include "Algo/AnyOf.h"
+#include "Async/TaskGraphInterfaces.h"
 #include "HAL/PlatformFileManager.h"
 #include "IncludeSQLite.h"
 #include "Misc/FeedbackContext.h"
 #include "Misc/Paths.h"
 #include "PointCloudAlembicHelpers.h"
+#include "PointCloudColumnarStore.h"
 #include "PointCloudCsv.h"
+#include "PointCloudCustomVersion.h"
+#include "PointCloudDatabaseStream.h"
 #include "PointCloudQuery.h"
 #include "PointCloudSchema.h"
+#include "PointCloudSpatialIndex.h"
+#include "PointCloudAttributeIndex.h"
 #include "PointCloudSQLExtensions.h"
 #include "PointCloudTransactionHolder.h"
 #include "PointCloudUtils.h"
@@ -29,10 +35,10 @@ DEFINE_LOG_CATEGORY(PointCloudLog)
 #define LOCTEXT_NAMESPACE "PointCloudImpl"
 
 // Convenience macros
-#define RUN_QUERY(Query) RunQuery(Query, __FILE__, __LINE__)
-#define RUN_QUERY_P(PointCloud, Query) PointCloud->RunQuery(Query, __FILE__, __LINE__)
-#define LOG_QUERY(Query) PointCloud::QueryLogger Logger(this, Query, FString(), __FILE__, __LINE__)
-#define LOG_QUERY_LABEL(Query, Label) PointCloud::QueryLogger Logger(this, Query, Label, __FILE__, __LINE__)
+#define RUN_QUERY(Query) RunQuery(Query, __FILE__, __LINE__, POINTCLOUD_QUERY_STAT_ID(FString()))
+#define RUN_QUERY_P(PointCloud, Query) PointCloud->RunQuery(Query, __FILE__, __LINE__, POINTCLOUD_QUERY_STAT_ID(FString()))
+#define LOG_QUERY(Query) PointCloud::QueryLogger Logger(this, Query, FString(), __FILE__, __LINE__, POINTCLOUD_QUERY_STAT_ID(FString()))
+#define LOG_QUERY_LABEL(Query, Label) PointCloud::QueryLogger Logger(this, Query, Label, __FILE__, __LINE__, POINTCLOUD_QUERY_STAT_ID(Label))
 
 namespace
 {
@@ -49,15 +55,15 @@ namespace PointCloudPrivateNamespace
 {
 #if WITH_EDITOR
 
-	// This method will move data out of the incoming FPointCloudCsv and into the outgoing array. The 
-	// columns in the doc can potentially be very large and saving a copy here is useful.
-	// It should be assumed that once this called, the doc no longer contains data in the given column
+	// This method will move data out of the incoming FPointCloudCsv and into the outgoing array. The columns in the doc can potentially be very large
+	// and saving a copy here is useful. It should be assumed that once this called, the doc no longer contains data in the given column.
+	// Returns false if the doc doesn't hold the given column as a numeric column
 	bool TryTakeColumn(FPointCloudCsv& doc,
 		const FString& InColumnName,
 		const FString& OutColumName,
-		TMap<FString, TArray<FString> >& OutValues)
+		TMap<FString, TArray<float> >& OutValues)
 	{
-		TArray<FString>* Column = doc.GetColumn(InColumnName);
+		TArray<float>* Column = doc.GetNumericColumn(InColumnName);
 		if (Column != nullptr)
 		{
 			OutValues.Add(OutColumName, MoveTemp(*Column));
@@ -77,6 +83,45 @@ namespace PointCloudPrivateNamespace
 		return FString::Printf(TEXT("%u"), Hash);
 	}
 
+	// The number of vertices hashed together in the whole database hash. Loads only read back the blocks they added rows to
+	const int64 VerticesPerHashBlock = 4096;
+
+	// Add the columns of the current row of a statement to a hash, with their type so that different rows can't produce the same stream
+	void HashRowColumns(FSHA1& Hash, sqlite3_stmt* Statement)
+	{
+		for (int32 Column = 0; Column < sqlite3_column_count(Statement); ++Column)
+		{
+			const uint8 Type = (uint8)sqlite3_column_type(Statement, Column);
+			Hash.Update(&Type, sizeof(Type));
+
+			if (Type == SQLITE_INTEGER)
+			{
+				const int64 Value = sqlite3_column_int64(Statement, Column);
+				Hash.Update(reinterpret_cast<const uint8*>(&Value), sizeof(Value));
+			}
+			else if (Type == SQLITE_FLOAT)
+			{
+				const double Value = sqlite3_column_double(Statement, Column);
+				Hash.Update(reinterpret_cast<const uint8*>(&Value), sizeof(Value));
+			}
+			else if (Type != SQLITE_NULL)
+			{
+				const int32 NumBytes = sqlite3_column_bytes(Statement, Column);
+				Hash.Update(reinterpret_cast<const uint8*>(&NumBytes), sizeof(NumBytes));
+				Hash.Update(static_cast<const uint8*>(sqlite3_column_blob(Statement, Column)), NumBytes);
+			}
+		}
+	}
+
+	// Return the key a temporary table was added to the cache with, temporary tables are all named Temp_<Key>_Table
+	FString GetTemporaryTableKey(const FString& InTableName)
+	{
+		FString Key = InTableName;
+		Key.RemoveFromStart(TEXT("Temp_"));
+		Key.RemoveFromEnd(TEXT("_Table"));
+		return Key;
+	}
+
 	// Drop any indexs on the point cloud, this should be done before bulk inserts
 	void DropIndexes(UPointCloudImpl* PointCloud)
 	{
@@ -97,8 +142,8 @@ namespace PointCloudPrivateNamespace
 		PointCloud->ClearTemporaryTables();
 	}
 
-	// create any required indexes
-	void CreateIndexes(UPointCloudImpl* PointCloud, FFeedbackContext* Warn = nullptr)
+	// create any required indexes. Callers that have already filled the spatial index can skip rebuilding it from the Vertex table
+	void CreateIndexes(UPointCloudImpl* PointCloud, FFeedbackContext* Warn = nullptr, bool bPopulateSpatialIndex = true)
 	{
 		PointCloud::UtilityTimer Timer;
 		if (PointCloud == nullptr)
@@ -106,13 +151,16 @@ namespace PointCloudPrivateNamespace
 			return;
 		}
 
-		RUN_QUERY_P(PointCloud, "CREATE VIRTUAL TABLE if not exists SpatialQuery USING rtree(id, Minx , Maxx , Miny , Maxy , Minz, Maxz);");
-		UpdateProgress(Warn, 80, 100);
+		if (bPopulateSpatialIndex)
+		{
+			RUN_QUERY_P(PointCloud, "CREATE VIRTUAL TABLE if not exists SpatialQuery USING rtree(id, Minx , Maxx , Miny , Maxy , Minz, Maxz);");
+			UpdateProgress(Warn, 80, 100);
 
-		RUN_QUERY_P(PointCloud, "INSERT INTO SpatialQuery SELECT rowid, x, x, y, y, z, z from Vertex");
-		UpdateProgress(Warn, 85, 100);
+			RUN_QUERY_P(PointCloud, "INSERT INTO SpatialQuery SELECT rowid, x, x, y, y, z, z from Vertex");
+			UpdateProgress(Warn, 85, 100);
 
-		Timer.Report("Build Spatial Index");
+			Timer.Report("Build Spatial Index");
+		}
 
 		RUN_QUERY_P(PointCloud, "CREATE INDEX VertexKeytoValue 	ON VertexToAttribute(key_id, value_id)");
 		UpdateProgress(Warn, 90, 100);
@@ -127,6 +175,340 @@ namespace PointCloudPrivateNamespace
 	}
 }
 
+namespace PointCloudPrivateNamespace
+{
+	// Bulk loads are split into partitions of at least this many points, smaller loads are prepared as a single partition
+	static constexpr int32 MinPointsPerLoadPartition = 16384;
+
+	// Records the time spent in a phase of a bulk load to the given stats object, if there is one, when it goes out of scope
+	class FLoadPhaseTimer
+	{
+	public:
+		FLoadPhaseTimer(const FPointCloudStatsPtr& InStats, const TCHAR* InPhaseName)
+			: Stats(InStats)
+			, PhaseName(InPhaseName)
+			, StartTime(FPlatformTime::Seconds())
+		{
+		}
+
+		~FLoadPhaseTimer()
+		{
+			if (Stats.IsValid())
+			{
+				Stats->AddTimingToEvent(FString::Printf(TEXT("PointCloud Load %s"), PhaseName), FTimespan::FromSeconds(FPlatformTime::Seconds() - StartTime));
+			}
+		}
+
+	private:
+		FPointCloudStatsPtr Stats;
+		const TCHAR* PhaseName;
+		double StartTime;
+	};
+
+	// The rows generated for a contiguous range of the incoming points. Vertex ids in the partition are local, and are offset by FirstRowId when the partition is merged into the database
+	struct FLoadPartition
+	{
+		// Number of values written to the Vertex table for each point: x, y, z, nx, ny, nz, nw, sx, sy, sz
+		static constexpr int32 VertexRowSize = 10;
+
+		// Range of incoming points [Begin, End) and the range of incoming metadata that belongs to them
+		int32 Begin = 0;
+		int32 End = 0;
+		int32 MetadataBegin = 0;
+		int32 MetadataCount = 0;
+
+		// Number of points that passed the import bounds test, and the row id the first of them will be given
+		int32 NumVertices = 0;
+		int64 FirstRowId = 0;
+
+		// VertexRowSize values per point
+		TArray<float> VertexRows;
+
+		// Triples of (local vertex, key id, value id)
+		TArray<int32> AttributeRows;
+
+		// Bounds of the points in this partition
+		FBox Bounds = FBox(EForceInit::ForceInit);
+
+		// Morton code and local vertex index of each point, sorted by code
+		TArray<TPair<uint64, int32>> SpatialOrder;
+	};
+
+	// Split Count incoming points into contiguous partitions, each of which is prepared independently and then merged in order
+	TArray<FLoadPartition> MakeLoadPartitions(int32 Count)
+	{
+		const int32 NumPartitions = FMath::Clamp(Count / MinPointsPerLoadPartition, 1, FMath::Max(1, FTaskGraphInterface::Get().GetNumWorkerThreads()) * 4);
+		const int32 PointsPerPartition = FMath::DivideAndRoundUp(Count, NumPartitions);
+
+		TArray<FLoadPartition> Partitions;
+		Partitions.SetNum(NumPartitions);
+		for (int32 PartitionIndex = 0; PartitionIndex < NumPartitions; ++PartitionIndex)
+		{
+			Partitions[PartitionIndex].Begin = FMath::Min(PartitionIndex * PointsPerPartition, Count);
+			Partitions[PartitionIndex].End = FMath::Min(Partitions[PartitionIndex].Begin + PointsPerPartition, Count);
+		}
+
+		return Partitions;
+	}
+
+	// Append the Vertex row of incoming point Index to the partition
+	void AppendLoadPartitionVertex(FLoadPartition& Partition, int32 Index, const float (&VertexValues)[FLoadPartition::VertexRowSize])
+	{
+#define CHECK_VALUE(Value, Message) if(FMath::IsFinite(VertexValues[Value])==false) UE_LOG(PointCloudLog, Warning, TEXT("Found Nan or Infinite on Vertex %d Value %hs"), Index, Message);
+
+		CHECK_VALUE(0, "Translation.x");
+		CHECK_VALUE(1, "Translation.y");
+		CHECK_VALUE(2, "Translation.z");
+		CHECK_VALUE(3, "Rotation.x");
+		CHECK_VALUE(4, "Rotation.y");
+		CHECK_VALUE(5, "Rotation.z");
+		CHECK_VALUE(6, "Rotation.w");
+		CHECK_VALUE(7, "Scale.x");
+		CHECK_VALUE(8, "Scale.y");
+		CHECK_VALUE(9, "Scale.z");
+
+#undef CHECK_VALUE
+
+		Partition.VertexRows.Append(VertexValues, FLoadPartition::VertexRowSize);
+		Partition.Bounds += FVector(VertexValues[0], VertexValues[1], VertexValues[2]);
+	}
+
+	// Convert the incoming points and metadata in the range of the given partition into the rows that will be inserted into the database
+	void BuildLoadPartitionRows(FLoadPartition& Partition,
+		const TArray<FTransform>& PreparedTransforms,
+		const TArray<int>& MetadataCountPerVertex,
+		const TArray<TPair<int, FString>>& PreparedMetadata,
+		const TArray<int32>& KeyIdFromColumn,
+		const TMap<FString, int>& ValueKeysIndex,
+		const FBox& ImportBounds)
+	{
+		Partition.VertexRows.Reserve((Partition.End - Partition.Begin) * FLoadPartition::VertexRowSize);
+		Partition.AttributeRows.Reserve(Partition.MetadataCount * 3);
+
+		int32 MetadataIndex = Partition.MetadataBegin;
+
+		for (int32 Index = Partition.Begin; Index < Partition.End; ++Index)
+		{
+			const FTransform& Transform = PreparedTransforms[Index];
+			const int32 MetadataCount = MetadataCountPerVertex[Index];
+
+			if (ImportBounds.IsValid && !ImportBounds.IsInside(Transform.GetTranslation()))
+			{
+				// The given point is not within the bounding box, so skip it and its metadata
+				MetadataIndex += MetadataCount;
+				continue;
+			}
+
+			const float VertexValues[FLoadPartition::VertexRowSize] =
+			{
+				(float)Transform.GetTranslation().X,
+				(float)Transform.GetTranslation().Y,
+				(float)Transform.GetTranslation().Z,
+				(float)Transform.GetRotation().X,
+				(float)Transform.GetRotation().Y,
+				(float)Transform.GetRotation().Z,
+				(float)Transform.GetRotation().W,
+				(float)Transform.GetScale3D().X,
+				(float)Transform.GetScale3D().Y,
+				(float)Transform.GetScale3D().Z
+			};
+
+			AppendLoadPartitionVertex(Partition, Index, VertexValues);
+
+			for (int32 Entry = 0; Entry < MetadataCount; ++Entry, ++MetadataIndex)
+			{
+				const TPair<int, FString>& Metadata = PreparedMetadata[MetadataIndex];
+
+				Partition.AttributeRows.Add(Partition.NumVertices);
+				Partition.AttributeRows.Add(KeyIdFromColumn[Metadata.Key]);
+				Partition.AttributeRows.Add(ValueKeysIndex[Metadata.Value]);
+			}
+
+			Partition.NumVertices++;
+		}
+	}
+
+	// Convert the points of a columnar store in the range of the given partition into the rows that will be inserted into the database.
+	// Values are translated from dictionary ids to database ids, so no strings are touched per point
+	void BuildColumnarLoadPartitionRows(FLoadPartition& Partition,
+		const FPointCloudColumnarStore& Store,
+		const TArray<int32>& KeyIdFromColumn,
+		const TArray<TArray<int32>>& ValueIdFromDictionary,
+		const FBox& ImportBounds)
+	{
+		const TArrayView<const FVector3f> Positions = Store.GetPositions();
+		const TArrayView<const FVector4f> Orientations = Store.GetOrientations();
+		const TArrayView<const FVector3f> Scales = Store.GetScales();
+
+		TArray<TArrayView<const int32>> ValueIdColumns;
+		ValueIdColumns.SetNum(KeyIdFromColumn.Num());
+		for (int32 Column = 0; Column < KeyIdFromColumn.Num(); ++Column)
+		{
+			ValueIdColumns[Column] = Store.GetValueIds(Column);
+		}
+
+		Partition.VertexRows.Reserve((Partition.End - Partition.Begin) * FLoadPartition::VertexRowSize);
+		Partition.AttributeRows.Reserve((Partition.End - Partition.Begin) * KeyIdFromColumn.Num() * 3);
+
+		for (int32 Index = Partition.Begin; Index < Partition.End; ++Index)
+		{
+			const FVector3f& Position = Positions[Index];
+
+			if (ImportBounds.IsValid && !ImportBounds.IsInside(FVector(Position)))
+			{
+				continue;
+			}
+
+			const FVector4f& Orientation = Orientations[Index];
+			const FVector3f& Scale = Scales[Index];
+
+			const float VertexValues[FLoadPartition::VertexRowSize] =
+			{
+				Position.X, Position.Y, Position.Z,
+				Orientation.X, Orientation.Y, Orientation.Z, Orientation.W,
+				Scale.X, Scale.Y, Scale.Z
+			};
+
+			AppendLoadPartitionVertex(Partition, Index, VertexValues);
+
+			for (int32 Column = 0; Column < ValueIdColumns.Num(); ++Column)
+			{
+				const int32 DictionaryId = ValueIdColumns[Column][Index];
+
+				if (DictionaryId != FPointCloudColumnarStore::NoValue)
+				{
+					Partition.AttributeRows.Add(Partition.NumVertices);
+					Partition.AttributeRows.Add(KeyIdFromColumn[Column]);
+					Partition.AttributeRows.Add(ValueIdFromDictionary[Column][DictionaryId]);
+				}
+			}
+
+			Partition.NumVertices++;
+		}
+	}
+
+	// Convert the points of dictionary encoded columns in the range of the given partition into the rows that will be inserted into the database.
+	// Every point has a value for every key, values are translated from dictionary ids to database ids
+	void BuildInternedLoadPartitionRows(FLoadPartition& Partition,
+		const TArray<FTransform>& PreparedTransforms,
+		TArrayView<const TArray<int32>* const> ValueIdColumns,
+		const TArray<int32>& KeyIdFromColumn,
+		const TArray<TArray<int32>>& ValueIdFromDictionary,
+		const FBox& ImportBounds)
+	{
+		Partition.VertexRows.Reserve((Partition.End - Partition.Begin) * FLoadPartition::VertexRowSize);
+		Partition.AttributeRows.Reserve((Partition.End - Partition.Begin) * KeyIdFromColumn.Num() * 3);
+
+		for (int32 Index = Partition.Begin; Index < Partition.End; ++Index)
+		{
+			const FTransform& Transform = PreparedTransforms[Index];
+
+			if (ImportBounds.IsValid && !ImportBounds.IsInside(Transform.GetTranslation()))
+			{
+				continue;
+			}
+
+			const float VertexValues[FLoadPartition::VertexRowSize] =
+			{
+				(float)Transform.GetTranslation().X,
+				(float)Transform.GetTranslation().Y,
+				(float)Transform.GetTranslation().Z,
+				(float)Transform.GetRotation().X,
+				(float)Transform.GetRotation().Y,
+				(float)Transform.GetRotation().Z,
+				(float)Transform.GetRotation().W,
+				(float)Transform.GetScale3D().X,
+				(float)Transform.GetScale3D().Y,
+				(float)Transform.GetScale3D().Z
+			};
+
+			AppendLoadPartitionVertex(Partition, Index, VertexValues);
+
+			for (int32 Column = 0; Column < ValueIdColumns.Num(); ++Column)
+			{
+				Partition.AttributeRows.Add(Partition.NumVertices);
+				Partition.AttributeRows.Add(KeyIdFromColumn[Column]);
+				Partition.AttributeRows.Add(ValueIdFromDictionary[Column][(*ValueIdColumns[Column])[Index]]);
+			}
+
+			Partition.NumVertices++;
+		}
+	}
+
+	// Sort the points in a partition along a Morton curve covering the given bounds
+	void SortLoadPartitionSpatially(FLoadPartition& Partition, const FBox& Bounds)
+	{
+		Partition.SpatialOrder.SetNumUninitialized(Partition.NumVertices);
+
+		for (int32 Vertex = 0; Vertex < Partition.NumVertices; ++Vertex)
+		{
+			const float* Row = Partition.VertexRows.GetData() + Vertex * FLoadPartition::VertexRowSize;
+			Partition.SpatialOrder[Vertex] = TPair<uint64, int32>(PointCloud::MortonCode(FVector(Row[0], Row[1], Row[2]), Bounds), Vertex);
+		}
+
+		Partition.SpatialOrder.Sort([](const TPair<uint64, int32>& A, const TPair<uint64, int32>& B)
+			{
+				return A.Key < B.Key;
+			});
+	}
+
+	// Insert the points of all of the partitions into the spatial index, merging the sorted partitions so the rtree is built in Morton order
+	bool InsertSpatialRows(UPointCloudImpl* PointCloud, const TArray<FLoadPartition>& Partitions)
+	{
+		struct FCursor
+		{
+			uint64 Code;
+			int32 Partition;
+			int32 Position;
+		};
+
+		auto CursorPredicate = [](const FCursor& A, const FCursor& B)
+		{
+			return A.Code < B.Code || (A.Code == B.Code && A.Partition < B.Partition);
+		};
+
+		TArray<FCursor> Heap;
+		Heap.Reserve(Partitions.Num());
+
+		for (int32 PartitionIndex = 0; PartitionIndex < Partitions.Num(); ++PartitionIndex)
+		{
+			if (Partitions[PartitionIndex].SpatialOrder.Num() > 0)
+			{
+				Heap.HeapPush(FCursor{ Partitions[PartitionIndex].SpatialOrder[0].Key, PartitionIndex, 0 }, CursorPredicate);
+			}
+		}
+
+		FPointCloudQuery InsertSpatialQuery(PointCloud);
+		InsertSpatialQuery.SetQuery(TEXT("INSERT INTO SpatialQuery VALUES(?,?,?,?,?,?,?)"));
+		InsertSpatialQuery.Begin();
+
+		while (Heap.Num() > 0)
+		{
+			FCursor Cursor;
+			Heap.HeapPop(Cursor, CursorPredicate, EAllowShrinking::No);
+
+			const FLoadPartition& Partition = Partitions[Cursor.Partition];
+			const int32 Vertex = Partition.SpatialOrder[Cursor.Position].Value;
+			const float* Row = Partition.VertexRows.GetData() + Vertex * FLoadPartition::VertexRowSize;
+			const float Extents[6] = { Row[0], Row[0], Row[1], Row[1], Row[2], Row[2] };
+
+			if (!InsertSpatialQuery.Step(Partition.FirstRowId + Vertex, MakeArrayView(Extents)))
+			{
+				InsertSpatialQuery.End();
+				return false;
+			}
+
+			if (++Cursor.Position < Partition.SpatialOrder.Num())
+			{
+				Cursor.Code = Partition.SpatialOrder[Cursor.Position].Key;
+				Heap.HeapPush(Cursor, CursorPredicate);
+			}
+		}
+
+		return InsertSpatialQuery.End();
+	}
+}
+
 uint32 UPointCloudImpl::GetTemporaryTableOptimizeFrequency()
 {
 	// magic number warning. This maybe become user configurable at some point, hence using a static method rather than a const int or similar
@@ -151,6 +533,88 @@ FString UPointCloudImpl::GetTemporaryIntersectionTable(EArgumentType ArgumentATy
 	return GetTemporaryQueryTable(UnionQuery);
 }
 
+FString UPointCloudImpl::GetTemporaryQueryPlanTable(const FPointCloudQueryPlan& Plan)
+{
+	if (Plan.Statements.Num() == 0)
+	{
+		return FString();
+	}
+
+	POINTCLOUD_PROFILE_SCOPE("PointCloud Query Plan Build");
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	FString TableName = GetTemporaryQueryTable(Plan.Statements[0]);
+
+	if (Plan.Statements.Num() > 1)
+	{
+		// Go through each filter, the most selective first, intersecting it with the results so far
+		for (int32 StatementIndex = 1; StatementIndex < Plan.Statements.Num() && !TableName.IsEmpty(); ++StatementIndex)
+		{
+			TableName = GetTemporaryIntersectionTable(EArgumentType::Table, TableName, EArgumentType::Query, Plan.Statements[StatementIndex]);
+		}
+
+		// The order of the rows of an intersection depends on the order the filters were run in, order them so that the results and their 
+		// hash don't depend on the plan
+		if (!TableName.IsEmpty())
+		{
+			TableName = GetTemporaryQueryTable(FString::Printf(TEXT("SELECT ID FROM %s ORDER BY ID"), *TableName));
+		}
+	}
+
+	if (Stats.IsValid())
+	{
+		Stats->AddTimingToEvent(TEXT("PointCloud Query Plan Build"), FTimespan::FromSeconds(FPlatformTime::Seconds() - StartTime));
+	}
+
+	return TableName;
+}
+
+FString UPointCloudImpl::FindQueryPlanTable(const FPointCloudQueryPlan& Plan)
+{
+	FString TableName = QueryPlanTables.Find(Plan.Hash);
+
+	if (!TableName.IsEmpty())
+	{
+		// Keep the table from being evicted while it is in use. Try not to wait on the LRU, but if it is busy the table may have been evicted
+		// meanwhile, so wait for the lock to find out rather than hand back a table that could have been dropped
+		const FString Key = PointCloudPrivateNamespace::GetTemporaryTableKey(TableName);
+
+		int32 CacheHitCount = 0;
+		FPointCloudTemporaryTablesCache::ETouchResult TouchResult = TemporaryTables.TryTouch(Key, &CacheHitCount);
+
+		if (TouchResult == FPointCloudTemporaryTablesCache::ETouchResult::Busy)
+		{
+			TouchResult = TemporaryTables.GetFromCache(Key, &CacheHitCount).IsEmpty() ? FPointCloudTemporaryTablesCache::ETouchResult::NotCached : FPointCloudTemporaryTablesCache::ETouchResult::Touched;
+		}
+
+		if (TouchResult == FPointCloudTemporaryTablesCache::ETouchResult::NotCached)
+		{
+			// The table was dropped after it was looked up, it gets rebuilt by the caller
+			TableName.Empty();
+		}
+		else if (CacheHitCount == GetCacheHitBeforeIndexCount())
+		{
+			CreateTemporaryTableIndex(Key, TableName);
+		}
+	}
+
+	if (Stats.IsValid())
+	{
+		Stats->IncrementCounter(TableName.IsEmpty() ? TEXT("PointCloud Query Plan Misses") : TEXT("PointCloud Query Plan Hits"));
+	}
+
+	return TableName;
+}
+
+void UPointCloudImpl::AddQueryPlanTable(const FPointCloudQueryPlan& Plan, const FString& TableName)
+{
+	if (!TableName.IsEmpty())
+	{
+		QueryPlanTables.Add(Plan.Hash, TableName);
+	}
+}
+
 TArray<TPair<FString, int32>>  UPointCloudImpl::GetQueryCacheMissCounts() const
 {
 	TArray< TPair<FString, int32> > Result;
@@ -180,65 +644,248 @@ uint32 UPointCloudImpl::GetCacheHitBeforeIndexCount()
 	return 3;
 }
 
-FString UPointCloudImpl::GetTemporaryQueryTable(const FString& Query)
+FString UPointCloudImpl::GetTemporaryQueryTable(const FString& Query)
+{
+	// hash the string to find a unique ID
+	const FString SanitizedQuery = PointCloudPrivateNamespace::SanitizeTableName(Query);
+	const FString KeyName = FString::Printf(TEXT("QUERY_TABLE_%s"), *SanitizedQuery);
+	const FString TempName = "Temp_" + KeyName + "_Table";
+
+	// Check if the table already exists
+	int32 CacheHitCount = 0;
+	FString CachedTableName = TemporaryTables.GetFromCache(KeyName, &CacheHitCount);
+
+	// Build index if needed (note: if cache hit count != 0 then the table already exists)
+	if (CacheHitCount == GetCacheHitBeforeIndexCount())
+	{
+		CreateTemporaryTableIndex(KeyName, TempName);
+	}
+
+	// If table already exists, just return that
+	if (!CachedTableName.IsEmpty())
+	{
+		return CachedTableName;
+	}
+
+	// Otherwise, create the table
+	POINTCLOUD_PROFILE_SCOPE("PointCloud Temporary Query Table");
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int64 NumRows = CreateTemporaryTableAs(TempName, Query);
+	if (NumRows < 0)
+	{
+		return FString();
+	}
+
+	AddTemporaryTable(KeyName, TempName, FPlatformTime::Seconds() - StartTime, NumRows);
+
+	return TempName;
+}
+
+int64 UPointCloudImpl::CreateTemporaryTableAs(const FString& Name, const FString& Query)
+{
+	// CREATE TABLE AS does not report how many rows it wrote, so create the empty table from the query's columns then fill it,
+	// the insert reporting the number of rows through sqlite3_changes without another pass over the table. Callers only get here
+	// on a cache miss, so a table left with this name is not tracked anymore and is rebuilt rather than appended to
+	const FString DropTableQuery = FString::Printf(TEXT("DROP TABLE IF EXISTS %s"), *Name);
+	RUN_QUERY(DropTableQuery);
+
+	const FString CreateTableQuery = FString::Printf(TEXT("CREATE TEMPORARY TABLE %s AS SELECT * FROM (%s) LIMIT 0"), *Name, *Query);
+	if (RUN_QUERY(CreateTableQuery) == false)
+	{
+		return INDEX_NONE;
+	}
+
+	const FString InsertQuery = FString::Printf(TEXT("INSERT INTO %s %s"), *Name, *Query);
+	if (RUN_QUERY(InsertQuery) == false)
+	{
+		return INDEX_NONE;
+	}
+
+	return sqlite3_changes(InternalDatabase);
+}
+
+void UPointCloudImpl::AddTemporaryTable(const FString& Key, const FString& Name, double BuildSeconds, int64 NumRows)
+{
+	check(Key.IsEmpty() == false);
+	check(Name.IsEmpty() == false);
+
+	// The size is only an estimate, rows are assumed to all take GetTemporaryTableBytesPerRow
+	const TArray<FString> TablesToDrop = TemporaryTables.AddToCache(Key, Name, NumRows * GetTemporaryTableBytesPerRow(), BuildSeconds);
+
+	for (const FString& TableToDrop : TablesToDrop)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+
+		const int32 NumPlansRemoved = QueryPlanTables.RemoveTable(TableToDrop);
+
+		FString DeleteTableQuery = FString::Printf(TEXT("DROP TABLE IF EXISTS %s"), *TableToDrop);
+		RUN_QUERY(DeleteTableQuery);
+
+		if (Stats.IsValid() && NumPlansRemoved > 0)
+		{
+			Stats->AddToCounter(TEXT("PointCloud Query Plan Evictions"), NumPlansRemoved);
+			Stats->AddTimingToEvent(TEXT("PointCloud Query Plan Eviction"), FTimespan::FromSeconds(FPlatformTime::Seconds() - StartTime));
+		}
+	}
+
+	if (NumTablesSinceOptimize++ > GetTemporaryTableOptimizeFrequency())
+	{
+		FString Analyze = FString::Printf(TEXT("PRAGMA optimize"));
+		RUN_QUERY(Analyze);
+		NumTablesSinceOptimize = 0;
+	}
+}
+
+void UPointCloudImpl::CreateTemporaryTableIndex(const FString& Key, const FString& Name)
+{
+	POINTCLOUD_PROFILE_SCOPE("PointCloud Temporary Table Index");
+
+	const FString IndexName = "Temp_" + Key + "_Index";
+	const FString CreateIndexQuery = FString::Printf(TEXT("CREATE INDEX IF NOT EXISTS %s ON %s(ID);"), *IndexName, *Name);
+	if (RUN_QUERY(CreateIndexQuery) == false)
+	{
+		UE_LOG(PointCloudLog, Log, TEXT("Cannot create index on temporary table %s"), *Name);
+	}
+}
+
+FString UPointCloudImpl::GetTemporaryIdTable(const FString& Key, const TArray<int32>& Ids)
+{
+	const FString KeyName = FString::Printf(TEXT("ID_TABLE_%s"), *PointCloudPrivateNamespace::SanitizeTableName(Key));
+	const FString TempName = "Temp_" + KeyName + "_Table";
+
+	// If table already exists, just return that
+	FString CachedTableName = TemporaryTables.GetFromCache(KeyName);
+	if (!CachedTableName.IsEmpty())
+	{
+		return CachedTableName;
+	}
+
+	POINTCLOUD_PROFILE_SCOPE("PointCloud Temporary Id Table");
+
+	const double StartTime = FPlatformTime::Seconds();
+	const FString CreateTableQuery = FString::Printf(TEXT("CREATE TEMPORARY TABLE IF NOT EXISTS %s(Id INTEGER PRIMARY KEY)"), *TempName);
+	if (RUN_QUERY(CreateTableQuery) == false)
+	{
+		return FString();
+	}
+
+	// Insert the ids using multi row inserts, which is much quicker than stepping a statement once per id
+	const int32 IdsPerInsert = 500;
+	TStringBuilder<8192> Builder;
+
+	for (int32 Begin = 0; Begin < Ids.Num(); Begin += IdsPerInsert)
+	{
+		const int32 End = FMath::Min(Begin + IdsPerInsert, Ids.Num());
+
+		Builder.Reset();
+		Builder.Appendf(TEXT("INSERT OR IGNORE INTO %s(Id) VALUES (%d)"), *TempName, Ids[Begin]);
+
+		for (int32 Index = Begin + 1; Index < End; ++Index)
+		{
+			Builder.Appendf(TEXT(",(%d)"), Ids[Index]);
+		}
+
+		if (RUN_QUERY(FString(Builder.ToString())) == false)
+		{
+			RUN_QUERY(FString::Printf(TEXT("DROP TABLE IF EXISTS %s"), *TempName));
+			return FString();
+		}
+	}
+
+	AddTemporaryTable(KeyName, TempName, FPlatformTime::Seconds() - StartTime, Ids.Num());
+
+	return TempName;
+}
+
+TSharedPtr<const FPointCloudSpatialIndex> UPointCloudImpl::GetSpatialIndex() const
+{
+	FScopeLock Lock(&SpatialIndexLock);
+
+	if (!SpatialIndex.IsValid() && IsInitialized())
+	{
+		PointCloud::UtilityTimer Timer;
+
+		TArray<int32> RowIds;
+		TArray<FVector3f> Positions;
+
+		GetValues(TEXT("SELECT rowid, x, y, z FROM Vertex"), TArray<FString>(), [&RowIds, &Positions](sqlite3_stmt* Statement, int* ColumnIndices)
+			{
+				RowIds.Add(sqlite3_column_int(Statement, 0));
+				Positions.Emplace((float)sqlite3_column_double(Statement, 1), (float)sqlite3_column_double(Statement, 2), (float)sqlite3_column_double(Statement, 3));
+			});
+
+		SpatialIndex = MakeShared<const FPointCloudSpatialIndex>(RowIds, Positions);
+
+		Timer.Report("Build Spatial Index");
+	}
+
+	return SpatialIndex;
+}
+
+void UPointCloudImpl::InvalidateSpatialIndex() const
+{
+	{
+		FScopeLock Lock(&SpatialIndexLock);
+		SpatialIndex.Reset();
+	}
+
+	// Attribute indices are laid out in the order of the spatial index, and are built from the same data
+	FScopeLock Lock(&AttributeIndicesLock);
+	AttributeIndices.Reset();
+}
+
+TSharedPtr<const FPointCloudAttributeIndex> UPointCloudImpl::GetAttributeIndex(const FString& MetadataKey) const
 {
-	// hash the string to find a unique ID
-	const FString SanitizedQuery = PointCloudPrivateNamespace::SanitizeTableName(Query);
-	const FString KeyName = FString::Printf(TEXT("QUERY_TABLE_%s"), *SanitizedQuery);
-	const FString TempName = "Temp_" + KeyName + "_Table";
-
-	// Check if the table already exists
-	int32 CacheHitCount = 0;
-	FString CachedTableName = TemporaryTables.GetFromCache(KeyName, &CacheHitCount);
+	TSharedPtr<const FPointCloudSpatialIndex> Index = GetSpatialIndex();
 
-	// Build index if needed (note: if cache hit count != 0 then the table already exists)
-	if (CacheHitCount == GetCacheHitBeforeIndexCount())
+	if (!Index.IsValid())
 	{
-		const FString IndexName = "Temp_" + KeyName + "_Index";
-		const FString CreateIndexQuery = FString::Printf(TEXT("CREATE INDEX IF NOT EXISTS %s ON %s(ID);"), *IndexName, *TempName);
-		if (RUN_QUERY(CreateIndexQuery) == false)
-		{
-			UE_LOG(PointCloudLog, Log, TEXT("Cannot create index on temporary table for query %s"), *Query);
-		}
+		return nullptr;
 	}
 
-	// If table already exists, just return that
-	if (!CachedTableName.IsEmpty())
+	FScopeLock Lock(&AttributeIndicesLock);
+
+	TSharedPtr<const FPointCloudAttributeIndex>* CachedIndex = AttributeIndices.Find(MetadataKey);
+
+	// An index built for a previous spatial index is out of date even if it was not discarded yet
+	if (CachedIndex && (*CachedIndex)->GetSpatialIndex() == Index)
 	{
-		return CachedTableName;
+		return *CachedIndex;
 	}
 
-	// Otherwise, create the table
-	const FString CreateTableQuery = FString::Printf(TEXT("CREATE TEMPORARY TABLE IF NOT EXISTS %s AS %s"), *TempName, *Query);
-	if (RUN_QUERY(CreateTableQuery) == false)
+	if (HasMetaDataAttribute(MetadataKey) == false)
 	{
-		return FString();
+		return nullptr;
 	}
 
-	AddTemporaryTable(KeyName, TempName);
+	PointCloud::UtilityTimer Timer;
 
-	return TempName;
-}
+	const int KeyId = GetValue<int>(FString::Printf(TEXT("SELECT rowid AS ID from AttributeKeys where AttributeKeys.Name = \'%s\'"), *SanitizeAndEscapeString(MetadataKey)), "ID");
 
-void UPointCloudImpl::AddTemporaryTable(const FString& Key, const FString& Name)
-{
-	check(Key.IsEmpty() == false);
-	check(Name.IsEmpty() == false);
+	TArray<int32> RowIds;
+	TArray<int32> ValueIds;
+
+	GetValues(FString::Printf(TEXT("SELECT vertex_id, value_id FROM VertexToAttribute WHERE key_id=%d"), KeyId), TArray<FString>(), [&RowIds, &ValueIds](sqlite3_stmt* Statement, int* ColumnIndices)
+		{
+			RowIds.Add(sqlite3_column_int(Statement, 0));
+			ValueIds.Add(sqlite3_column_int(Statement, 1));
+		});
 
-	FString TableToDrop = TemporaryTables.AddToCache(Key, Name);
+	// Each distinct value is read once, rather than once per point
+	TMap<int32, FString> Values;
 
-	if (!TableToDrop.IsEmpty())
-	{
-		FString DeleteTableQuery = FString::Printf(TEXT("DROP TABLE IF EXISTS %s"), *TableToDrop);
-		RUN_QUERY(DeleteTableQuery);
-	}
+	GetValues(FString::Printf(TEXT("SELECT rowid, Value FROM AttributeValues WHERE rowid IN (SELECT DISTINCT value_id FROM VertexToAttribute WHERE key_id=%d)"), KeyId), TArray<FString>(), [&Values](sqlite3_stmt* Statement, int* ColumnIndices)
+		{
+			Values.Add(sqlite3_column_int(Statement, 0), (const char*)sqlite3_column_text(Statement, 1));
+		});
 
-	if (NumTablesSinceOptimize++ > GetTemporaryTableOptimizeFrequency())
-	{
-		FString Analyze = FString::Printf(TEXT("PRAGMA optimize"));
-		RUN_QUERY(Analyze);
-		NumTablesSinceOptimize = 0;
-	}
+	TSharedPtr<const FPointCloudAttributeIndex> AttributeIndex = MakeShared<const FPointCloudAttributeIndex>(Index, RowIds, ValueIds, Values);
+	AttributeIndices.Add(MetadataKey, AttributeIndex);
+
+	Timer.Report("Build Attribute Index");
+
+	return AttributeIndex;
 }
 
 FString UPointCloudImpl::GetTemporaryAttributeTable(const FString& MetadataKey)
@@ -259,11 +906,15 @@ FString UPointCloudImpl::GetTemporaryAttributeTable(const FString& MetadataKey)
 	FString TempName = "Temp_" + PointCloudPrivateNamespace::SanitizeTableName(MetadataKey) + "_Table";
 	FString IndexName = "Temp_" + PointCloudPrivateNamespace::SanitizeTableName(MetadataKey) + "_Index";
 
+	POINTCLOUD_PROFILE_SCOPE("PointCloud Temporary Attribute Table");
+
+	const double StartTime = FPlatformTime::Seconds();
+
 	FString GetAttributeQuery = FString::Printf(TEXT("SELECT rowid AS ID from AttributeKeys where AttributeKeys.Name = \'%s\'"), *MetadataKey);
 	int MetadataIndex = GetValue<int>(GetAttributeQuery, "ID");
 
-	FString CreateTableQuery = FString::Printf(TEXT("CREATE  TEMPORARY TABLE IF NOT EXISTS %s AS Select VertexToAttribute.vertex_id as Id, VertexToAttribute.value_id as ValueId From VertexToAttribute where key_id=%d"), *TempName, MetadataIndex);
-	RUN_QUERY(CreateTableQuery);
+	const FString SelectQuery = FString::Printf(TEXT("Select VertexToAttribute.vertex_id as Id, VertexToAttribute.value_id as ValueId From VertexToAttribute where key_id=%d"), MetadataIndex);
+	const int64 NumRows = FMath::Max<int64>(CreateTemporaryTableAs(TempName, SelectQuery), 0);
 
 	FString CreateIndexQuery = FString::Printf(TEXT("CREATE INDEX IF NOT EXISTS %s ON %s(ID,ValueId);"), *IndexName, *TempName);
 	RUN_QUERY(CreateIndexQuery);
@@ -271,7 +922,7 @@ FString UPointCloudImpl::GetTemporaryAttributeTable(const FString& MetadataKey)
 	FString Analyze = FString::Printf(TEXT("ANALYZE %s"), *TempName);
 	RUN_QUERY(Analyze);
 
-	AddTemporaryTable(MetadataKey, TempName);
+	AddTemporaryTable(MetadataKey, TempName, FPlatformTime::Seconds() - StartTime, NumRows);
 
 	return TempName;
 }
@@ -283,21 +934,15 @@ bool UPointCloudImpl::HasTemporaryTable(const FString& MetadataKey) const
 
 void UPointCloudImpl::ClearTemporaryTables()
 {
-	bool bContinueCleanup = true;
+	// The spatial index is derived data in the same way as the temporary tables are, so goes with them
+	InvalidateSpatialIndex();
 
-	while (bContinueCleanup)
-	{
-		FString TableName = TemporaryTables.RemoveLeastRecentNotThreadSafe();
+	QueryPlanTables.Reset();
 
-		if (TableName.IsEmpty())
-		{
-			bContinueCleanup = false;
-		}
-		else
-		{
-			FString DeleteTableQuery = FString::Printf(TEXT("DROP TABLE IF EXISTS %s"), *TableName);
-			RUN_QUERY(DeleteTableQuery);
-		}
+	for (const FString& TableName : TemporaryTables.RemoveAll())
+	{
+		FString DeleteTableQuery = FString::Printf(TEXT("DROP TABLE IF EXISTS %s"), *TableName);
+		RUN_QUERY(DeleteTableQuery);
 	}
 }
 
@@ -369,6 +1014,9 @@ bool UPointCloudImpl::UpdateFromSchemaVersionOneToVersionTwo()
 
 	SchemaVersion = EPointCloudSchemaVersions::POINTCLOUD_VERSION_2;
 
+	// Every row was copied to the new tables
+	InvalidateHash(/*bContentChanged=*/true);
+
 	MarkPackageDirty();
 
 	return true;
@@ -400,6 +1048,7 @@ UPointCloudImpl::~UPointCloudImpl()
 {
 	if (InternalDatabase)
 	{
+		PreparedStatements.Reset();
 		sqlite3_close(InternalDatabase);
 	}
 }
@@ -431,9 +1080,17 @@ bool UPointCloudImpl::BeginTransaction()
 }
 
 // Invalidate the WholeDb Hash
-void UPointCloudImpl::InvalidateHash()
+void UPointCloudImpl::InvalidateHash(bool bContentChanged)
 {
+	FScopeLock Lock(&HashLock);
+
 	WholeDbHash.Reset();
+	InvalidateSpatialIndex();
+
+	if (bContentChanged)
+	{
+		bVertexBlockHashesValid = false;
+	}
 }
 
 bool UPointCloudImpl::IsHashInvalid() const
@@ -451,47 +1108,142 @@ bool UPointCloudImpl::IsHashInvalid() const
 }
 
 // recalculate the whole DB Hash
-void UPointCloudImpl::CalculateWholeDbHash(void* Data, uint64 Size) const
+void UPointCloudImpl::CalculateWholeDbHash() const
 {
 	if (!IsInitialized())
 	{
 		return;
 	}
 
+	FScopeLock Lock(&HashLock);
+
 	// calculate the DB hash
 	if (IsHashInvalid())
 	{
-		if (Data)
+		UpdateVertexBlockHashes();
+
+		// This is a Merkle tree with a single level, the root hashes the objects, which are few, and the hash of each block
+		WholeDbHash.Reset();
+
+		GetValues(TEXT("SELECT rowid, Name FROM Object ORDER BY rowid"), TArray<FString>(), [this](sqlite3_stmt* Statement, int* ColumnIndices)
+			{
+				PointCloudPrivateNamespace::HashRowColumns(WholeDbHash, Statement);
+			});
+
+		const int32 NumBlocks = VertexBlockHashes.Num();
+		WholeDbHash.Update(reinterpret_cast<const uint8*>(&NumBlocks), sizeof(NumBlocks));
+
+		for (const FSHAHash& BlockHash : VertexBlockHashes)
 		{
-			WholeDbHash.Update((const uint8*)Data, Size);
-			WholeDbHash.Final();
+			WholeDbHash.Update(BlockHash.Hash, sizeof(BlockHash.Hash));
 		}
-		else
+
+		WholeDbHash.Final();
+	}
+}
+
+void UPointCloudImpl::UpdateVertexBlockHashes() const
+{
+	using namespace PointCloudPrivateNamespace;
+
+	const int64 MaxRowId = GetValue<int64>(TEXT("SELECT MAX(rowid) FROM Vertex"));
+	const int32 NumBlocks = (int32)FMath::DivideAndRoundUp(MaxRowId, VerticesPerHashBlock);
+
+	if (!bVertexBlockHashesValid)
+	{
+		VertexBlockHashes.Reset();
+		DirtyVertexBlocks.Reset();
+		bVertexBlockHashesValid = true;
+	}
+
+	// New blocks need to be hashed, blocks past the end of the table no longer exist
+	VertexBlockHashes.SetNum(NumBlocks);
+	DirtyVertexBlocks.SetNum(NumBlocks, true);
+
+	// Hash each run of dirty blocks with one pass over their vertices and one over their metadata
+	for (int32 FirstBlock = DirtyVertexBlocks.Find(true); FirstBlock != INDEX_NONE; FirstBlock = DirtyVertexBlocks.FindFrom(true, FirstBlock))
+	{
+		int32 EndBlock = FirstBlock + 1;
+		while (EndBlock < NumBlocks && DirtyVertexBlocks[EndBlock])
 		{
-			// the calling function has not provided us with any data, derialize the database and use that data for the hash
+			++EndBlock;
+		}
 
-			sqlite3_int64 piSize = 0;
+		const int64 FirstRowId = FirstBlock * VerticesPerHashBlock + 1;
+		const int64 LastRowId = EndBlock * VerticesPerHashBlock;
 
-			unsigned char* SerializedData = sqlite3_serialize(
-				InternalDatabase,           /* The database connection */
-				"main",						/* Which DB to serialize. ex: "main", "temp", ... */
-				&piSize,					/* Write size of the DB here, if not NULL */
-				0							/* Zero or more SQLITE_SERIALIZE_* flags */
-			);
+		TArray<FSHA1> VertexHashes;
+		TArray<FSHA1> MetadataHashes;
+		VertexHashes.SetNum(EndBlock - FirstBlock);
+		MetadataHashes.SetNum(EndBlock - FirstBlock);
 
-			if (SerializedData != nullptr && piSize != 0)
+		GetValues(FString::Printf(TEXT("SELECT rowid, ObjectId, x, y, z, nx, ny, nz, nw, u, v, sx, sy, sz FROM Vertex WHERE rowid BETWEEN %lld AND %lld ORDER BY rowid"), FirstRowId, LastRowId), TArray<FString>(),
+			[&VertexHashes, FirstRowId](sqlite3_stmt* Statement, int* ColumnIndices)
 			{
-				CalculateWholeDbHash(SerializedData, piSize);
-			}
+				HashRowColumns(VertexHashes[(sqlite3_column_int64(Statement, 0) - FirstRowId) / VerticesPerHashBlock], Statement);
+			});
+
+		// Metadata is hashed by name and value rather than by id, the ids depend on the order attributes were first loaded in
+		GetValues(FString::Printf(TEXT("SELECT Vertex_Id, Attribute_Name, Attribute_Value FROM MetaData WHERE Vertex_Id BETWEEN %lld AND %lld ORDER BY Vertex_Id, Attribute_Name, Attribute_Value"), FirstRowId, LastRowId), TArray<FString>(),
+			[&MetadataHashes, FirstRowId](sqlite3_stmt* Statement, int* ColumnIndices)
+			{
+				HashRowColumns(MetadataHashes[(sqlite3_column_int64(Statement, 0) - FirstRowId) / VerticesPerHashBlock], Statement);
+			});
 
-			sqlite3_free((void*)SerializedData);
+		for (int32 Block = FirstBlock; Block < EndBlock; ++Block)
+		{
+			FSHAHash VertexHash;
+			FSHAHash MetadataHash;
+			VertexHashes[Block - FirstBlock].Final();
+			VertexHashes[Block - FirstBlock].GetHash(VertexHash.Hash);
+			MetadataHashes[Block - FirstBlock].Final();
+			MetadataHashes[Block - FirstBlock].GetHash(MetadataHash.Hash);
+
+			FSHA1 BlockHash;
+			BlockHash.Update(VertexHash.Hash, sizeof(VertexHash.Hash));
+			BlockHash.Update(MetadataHash.Hash, sizeof(MetadataHash.Hash));
+			BlockHash.Final();
+			BlockHash.GetHash(VertexBlockHashes[Block].Hash);
+
+			DirtyVertexBlocks[Block] = false;
+		}
 
+		if (EndBlock >= NumBlocks)
+		{
+			break;
 		}
 	}
 }
 
+void UPointCloudImpl::MarkVertexBlocksDirty(int64 FirstRowId, int64 LastRowId)
+{
+	using namespace PointCloudPrivateNamespace;
+
+	FScopeLock Lock(&HashLock);
+
+	if (!bVertexBlockHashesValid || LastRowId < FirstRowId)
+	{
+		// Every block will be hashed anyway
+		return;
+	}
+
+	const int32 FirstBlock = (int32)((FMath::Max<int64>(FirstRowId, 1) - 1) / VerticesPerHashBlock);
+	const int32 LastBlock = (int32)((LastRowId - 1) / VerticesPerHashBlock);
+
+	if (DirtyVertexBlocks.Num() <= LastBlock)
+	{
+		VertexBlockHashes.SetNum(LastBlock + 1);
+		DirtyVertexBlocks.SetNum(LastBlock + 1, true);
+	}
+
+	DirtyVertexBlocks.SetRange(FirstBlock, LastBlock - FirstBlock + 1, true);
+}
+
 FString UPointCloudImpl::GetHashAsString() const
 {
+	// call recaluldate hash if required
+	CalculateWholeDbHash();
+
 	FString Out;
 
 	for (int i = 0; i < WholeDbHash.DigestSize; i++)
@@ -609,6 +1361,188 @@ bool UPointCloudImpl::InitFromPreparedData(const FString& ObjectName,
 	const FBox& ImportBounds,
 	FFeedbackContext* Warn)
 {
+	using namespace PointCloudPrivateNamespace;
+
+	// Clear the MetadataAttributeCache
+	MetadataAttributeCache.Empty();
+
+	if (PreparedTransforms.Num() == 0)
+	{
+		return false;
+	}
+
+	// Check that we have the right number of Metadata points
+	if (PreparedTransforms.Num() != MetadataCountPerVertex.Num())
+	{
+		UE_LOG(PointCloudLog, Log, TEXT("Incorrect number of metadata entries %d vs %d expected Points\n"), MetadataCountPerVertex.Num(), PreparedTransforms.Num());
+		return false;
+	}
+
+	PointCloud::UtilityTimer Timer;
+	FLoadPhaseTimer TotalTimer(Stats, TEXT("Total"));
+
+	const int32 Count = PreparedTransforms.Num();
+
+	// Split the points into contiguous partitions, each of which is prepared independently and then merged in order
+	TArray<FLoadPartition> Partitions;
+	{
+		FLoadPhaseTimer PhaseTimer(Stats, TEXT("Partition"));
+
+		Partitions = MakeLoadPartitions(Count);
+
+		ParallelFor(Partitions.Num(), [&](int32 PartitionIndex)
+			{
+				FLoadPartition& Partition = Partitions[PartitionIndex];
+				for (int32 Index = Partition.Begin; Index < Partition.End; ++Index)
+				{
+					Partition.MetadataCount += MetadataCountPerVertex[Index];
+				}
+			});
+
+		int32 MetadataTotal = 0;
+		for (FLoadPartition& Partition : Partitions)
+		{
+			Partition.MetadataBegin = MetadataTotal;
+			MetadataTotal += Partition.MetadataCount;
+		}
+
+		if (MetadataTotal > PreparedMetadata.Num())
+		{
+			UE_LOG(PointCloudLog, Warning, TEXT("Metadata count per vertex requires %d entries but only %d were provided\n"), MetadataTotal, PreparedMetadata.Num());
+			return false;
+		}
+	}
+
+	TMap<FString, int> ValueKeysIndex;
+
+	auto InsertValues = [&]()
+	{
+		// find the set of unique Metadata values, one set per partition then merged
+		TArray<TSet<FString>> PartitionValueSets;
+		PartitionValueSets.SetNum(Partitions.Num());
+
+		ParallelFor(Partitions.Num(), [&](int32 PartitionIndex)
+			{
+				const FLoadPartition& Partition = Partitions[PartitionIndex];
+				for (int32 Index = Partition.MetadataBegin; Index < Partition.MetadataBegin + Partition.MetadataCount; ++Index)
+				{
+					PartitionValueSets[PartitionIndex].Add(PreparedMetadata[Index].Value);
+				}
+			});
+
+		TSet<FString> MetadataValueSet = MoveTemp(PartitionValueSets[0]);
+		for (int32 PartitionIndex = 1; PartitionIndex < PartitionValueSets.Num(); ++PartitionIndex)
+		{
+			MetadataValueSet.Append(MoveTemp(PartitionValueSets[PartitionIndex]));
+		}
+
+		FPointCloudQuery InsertAttributeQuery(this);
+		InsertAttributeQuery.SetQuery(TEXT("INSERT OR IGNORE INTO AttributeValues VALUES(?);"));
+
+		InsertAttributeQuery.Begin();
+		// now insert all of the Metadata values	
+		for (const FString& Value : MetadataValueSet)
+		{
+			FTCHARToUTF8 EchoStrUtf8(*Value);
+			TArray<char> UTF8Value(EchoStrUtf8.Get(), EchoStrUtf8.Length() + 1);
+			InsertAttributeQuery.Step(UTF8Value);
+		}
+		InsertAttributeQuery.End();
+
+		// Get the unique metadata DB ID's after inserting them all
+		TMap<FString, FString> ValueKeys = GetValueMap<FString, FString>("SELECT rowid as ID,Value from AttributeValues", "Value", "ID");
+
+		// Make a map from Value to Index In Database
+		for (const auto& a : ValueKeys)
+		{
+			ValueKeysIndex.Add(a.Key, FCString::Atoi(*a.Value));
+		}
+
+		return true;
+	};
+
+	auto BuildRows = [&](FLoadPartition& Partition, const TArray<int32>& KeyIdFromColumn)
+	{
+		BuildLoadPartitionRows(Partition, PreparedTransforms, MetadataCountPerVertex, PreparedMetadata, KeyIdFromColumn, ValueKeysIndex, ImportBounds);
+	};
+
+	if (!BulkInsertPartitions(ObjectName, Count, MetadataColumnNames, Partitions, InsertValues, BuildRows, Warn))
+	{
+		return false;
+	}
+
+	UE_LOG(PointCloudLog, Log, TEXT("Took %.2f Seconds to Insert Object\n"), Timer.ToSeconds());
+
+	return true;
+}
+
+bool UPointCloudImpl::InitFromColumnarStore(const FString& ObjectName, const FPointCloudColumnarStore& Store, const FBox& ImportBounds, FFeedbackContext* Warn)
+{
+	using namespace PointCloudPrivateNamespace;
+
+	// Clear the MetadataAttributeCache
+	MetadataAttributeCache.Empty();
+
+	if (Store.Num() == 0)
+	{
+		return false;
+	}
+
+	PointCloud::UtilityTimer Timer;
+	FLoadPhaseTimer TotalTimer(Stats, TEXT("Total"));
+
+	const TArray<FPointCloudColumnarStore::FAttributeColumn>& Attributes = Store.GetAttributes();
+
+	TArray<FString> MetadataColumnNames;
+	MetadataColumnNames.Reserve(Attributes.Num());
+	for (const FPointCloudColumnarStore::FAttributeColumn& Attribute : Attributes)
+	{
+		MetadataColumnNames.Add(Attribute.Name);
+	}
+
+	TArray<FLoadPartition> Partitions = MakeLoadPartitions(Store.Num());
+
+	// Database value id of each dictionary entry, per attribute
+	TArray<TArray<int32>> ValueIdFromDictionary;
+
+	TArray<const TArray<FString>*> Dictionaries;
+	Dictionaries.Reserve(Attributes.Num());
+	for (const FPointCloudColumnarStore::FAttributeColumn& Attribute : Attributes)
+	{
+		Dictionaries.Add(&Attribute.Dictionary);
+	}
+
+	auto InsertValues = [&]()
+	{
+		// The dictionaries already hold the distinct values of each attribute, so only they need to go through the database
+		return InsertDictionaryValues(Dictionaries, ValueIdFromDictionary);
+	};
+
+	auto BuildRows = [&](FLoadPartition& Partition, const TArray<int32>& KeyIdFromColumn)
+	{
+		BuildColumnarLoadPartitionRows(Partition, Store, KeyIdFromColumn, ValueIdFromDictionary, ImportBounds);
+	};
+
+	if (!BulkInsertPartitions(ObjectName, Store.Num(), MetadataColumnNames, Partitions, InsertValues, BuildRows, Warn))
+	{
+		return false;
+	}
+
+	UE_LOG(PointCloudLog, Log, TEXT("Took %.2f Seconds to Insert Object\n"), Timer.ToSeconds());
+
+	return true;
+}
+
+bool UPointCloudImpl::InitFromInternedColumns(const FString& ObjectName,
+	const TArray<FTransform>& PreparedTransforms,
+	const TArray<FString>& MetadataColumnNames,
+	TArrayView<const TArray<int32>* const> ValueIdColumns,
+	TArrayView<const TArray<FString>* const> Dictionaries,
+	const FBox& ImportBounds,
+	FFeedbackContext* Warn)
+{
+	using namespace PointCloudPrivateNamespace;
+
 	// Clear the MetadataAttributeCache
 	MetadataAttributeCache.Empty();
 
@@ -617,14 +1551,99 @@ bool UPointCloudImpl::InitFromPreparedData(const FString& ObjectName,
 		return false;
 	}
 
-	// Check that we have the right number of Metadata points
-	if (PreparedTransforms.Num() != MetadataCountPerVertex.Num())
+	if (ValueIdColumns.Num() != MetadataColumnNames.Num() || Dictionaries.Num() != MetadataColumnNames.Num())
+	{
+		UE_LOG(PointCloudLog, Log, TEXT("Incorrect number of metadata columns %d and dictionaries %d vs %d expected keys\n"), ValueIdColumns.Num(), Dictionaries.Num(), MetadataColumnNames.Num());
+		return false;
+	}
+
+	for (const TArray<int32>* ValueIds : ValueIdColumns)
+	{
+		if (ValueIds->Num() != PreparedTransforms.Num())
+		{
+			UE_LOG(PointCloudLog, Log, TEXT("Incorrect number of metadata entries %d vs %d expected Points\n"), ValueIds->Num(), PreparedTransforms.Num());
+			return false;
+		}
+	}
+
+	PointCloud::UtilityTimer Timer;
+	FLoadPhaseTimer TotalTimer(Stats, TEXT("Total"));
+
+	TArray<FLoadPartition> Partitions = MakeLoadPartitions(PreparedTransforms.Num());
+
+	// Database value id of each dictionary entry, per key
+	TArray<TArray<int32>> ValueIdFromDictionary;
+
+	auto InsertValues = [&]()
+	{
+		return InsertDictionaryValues(Dictionaries, ValueIdFromDictionary);
+	};
+
+	auto BuildRows = [&](FLoadPartition& Partition, const TArray<int32>& KeyIdFromColumn)
+	{
+		BuildInternedLoadPartitionRows(Partition, PreparedTransforms, ValueIdColumns, KeyIdFromColumn, ValueIdFromDictionary, ImportBounds);
+	};
+
+	if (!BulkInsertPartitions(ObjectName, PreparedTransforms.Num(), MetadataColumnNames, Partitions, InsertValues, BuildRows, Warn))
+	{
+		return false;
+	}
+
+	UE_LOG(PointCloudLog, Log, TEXT("Took %.2f Seconds to Insert Object\n"), Timer.ToSeconds());
+
+	return true;
+}
+
+bool UPointCloudImpl::InsertDictionaryValues(TArrayView<const TArray<FString>* const> Dictionaries, TArray<TArray<int32>>& OutValueIdFromDictionary)
+{
+	FPointCloudQuery InsertAttributeQuery(this);
+	InsertAttributeQuery.SetQuery(TEXT("INSERT OR IGNORE INTO AttributeValues VALUES(?);"));
+
+	InsertAttributeQuery.Begin();
+	for (const TArray<FString>* Dictionary : Dictionaries)
+	{
+		for (const FString& Value : *Dictionary)
+		{
+			FTCHARToUTF8 EchoStrUtf8(*Value);
+			TArray<char> UTF8Value(EchoStrUtf8.Get(), EchoStrUtf8.Length() + 1);
+			InsertAttributeQuery.Step(UTF8Value);
+		}
+	}
+	InsertAttributeQuery.End();
+
+	TMap<FString, FString> ValueKeys = GetValueMap<FString, FString>("SELECT rowid as ID,Value from AttributeValues", "Value", "ID");
+
+	OutValueIdFromDictionary.SetNum(Dictionaries.Num());
+	for (int32 DictionaryIndex = 0; DictionaryIndex < Dictionaries.Num(); ++DictionaryIndex)
 	{
-		UE_LOG(PointCloudLog, Log, TEXT("Incorrect number of metadata entries %d vs %d expected Points\n"), MetadataCountPerVertex.Num(), PreparedTransforms.Num());
-		return false;
+		const TArray<FString>& Dictionary = *Dictionaries[DictionaryIndex];
+
+		OutValueIdFromDictionary[DictionaryIndex].SetNumUninitialized(Dictionary.Num());
+		for (int32 DictionaryId = 0; DictionaryId < Dictionary.Num(); ++DictionaryId)
+		{
+			const FString* ValueId = ValueKeys.Find(Dictionary[DictionaryId]);
+			if (ValueId == nullptr)
+			{
+				UE_LOG(PointCloudLog, Warning, TEXT("Failed to insert metadata value %s\n"), *Dictionary[DictionaryId]);
+				return false;
+			}
+
+			OutValueIdFromDictionary[DictionaryIndex][DictionaryId] = FCString::Atoi(**ValueId);
+		}
 	}
 
-	PointCloud::UtilityTimer Timer;
+	return true;
+}
+
+bool UPointCloudImpl::BulkInsertPartitions(const FString& ObjectName,
+	int32 Count,
+	const TArray<FString>& MetadataColumnNames,
+	TArray<PointCloudPrivateNamespace::FLoadPartition>& Partitions,
+	TFunctionRef<bool()> InsertValues,
+	TFunctionRef<void(PointCloudPrivateNamespace::FLoadPartition&, const TArray<int32>&)> BuildRows,
+	FFeedbackContext* Warn)
+{
+	using namespace PointCloudPrivateNamespace;
 
 	InvalidateHash();
 
@@ -632,191 +1651,161 @@ bool UPointCloudImpl::InitFromPreparedData(const FString& ObjectName,
 
 	RUN_QUERY(FString::Printf(TEXT("INSERT INTO Object VALUES(\"%s\"); "), *ObjectName));
 
-	PointCloudPrivateNamespace::DropIndexes(this);
+	DropIndexes(this);
 
-	for (const FString& Name : MetadataColumnNames)
+	// Insert the keys and the distinct values, and build the mappings from the incoming data to the ids in the database
+	TArray<int32> KeyIdFromColumn;
 	{
-		if (RUN_QUERY(FString::Printf(TEXT("INSERT INTO AttributeKeys(Name) VALUES('%s');"), *Name)) == false)
+		FLoadPhaseTimer PhaseTimer(Stats, TEXT("Attributes"));
+
+		for (const FString& Name : MetadataColumnNames)
 		{
-			Holder.RollBack();
-			return false;
+			if (RUN_QUERY(FString::Printf(TEXT("INSERT INTO AttributeKeys(Name) VALUES('%s');"), *Name)) == false)
+			{
+				Holder.RollBack();
+				return false;
+			}
 		}
-	}
-
-	uint32 index = 0;
-
-	int Count = PreparedTransforms.Num();
-	int NumMetadataColumns = MetadataColumnNames.Num();
-
-	FPointCloudQuery InsertVertexQuery(this);
-	FPointCloudQuery InsertAttributeQuery(this);
-	FPointCloudQuery VertexToAttributeQuery(this);
-
-	FString Query;
 
-	FString GetObjectIdQuery = FString::Printf(TEXT("SELECT rowid as ID from Object where Name=\"%s\""), *ObjectName);
-	FString ObjectId = GetValue<FString>(GetObjectIdQuery, "ID");
+		// We now need to update the Key Ids in the incoming Metadata to refer to the DB ID's returned after inserting the attribute Keys
+		TMap<FString, FString> AttributeKeys = GetValueMap<FString, FString>("SELECT rowid as ID,Name from AttributeKeys", "Name", "ID");
 
-	Query += FString::Printf(TEXT("INSERT INTO Vertex(ObjectId, x,y,z,nx,ny,nz,nw,u,v,sx,sy,sz)  VALUES"));
-	Query += FString::Printf(TEXT("( %s, ?,?,?,?,?,?,?,0,0,?,?,?)"), *ObjectId);
-	InsertVertexQuery.SetQuery(Query);
-
-	Query = FString::Printf(TEXT("INSERT OR IGNORE INTO AttributeValues VALUES(?);"));
-	InsertAttributeQuery.SetQuery(Query);
+		KeyIdFromColumn.SetNum(MetadataColumnNames.Num());
+		for (int32 Column = 0; Column < MetadataColumnNames.Num(); ++Column)
+		{
+			KeyIdFromColumn[Column] = FCString::Atoi(*AttributeKeys[MetadataColumnNames[Column]]);
+		}
 
-	Query = FString::Printf(TEXT("INSERT INTO VertexToAttribute(vertex_id, key_id, value_id) VALUES(?,?,?)"));
-	VertexToAttributeQuery.SetQuery(Query);
+		if (!InsertValues())
+		{
+			Holder.RollBack();
+			return false;
+		}
+	}
 
-	TArray<float> VertexValues;
-	VertexValues.SetNum(10);
+	// Build the Vertex, VertexToAttribute and SpatialQuery rows for each partition in parallel
+	const int64 BaseRowId = GetValue<int64>("SELECT Max(rowid) from Vertex");
+	FBox NewPointBounds(EForceInit::ForceInit);
+	{
+		FLoadPhaseTimer PhaseTimer(Stats, TEXT("Prepare Rows"));
 
-	// We now need to update the Key Ids in the incoming Metadata to refer to the DB ID's returned after inserting the attribute Keys
-	TMap<FString, FString> AttributeKeys = GetValueMap<FString, FString>("SELECT rowid as ID,Name from AttributeKeys", "Name", "ID");
+		ParallelFor(Partitions.Num(), [&](int32 PartitionIndex)
+			{
+				BuildRows(Partitions[PartitionIndex], KeyIdFromColumn);
+			});
 
-	// Preconvert the String ID into an int so we don't have to do it in the loop
-	TMap<FString, int> AttributeKeysIndex;
+		int64 NextRowId = BaseRowId + 1;
+		for (FLoadPartition& Partition : Partitions)
+		{
+			Partition.FirstRowId = NextRowId;
+			NextRowId += Partition.NumVertices;
+			NewPointBounds += Partition.Bounds;
+		}
 
-	// Make a map from KeyName to Index In Database
-	for (const auto& a : AttributeKeys)
-	{
-		AttributeKeysIndex.Add(a.Key, FCString::Atoi(*a.Value));
+		// Order the new points along a Morton curve so the spatial index is built from spatially coherent inserts
+		ParallelFor(Partitions.Num(), [&](int32 PartitionIndex)
+			{
+				SortLoadPartitionSpatially(Partitions[PartitionIndex], NewPointBounds);
+			});
 	}
 
-	PointCloud::UtilityTimer InsertTimer;
-
-	// find the set of unique Metadata values
-	TSet<FString> MetadataValueSet;
-	for (const auto& Elem : PreparedMetadata)
+	int32 NumVertices = 0;
+	int64 NumAttributes = 0;
+	for (const FLoadPartition& Partition : Partitions)
 	{
-		MetadataValueSet.Add(Elem.Value);
+		NumVertices += Partition.NumVertices;
+		NumAttributes += Partition.AttributeRows.Num() / 3;
 	}
 
-	InsertAttributeQuery.Begin();
-	// now insert all of the Metadata values	
-	for (const FString& Value : MetadataValueSet)
+	// Merge the partitions into the database in order
 	{
-		FTCHARToUTF8 EchoStrUtf8(*Value);
-		TArray<char> UTF8Value(EchoStrUtf8.Get(), EchoStrUtf8.Length() + 1);
-		InsertAttributeQuery.Step(UTF8Value);
-	}
-	InsertAttributeQuery.End();
+		FLoadPhaseTimer PhaseTimer(Stats, TEXT("Insert Vertices"));
 
-	// Get the unique metadata DB ID's after inserting them all
-	TMap<FString, FString> ValueKeys = GetValueMap<FString, FString>("SELECT rowid as ID,Value from AttributeValues", "Value", "ID");
+		FString GetObjectIdQuery = FString::Printf(TEXT("SELECT rowid as ID from Object where Name=\"%s\""), *ObjectName);
+		FString ObjectId = GetValue<FString>(GetObjectIdQuery, "ID");
 
-	// Preconvert the String ID into an int so we don't have to do it in the loop
-	TMap<FString, int> ValueKeysIndex;
+		FPointCloudQuery InsertVertexQuery(this);
+		InsertVertexQuery.SetQuery(FString::Printf(TEXT("INSERT INTO Vertex(rowid, ObjectId, x,y,z,nx,ny,nz,nw,u,v,sx,sy,sz) VALUES(?, %s, ?,?,?,?,?,?,?,0,0,?,?,?)"), *ObjectId));
 
-	// Make a map from KeyName to Index In Database
-	for (const auto& a : ValueKeys)
-	{
-		ValueKeysIndex.Add(a.Key, FCString::Atoi(*a.Value));
-	}
+		int CurrentProgress = 40;
+		int ProgressShare = 20;
 
-	// Convert the incoming Metadata Key Ids and Values from those given, mapping to the incoming column names and values, to the IDs as stored in the DB
-	TArray<TPair<int, int>> PreparedMetadataIndices;
-	PreparedMetadataIndices.SetNum(PreparedMetadata.Num()); // we may not use all of these, but we want the elements to line up with the PreparedMetadata elements
-	ParallelFor(PreparedMetadata.Num(), [&](int32 i)
+		InsertVertexQuery.Begin();
+		for (int32 PartitionIndex = 0; PartitionIndex < Partitions.Num(); ++PartitionIndex)
 		{
-			int LocalColumnKey = PreparedMetadata[i].Key;
-			const FString& IncomingColumnName = MetadataColumnNames[LocalColumnKey];
-			int ColumnNameIndexInDb = AttributeKeysIndex[IncomingColumnName];
-			PreparedMetadataIndices[i].Key = ColumnNameIndexInDb;
-
-			const FString& IncomingValue = PreparedMetadata[i].Value;
-			int ValueIndexInDb = ValueKeysIndex[IncomingValue];
-			PreparedMetadataIndices[i].Value = ValueIndexInDb;
-		});
+			UpdateProgress(Warn, CurrentProgress + (PartitionIndex * ProgressShare) / Partitions.Num(), 100);
 
-	int CurrentProgress = 40;
-	int ProgressShare = 30;
-	int UpdateFreq = Count / ProgressShare;
+			const FLoadPartition& Partition = Partitions[PartitionIndex];
+			for (int32 Vertex = 0; Vertex < Partition.NumVertices; ++Vertex)
+			{
+				if (!InsertVertexQuery.Step(Partition.FirstRowId + Vertex, MakeArrayView(Partition.VertexRows.GetData() + Vertex * FLoadPartition::VertexRowSize, FLoadPartition::VertexRowSize)))
+				{
+					Holder.RollBack();
+					return false;
+				}
+			}
+		}
+		InsertVertexQuery.End();
+	}
 
-	if (UpdateFreq == 0)
 	{
-		UpdateFreq = 1;
-	}
+		FLoadPhaseTimer PhaseTimer(Stats, TEXT("Insert VertexToAttribute"));
 
-	int CurrentTopVertexRowId = GetValue<int>("SELECT Max(rowid) from Vertex");
-	int CurrentMetadataIndex = 0;
+		FPointCloudQuery VertexToAttributeQuery(this);
+		VertexToAttributeQuery.SetQuery(TEXT("INSERT INTO VertexToAttribute(vertex_id, key_id, value_id) VALUES(?,?,?)"));
 
-	InsertVertexQuery.Begin();
-	VertexToAttributeQuery.Begin();
+		int CurrentProgress = 60;
+		int ProgressShare = 15;
 
-	for (int Index = 0; Index < Count; Index++)
-	{
-		if ((Index % UpdateFreq) == 0)
+		VertexToAttributeQuery.Begin();
+		for (int32 PartitionIndex = 0; PartitionIndex < Partitions.Num(); ++PartitionIndex)
 		{
-			float Percent = Index / (float)Count;
-			int Progress = Percent * ProgressShare;
+			UpdateProgress(Warn, CurrentProgress + (PartitionIndex * ProgressShare) / Partitions.Num(), 100);
 
-			UpdateProgress(Warn, CurrentProgress + Progress, 100);
-		}
-
-		FTransform& Transform = PreparedTransforms[Index];
+			const FLoadPartition& Partition = Partitions[PartitionIndex];
+			for (int32 Row = 0; Row < Partition.AttributeRows.Num(); Row += 3)
+			{
+				const int64 RowId = Partition.FirstRowId + Partition.AttributeRows[Row];
 
-		if (ImportBounds.IsValid && !ImportBounds.IsInside(Transform.GetTranslation()))
-		{
-			// The given point is not within the bounding box, so skip it
-			continue;
+				if (!VertexToAttributeQuery.Step(RowId, Partition.AttributeRows[Row + 1], Partition.AttributeRows[Row + 2]))
+				{
+					Holder.RollBack();
+					return false;
+				}
+			}
 		}
+		VertexToAttributeQuery.End();
+	}
 
-		VertexValues[0] = Transform.GetTranslation().X;
-		VertexValues[1] = Transform.GetTranslation().Y;
-		VertexValues[2] = Transform.GetTranslation().Z;
-		VertexValues[3] = Transform.GetRotation().X;
-		VertexValues[4] = Transform.GetRotation().Y;
-		VertexValues[5] = Transform.GetRotation().Z;
-		VertexValues[6] = Transform.GetRotation().W;
-		VertexValues[7] = Transform.GetScale3D().X;
-		VertexValues[8] = Transform.GetScale3D().Y;
-		VertexValues[9] = Transform.GetScale3D().Z;
-
-#define CHECK_VALUE(Value, Message) if(FMath::IsFinite(VertexValues[Value])==false) UE_LOG(PointCloudLog, Warning, TEXT("Found Nan or Infinite on Vertex %d Value %hs"), Index, Message);
+	{
+		FLoadPhaseTimer PhaseTimer(Stats, TEXT("Spatial Index"));
 
-		CHECK_VALUE(0, "Translation.x");
-		CHECK_VALUE(1, "Translation.y");
-		CHECK_VALUE(2, "Translation.z");
-		CHECK_VALUE(3, "Rotation.x");
-		CHECK_VALUE(4, "Rotation.y");
-		CHECK_VALUE(5, "Rotation.z");
-		CHECK_VALUE(6, "Rotation.w");
-		CHECK_VALUE(7, "Scale.x");
-		CHECK_VALUE(8, "Scale.y");
-		CHECK_VALUE(9, "Scale.z");
+		RUN_QUERY("CREATE VIRTUAL TABLE if not exists SpatialQuery USING rtree(id, Minx , Maxx , Miny , Maxy , Minz, Maxz);");
+		UpdateProgress(Warn, 75, 100);
 
-#undef CHECK_VALUE
+		// Points that were already in the database need to go back into the index, DropIndexes removed them
+		if (BaseRowId > 0)
+		{
+			RUN_QUERY(FString::Printf(TEXT("INSERT INTO SpatialQuery SELECT rowid, x, x, y, y, z, z from Vertex WHERE rowid <= %lld"), BaseRowId));
+		}
 
-		if (!InsertVertexQuery.Step(VertexValues))
+		if (!InsertSpatialRows(this, Partitions))
 		{
 			Holder.RollBack();
 			return false;
 		}
 
-		CurrentTopVertexRowId++;
-
-		int32 IndexInToMetadata = Index * NumMetadataColumns;
-
-		for (int i = 0; i < MetadataCountPerVertex[Index]; ++i, ++CurrentMetadataIndex)
-		{
-			if (!VertexToAttributeQuery.Step(CurrentTopVertexRowId, PreparedMetadataIndices[CurrentMetadataIndex].Key, PreparedMetadataIndices[CurrentMetadataIndex].Value))
-			{
-				Holder.RollBack();
-				return false;
-			}
-		}
+		UpdateProgress(Warn, 85, 100);
 	}
 
-	InsertVertexQuery.End();
-	VertexToAttributeQuery.End();
-
-	InsertTimer.Report("Time To Insert Points");
-
-	PointCloudPrivateNamespace::CreateIndexes(this, Warn);
+	{
+		FLoadPhaseTimer PhaseTimer(Stats, TEXT("Attribute Indexes"));
+		CreateIndexes(this, Warn, false);
+	}
 
 	if (Holder.EndTransaction())
 	{
-		UE_LOG(PointCloudLog, Log, TEXT("Inserted %d Points and %d Attributes\n"), PreparedTransforms.Num(), PreparedMetadata.Num());
+		UE_LOG(PointCloudLog, Log, TEXT("Inserted %d Points and %lld Attributes\n"), NumVertices, NumAttributes);
 	}
 	else
 	{
@@ -825,10 +1814,20 @@ bool UPointCloudImpl::InitFromPreparedData(const FString& ObjectName,
 		return false;
 	}
 
-	UE_LOG(PointCloudLog, Log, TEXT("Took %.2f Seconds to Insert Object\n"), Timer.ToSeconds());
+	if (Stats.IsValid())
+	{
+		Stats->AddToCounter(TEXT("PointCloud Load Points"), NumVertices);
+		Stats->AddToCounter(TEXT("PointCloud Load Skipped Points"), Count - NumVertices);
+		Stats->AddToCounter(TEXT("PointCloud Load Attributes"), NumAttributes);
+		Stats->AddToCounter(TEXT("PointCloud Load Partitions"), Partitions.Num());
+	}
 
-	// Calculate the hash of the database
-	CalculateWholeDbHash();
+	// Calculate the hash of the database, only the blocks the new points went into are read back
+	{
+		FLoadPhaseTimer PhaseTimer(Stats, TEXT("Hash"));
+		MarkVertexBlocksDirty(BaseRowId + 1, BaseRowId + NumVertices);
+		CalculateWholeDbHash();
+	}
 
 	return true;
 }
@@ -905,7 +1904,7 @@ namespace
 	}
 
 
-	void PrepareTransforms(int32 Count, bool FlipW, TMap<FString, TArray<FString> >& DefaultColumnValues, TArray<FTransform>& PreparedTransforms)
+	void PrepareTransforms(int32 Count, bool FlipW, TMap<FString, TArray<float> >& DefaultColumnValues, TArray<FTransform>& PreparedTransforms)
 	{
 		PointCloud::UtilityTimer Timer;
 		// Use a parallel for loop to prepare all of the transforms		
@@ -924,7 +1923,7 @@ namespace
 		const int32 SY_Index = 8;
 		const int32 SZ_Index = 9;
 
-		TArray< TArray<FString>*> ColumnPtrs;
+		TArray< TArray<float>*> ColumnPtrs;
 		ColumnPtrs.SetNum(DefaultColumnValues.Num());
 
 		ColumnPtrs[NX_Index] = DefaultColumnValues.Find("nx");
@@ -942,22 +1941,22 @@ namespace
 
 		ParallelFor(Count, [&](int32 Index)
 			{
-				float RotX = FCString::Atof(*ColumnPtrs[NX_Index]->operator[](Index));
-				float RotY = FCString::Atof(*ColumnPtrs[NY_Index]->operator[](Index));
-				float RotZ = FCString::Atof(*ColumnPtrs[NZ_Index]->operator[](Index));
-				float RotW = FCString::Atof(*ColumnPtrs[NW_Index]->operator[](Index));
+				float RotX = ColumnPtrs[NX_Index]->operator[](Index);
+				float RotY = ColumnPtrs[NY_Index]->operator[](Index);
+				float RotZ = ColumnPtrs[NZ_Index]->operator[](Index);
+				float RotW = ColumnPtrs[NW_Index]->operator[](Index);
 
 				if (FlipW)
 				{
 					RotW = -RotW;
 				}
 
-				float ScaleX = FCString::Atof(*ColumnPtrs[SX_Index]->operator[](Index));
-				float ScaleY = FCString::Atof(*ColumnPtrs[SY_Index]->operator[](Index));
-				float ScaleZ = FCString::Atof(*ColumnPtrs[SZ_Index]->operator[](Index));
-				float PosX = FCString::Atof(*ColumnPtrs[PX_Index]->operator[](Index));
-				float PosY = FCString::Atof(*ColumnPtrs[PY_Index]->operator[](Index));
-				float PosZ = FCString::Atof(*ColumnPtrs[PZ_Index]->operator[](Index));
+				float ScaleX = ColumnPtrs[SX_Index]->operator[](Index);
+				float ScaleY = ColumnPtrs[SY_Index]->operator[](Index);
+				float ScaleZ = ColumnPtrs[SZ_Index]->operator[](Index);
+				float PosX = ColumnPtrs[PX_Index]->operator[](Index);
+				float PosY = ColumnPtrs[PY_Index]->operator[](Index);
+				float PosZ = ColumnPtrs[PZ_Index]->operator[](Index);
 
 				FQuat Q(RotX, RotY, RotZ, RotW);
 				Q.Normalize();
@@ -968,7 +1967,7 @@ namespace
 		Timer.Report("Prepare Transforms");
 	}
 
-	bool HasColumn(const FString& Name, const TMap<FString, TArray<FString> >& Data)
+	bool HasColumn(const FString& Name, const TMap<FString, TArray<float> >& Data)
 	{
 
 		bool Found = Data.Contains(Name);
@@ -983,9 +1982,9 @@ namespace
 	bool ProcessCsvPrepared(
 		UPointCloudImpl* Cloud,
 		const FString& FileName,
-		TMap<FString, TArray<FString> >& DefaultColumnValues,
-		TMap<FString, TArray<FString > >& MetadataColumnValues,
-		TSet<FString>& MetadataColumnNames,
+		TMap<FString, TArray<float> >& DefaultColumnValues,
+		const FPointCloudCsv& Doc,
+		TArray<FString>& ArrayOfColumnNames,
 		bool FlipW,
 		const FBox& ImportBounds,
 		FFeedbackContext* Warn)
@@ -1019,21 +2018,21 @@ namespace
 		TArray<FTransform> PreparedTransforms;
 		PrepareTransforms(Count, FlipW, DefaultColumnValues, PreparedTransforms);
 
-		TArray<FString> ArrayOfColumnNames = MetadataColumnNames.Array();// Make a mapping 
+		// The transforms hold everything the default columns did
+		DefaultColumnValues.Empty();
+
+		// The interned metadata columns are inserted by dictionary id, so the per point values are never expanded into strings
+		TArray<const TArray<int32>*> ValueIdColumns;
+		TArray<const TArray<FString>*> Dictionaries;
+		ValueIdColumns.SetNum(ArrayOfColumnNames.Num());
+		Dictionaries.SetNum(ArrayOfColumnNames.Num());
 
-		// We need to easily map between the KeyName as a string and the Index in the ArrayOfColumnNames 
-		TMap<FString, int> AttributeKeys;
-		for (int i = 0; i < ArrayOfColumnNames.Num(); i++)
+		for (int32 i = 0; i < ArrayOfColumnNames.Num(); i++)
 		{
-			AttributeKeys.Add(ArrayOfColumnNames[i], i);
+			verify(Doc.GetInternedColumn(ArrayOfColumnNames[i], ValueIdColumns[i], Dictionaries[i]));
 		}
 
-		// We need to prepare a UTF-8, santized version of each Metadata Value
-		TArray< TPair<int, FString> > PreparedMetadata;
-		TArray<int> MetadataCountPerVertex;
-		PrepareMetadata(Count, AttributeKeys, MetadataColumnValues, PreparedMetadata, MetadataCountPerVertex);
-
-		bool ReturnValue = Cloud->InitFromPreparedData(FileName, PreparedTransforms, ArrayOfColumnNames, MetadataCountPerVertex, PreparedMetadata, ImportBounds, Warn);
+		bool ReturnValue = Cloud->InitFromInternedColumns(FileName, PreparedTransforms, ArrayOfColumnNames, ValueIdColumns, Dictionaries, ImportBounds, Warn);
 
 		Timer.Report("Time To Insert Points");
 
@@ -1135,6 +2134,11 @@ bool UPointCloudImpl::SaveToDisk(const FString& FileName)
 		return false;
 	}
 
+	if (FPaths::GetExtension(FileName).ToLower() == TEXT("pcc"))
+	{
+		return SaveToColumnar(FileName);
+	}
+
 	int Rc = loadOrSaveDb(InternalDatabase, TCHAR_TO_ANSI(*FileName), 1);
 
 	if (Rc == SQLITE_OK)
@@ -1152,6 +2156,100 @@ bool UPointCloudImpl::SaveToDisk(const FString& FileName)
 #endif
 }
 
+bool UPointCloudImpl::SaveToColumnar(const FString& FileName)
+{
+	if (!IsInitialized())
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("SaveToColumnar : Not Initialized %s\n"), *FileName);
+		return false;
+	}
+
+	PointCloud::UtilityTimer Timer;
+
+	TArray<TPair<int, FTransform>> IdsAndTransforms = GetValuePairArray<int, FTransform>(TEXT("SELECT rowid as Id, x, y, z, nx, ny, nz, nw, sx, sy, sz FROM Vertex ORDER BY rowid"));
+	TMap<int, FString> AttributeKeys = GetValueMap<int, FString>(TEXT("SELECT rowid as ID, Name from AttributeKeys"), TEXT("ID"), TEXT("Name"));
+	TMap<int, FString> AttributeValues = GetValueMap<int, FString>(TEXT("SELECT rowid as ID, Value from AttributeValues"), TEXT("ID"), TEXT("Value"));
+	TArray<TArray<int>> VertexToAttribute = GetValueArray<TArray<int>>(TEXT("SELECT vertex_id, key_id, value_id FROM VertexToAttribute"), TArray<FString>({ TEXT("vertex_id"), TEXT("key_id"), TEXT("value_id") }));
+
+	Timer.Report(TEXT("SaveToColumnar Read Database"));
+
+	TArray<FTransform> Transforms;
+	TMap<int, int32> PointIndexFromVertexId;
+	Transforms.Reserve(IdsAndTransforms.Num());
+	PointIndexFromVertexId.Reserve(IdsAndTransforms.Num());
+
+	for (const TPair<int, FTransform>& IdAndTransform : IdsAndTransforms)
+	{
+		PointIndexFromVertexId.Add(IdAndTransform.Key, Transforms.Add(IdAndTransform.Value));
+	}
+
+	TArray<FString> MetadataColumnNames;
+	TMap<int, int> ColumnIndexFromKeyId;
+
+	for (const TPair<int, FString>& Key : AttributeKeys)
+	{
+		ColumnIndexFromKeyId.Add(Key.Key, MetadataColumnNames.Add(Key.Value));
+	}
+
+	// Count the metadata entries for each point, then place each entry in its point's range so the layout matches InitFromPreparedData
+	TArray<int> MetadataCountPerVertex;
+	MetadataCountPerVertex.SetNumZeroed(Transforms.Num());
+
+	for (const TArray<int>& Row : VertexToAttribute)
+	{
+		if (const int32* PointIndex = PointIndexFromVertexId.Find(Row[0]))
+		{
+			MetadataCountPerVertex[*PointIndex]++;
+		}
+	}
+
+	TArray<int> MetadataStart;
+	MetadataStart.SetNumUninitialized(Transforms.Num());
+
+	int MetadataTotal = 0;
+	for (int32 PointIndex = 0; PointIndex < Transforms.Num(); ++PointIndex)
+	{
+		MetadataStart[PointIndex] = MetadataTotal;
+		MetadataTotal += MetadataCountPerVertex[PointIndex];
+	}
+
+	TArray<TPair<int, FString>> PreparedMetadata;
+	PreparedMetadata.SetNum(MetadataTotal);
+
+	for (const TArray<int>& Row : VertexToAttribute)
+	{
+		const int32* PointIndex = PointIndexFromVertexId.Find(Row[0]);
+		const int* ColumnIndex = ColumnIndexFromKeyId.Find(Row[1]);
+		const FString* Value = AttributeValues.Find(Row[2]);
+
+		if (PointIndex == nullptr || ColumnIndex == nullptr || Value == nullptr)
+		{
+			UE_LOG(PointCloudLog, Warning, TEXT("SaveToColumnar : Inconsistent metadata for vertex %d\n"), Row[0]);
+			return false;
+		}
+
+		PreparedMetadata[MetadataStart[*PointIndex]++] = TPair<int, FString>(*ColumnIndex, *Value);
+	}
+
+	FPointCloudColumnarStore Store;
+
+	if (!Store.InitFromPreparedData(Transforms, MetadataColumnNames, MetadataCountPerVertex, PreparedMetadata))
+	{
+		return false;
+	}
+
+	const bool bSaved = Store.SaveToFile(FileName);
+
+	if (bSaved)
+	{
+		UE_LOG(PointCloudLog, Log, TEXT("SaveToColumnar : Saved %d points to %s\n"), Store.Num(), *FileName);
+	}
+
+	Timer.Report(TEXT("SaveToColumnar"));
+
+	return bSaved;
+}
+
 void UPointCloudImpl::OptimizeIfRequired()
 {
 	// for the moment always call analyze	
@@ -1168,7 +2266,6 @@ bool UPointCloudImpl::LoadFromCsv(const FString& FileName, const FBox& InImportB
 	}
 
 	PointCloud::UtilityTimer Timer;
-	FPointCloudCsv doc = FPointCloudCsv::Open(FileName, Warn);
 
 	FString SQLiteVersion = GetValue<FString>("select sqlite_version() as VERSION", "VERSION");
 
@@ -1185,15 +2282,8 @@ bool UPointCloudImpl::LoadFromCsv(const FString& FileName, const FBox& InImportB
 
 	UpdateProgress(Warn, 10, 100);
 
-	if (doc.GetIsOpen() == false)
-	{
-		UE_LOG(PointCloudLog, Log, TEXT("Cannot read from stream for CSV: %s\n"), *FileName);
-		return false;
-	}
-
-	TMap<FString, TArray<FString> >			DefaultColumnValues;
-	TMap<FString, TArray<FString > >		MetadataColumnValues;
-	TSet<FString>							MetadataColumnNames;
+	TMap<FString, TArray<float> >			DefaultColumnValues;
+	TArray<FString>							MetadataColumnNames;
 
 	UE_LOG(PointCloudLog, Log, TEXT("Reading CSV: %s\n"), *FileName);
 
@@ -1229,6 +2319,21 @@ bool UPointCloudImpl::LoadFromCsv(const FString& FileName, const FBox& InImportB
 					TTuple<FString, FString>(FString("sz"), FString("1.0")),
 	};
 
+	// The default columns are parsed straight to numbers, everything else is metadata and is interned
+	TSet<FString> NumericColumns;
+	for (const auto& i : DefaultColumns)
+	{
+		NumericColumns.Add(i.Key);
+	}
+
+	FPointCloudCsv doc = FPointCloudCsv::OpenStreaming(FileName, NumericColumns, Warn);
+
+	if (doc.GetIsOpen() == false)
+	{
+		UE_LOG(PointCloudLog, Log, TEXT("Cannot read from stream for CSV: %s\n"), *FileName);
+		return false;
+	}
+
 	UpdateProgress(Warn, 20, 100);
 
 	// Try and read in the default columns
@@ -1236,10 +2341,10 @@ bool UPointCloudImpl::LoadFromCsv(const FString& FileName, const FBox& InImportB
 	{
 		if (!PointCloudPrivateNamespace::TryTakeColumn(doc, i.Key, i.Value, DefaultColumnValues))
 		{
-			// if the column can't be loaded, created an entry with the default values. Not very efficient but will do for now.
-			FString DefaultValue = DefaultValues[i.Value];
+			// if the column can't be loaded, created an entry with the default values
+			float DefaultValue = FCString::Atof(*DefaultValues[i.Value]);
 
-			TArray<FString> Defaults;
+			TArray<float> Defaults;
 
 			Defaults.Init(DefaultValue, doc.GetRowCount());
 
@@ -1261,12 +2366,12 @@ bool UPointCloudImpl::LoadFromCsv(const FString& FileName, const FBox& InImportB
 			// load it into the Metadata columns
 			UE_LOG(PointCloudLog, Log, TEXT("Metadata Colmun %s\n"), *ColumnName);
 
-			TArray<FString>* Column = doc.GetColumn(ColumnName);
+			const TArray<int32>* ValueIds = nullptr;
+			const TArray<FString>* Values = nullptr;
 
-			if (Column != nullptr)
+			if (doc.GetInternedColumn(ColumnName, ValueIds, Values))
 			{
-				MetadataColumnValues.Add(ColumnName, MoveTemp(*Column));
-				MetadataColumnNames.Add(ColumnName);
+				MetadataColumnNames.AddUnique(ColumnName);
 			}
 			else
 			{
@@ -1283,7 +2388,7 @@ bool UPointCloudImpl::LoadFromCsv(const FString& FileName, const FBox& InImportB
 	bool Result = ProcessCsvPrepared(this,
 		FileName,
 		DefaultColumnValues,
-		MetadataColumnValues,
+		doc,
 		MetadataColumnNames, true,
 		InImportBounds,
 		Warn);
@@ -1396,6 +2501,28 @@ bool UPointCloudImpl::LoadFromStructuredPoints(const TArray<FPointCloudPoint>& I
 	return InitFromPreparedData(FString(), PreparedTransforms, MetadataColumnNames, MetadataCountPerVertex, PreparedMetadata, InImportBounds, Warn);
 }
 
+bool UPointCloudImpl::LoadFromColumnar(const FString& FileName, const FBox& InImportBounds, ELoadMode Mode, FFeedbackContext* Warn)
+{
+	PointCloud::UtilityTimer Timer;
+
+	FPointCloudColumnarStore Store;
+
+	if (!Store.LoadFromFile(FileName))
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Failed to open %s: Not a valid columnar point cloud file."), *FileName);
+		return false;
+	}
+
+	UE_LOG(PointCloudLog, Log, TEXT("Reading Columnar Point Cloud: %s, %d points (%s)\n"), *FileName, Store.Num(), Store.IsMapped() ? TEXT("Mapped") : TEXT("Loaded"));
+
+	Timer.Report(TEXT("Read Columnar File"));
+
+	UpdateProgress(Warn, 40, 100);
+
+	// The columns are read in place while the rows are built, so the file stays mapped until the insert is done
+	return InitFromColumnarStore(FileName, Store, InImportBounds, Warn);
+}
+
 int32 UPointCloudImpl::GetTemporaryTableCacheSize()
 {
 	// Magic Number alert. This is a method for the moment but it may become dynamic down the line, hence using a method 
@@ -1403,6 +2530,20 @@ int32 UPointCloudImpl::GetTemporaryTableCacheSize()
 	return 5000;
 }
 
+int64 UPointCloudImpl::GetTemporaryTableMemoryBudget()
+{
+	// Magic Number alert. Temporary tables live in the in-memory database alongside the point cloud, this keeps them from growing
+	// without bounds on large point clouds, where a single filter table can hold millions of ids
+	return 1024ll * 1024 * 1024;
+}
+
+int64 UPointCloudImpl::GetTemporaryTableBytesPerRow()
+{
+	// Heuristic size of a row of a temporary table, most only hold an integer id, including the b-tree overhead. Wider tables,
+	// such as the attribute tables holding an id and a value id, take more than this
+	return 16;
+}
+
 namespace
 {
 #if WITH_EDITOR
@@ -1498,7 +2639,8 @@ bool UPointCloudImpl::ReloadInternal(const TArray<FString >& Files, const FBox&
 {
 	PointCloud::UtilityTimer Timer;
 
-	// create a new database and store the original
+	// create a new database and store the original. Cached statements were prepared on the original, which is closed on success
+	PreparedStatements.Reset();
 	sqlite3* CopyInternalDatabase = InternalDatabase;
 
 	InternalDatabase = nullptr;
@@ -1530,6 +2672,10 @@ bool UPointCloudImpl::ReloadInternal(const TArray<FString >& Files, const FBox&
 		{
 			Sucess = LoadFromAlembic(FileName, ImportBounds, UPointCloud::ELoadMode::ADD, nullptr);
 		}
+		else if (Extension == "pcc")
+		{
+			Sucess = LoadFromColumnar(FileName, ImportBounds, UPointCloud::ELoadMode::ADD, nullptr);
+		}
 		else
 		{
 			UE_LOG(PointCloudLog, Log, TEXT("Unrecognised File Type : %s\n"), *Extension);
@@ -1546,6 +2692,9 @@ bool UPointCloudImpl::ReloadInternal(const TArray<FString >& Files, const FBox&
 	{
 		sqlite3_close(InternalDatabase);
 		InternalDatabase = CopyInternalDatabase;
+
+		// The block hashes were reset for the new database
+		InvalidateHash(/*bContentChanged=*/true);
 	}
 	else
 	{
@@ -1619,6 +2768,9 @@ void UPointCloudImpl::InitDb()
 		return;
 	}
 
+	// Keep the main database in a single resizeable buffer, as deserialized databases are, so that it can be saved without copying it
+	sqlite3_deserialize(InternalDatabase, "main", nullptr, 0, 0, SQLITE_DESERIALIZE_FREEONCLOSE | SQLITE_DESERIALIZE_RESIZEABLE);
+
 	// This bit of Dark Voodoo is required because there is a poorly documented default limit to 
 	// the maximum size of in-memory databases that can be deserialized. Phew. That limit is by default
 	// 1Gb. This totally removes that limit. I'm still not sure that in memory DBs over 2GB are supported due to 
@@ -1648,6 +2800,9 @@ void UPointCloudImpl::InitDb()
 		InternalDatabase = 0;
 	}
 
+	// The block hashes refer to the previous database, if any
+	InvalidateHash(/*bContentChanged=*/true);
+
 	// This needs to be called now to set the internal Schema Version 
 	EPointCloudSchemaVersions Version = GetSchemaVersion();
 
@@ -1661,6 +2816,7 @@ void UPointCloudImpl::Serialize(FArchive& Ar)
 	Super::Serialize(Ar);
 
 	Ar.UsingCustomVersion(FUE5MainStreamObjectVersion::GUID);
+	Ar.UsingCustomVersion(FPointCloudCustomVersion::GUID);
 
 	if (Ar.IsSaving())
 	{
@@ -1858,13 +3014,26 @@ void UPointCloudImpl::SerializeDb(FArchive& Ar)
 	// sqlite3_serialize will fail to create the buffer for databases above this size. 
 	static unsigned int MAX_SQLITE_ALLOC_SIZE = 0x7fffff00;
 
+	// Databases that were deserialized already live in a single buffer, which can be written out without a copy
+	bool bNoCopy = true;
 	unsigned char* Data = sqlite3_serialize(
 		InternalDatabase,           /* The database connection */
 		"main",						/* Which DB to serialize. ex: "main", "temp", ... */
 		&piSize,					/* Write size of the DB here, if not NULL */
-		0							/* Zero or more SQLITE_SERIALIZE_* flags */
+		SQLITE_SERIALIZE_NOCOPY		/* Zero or more SQLITE_SERIALIZE_* flags */
 	);
 
+	if (Data == nullptr)
+	{
+		bNoCopy = false;
+		Data = sqlite3_serialize(
+			InternalDatabase,           /* The database connection */
+			"main",						/* Which DB to serialize. ex: "main", "temp", ... */
+			&piSize,					/* Write size of the DB here, if not NULL */
+			0							/* Zero or more SQLITE_SERIALIZE_* flags */
+		);
+	}
+
 #if WITH_EDITOR
 
 	// If no data was allocated and the reported size is above the maximum allocatable size
@@ -1916,26 +3085,44 @@ void UPointCloudImpl::SerializeDb(FArchive& Ar)
 	if (piSize == 0)
 	{
 		UE_LOG(PointCloudLog, Log, TEXT("Zero Sized Data return from sqlite3_serialize"));
-		sqlite3_free(static_cast<void*>(Data));
+		if (!bNoCopy)
+		{
+			sqlite3_free(static_cast<void*>(Data));
+		}
 		return;
 	}
 
 	if (Data == nullptr)
 	{
 		UE_LOG(PointCloudLog, Log, TEXT("Null Ptr Returned from sqlite3_serialize"));
-		sqlite3_free(static_cast<void*>(Data));
 		return;
 	}
 
-	// Use this oppertunity to calculate the hash if the data is out of date
-	CalculateWholeDbHash(Data, piSize);
+	// Calculate the hash if the data is out of date, this only reads back the vertex blocks that changed
+	CalculateWholeDbHash();
+
+	// Compress and write the database a few chunks at a time, rather than compressing it all into another buffer first
+	FPointCloudDatabaseStream::FStreamStats StreamStats;
+	if (!FPointCloudDatabaseStream::Save(Ar, Data, (int64)piSize, FPointCloudDatabaseStream::FSettings(), &StreamStats))
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Failed To Write Rule Processor Asset"));
+		Ar.SetCriticalError();
+	}
 
-	int64 Size = (int64)piSize;
-	Ar << Size;
-	Ar.SerializeCompressedNew(Data, Size);
 	Ar.Serialize(WholeDbHash.m_digest, WholeDbHash.DigestSize);
 
-	sqlite3_free(static_cast<void*>(Data));
+	if (Stats.IsValid())
+	{
+		Stats->AddToCounter(TEXT("PointCloud Serialize Bytes"), (int64)piSize);
+		Stats->AddToCounter(TEXT("PointCloud Serialize Compressed Bytes"), StreamStats.CompressedBytes);
+		Stats->AddToCounter(TEXT("PointCloud Serialize Peak Scratch Bytes"), StreamStats.PeakScratchBytes);
+	}
+
+	// Buffers returned with SQLITE_SERIALIZE_NOCOPY still belong to the database
+	if (!bNoCopy)
+	{
+		sqlite3_free(static_cast<void*>(Data));
+	}
 }
 
 // copy the Serialized database into the internal;
@@ -1951,22 +3138,69 @@ void UPointCloudImpl::DeSerializeDb(FArchive& Ar)
 	PointCloud::UtilityTimer Timer;
 
 	int64 Size = 0;
-	Ar << Size;
-	uint8* Copy = static_cast<uint8*>(FMemory::Malloc(Size * 2)); //note: we do not use sqlite3_malloc64 here, because it fails for allocations over 32b.
-	Ar.SerializeCompressedNew(Copy, Size);
-	Ar.Serialize(WholeDbHash.m_digest, WholeDbHash.DigestSize);
+	uint8* Copy = nullptr;
+
+	// The database is resizeable, so sqlite grows the buffer itself if points are added later rather than us reserving twice the size up front
+	if (Ar.CustomVer(FPointCloudCustomVersion::GUID) >= FPointCloudCustomVersion::StreamedDatabase)
+	{
+		// The chunks are decompressed straight into the database buffer, a few at a time
+		FPointCloudDatabaseStream::FHeader Header;
+		if (!FPointCloudDatabaseStream::LoadHeader(Ar, Header))
+		{
+			return;
+		}
+
+		Size = Header.Size;
+		Copy = static_cast<uint8*>(FMemory::Malloc(Size)); //note: we do not use sqlite3_malloc64 here, because it fails for allocations over 32b.
+
+		FPointCloudDatabaseStream::FStreamStats StreamStats;
+		if (!FPointCloudDatabaseStream::LoadChunks(Ar, Header, Copy, FPointCloudDatabaseStream::FSettings().MaxChunksInFlight, &StreamStats))
+		{
+			FMemory::Free(Copy);
+			return;
+		}
+
+		if (Stats.IsValid())
+		{
+			Stats->AddToCounter(TEXT("PointCloud Deserialize Bytes"), Size);
+			Stats->AddToCounter(TEXT("PointCloud Deserialize Peak Scratch Bytes"), StreamStats.PeakScratchBytes);
+		}
+	}
+	else
+	{
+		Ar << Size;
+		Copy = static_cast<uint8*>(FMemory::Malloc(Size)); //note: we do not use sqlite3_malloc64 here, because it fails for allocations over 32b.
+		Ar.SerializeCompressedNew(Copy, Size);
+	}
+
+	{
+		// Keep the hash that was saved with the database, the block hashes are only calculated if it changes
+		FScopeLock Lock(&HashLock);
+		Ar.Serialize(WholeDbHash.m_digest, WholeDbHash.DigestSize);
+		bVertexBlockHashesValid = false;
+
+		// Older assets saved a hash made a different way, which would never match one calculated now. Recalculate it below
+		if (Ar.CustomVer(FPointCloudCustomVersion::GUID) < FPointCloudCustomVersion::BlockTreeHash)
+		{
+			WholeDbHash.Reset();
+		}
+	}
 
-	// Calculate the hash of the database on loading to ensure it is up to date	
+	InvalidateSpatialIndex();
 
 	int rc = sqlite3_deserialize(
 		InternalDatabase,				/* The database connection */
 		"main",							/* Which DB to reopen with the deserialization */
 		Copy,							/* The serialized database content */
 		Size,							/* Number bytes in the deserialization */
-		Size * 2,							/* Total size of buffer pData[] */
+		Size,							/* Total size of buffer pData[] */
 		SQLITE_DESERIALIZE_FREEONCLOSE | SQLITE_DESERIALIZE_RESIZEABLE
 	);
 
+	// Deserializing resets the size limit of the database, see InitDb
+	int64 MaxSize = TNumericLimits<int64>::Max();
+	sqlite3_file_control(InternalDatabase, "main", SQLITE_FCNTL_SIZE_LIMIT, &MaxSize);
+
 	if (NeedsUpdating())
 	{
 		UE_LOG(PointCloudLog, Warning, TEXT("Point Cloud '%s' Uses An Old Schema (PointCloud=%d Current=%d), Please Update Or Recreate"), *GetPathName(), SchemaVersion, GetLatestSchemaVersion());
@@ -1974,8 +3208,8 @@ void UPointCloudImpl::DeSerializeDb(FArchive& Ar)
 
 	OptimizeIfRequired();
 
-	// Calculate the hash if required
-	CalculateWholeDbHash(Copy, Size);
+	// Calculate the hash if required, which is the case for assets saved without one or with an older kind of hash
+	CalculateWholeDbHash();
 
 	Timer.Report(TEXT("Deserialize"));
 }
@@ -1993,9 +3227,9 @@ namespace
 	}
 }
 
-bool UPointCloudImpl::RunQuery(const FString& Query, int (*Callback)(void*, int, char**, char**), void* UsrData, const FString& InOriginatingFile, const uint32 InOriginatingLine)
+bool UPointCloudImpl::RunQuery(const FString& Query, int (*Callback)(void*, int, char**, char**), void* UsrData, const FString& InOriginatingFile, const uint32 InOriginatingLine, FPointCloudStatId InStatId)
 {
-	PointCloud::QueryLogger(this, Query, FString(), InOriginatingFile, InOriginatingLine);
+	PointCloud::QueryLogger Logger(this, Query, FString(), InOriginatingFile, InOriginatingLine, InStatId);
 	return RunQueryInternal(Query, Callback, UsrData);
 }
 
@@ -2026,9 +3260,9 @@ bool UPointCloudImpl::RunQueryInternal(const FString& Query, int (*Callback)(voi
 	return true;
 }
 
-bool UPointCloudImpl::RunQuery(const FString& Query, const FString& InOriginatingFile, const uint32 InOriginatingLine)
+bool UPointCloudImpl::RunQuery(const FString& Query, const FString& InOriginatingFile, const uint32 InOriginatingLine, FPointCloudStatId InStatId)
 {
-	PointCloud::QueryLogger(this, Query, FString(), InOriginatingFile, InOriginatingLine);
+	PointCloud::QueryLogger Logger(this, Query, FString(), InOriginatingFile, InOriginatingLine, InStatId);
 	return RunQueryInternal(Query);
 }
 
@@ -2052,12 +3286,11 @@ void UPointCloudImpl::GetValues(const FString& Query, const TArray<FString>& Col
 
 	LOG_QUERY(Query);
 
-	sqlite3_stmt* stmt = nullptr;
-
-	// execute statement
-	int retval = sqlite3_prepare_v2(InternalDatabase, TCHAR_TO_ANSI(*Query), -1, &stmt, 0);
+	// execute statement, reusing the statement prepared the last time the same query was run
+	int retval = SQLITE_OK;
+	sqlite3_stmt* stmt = PreparedStatements.Acquire(InternalDatabase, Query, retval);
 
-	if (retval)
+	if (stmt == nullptr)
 	{
 		UE_LOG(PointCloudLog, Warning, TEXT("Error Fetching Value (%d) : %s (%s)\n"), retval, ANSI_TO_TCHAR(sqlite3_errmsg(InternalDatabase)), (*Query));
 		return;
@@ -2097,7 +3330,7 @@ void UPointCloudImpl::GetValues(const FString& Query, const TArray<FString>& Col
 				else
 				{
 					UE_LOG(PointCloudLog, Warning, TEXT("Column Not Found (%s)\n"), *ColumnName);
-					sqlite3_finalize(stmt);
+					PreparedStatements.Release(Query, stmt);
 					return;
 				}
 			}
@@ -2133,7 +3366,7 @@ void UPointCloudImpl::GetValues(const FString& Query, const TArray<FString>& Col
 		}
 	}
 
-	sqlite3_finalize(stmt);
+	PreparedStatements.Release(Query, stmt);
 }
 
 // Undef convenience macros
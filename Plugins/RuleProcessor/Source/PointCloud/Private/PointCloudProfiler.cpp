@@ -0,0 +1,577 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PointCloudProfiler.h"
+#include "PointCloudSliceAndDiceRule.h"
+#include "PointCloudSliceAndDiceRuleInstance.h"
+#include "PointCloudStats.h"
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeRWLock.h"
+#include "Misc/StringBuilder.h"
+
+#include <atomic>
+
+bool FPointCloudProfiler::bEnabled = false;
+
+static TAutoConsoleVariable<int32> CVarProfile(
+	TEXT("t.RuleProcessor.Profile"),
+	0,
+	TEXT("If non-zero, rule execution, queries and temporary tables are profiled, and a Chrome trace and a CSV summary are saved to the Profiling directory after each execution."),
+	FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Variable) { FPointCloudProfiler::SetEnabled(Variable->GetInt() != 0); }));
+
+static TAutoConsoleVariable<int32> CVarProfileBufferSize(
+	TEXT("t.RuleProcessor.Profile.BufferSize"),
+	1 << 18,
+	TEXT("Number of events each thread keeps while profiling, rounded up to a power of two. Older events are overwritten once a thread records more."));
+
+namespace PointCloudProfilerPrivate
+{
+	enum class EEventType : uint8
+	{
+		Scope,
+		Counter
+	};
+
+	struct FEvent
+	{
+		uint64 BeginCycles;
+		uint64 EndCycles;
+		int64 Value;
+		UPTRINT RuleInstance;
+		int32 Path;
+		uint16 Depth;
+		EEventType Type;
+	};
+
+	/** A node of the scope tree: a stat nested in the path of its parent */
+	struct FPathNode
+	{
+		int32 Parent;
+		FPointCloudStatId StatId;
+	};
+
+	/** An open scope of a thread */
+	struct FStackEntry
+	{
+		int32 Path;
+		UPTRINT RuleInstance;
+	};
+
+	/** Events of a thread. Only the thread writes to it, other threads only read the events published by WriteIndex */
+	struct FThreadBuffer
+	{
+		uint32 ThreadId = 0;
+		FString ThreadName;
+
+		TArray<FEvent> Events;
+		uint64 Mask = 0;
+		std::atomic<uint64> WriteIndex{ 0 };
+
+		// Index of the first event not discarded by a reset, only used while no thread is recording
+		uint64 ReadIndex = 0;
+
+		// Owned by the thread
+		TArray<FStackEntry> Stack;
+		TMap<uint64, int32> PathCache;
+	};
+
+	FRWLock StatLock;
+	TArray<FString> StatNames;
+	TMap<FString, FPointCloudStatId> StatIds;
+
+	FRWLock PathLock;
+	TArray<FPathNode> PathNodes;
+	TMap<uint64, int32> PathIds;
+
+	FCriticalSection BuffersLock;
+	TArray<TUniquePtr<FThreadBuffer>> Buffers;
+
+	thread_local FThreadBuffer* ThreadBuffer = nullptr;
+
+	FThreadBuffer& GetThreadBuffer()
+	{
+		if (ThreadBuffer == nullptr)
+		{
+			TUniquePtr<FThreadBuffer> Buffer = MakeUnique<FThreadBuffer>();
+			Buffer->ThreadId = FPlatformTLS::GetCurrentThreadId();
+			Buffer->ThreadName = FThreadManager::GetThreadName(Buffer->ThreadId);
+
+			const uint32 Capacity = FMath::RoundUpToPowerOfTwo(FMath::Max(CVarProfileBufferSize.GetValueOnAnyThread(), 1024));
+			Buffer->Events.SetNumUninitialized(Capacity);
+			Buffer->Mask = Capacity - 1;
+
+			// Buffers outlive their threads, so events of finished tasks can still be exported
+			ThreadBuffer = Buffer.Get();
+
+			FScopeLock Lock(&BuffersLock);
+			Buffers.Add(MoveTemp(Buffer));
+		}
+
+		return *ThreadBuffer;
+	}
+
+	int32 GetPathId(FThreadBuffer& Buffer, int32 Parent, FPointCloudStatId StatId)
+	{
+		const uint64 Key = ((uint64)(uint32)(Parent + 1) << 32) | (uint32)StatId;
+
+		if (const int32* CachedPath = Buffer.PathCache.Find(Key))
+		{
+			return *CachedPath;
+		}
+
+		int32 Path = INDEX_NONE;
+
+		{
+			FReadScopeLock Lock(PathLock);
+
+			if (const int32* ExistingPath = PathIds.Find(Key))
+			{
+				Path = *ExistingPath;
+			}
+		}
+
+		if (Path == INDEX_NONE)
+		{
+			FWriteScopeLock Lock(PathLock);
+
+			if (const int32* ExistingPath = PathIds.Find(Key))
+			{
+				Path = *ExistingPath;
+			}
+			else
+			{
+				Path = PathNodes.Add({ Parent, StatId });
+				PathIds.Add(Key, Path);
+			}
+		}
+
+		Buffer.PathCache.Add(Key, Path);
+
+		return Path;
+	}
+
+	FString GetRuleName(const FPointCloudRuleInstance* RuleInstance)
+	{
+		const UPointCloudRule* Rule = RuleInstance->GetRule();
+
+		if (Rule == nullptr)
+		{
+			return TEXT("Rule");
+		}
+
+		if (!Rule->Label.IsEmpty())
+		{
+			return Rule->Label;
+		}
+
+		const FString RuleName = Rule->RuleName();
+		return RuleName.IsEmpty() ? Rule->GetClass()->GetName() : RuleName;
+	}
+
+	/** Return the path of a rule instance, nested in the paths of its parents. The path is kept on the instance, and only made again if its parent changes */
+	int32 GetRulePath(FThreadBuffer& Buffer, const FPointCloudRuleInstance* RuleInstance)
+	{
+		const int32 ParentPath = RuleInstance->Parent.IsValid() ? GetRulePath(Buffer, RuleInstance->Parent.Get()) : INDEX_NONE;
+		const uint32 ParentKey = (uint32)(ParentPath + 1);
+
+		const uint64 CachedPath = RuleInstance->ProfilePath.load(std::memory_order_relaxed);
+		if (CachedPath != MAX_uint64 && (uint32)(CachedPath >> 32) == ParentKey)
+		{
+			return (int32)(uint32)CachedPath;
+		}
+
+		// Threads racing to fill in the path find the same id, so whichever store lands last is right
+		const int32 Path = GetPathId(Buffer, ParentPath, FPointCloudProfiler::GetStatId(GetRuleName(RuleInstance)));
+		RuleInstance->ProfilePath.store(((uint64)ParentKey << 32) | (uint32)Path, std::memory_order_relaxed);
+
+		return Path;
+	}
+
+	void Publish(FThreadBuffer& Buffer, const FEvent& Event)
+	{
+		const uint64 Index = Buffer.WriteIndex.load(std::memory_order_relaxed);
+		Buffer.Events[Index & Buffer.Mask] = Event;
+		Buffer.WriteIndex.store(Index + 1, std::memory_order_release);
+	}
+
+	/** The events of a thread still held in its buffer, oldest first */
+	struct FThreadEvents
+	{
+		uint32 ThreadId;
+		FString ThreadName;
+		TArray<FEvent> Events;
+	};
+
+	TArray<FThreadEvents> CollectEvents(int64* OutNumDropped = nullptr)
+	{
+		TArray<FThreadEvents> Result;
+		int64 NumDropped = 0;
+
+		FScopeLock Lock(&BuffersLock);
+
+		for (const TUniquePtr<FThreadBuffer>& Buffer : Buffers)
+		{
+			const uint64 End = Buffer->WriteIndex.load(std::memory_order_acquire);
+			const uint64 Capacity = Buffer->Mask + 1;
+			const uint64 Begin = FMath::Max(Buffer->ReadIndex, End > Capacity ? End - Capacity : 0);
+
+			NumDropped += Begin - Buffer->ReadIndex;
+
+			if (Begin == End)
+			{
+				continue;
+			}
+
+			FThreadEvents& ThreadEvents = Result.AddDefaulted_GetRef();
+			ThreadEvents.ThreadId = Buffer->ThreadId;
+			ThreadEvents.ThreadName = Buffer->ThreadName;
+			ThreadEvents.Events.Reserve(End - Begin);
+
+			for (uint64 Index = Begin; Index < End; ++Index)
+			{
+				ThreadEvents.Events.Add(Buffer->Events[Index & Buffer->Mask]);
+			}
+		}
+
+		if (OutNumDropped)
+		{
+			*OutNumDropped = NumDropped;
+		}
+
+		return Result;
+	}
+
+	/** Return the full name of every path, with the names of its scopes separated by slashes */
+	TArray<FString> GetPathNames()
+	{
+		TArray<FPathNode> Nodes;
+		{
+			FReadScopeLock Lock(PathLock);
+			Nodes = PathNodes;
+		}
+
+		TArray<FString> Names;
+		Names.SetNum(Nodes.Num());
+
+		// Parents are always added before their children
+		for (int32 Path = 0; Path < Nodes.Num(); ++Path)
+		{
+			const FString StatName = FPointCloudProfiler::GetStatName(Nodes[Path].StatId);
+			Names[Path] = Nodes[Path].Parent == INDEX_NONE ? StatName : Names[Nodes[Path].Parent] + TEXT("/") + StatName;
+		}
+
+		return Names;
+	}
+
+	struct FPathSummary
+	{
+		int64 Calls = 0;
+		int64 Count = 0;
+		double InclusiveSeconds = 0.0;
+		double ExclusiveSeconds = 0.0;
+		double MaxSeconds = 0.0;
+	};
+
+	/** Aggregate the recorded events on their path */
+	TMap<int32, FPathSummary> Summarize(const TArray<FThreadEvents>& AllEvents)
+	{
+		const double SecondsPerCycle = FPlatformTime::GetSecondsPerCycle64();
+
+		TMap<int32, FPathSummary> Summaries;
+		TArray<double> ChildSeconds;
+
+		for (const FThreadEvents& ThreadEvents : AllEvents)
+		{
+			ChildSeconds.Reset();
+
+			// Scopes of a thread end in stack order, so the children of a scope are the deeper scopes that ended since the previous scope at its depth
+			for (const FEvent& Event : ThreadEvents.Events)
+			{
+				FPathSummary& Summary = Summaries.FindOrAdd(Event.Path);
+
+				if (Event.Type == EEventType::Counter)
+				{
+					Summary.Count += Event.Value;
+					continue;
+				}
+
+				const double Seconds = (Event.EndCycles - Event.BeginCycles) * SecondsPerCycle;
+
+				if (ChildSeconds.Num() < Event.Depth + 2)
+				{
+					ChildSeconds.SetNumZeroed(Event.Depth + 2);
+				}
+
+				++Summary.Calls;
+				Summary.InclusiveSeconds += Seconds;
+				Summary.ExclusiveSeconds += FMath::Max(Seconds - ChildSeconds[Event.Depth + 1], 0.0);
+				Summary.MaxSeconds = FMath::Max(Summary.MaxSeconds, Seconds);
+
+				ChildSeconds[Event.Depth + 1] = 0.0;
+				ChildSeconds[Event.Depth] += Seconds;
+			}
+		}
+
+		return Summaries;
+	}
+
+	void AppendJsonString(FStringBuilderBase& Builder, const FString& String)
+	{
+		Builder.AppendChar(TEXT('"'));
+
+		for (const TCHAR Char : String)
+		{
+			if (Char == TEXT('"') || Char == TEXT('\\'))
+			{
+				Builder.AppendChar(TEXT('\\'));
+				Builder.AppendChar(Char);
+			}
+			else if (Char < 0x20)
+			{
+				Builder.AppendChar(TEXT(' '));
+			}
+			else
+			{
+				Builder.AppendChar(Char);
+			}
+		}
+
+		Builder.AppendChar(TEXT('"'));
+	}
+}
+
+void FPointCloudProfiler::SetEnabled(bool bInEnabled)
+{
+	bEnabled = bInEnabled;
+}
+
+FPointCloudStatId FPointCloudProfiler::GetStatId(const FString& Name)
+{
+	using namespace PointCloudProfilerPrivate;
+
+	{
+		FReadScopeLock Lock(StatLock);
+
+		if (const FPointCloudStatId* StatId = StatIds.Find(Name))
+		{
+			return *StatId;
+		}
+	}
+
+	FWriteScopeLock Lock(StatLock);
+
+	if (const FPointCloudStatId* StatId = StatIds.Find(Name))
+	{
+		return *StatId;
+	}
+
+	const FPointCloudStatId StatId = StatNames.Add(Name);
+	StatIds.Add(Name, StatId);
+
+	return StatId;
+}
+
+FString FPointCloudProfiler::GetStatName(FPointCloudStatId StatId)
+{
+	using namespace PointCloudProfilerPrivate;
+
+	FReadScopeLock Lock(StatLock);
+	return StatNames.IsValidIndex(StatId) ? StatNames[StatId] : FString();
+}
+
+void FPointCloudProfiler::AddToCounter(FPointCloudStatId StatId, int64 Value)
+{
+	using namespace PointCloudProfilerPrivate;
+
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	FThreadBuffer& Buffer = GetThreadBuffer();
+	const FStackEntry Parent = Buffer.Stack.Num() > 0 ? Buffer.Stack.Last() : FStackEntry{ INDEX_NONE, 0 };
+	const uint64 Now = FPlatformTime::Cycles64();
+
+	Publish(Buffer, { Now, Now, Value, Parent.RuleInstance, GetPathId(Buffer, Parent.Path, StatId), (uint16)Buffer.Stack.Num(), EEventType::Counter });
+}
+
+void FPointCloudProfiler::Reset()
+{
+	using namespace PointCloudProfilerPrivate;
+
+	FScopeLock Lock(&BuffersLock);
+
+	for (const TUniquePtr<FThreadBuffer>& Buffer : Buffers)
+	{
+		Buffer->ReadIndex = Buffer->WriteIndex.load(std::memory_order_acquire);
+	}
+}
+
+int64 FPointCloudProfiler::GetNumDroppedEvents()
+{
+	int64 NumDropped = 0;
+	PointCloudProfilerPrivate::CollectEvents(&NumDropped);
+	return NumDropped;
+}
+
+FString FPointCloudProfiler::ExportChromeTrace()
+{
+	using namespace PointCloudProfilerPrivate;
+
+	int64 NumDropped = 0;
+	const TArray<FThreadEvents> AllEvents = CollectEvents(&NumDropped);
+	const TArray<FString> PathNames = GetPathNames();
+
+	uint64 StartCycles = MAX_uint64;
+	for (const FThreadEvents& ThreadEvents : AllEvents)
+	{
+		for (const FEvent& Event : ThreadEvents.Events)
+		{
+			StartCycles = FMath::Min(StartCycles, Event.BeginCycles);
+		}
+	}
+
+	const double MicrosecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1.0e6;
+
+	TStringBuilder<4096> Builder;
+	Builder.Append(TEXT("{\"traceEvents\":["));
+
+	bool bFirst = true;
+	auto BeginEvent = [&Builder, &bFirst]()
+	{
+		Builder.Append(bFirst ? TEXT("\n") : TEXT(",\n"));
+		bFirst = false;
+	};
+
+	for (const FThreadEvents& ThreadEvents : AllEvents)
+	{
+		BeginEvent();
+		Builder.Appendf(TEXT("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":"), ThreadEvents.ThreadId);
+		AppendJsonString(Builder, ThreadEvents.ThreadName.IsEmpty() ? FString::Printf(TEXT("Thread %u"), ThreadEvents.ThreadId) : ThreadEvents.ThreadName);
+		Builder.Append(TEXT("}}"));
+
+		for (const FEvent& Event : ThreadEvents.Events)
+		{
+			const FString& PathName = PathNames[Event.Path];
+			const int32 NameStart = PathName.Find(TEXT("/"), ESearchCase::CaseSensitive, ESearchDir::FromEnd) + 1;
+			const double Timestamp = (Event.BeginCycles - StartCycles) * MicrosecondsPerCycle;
+
+			BeginEvent();
+			Builder.Append(TEXT("{\"name\":"));
+			AppendJsonString(Builder, PathName.RightChop(NameStart));
+
+			if (Event.Type == EEventType::Counter)
+			{
+				Builder.Appendf(TEXT(",\"ph\":\"C\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"value\":%lld}}"), Timestamp, ThreadEvents.ThreadId, Event.Value);
+				continue;
+			}
+
+			Builder.Appendf(TEXT(",\"cat\":\"RuleProcessor\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"path\":"),
+				Timestamp, (Event.EndCycles - Event.BeginCycles) * MicrosecondsPerCycle, ThreadEvents.ThreadId);
+			AppendJsonString(Builder, PathName);
+
+			if (Event.RuleInstance)
+			{
+				Builder.Appendf(TEXT(",\"ruleInstance\":\"0x%llx\""), (uint64)Event.RuleInstance);
+			}
+
+			Builder.Append(TEXT("}}"));
+		}
+	}
+
+	Builder.Appendf(TEXT("\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":%lld}}\n"), NumDropped);
+
+	return Builder.ToString();
+}
+
+FString FPointCloudProfiler::ExportSummaryCsv()
+{
+	using namespace PointCloudProfilerPrivate;
+
+	const TMap<int32, FPathSummary> Summaries = Summarize(CollectEvents());
+	const TArray<FString> PathNames = GetPathNames();
+
+	TArray<int32> Paths;
+	Summaries.GetKeys(Paths);
+	Paths.Sort([&PathNames](int32 A, int32 B) { return PathNames[A] < PathNames[B]; });
+
+	TStringBuilder<4096> Builder;
+	Builder.Append(TEXT("Path,Calls,InclusiveSeconds,ExclusiveSeconds,MaxSeconds,Count\n"));
+
+	for (const int32 Path : Paths)
+	{
+		const FPathSummary& Summary = Summaries[Path];
+
+		Builder.Appendf(TEXT("\"%s\",%lld,%.6f,%.6f,%.6f,%lld\n"), *PathNames[Path].Replace(TEXT("\""), TEXT("\"\"")),
+			Summary.Calls, Summary.InclusiveSeconds, Summary.ExclusiveSeconds, Summary.MaxSeconds, Summary.Count);
+	}
+
+	return Builder.ToString();
+}
+
+void FPointCloudProfiler::AddToStats(FPointCloudStats& Stats)
+{
+	using namespace PointCloudProfilerPrivate;
+
+	const TMap<int32, FPathSummary> Summaries = Summarize(CollectEvents());
+	const TArray<FString> PathNames = GetPathNames();
+
+	for (const TPair<int32, FPathSummary>& Entry : Summaries)
+	{
+		const FString Name = TEXT("Profile ") + PathNames[Entry.Key];
+
+		if (Entry.Value.Calls > 0)
+		{
+			Stats.AddTimingToEvent(Name, FTimespan::FromSeconds(Entry.Value.InclusiveSeconds));
+			Stats.AddToCounter(Name + TEXT(" Calls"), Entry.Value.Calls);
+		}
+		else
+		{
+			Stats.AddToCounter(Name, Entry.Value.Count);
+		}
+	}
+}
+
+bool FPointCloudProfiler::SaveReports(const FString& BaseFilename)
+{
+	const bool bSavedTrace = FFileHelper::SaveStringToFile(ExportChromeTrace(), *(BaseFilename + TEXT(".json")));
+	const bool bSavedSummary = FFileHelper::SaveStringToFile(ExportSummaryCsv(), *(BaseFilename + TEXT(".csv")));
+
+	return bSavedTrace && bSavedSummary;
+}
+
+void FPointCloudProfileScope::Begin(FPointCloudStatId StatId, const FPointCloudRuleInstance* RuleInstance)
+{
+	using namespace PointCloudProfilerPrivate;
+
+	FThreadBuffer& Buffer = GetThreadBuffer();
+
+	FStackEntry Entry = Buffer.Stack.Num() > 0 ? Buffer.Stack.Last() : FStackEntry{ INDEX_NONE, 0 };
+
+	// A rule scope starts from the path of its instance, whatever the thread was doing before
+	if (RuleInstance)
+	{
+		Entry.Path = GetRulePath(Buffer, RuleInstance);
+		Entry.RuleInstance = (UPTRINT)RuleInstance;
+	}
+
+	Entry.Path = GetPathId(Buffer, Entry.Path, StatId);
+	Buffer.Stack.Add(Entry);
+
+	bActive = true;
+	BeginCycles = FPlatformTime::Cycles64();
+}
+
+void FPointCloudProfileScope::End()
+{
+	using namespace PointCloudProfilerPrivate;
+
+	const uint64 EndCycles = FPlatformTime::Cycles64();
+
+	FThreadBuffer& Buffer = GetThreadBuffer();
+	const FStackEntry Entry = Buffer.Stack.Pop(EAllowShrinking::No);
+
+	Publish(Buffer, { BeginCycles, EndCycles, 0, Entry.RuleInstance, Entry.Path, (uint16)Buffer.Stack.Num(), EEventType::Scope });
+}
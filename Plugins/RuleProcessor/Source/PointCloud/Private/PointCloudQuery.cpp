@@ -9,7 +9,7 @@
 #define LOCTEXT_NAMESPACE "PointCloudQuery"
 
 // Convenience macro
-#define QUERY_LOG(Query, Label) PointCloud::QueryLogger Logger(Cloud, Query, Label, __FILE__, __LINE__)
+#define QUERY_LOG(Query, Label) PointCloud::QueryLogger Logger(Cloud, Query, Label, __FILE__, __LINE__, POINTCLOUD_QUERY_STAT_ID(Label))
 
 FPointCloudQuery::FPointCloudQuery(UPointCloudImpl* InCloud) : Cloud(InCloud), Statement(nullptr)
 {
@@ -98,7 +98,7 @@ bool FPointCloudQuery::Step(const TArray<FString>& Values)
 	return true;
 }
 
-bool FPointCloudQuery::Step(int32 ValueA, int32 ValueB, int32 ValueC)
+bool FPointCloudQuery::Step(int64 ValueA, int32 ValueB, int32 ValueC)
 {
 	if (!Cloud || !Statement)
 	{
@@ -108,7 +108,7 @@ bool FPointCloudQuery::Step(int32 ValueA, int32 ValueB, int32 ValueC)
 
 	QUERY_LOG(FString(), TEXT("const TArray<char>& Values"));
 
-	if (sqlite3_bind_int(Statement, 1, ValueA) != SQLITE_OK)
+	if (sqlite3_bind_int64(Statement, 1, ValueA) != SQLITE_OK)
 	{
 		UE_LOG(PointCloudLog, Warning, TEXT("Bind Attribute 1 failed"));
 		return false;
@@ -295,6 +295,51 @@ bool FPointCloudQuery::Step(const TArray<float>& Values)
 	return true;
 }
 
+bool FPointCloudQuery::Step(int64 RowId, TArrayView<const float> Values)
+{
+	if (!Cloud || !Statement)
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Null Cloud or Statement"));
+		return false;
+	}
+
+	QUERY_LOG(FString(), TEXT("bool FPointCloudQuery::Step(int64 RowId, TArrayView<const float> Values)"));
+
+	if (sqlite3_bind_int64(Statement, 1, RowId) != SQLITE_OK)
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Bind RowId failed"));
+		return false;
+	}
+
+	for (int i = 0; i < Values.Num(); i++)
+	{
+		if (sqlite3_bind_double(Statement, i + 2, static_cast<double>(Values[i])) != SQLITE_OK)
+		{
+			UE_LOG(PointCloudLog, Warning, TEXT("Bind Attribute %d failed"), i);
+			return false;
+		}
+	}
+
+	int StepResult = sqlite3_step(Statement);
+
+	if (StepResult != SQLITE_DONE)
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Step Failed - %s"), ANSI_TO_TCHAR(sqlite3_errstr(StepResult)));
+		return false;
+	}
+
+	sqlite3_clear_bindings(Statement);
+	int rc = sqlite3_reset(Statement);
+
+	if (rc != SQLITE_OK)
+	{
+		UE_LOG(PointCloudLog, Warning, TEXT("Cleanup Failed"));
+		return false;
+	}
+
+	return true;
+}
+
 bool FPointCloudQuery::Step(const TArray<int>& Values, FPointCloudQuery::FRowHandler* Handler)
 {
 	if (!Cloud || !Statement)
@@ -381,7 +426,7 @@ FString FPointCloudQuery::GetHash(int HashType/* = 256*/, bool bIncludeQuery/* =
 
 	const FString FinalQuery = FString::Printf(TEXT("SELECT SHA3_QUERY(\"%s\", %i, %i)"), *HashQuery, HashType, (int8)bIncludeQuery);
 
-	Cloud->RunQuery(FinalQuery, SQLExtension::Sha3CallBack, &Result, __FILE__, __LINE__);
+	Cloud->RunQuery(FinalQuery, SQLExtension::Sha3CallBack, &Result, __FILE__, __LINE__, POINTCLOUD_QUERY_STAT_ID(FString()));
 
 	return Result;
 }
@@ -88,12 +88,12 @@ public:
 
 	/**
 	* Special case step function for metadata insertion. This should all be cleaned up by using a Variant or similar
-	* @param ValueA - The first value to substitute in the query
+	* @param ValueA - The first value to substitute in the query, wide enough to hold a vertex rowid
 	* @param ValueB - The second value to substitute in the query
 	* @param ValueC - The third value to substitute in the query
 	* @return True if the query can be stepped given the provided values
 	*/
-	bool Step(int32 ValueA, int32 ValueB, int32 ValueC);
+	bool Step(int64 ValueA, int32 ValueB, int32 ValueC);
 
 	/**
 	* Run this prepared statement substituting parameters with characters. This represents a single 8-bit string parameter
@@ -109,6 +109,14 @@ public:
 	*/
 	bool Step(const TArray<float>& Values);
 
+	/**
+	* Run this prepared statement substituting the first parameter with a row id and the remaining parameters with floats, in the order they appear in the statement.
+	* @param RowId - Value for the first parameter
+	* @param Values - Values for the remaining parameters. This must contain one value for each remaining parameter in the Query.
+	* @return True if the query can be stepped given the provided values
+	*/
+	bool Step(int64 RowId, TArrayView<const float> Values);
+
 	/**
 	* Run this prepared statement substituting parameters with an int and a string. parameters will be replaced in the order they appear in the statement.
 	* @param Values - Parameter substitution values. This Array must contain one value for each expected parameter in the Query.
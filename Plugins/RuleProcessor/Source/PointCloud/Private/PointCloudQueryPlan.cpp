@@ -0,0 +1,223 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PointCloudQueryPlan.h"
+#include "Algo/StableSort.h"
+#include "Hash/CityHash.h"
+#include "IncludeSQLite.h"
+
+namespace PointCloudQueryPlanPrivate
+{
+	// The number of prepared statements to keep around. Views query many different tables, so most statements are only run a handful of times
+	const int32 StatementCacheSize = 128;
+}
+
+FPointCloudQueryPlan FPointCloudQueryPlan::Compile(const TArray<FString>& FilterStatements)
+{
+	FPointCloudQueryPlan Plan;
+	Plan.Statements.Reserve(FilterStatements.Num());
+
+	for (const FString& FilterStatement : FilterStatements)
+	{
+		// Intersecting a set with itself doesn't change it, so repeated statements can be dropped
+		Plan.Statements.AddUnique(FilterStatement.TrimStartAndEnd());
+	}
+
+	// Sort by rank only, so that statements with the same rank keep the order they were applied in
+	Algo::StableSortBy(Plan.Statements, &FPointCloudQueryPlan::GetSelectivityRank);
+
+	Plan.Key = FString::Join(Plan.Statements, TEXT(";"));
+	Plan.Hash = CityHash64(reinterpret_cast<const char*>(*Plan.Key), Plan.Key.Len() * sizeof(TCHAR));
+
+	return Plan;
+}
+
+int32 FPointCloudQueryPlan::GetSelectivityRank(const FString& FilterStatement)
+{
+	// Keywords are matched with the case used by the UPointCloudView filters, so that metadata values are less likely to match them
+	// Inverted filters keep everything but a region or a value, so are unlikely to remove many points
+	if (FilterStatement.Contains(TEXT("NOT("), ESearchCase::CaseSensitive) || FilterStatement.Contains(TEXT("NOT "), ESearchCase::CaseSensitive) || FilterStatement.Contains(TEXT(" OR "), ESearchCase::CaseSensitive))
+	{
+		return 5;
+	}
+
+	// FilterOnIndex
+	if (FilterStatement.Contains(TEXT("Id="), ESearchCase::CaseSensitive))
+	{
+		return 0;
+	}
+
+	// FilterOnRange
+	if (FilterStatement.Contains(TEXT("Id>="), ESearchCase::CaseSensitive))
+	{
+		return 1;
+	}
+
+	// FilterOnMetadata with an exact value
+	if (FilterStatement.Contains(TEXT("Attribute_Value='"), ESearchCase::CaseSensitive))
+	{
+		return 2;
+	}
+
+	// Spatial filters
+	if (FilterStatement.Contains(TEXT("IN_SPHERE"), ESearchCase::CaseSensitive) || FilterStatement.Contains(TEXT("IN_OBB"), ESearchCase::CaseSensitive) || FilterStatement.Contains(TEXT("Minx"), ESearchCase::CaseSensitive))
+	{
+		return 3;
+	}
+
+	// Statements without a WHERE clause select every point
+	if (!FilterStatement.Contains(TEXT("WHERE")))
+	{
+		return 6;
+	}
+
+	// Metadata patterns and point expressions
+	return 4;
+}
+
+FString FPointCloudQueryPlanCache::Find(uint64 PlanHash) const
+{
+	const FShard& Shard = GetShard(PlanHash);
+
+	FReadScopeLock Lock(Shard.Lock);
+	const FString* TableName = Shard.Tables.Find(PlanHash);
+	return TableName ? *TableName : FString();
+}
+
+void FPointCloudQueryPlanCache::Add(uint64 PlanHash, const FString& TableName)
+{
+	FShard& Shard = GetShard(PlanHash);
+
+	FWriteScopeLock Lock(Shard.Lock);
+	Shard.Tables.Add(PlanHash, TableName);
+}
+
+int32 FPointCloudQueryPlanCache::RemoveTable(const FString& TableName)
+{
+	int32 NumRemoved = 0;
+
+	// Tables are not indexed by name, but this only happens when a temporary table is dropped
+	for (FShard& Shard : Shards)
+	{
+		FWriteScopeLock Lock(Shard.Lock);
+
+		for (auto It = Shard.Tables.CreateIterator(); It; ++It)
+		{
+			if (It->Value == TableName)
+			{
+				It.RemoveCurrent();
+				++NumRemoved;
+			}
+		}
+	}
+
+	return NumRemoved;
+}
+
+void FPointCloudQueryPlanCache::Reset()
+{
+	for (FShard& Shard : Shards)
+	{
+		FWriteScopeLock Lock(Shard.Lock);
+		Shard.Tables.Empty();
+	}
+}
+
+int32 FPointCloudQueryPlanCache::Num() const
+{
+	int32 Result = 0;
+
+	for (const FShard& Shard : Shards)
+	{
+		FReadScopeLock Lock(Shard.Lock);
+		Result += Shard.Tables.Num();
+	}
+
+	return Result;
+}
+
+FPointCloudStatementCache::FPointCloudStatementCache()
+	: Statements(PointCloudQueryPlanPrivate::StatementCacheSize + 1)
+	, MaxStatements(PointCloudQueryPlanPrivate::StatementCacheSize)
+{
+
+}
+
+FPointCloudStatementCache::~FPointCloudStatementCache()
+{
+	Reset();
+}
+
+sqlite3_stmt* FPointCloudStatementCache::Acquire(sqlite3* Database, const FString& Query, int32& OutError)
+{
+	OutError = SQLITE_OK;
+
+	{
+		FScopeLock Locker(&Lock);
+
+		if (Statements.Contains(Query))
+		{
+			sqlite3_stmt* Statement = Statements.FindAndTouchRef(Query);
+			Statements.Remove(Query);
+			return Statement;
+		}
+	}
+
+	sqlite3_stmt* Statement = nullptr;
+	OutError = sqlite3_prepare_v2(Database, TCHAR_TO_ANSI(*Query), -1, &Statement, 0);
+
+	if (OutError != SQLITE_OK)
+	{
+		sqlite3_finalize(Statement);
+		return nullptr;
+	}
+
+	return Statement;
+}
+
+void FPointCloudStatementCache::Release(const FString& Query, sqlite3_stmt* Statement)
+{
+	if (Statement == nullptr)
+	{
+		return;
+	}
+
+	// Release any lock the statement holds on the database before it goes back in the cache
+	sqlite3_reset(Statement);
+	sqlite3_clear_bindings(Statement);
+
+	sqlite3_stmt* StatementToFinalize = nullptr;
+
+	{
+		FScopeLock Locker(&Lock);
+
+		if (Statements.Contains(Query))
+		{
+			// Another thread ran the same query at the same time and already put its statement back
+			StatementToFinalize = Statement;
+		}
+		else
+		{
+			Statements.Add(Query, Statement);
+
+			if (Statements.Num() > MaxStatements)
+			{
+				StatementToFinalize = *Statements.RemoveLeastRecent();
+			}
+		}
+	}
+
+	if (StatementToFinalize)
+	{
+		sqlite3_finalize(StatementToFinalize);
+	}
+}
+
+void FPointCloudStatementCache::Reset()
+{
+	FScopeLock Locker(&Lock);
+
+	while (Statements.Num() > 0)
+	{
+		sqlite3_finalize(*Statements.RemoveLeastRecent());
+	}
+}
@@ -91,15 +91,44 @@ void SQLExtension::sqlIsInOBB(sqlite3_context* context, int argc, sqlite3_value*
 		return;
 	}
 
-	const FRotator Rotation((float)sqlite3_value_double(argv[0]), (float)sqlite3_value_double(argv[1]), (float)sqlite3_value_double(argv[2]));
-	const FVector Translation((float)sqlite3_value_double(argv[3]), (float)sqlite3_value_double(argv[4]), (float)sqlite3_value_double(argv[5]));
-	const FVector Scale((float)sqlite3_value_double(argv[6]), (float)sqlite3_value_double(argv[7]), (float)sqlite3_value_double(argv[8]));
+	// The box is the same for every row of a query, so keep the transform built from its arguments with the first argument rather than
+	// building it for every point. The arguments are checked against the ones the transform was built from in case they are not constant
+	struct FBoxTransform
+	{
+		float Arguments[9];
+		FTransform Transform;
+	};
+
+	float Arguments[9];
+	for (int32 Index = 0; Index < 9; ++Index)
+	{
+		Arguments[Index] = (float)sqlite3_value_double(argv[Index]);
+	}
+
 	const FVector Point((float)sqlite3_value_double(argv[9]), (float)sqlite3_value_double(argv[10]), (float)sqlite3_value_double(argv[11]));
 
-	const FTransform Transform(Rotation, Translation, Scale);
+	FVector LocalPoint;
+
+	const FBoxTransform* CachedTransform = static_cast<const FBoxTransform*>(sqlite3_get_auxdata(context, 0));
+	if (CachedTransform != nullptr && FMemory::Memcmp(CachedTransform->Arguments, Arguments, sizeof(Arguments)) == 0)
+	{
+		LocalPoint = CachedTransform->Transform.InverseTransformPosition(Point);
+	}
+	else
+	{
+		const FRotator Rotation(Arguments[0], Arguments[1], Arguments[2]);
+		const FVector Translation(Arguments[3], Arguments[4], Arguments[5]);
+		const FVector Scale(Arguments[6], Arguments[7], Arguments[8]);
+
+		FBoxTransform* BoxTransform = new FBoxTransform{ {}, FTransform(Rotation, Translation, Scale) };
+		FMemory::Memcpy(BoxTransform->Arguments, Arguments, sizeof(Arguments));
+
+		LocalPoint = BoxTransform->Transform.InverseTransformPosition(Point);
+
+		// sqlite owns the data from here on, and may delete it straight away if the argument is not constant
+		sqlite3_set_auxdata(context, 0, BoxTransform, [](void* Data) { delete static_cast<FBoxTransform*>(Data); });
+	}
 
-	// TODO, pre-invert transfom instead of doing it for every point.
-	const FVector LocalPoint = Transform.InverseTransformPosition(Point);
 	if (FMath::Abs(LocalPoint.X) <= 1.0f &&
 		FMath::Abs(LocalPoint.Y) <= 1.0f &&
 		FMath::Abs(LocalPoint.Z) <= 1.0f)
@@ -875,4 +904,25 @@ int SQLExtension::Sha3CallBack(void* UsrData, int argc, char** argv, char** azCo
 	*HashString = FString::FromHexBlob((const uint8*)argv[0], 32);
 
 	return 0;
+}
+
+FString SQLExtension::HashIntegerRow(int64 Value)
+{
+	SHA3Context cx;
+	SHA3Init(&cx, 256);
+
+	// Same byte stream as sha3QueryFunc, a row marker then the big-endian integer
+	SHA3Update(&cx, (const unsigned char*)"R", 1);
+
+	sqlite3_uint64 u;
+	unsigned char x[9];
+	memcpy(&u, &Value, 8);
+	for (int j = 8; j >= 1; j--) {
+		x[j] = u & 0xff;
+		u >>= 8;
+	}
+	x[0] = 'I';
+	SHA3Update(&cx, x, 9);
+
+	return FString::FromHexBlob(SHA3Final(&cx), 32);
 }
\ No newline at end of file
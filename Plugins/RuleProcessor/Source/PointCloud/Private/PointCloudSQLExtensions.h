@@ -94,6 +94,12 @@ public:
 
 	static int Sha3CallBack(void* UsrData, int argc, char** argv, char** azColName);
 
+	/**
+	* Returns the hash that sha3_query(SQL, 256, 0) followed by Sha3CallBack gives for a query
+	* returning a single row made of a single integer, without running any query.
+	*/
+	static FString HashIntegerRow(int64 Value);
+
 private:
 	
 	// A single step of the Keccak mixing function for a 1600-bit state
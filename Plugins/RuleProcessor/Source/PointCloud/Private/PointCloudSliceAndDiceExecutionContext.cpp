@@ -2,12 +2,16 @@
 
 #include "PointCloudSliceAndDiceExecutionContext.h"
 #include "PointCloudSliceAndDiceRuleInstance.h"
+#include "PointCloudSliceAndDiceRuleSetScheduler.h"
+#include "PointCloudView.h"
 #include "PointCloudSliceAndDiceContext.h"
+#include "PointCloudProfiler.h"
 #include "PointCloudSliceAndDiceManager.h"
 #include "PointCloudWorldPartitionHelpers.h"
 #include "Engine/World.h"
 #include "WorldPartition/WorldPartition.h"
 #include "GameFramework/Actor.h"
+#include "Misc/ScopedSlowTask.h"
 
 #if WITH_EDITOR
 #include "FileHelpers.h"
@@ -23,6 +27,11 @@ static TAutoConsoleVariable<int32> CVarBatchIterationFrequency(
 	8192,
 	TEXT("Control how frequently Rule Processor will do internal cleanup (save, unload, GC) when generating lots of actors."));
 
+static TAutoConsoleVariable<int32> CVarPerPointBatchSize(
+	TEXT("t.RuleProcessor.PerPointBatchSize"),
+	1024,
+	TEXT("Number of points whose rules are scheduled together when executing rules once per point."));
+
 FSliceAndDiceExecutionContext::FSliceAndDiceExecutionContext(const FSliceAndDiceContext& InContext, bool bSaveAndUnload)
 {
 	World = InContext.GetOriginatingWorld();
@@ -322,12 +331,33 @@ bool FSliceAndDiceExecutionContext::CommitAndCleanup()
 	return bSavedPackages || bUnloadedCells;
 }
 
+namespace PointCloudSliceAndDiceExecutionPrivate
+{
+	/** Parents and children reference each other, break the cycles so instances made during execution are released */
+	static void ReleaseChildren(const FPointCloudRuleInstancePtr& InInstance)
+	{
+		for (const FPointCloudRuleInstancePtr& Child : InInstance->Children)
+		{
+			ReleaseChildren(Child);
+		}
+
+		InInstance->Children.Reset();
+	}
+}
+
 namespace SliceAndDiceExecution
 {
 	void SingleThreadedRuleInstanceExecute(FPointCloudRuleInstancePtr InRule, FSliceAndDiceExecutionContextPtr Context)
 	{
 		check(InRule);
-		InRule->PreExecute(Context);
+
+		static const FPointCloudStatId PreExecuteStatId = FPointCloudProfiler::GetStatId(TEXT("PreExecute"));
+		static const FPointCloudStatId PostExecuteStatId = FPointCloudProfiler::GetStatId(TEXT("PostExecute"));
+
+		{
+			FPointCloudProfileScope ProfileScope(PreExecuteStatId, InRule.Get());
+			InRule->PreExecute(Context);
+		}
 
 		if(!InRule->IsSkipped() && !InRule->AreChildrenSkipped())
 		{
@@ -337,7 +367,85 @@ namespace SliceAndDiceExecution
 			}
 		}
 
-		InRule->PostExecute(Context);
+		{
+			FPointCloudProfileScope ProfileScope(PostExecuteStatId, InRule.Get());
+			InRule->PostExecute(Context);
+		}
+
 		InRule->ClearView();
 	}
+
+	void PerPointRuleInstanceExecute(const TArray<FPointCloudRuleInstancePtr>& InInstances, UPointCloudView* InView, FSliceAndDiceExecutionContextPtr Context, TFunctionRef<FPointCloudRuleInstancePtr(int32 PointId)> InMakePointInstance, bool bAllowWorkerThreads, FScopedSlowTask* SlowTask)
+	{
+		check(InView);
+
+		TArray<FPointCloudRuleInstancePtr> Instances = InInstances.FilterByPredicate([](const FPointCloudRuleInstancePtr& Instance) { return Instance.IsValid(); });
+
+		if (Instances.IsEmpty())
+		{
+			return;
+		}
+
+		const TSharedPtr<const FPointCloudViewPoints> Points = MakeShared<const FPointCloudViewPoints>(InView);
+
+		// Batches bound the number of views and duplicated instances alive at once
+		const int32 BatchSize = FMath::Max(CVarPerPointBatchSize.GetValueOnGameThread(), 1);
+
+		TArray<UPointCloudView*> PointViews;
+		TArray<FPointCloudRuleInstancePtr> PointInstances;
+		TArray<FPointCloudRuleInstancePtr> Roots;
+
+		for (int32 BatchStart = 0; BatchStart < Points->Num(); BatchStart += BatchSize)
+		{
+			const int32 BatchEnd = FMath::Min(BatchStart + BatchSize, Points->Num());
+
+			PointViews.Reset();
+			PointInstances.Reset();
+			Roots.Reset();
+
+			for (int32 PointIndex = BatchStart; PointIndex < BatchEnd; ++PointIndex)
+			{
+				UPointCloudView* PointView = InView->MakePointView(Points, PointIndex);
+
+				FPointCloudRuleInstancePtr PointInstance = InMakePointInstance(Points->GetId(PointIndex));
+				check(PointInstance);
+				PointInstance->SetView(PointView);
+
+				PointViews.Add(PointView);
+				PointInstances.Add(PointInstance);
+			}
+
+			// Keep the order of the single threaded iteration within the batch: every point for an instance, then the next instance
+			for (const FPointCloudRuleInstancePtr& Instance : Instances)
+			{
+				for (const FPointCloudRuleInstancePtr& PointInstance : PointInstances)
+				{
+					const bool bAttachToParent = false;
+					FPointCloudRuleInstancePtr PointChild = Instance->Duplicate(bAttachToParent);
+					PointChild->SetParent(PointInstance);
+					PointInstance->AddChild(PointChild);
+
+					Roots.Add(PointChild);
+				}
+			}
+
+			FPointCloudSliceAndDiceRuleSetScheduler Scheduler(Roots, Context, bAllowWorkerThreads);
+			Scheduler.Execute();
+
+			for (UPointCloudView* PointView : PointViews)
+			{
+				InView->RemoveChildView(PointView);
+			}
+
+			for (const FPointCloudRuleInstancePtr& PointInstance : PointInstances)
+			{
+				PointCloudSliceAndDiceExecutionPrivate::ReleaseChildren(PointInstance);
+			}
+
+			if (SlowTask)
+			{
+				SlowTask->EnterProgressFrame((BatchEnd - BatchStart) * Instances.Num());
+			}
+		}
+	}
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "Engine/World.h"
 #include "Kismet/GameplayStatics.h"
 #include "PointCloudSliceAndDiceContext.h"
+#include "PointCloudProfiler.h"
 #include "PointCloudSliceAndDiceRuleSet.h"
 #include "PointCloudSliceAndDiceRuleSetExecutor.h"
 #include "PointCloudSliceAndDiceRuleInstance.h"
@@ -11,6 +12,7 @@
 #include "WorldPartition/WorldPartition.h"
 #include "Algo/Reverse.h"
 #include "GameFramework/LightWeightInstanceSubsystem.h"
+#include "Misc/Paths.h"
 
 #if WITH_EDITOR
 #include "Editor.h"
@@ -601,6 +603,13 @@ bool ASliceAndDiceManager::RunOnMappings(const TArray<USliceAndDiceMapping*>& Se
 
 	FDateTime ExecuteStart = FDateTime::Now(); // eq. to CheckoutEnd
 
+	// Only profile this execution
+	const bool bProfiling = FPointCloudProfiler::IsEnabled();
+	if (bProfiling)
+	{
+		FPointCloudProfiler::Reset();
+	}
+
 	if (!bIsReporting || Context.ReportObject.GetReportingLevel() > EPointCloudReportLevel::Basic)
 	{
 		FPointCloudSliceAndDiceRuleSetExecutor Executor(Context);
@@ -611,6 +620,23 @@ bool ASliceAndDiceManager::RunOnMappings(const TArray<USliceAndDiceMapping*>& Se
 
 	FDateTime ExecuteEnd = FDateTime::Now();
 
+	if (bProfiling)
+	{
+		const FString ProfileFilename = FPaths::Combine(FPaths::ProfilingDir(), TEXT("RuleProcessor"), FString::Printf(TEXT("RuleProcessor-%s"), *ExecuteStart.ToString()));
+
+		if (FPointCloudProfiler::SaveReports(ProfileFilename))
+		{
+			UE_LOG(PointCloudLog, Log, TEXT("Saved the rule processor profile to %s.json and %s.csv"), *ProfileFilename, *ProfileFilename);
+		}
+
+		if (const int64 NumDroppedEvents = FPointCloudProfiler::GetNumDroppedEvents())
+		{
+			UE_LOG(PointCloudLog, Warning, TEXT("The rule processor profile is missing %lld events, increase t.RuleProcessor.Profile.BufferSize to keep them"), NumDroppedEvents);
+		}
+
+		FPointCloudProfiler::AddToStats(*Context.GetStats());
+	}
+
 	// Keep track of new actors, actors to delete and allow views to be garbage collected
 	if (!bIsReporting)
 	{
@@ -25,6 +25,7 @@ FPointCloudRuleInstance::FPointCloudRuleInstance(const FPointCloudRuleInstance&
 	Parent = nullptr;
 	View = nullptr;
 	ExecutingChildCount = 0;
+	ProfilePath = MAX_uint64;
 }
 
 void FPointCloudRuleInstance::ClearView()
@@ -17,9 +17,6 @@ private:
 	void PrepareWorkloads();
 	bool ExecuteWorkloads();
 
-	void QueueRuleInstances(FPointCloudRuleInstancePtr InParentInstance, const TArray<FPointCloudRuleInstancePtr>& InChildInstances, FSliceAndDiceExecutionContextPtr Context);
-	void NotifyParentInstanceThatChildJobIsDone(FPointCloudRuleInstancePtr InInstance, FSliceAndDiceExecutionContextPtr Context);
-
 private:
 	FSliceAndDiceContext& Context;
 	TArray<FPointCloudRuleInstancePtr> RuleInstances;
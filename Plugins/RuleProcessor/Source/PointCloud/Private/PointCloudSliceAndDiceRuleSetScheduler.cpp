@@ -0,0 +1,214 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PointCloudSliceAndDiceRuleSetScheduler.h"
+#include "PointCloudProfiler.h"
+
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/GCScopeLock.h"
+
+DECLARE_STATS_GROUP(TEXT("RuleProcessor"), STATGROUP_RuleProcessor, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Execution Time"), STAT_RuleProcessorExecutionTime, STATGROUP_RuleProcessor)
+
+FPointCloudSliceAndDiceRuleSetScheduler::FPointCloudSliceAndDiceRuleSetScheduler(const TArray<FPointCloudRuleInstancePtr>& InRootInstances, FSliceAndDiceExecutionContextPtr InExecutionContext, bool bInAllowWorkerThreads)
+	: ExecutionContext(InExecutionContext)
+	, bAllowWorkerThreads(bInAllowWorkerThreads)
+{
+	int32 PreviousPostExecuteNode = INDEX_NONE;
+
+	for (const FPointCloudRuleInstancePtr& RootInstance : InRootInstances)
+	{
+		if (RootInstance)
+		{
+			PreviousPostExecuteNode = AddInstance(RootInstance, INDEX_NONE, PreviousPostExecuteNode);
+		}
+	}
+}
+
+int32 FPointCloudSliceAndDiceRuleSetScheduler::AddInstance(FPointCloudRuleInstancePtr InInstance, int32 InParent, int32 InPreviousPostExecuteNode)
+{
+	const int32 InstanceIndex = Instances.Num();
+
+	// Note that the state is accessed through its index below, as adding children reallocates the array
+	FInstanceState& State = Instances.AddDefaulted_GetRef();
+	State.Instance = InInstance;
+	State.Parent = InParent;
+	State.bPreExecuteOnGameThread = !bAllowWorkerThreads || !InInstance->CanBeExecutedOnAnyThread();
+
+	if (const UPointCloud* PointCloud = InInstance->GetPointCloud())
+	{
+		if (const int32* ResourceIndex = ResourceIndices.Find(PointCloud))
+		{
+			State.Resource = *ResourceIndex;
+		}
+		else
+		{
+			State.Resource = ResourceLocks.Add(MakeUnique<FCriticalSection>());
+			ResourceIndices.Add(PointCloud, State.Resource);
+		}
+	}
+
+	Dependents.AddDefaulted(2);
+	Prerequisites.AddDefaulted(2);
+
+	// Children are executed once their parent has applied its filters
+	if (InParent != INDEX_NONE)
+	{
+		AddDependency(PreExecuteNode(InParent), PreExecuteNode(InstanceIndex));
+	}
+
+	AddDependency(PreExecuteNode(InstanceIndex), PostExecuteNode(InstanceIndex));
+
+	// PostExecute nodes form a single chain in depth first order, the last node of each child subtree preceding the next one
+	int32 PreviousPostExecuteNode = InPreviousPostExecuteNode;
+
+	for (const FPointCloudRuleInstancePtr& Child : InInstance->Children)
+	{
+		if (Child)
+		{
+			PreviousPostExecuteNode = AddInstance(Child, InstanceIndex, PreviousPostExecuteNode);
+		}
+	}
+
+	if (PreviousPostExecuteNode != INDEX_NONE)
+	{
+		AddDependency(PreviousPostExecuteNode, PostExecuteNode(InstanceIndex));
+	}
+
+	return PostExecuteNode(InstanceIndex);
+}
+
+void FPointCloudSliceAndDiceRuleSetScheduler::AddDependency(int32 FromNode, int32 ToNode)
+{
+	Dependents[FromNode].Add(ToNode);
+	Prerequisites[ToNode].Add(FromNode);
+}
+
+bool FPointCloudSliceAndDiceRuleSetScheduler::IsGameThreadNode(int32 NodeIndex) const
+{
+	// Loading, saving and garbage collection happen in PostExecute, so it always runs on the game thread
+	return !IsPreExecuteNode(NodeIndex) || Instances[NodeIndex / 2].bPreExecuteOnGameThread;
+}
+
+TArray<int32> FPointCloudSliceAndDiceRuleSetScheduler::SortNodes() const
+{
+	const int32 NumNodes = Dependents.Num();
+
+	TArray<int32> PendingPrerequisites;
+	PendingPrerequisites.SetNumUninitialized(NumNodes);
+
+	TArray<int32> SortedNodes;
+	SortedNodes.Reserve(NumNodes);
+
+	for (int32 NodeIndex = 0; NodeIndex < NumNodes; ++NodeIndex)
+	{
+		PendingPrerequisites[NodeIndex] = Prerequisites[NodeIndex].Num();
+
+		if (PendingPrerequisites[NodeIndex] == 0)
+		{
+			SortedNodes.Add(NodeIndex);
+		}
+	}
+
+	for (int32 SortedIndex = 0; SortedIndex < SortedNodes.Num(); ++SortedIndex)
+	{
+		for (int32 Dependent : Dependents[SortedNodes[SortedIndex]])
+		{
+			if (--PendingPrerequisites[Dependent] == 0)
+			{
+				SortedNodes.Add(Dependent);
+			}
+		}
+	}
+
+	// Edges only go from parents to children and along the PostExecute chain, so the graph has no cycle
+	check(SortedNodes.Num() == NumNodes);
+
+	return SortedNodes;
+}
+
+void FPointCloudSliceAndDiceRuleSetScheduler::Execute()
+{
+	check(IsInGameThread());
+
+	const int32 NumNodes = Instances.Num() * 2;
+
+	if (NumNodes == 0)
+	{
+		return;
+	}
+
+	// Tasks are created once their prerequisites exist, they start as soon as those have completed
+	TArray<FGraphEventRef> NodeEvents;
+	NodeEvents.SetNum(NumNodes);
+
+	for (int32 NodeIndex : SortNodes())
+	{
+		FGraphEventArray NodePrerequisites;
+		NodePrerequisites.Reserve(Prerequisites[NodeIndex].Num());
+
+		for (int32 Prerequisite : Prerequisites[NodeIndex])
+		{
+			NodePrerequisites.Add(NodeEvents[Prerequisite]);
+		}
+
+		NodeEvents[NodeIndex] = FFunctionGraphTask::CreateAndDispatchWhenReady(
+			[this, NodeIndex]() { RunNode(NodeIndex); },
+			GET_STATID(STAT_RuleProcessorExecutionTime),
+			&NodePrerequisites,
+			IsGameThreadNode(NodeIndex) ? ENamedThreads::GameThread : ENamedThreads::AnyThread);
+	}
+
+	// Processes the game thread queue, and so the game thread nodes, until every node has completed
+	FTaskGraphInterface::Get().WaitUntilTasksComplete(NodeEvents, ENamedThreads::GameThread);
+}
+
+void FPointCloudSliceAndDiceRuleSetScheduler::RunNode(int32 NodeIndex)
+{
+	FInstanceState& State = Instances[NodeIndex / 2];
+
+	// Acquire the point cloud before blocking garbage collection, so a worker never waits on the game thread while holding the GC lock
+	TOptional<FScopeLock> ResourceLock;
+	TOptional<FGCScopeGuard> GCGuard;
+
+	auto LockResources = [this, &State, &ResourceLock, &GCGuard]()
+	{
+		if (State.Resource != INDEX_NONE)
+		{
+			ResourceLock.Emplace(ResourceLocks[State.Resource].Get());
+		}
+
+		// Views are created while executing rules, make sure they're not collected before they are referenced
+		if (!IsInGameThread())
+		{
+			GCGuard.Emplace();
+		}
+	};
+
+	if (IsPreExecuteNode(NodeIndex))
+	{
+		const FInstanceState* ParentState = (State.Parent != INDEX_NONE) ? &Instances[State.Parent] : nullptr;
+		State.bPruned = ParentState && (ParentState->bPruned || ParentState->bSkipChildren);
+
+		if (!State.bPruned)
+		{
+			LockResources();
+
+			static const FPointCloudStatId PreExecuteStatId = FPointCloudProfiler::GetStatId(TEXT("PreExecute"));
+			FPointCloudProfileScope ProfileScope(PreExecuteStatId, State.Instance.Get());
+
+			State.Instance->PreExecute(ExecutionContext);
+			State.bSkipChildren = State.Instance->IsSkipped() || State.Instance->AreChildrenSkipped();
+		}
+	}
+	else if (!State.bPruned)
+	{
+		LockResources();
+
+		static const FPointCloudStatId PostExecuteStatId = FPointCloudProfiler::GetStatId(TEXT("PostExecute"));
+		FPointCloudProfileScope ProfileScope(PostExecuteStatId, State.Instance.Get());
+
+		State.Instance->PostExecute(ExecutionContext);
+		State.Instance->ClearView();
+	}
+}
@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PointCloudSliceAndDiceRuleInstance.h"
+#include "PointCloudSliceAndDiceExecutionContext.h"
+
+/**
+* Executes a forest of rule instances as a dependency graph.
+*
+* Each rule instance contributes two nodes: its PreExecute, which depends on the PreExecute of its parent,
+* and its PostExecute, which depends on its own PreExecute. PostExecute nodes are also chained in the order
+* the single threaded executor would have run them (depth first, children in order) so that saving, unloading
+* and actor mapping always happen in the same order regardless of the number of threads.
+*
+* Each node is launched as its own task graph task, with the nodes it depends on as prerequisites, so worker
+* threads are only used while a node is actually running. PostExecute nodes and the PreExecute of instances that
+* cannot run on any thread are sent to the game thread queue, which Execute processes while waiting. Nodes working
+* on the same point cloud are serialized against each other, since the point cloud database and the views built on
+* it are not safe to use from several threads at once.
+*/
+class FPointCloudSliceAndDiceRuleSetScheduler
+{
+public:
+	/**
+	* Build the graph for the given root instances
+	* @param InRootInstances - The instances to execute, along with all their children
+	* @param InExecutionContext - The context passed to every PreExecute and PostExecute call
+	* @param bInAllowWorkerThreads - If false, every node is executed on the game thread
+	*/
+	FPointCloudSliceAndDiceRuleSetScheduler(const TArray<FPointCloudRuleInstancePtr>& InRootInstances, FSliceAndDiceExecutionContextPtr InExecutionContext, bool bInAllowWorkerThreads);
+
+	/** Execute every node and return once they have all completed. Must be called from the game thread */
+	void Execute();
+
+	/** Return the number of rule instances in the graph */
+	int32 NumInstances() const { return Instances.Num(); }
+
+private:
+	struct FInstanceState
+	{
+		FPointCloudRuleInstancePtr Instance;
+
+		// Index of the parent instance, INDEX_NONE for roots
+		int32 Parent = INDEX_NONE;
+
+		// Index of the lock guarding the point cloud used by this instance, INDEX_NONE if it has none
+		int32 Resource = INDEX_NONE;
+
+		bool bPreExecuteOnGameThread = true;
+
+		// Written by the PreExecute node, read by nodes that depend on it
+		bool bPruned = false;
+		bool bSkipChildren = false;
+	};
+
+	/** Node indices, each instance owns two consecutive nodes */
+	static int32 PreExecuteNode(int32 InstanceIndex) { return InstanceIndex * 2; }
+	static int32 PostExecuteNode(int32 InstanceIndex) { return InstanceIndex * 2 + 1; }
+	static bool IsPreExecuteNode(int32 NodeIndex) { return (NodeIndex & 1) == 0; }
+
+	/** Recursively add an instance and its children, and return the index of the last PostExecute node in the subtree */
+	int32 AddInstance(FPointCloudRuleInstancePtr InInstance, int32 InParent, int32 InPreviousPostExecuteNode);
+
+	/** Add an edge between two nodes */
+	void AddDependency(int32 FromNode, int32 ToNode);
+
+	/** Return true if the node has to be executed on the game thread */
+	bool IsGameThreadNode(int32 NodeIndex) const;
+
+	/** Return the nodes in an order where every node comes after the nodes it depends on */
+	TArray<int32> SortNodes() const;
+
+	/** Run a node, its dependencies have all completed */
+	void RunNode(int32 NodeIndex);
+
+private:
+	FSliceAndDiceExecutionContextPtr ExecutionContext;
+	bool bAllowWorkerThreads;
+
+	TArray<FInstanceState> Instances;
+
+	// Per node outgoing and incoming edges
+	TArray<TArray<int32>> Dependents;
+	TArray<TArray<int32>> Prerequisites;
+
+	// One lock per point cloud used by the instances
+	TArray<TUniquePtr<FCriticalSection>> ResourceLocks;
+	TMap<const UPointCloud*, int32> ResourceIndices;
+};
@@ -0,0 +1,472 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PointCloudSpatialIndex.h"
+#include "PointCloudUtils.h"
+
+#include "Async/ParallelFor.h"
+
+namespace PointCloudSpatialIndexPrivate
+{
+	// Subtrees at or below this number of points are intersected on the calling thread
+	static constexpr int32 MinPointsPerParallelTask = 1 << 16;
+
+	// Widen four floats to doubles, the filters are stored in double precision and Contains compares in double precision too
+	FORCEINLINE VectorRegister4Double LoadDoubles(const float* Values)
+	{
+		return VectorRegister4Double(VectorLoad(Values));
+	}
+}
+
+FPointCloudSpatialFilter FPointCloudSpatialFilter::MakeBox(const FBox& InBox, bool bInInvert)
+{
+	FPointCloudSpatialFilter Filter;
+	Filter.Type = EType::Box;
+	Filter.bInvert = bInInvert;
+	Filter.Box = InBox;
+	return Filter;
+}
+
+FPointCloudSpatialFilter FPointCloudSpatialFilter::MakeSphere(const FVector& InCenter, double InRadius)
+{
+	FPointCloudSpatialFilter Filter;
+	Filter.Type = EType::Sphere;
+	Filter.Center = InCenter;
+	Filter.RadiusSquared = InRadius * InRadius;
+	return Filter;
+}
+
+FPointCloudSpatialFilter FPointCloudSpatialFilter::MakeOrientedBox(const FTransform& Transform, bool bInInvert)
+{
+	FPointCloudSpatialFilter Filter;
+	Filter.Type = EType::OrientedBox;
+	Filter.bInvert = bInInvert;
+	Filter.WorldToLocal = Transform.ToMatrixWithScale().Inverse();
+	return Filter;
+}
+
+bool FPointCloudSpatialFilter::Contains(const FVector3f& Point) const
+{
+	return ContainsNonInverted(Point) != bInvert;
+}
+
+bool FPointCloudSpatialFilter::ContainsNonInverted(const FVector3f& Point) const
+{
+	switch (Type)
+	{
+	case EType::Box:
+		return Point.X >= Box.Min.X && Point.X <= Box.Max.X
+			&& Point.Y >= Box.Min.Y && Point.Y <= Box.Max.Y
+			&& Point.Z >= Box.Min.Z && Point.Z <= Box.Max.Z;
+
+	case EType::Sphere:
+		return FVector::DistSquared(FVector(Point), Center) < RadiusSquared;
+
+	case EType::OrientedBox:
+	{
+		const FVector LocalPoint = WorldToLocal.TransformPosition(FVector(Point));
+		return FMath::Abs(LocalPoint.X) <= 1.0 && FMath::Abs(LocalPoint.Y) <= 1.0 && FMath::Abs(LocalPoint.Z) <= 1.0;
+	}
+
+	default:
+		return true;
+	}
+}
+
+uint64 FPointCloudSpatialFilter::ContainsBlock(const float* X, const float* Y, const float* Z, int32 Num) const
+{
+	using namespace PointCloudSpatialIndexPrivate;
+
+	check(Num >= 0 && Num <= 64);
+
+	uint64 Mask = 0;
+	int32 Index = 0;
+
+	// Each case mirrors the arithmetic of ContainsNonInverted, in the same order, so both give the same result on the boundary
+	switch (Type)
+	{
+	case EType::Box:
+	{
+		const VectorRegister4Double MinX = VectorSetFloat1(Box.Min.X);
+		const VectorRegister4Double MinY = VectorSetFloat1(Box.Min.Y);
+		const VectorRegister4Double MinZ = VectorSetFloat1(Box.Min.Z);
+		const VectorRegister4Double MaxX = VectorSetFloat1(Box.Max.X);
+		const VectorRegister4Double MaxY = VectorSetFloat1(Box.Max.Y);
+		const VectorRegister4Double MaxZ = VectorSetFloat1(Box.Max.Z);
+
+		for (; Index + 4 <= Num; Index += 4)
+		{
+			const VectorRegister4Double PX = LoadDoubles(X + Index);
+			const VectorRegister4Double PY = LoadDoubles(Y + Index);
+			const VectorRegister4Double PZ = LoadDoubles(Z + Index);
+
+			const VectorRegister4Double InX = VectorBitwiseAnd(VectorCompareGE(PX, MinX), VectorCompareLE(PX, MaxX));
+			const VectorRegister4Double InY = VectorBitwiseAnd(VectorCompareGE(PY, MinY), VectorCompareLE(PY, MaxY));
+			const VectorRegister4Double InZ = VectorBitwiseAnd(VectorCompareGE(PZ, MinZ), VectorCompareLE(PZ, MaxZ));
+
+			Mask |= (uint64)VectorMaskBits(VectorBitwiseAnd(InX, VectorBitwiseAnd(InY, InZ))) << Index;
+		}
+		break;
+	}
+
+	case EType::Sphere:
+	{
+		const VectorRegister4Double CenterX = VectorSetFloat1(Center.X);
+		const VectorRegister4Double CenterY = VectorSetFloat1(Center.Y);
+		const VectorRegister4Double CenterZ = VectorSetFloat1(Center.Z);
+		const VectorRegister4Double Radius2 = VectorSetFloat1(RadiusSquared);
+
+		for (; Index + 4 <= Num; Index += 4)
+		{
+			const VectorRegister4Double DX = VectorSubtract(CenterX, LoadDoubles(X + Index));
+			const VectorRegister4Double DY = VectorSubtract(CenterY, LoadDoubles(Y + Index));
+			const VectorRegister4Double DZ = VectorSubtract(CenterZ, LoadDoubles(Z + Index));
+
+			const VectorRegister4Double DistSquared = VectorAdd(VectorAdd(VectorMultiply(DX, DX), VectorMultiply(DY, DY)), VectorMultiply(DZ, DZ));
+
+			Mask |= (uint64)VectorMaskBits(VectorCompareLT(DistSquared, Radius2)) << Index;
+		}
+		break;
+	}
+
+	case EType::OrientedBox:
+	{
+		// Columns of the local position, as FMatrix::TransformPosition computes them
+		VectorRegister4Double M[4][3];
+		for (int32 Row = 0; Row < 4; ++Row)
+		{
+			for (int32 Column = 0; Column < 3; ++Column)
+			{
+				M[Row][Column] = VectorSetFloat1(WorldToLocal.M[Row][Column]);
+			}
+		}
+
+		const VectorRegister4Double One = VectorSetFloat1(1.0);
+
+		for (; Index + 4 <= Num; Index += 4)
+		{
+			const VectorRegister4Double PX = LoadDoubles(X + Index);
+			const VectorRegister4Double PY = LoadDoubles(Y + Index);
+			const VectorRegister4Double PZ = LoadDoubles(Z + Index);
+
+			VectorRegister4Double Inside = VectorSetFloat1(-1.0);
+			for (int32 Column = 0; Column < 3; ++Column)
+			{
+				const VectorRegister4Double Local = VectorAdd(
+					VectorAdd(VectorMultiply(PX, M[0][Column]), VectorMultiply(PY, M[1][Column])),
+					VectorAdd(VectorMultiply(PZ, M[2][Column]), M[3][Column]));
+
+				Inside = VectorBitwiseAnd(Inside, VectorCompareLE(VectorAbs(Local), One));
+			}
+
+			Mask |= (uint64)VectorMaskBits(Inside) << Index;
+		}
+		break;
+	}
+
+	default:
+		break;
+	}
+
+	// The points left over from the last group of four
+	for (; Index < Num; ++Index)
+	{
+		if (ContainsNonInverted(FVector3f(X[Index], Y[Index], Z[Index])))
+		{
+			Mask |= 1ull << Index;
+		}
+	}
+
+	if (bInvert)
+	{
+		Mask ^= Num == 64 ? ~0ull : (1ull << Num) - 1;
+	}
+
+	return Mask;
+}
+
+FPointCloudSpatialFilter::EOverlap FPointCloudSpatialFilter::Classify(const FBox3f& Bounds) const
+{
+	const EOverlap Overlap = ClassifyNonInverted(Bounds);
+
+	if (!bInvert || Overlap == EOverlap::Partial)
+	{
+		return Overlap;
+	}
+
+	return Overlap == EOverlap::Inside ? EOverlap::Outside : EOverlap::Inside;
+}
+
+FPointCloudSpatialFilter::EOverlap FPointCloudSpatialFilter::ClassifyNonInverted(const FBox3f& Bounds) const
+{
+	const FBox NodeBounds(FVector(Bounds.Min), FVector(Bounds.Max));
+
+	switch (Type)
+	{
+	case EType::Box:
+		if (NodeBounds.Max.X < Box.Min.X || NodeBounds.Min.X > Box.Max.X ||
+			NodeBounds.Max.Y < Box.Min.Y || NodeBounds.Min.Y > Box.Max.Y ||
+			NodeBounds.Max.Z < Box.Min.Z || NodeBounds.Min.Z > Box.Max.Z)
+		{
+			return EOverlap::Outside;
+		}
+
+		return Box.IsInsideOrOn(NodeBounds.Min) && Box.IsInsideOrOn(NodeBounds.Max) ? EOverlap::Inside : EOverlap::Partial;
+
+	case EType::Sphere:
+	{
+		if (NodeBounds.ComputeSquaredDistanceToPoint(Center) >= RadiusSquared)
+		{
+			return EOverlap::Outside;
+		}
+
+		// The farthest corner of the box from the center
+		const FVector Farthest(
+			FMath::Max(FMath::Abs(Center.X - NodeBounds.Min.X), FMath::Abs(Center.X - NodeBounds.Max.X)),
+			FMath::Max(FMath::Abs(Center.Y - NodeBounds.Min.Y), FMath::Abs(Center.Y - NodeBounds.Max.Y)),
+			FMath::Max(FMath::Abs(Center.Z - NodeBounds.Min.Z), FMath::Abs(Center.Z - NodeBounds.Max.Z)));
+
+		return Farthest.SizeSquared() < RadiusSquared ? EOverlap::Inside : EOverlap::Partial;
+	}
+
+	case EType::OrientedBox:
+	{
+		// Bound the node in the local space of the oriented box, which is the unit box
+		const FBox LocalBounds = NodeBounds.TransformBy(WorldToLocal);
+
+		if (LocalBounds.Max.X < -1.0 || LocalBounds.Min.X > 1.0 ||
+			LocalBounds.Max.Y < -1.0 || LocalBounds.Min.Y > 1.0 ||
+			LocalBounds.Max.Z < -1.0 || LocalBounds.Min.Z > 1.0)
+		{
+			return EOverlap::Outside;
+		}
+
+		return LocalBounds.Min.GetMin() >= -1.0 && LocalBounds.Max.GetMax() <= 1.0 ? EOverlap::Inside : EOverlap::Partial;
+	}
+
+	default:
+		return EOverlap::Inside;
+	}
+}
+
+FPointCloudSpatialIndex::FPointCloudSpatialIndex(const TArray<int32>& InRowIds, const TArray<FVector3f>& InPositions)
+{
+	check(InRowIds.Num() == InPositions.Num());
+
+	const int32 Count = InRowIds.Num();
+
+	FBox Bounds(EForceInit::ForceInit);
+	for (const FVector3f& Position : InPositions)
+	{
+		Bounds += FVector(Position);
+	}
+
+	// Sort the points along a Morton curve so that nodes built over contiguous ranges are spatially coherent
+	TArray<TPair<uint64, int32>> Order;
+	Order.SetNumUninitialized(Count);
+
+	ParallelFor(Count, [&](int32 Index)
+		{
+			Order[Index] = TPair<uint64, int32>(PointCloud::MortonCode(FVector(InPositions[Index]), Bounds), Index);
+		});
+
+	Order.Sort([](const TPair<uint64, int32>& A, const TPair<uint64, int32>& B)
+		{
+			return A.Key < B.Key || (A.Key == B.Key && A.Value < B.Value);
+		});
+
+	PositionsX.SetNumUninitialized(Count);
+	PositionsY.SetNumUninitialized(Count);
+	PositionsZ.SetNumUninitialized(Count);
+	RowIds.SetNumUninitialized(Count);
+
+	int32 MaxRowId = 0;
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FVector3f& Position = InPositions[Order[Index].Value];
+		PositionsX[Index] = Position.X;
+		PositionsY[Index] = Position.Y;
+		PositionsZ[Index] = Position.Z;
+		RowIds[Index] = InRowIds[Order[Index].Value];
+		MaxRowId = FMath::Max(MaxRowId, RowIds[Index]);
+	}
+
+	IndexFromRowId.Init(INDEX_NONE, Count > 0 ? MaxRowId + 1 : 0);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		IndexFromRowId[RowIds[Index]] = Index;
+	}
+
+	Nodes.Reserve(FMath::Max(1, 2 * FMath::DivideAndRoundUp(Count, LeafSize)));
+	BuildNode(0, Count);
+}
+
+int32 FPointCloudSpatialIndex::BuildNode(int32 Begin, int32 End)
+{
+	const int32 NodeIndex = Nodes.AddUninitialized();
+	FNode& Node = Nodes[NodeIndex];
+	Node.Begin = Begin;
+	Node.End = End;
+	Node.Left = INDEX_NONE;
+	Node.Right = INDEX_NONE;
+
+	if (End - Begin > LeafSize)
+	{
+		// Split on a leaf boundary so that no two leaves share a word of a result bit array
+		const int32 NumLeaves = FMath::DivideAndRoundUp(End - Begin, LeafSize);
+		const int32 Middle = Begin + (NumLeaves / 2) * LeafSize;
+
+		const int32 Left = BuildNode(Begin, Middle);
+		const int32 Right = BuildNode(Middle, End);
+
+		Nodes[NodeIndex].Left = Left;
+		Nodes[NodeIndex].Right = Right;
+		Nodes[NodeIndex].Bounds = Nodes[Left].Bounds + Nodes[Right].Bounds;
+	}
+	else
+	{
+		FBox3f Bounds(EForceInit::ForceInit);
+		for (int32 Index = Begin; Index < End; ++Index)
+		{
+			Bounds += GetPosition(Index);
+		}
+
+		Nodes[NodeIndex].Bounds = Bounds;
+	}
+
+	return NodeIndex;
+}
+
+void FPointCloudSpatialIndex::Intersect(const FPointCloudSpatialFilter& Filter, TBitArray<>& InOutBits) const
+{
+	check(InOutBits.Num() == Num());
+
+	if (!Filter.IsSpatial() || Nodes.Num() == 0)
+	{
+		return;
+	}
+
+	// Find a set of disjoint subtrees to process in parallel. Every subtree covers whole leaves, so they never write to the same word
+	TArray<int32> Subtrees;
+	TArray<int32> Pending = { 0 };
+
+	while (Pending.Num() > 0)
+	{
+		const int32 NodeIndex = Pending.Pop(EAllowShrinking::No);
+		const FNode& Node = Nodes[NodeIndex];
+
+		if (Node.End - Node.Begin > PointCloudSpatialIndexPrivate::MinPointsPerParallelTask && Node.Left != INDEX_NONE && Filter.Classify(Node.Bounds) == FPointCloudSpatialFilter::EOverlap::Partial)
+		{
+			Pending.Add(Node.Left);
+			Pending.Add(Node.Right);
+		}
+		else
+		{
+			Subtrees.Add(NodeIndex);
+		}
+	}
+
+	ParallelFor(Subtrees.Num(), [&](int32 SubtreeIndex)
+		{
+			IntersectNode(Subtrees[SubtreeIndex], Filter, InOutBits);
+		}, Subtrees.Num() == 1);
+}
+
+void FPointCloudSpatialIndex::IntersectNode(int32 NodeIndex, const FPointCloudSpatialFilter& Filter, TBitArray<>& InOutBits) const
+{
+	const FNode& Node = Nodes[NodeIndex];
+
+	switch (Filter.Classify(Node.Bounds))
+	{
+	case FPointCloudSpatialFilter::EOverlap::Inside:
+		return;
+
+	case FPointCloudSpatialFilter::EOverlap::Outside:
+		InOutBits.SetRange(Node.Begin, Node.End - Node.Begin, false);
+		return;
+
+	default:
+		break;
+	}
+
+	if (Node.Left != INDEX_NONE)
+	{
+		IntersectNode(Node.Left, Filter, InOutBits);
+		IntersectNode(Node.Right, Filter, InOutBits);
+		return;
+	}
+
+	// Leaves start on a 64 bit boundary, so the mask of the leaf lines up with the words of the bit array
+	static_assert(LeafSize == 64 && NumBitsPerDWORD == 32, "Leaves are expected to cover two words of the result bit array");
+
+	const int32 NumInLeaf = Node.End - Node.Begin;
+	const uint64 Mask = Filter.ContainsBlock(PositionsX.GetData() + Node.Begin, PositionsY.GetData() + Node.Begin, PositionsZ.GetData() + Node.Begin, NumInLeaf);
+
+	uint32* Words = InOutBits.GetData() + Node.Begin / NumBitsPerDWORD;
+	Words[0] &= (uint32)Mask;
+	if (NumInLeaf > NumBitsPerDWORD)
+	{
+		Words[1] &= (uint32)(Mask >> NumBitsPerDWORD);
+	}
+}
+
+void FPointCloudSpatialIndex::IntersectRowIds(const TArray<int32>& InRowIds, TBitArray<>& InOutBits) const
+{
+	check(InOutBits.Num() == Num());
+
+	TBitArray<> Keep(false, Num());
+
+	for (int32 RowId : InRowIds)
+	{
+		if (IndexFromRowId.IsValidIndex(RowId) && IndexFromRowId[RowId] != INDEX_NONE)
+		{
+			Keep[IndexFromRowId[RowId]] = true;
+		}
+	}
+
+	InOutBits.CombineWithBitwiseAND(Keep, EBitwiseOperatorFlags::MaintainSize);
+}
+
+TArray<int32> FPointCloudSpatialIndex::GetRowIds(const TBitArray<>& Bits) const
+{
+	TArray<int32> Result;
+
+	for (TConstSetBitIterator<> It(Bits); It; ++It)
+	{
+		Result.Add(RowIds[It.GetIndex()]);
+	}
+
+	Result.Sort();
+
+	return Result;
+}
+
+FBox FPointCloudSpatialIndex::GetBounds(const TBitArray<>& Bits) const
+{
+	FBox3f Bounds(EForceInit::ForceInit);
+
+	for (TConstSetBitIterator<> It(Bits); It; ++It)
+	{
+		Bounds += GetPosition(It.GetIndex());
+	}
+
+	return FBox(Bounds);
+}
+
+int32 FPointCloudSpatialIndex::CountInBox(const TBitArray<>& Bits, const FBox& Box) const
+{
+	int32 Result = 0;
+
+	for (TConstSetBitIterator<> It(Bits); It; ++It)
+	{
+		const FVector3f Position = GetPosition(It.GetIndex());
+
+		if (Position.X > Box.Min.X && Position.X < Box.Max.X &&
+			Position.Y > Box.Min.Y && Position.Y < Box.Max.Y &&
+			Position.Z > Box.Min.Z && Position.Z < Box.Max.Z)
+		{
+			++Result;
+		}
+	}
+
+	return Result;
+}
@@ -12,6 +12,13 @@ namespace PointCloudSqliteHelpers
 		Value = (int)sqlite3_column_int(stmt, ColumnIndex);
 	}
 
+	void ResultRetrieval(sqlite3_stmt* stmt, int, int* ColumnIndices, int& ReadColumns, int64& Value)
+	{
+		int ColumnIndex = *ColumnIndices == -1 ? ReadColumns : *ColumnIndices;
+		++ReadColumns;
+		Value = (int64)sqlite3_column_int64(stmt, ColumnIndex);
+	}
+
 	void ResultRetrieval(sqlite3_stmt* stmt, int, int* ColumnIndices, int& ReadColumns, float& Value)
 	{
 		int ColumnIndex = *ColumnIndices == -1 ? ReadColumns : *ColumnIndices;
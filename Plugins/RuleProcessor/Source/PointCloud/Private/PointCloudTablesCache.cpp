@@ -4,18 +4,58 @@
 #include "PointCloudImpl.h"
 
 FPointCloudTemporaryTablesCache::FPointCloudTemporaryTablesCache()
-	: TemporaryTables(UPointCloudImpl::GetTemporaryTableCacheSize() + 1)
-	, CacheSize(UPointCloudImpl::GetTemporaryTableCacheSize())
-	, EjectedTablesCount(0)
+	: FPointCloudTemporaryTablesCache(UPointCloudImpl::GetTemporaryTableCacheSize(), UPointCloudImpl::GetTemporaryTableMemoryBudget())
 {
 
 }
 
+FPointCloudTemporaryTablesCache::FPointCloudTemporaryTablesCache(int32 InCacheSize, int64 InMemoryBudget, int32 InNumShards)
+	: NumShards(FMath::Max(InNumShards, 1))
+	, UseCount(0)
+	, ContendedLocks(0)
+	, LockWaitCycles(0)
+{
+	Shards = MakeUnique<FShard[]>(NumShards);
+
+	// Round up so the cache holds at least InCacheSize tables when they are spread evenly
+	ShardCacheSize = FMath::Max(FMath::DivideAndRoundUp(InCacheSize, NumShards), 1);
+	ShardMemoryBudget = FMath::Max<int64>(InMemoryBudget / NumShards, 1);
+}
+
+FPointCloudTemporaryTablesCache::FShard& FPointCloudTemporaryTablesCache::LockShard(const FString& InKey) const
+{
+	FShard& Shard = Shards[GetTypeHash(InKey) % (uint32)NumShards];
+	LockShard(Shard);
+	return Shard;
+}
+
+void FPointCloudTemporaryTablesCache::LockShard(const FShard& Shard) const
+{
+	// Only time the lock when it has to be waited on, so the uncontended path stays cheap
+	if (!Shard.Lock.TryLock())
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		Shard.Lock.Lock();
+
+		LockWaitCycles.fetch_add(FPlatformTime::Cycles64() - StartCycles, std::memory_order_relaxed);
+		ContendedLocks.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void FPointCloudTemporaryTablesCache::TouchEntry(FShard& Shard, FEntry& Entry) const
+{
+	// GreedyDual-Size-Frequency. Tables without a size or cost all get the shard's inflation as their priority, and are evicted least
+	// recently used first
+	const double Cost = Entry.BuildSeconds * Entry.Hits;
+	Entry.Priority = Shard.Inflation + (Entry.SizeBytes > 0 ? Cost / (double)Entry.SizeBytes : Cost);
+	Entry.LastUsed = ++UseCount;
+}
+
 bool FPointCloudTemporaryTablesCache::Contains(const FString& InKey) const
 {
-	CacheLock.Lock();
-	bool bFound = TemporaryTables.Contains(InKey);
-	CacheLock.Unlock();
+	FShard& Shard = LockShard(InKey);
+	bool bFound = Shard.Entries.Contains(InKey);
+	Shard.Lock.Unlock();
 	return bFound;
 }
 
@@ -24,13 +64,20 @@ FString FPointCloudTemporaryTablesCache::GetFromCache(const FString& InKey, int3
 	FString CachedTableName;
 	int32 CacheHitCount = 0;
 
-	CacheLock.Lock();
-	if (TemporaryTables.Contains(InKey))
+	FShard& Shard = LockShard(InKey);
+	if (FEntry* Entry = Shard.Entries.Find(InKey))
 	{
-		CachedTableName = TemporaryTables.FindAndTouchRef(InKey);
-		CacheHitCount = ++CacheHits[CachedTableName];
+		CacheHitCount = ++Entry->Hits;
+		TouchEntry(Shard, *Entry);
+
+		CachedTableName = Entry->Name;
+		++Shard.Hits;
+	}
+	else
+	{
+		++Shard.Misses;
 	}
-	CacheLock.Unlock();
+	Shard.Lock.Unlock();
 
 	if (OutCachedHits)
 	{
@@ -40,59 +87,167 @@ FString FPointCloudTemporaryTablesCache::GetFromCache(const FString& InKey, int3
 	return CachedTableName;
 }
 
-FString FPointCloudTemporaryTablesCache::AddToCache(const FString& InKey, const FString& InName)
+FPointCloudTemporaryTablesCache::ETouchResult FPointCloudTemporaryTablesCache::TryTouch(const FString& InKey, int32* OutCachedHits)
 {
-	FString TableToEject;
-
-	CacheLock.Lock();
-	TemporaryTables.Add(InKey, InName);
+	if (OutCachedHits)
+	{
+		*OutCachedHits = 0;
+	}
 
-	// Add to cache hits
-	if (CacheHits.Contains(InName))
+	FShard& Shard = Shards[GetTypeHash(InKey) % (uint32)NumShards];
+	if (!Shard.Lock.TryLock())
 	{
-		CacheHits[InName] = 1;
+		return ETouchResult::Busy;
 	}
-	else
+
+	bool bFound = false;
+	if (FEntry* Entry = Shard.Entries.Find(InKey))
 	{
-		CacheHits.Add(InName, 1);
+		const int32 CacheHitCount = ++Entry->Hits;
+		TouchEntry(Shard, *Entry);
+
+		++Shard.Hits;
+		bFound = true;
+
+		if (OutCachedHits)
+		{
+			*OutCachedHits = CacheHitCount;
+		}
 	}
+	Shard.Lock.Unlock();
+
+	return bFound ? ETouchResult::Touched : ETouchResult::NotCached;
+}
+
+TArray<FString> FPointCloudTemporaryTablesCache::AddToCache(const FString& InKey, const FString& InName, int64 InSizeBytes, double InBuildSeconds)
+{
+	TArray<FString> TablesToEject;
+
+	FShard& Shard = LockShard(InKey);
 
-	if (TemporaryTables.Num() > CacheSize)
+	FEntry& Entry = Shard.Entries.FindOrAdd(InKey);
+	Shard.SizeBytes += InSizeBytes - Entry.SizeBytes;
+
+	if (Entry.Name != InName && !Entry.Name.IsEmpty())
 	{
-		TableToEject = *TemporaryTables.RemoveLeastRecent();
-		++EjectedTablesCount;
+		// The key now refers to another table, the previous one is no longer reachable
+		TablesToEject.Add(Entry.Name);
 	}
 
+	Entry.Name = InName;
+	Entry.SizeBytes = InSizeBytes;
+	Entry.BuildSeconds = InBuildSeconds;
+	Entry.Hits = 1;
+	TouchEntry(Shard, Entry);
+
 #if defined RULEPROCESSOR_ENABLE_LOGGING
 	// Add to cache misses as well
-	if (CacheMisses.Contains(InName))
+	Shard.CacheMisses.FindOrAdd(InName)++;
+#endif
+
+	// Evict until the shard is back within its share of the budget, always keeping the table that was just added
+	while (Shard.Entries.Num() > 1 && (Shard.Entries.Num() > ShardCacheSize || Shard.SizeBytes > ShardMemoryBudget))
 	{
-		CacheMisses[InName]++;
+		const FString* VictimKey = nullptr;
+		const FEntry* Victim = nullptr;
+
+		// Shards only hold a small share of the tables, so a linear search is cheaper than keeping them sorted
+		for (const TPair<FString, FEntry>& Candidate : Shard.Entries)
+		{
+			if (Candidate.Key == InKey)
+			{
+				continue;
+			}
+
+			if (Victim == nullptr || Candidate.Value.Priority < Victim->Priority
+				|| (Candidate.Value.Priority == Victim->Priority && Candidate.Value.LastUsed < Victim->LastUsed))
+			{
+				VictimKey = &Candidate.Key;
+				Victim = &Candidate.Value;
+			}
+		}
+
+		check(Victim);
+
+		Shard.Inflation = Victim->Priority;
+		Shard.SizeBytes -= Victim->SizeBytes;
+		++Shard.Evictions;
+
+		TablesToEject.Add(Victim->Name);
+		Shard.Entries.Remove(*VictimKey);
 	}
-	else
+
+	Shard.Lock.Unlock();
+
+	return TablesToEject;
+}
+
+TArray<FString> FPointCloudTemporaryTablesCache::RemoveAll()
+{
+	TArray<FString> Tables;
+
+	for (int32 ShardIndex = 0; ShardIndex < NumShards; ++ShardIndex)
 	{
-		CacheMisses.Add(InName, 1);
-	}
-#endif
+		FShard& Shard = Shards[ShardIndex];
+		LockShard(Shard);
+
+		for (const TPair<FString, FEntry>& Entry : Shard.Entries)
+		{
+			Tables.Add(Entry.Value.Name);
+		}
 
-	CacheLock.Unlock();
+		Shard.Entries.Empty();
+		Shard.SizeBytes = 0;
+		Shard.Inflation = 0.0;
 
-	return TableToEject;
+		Shard.Lock.Unlock();
+	}
+
+	return Tables;
 }
 
-FString FPointCloudTemporaryTablesCache::RemoveLeastRecentNotThreadSafe()
+FPointCloudTemporaryTablesCache::FCacheStats FPointCloudTemporaryTablesCache::GetStats() const
 {
-	if (TemporaryTables.Num() > 0)
+	FCacheStats Result;
+
+	for (int32 ShardIndex = 0; ShardIndex < NumShards; ++ShardIndex)
 	{
-		FString TableToDrop = *TemporaryTables.RemoveLeastRecent();
+		const FShard& Shard = Shards[ShardIndex];
+		LockShard(Shard);
 
-		// Remove from cache
-		CacheHits.Remove(TableToDrop);
+		Result.Hits += Shard.Hits;
+		Result.Misses += Shard.Misses;
+		Result.Evictions += Shard.Evictions;
+		Result.NumTables += Shard.Entries.Num();
+		Result.SizeBytes += Shard.SizeBytes;
 
-		return TableToDrop;
+		Shard.Lock.Unlock();
 	}
-	else
+
+	Result.ContendedLocks = ContendedLocks.load(std::memory_order_relaxed);
+	Result.LockWaitSeconds = FPlatformTime::ToSeconds64(LockWaitCycles.load(std::memory_order_relaxed));
+
+	return Result;
+}
+
+#if defined RULEPROCESSOR_ENABLE_LOGGING
+TMap<FString, int32> FPointCloudTemporaryTablesCache::GetCacheMisses() const
+{
+	TMap<FString, int32> Result;
+
+	for (int32 ShardIndex = 0; ShardIndex < NumShards; ++ShardIndex)
 	{
-		return FString();
+		const FShard& Shard = Shards[ShardIndex];
+		LockShard(Shard);
+
+		for (const TPair<FString, int32>& Record : Shard.CacheMisses)
+		{
+			Result.FindOrAdd(Record.Key) += Record.Value;
+		}
+
+		Shard.Lock.Unlock();
 	}
-}
\ No newline at end of file
+
+	return Result;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PointCloudTilePartition.h"
+#include "PointCloudSpatialIndex.h"
+
+#include "Async/ParallelFor.h"
+
+namespace PointCloudTilePartitionPrivate
+{
+	// Fewer points than this are not worth a task of their own
+	static constexpr int32 MinPointsPerChunk = 16384;
+
+	// Chunk counts are held per tile, so the number of chunks is bounded to keep them small on large grids
+	static constexpr int32 MaxChunks = 64;
+
+	/**
+	* Return the range of tiles along an axis a coordinate can belong to. This is the tile the coordinate falls in, along with the neighbouring
+	* tile when the coordinate is close enough to the face between them that the tolerance of the tile filters can put it in both
+	*/
+	void GetCandidateTiles(double Coordinate, double GridMin, double TileSize, int32 NumTiles, int32& OutFirst, int32& OutLast)
+	{
+		if (!(TileSize > 0.0))
+		{
+			OutFirst = 0;
+			OutLast = NumTiles - 1;
+			return;
+		}
+
+		const double Position = (Coordinate - GridMin) / TileSize;
+		const int32 Tile = FMath::Clamp(FMath::FloorToInt32(Position), 0, NumTiles - 1);
+
+		// The filters widen the tiles by a millionth of their coordinates, keep a generous margin over that and the float precision of the points
+		const double Margin = 0.01 + 1.0e-5 * (FMath::Abs(Coordinate) + 1.0) / TileSize;
+
+		OutFirst = (Tile > 0 && Position - Tile < Margin) ? Tile - 1 : Tile;
+		OutLast = (Tile < NumTiles - 1 && Tile + 1 - Position < Margin) ? Tile + 1 : Tile;
+	}
+}
+
+FPointCloudTilePartition::FPointCloudTilePartition(const TSharedPtr<const FPointCloudSpatialIndex>& InSpatialIndex, const TBitArray<>& Bits, const FBox& InGridBounds, const FIntVector& InNumTiles, TFunctionRef<FPointCloudSpatialFilter(const FIntVector& Tile)> MakeTileFilter)
+	: SpatialIndex(InSpatialIndex)
+	, GridBounds(InGridBounds)
+	, NumTiles(InNumTiles)
+{
+	using namespace PointCloudTilePartitionPrivate;
+
+	check(SpatialIndex.IsValid());
+	check(Bits.Num() == SpatialIndex->Num());
+	check(NumTiles.X > 0 && NumTiles.Y > 0 && NumTiles.Z > 0);
+
+	const int32 TotalTiles = NumTiles.X * NumTiles.Y * NumTiles.Z;
+
+	TArray<FPointCloudSpatialFilter> TileFilters;
+	TileFilters.Reserve(TotalTiles);
+
+	for (int32 X = 0; X < NumTiles.X; ++X)
+	{
+		for (int32 Y = 0; Y < NumTiles.Y; ++Y)
+		{
+			for (int32 Z = 0; Z < NumTiles.Z; ++Z)
+			{
+				TileFilters.Add(MakeTileFilter(FIntVector(X, Y, Z)));
+			}
+		}
+	}
+
+	TArray<int32> SourcePoints;
+	SourcePoints.Reserve(Bits.CountSetBits());
+
+	for (TConstSetBitIterator<> It(Bits); It; ++It)
+	{
+		SourcePoints.Add(It.GetIndex());
+	}
+
+	const FVector TileSize = GridBounds.GetSize() / FVector(NumTiles);
+
+	auto ForEachTile = [this, &TileFilters, &TileSize](int32 PointIndex, auto&& Callback)
+	{
+		const FVector3f Position = SpatialIndex->GetPosition(PointIndex);
+
+		FIntVector First, Last;
+		GetCandidateTiles(Position.X, GridBounds.Min.X, TileSize.X, NumTiles.X, First.X, Last.X);
+		GetCandidateTiles(Position.Y, GridBounds.Min.Y, TileSize.Y, NumTiles.Y, First.Y, Last.Y);
+		GetCandidateTiles(Position.Z, GridBounds.Min.Z, TileSize.Z, NumTiles.Z, First.Z, Last.Z);
+
+		for (int32 X = First.X; X <= Last.X; ++X)
+		{
+			for (int32 Y = First.Y; Y <= Last.Y; ++Y)
+			{
+				for (int32 Z = First.Z; Z <= Last.Z; ++Z)
+				{
+					const int32 TileIndex = GetTileIndex(FIntVector(X, Y, Z));
+
+					if (TileFilters[TileIndex].Contains(Position))
+					{
+						Callback(TileIndex);
+					}
+				}
+			}
+		}
+	};
+
+	const int32 NumChunks = FMath::Clamp(SourcePoints.Num() / MinPointsPerChunk, 1, MaxChunks);
+	const int32 PointsPerChunk = FMath::DivideAndRoundUp(SourcePoints.Num(), NumChunks);
+
+	// Count the points of each tile in each chunk
+	TArray<int32> ChunkOffsets;
+	ChunkOffsets.SetNumZeroed(NumChunks * TotalTiles);
+
+	ParallelFor(NumChunks, [&](int32 Chunk)
+	{
+		int32* Counts = ChunkOffsets.GetData() + Chunk * TotalTiles;
+
+		for (int32 Point = Chunk * PointsPerChunk, End = FMath::Min(Point + PointsPerChunk, SourcePoints.Num()); Point < End; ++Point)
+		{
+			ForEachTile(SourcePoints[Point], [Counts](int32 TileIndex) { ++Counts[TileIndex]; });
+		}
+	});
+
+	// Turn the counts into the offset each chunk writes its points of a tile at, chunks in order so tiles keep the order of the index
+	TileStarts.SetNumUninitialized(TotalTiles + 1);
+
+	int32 Offset = 0;
+	for (int32 TileIndex = 0; TileIndex < TotalTiles; ++TileIndex)
+	{
+		TileStarts[TileIndex] = Offset;
+
+		for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+		{
+			const int32 Count = ChunkOffsets[Chunk * TotalTiles + TileIndex];
+			ChunkOffsets[Chunk * TotalTiles + TileIndex] = Offset;
+			Offset += Count;
+		}
+	}
+	TileStarts[TotalTiles] = Offset;
+
+	Points.SetNumUninitialized(Offset);
+
+	ParallelFor(NumChunks, [&](int32 Chunk)
+	{
+		int32* Cursors = ChunkOffsets.GetData() + Chunk * TotalTiles;
+
+		for (int32 Point = Chunk * PointsPerChunk, End = FMath::Min(Point + PointsPerChunk, SourcePoints.Num()); Point < End; ++Point)
+		{
+			const int32 PointIndex = SourcePoints[Point];
+			ForEachTile(PointIndex, [this, Cursors, PointIndex](int32 TileIndex) { Points[Cursors[TileIndex]++] = PointIndex; });
+		}
+	});
+}
+
+TBitArray<> FPointCloudTilePartition::MakeBits(int32 TileIndex) const
+{
+	TBitArray<> Bits(false, SpatialIndex->Num());
+
+	for (const int32 PointIndex : GetPoints(TileIndex))
+	{
+		Bits[PointIndex] = true;
+	}
+
+	return Bits;
+}
+
+bool FPointCloudTilePartition::IsSource(const UPointCloudView* ParentView, const UObject* PointCloud) const
+{
+	if (PointCloud == nullptr || SourcePointCloud.Get() != PointCloud)
+	{
+		return false;
+	}
+
+	// A view without parent has every point of the point cloud, a partition made from one can't be used under a parent that has been collected
+	return bHasSourceParentView ? (ParentView != nullptr && SourceParentView.Get() == ParentView) : ParentView == nullptr;
+}
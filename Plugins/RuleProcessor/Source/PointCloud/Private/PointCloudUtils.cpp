@@ -2,6 +2,7 @@
 
 #include "PointCloudUtils.h"
 #include "PointCloudImpl.h"
+#include "Misc/Paths.h"
 
 namespace PointCloud
 {
@@ -71,8 +72,18 @@ namespace PointCloud
 	/**
 	* QueryLogger struct implementation
 	*/
-	QueryLogger::QueryLogger(const UPointCloudImpl* InPointCloud, const FString& InQuery, const FString& InLabel, const FString& InFile, const uint32 InLine)
+	FPointCloudStatId QueryLogger::GetStatId(const FString& InLabel, const FString& InFile, const uint32 InLine)
 	{
+		return FPointCloudProfiler::GetStatId(InLabel.IsEmpty() ? FString::Printf(TEXT("Query %s:%u"), *FPaths::GetCleanFilename(InFile), InLine) : InLabel);
+	}
+
+	QueryLogger::QueryLogger(const UPointCloudImpl* InPointCloud, const FString& InQuery, const FString& InLabel, const FString& InFile, const uint32 InLine, FPointCloudStatId InStatId)
+	{
+		if (FPointCloudProfiler::IsEnabled())
+		{
+			ProfileScope.Emplace(InStatId != INDEX_NONE ? InStatId : GetStatId(InLabel, InFile, InLine));
+		}
+
 #if defined(RULEPROCESSOR_ENABLE_LOGGING)
 		check(InPointCloud);
 		PointCloud = InPointCloud;
@@ -100,4 +111,29 @@ namespace PointCloud
 
 #endif // RULEPROCESSOR_ENABLE_LOGGING
 	}
+
+	static uint64 SpreadMortonBits(uint64 Value)
+	{
+		// Spread the lower 21 bits of the value so that there are two zero bits between each bit
+		Value &= 0x1fffff;
+		Value = (Value | Value << 32) & 0x1f00000000ffff;
+		Value = (Value | Value << 16) & 0x1f0000ff0000ff;
+		Value = (Value | Value << 8) & 0x100f00f00f00f00f;
+		Value = (Value | Value << 4) & 0x10c30c30c30c30c3;
+		Value = (Value | Value << 2) & 0x1249249249249249;
+		return Value;
+	}
+
+	uint64 MortonCode(const FVector& Position, const FBox& Bounds)
+	{
+		const double MaxCell = (double)((1 << 21) - 1);
+		const FVector Extent = Bounds.GetSize();
+
+		const FVector Cell(
+			Extent.X > 0.0 ? FMath::Clamp((Position.X - Bounds.Min.X) * MaxCell / Extent.X, 0.0, MaxCell) : 0.0,
+			Extent.Y > 0.0 ? FMath::Clamp((Position.Y - Bounds.Min.Y) * MaxCell / Extent.Y, 0.0, MaxCell) : 0.0,
+			Extent.Z > 0.0 ? FMath::Clamp((Position.Z - Bounds.Min.Z) * MaxCell / Extent.Z, 0.0, MaxCell) : 0.0);
+
+		return SpreadMortonBits((uint64)Cell.X) | (SpreadMortonBits((uint64)Cell.Y) << 1) | (SpreadMortonBits((uint64)Cell.Z) << 2);
+	}
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "PointCloudConfig.h"
+#include "PointCloudProfiler.h"
 
 class UPointCloudImpl;
 
@@ -28,9 +29,16 @@ namespace PointCloud
 
 	struct QueryLogger
 	{
-		QueryLogger(const UPointCloudImpl* InPointCloud, const FString& InQuery, const FString& InLabel = FString(), const FString& InFile = FString(), const uint32 InLine = 0);
+		/** @param InStatId - The id to profile the query under, see POINTCLOUD_QUERY_STAT_ID. If INDEX_NONE it is looked up from the label or call site on every query */
+		QueryLogger(const UPointCloudImpl* InPointCloud, const FString& InQuery, const FString& InLabel = FString(), const FString& InFile = FString(), const uint32 InLine = 0, FPointCloudStatId InStatId = INDEX_NONE);
 		~QueryLogger();
 
+		/** Return the id a query is profiled under: its label, or its call site when it has no label */
+		static FPointCloudStatId GetStatId(const FString& InLabel, const FString& InFile, const uint32 InLine);
+
+		// Profiled under the label, or the call site when there is no label, see t.RuleProcessor.Profile
+		TOptional<FPointCloudProfileScope> ProfileScope;
+
 #if defined(RULEPROCESSOR_ENABLE_LOGGING)
 		const UPointCloud* PointCloud;
 		UPointCloud::LogEntry LogEntry;
@@ -45,4 +53,14 @@ namespace PointCloud
 #endif
 #endif // RULEPROCESSOR_ENABLE_LOGGING
 	};
+
+	/**
+	* Return the Morton code of a position, quantized to 21 bits per axis over the given bounds
+	* @param Position - The position to encode, values outside of Bounds are clamped
+	* @param Bounds - The bounds the quantization grid covers
+	*/
+	uint64 MortonCode(const FVector& Position, const FBox& Bounds);
 }
+
+/** The id queries made at this call site are profiled under, interned the first time the call site is reached */
+#define POINTCLOUD_QUERY_STAT_ID(Label) []() { static const FPointCloudStatId StatId = PointCloud::QueryLogger::GetStatId(Label, __FILE__, __LINE__); return StatId; }()
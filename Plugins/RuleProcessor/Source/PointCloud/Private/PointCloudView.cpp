@@ -3,6 +3,108 @@
 #include "PointCloudView.h"
 #include "PointCloudImpl.h"
 #include "PointCloudSQLExtensions.h"
+#include "PointCloudSpatialIndex.h"
+#include "PointCloudTilePartition.h"
+#include "PointCloudUtils.h"
+
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarNativeSpatialFilters(
+	TEXT("t.RuleProcessor.NativeSpatialFilters"),
+	1,
+	TEXT("If non-zero, spatial view filters are evaluated against an in-memory spatial index instead of in SQL."));
+
+static TAutoConsoleVariable<int32> CVarNativeMetadata(
+	TEXT("t.RuleProcessor.NativeMetadata"),
+	1,
+	TEXT("If non-zero, metadata view filters, values and counts are evaluated against in-memory attribute indices instead of in SQL."));
+
+namespace PointCloudViewPrivate
+{
+	/** Return the bounds of a tile of a grid */
+	FBox MakeTileBox(const FBox& GridBounds, const FIntVector& NumTiles, const FIntVector& Tile)
+	{
+		const FVector TileOffset = GridBounds.Min;
+		const FVector TileSize = (GridBounds.Max - GridBounds.Min) / FVector(NumTiles);
+		const FVector TileMin = TileOffset + TileSize * FVector(Tile);
+		const FVector TileMax = TileOffset + TileSize * FVector(Tile + FIntVector(1));
+
+		return FBox(TileMin, TileMax);
+	}
+
+	/** Return the box actually queried by FilterOnBoundingBox */
+	FBox MakeQueryBox(const FBox& Query)
+	{
+		// We will increase/decrease values by a small value around the last digit we'll display to make sure we do the proper query
+		const double Iota = 1.0e-6;
+
+		const FVector QueryMin = FVector(
+			Query.Min.X * (1.0 - FMath::Sign(Query.Min.X) * Iota),
+			Query.Min.Y * (1.0 - FMath::Sign(Query.Min.Y) * Iota),
+			Query.Min.Z * (1.0 - FMath::Sign(Query.Min.Z) * Iota));
+
+		const FVector QueryMax = FVector(
+			Query.Max.X * (1.0 + FMath::Sign(Query.Max.X) * Iota),
+			Query.Max.Y * (1.0 + FMath::Sign(Query.Max.Y) * Iota),
+			Query.Max.Z * (1.0 + FMath::Sign(Query.Max.Z) * Iota));
+
+		return FBox(QueryMin, QueryMax);
+	}
+
+	/** Call a function with the rowid and the index of each point of a result set that has a value in an attribute index, in rowid order */
+	template<typename FunctionType>
+	void ForEachPointWithValue(const FPointCloudAttributeIndex& AttributeIndex, const TBitArray<>* Bits, FunctionType&& Function)
+	{
+		const FPointCloudSpatialIndex& Index = *AttributeIndex.GetSpatialIndex();
+
+		for (const int32 RowId : Index.GetRowIds(Bits ? *Bits : Index.MakeFullSet()))
+		{
+			const int32 PointIndex = Index.GetIndexFromRowId(RowId);
+
+			if (AttributeIndex.GetValueIndex(PointIndex) != INDEX_NONE)
+			{
+				Function(RowId, PointIndex);
+			}
+		}
+	}
+}
+
+FPointCloudViewPoints::FPointCloudViewPoints(const UPointCloudView* InSourceView)
+	: SourceView(InSourceView)
+{
+	if (InSourceView)
+	{
+		Points = InSourceView->GetPerIdTransforms();
+	}
+}
+
+bool FPointCloudViewPoints::GetMetadataValue(int32 PointIndex, const FString& Key, FString& OutValue) const
+{
+	TSharedPtr<const TMap<int, FString>> Values;
+
+	{
+		FScopeLock Lock(&MetadataValuesLock);
+
+		TSharedPtr<const TMap<int, FString>>& CachedValues = MetadataValues.FindOrAdd(Key);
+
+		if (!CachedValues.IsValid())
+		{
+			// One query for every point, rather than one per point
+			const UPointCloudView* View = SourceView.Get();
+			CachedValues = MakeShared<const TMap<int, FString>>(View ? View->GetMetadataValues(Key) : TMap<int, FString>());
+		}
+
+		Values = CachedValues;
+	}
+
+	if (const FString* Value = Values->Find(GetId(PointIndex)))
+	{
+		OutValue = *Value;
+		return true;
+	}
+
+	return false;
+}
 
 UPointCloudView::~UPointCloudView()
 {
@@ -16,12 +118,27 @@ int32 UPointCloudView::GetCount() const
 		return 0;
 	}
 
+	int32 PointIndex;
+	if (GetSinglePoint(PointIndex))
+	{
+		return 1;
+	}
+
 	if(HasFiltersApplied()==false)
 	{
 		return PointCloud->GetValue<int>(FString(TEXT("SELECT COUNT(*) FROM Vertex")), "COUNT(*)");
 	}
 	else
 	{
+		if (UseNativeFilters())
+		{
+			TSharedPtr<const FPointCloudSpatialIndex> Index;
+			if (TSharedPtr<const TBitArray<>> ResultBits = GetFilterResultBits(Index))
+			{
+				return ResultBits->CountSetBits();
+			}
+		}
+
 		int Count = 0;
 
 		const FString ResultTableName = GetFilterResultTable();
@@ -36,10 +153,17 @@ const FString& UPointCloudView::GetHash() const
 {
 	if (CachedResultHash.IsEmpty())
 	{
+		int32 PointIndex;
+
 		if (PointCloud == nullptr)
 		{
 			// Nothing
 		}
+		else if (const FPointCloudViewPoints* Points = GetSinglePoint(PointIndex))
+		{
+			// Same hash as the result table, which holds the id of the point
+			CachedResultHash = SQLExtension::HashIntegerRow(Points->GetId(PointIndex));
+		}
 		else if (HasFiltersApplied() == false)
 		{
 			// Return hash from point cloud
@@ -66,7 +190,7 @@ FString UPointCloudView::HashQueryResults(const FString& Query) const
 
 	if (PointCloud)
 	{
-		PointCloud->RunQuery(HashQuery, SQLExtension::Sha3CallBack, &QueryHash, __FILE__, __LINE__);
+		PointCloud->RunQuery(HashQuery, SQLExtension::Sha3CallBack, &QueryHash, __FILE__, __LINE__, POINTCLOUD_QUERY_STAT_ID(FString()));
 	}
 
 	return QueryHash;
@@ -77,6 +201,12 @@ void UPointCloudView::DirtyHash()
 	// Not threadsafe; should never be called by a non-owning user
 	CachedResultHash = FString();
 
+	{
+		FScopeLock Lock(&CachedResultBitsLock);
+		CachedResultBits.Reset();
+		CachedResultIndex.Reset();
+	}
+
 	// Need to dirty in child views as well, as any changes in this view could have an impact
 	// in child views
 	for (UPointCloudView* View : ChildViews)
@@ -121,6 +251,20 @@ UPointCloudView* UPointCloudView::MakeChildView()
 	return ChildView;
 }
 
+UPointCloudView* UPointCloudView::MakePointView(const TSharedPtr<const FPointCloudViewPoints>& InPoints, int32 InPointIndex)
+{
+	check(InPoints.IsValid() && InPoints->Num() > InPointIndex);
+
+	UPointCloudView* PointView = MakeChildView();
+
+	// Keep the statement so the hash, the actor mappings and any filter stacked on top are the same as with FilterOnIndex
+	PointView->FilterOnIndex(InPoints->GetId(InPointIndex));
+	PointView->SinglePoints = InPoints;
+	PointView->SinglePointIndex = InPointIndex;
+
+	return PointView;
+}
+
 void UPointCloudView::RemoveChildView(UPointCloudView* ChildView)
 {
 	ChildViewsLock.Lock();
@@ -150,7 +294,7 @@ void UPointCloudView::FilterOnBoundingSphere(const FVector& Center, float Radius
 										Center.X, Center.Y, Center.Z, 
 										Radius);
 
-	AddFilterStatement(FullQuery);	
+	AddFilterStatement(FullQuery, FPointCloudSpatialFilter::MakeSphere(Center, Radius));
 	
 	return;
 }
@@ -164,18 +308,9 @@ void UPointCloudView::FilterOnBoundingBox(const FBox& Query, bool bInvertSelecti
 
 	FString FullQuery;
 
-	// We will increase/decrease values by a small value around the last digit we'll display to make sure we do the proper query
-	const double Iota = 1.0e-6;
-
-	FVector QueryMin = FVector(
-		Query.Min.X * (1.0 - FMath::Sign(Query.Min.X) * Iota),
-		Query.Min.Y * (1.0 - FMath::Sign(Query.Min.Y) * Iota),
-		Query.Min.Z * (1.0 - FMath::Sign(Query.Min.Z) * Iota));
-
-	FVector QueryMax = FVector(
-		Query.Max.X * (1.0 + FMath::Sign(Query.Max.X) * Iota),
-		Query.Max.Y * (1.0 + FMath::Sign(Query.Max.Y) * Iota),
-		Query.Max.Z * (1.0 + FMath::Sign(Query.Max.Z) * Iota));
+	const FBox QueryBox = PointCloudViewPrivate::MakeQueryBox(Query);
+	const FVector QueryMin = QueryBox.Min;
+	const FVector QueryMax = QueryBox.Max;
 	
 	if (!bInvertSelection)
 	{
@@ -191,7 +326,7 @@ void UPointCloudView::FilterOnBoundingBox(const FBox& Query, bool bInvertSelecti
 			QueryMin.Y, QueryMax.Y,
 			QueryMin.Z, QueryMax.Z);
 	}
-	AddFilterStatement(FullQuery);
+	AddFilterStatement(FullQuery, FPointCloudSpatialFilter::MakeBox(QueryBox, bInvertSelection));
 
 	return;
 }
@@ -220,7 +355,7 @@ void UPointCloudView::FilterOnOrientedBoundingBox(const FTransform& InOBB, bool
 		Translation.X, Translation.Y, Translation.Z,
 		Scale.X, Scale.Y, Scale.Z);
 
-	AddFilterStatement(FullQuery);
+	AddFilterStatement(FullQuery, FPointCloudSpatialFilter::MakeOrientedBox(FTransform(Rotation, Translation, Scale), bInvertSelection));
 }
 
 void UPointCloudView::FilterOnTile(int InNumTilesX, int InNumTilesY, int InNumTilesZ, int InTileX, int InTileY, int InTileZ, bool bInvertSelection, EFilterMode Mode)
@@ -246,14 +381,84 @@ void UPointCloudView::FilterOnTile(
 		return;
 	}
 
-	const FVector TileOffset = QueryGridBounds.Min;
-	const FVector TileSize = (QueryGridBounds.Max - QueryGridBounds.Min) / FVector(InNumTilesX, InNumTilesY, InNumTilesZ);
-	const FVector TileMin = TileOffset + TileSize * FVector(InTileX, InTileY, InTileZ);
-	const FVector TileMax = TileOffset + TileSize * FVector(InTileX + 1, InTileY + 1, InTileZ + 1);
+	const FBox TileBox = PointCloudViewPrivate::MakeTileBox(QueryGridBounds, FIntVector(InNumTilesX, InNumTilesY, InNumTilesZ), FIntVector(InTileX, InTileY, InTileZ));
 
-	return FilterOnBoundingBox(FBox(TileMin, TileMax), bInvertSelection, Mode);
+	return FilterOnBoundingBox(TileBox, bInvertSelection, Mode);
 } 
 
+TSharedPtr<const FPointCloudTilePartition> UPointCloudView::MakeTilePartition(const FBox& QueryGridBounds, int InNumTilesX, int InNumTilesY, int InNumTilesZ) const
+{
+	if (PointCloud == nullptr || InNumTilesX <= 0 || InNumTilesY <= 0 || InNumTilesZ <= 0 || CVarNativeSpatialFilters.GetValueOnAnyThread() == 0)
+	{
+		return nullptr;
+	}
+
+	if (FilterStatementList.Num() != 0)
+	{
+		// The partition is bound to views that are siblings of this one, they don't have its filters
+		return nullptr;
+	}
+
+	TSharedPtr<const FPointCloudSpatialIndex> Index = PointCloud->GetSpatialIndex();
+	TSharedPtr<const TBitArray<>> Bits;
+
+	if (HasFiltersApplied())
+	{
+		TSharedPtr<const FPointCloudSpatialIndex> BitsIndex;
+		Bits = GetFilterResultBits(BitsIndex);
+
+		if (!Bits.IsValid() || BitsIndex != Index)
+		{
+			return nullptr;
+		}
+	}
+	else if (Index.IsValid())
+	{
+		Bits = MakeShared<const TBitArray<>>(Index->MakeFullSet());
+	}
+	else
+	{
+		return nullptr;
+	}
+
+	const FIntVector NumTiles(InNumTilesX, InNumTilesY, InNumTilesZ);
+
+	TSharedPtr<FPointCloudTilePartition> Partition = MakeShared<FPointCloudTilePartition>(Index, *Bits, QueryGridBounds, NumTiles, [&QueryGridBounds, &NumTiles](const FIntVector& Tile)
+	{
+		return FPointCloudSpatialFilter::MakeBox(PointCloudViewPrivate::MakeQueryBox(PointCloudViewPrivate::MakeTileBox(QueryGridBounds, NumTiles, Tile)), /*bInvert=*/false);
+	});
+
+	Partition->SourceParentView = ParentView;
+	Partition->SourcePointCloud = PointCloud;
+	Partition->bHasSourceParentView = ParentView != nullptr;
+
+	return Partition;
+}
+
+bool UPointCloudView::FilterOnTile(const TSharedPtr<const FPointCloudTilePartition>& Partition, int InTileX, int InTileY, int InTileZ)
+{
+	if (!Partition.IsValid())
+	{
+		return false;
+	}
+
+	const FIntVector& NumTiles = Partition->GetNumTilesPerAxis();
+	const bool bIsInGrid = InTileX >= 0 && InTileX < NumTiles.X && InTileY >= 0 && InTileY < NumTiles.Y && InTileZ >= 0 && InTileZ < NumTiles.Z;
+	const bool bCanBindPoints = bIsInGrid && FilterStatementList.Num() == 0 && Partition->IsSource(ParentView, PointCloud);
+
+	FilterOnTile(Partition->GetGridBounds(), NumTiles.X, NumTiles.Y, NumTiles.Z, InTileX, InTileY, InTileZ, /*bInvertSelection=*/false);
+
+	if (bCanBindPoints && FilterStatementList.Num() == 1 && PointCloud->GetSpatialIndex() == Partition->GetSpatialIndex())
+	{
+		FScopeLock Lock(&CachedResultBitsLock);
+		CachedResultBits = MakeShared<const TBitArray<>>(Partition->MakeBits(Partition->GetTileIndex(FIntVector(InTileX, InTileY, InTileZ))));
+		CachedResultIndex = Partition->GetSpatialIndex();
+		return true;
+	}
+
+	return false;
+}
+
 void  UPointCloudView::FilterOnPointExpression(const FString &Query, EFilterMode Mode)
 {
 	if (PointCloud==nullptr)
@@ -349,6 +554,15 @@ int32 UPointCloudView::CountResultsInBox(const FBox& Box) const
 		return Result;
 	}
 	
+	if (UseNativeFilters())
+	{
+		TSharedPtr<const FPointCloudSpatialIndex> Index;
+		if (TSharedPtr<const TBitArray<>> ResultBits = GetFilterResultBits(Index))
+		{
+			return Index->CountInBox(*ResultBits, Box);
+		}
+	}
+
 	FString SelectQuery;
 
 	if (HasFiltersApplied())
@@ -380,6 +594,15 @@ FBox UPointCloudView::GetResultsBoundingBox() const
 		return Result;
 	}
 	
+	if (UseNativeFilters())
+	{
+		TSharedPtr<const FPointCloudSpatialIndex> Index;
+		if (TSharedPtr<const TBitArray<>> ResultBits = GetFilterResultBits(Index))
+		{
+			return Index->GetBounds(*ResultBits);
+		}
+	}
+
 	if (HasFiltersApplied())
 	{		
 		FString ResultTable = GetFilterResultTable();
@@ -437,7 +660,7 @@ void UPointCloudView::FilterOnMetadataPattern(const FString& MetaData, const FSt
 		FullQuery = FString::Printf(TEXT("SELECT Vertex_Id AS Id FROM %s WHERE Attribute_Name='%s' AND Attribute_Value GLOB('%s')"), *MetaDataQuery, *MetaData, *MetadataPattern);
 	}
 
-	AddFilterStatement(FullQuery);	
+	AddFilterStatement(FullQuery, FPointCloudMetadataFilter::MakePattern(MetaData, Pattern, Mode == EFilterMode::FILTER_Not));
 }
 
 // Set a query that finds points that gave a given metadata value
@@ -474,12 +697,17 @@ void  UPointCloudView::FilterOnMetadata(const FString& MetaData, const FString&
 	}
 	
 
-	AddFilterStatement(FullQuery);
+	AddFilterStatement(FullQuery, FPointCloudMetadataFilter::MakeValue(MetaData, Value, Mode == EFilterMode::FILTER_Not));
 					
 	return ;
 }
 
 void UPointCloudView::AddFilterStatement(const FString& Statement)
+{
+	AddFilterStatement(Statement, FPointCloudSpatialFilter());
+}
+
+void UPointCloudView::AddFilterStatement(const FString& Statement, const FPointCloudSpatialFilter& NativeFilter)
 {
 	if (Statement.IsEmpty())
 	{
@@ -494,13 +722,34 @@ void UPointCloudView::AddFilterStatement(const FString& Statement)
 	}
 
 	FilterStatementList.Add(Statement);
+	NativeFilterList.Add(NativeFilter);
+	MetadataFilterList.Add(FPointCloudMetadataFilter());
+	SinglePoints.Reset();
+	SinglePointIndex = INDEX_NONE;
 	DirtyHash();
 }
 
+void UPointCloudView::AddFilterStatement(const FString& Statement, const FPointCloudMetadataFilter& MetadataFilter)
+{
+	const int32 NumStatements = FilterStatementList.Num();
+
+	AddFilterStatement(Statement, FPointCloudSpatialFilter());
+
+	if (FilterStatementList.Num() > NumStatements)
+	{
+		MetadataFilterList.Last() = MetadataFilter;
+	}
+}
+
 /** Clear the list of create view statements */
 void UPointCloudView::ClearFilterStatements()
 {
 	FilterStatementList.Empty();
+	NativeFilterList.Empty();
+	MetadataFilterList.Empty();
+	SinglePoints.Reset();
+	SinglePointIndex = INDEX_NONE;
+	DirtyHash();
 }
 
 TArray< FString > UPointCloudView::GetUniqueMetadataValues(const FString& Key) const
@@ -519,6 +768,34 @@ TArray< FString > UPointCloudView::GetUniqueMetadataValues(const FString& Key) c
 		return Result;
 	}
 
+	int32 PointIndex;
+	if (const FPointCloudViewPoints* Points = GetSinglePoint(PointIndex))
+	{
+		FString Value;
+		if (Points->GetMetadataValue(PointIndex, Key, Value))
+		{
+			Result.Add(Value);
+		}
+
+		return Result;
+	}
+
+	TSharedPtr<const TBitArray<>> ResultBits;
+	if (TSharedPtr<const FPointCloudAttributeIndex> AttributeIndex = GetAttributeIndex(Key, ResultBits))
+	{
+		const TArray<int32> Counts = AttributeIndex->CountValues(ResultBits.Get());
+
+		for (int32 ValueIndex = 0; ValueIndex < Counts.Num(); ++ValueIndex)
+		{
+			if (Counts[ValueIndex] > 0)
+			{
+				Result.Add(AttributeIndex->GetValue(ValueIndex));
+			}
+		}
+
+		return Result;
+	}
+
 	char* zErrMsg = nullptr;
 	const FString MetaDataQuery = GetMetadataQuery();	
 
@@ -561,6 +838,34 @@ TMap<FString, int> UPointCloudView::GetUniqueMetadataValuesAndCounts(const FStri
 		UE_LOG(PointCloudLog, Warning, TEXT("Empty Name For Metadata"));
 		return Result;
 	}
+
+	int32 PointIndex;
+	if (const FPointCloudViewPoints* Points = GetSinglePoint(PointIndex))
+	{
+		FString Value;
+		if (Points->GetMetadataValue(PointIndex, Key, Value))
+		{
+			Result.Add(Value, 1);
+		}
+
+		return Result;
+	}
+
+	TSharedPtr<const TBitArray<>> ResultBits;
+	if (TSharedPtr<const FPointCloudAttributeIndex> AttributeIndex = GetAttributeIndex(Key, ResultBits))
+	{
+		const TArray<int32> Counts = AttributeIndex->CountValues(ResultBits.Get());
+
+		for (int32 ValueIndex = 0; ValueIndex < Counts.Num(); ++ValueIndex)
+		{
+			if (Counts[ValueIndex] > 0)
+			{
+				Result.Add(AttributeIndex->GetValue(ValueIndex), Counts[ValueIndex]);
+			}
+		}
+
+		return Result;
+	}
 	
 	const FString MetaDataQuery = GetMetadataQuery();
 	FString GetInstanceAndCountQuery;
@@ -623,6 +928,11 @@ TArray<TPair<TArray<FString>, int32>> UPointCloudView::GetUniqueMetadataValuesAn
 		return Result;
 	}
 
+	if (GetUniqueMetadataValuesAndCountsNative(Keys, Result))
+	{
+		return Result;
+	}
+
 	TArray<FString> AttributeTempTables;
 
 	for (const FString& Key : Keys)
@@ -682,6 +992,96 @@ TArray<TPair<TArray<FString>, int32>> UPointCloudView::GetUniqueMetadataValuesAn
 	return Result;
 }
 
+bool UPointCloudView::GetUniqueMetadataValuesAndCountsNative(const TArray<FString>& Keys, TArray<TPair<TArray<FString>, int32>>& OutResult) const
+{
+	TArray<TSharedPtr<const FPointCloudAttributeIndex>> AttributeIndices;
+	TSharedPtr<const TBitArray<>> ResultBits;
+
+	// Each combination of values is encoded as a single number, with the first key as the most significant digit
+	uint64 NumCombinations = 1;
+
+	for (const FString& Key : Keys)
+	{
+		TSharedPtr<const FPointCloudAttributeIndex> AttributeIndex = GetAttributeIndex(Key, ResultBits);
+
+		if (!AttributeIndex.IsValid() || (AttributeIndices.Num() > 0 && AttributeIndex->GetSpatialIndex() != AttributeIndices[0]->GetSpatialIndex()))
+		{
+			return false;
+		}
+
+		const uint64 NumValues = FMath::Max(AttributeIndex->GetNumValues(), 1);
+
+		if (NumCombinations > MAX_uint64 / NumValues)
+		{
+			return false;
+		}
+
+		NumCombinations *= NumValues;
+		AttributeIndices.Add(AttributeIndex);
+	}
+
+	TMap<uint64, int32> Counts;
+
+	auto CountPoint = [&AttributeIndices, &Counts](int32 PointIndex)
+	{
+		uint64 Combination = 0;
+
+		for (const TSharedPtr<const FPointCloudAttributeIndex>& AttributeIndex : AttributeIndices)
+		{
+			const int32 ValueIndex = AttributeIndex->GetValueIndex(PointIndex);
+
+			// Points have to have a value for every key, as with the joins in SQL
+			if (ValueIndex == INDEX_NONE)
+			{
+				return;
+			}
+
+			Combination = Combination * FMath::Max(AttributeIndex->GetNumValues(), 1) + ValueIndex;
+		}
+
+		++Counts.FindOrAdd(Combination);
+	};
+
+	if (ResultBits.IsValid())
+	{
+		for (TConstSetBitIterator<> It(*ResultBits); It; ++It)
+		{
+			CountPoint(It.GetIndex());
+		}
+	}
+	else
+	{
+		for (int32 PointIndex = 0; PointIndex < AttributeIndices[0]->Num(); ++PointIndex)
+		{
+			CountPoint(PointIndex);
+		}
+	}
+
+	// Dictionaries are sorted on the AttributeValues rowid, so this gives the same order as grouping on the value ids in SQL
+	Counts.KeySort(TLess<uint64>());
+
+	OutResult.Reserve(Counts.Num());
+
+	for (const TPair<uint64, int32>& Count : Counts)
+	{
+		TArray<FString> Values;
+		Values.SetNum(AttributeIndices.Num());
+
+		uint64 Combination = Count.Key;
+
+		for (int32 KeyIndex = AttributeIndices.Num() - 1; KeyIndex >= 0; --KeyIndex)
+		{
+			const uint64 NumValues = FMath::Max(AttributeIndices[KeyIndex]->GetNumValues(), 1);
+			Values[KeyIndex] = AttributeIndices[KeyIndex]->GetValue((int32)(Combination % NumValues));
+			Combination /= NumValues;
+		}
+
+		OutResult.Emplace(MoveTemp(Values), Count.Value);
+	}
+
+	return true;
+}
+
 template<typename T>
 TArray<T> UPointCloudView::GetMetadataValuesArray(const FString& Key) const
 {
@@ -699,6 +1099,18 @@ TArray<T> UPointCloudView::GetMetadataValuesArray(const FString& Key) const
 		return Result;
 	}
 
+	TSharedPtr<const TBitArray<>> ResultBits;
+	if (TSharedPtr<const FPointCloudAttributeIndex> AttributeIndex = GetAttributeIndex(Key, ResultBits))
+	{
+		// Values are converted the same way SQL converts them, in the order of the points in GetTransforms
+		PointCloudViewPrivate::ForEachPointWithValue(*AttributeIndex, ResultBits.Get(), [&Result, &AttributeIndex](int32 RowId, int32 PointIndex)
+			{
+				Result.Add((T)AttributeIndex->GetNumber(PointIndex));
+			});
+
+		return Result;
+	}
+
 	FString SelectQuery;
 
 	if (HasFiltersApplied() == false)
@@ -761,6 +1173,29 @@ TMap<int, FString> UPointCloudView::GetMetadataValues(const FString& Key) const
 		return Result;
 	}
 
+	int32 PointIndex;
+	if (const FPointCloudViewPoints* Points = GetSinglePoint(PointIndex))
+	{
+		FString Value;
+		if (Points->GetMetadataValue(PointIndex, Key, Value))
+		{
+			Result.Add(Points->GetId(PointIndex), Value);
+		}
+
+		return Result;
+	}
+
+	TSharedPtr<const TBitArray<>> ResultBits;
+	if (TSharedPtr<const FPointCloudAttributeIndex> AttributeIndex = GetAttributeIndex(Key, ResultBits))
+	{
+		PointCloudViewPrivate::ForEachPointWithValue(*AttributeIndex, ResultBits.Get(), [&Result, &AttributeIndex](int32 RowId, int32 PointIndex)
+			{
+				Result.Add(RowId, AttributeIndex->GetValue(AttributeIndex->GetValueIndex(PointIndex)));
+			});
+
+		return Result;
+	}
+
 	FString SelectQuery;
 
 	if (HasFiltersApplied()==false)
@@ -823,13 +1258,180 @@ bool UPointCloudView::HasFiltersApplied() const
 	return (FilterStatementList.Num() != 0 || (ParentView && ParentView->HasFiltersApplied()));
 }
 
+const FPointCloudViewPoints* UPointCloudView::GetSinglePoint(int32& OutPointIndex) const
+{
+	if (SinglePoints.IsValid())
+	{
+		OutPointIndex = SinglePointIndex;
+		return SinglePoints.Get();
+	}
+
+	// A view without filters of its own returns the same results as its parent
+	if (FilterStatementList.Num() == 0 && ParentView != nullptr)
+	{
+		return ParentView->GetSinglePoint(OutPointIndex);
+	}
+
+	return nullptr;
+}
+
 int UPointCloudView::GetFilterCount() const
 {
 	return FilterStatementList.Num() + (ParentView ? ParentView->GetFilterCount() : 0);
 }
 
+bool UPointCloudView::HasNativeFilters() const
+{
+	for (const FPointCloudSpatialFilter& Filter : NativeFilterList)
+	{
+		if (Filter.IsSpatial())
+		{
+			return true;
+		}
+	}
+
+	if (CVarNativeMetadata.GetValueOnAnyThread() != 0)
+	{
+		for (const FPointCloudMetadataFilter& Filter : MetadataFilterList)
+		{
+			if (Filter.IsValid())
+			{
+				return true;
+			}
+		}
+	}
+
+	return ParentView && ParentView->HasNativeFilters();
+}
+
+bool UPointCloudView::UseNativeFilters() const
+{
+	// Chains without any spatial or metadata filter gain nothing from the indices, they are better served by the shared temporary tables
+	return PointCloud != nullptr && CVarNativeSpatialFilters.GetValueOnAnyThread() != 0 && HasNativeFilters();
+}
+
+TSharedPtr<const FPointCloudAttributeIndex> UPointCloudView::GetAttributeIndex(const FString& Key, TSharedPtr<const TBitArray<>>& OutBits) const
+{
+	OutBits.Reset();
+
+	if (PointCloud == nullptr || CVarNativeMetadata.GetValueOnAnyThread() == 0)
+	{
+		return nullptr;
+	}
+
+	if (HasFiltersApplied() && !UseNativeFilters())
+	{
+		// The results are only known as a table, joining it in SQL is cheaper than reading it back
+		return nullptr;
+	}
+
+	TSharedPtr<const FPointCloudAttributeIndex> AttributeIndex = PointCloud->GetAttributeIndex(Key);
+
+	if (!AttributeIndex.IsValid() || !HasFiltersApplied())
+	{
+		return AttributeIndex;
+	}
+
+	TSharedPtr<const FPointCloudSpatialIndex> Index;
+	OutBits = GetFilterResultBits(Index);
+
+	if (!OutBits.IsValid() || Index != AttributeIndex->GetSpatialIndex())
+	{
+		// The point cloud changed while the filters were being evaluated
+		OutBits.Reset();
+		return nullptr;
+	}
+
+	return AttributeIndex;
+}
+
+TSharedPtr<const TBitArray<>> UPointCloudView::GetFilterResultBits(TSharedPtr<const FPointCloudSpatialIndex>& OutIndex) const
+{
+	FScopeLock Lock(&CachedResultBitsLock);
+
+	TSharedPtr<const FPointCloudSpatialIndex> Index = PointCloud->GetSpatialIndex();
+
+	if (!Index.IsValid())
+	{
+		return nullptr;
+	}
+
+	if (CachedResultBits.IsValid() && CachedResultIndex == Index)
+	{
+		OutIndex = Index;
+		return CachedResultBits;
+	}
+
+	TBitArray<> Bits;
+
+	if (ParentView != nullptr && ParentView->HasFiltersApplied())
+	{
+		TSharedPtr<const FPointCloudSpatialIndex> ParentIndex;
+		TSharedPtr<const TBitArray<>> ParentBits = ParentView->GetFilterResultBits(ParentIndex);
+
+		if (!ParentBits.IsValid() || ParentIndex != Index)
+		{
+			// The point cloud changed while the filters were being evaluated
+			return nullptr;
+		}
+
+		Bits = *ParentBits;
+	}
+	else
+	{
+		Bits = Index->MakeFullSet();
+	}
+
+	for (int32 FilterIndex = 0; FilterIndex < FilterStatementList.Num(); ++FilterIndex)
+	{
+		const FPointCloudMetadataFilter& MetadataFilter = MetadataFilterList[FilterIndex];
+
+		if (NativeFilterList[FilterIndex].IsSpatial())
+		{
+			Index->Intersect(NativeFilterList[FilterIndex], Bits);
+			continue;
+		}
+
+		if (MetadataFilter.IsValid() && CVarNativeMetadata.GetValueOnAnyThread() != 0)
+		{
+			TSharedPtr<const FPointCloudAttributeIndex> AttributeIndex = PointCloud->GetAttributeIndex(MetadataFilter.Key);
+
+			if (AttributeIndex.IsValid() && AttributeIndex->GetSpatialIndex() == Index)
+			{
+				AttributeIndex->Intersect(MetadataFilter, Bits);
+				continue;
+			}
+		}
+
+		Index->IntersectRowIds(PointCloud->GetValueArray<int>(FilterStatementList[FilterIndex]), Bits);
+	}
+
+	CachedResultBits = MakeShared<const TBitArray<>>(MoveTemp(Bits));
+	CachedResultIndex = Index;
+
+	OutIndex = Index;
+	return CachedResultBits;
+}
+
 void UPointCloudView::PreCacheFilters()
 {
+	int32 PointIndex;
+	if (GetSinglePoint(PointIndex))
+	{
+		// Nothing to cache, the point is already known
+		return;
+	}
+
+	if (UseNativeFilters())
+	{
+		// The result is held as a bit array, the table is only made if something needs to query it in SQL
+		TSharedPtr<const FPointCloudSpatialIndex> Index;
+		if (GetFilterResultBits(Index).IsValid())
+		{
+			return;
+		}
+	}
+
 	// requesting the table causes it to be cached
 	GetFilterResultTable(/*bSilentOnNoFilter=*/true);
 }
@@ -848,21 +1450,31 @@ FString UPointCloudView::GetFilterResultTable(bool bSilentOnNoFilter) const
 		return FString();
 	}
 
-	FString TableName;
+	// Views whose filters only differ by order or repetition share the same plan, and so the same result table
+	const FPointCloudQueryPlan Plan = FPointCloudQueryPlan::Compile(Filters);
+
+	FString TableName = PointCloud->FindQueryPlanTable(Plan);
 
-	if (Filters.Num() == 1)
+	if (!TableName.IsEmpty())
 	{
-		TableName = PointCloud->GetTemporaryQueryTable(Filters[0]);
+		return TableName;
 	}
-	else if (Filters.Num() > 1)
+
+	if (UseNativeFilters())
 	{
-		TableName = PointCloud->GetTemporaryQueryTable(Filters[0]);
-		// go through each pair of filters, creating intersection tables for them in order
-		for (int i = 1; i < Filters.Num(); i++)
+		TSharedPtr<const FPointCloudSpatialIndex> Index;
+		if (TSharedPtr<const TBitArray<>> ResultBits = GetFilterResultBits(Index))
 		{
-			TableName = PointCloud->GetTemporaryIntersectionTable(UPointCloudImpl::EArgumentType::Table, TableName, UPointCloudImpl::EArgumentType::Query, Filters[i]);
+			TableName = PointCloud->GetTemporaryIdTable(Plan.Key, Index->GetRowIds(*ResultBits));
 		}
 	}
+
+	if (TableName.IsEmpty())
+	{
+		TableName = PointCloud->GetTemporaryQueryPlanTable(Plan);
+	}
+
+	PointCloud->AddQueryPlanTable(Plan, TableName);
 	
 	return TableName;
 }
@@ -889,6 +1501,13 @@ int UPointCloudView::GetIndexes(UPARAM(ref) TArray<int32>& OutIds) const
 		return 0;
 	}
 
+	int32 PointIndex;
+	if (const FPointCloudViewPoints* Points = GetSinglePoint(PointIndex))
+	{
+		OutIds = { Points->GetId(PointIndex) };
+		return OutIds.Num();
+	}
+
 	if (HasFiltersApplied() == false)
 	{
 		// return all of the vertex ids
@@ -897,6 +1516,16 @@ int UPointCloudView::GetIndexes(UPARAM(ref) TArray<int32>& OutIds) const
 		return OutIds.Num();
 	}
 
+	if (UseNativeFilters())
+	{
+		TSharedPtr<const FPointCloudSpatialIndex> Index;
+		if (TSharedPtr<const TBitArray<>> ResultBits = GetFilterResultBits(Index))
+		{
+			OutIds = Index->GetRowIds(*ResultBits);
+			return OutIds.Num();
+		}
+	}
+
 	const FString ResultTableName = GetFilterResultTable();
 
 	if (ResultTableName.IsEmpty())
@@ -919,6 +1548,12 @@ TArray<FTransform> UPointCloudView::GetTransforms() const
 		return TArray<FTransform>();
 	}
 
+	int32 PointIndex;
+	if (const FPointCloudViewPoints* Points = GetSinglePoint(PointIndex))
+	{
+		return { Points->GetTransform(PointIndex) };
+	}
+
 	FString GetTransformsQuery;
 
 	if (HasFiltersApplied() == false)
@@ -949,6 +1584,12 @@ TArray<TPair<int32, FTransform>> UPointCloudView::GetPerIdTransforms() const
 		return TArray<TPair<int32, FTransform>>();
 	}
 
+	int32 PointIndex;
+	if (const FPointCloudViewPoints* Points = GetSinglePoint(PointIndex))
+	{
+		return { TPair<int32, FTransform>(Points->GetId(PointIndex), Points->GetTransform(PointIndex)) };
+	}
+
 	FString GetIdAndTransformQuery;
 
 	if (HasFiltersApplied() == false)
@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Dom/JsonObject.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+#include "PointCloudBenchmark.h"
+#include "PointCloudTestBase.h"
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudBenchmarkReportTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.Benchmark.Report", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Check that a small benchmark is deterministic and that its report holds a timer for every stage
+bool FPointCloudBenchmarkReportTest::RunTest(const FString& Parameters)
+{
+	FPointCloudBenchmark::FSettings Settings;
+	Settings.Sizes = { 2000 };
+	Settings.NumTilesPerAxis = 2;
+	Settings.NumPointViews = 20;
+
+	const FPointCloudBenchmark::FRun First = FPointCloudBenchmark::RunSize(Settings, 2000);
+	const FPointCloudBenchmark::FRun Second = FPointCloudBenchmark::RunSize(Settings, 2000);
+
+	if (!TestTrue("The first run succeeds", First.bSuccess) || !TestTrue("The second run succeeds", Second.bSuccess))
+	{
+		return false;
+	}
+
+	// Every counter, including the number of points each filter keeps, only depends on the seed and the size
+	for (const FString& Name : First.Stats->GetCounterNames())
+	{
+		if (Name.StartsWith(TEXT("Benchmark")))
+		{
+			TestEqual(FString::Printf(TEXT("Counter '%s' is the same in both runs"), *Name), Second.Stats->GetCounterValue(Name), First.Stats->GetCounterValue(Name));
+		}
+	}
+
+	// Tiles include their faces, so points on the edge between two tiles are found by both
+	TestTrue("Every point is found in a tile", First.Stats->GetCounterValue(TEXT("Benchmark Tiles Points")) >= 2000);
+	TestEqual("Partitioned tiles find the same points", First.Stats->GetCounterValue(TEXT("Benchmark Tiles Partitioned Points")), First.Stats->GetCounterValue(TEXT("Benchmark Tiles Points")));
+	TestEqual("Every point is deserialized", First.Stats->GetCounterValue(TEXT("Benchmark Deserialized Points")), (int64)2000);
+
+	const FString Report = FPointCloudBenchmark::MakeReport(Settings, { First });
+
+	TSharedPtr<FJsonObject> Root;
+	if (!TestTrue("The report is valid JSON", FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Report), Root) && Root.IsValid()))
+	{
+		return false;
+	}
+
+	TestEqual("Report version", (int32)Root->GetNumberField(TEXT("Version")), FPointCloudBenchmark::ReportVersion);
+
+	const TArray<TSharedPtr<FJsonValue>>& Runs = Root->GetArrayField(TEXT("Runs"));
+	if (!TestEqual("Number of runs in the report", Runs.Num(), 1))
+	{
+		return false;
+	}
+
+	const TSharedPtr<FJsonObject>& Timers = Runs[0]->AsObject()->GetObjectField(TEXT("Timers"));
+
+	const TCHAR* Stages[] = { TEXT("Generate"), TEXT("Load"), TEXT("Hash Full"), TEXT("Hash Incremental"), TEXT("Serialize"), TEXT("Deserialize"),
+		TEXT("Filter Box"), TEXT("Filter Sphere"), TEXT("Filter Oriented Box"), TEXT("Filter Expression"), TEXT("Filter Metadata"), TEXT("Filter Metadata Pattern"),
+		TEXT("Filter Box And Metadata"), TEXT("Metadata Counts"), TEXT("Metadata Values"), TEXT("Tiles"), TEXT("Tiles Partitioned"), TEXT("Rule Iteration") };
+
+	for (const TCHAR* Stage : Stages)
+	{
+		TestTrue(FString::Printf(TEXT("The report times the %s stage"), Stage), Timers->HasField(FString::Printf(TEXT("Benchmark %s"), Stage)));
+	}
+
+	return true;
+}
@@ -0,0 +1,150 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Tests/AutomationCommon.h"
+#include "TestingCommon.h"
+
+#include "PointCloudCsv.h"
+#include "PointCloudTestBase.h"
+
+namespace PointCloudCsvTests
+{
+	static const FString TestDataFile = "BuildingPointCloud.psv";
+
+	static const TSet<FString> NumericColumns = { TEXT("point"), TEXT("Px"), TEXT("Py"), TEXT("Pz"), TEXT("orientx"), TEXT("orienty"), TEXT("orientz"), TEXT("orientw"), TEXT("scalex"), TEXT("scaley"), TEXT("scalez") };
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudCsvStreamingTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloudCsv.Streaming", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Check that the streaming parser produces the same columns as the line based parser
+bool FPointCloudCsvStreamingTest::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudCsvTests;
+
+	const FString PathToData = PathToTestData(TestDataFile);
+
+	FPointCloudCsv Legacy = FPointCloudCsv::Open(PathToData);
+	FPointCloudCsv Streaming = FPointCloudCsv::OpenStreaming(PathToData, NumericColumns);
+
+	TestTrue("Legacy document is open", Legacy.GetIsOpen());
+	TestTrue("Streaming document is open", Streaming.GetIsOpen());
+	TestEqual("Row counts match", Streaming.GetRowCount(), Legacy.GetRowCount());
+	TestEqual("Column names match", Streaming.GetColumnNames(), Legacy.GetColumnNames());
+
+	for (const FString& ColumnName : Legacy.GetColumnNames())
+	{
+		const TArray<FString>* LegacyColumn = Legacy.GetColumn(ColumnName);
+
+		if (const TArray<float>* Numbers = Streaming.GetNumericColumn(ColumnName))
+		{
+			bool bMatches = LegacyColumn->Num() == Numbers->Num();
+			for (int32 Row = 0; bMatches && Row < Numbers->Num(); ++Row)
+			{
+				bMatches = (*Numbers)[Row] == (float)FCString::Atof(*(*LegacyColumn)[Row]);
+			}
+
+			TestTrue(FString::Printf(TEXT("Numeric column %s matches"), *ColumnName), bMatches);
+		}
+		else
+		{
+			const TArray<int32>* ValueIds = nullptr;
+			const TArray<FString>* Values = nullptr;
+
+			TestTrue(FString::Printf(TEXT("Column %s is interned"), *ColumnName), Streaming.GetInternedColumn(ColumnName, ValueIds, Values));
+
+			bool bMatches = ValueIds != nullptr && LegacyColumn->Num() == ValueIds->Num();
+			for (int32 Row = 0; bMatches && Row < ValueIds->Num(); ++Row)
+			{
+				bMatches = (*Values)[(*ValueIds)[Row]] == (*LegacyColumn)[Row];
+			}
+
+			TestTrue(FString::Printf(TEXT("Interned column %s matches"), *ColumnName), bMatches);
+		}
+	}
+
+	// Line endings, a missing final line break and malformed lines
+	const FString Text = TEXT("a,b,c\r\n1,x,2\r\n3,y\r\n\r\n4,x,5");
+	FTCHARToUTF8 Utf8(*Text);
+	FPointCloudCsv Small = FPointCloudCsv::ParseStreaming(MakeArrayView(reinterpret_cast<const uint8*>(Utf8.Get()), (int64)Utf8.Length()), { TEXT("a"), TEXT("c") });
+
+	TestEqual("Small row count", Small.GetRowCount(), 2);
+
+	const TArray<float>* ColumnC = Small.GetNumericColumn(TEXT("c"));
+	TestTrue("Small numeric column", ColumnC != nullptr && ColumnC->Num() == 2 && (*ColumnC)[1] == 5.0f);
+
+	const TArray<int32>* ValueIds = nullptr;
+	const TArray<FString>* Values = nullptr;
+	TestTrue("Small interned column", Small.GetInternedColumn(TEXT("b"), ValueIds, Values) && Values->Num() == 1 && (*Values)[0] == TEXT("x"));
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudCsvStreamingBenchmark, FPointCloudTestBaseClass, "RuleProcessor.PointCloudCsv.StreamingBenchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Compare the time taken to read a large file into typed columns with the line based parser and the streaming parser
+bool FPointCloudCsvStreamingBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudCsvTests;
+
+	TArray<FString> Lines;
+	TestTrue("Read test data", FFileHelper::LoadANSITextFileToStrings(*PathToTestData(TestDataFile), nullptr, Lines));
+
+	if (Lines.Num() < 2)
+	{
+		return false;
+	}
+
+	// Repeat the test data until the file has a few hundred thousand rows
+	const int32 TargetRows = 250000;
+	const int32 DataLines = Lines.Num() - 1;
+
+	FString Text = Lines[0] + TEXT("\n");
+	for (int32 Row = 0; Row < TargetRows; ++Row)
+	{
+		Text += Lines[1 + (Row % DataLines)];
+		Text += TEXT("\n");
+	}
+
+	const FString BenchmarkFile = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("CsvBenchmark.psv")));
+	TestTrue("Write benchmark file", FFileHelper::SaveStringToFile(Text, *BenchmarkFile));
+	Text.Empty();
+
+	// The line based parser leaves everything as strings, so include the conversion LoadFromCsv previously did
+	double StartTime = FPlatformTime::Seconds();
+	{
+		FPointCloudCsv Legacy = FPointCloudCsv::Open(BenchmarkFile);
+
+		for (const FString& ColumnName : NumericColumns)
+		{
+			if (TArray<FString>* Column = Legacy.GetColumn(ColumnName))
+			{
+				TArray<float> Numbers;
+				Numbers.SetNumUninitialized(Column->Num());
+				ParallelFor(Column->Num(), [&](int32 Row)
+				{
+					Numbers[Row] = FCString::Atof(*(*Column)[Row]);
+				});
+			}
+		}
+
+		TestEqual("Legacy row count", Legacy.GetRowCount(), TargetRows);
+	}
+	const double LegacyTime = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	{
+		FPointCloudCsv Streaming = FPointCloudCsv::OpenStreaming(BenchmarkFile, NumericColumns);
+		TestEqual("Streaming row count", Streaming.GetRowCount(), TargetRows);
+	}
+	const double StreamingTime = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("CSV ingestion of %d rows: line based %.3fs, streaming %.3fs (%.2fx)"), TargetRows, LegacyTime, StreamingTime, StreamingTime > 0.0 ? LegacyTime / StreamingTime : 0.0));
+
+	IFileManager::Get().Delete(*BenchmarkFile);
+
+	return true;
+}
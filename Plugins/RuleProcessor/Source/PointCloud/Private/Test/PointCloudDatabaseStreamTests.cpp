@@ -0,0 +1,186 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#include "PointCloudDatabaseStream.h"
+#include "PointCloudImpl.h"
+#include "PointCloudTestBase.h"
+
+namespace PointCloudDatabaseStreamTests
+{
+	// Half random bytes and half runs, so some chunks compress and others don't
+	static TArray<uint8> MakeImage(int64 Size, int32 ChunkSize)
+	{
+		FRandomStream Random((int32)Size);
+
+		TArray<uint8> Image;
+		Image.SetNumUninitialized((int32)Size);
+		for (int64 Index = 0; Index < Size; ++Index)
+		{
+			Image[Index] = ((Index / ChunkSize) % 2 == 0) ? (uint8)Random.RandHelper(256) : (uint8)(Index / 64);
+		}
+
+		return Image;
+	}
+
+	static bool LoadImage(TArray<uint8>& Bytes, TArray<uint8>& OutImage, int32 MaxChunksInFlight, FPointCloudDatabaseStream::FStreamStats& OutStats)
+	{
+		FMemoryReader Reader(Bytes);
+
+		FPointCloudDatabaseStream::FHeader Header;
+		if (!FPointCloudDatabaseStream::LoadHeader(Reader, Header))
+		{
+			return false;
+		}
+
+		OutImage.SetNumUninitialized((int32)Header.Size);
+		return FPointCloudDatabaseStream::LoadChunks(Reader, Header, OutImage.GetData(), MaxChunksInFlight, &OutStats);
+	}
+
+	// Synthetic cloud of NumPoints points along a line, with a few metadata values each
+	static bool LoadSyntheticCloud(UPointCloudImpl* PointCloud, int32 NumPoints)
+	{
+		TArray<FTransform> Transforms;
+		TArray<FString> ColumnNames = { TEXT("Index"), TEXT("Group") };
+		TArray<int> MetadataCountPerVertex;
+		TArray<TPair<int, FString>> Metadata;
+
+		for (int32 I = 0; I < NumPoints; ++I)
+		{
+			Transforms.Add(FTransform(FVector(I, I % 100, 0)));
+			Metadata.Add(TPair<int, FString>(0, FString::FromInt(I)));
+			Metadata.Add(TPair<int, FString>(1, FString::FromInt(I % 17)));
+			MetadataCountPerVertex.Add(2);
+		}
+
+		return PointCloud->InitFromPreparedData(TEXT("Synthetic"), Transforms, ColumnNames, MetadataCountPerVertex, Metadata, FBox(EForceInit::ForceInit));
+	}
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudDatabaseStreamRoundTripTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.DatabaseStream.RoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Write images of sizes around the chunk size, with and without compression, and check they read back unchanged
+bool FPointCloudDatabaseStreamRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudDatabaseStreamTests;
+
+	FPointCloudDatabaseStream::FSettings Settings;
+	Settings.ChunkSize = 4096;
+	Settings.MaxChunksInFlight = 3;
+
+	for (const FName CompressionFormat : { FName(NAME_None), FName(NAME_Zlib), FName(NAME_Oodle) })
+	{
+		Settings.CompressionFormat = CompressionFormat;
+
+		for (const int64 Size : { (int64)0, (int64)1, (int64)Settings.ChunkSize - 1, (int64)Settings.ChunkSize, (int64)Settings.ChunkSize * 10 + 7 })
+		{
+			const TArray<uint8> Image = MakeImage(Size, Settings.ChunkSize);
+
+			TArray<uint8> Bytes;
+			FMemoryWriter Writer(Bytes);
+			TestTrue(FString::Printf(TEXT("%s, %lld bytes: save"), *CompressionFormat.ToString(), Size), FPointCloudDatabaseStream::Save(Writer, Image.GetData(), Size, Settings));
+
+			TArray<uint8> Loaded;
+			FPointCloudDatabaseStream::FStreamStats Stats;
+			TestTrue(FString::Printf(TEXT("%s, %lld bytes: load"), *CompressionFormat.ToString(), Size), LoadImage(Bytes, Loaded, Settings.MaxChunksInFlight, Stats));
+			TestTrue(FString::Printf(TEXT("%s, %lld bytes: the image is unchanged"), *CompressionFormat.ToString(), Size), Loaded == Image);
+		}
+	}
+
+	// A stream with a corrupt header fails rather than allocating a buffer for it
+	{
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+
+		int64 Size = -1;
+		int32 ChunkSize = Settings.ChunkSize;
+		FName CompressionFormat = NAME_Oodle;
+		Writer << Size << ChunkSize << CompressionFormat;
+
+		// Once for this stream and once for each of the bad layouts below
+		AddExpectedError(TEXT("Invalid Point Cloud Database Stream Header"), EAutomationExpectedErrorFlags::Contains, 4);
+
+		TArray<uint8> Loaded;
+		FPointCloudDatabaseStream::FStreamStats Stats;
+		TestFalse("Check a corrupt stream fails to load", LoadImage(Bytes, Loaded, Settings.MaxChunksInFlight, Stats));
+	}
+
+	// Headers that describe more data than the archive holds, or chunks that are too large, are rejected before anything is allocated
+	{
+		const TPair<int64, int32> BadLayouts[] =
+		{
+			{ (int64)1 << 40, Settings.ChunkSize },
+			{ (int64)Settings.ChunkSize, FPointCloudDatabaseStream::MaxChunkSize + 1 },
+			{ (int64)1 << 40, 1 },
+		};
+
+		for (const TPair<int64, int32>& Layout : BadLayouts)
+		{
+			TArray<uint8> Bytes;
+			FMemoryWriter Writer(Bytes);
+
+			int64 Size = Layout.Key;
+			int32 ChunkSize = Layout.Value;
+			FName CompressionFormat = NAME_Oodle;
+			Writer << Size << ChunkSize << CompressionFormat;
+
+			FMemoryReader Reader(Bytes);
+			FPointCloudDatabaseStream::FHeader Header;
+			TestFalse(FString::Printf(TEXT("Check a header of %lld bytes in chunks of %d fails to load"), Size, ChunkSize), FPointCloudDatabaseStream::LoadHeader(Reader, Header));
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudDatabaseStreamPeakMemoryTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.DatabaseStream.PeakMemory", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Save and load synthetic clouds of increasing size and check the memory held for chunks stays within the same budget
+bool FPointCloudDatabaseStreamPeakMemoryTest::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudDatabaseStreamTests;
+
+	const int64 ScratchBudget = FPointCloudDatabaseStream::GetScratchBudget(FPointCloudDatabaseStream::FSettings());
+
+	for (const int32 NumPoints : { 10000, 100000, 400000 })
+	{
+		FAssetDeleter<UPointCloud> Source(CreateTestAsset());
+		UPointCloudImpl* SourceCloud = Cast<UPointCloudImpl>(Source.Get());
+		TestTrue(FString::Printf(TEXT("%d points: load the synthetic cloud"), NumPoints), LoadSyntheticCloud(SourceCloud, NumPoints));
+
+		FPointCloudStatsPtr SaveStats = MakeShared<FPointCloudStats>();
+		SourceCloud->SetStats(SaveStats);
+
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes, /*bIsPersistent=*/true);
+		SourceCloud->Serialize(Writer);
+
+		FAssetDeleter<UPointCloud> Loaded(CreateTestAsset());
+		UPointCloudImpl* LoadedCloud = Cast<UPointCloudImpl>(Loaded.Get());
+
+		FPointCloudStatsPtr LoadStats = MakeShared<FPointCloudStats>();
+		LoadedCloud->SetStats(LoadStats);
+
+		FMemoryReader Reader(Bytes, /*bIsPersistent=*/true);
+		Reader.SetCustomVersions(Writer.GetCustomVersions());
+		LoadedCloud->Serialize(Reader);
+
+		TestEqual(FString::Printf(TEXT("%d points: the loaded cloud has every point"), NumPoints), LoadedCloud->GetCount(), NumPoints);
+		TestEqual(FString::Printf(TEXT("%d points: the loaded cloud has the same hash"), NumPoints), LoadedCloud->GetHashAsString(), SourceCloud->GetHashAsString());
+
+		const int64 DatabaseBytes = SaveStats->GetCounterValue(TEXT("PointCloud Serialize Bytes"));
+		const int64 SavePeak = SaveStats->GetCounterValue(TEXT("PointCloud Serialize Peak Scratch Bytes"));
+		const int64 LoadPeak = LoadStats->GetCounterValue(TEXT("PointCloud Deserialize Peak Scratch Bytes"));
+
+		TestTrue(FString::Printf(TEXT("%d points: saving stays within the chunk budget"), NumPoints), SavePeak <= ScratchBudget);
+		TestTrue(FString::Printf(TEXT("%d points: loading stays within the chunk budget"), NumPoints), LoadPeak <= ScratchBudget);
+
+		AddInfo(FString::Printf(TEXT("%d points: database %.2fMb, asset %.2fMb, peak chunk memory %.2fMb saving and %.2fMb loading"),
+			NumPoints, DatabaseBytes / 1024.0 / 1024.0, Bytes.Num() / 1024.0 / 1024.0, SavePeak / 1024.0 / 1024.0, LoadPeak / 1024.0 / 1024.0));
+	}
+
+	return true;
+}
@@ -0,0 +1,162 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Async/ParallelFor.h"
+#include "Dom/JsonObject.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+#include "PointCloudProfiler.h"
+#include "PointCloudStats.h"
+#include "PointCloudView.h"
+#include "PointCloudTestBase.h"
+
+namespace PointCloudProfilerTests
+{
+	/** Enable the profiler for the lifetime of the test, discarding what was recorded before */
+	struct FScopedProfiling
+	{
+		FScopedProfiling()
+			: bWasEnabled(FPointCloudProfiler::IsEnabled())
+		{
+			FPointCloudProfiler::Reset();
+			FPointCloudProfiler::SetEnabled(true);
+		}
+
+		~FScopedProfiling()
+		{
+			FPointCloudProfiler::SetEnabled(bWasEnabled);
+			FPointCloudProfiler::Reset();
+		}
+
+		bool bWasEnabled;
+	};
+
+	/** Return the lines of the CSV summary by path */
+	TMap<FString, TArray<FString>> ParseSummary(const FString& Csv)
+	{
+		TArray<FString> Lines;
+		Csv.ParseIntoArrayLines(Lines);
+
+		TMap<FString, TArray<FString>> Result;
+		for (int32 LineIndex = 1; LineIndex < Lines.Num(); ++LineIndex)
+		{
+			TArray<FString> Columns;
+			Lines[LineIndex].ParseIntoArray(Columns, TEXT(","));
+			Result.Add(Columns[0].TrimQuotes(), Columns);
+		}
+
+		return Result;
+	}
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudProfilerScopesTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.Profiler.Scopes", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Check that nested scopes and counters recorded on several threads are summarized on their paths, and exported as a valid Chrome trace
+bool FPointCloudProfilerScopesTest::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudProfilerTests;
+
+	const FPointCloudStatId OuterId = FPointCloudProfiler::GetStatId(TEXT("Profiler Test Outer"));
+	const FPointCloudStatId InnerId = FPointCloudProfiler::GetStatId(TEXT("Profiler Test Inner"));
+	const FPointCloudStatId CounterId = FPointCloudProfiler::GetStatId(TEXT("Profiler Test Counter"));
+
+	TestEqual("Names are interned once", FPointCloudProfiler::GetStatId(TEXT("Profiler Test Outer")), OuterId);
+	TestEqual("Ids give back their name", FPointCloudProfiler::GetStatName(InnerId), FString(TEXT("Profiler Test Inner")));
+
+	// Nothing is recorded while the profiler is disabled
+	{
+		const bool bWasEnabled = FPointCloudProfiler::IsEnabled();
+		FPointCloudProfiler::SetEnabled(false);
+		FPointCloudProfiler::Reset();
+
+		{
+			FPointCloudProfileScope Scope(OuterId);
+			FPointCloudProfiler::AddToCounter(CounterId, 1);
+		}
+
+		TestFalse("Disabled scopes are not recorded", FPointCloudProfiler::ExportSummaryCsv().Contains(TEXT("Profiler Test")));
+		FPointCloudProfiler::SetEnabled(bWasEnabled);
+	}
+
+	FScopedProfiling Profiling;
+
+	const int32 NumTasks = 64;
+
+	ParallelFor(NumTasks, [&](int32 TaskIndex)
+	{
+		FPointCloudProfileScope Outer(OuterId);
+
+		for (int32 Iteration = 0; Iteration < 4; ++Iteration)
+		{
+			FPointCloudProfileScope Inner(InnerId);
+			FPointCloudProfiler::AddToCounter(CounterId, 2);
+			FPlatformProcess::Sleep(0.0001f);
+		}
+	});
+
+	const TMap<FString, TArray<FString>> Summary = ParseSummary(FPointCloudProfiler::ExportSummaryCsv());
+
+	const TArray<FString>* Outer = Summary.Find(TEXT("Profiler Test Outer"));
+	const TArray<FString>* Inner = Summary.Find(TEXT("Profiler Test Outer/Profiler Test Inner"));
+	const TArray<FString>* Counter = Summary.Find(TEXT("Profiler Test Outer/Profiler Test Inner/Profiler Test Counter"));
+
+	if (!TestNotNull("The outer scope is summarized", Outer) || !TestNotNull("The inner scope is summarized under the outer scope", Inner) || !TestNotNull("The counter is summarized under the inner scope", Counter))
+	{
+		return false;
+	}
+
+	TestEqual("Calls of the outer scope", FCString::Atoi((*Outer)[1]), NumTasks);
+	TestEqual("Calls of the inner scope", FCString::Atoi((*Inner)[1]), NumTasks * 4);
+	TestEqual("Sum of the counter", FCString::Atoi((*Counter)[5]), NumTasks * 4 * 2);
+
+	const double OuterInclusive = FCString::Atod(*(*Outer)[2]);
+	const double OuterExclusive = FCString::Atod(*(*Outer)[3]);
+	const double InnerInclusive = FCString::Atod(*(*Inner)[2]);
+	TestTrue("The inner scopes are excluded from the exclusive time of the outer scope", FMath::IsNearlyEqual(OuterExclusive, OuterInclusive - InnerInclusive, 1.0e-3));
+
+	TSharedPtr<FJsonObject> Trace;
+	if (!TestTrue("The Chrome trace is valid JSON", FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(FPointCloudProfiler::ExportChromeTrace()), Trace) && Trace.IsValid()))
+	{
+		return false;
+	}
+
+	int32 NumCompleteEvents = 0;
+	for (const TSharedPtr<FJsonValue>& Event : Trace->GetArrayField(TEXT("traceEvents")))
+	{
+		NumCompleteEvents += Event->AsObject()->GetStringField(TEXT("ph")) == TEXT("X") ? 1 : 0;
+	}
+
+	TestEqual("Every scope is a complete event of the trace", NumCompleteEvents, NumTasks * 5);
+	TestEqual("No event was dropped", FPointCloudProfiler::GetNumDroppedEvents(), (int64)0);
+
+	FPointCloudStats Stats;
+	FPointCloudProfiler::AddToStats(Stats);
+	TestEqual("Calls are added to the stats", Stats.GetCounterValue(TEXT("Profile Profiler Test Outer Calls")), (int64)NumTasks);
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudProfilerQueriesTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.Profiler.Queries", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Check that the queries and temporary tables of a view are profiled
+bool FPointCloudProfilerQueriesTest::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudProfilerTests;
+
+	FAssetDeleter<UPointCloud> P(CreateTestAsset());
+	LoadDefaultCsv(P.Get());
+
+	FScopedProfiling Profiling;
+
+	UPointCloudView* View = MakeView(P.Get());
+	View->FilterOnPointExpression(TEXT("Minz > 0"));
+	View->GetCount();
+
+	const FString Summary = FPointCloudProfiler::ExportSummaryCsv();
+
+	TestTrue("The temporary table of the view is profiled", Summary.Contains(TEXT("PointCloud Temporary Query Table")));
+	TestTrue("The queries of the view are profiled", Summary.Contains(TEXT("/Query ")) || Summary.Contains(TEXT("\"Query ")));
+
+	return true;
+}
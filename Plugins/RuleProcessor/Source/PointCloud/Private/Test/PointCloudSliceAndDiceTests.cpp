@@ -0,0 +1,325 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Misc/ScopeLock.h"
+#include "TestingCommon.h"
+
+#include "PointCloudSliceAndDiceRuleSetScheduler.h"
+#include "PointCloudTestBase.h"
+#include "PointCloudView.h"
+
+namespace PointCloudSliceAndDiceTests
+{
+	/** Records the order in which rule instances are executed */
+	struct FExecutionLog
+	{
+		FCriticalSection Lock;
+		TArray<int32> PreExecuteOrder;
+		TArray<int32> PostExecuteOrder;
+		bool bGameThreadViolation = false;
+
+		void Reset()
+		{
+			PreExecuteOrder.Reset();
+			PostExecuteOrder.Reset();
+			bGameThreadViolation = false;
+		}
+	};
+
+	/** Rule instance that only logs its execution, standing in for the compiled rules */
+	class FLoggingRuleInstance : public FPointCloudRuleInstance
+	{
+	public:
+		using FPointCloudRuleInstance::PostExecute;
+
+		FLoggingRuleInstance(int32 InId, bool bInGameThreadOnly, bool bInSkipChildren, FExecutionLog& InLog)
+			: FPointCloudRuleInstance(nullptr), Id(InId), bGameThreadOnly(bInGameThreadOnly), bSkipChildren(bInSkipChildren), Log(InLog)
+		{}
+
+		int32 GetId() const { return Id; }
+
+		virtual bool CanBeExecutedOnAnyThread() const override { return !bGameThreadOnly; }
+
+		virtual bool PreExecute(FSliceAndDiceExecutionContextPtr Context) override
+		{
+			FScopeLock Lock(&Log.Lock);
+			Log.PreExecuteOrder.Add(Id);
+			Log.bGameThreadViolation |= bGameThreadOnly && !IsInGameThread();
+			SetSkipChildren(bSkipChildren);
+			return true;
+		}
+
+		virtual bool PostExecute(FSliceAndDiceExecutionContextPtr Context) override
+		{
+			FScopeLock Lock(&Log.Lock);
+			Log.PostExecuteOrder.Add(Id);
+			Log.bGameThreadViolation |= !IsInGameThread();
+			return true;
+		}
+
+	protected:
+		virtual FPointCloudRuleInstancePtr DuplicateInternal() const override
+		{
+			return MakeShareable(new FLoggingRuleInstance(Id, bGameThreadOnly, bSkipChildren, Log));
+		}
+
+	private:
+		int32 Id;
+		bool bGameThreadOnly;
+		bool bSkipChildren;
+		FExecutionLog& Log;
+	};
+
+	/** Records what rule instances read from their view and data, per point id */
+	struct FPointReadLog
+	{
+		FCriticalSection Lock;
+		TMap<int32, FString> Reads;
+	};
+
+	/** Rule instance that reads the queries rules commonly make on their view */
+	class FPointReadingRuleInstance : public FPointCloudRuleInstanceWithData<FPointReadingRuleInstance, FPointCloudRuleData>
+	{
+	public:
+		using FPointCloudRuleInstance::PostExecute;
+
+		FPointReadingRuleInstance(UPointCloud* InPointCloud, const FString& InMetadataKey, FPointReadLog& InLog)
+			: FPointCloudRuleInstanceWithData(nullptr, FPointCloudRuleData()), MetadataKey(InMetadataKey), Log(InLog)
+		{
+			SetPointCloud(InPointCloud);
+		}
+
+		void SetNameValue(const FString& InNameValue) { Data.NameValue = InNameValue; }
+
+		virtual bool PreExecute(FSliceAndDiceExecutionContextPtr Context) override
+		{
+			UpdateData();
+
+			UPointCloudView* View = GetView();
+
+			TArray<int32> Ids;
+			View->GetIndexes(Ids);
+
+			const TArray<FTransform> Transforms = View->GetTransforms();
+			const TMap<int, FString> Values = View->GetMetadataValues(MetadataKey);
+
+			const int32 Id = (Ids.Num() == 1) ? Ids[0] : INDEX_NONE;
+			const FString* Value = Values.Find(Id);
+
+			const FString Read = FString::Printf(TEXT("%d %d %s %s %s %s"), View->GetCount(), Transforms.Num(), Transforms.Num() ? *Transforms[0].GetLocation().ToString() : TEXT("-"),
+				Value ? **Value : TEXT("-"), *View->GetHash(), *Data.NameValue);
+
+			FScopeLock Lock(&Log.Lock);
+			Log.Reads.Add(Id, Read);
+
+			return true;
+		}
+
+		virtual bool PostExecute(FSliceAndDiceExecutionContextPtr Context) override
+		{
+			return true;
+		}
+
+	private:
+		FString MetadataKey;
+		FPointReadLog& Log;
+	};
+
+	static FPointCloudRuleInstancePtr AddInstance(FPointCloudRuleInstancePtr Parent, int32 Id, bool bGameThreadOnly, bool bSkipChildren, FExecutionLog& Log)
+	{
+		FPointCloudRuleInstancePtr Instance = MakeShareable(new FLoggingRuleInstance(Id, bGameThreadOnly, bSkipChildren, Log));
+
+		if (Parent)
+		{
+			Parent->AddChild(Instance);
+			Instance->SetParent(Parent);
+		}
+
+		return Instance;
+	}
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudRuleSetSchedulerTest, FPointCloudTestBaseClass, "RuleProcessor.SliceAndDice.RuleSetScheduler", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Check that the scheduler executes the same instances as the single threaded executor, in a compatible order
+bool FPointCloudRuleSetSchedulerTest::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudSliceAndDiceTests;
+
+	FExecutionLog Log;
+	int32 NextId = 0;
+
+	// Two roots with a mix of game thread only instances, skipped children and wide levels
+	TArray<FPointCloudRuleInstancePtr> Roots;
+
+	for (int32 RootIndex = 0; RootIndex < 2; ++RootIndex)
+	{
+		FPointCloudRuleInstancePtr Root = AddInstance(nullptr, NextId++, false, false, Log);
+		Roots.Add(Root);
+
+		for (int32 ChildIndex = 0; ChildIndex < 8; ++ChildIndex)
+		{
+			const bool bSkipChildren = (ChildIndex == 3);
+			FPointCloudRuleInstancePtr Child = AddInstance(Root, NextId++, false, bSkipChildren, Log);
+
+			for (int32 LeafIndex = 0; LeafIndex < 16; ++LeafIndex)
+			{
+				const bool bGameThreadOnly = (LeafIndex % 5 == 0);
+				AddInstance(Child, NextId++, bGameThreadOnly, false, Log);
+			}
+		}
+	}
+
+	for (const FPointCloudRuleInstancePtr& Root : Roots)
+	{
+		SliceAndDiceExecution::SingleThreadedRuleInstanceExecute(Root, nullptr);
+	}
+
+	const TArray<int32> ExpectedPreExecute = Log.PreExecuteOrder;
+	const TArray<int32> ExpectedPostExecute = Log.PostExecuteOrder;
+	Log.Reset();
+
+	FPointCloudSliceAndDiceRuleSetScheduler Scheduler(Roots, nullptr, true);
+	TestEqual("All instances are in the graph", Scheduler.NumInstances(), NextId);
+
+	Scheduler.Execute();
+
+	TestFalse("Game thread only steps ran on the game thread", Log.bGameThreadViolation);
+	TestEqual("PostExecute order matches the single threaded order", Log.PostExecuteOrder, ExpectedPostExecute);
+
+	TArray<int32> PreExecuted = Log.PreExecuteOrder;
+	PreExecuted.Sort();
+	TArray<int32> ExpectedPreExecuted = ExpectedPreExecute;
+	ExpectedPreExecuted.Sort();
+	TestEqual("Same instances were executed", PreExecuted, ExpectedPreExecuted);
+
+	// Children must only be executed once their parent has been
+	TArray<int32> PreExecuteIndex;
+	PreExecuteIndex.Init(INDEX_NONE, NextId);
+	for (int32 Index = 0; Index < Log.PreExecuteOrder.Num(); ++Index)
+	{
+		PreExecuteIndex[Log.PreExecuteOrder[Index]] = Index;
+	}
+
+	bool bParentsFirst = true;
+	TArray<FPointCloudRuleInstancePtr> ToVisit = Roots;
+
+	while (ToVisit.Num() > 0)
+	{
+		FPointCloudRuleInstancePtr Instance = ToVisit.Pop();
+		const int32 InstanceIndex = PreExecuteIndex[StaticCastSharedPtr<FLoggingRuleInstance>(Instance)->GetId()];
+
+		if (Instance->Parent && InstanceIndex != INDEX_NONE)
+		{
+			bParentsFirst &= PreExecuteIndex[StaticCastSharedPtr<FLoggingRuleInstance>(Instance->Parent)->GetId()] < InstanceIndex;
+		}
+
+		ToVisit.Append(Instance->Children);
+	}
+
+	TestTrue("Parents are executed before their children", bParentsFirst);
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudPerPointExecutionBenchmark, FPointCloudTestBaseClass, "RuleProcessor.SliceAndDice.PerPointExecutionBenchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Compare executing a rule for each point of a large point cloud with a filtered view per point, as the per point iterator used to,
+// and with the per point execution, checking that the rule reads the same values either way
+bool FPointCloudPerPointExecutionBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudSliceAndDiceTests;
+
+	FAssetDeleter<UPointCloud> P(CreateTestAsset());
+	UPointCloudImpl* PointCloud = Cast<UPointCloudImpl>(P.Get());
+
+	const int32 NumPoints = 100000;
+
+	// A filtered view per point takes minutes on the whole cloud, so the previous loop only runs on the first points
+	const int32 NumPreviousLoopPoints = 2000;
+
+	TArray<FTransform> Transforms;
+	TArray<FString> ColumnNames = { TEXT("Index"), TEXT("Group") };
+	TArray<int> MetadataCountPerVertex;
+	TArray<TPair<int, FString>> Metadata;
+
+	for (int32 I = 0; I < NumPoints; ++I)
+	{
+		Transforms.Add(FTransform(FVector(I % 1000, I / 1000, 0)));
+		Metadata.Add(TPair<int, FString>(0, FString::FromInt(I)));
+		Metadata.Add(TPair<int, FString>(1, FString::FromInt(I % 7)));
+		MetadataCountPerVertex.Add(2);
+	}
+
+	TestTrue("Load the points", PointCloud->InitFromPreparedData(TEXT("PerPoint"), Transforms, ColumnNames, MetadataCountPerVertex, Metadata, FBox(EForceInit::ForceInit)));
+
+	UPointCloudView* RootView = PointCloud->MakeView();
+
+	TArray<int32> Ids;
+	RootView->GetIndexes(Ids);
+	TestEqual("Check every point was loaded", Ids.Num(), NumPoints);
+
+	FPointReadLog Log;
+
+	TSharedPtr<FPointReadingRuleInstance> Root = MakeShareable(new FPointReadingRuleInstance(PointCloud, TEXT("Index"), Log));
+	Root->SetView(RootView);
+
+	FPointCloudRuleInstancePtr Child = MakeShareable(new FPointReadingRuleInstance(PointCloud, TEXT("Index"), Log));
+	Root->AddChild(Child);
+	Child->SetParent(Root);
+
+	double StartTime = FPlatformTime::Seconds();
+
+	for (int32 PointIndex = 0; PointIndex < FMath::Min(NumPreviousLoopPoints, Ids.Num()); ++PointIndex)
+	{
+		Root->SetNameValue(FString::FromInt(Ids[PointIndex]));
+
+		UPointCloudView* PerChildView = RootView->MakeChildView();
+		PerChildView->FilterOnIndex(Ids[PointIndex]);
+		Child->SetView(PerChildView);
+
+		SliceAndDiceExecution::SingleThreadedRuleInstanceExecute(Child, nullptr);
+	}
+
+	const double PreviousLoopTime = FPlatformTime::Seconds() - StartTime;
+	const TMap<int32, FString> PreviousLoopReads = MoveTemp(Log.Reads);
+
+	const FString RootHash = Root->GetHash();
+
+	auto MakePointInstance = [&RootHash](int32 PointId) -> FPointCloudRuleInstancePtr
+	{
+		TSharedPtr<FPointCloudPointRuleInstance<FPointCloudRuleData>> PointInstance = MakeShareable(new FPointCloudPointRuleInstance<FPointCloudRuleData>(nullptr, FPointCloudRuleData(), nullptr, RootHash));
+		PointInstance->GetData().NameValue = FString::FromInt(PointId);
+		return PointInstance;
+	};
+
+	double PerPointTimes[2] = { 0.0, 0.0 };
+
+	for (const bool bAllowWorkerThreads : { false, true })
+	{
+		Log.Reads.Reset();
+
+		StartTime = FPlatformTime::Seconds();
+		SliceAndDiceExecution::PerPointRuleInstanceExecute(Root->Children, RootView, nullptr, MakePointInstance, bAllowWorkerThreads);
+		PerPointTimes[bAllowWorkerThreads ? 1 : 0] = FPlatformTime::Seconds() - StartTime;
+
+		TestEqual("Check the rule was executed once per point", Log.Reads.Num(), NumPoints);
+
+		int32 Mismatches = 0;
+		for (const TPair<int32, FString>& PreviousLoopRead : PreviousLoopReads)
+		{
+			const FString* Read = Log.Reads.Find(PreviousLoopRead.Key);
+			Mismatches += (Read == nullptr || *Read != PreviousLoopRead.Value) ? 1 : 0;
+		}
+
+		TestEqual(FString::Printf(TEXT("Check the rule read the same values as with the previous loop (workers %d)"), (int32)bAllowWorkerThreads), Mismatches, 0);
+	}
+
+	const double PreviousLoopTimePerPoint = PreviousLoopTime / FMath::Max(PreviousLoopReads.Num(), 1);
+
+	AddInfo(FString::Printf(TEXT("Per point execution on %d points: previous loop %.3fs for %d points (%.3fs estimated for all), game thread %.3fs, workers %.3fs (%.2fx)"),
+		NumPoints, PreviousLoopTime, PreviousLoopReads.Num(), PreviousLoopTimePerPoint * NumPoints, PerPointTimes[0], PerPointTimes[1],
+		PerPointTimes[1] > 0.0 ? (PreviousLoopTimePerPoint * NumPoints) / PerPointTimes[1] : 0.0));
+
+	return true;
+}
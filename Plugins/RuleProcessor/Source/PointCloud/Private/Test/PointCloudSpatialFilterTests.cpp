@@ -0,0 +1,197 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#include "PointCloudImpl.h"
+#include "PointCloudSpatialIndex.h"
+#include "PointCloudTestBase.h"
+
+namespace PointCloudSpatialFilterTests
+{
+	static TArray<FPointCloudSpatialFilter> MakeFilters(const FVector& Center, double Size)
+	{
+		const FBox Box(Center - FVector(Size * 0.5), Center + FVector(Size * 0.5, Size * 0.25, Size));
+		const FTransform OrientedBox(FRotator(10, 30, 5), Center, FVector(Size * 0.5, Size * 0.3, Size * 0.2));
+
+		return {
+			FPointCloudSpatialFilter::MakeBox(Box, false),
+			FPointCloudSpatialFilter::MakeBox(Box, true),
+			FPointCloudSpatialFilter::MakeSphere(Center, Size * 0.5),
+			FPointCloudSpatialFilter::MakeOrientedBox(OrientedBox, false),
+			FPointCloudSpatialFilter::MakeOrientedBox(OrientedBox, true)
+		};
+	}
+
+	// Grid of points with integer coordinates, so many of them lie exactly on the faces of the filters
+	static void MakeGrid(int32 NumPoints, TArray<int32>& OutRowIds, TArray<FVector3f>& OutPositions)
+	{
+		for (int32 I = 0; I < NumPoints; ++I)
+		{
+			OutRowIds.Add(I + 1);
+			OutPositions.Add(FVector3f(I % 100, (I / 100) % 100, I / 10000));
+		}
+	}
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudSpatialFilterBlockTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.SpatialFilter.Blocks", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Check that testing blocks of points gives the same result as testing the points one at a time, including on the faces of the filters
+bool FPointCloudSpatialFilterBlockTest::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudSpatialFilterTests;
+
+	TArray<int32> RowIds;
+	TArray<FVector3f> Positions;
+	MakeGrid(20000, RowIds, Positions);
+
+	TArray<float> X, Y, Z;
+	for (const FVector3f& Position : Positions)
+	{
+		X.Add(Position.X);
+		Y.Add(Position.Y);
+		Z.Add(Position.Z);
+	}
+
+	const FPointCloudSpatialIndex Index(RowIds, Positions);
+
+	FRandomStream Random(0x5EED);
+
+	for (int32 Iteration = 0; Iteration < 8; ++Iteration)
+	{
+		// Integer centers and sizes put the faces of the boxes on grid points
+		const FVector Center(Random.RandRange(0, 100), Random.RandRange(0, 100), Random.RandRange(0, 2));
+		const TArray<FPointCloudSpatialFilter> Filters = MakeFilters(Center, Random.RandRange(2, 40));
+
+		for (int32 FilterIndex = 0; FilterIndex < Filters.Num(); ++FilterIndex)
+		{
+			const FPointCloudSpatialFilter& Filter = Filters[FilterIndex];
+
+			int32 Mismatches = 0;
+
+			// Full blocks, and blocks of every size up to a full block
+			for (int32 Begin = 0, BlockSize = 64; Begin < Positions.Num(); Begin += BlockSize, BlockSize = Begin % 3 == 0 ? 64 : 1 + Begin % 64)
+			{
+				const int32 Num = FMath::Min(BlockSize, Positions.Num() - Begin);
+				const uint64 Mask = Filter.ContainsBlock(X.GetData() + Begin, Y.GetData() + Begin, Z.GetData() + Begin, Num);
+
+				for (int32 PointIndex = 0; PointIndex < Num; ++PointIndex)
+				{
+					if (((Mask >> PointIndex) & 1) != (Filter.Contains(Positions[Begin + PointIndex]) ? 1 : 0))
+					{
+						++Mismatches;
+					}
+				}
+
+				if (Num < 64 && (Mask >> Num) != 0)
+				{
+					++Mismatches;
+				}
+			}
+
+			TestEqual(FString::Printf(TEXT("Iteration %d, filter %d: points where the block and the point tests differ"), Iteration, FilterIndex), Mismatches, 0);
+
+			// The index tests its leaves a block at a time
+			TBitArray<> Bits = Index.MakeFullSet();
+			Index.Intersect(Filter, Bits);
+
+			int32 Expected = 0;
+			for (const FVector3f& Position : Positions)
+			{
+				Expected += Filter.Contains(Position) ? 1 : 0;
+			}
+
+			TestEqual(FString::Printf(TEXT("Iteration %d, filter %d: points found by the index"), Iteration, FilterIndex), Bits.CountSetBits(), Expected);
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudSpatialFilterBenchmark, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.SpatialFilter.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Compare the rows per second of the IN_SPHERE and IN_OBB sql functions with testing the points one at a time and a block at a time
+bool FPointCloudSpatialFilterBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudSpatialFilterTests;
+
+	const int32 NumPoints = 400000;
+
+	TArray<int32> RowIds;
+	TArray<FVector3f> Positions;
+	MakeGrid(NumPoints, RowIds, Positions);
+
+	FAssetDeleter<UPointCloud> P(CreateTestAsset());
+	UPointCloudImpl* PointCloud = Cast<UPointCloudImpl>(P.Get());
+
+	TArray<FTransform> Transforms;
+	TArray<int> MetadataCountPerVertex;
+	TArray<TPair<int, FString>> Metadata;
+	for (const FVector3f& Position : Positions)
+	{
+		Transforms.Add(FTransform(FVector(Position)));
+		Metadata.Add(TPair<int, FString>(0, TEXT("1")));
+		MetadataCountPerVertex.Add(1);
+	}
+
+	TestTrue("Load the points", PointCloud->InitFromPreparedData(TEXT("Grid"), Transforms, { TEXT("Grid") }, MetadataCountPerVertex, Metadata, FBox(EForceInit::ForceInit)));
+
+	TArray<float> X, Y, Z;
+	for (const FVector3f& Position : Positions)
+	{
+		X.Add(Position.X);
+		Y.Add(Position.Y);
+		Z.Add(Position.Z);
+	}
+
+	const FVector Center(50.5, 50.5, 20.0);
+	const double Radius = 30.0;
+	const FTransform OrientedBox(FRotator(10, 30, 5), Center, FVector(20, 15, 10));
+
+	struct FCase
+	{
+		const TCHAR* Name;
+		FString Query;
+		FPointCloudSpatialFilter Filter;
+	};
+
+	const FRotator Rotation = OrientedBox.GetRotation().Rotator();
+
+	const FCase Cases[] = {
+		{ TEXT("Sphere"), FString::Printf(TEXT("SELECT COUNT(*) FROM SpatialQuery WHERE IN_SPHERE( %f, %f, %f, %f, Minx, Miny, Minz)>0"), Center.X, Center.Y, Center.Z, Radius), FPointCloudSpatialFilter::MakeSphere(Center, Radius) },
+		{ TEXT("Oriented box"), FString::Printf(TEXT("SELECT COUNT(*) FROM SpatialQuery WHERE IN_OBB(%f,%f,%f,%f,%f,%f,%f,%f,%f,Minx,Miny,Minz)"),
+			Rotation.Pitch, Rotation.Yaw, Rotation.Roll, Center.X, Center.Y, Center.Z, OrientedBox.GetScale3D().X, OrientedBox.GetScale3D().Y, OrientedBox.GetScale3D().Z), FPointCloudSpatialFilter::MakeOrientedBox(OrientedBox, false) }
+	};
+
+	for (const FCase& Case : Cases)
+	{
+		double StartTime = FPlatformTime::Seconds();
+		const int32 SqlCount = PointCloud->GetValue<int>(Case.Query);
+		const double SqlTime = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		int32 PointCount = 0;
+		for (const FVector3f& Position : Positions)
+		{
+			PointCount += Case.Filter.Contains(Position) ? 1 : 0;
+		}
+		const double PointTime = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		int32 BlockCount = 0;
+		for (int32 Begin = 0; Begin < NumPoints; Begin += 64)
+		{
+			BlockCount += FMath::CountBits(Case.Filter.ContainsBlock(X.GetData() + Begin, Y.GetData() + Begin, Z.GetData() + Begin, FMath::Min(64, NumPoints - Begin)));
+		}
+		const double BlockTime = FPlatformTime::Seconds() - StartTime;
+
+		TestEqual(FString::Printf(TEXT("%s: the block and point tests find the same points"), Case.Name), BlockCount, PointCount);
+
+		auto RowsPerSecond = [NumPoints](double Seconds) { return Seconds > 0.0 ? NumPoints / Seconds / 1.0e6 : 0.0; };
+
+		AddInfo(FString::Printf(TEXT("%s: sql function %.1fM rows/s (%d points), point tests %.1fM rows/s, block tests %.1fM rows/s (%d points)"),
+			Case.Name, RowsPerSecond(SqlTime), SqlCount, RowsPerSecond(PointTime), RowsPerSecond(BlockTime), BlockCount));
+	}
+
+	return true;
+}
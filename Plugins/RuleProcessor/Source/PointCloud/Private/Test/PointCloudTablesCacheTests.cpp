@@ -0,0 +1,241 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#include "PointCloudTablesCache.h"
+#include "PointCloudTestBase.h"
+
+#include <atomic>
+
+namespace PointCloudTablesCacheTests
+{
+	static FString MakeKey(int32 Index)
+	{
+		return FString::Printf(TEXT("QUERY_TABLE_%d"), Index);
+	}
+
+	static FString MakeTableName(const FString& Key)
+	{
+		return TEXT("Temp_") + Key + TEXT("_Table");
+	}
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudTablesCacheEvictionTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.TablesCache.Eviction", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Check which tables are evicted once the cache is over its table count or memory budget
+bool FPointCloudTablesCacheEvictionTest::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudTablesCacheTests;
+
+	// Without size or cost information, the least recently used table goes first
+	{
+		FPointCloudTemporaryTablesCache Cache(2, 1000, 1);
+		Cache.AddToCache(MakeKey(0), MakeTableName(MakeKey(0)));
+		Cache.AddToCache(MakeKey(1), MakeTableName(MakeKey(1)));
+		Cache.GetFromCache(MakeKey(0));
+
+		const TArray<FString> Evicted = Cache.AddToCache(MakeKey(2), MakeTableName(MakeKey(2)));
+		TestEqual("Check the least recently used table is evicted", Evicted, TArray<FString>({ MakeTableName(MakeKey(1)) }));
+		TestTrue("Check the used table is kept", Cache.Contains(MakeKey(0)));
+	}
+
+	// Tables that are quick to remake go before tables that are slow to remake, even if they were used more recently
+	{
+		FPointCloudTemporaryTablesCache Cache(2, 1000, 1);
+		Cache.AddToCache(MakeKey(0), MakeTableName(MakeKey(0)), 100, 10.0);
+		Cache.AddToCache(MakeKey(1), MakeTableName(MakeKey(1)), 100, 0.001);
+
+		const TArray<FString> Evicted = Cache.AddToCache(MakeKey(2), MakeTableName(MakeKey(2)), 100, 0.001);
+		TestEqual("Check the cheapest table is evicted", Evicted, TArray<FString>({ MakeTableName(MakeKey(1)) }));
+		TestTrue("Check the expensive table is kept", Cache.Contains(MakeKey(0)));
+	}
+
+	// Going over the memory budget evicts as many tables as needed, but never the table being added
+	{
+		FPointCloudTemporaryTablesCache Cache(100, 1000, 1);
+		Cache.AddToCache(MakeKey(0), MakeTableName(MakeKey(0)), 400, 1.0);
+		Cache.AddToCache(MakeKey(1), MakeTableName(MakeKey(1)), 400, 1.0);
+
+		const TArray<FString> Evicted = Cache.AddToCache(MakeKey(2), MakeTableName(MakeKey(2)), 2000, 1.0);
+		TestEqual("Check all other tables are evicted to make room", Evicted.Num(), 2);
+		TestTrue("Check the new table is kept", Cache.Contains(MakeKey(2)));
+		TestEqual("Check the size of the cache", Cache.GetStats().SizeBytes, (int64)2000);
+	}
+
+	// Hit and miss counters
+	{
+		FPointCloudTemporaryTablesCache Cache(100, 1000, 4);
+		Cache.AddToCache(MakeKey(0), MakeTableName(MakeKey(0)));
+
+		int32 CacheHits = 0;
+		TestEqual("Check a cached table is found", Cache.GetFromCache(MakeKey(0), &CacheHits), MakeTableName(MakeKey(0)));
+		TestEqual("Check the table use count", CacheHits, 2);
+		TestTrue("Check a missing table is not found", Cache.GetFromCache(MakeKey(1)).IsEmpty());
+
+		const FPointCloudTemporaryTablesCache::FCacheStats Stats = Cache.GetStats();
+		TestEqual("Check the hit count", Stats.Hits, (int64)1);
+		TestEqual("Check the miss count", Stats.Misses, (int64)1);
+
+		TestEqual("Check all tables are removed", Cache.RemoveAll(), TArray<FString>({ MakeTableName(MakeKey(0)) }));
+		TestEqual("Check the cache is empty", Cache.GetStats().NumTables, 0);
+	}
+
+	// Touching a table tells a cached table apart from a missing one
+	{
+		FPointCloudTemporaryTablesCache Cache(100, 1000, 1);
+		Cache.AddToCache(MakeKey(0), MakeTableName(MakeKey(0)));
+
+		int32 CacheHits = 0;
+		TestTrue("Check a cached table is touched", Cache.TryTouch(MakeKey(0), &CacheHits) == FPointCloudTemporaryTablesCache::ETouchResult::Touched);
+		TestEqual("Check the touched table use count", CacheHits, 2);
+		TestTrue("Check a missing table is reported as not cached", Cache.TryTouch(MakeKey(1), &CacheHits) == FPointCloudTemporaryTablesCache::ETouchResult::NotCached);
+		TestEqual("Check the missing table use count", CacheHits, 0);
+	}
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudTablesCacheStressTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.TablesCache.Stress", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Look up, add and evict tables from many threads at once and check the cache stays consistent
+bool FPointCloudTablesCacheStressTest::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudTablesCacheTests;
+
+	const int32 CacheSize = 64;
+	const int64 MemoryBudget = 64 * 1000;
+	const int64 MaxTableSize = 4000;
+	const int32 NumKeys = 256;
+	const int32 NumTasks = 64;
+	const int32 NumOperationsPerTask = 20000;
+
+	FPointCloudTemporaryTablesCache Cache(CacheSize, MemoryBudget);
+
+	std::atomic<int64> NumGets(0);
+	std::atomic<int64> NumTouches(0);
+	std::atomic<int32> NumWrongTables(0);
+	std::atomic<int32> NumWrongEvictions(0);
+
+	ParallelFor(NumTasks, [&](int32 TaskIndex)
+		{
+			FRandomStream Random(TaskIndex);
+
+			for (int32 Operation = 0; Operation < NumOperationsPerTask; ++Operation)
+			{
+				const FString Key = MakeKey(Random.RandHelper(NumKeys));
+				const int32 Choice = Random.RandHelper(10);
+
+				if (Choice < 6)
+				{
+					const FString TableName = Cache.GetFromCache(Key);
+					if (!TableName.IsEmpty() && TableName != MakeTableName(Key))
+					{
+						++NumWrongTables;
+					}
+					++NumGets;
+				}
+				else if (Choice < 8)
+				{
+					for (const FString& Evicted : Cache.AddToCache(Key, MakeTableName(Key), Random.RandRange(1, MaxTableSize), Random.FRand()))
+					{
+						if (!Evicted.StartsWith(TEXT("Temp_QUERY_TABLE_")))
+						{
+							++NumWrongEvictions;
+						}
+					}
+				}
+				else if (Choice < 9)
+				{
+					Cache.Contains(Key);
+				}
+				else
+				{
+					Cache.TryTouch(Key);
+					++NumTouches;
+				}
+			}
+		});
+
+	const FPointCloudTemporaryTablesCache::FCacheStats Stats = Cache.GetStats();
+
+	TestEqual("Check every table found matches its key", NumWrongTables.load(), 0);
+	TestEqual("Check every evicted table is one that was added", NumWrongEvictions.load(), 0);
+	TestTrue("Check every lookup was counted", Stats.Hits + Stats.Misses >= NumGets.load() && Stats.Hits + Stats.Misses <= NumGets.load() + NumTouches.load());
+	TestTrue("Check the cache is within its table count", Stats.NumTables <= FPointCloudTemporaryTablesCache::DefaultNumShards * FMath::DivideAndRoundUp(CacheSize, FPointCloudTemporaryTablesCache::DefaultNumShards));
+
+	// Each shard can hold one table over its budget, the one that was added last
+	TestTrue("Check the cache is within its memory budget", Stats.SizeBytes <= MemoryBudget + FPointCloudTemporaryTablesCache::DefaultNumShards * MaxTableSize);
+
+	for (int32 KeyIndex = 0; KeyIndex < NumKeys; ++KeyIndex)
+	{
+		const FString TableName = Cache.GetFromCache(MakeKey(KeyIndex));
+		if (!TableName.IsEmpty())
+		{
+			TestEqual("Check the cached table matches its key", TableName, MakeTableName(MakeKey(KeyIndex)));
+		}
+	}
+
+	TestEqual("Check all tables are removed", Cache.RemoveAll().Num(), Stats.NumTables);
+
+	AddInfo(FString::Printf(TEXT("%lld hits, %lld misses, %lld evictions, %lld contended locks, %.3fms waiting"),
+		Stats.Hits, Stats.Misses, Stats.Evictions, Stats.ContendedLocks, Stats.LockWaitSeconds * 1000.0));
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudTablesCacheContentionBenchmark, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.TablesCache.ContentionBenchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Compare the time spent waiting on locks when every worker looks tables up, with a single lock as the cache used to have and with shards
+bool FPointCloudTablesCacheContentionBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace PointCloudTablesCacheTests;
+
+	const int32 NumKeys = 1000;
+	const int32 NumWorkers = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	const int32 NumLookupsPerWorker = 200000;
+
+	TArray<FString> Keys;
+	for (int32 KeyIndex = 0; KeyIndex < NumKeys; ++KeyIndex)
+	{
+		Keys.Add(MakeKey(KeyIndex));
+	}
+
+	for (const int32 NumShards : { 1, FPointCloudTemporaryTablesCache::DefaultNumShards })
+	{
+		FPointCloudTemporaryTablesCache Cache(NumKeys, TNumericLimits<int64>::Max(), NumShards);
+		for (const FString& Key : Keys)
+		{
+			Cache.AddToCache(Key, MakeTableName(Key));
+		}
+
+		std::atomic<int32> NumFound(0);
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		ParallelFor(NumWorkers, [&](int32 WorkerIndex)
+			{
+				FRandomStream Random(WorkerIndex);
+				int32 WorkerFound = 0;
+
+				for (int32 Lookup = 0; Lookup < NumLookupsPerWorker; ++Lookup)
+				{
+					WorkerFound += Cache.GetFromCache(Keys[Random.RandHelper(NumKeys)]).IsEmpty() ? 0 : 1;
+				}
+
+				NumFound += WorkerFound;
+			});
+
+		const double Time = FPlatformTime::Seconds() - StartTime;
+		const FPointCloudTemporaryTablesCache::FCacheStats Stats = Cache.GetStats();
+
+		TestEqual(FString::Printf(TEXT("%d shards: every table is found"), NumShards), NumFound.load(), NumWorkers * NumLookupsPerWorker);
+
+		AddInfo(FString::Printf(TEXT("%d shards, %d workers: %.3fms, %lld contended locks, %.3fms waiting on locks"),
+			NumShards, NumWorkers, Time * 1000.0, Stats.ContendedLocks, Stats.LockWaitSeconds * 1000.0));
+	}
+
+	return true;
+}
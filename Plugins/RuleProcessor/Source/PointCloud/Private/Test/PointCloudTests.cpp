@@ -1,10 +1,16 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
+#include "HAL/FileManager.h"
 #include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
 #include "Tests/AutomationCommon.h"
 #include "TestingCommon.h"
 
+#include "PointCloudColumnarStore.h"
 #include "PointCloudImpl.h"
+#include "PointCloudView.h"
 #include "PointCloudTestBase.h"
 
 static const int TestPointCount = 7196;
@@ -235,5 +241,197 @@ bool FPointCloudLoadFromPoints::RunTest(const FString& Parameters)
 		TestTrue(FString::Printf(TEXT("Check Has Metadata %d"), I), P.Get()->HasMetaDataAttribute(FString::Printf(TEXT("Attribute %d"), I)));
 	}
 
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudColumnarRoundTripTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.ColumnarRoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Save a point cloud to the columnar format, load it into a new point cloud and check the contents match
+bool FPointCloudColumnarRoundTripTest::RunTest(const FString& Parameters)
+{
+	FAssetDeleter<UPointCloud> Source(CreateTestAsset());
+	LoadFromCsv(Source.Get(), TestDataFile);
+
+	const FString ColumnarFile = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("ColumnarRoundTrip.pcc")));
+
+	TestTrue("Save to columnar file", Source.Get()->SaveToDisk(ColumnarFile));
+
+	FAssetDeleter<UPointCloud> Loaded(CreateTestAsset());
+	TestTrue("Load from columnar file", Loaded.Get()->LoadFromColumnar(ColumnarFile));
+
+	TestEqual("Check the right number of points was loaded", Loaded.Get()->GetCount(), TestPointCount);
+	TestTrue("Check the metadata attributes match", Loaded.Get()->GetMetadataAttributes().Difference(Source.Get()->GetMetadataAttributes()).IsEmpty());
+	TestTrue("Check the bounds match", Loaded.Get()->GetBounds().Min.Equals(Source.Get()->GetBounds().Min, 0.01) && Loaded.Get()->GetBounds().Max.Equals(Source.Get()->GetBounds().Max, 0.01));
+
+	UPointCloudView* SourceView = Source.Get()->MakeView();
+	UPointCloudView* LoadedView = Loaded.Get()->MakeView();
+
+	TestEqual("Check metadata values match", LoadedView->GetUniqueMetadataValuesAndCounts(TEXT("Building_ID")).Num(), SourceView->GetUniqueMetadataValuesAndCounts(TEXT("Building_ID")).Num());
+
+	IFileManager::Get().Delete(*ColumnarFile);
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudColumnarMalformedHeaderTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.ColumnarMalformedHeader", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Columnar files whose header sizes or array counts don't fit in the file are rejected before anything is allocated for them
+bool FPointCloudColumnarMalformedHeaderTest::RunTest(const FString& Parameters)
+{
+	const FString ColumnarFile = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("ColumnarMalformed.pcc")));
+
+	auto WriteFile = [&ColumnarFile](uint64 HeaderSize, int32 NumAttributeNames, int32 NameLength)
+	{
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+
+		uint32 Magic = FPointCloudColumnarStore::FileMagic;
+		uint32 Version = FPointCloudColumnarStore::LatestVersion;
+		int32 NumPoints = 0;
+
+		Writer << Magic;
+		Writer << Version;
+		Writer << HeaderSize;
+		Writer << NumPoints;
+		Writer << NumAttributeNames;
+		Writer << NameLength;
+
+		// Padding, so the file is large enough for small counts to look plausible
+		Bytes.AddZeroed(64);
+
+		return FFileHelper::SaveArrayToFile(Bytes, *ColumnarFile);
+	};
+
+	FPointCloudColumnarStore Store;
+
+	TestTrue("Write a file with a header larger than an array view", WriteFile(uint64(MAX_int32) + 1, 1, 1));
+	TestFalse("Reject the header size", Store.LoadFromFile(ColumnarFile));
+
+	TestTrue("Write a file with too many attribute names", WriteFile(72, MAX_int32, 1));
+	TestFalse("Reject the attribute count", Store.LoadFromFile(ColumnarFile));
+
+	TestTrue("Write a file with an attribute name longer than the file", WriteFile(72, 1, MAX_int32));
+	TestFalse("Reject the attribute name length", Store.LoadFromFile(ColumnarFile));
+
+	TestTrue("Write a file with a UTF-16 attribute name longer than the file", WriteFile(72, 1, -(MAX_int32 / 2)));
+	TestFalse("Reject the UTF-16 attribute name length", Store.LoadFromFile(ColumnarFile));
+
+	IFileManager::Get().Delete(*ColumnarFile);
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudPartitionedLoadTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.PartitionedLoad", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Load enough points to be split across several partitions, some of which are outside the import bounds, and check each point kept its own metadata
+bool FPointCloudPartitionedLoadTest::RunTest(const FString& Parameters)
+{
+	FAssetDeleter<UPointCloud> P(CreateTestAsset());
+	UPointCloudImpl* PointCloud = Cast<UPointCloudImpl>(P.Get());
+
+	FPointCloudStatsPtr Stats = MakeShared<FPointCloudStats>();
+	PointCloud->SetStats(Stats);
+
+	const int32 NumPoints = 100000;
+	const int32 NumInside = (NumPoints * 3) / 4;
+
+	TArray<FTransform> Transforms;
+	TArray<FString> ColumnNames = { TEXT("Index"), TEXT("Third") };
+	TArray<int> MetadataCountPerVertex;
+	TArray<TPair<int, FString>> Metadata;
+
+	for (int32 I = 0; I < NumPoints; ++I)
+	{
+		Transforms.Add(FTransform(FVector(I, 0, 0)));
+		Metadata.Add(TPair<int, FString>(0, FString::FromInt(I)));
+
+		// Vary the number of metadata entries per point
+		if (I % 3 == 0)
+		{
+			Metadata.Add(TPair<int, FString>(1, TEXT("Yes")));
+		}
+
+		MetadataCountPerVertex.Add(I % 3 == 0 ? 2 : 1);
+	}
+
+	const FBox ImportBounds(FVector(-0.5, -1, -1), FVector(NumInside - 0.5, 1, 1));
+
+	TestTrue("Load the points", PointCloud->InitFromPreparedData(TEXT("Partitioned"), Transforms, ColumnNames, MetadataCountPerVertex, Metadata, ImportBounds));
+	TestEqual("Check only the points inside the bounds were loaded", PointCloud->GetCount(), NumInside);
+
+	UPointCloudView* View = PointCloud->MakeView();
+
+	TArray<FTransform> LoadedTransforms;
+	TArray<int32> LoadedIds;
+	View->GetTransformsAndIds(LoadedTransforms, LoadedIds);
+
+	const TMap<int, FString> IndexValues = View->GetMetadataValues(TEXT("Index"));
+	const TMap<int, FString> ThirdValues = View->GetMetadataValues(TEXT("Third"));
+
+	bool bMetadataMatches = LoadedIds.Num() == NumInside;
+	for (int32 I = 0; bMetadataMatches && I < LoadedIds.Num(); ++I)
+	{
+		const int32 SourceIndex = FMath::RoundToInt(LoadedTransforms[I].GetTranslation().X);
+		const FString* Index = IndexValues.Find(LoadedIds[I]);
+
+		bMetadataMatches = Index != nullptr && FCString::Atoi(**Index) == SourceIndex && ThirdValues.Contains(LoadedIds[I]) == (SourceIndex % 3 == 0);
+	}
+
+	TestTrue("Check every point has its own metadata", bMetadataMatches);
+
+	const FBox SpatialBounds(FVector(99.5, -1, -1), FVector(199.5, 1, 1));
+	UPointCloudView* SpatialView = PointCloud->MakeView();
+	SpatialView->FilterOnBoundingBox(SpatialBounds, false);
+	TestEqual("Check the spatial index covers the loaded points", SpatialView->GetCount(), 100);
+
+	TestTrue("Check the load was timed", Stats->GetTimerNames().Contains(TEXT("PointCloud Load Total")));
+	TestEqual("Check the skipped points were counted", Stats->GetCounterValue(TEXT("PointCloud Load Skipped Points")), (int64)(NumPoints - NumInside));
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudIncrementalHashTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.IncrementalHash", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Load points in several batches and check the hash updated from the changed vertex blocks matches the hash calculated from scratch
+bool FPointCloudIncrementalHashTest::RunTest(const FString& Parameters)
+{
+	FAssetDeleter<UPointCloud> P(CreateTestAsset());
+	UPointCloudImpl* PointCloud = Cast<UPointCloudImpl>(P.Get());
+
+	// Batches that don't line up with the vertex blocks, so the last block of each batch is shared with the next one
+	const TArray<int32> BatchSizes = { 5000, 3000, 10 };
+	const TArray<FString> ColumnNames = { TEXT("Index"), TEXT("Batch") };
+
+	FString PreviousHash = PointCloud->GetHashAsString();
+	int32 FirstIndex = 0;
+
+	for (int32 Batch = 0; Batch < BatchSizes.Num(); ++Batch)
+	{
+		TArray<FTransform> Transforms;
+		TArray<int> MetadataCountPerVertex;
+		TArray<TPair<int, FString>> Metadata;
+
+		for (int32 I = FirstIndex; I < FirstIndex + BatchSizes[Batch]; ++I)
+		{
+			Transforms.Add(FTransform(FVector(I, Batch, 0)));
+			Metadata.Add(TPair<int, FString>(0, FString::FromInt(I)));
+			Metadata.Add(TPair<int, FString>(1, FString::FromInt(Batch)));
+			MetadataCountPerVertex.Add(2);
+		}
+
+		FirstIndex += BatchSizes[Batch];
+
+		TestTrue(FString::Printf(TEXT("Load batch %d"), Batch), PointCloud->InitFromPreparedData(FString::Printf(TEXT("Batch%d"), Batch), Transforms, ColumnNames, MetadataCountPerVertex, Metadata, FBox(EForceInit::ForceInit)));
+
+		const FString IncrementalHash = PointCloud->GetHashAsString();
+		TestNotEqual(FString::Printf(TEXT("Check batch %d changed the hash"), Batch), IncrementalHash, PreviousHash);
+
+		// Throw the block hashes away and hash every block again
+		PointCloud->InvalidateHash(/*bContentChanged=*/true);
+		TestEqual(FString::Printf(TEXT("Check the incremental hash after batch %d matches the full hash"), Batch), PointCloud->GetHashAsString(), IncrementalHash);
+
+		PreviousHash = IncrementalHash;
+	}
+
 	return true;
 }
\ No newline at end of file
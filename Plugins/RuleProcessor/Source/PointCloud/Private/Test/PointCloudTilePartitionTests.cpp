@@ -0,0 +1,157 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+
+#include "PointCloudImpl.h"
+#include "PointCloudSpatialIndex.h"
+#include "PointCloudTilePartition.h"
+#include "PointCloudView.h"
+#include "PointCloudTestBase.h"
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudTilePartitionGridTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloud.TilePartition.Grid", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Check that partitioning points gives each tile the points its filter selects, in index order, including the points on the faces between tiles
+bool FPointCloudTilePartitionGridTest::RunTest(const FString& Parameters)
+{
+	// Grid of points with integer coordinates, large enough to be partitioned in several chunks, with tile faces on grid points
+	TArray<int32> RowIds;
+	TArray<FVector3f> Positions;
+
+	for (int32 I = 0; I < 100000; ++I)
+	{
+		RowIds.Add(I + 1);
+		Positions.Add(FVector3f(I % 100, (I / 100) % 100, I / 10000));
+	}
+
+	const TSharedPtr<const FPointCloudSpatialIndex> Index = MakeShared<const FPointCloudSpatialIndex>(RowIds, Positions);
+
+	const FBox GridBounds(FVector(0.0, 0.0, 0.0), FVector(100.0, 100.0, 10.0));
+	const FIntVector NumTiles(10, 4, 2);
+
+	auto MakeTileFilter = [&GridBounds, &NumTiles](const FIntVector& Tile)
+	{
+		const FVector TileSize = GridBounds.GetSize() / FVector(NumTiles);
+		return FPointCloudSpatialFilter::MakeBox(FBox(GridBounds.Min + TileSize * FVector(Tile), GridBounds.Min + TileSize * FVector(Tile + FIntVector(1))), false);
+	};
+
+	// Leave some points out, the partition only holds the points it is given
+	TBitArray<> Bits = Index->MakeFullSet();
+	for (int32 PointIndex = 0; PointIndex < Bits.Num(); PointIndex += 7)
+	{
+		Bits[PointIndex] = false;
+	}
+
+	const FPointCloudTilePartition Partition(Index, Bits, GridBounds, NumTiles, MakeTileFilter);
+
+	if (!TestEqual("Number of tiles", Partition.GetNumTiles(), NumTiles.X * NumTiles.Y * NumTiles.Z))
+	{
+		return false;
+	}
+
+	int32 NumSharedPoints = 0;
+
+	for (int32 X = 0; X < NumTiles.X; ++X)
+	{
+		for (int32 Y = 0; Y < NumTiles.Y; ++Y)
+		{
+			for (int32 Z = 0; Z < NumTiles.Z; ++Z)
+			{
+				TBitArray<> Expected = Bits;
+				Index->Intersect(MakeTileFilter(FIntVector(X, Y, Z)), Expected);
+
+				const int32 TileIndex = Partition.GetTileIndex(FIntVector(X, Y, Z));
+				const TConstArrayView<int32> Points = Partition.GetPoints(TileIndex);
+
+				TArray<int32> ExpectedPoints;
+				for (TConstSetBitIterator<> It(Expected); It; ++It)
+				{
+					ExpectedPoints.Add(It.GetIndex());
+				}
+
+				TestEqual(FString::Printf(TEXT("Tile %d %d %d has the points of its filter, in index order"), X, Y, Z), TArray<int32>(Points), ExpectedPoints);
+				TestTrue(FString::Printf(TEXT("Tile %d %d %d bits match its points"), X, Y, Z), Partition.MakeBits(TileIndex) == Expected);
+
+				NumSharedPoints += Points.Num();
+			}
+		}
+	}
+
+	TestTrue("Points on the faces between tiles are in both tiles", NumSharedPoints > Bits.CountSetBits());
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudTilePartitionViewTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloudView.TilePartition", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Check that views bound to a partition return the same points as views filtered on their tile in SQL
+bool FPointCloudTilePartitionViewTest::RunTest(const FString& Parameters)
+{
+	FAssetDeleter<UPointCloud> P(CreateTestAsset());
+
+	LoadDefaultCsv(P.Get());
+
+	IConsoleVariable* NativeFilters = IConsoleManager::Get().FindConsoleVariable(TEXT("t.RuleProcessor.NativeSpatialFilters"));
+	if (!TestNotNull("Find the native filters console variable", NativeFilters))
+	{
+		return false;
+	}
+
+	const int32 PreviousValue = NativeFilters->GetInt();
+
+	const int32 NumTilesX = 6;
+	const int32 NumTilesY = 5;
+
+	auto CompareTiles = [&](const TCHAR* What, UPointCloudView* Parent)
+	{
+		const FBox Bounds = Parent->GetResultsBoundingBox();
+
+		NativeFilters->Set(1);
+		TSharedPtr<const FPointCloudTilePartition> Partition = Parent->MakeChildView()->MakeTilePartition(Bounds, NumTilesX, NumTilesY, 1);
+
+		if (!TestTrue(FString::Printf(TEXT("%s can be partitioned"), What), Partition.IsValid()))
+		{
+			return;
+		}
+
+		for (int32 TileX = 0; TileX < NumTilesX; ++TileX)
+		{
+			for (int32 TileY = 0; TileY < NumTilesY; ++TileY)
+			{
+				NativeFilters->Set(0);
+				UPointCloudView* SqlView = Parent->MakeChildView();
+				SqlView->FilterOnTile(Bounds, NumTilesX, NumTilesY, 1, TileX, TileY, 0, false);
+
+				TArray<int32> SqlIds;
+				SqlView->GetIndexes(SqlIds);
+				SqlIds.Sort();
+
+				NativeFilters->Set(1);
+				UPointCloudView* PartitionView = Parent->MakeChildView();
+				TestTrue(FString::Printf(TEXT("%s tile %d %d is bound to its points"), What, TileX, TileY), PartitionView->FilterOnTile(Partition, TileX, TileY, 0));
+
+				TArray<int32> PartitionIds;
+				PartitionView->GetIndexes(PartitionIds);
+				PartitionIds.Sort();
+
+				TestEqual(FString::Printf(TEXT("%s tile %d %d returns the same points"), What, TileX, TileY), PartitionIds, SqlIds);
+				TestEqual(FString::Printf(TEXT("%s tile %d %d has as many points as the partition"), What, TileX, TileY), Partition->Num(Partition->GetTileIndex(FIntVector(TileX, TileY, 0))), SqlIds.Num());
+				TestEqual(FString::Printf(TEXT("%s tile %d %d has the same statements"), What, TileX, TileY), PartitionView->GetFilterStatements(), SqlView->GetFilterStatements());
+			}
+		}
+
+		// A partition only binds points to views that share the parent it was made from
+		UPointCloudView* Unrelated = MakeView(P.Get());
+		TestFalse(FString::Printf(TEXT("%s partition is not bound to unrelated views"), What), Unrelated->FilterOnTile(Partition, 0, 0, 0));
+	};
+
+	CompareTiles(TEXT("Point cloud"), MakeView(P.Get()));
+
+	UPointCloudView* Filtered = MakeView(P.Get());
+	Filtered->FilterOnPointExpression(TEXT("Minz > 0"));
+	CompareTiles(TEXT("Filtered view"), Filtered);
+
+	NativeFilters->Set(PreviousValue);
+
+	return true;
+}
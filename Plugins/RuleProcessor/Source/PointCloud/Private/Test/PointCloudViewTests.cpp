@@ -1,9 +1,12 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
+#include "HAL/IConsoleManager.h"
 #include "Misc/AutomationTest.h"
 #include "TestingCommon.h"
 #include "PointCloudView.h"
 #include "PointCloud.h"
+#include "PointCloudImpl.h"
+#include "PointCloudQueryPlan.h"
 
 #include "PointCloudTestBase.h"
 
@@ -89,5 +92,299 @@ bool FPointCloudViewTileTest::RunTest(const FString& Parameters)
 		TestTrue("Check a custom tile filter on a subset of the data", NewView->GetCount() != 0);
 	}
 
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudViewNativeFilterTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloudView.NativeFilters", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Check that filters evaluated against the in-memory spatial index return the same points as the SQL filters
+bool FPointCloudViewNativeFilterTest::RunTest(const FString& Parameters)
+{
+	FAssetDeleter<UPointCloud> P(CreateTestAsset());
+
+	LoadDefaultCsv(P.Get());
+
+	IConsoleVariable* NativeFilters = IConsoleManager::Get().FindConsoleVariable(TEXT("t.RuleProcessor.NativeSpatialFilters"));
+	if (!TestNotNull("Find the native filters console variable", NativeFilters))
+	{
+		return false;
+	}
+
+	const int32 PreviousValue = NativeFilters->GetInt();
+
+	const FBox Bounds = P.Get()->GetBounds();
+	const FString BuildingId = MakeView(P.Get())->GetUniqueMetadataValues(TEXT("Building_ID"))[0];
+
+	// Apply the same filters with and without the spatial index and compare the ids, count and bounds of the results
+	auto CompareFilters = [&](const TCHAR* What, TFunctionRef<UPointCloudView*()> MakeFilteredView)
+	{
+		NativeFilters->Set(0);
+		UPointCloudView* SqlView = MakeFilteredView();
+
+		TArray<int32> SqlIds;
+		SqlView->GetIndexes(SqlIds);
+		SqlIds.Sort();
+
+		NativeFilters->Set(1);
+		UPointCloudView* NativeView = MakeFilteredView();
+
+		TArray<int32> NativeIds;
+		NativeView->GetIndexes(NativeIds);
+
+		TestEqual(FString::Printf(TEXT("%s returns the same points"), What), NativeIds, SqlIds);
+		TestEqual(FString::Printf(TEXT("%s returns the same count"), What), NativeView->GetCount(), SqlIds.Num());
+		TestEqual(FString::Printf(TEXT("%s returns the same transforms"), What), NativeView->GetTransforms().Num(), SqlIds.Num());
+	};
+
+	CompareFilters(TEXT("Bounding box"), [&]()
+		{
+			UPointCloudView* View = MakeView(P.Get());
+			View->FilterOnBoundingBox(FBox(Bounds.Min, Bounds.GetCenter()), false);
+			return View;
+		});
+
+	CompareFilters(TEXT("Inverted bounding box"), [&]()
+		{
+			UPointCloudView* View = MakeView(P.Get());
+			View->FilterOnBoundingBox(FBox(Bounds.Min, Bounds.GetCenter()), true);
+			return View;
+		});
+
+	CompareFilters(TEXT("Bounding sphere"), [&]()
+		{
+			UPointCloudView* View = MakeView(P.Get());
+			View->FilterOnBoundingSphere(Bounds.GetCenter(), Bounds.GetExtent().Size2D() * 0.5);
+			return View;
+		});
+
+	CompareFilters(TEXT("Oriented bounding box"), [&]()
+		{
+			UPointCloudView* View = MakeView(P.Get());
+			View->FilterOnOrientedBoundingBox(FTransform(FRotator(0, 30, 0), Bounds.GetCenter(), Bounds.GetExtent() * 0.5), false);
+			return View;
+		});
+
+	// Child views combine their filters with those of their parents, including filters that can only be run in SQL
+	for (int32 Tile = 0; Tile < 4; ++Tile)
+	{
+		CompareFilters(*FString::Printf(TEXT("Tile %d of a metadata filter"), Tile), [&]()
+			{
+				UPointCloudView* View = MakeView(P.Get());
+				View->FilterOnMetadata(TEXT("Building_ID"), BuildingId);
+
+				UPointCloudView* Child = View->MakeChildView();
+				Child->FilterOnTile(2, 2, 1, Tile % 2, Tile / 2, 0, false);
+				return Child;
+			});
+	}
+
+	NativeFilters->Set(PreviousValue);
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudViewQueryPlanTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloudView.QueryPlan", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Check that views whose filters only differ by order share the same query plan and results
+bool FPointCloudViewQueryPlanTest::RunTest(const FString& Parameters)
+{
+	const FString IndexFilter = TEXT("SELECT Id FROM SpatialQuery WHERE Id=3");
+	const FString MetadataFilter = TEXT("SELECT Vertex_Id AS Id FROM Metadata WHERE Attribute_Name='Building_ID' AND Attribute_Value='1'");
+	const FString AllFilter = TEXT("SELECT Id FROM SpatialQuery");
+
+	const FPointCloudQueryPlan Plan = FPointCloudQueryPlan::Compile({ AllFilter, MetadataFilter, IndexFilter, MetadataFilter });
+	TestEqual("Check repeated statements are removed", Plan.Statements.Num(), 3);
+	TestEqual("Check the most selective statement is run first", Plan.Statements[0], IndexFilter);
+	TestEqual("Check the least selective statement is run last", Plan.Statements.Last(), AllFilter);
+	TestEqual("Check the order of the statements doesn't change the plan", FPointCloudQueryPlan::Compile({ IndexFilter, AllFilter, MetadataFilter }).Hash, Plan.Hash);
+
+	FAssetDeleter<UPointCloud> P(CreateTestAsset());
+	UPointCloudImpl* PointCloud = Cast<UPointCloudImpl>(P.Get());
+
+	LoadDefaultCsv(P.Get());
+
+	// Run the filters in SQL, the native filters don't go through the intersection tables
+	IConsoleVariable* NativeFilters = IConsoleManager::Get().FindConsoleVariable(TEXT("t.RuleProcessor.NativeSpatialFilters"));
+	if (!TestNotNull("Find the native filters console variable", NativeFilters))
+	{
+		return false;
+	}
+
+	const int32 PreviousValue = NativeFilters->GetInt();
+	NativeFilters->Set(0);
+
+	FPointCloudStatsPtr Stats = MakeShared<FPointCloudStats>();
+	PointCloud->SetStats(Stats);
+
+	const FString BuildingId = MakeView(P.Get())->GetUniqueMetadataValues(TEXT("Building_ID"))[0];
+	const int32 Count = P.Get()->GetCount();
+
+	UPointCloudView* ViewA = MakeView(P.Get());
+	ViewA->FilterOnMetadata(TEXT("Building_ID"), BuildingId);
+	ViewA->FilterOnTile(2, 2, 1, 0, 0, 0, true);
+	ViewA->FilterOnRange(0, Count / 2);
+
+	TArray<int32> IdsA;
+	ViewA->GetIndexes(IdsA);
+	const FString HashA = ViewA->GetHash();
+
+	const int64 HitsBefore = Stats->GetCounterValue(TEXT("PointCloud Query Plan Hits"));
+
+	// Same filters, in a different order and split between a parent and a child view
+	UPointCloudView* ViewB = MakeView(P.Get());
+	ViewB->FilterOnRange(0, Count / 2);
+	ViewB->FilterOnTile(2, 2, 1, 0, 0, 0, true);
+
+	UPointCloudView* ChildB = ViewB->MakeChildView();
+	ChildB->FilterOnMetadata(TEXT("Building_ID"), BuildingId);
+
+	TArray<int32> IdsB;
+	ChildB->GetIndexes(IdsB);
+
+	TestTrue("Check the filters keep some points", IdsA.Num() > 0);
+	TestEqual("Check the order of the filters doesn't change the results", IdsB, IdsA);
+	TestEqual("Check the order of the filters doesn't change the hash", ChildB->GetHash(), HashA);
+	TestTrue("Check the second view reused the results of the first", Stats->GetCounterValue(TEXT("PointCloud Query Plan Hits")) > HitsBefore);
+
+	NativeFilters->Set(PreviousValue);
+	PointCloud->SetStats(nullptr);
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPointCloudViewNativeMetadataTest, FPointCloudTestBaseClass, "RuleProcessor.PointCloudView.NativeMetadata", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+// Check that metadata filters, values and counts read from the in-memory attribute indices match the results of the SQL queries
+bool FPointCloudViewNativeMetadataTest::RunTest(const FString& Parameters)
+{
+	TestTrue("Check * matches any run of characters", FPointCloudMetadataFilter::MatchesGlob(TEXT("B*x*"), TEXT("Bax12")));
+	TestTrue("Check ? matches a single character", FPointCloudMetadataFilter::MatchesGlob(TEXT("?ax?"), TEXT("Bax1")));
+	TestFalse("Check patterns are case sensitive", FPointCloudMetadataFilter::MatchesGlob(TEXT("b*"), TEXT("Bax1")));
+	TestTrue("Check sets and ranges", FPointCloudMetadataFilter::MatchesGlob(TEXT("[A-C][^b-z]x[]0]"), TEXT("Bax]")));
+	TestFalse("Check an unterminated set never matches", FPointCloudMetadataFilter::MatchesGlob(TEXT("[A-C"), TEXT("B")));
+
+	FAssetDeleter<UPointCloud> P(CreateTestAsset());
+	UPointCloudImpl* PointCloud = Cast<UPointCloudImpl>(P.Get());
+
+	// Group has few values and is held as bitmaps, Index is numeric with a value per point, and Name is missing from some points
+	const int32 NumPoints = 3000;
+
+	TArray<FTransform> Transforms;
+	TArray<FString> ColumnNames = { TEXT("Group"), TEXT("Index"), TEXT("Name") };
+	TArray<int> MetadataCountPerVertex;
+	TArray<TPair<int, FString>> Metadata;
+
+	for (int32 I = 0; I < NumPoints; ++I)
+	{
+		Transforms.Add(FTransform(FVector(I % 50, I / 50, 0)));
+		Metadata.Add(TPair<int, FString>(0, FString::FromInt(I % 7)));
+		Metadata.Add(TPair<int, FString>(1, FString::FromInt(I)));
+
+		if (I % 5 != 0)
+		{
+			Metadata.Add(TPair<int, FString>(2, FString::Printf(TEXT("%c%cx%d"), TEXT('A') + I % 4, TEXT('a') + I % 6, I % 3)));
+		}
+
+		MetadataCountPerVertex.Add(I % 5 != 0 ? 3 : 2);
+	}
+
+	TestTrue("Load the points", PointCloud->InitFromPreparedData(TEXT("Metadata"), Transforms, ColumnNames, MetadataCountPerVertex, Metadata, FBox(EForceInit::ForceInit)));
+
+	IConsoleVariable* NativeMetadata = IConsoleManager::Get().FindConsoleVariable(TEXT("t.RuleProcessor.NativeMetadata"));
+	if (!TestNotNull("Find the native metadata console variable", NativeMetadata))
+	{
+		return false;
+	}
+
+	const int32 PreviousValue = NativeMetadata->GetInt();
+
+	auto SortCounts = [](TArray<TPair<TArray<FString>, int32>> Counts)
+	{
+		Counts.Sort([](const TPair<TArray<FString>, int32>& A, const TPair<TArray<FString>, int32>& B) { return FString::Join(A.Key, TEXT("|")) < FString::Join(B.Key, TEXT("|")); });
+		return Counts;
+	};
+
+	// Run the same queries with and without the attribute indices and compare the results
+	auto Compare = [&](const TCHAR* What, TFunctionRef<UPointCloudView*()> MakeFilteredView)
+	{
+		NativeMetadata->Set(0);
+		UPointCloudView* SqlView = MakeFilteredView();
+
+		TArray<int32> SqlIds;
+		SqlView->GetIndexes(SqlIds);
+		SqlIds.Sort();
+
+		TArray<float> SqlNumbers = SqlView->GetMetadataValuesArrayAsFloat(TEXT("Index"));
+		SqlNumbers.Sort();
+
+		const TMap<FString, int> SqlCounts = SqlView->GetUniqueMetadataValuesAndCounts(TEXT("Name"));
+		const TArray<TPair<TArray<FString>, int32>> SqlGroupCounts = SortCounts(SqlView->GetUniqueMetadataValuesAndCounts({ TEXT("Group"), TEXT("Name") }));
+		const TMap<int, FString> SqlValues = SqlView->GetMetadataValues(TEXT("Name"));
+
+		NativeMetadata->Set(1);
+		UPointCloudView* NativeView = MakeFilteredView();
+
+		TArray<int32> NativeIds;
+		NativeView->GetIndexes(NativeIds);
+
+		TArray<float> NativeNumbers = NativeView->GetMetadataValuesArrayAsFloat(TEXT("Index"));
+		NativeNumbers.Sort();
+
+		const TMap<FString, int> NativeCounts = NativeView->GetUniqueMetadataValuesAndCounts(TEXT("Name"));
+		const TMap<int, FString> NativeValues = NativeView->GetMetadataValues(TEXT("Name"));
+
+		TestEqual(FString::Printf(TEXT("%s returns the same points"), What), NativeIds, SqlIds);
+		TestEqual(FString::Printf(TEXT("%s returns the same numbers"), What), NativeNumbers, SqlNumbers);
+		TestTrue(FString::Printf(TEXT("%s returns the same counts"), What), NativeCounts.OrderIndependentCompareEqual(SqlCounts));
+		TestEqual(FString::Printf(TEXT("%s returns the same counts for combinations of values"), What), SortCounts(NativeView->GetUniqueMetadataValuesAndCounts({ TEXT("Group"), TEXT("Name") })), SqlGroupCounts);
+		TestTrue(FString::Printf(TEXT("%s returns the same values"), What), NativeValues.OrderIndependentCompareEqual(SqlValues));
+	};
+
+	Compare(TEXT("Unfiltered view"), [&]()
+		{
+			return MakeView(P.Get());
+		});
+
+	Compare(TEXT("Value filter"), [&]()
+		{
+			UPointCloudView* View = MakeView(P.Get());
+			View->FilterOnMetadata(TEXT("Group"), TEXT("3"));
+			return View;
+		});
+
+	Compare(TEXT("Inverted value filter"), [&]()
+		{
+			UPointCloudView* View = MakeView(P.Get());
+			View->FilterOnMetadata(TEXT("Name"), TEXT("Bbx1"), EFilterMode::FILTER_Not);
+			return View;
+		});
+
+	Compare(TEXT("Pattern filter"), [&]()
+		{
+			UPointCloudView* View = MakeView(P.Get());
+			View->FilterOnMetadataPattern(TEXT("Name"), TEXT("[A-B]?x*"));
+			return View;
+		});
+
+	Compare(TEXT("Inverted pattern filter on a numeric key"), [&]()
+		{
+			UPointCloudView* View = MakeView(P.Get());
+			View->FilterOnMetadataPattern(TEXT("Index"), TEXT("1*"), EFilterMode::FILTER_Not);
+			return View;
+		});
+
+	Compare(TEXT("Metadata and spatial filters in a child view"), [&]()
+		{
+			UPointCloudView* View = MakeView(P.Get());
+			View->FilterOnMetadataPattern(TEXT("Name"), TEXT("*x2"));
+
+			UPointCloudView* Child = View->MakeChildView();
+			Child->FilterOnBoundingBox(FBox(FVector(0, 0, -1), FVector(25, 30, 1)), false);
+			Child->FilterOnMetadata(TEXT("Group"), TEXT("1"), EFilterMode::FILTER_Not);
+			return Child;
+		});
+
+	NativeMetadata->Set(PreviousValue);
+
 	return true;
 }
\ No newline at end of file
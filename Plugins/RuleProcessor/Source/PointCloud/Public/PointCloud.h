@@ -153,6 +153,16 @@ public: // I/O Interface
 	*/
 	virtual bool LoadFromAlembic(const FString& FileName, const FBox& InImportBounds = FBox(EForceInit::ForceInit), ELoadMode Mode = UPointCloud::REPLACE, FFeedbackContext* Warn = nullptr) PURE_VIRTUAL(UPointCloud::LoadFromAlembic, return false;)
 
+	/**
+	* Load a point cloud from a columnar point cloud file (.pcc), as written by SaveToDisk.
+	* @return True if the file was loaded successfully, False on failure
+	* @param Mode - Controls if any existing data appended or replaced by the contents of the columnar file
+	* @param FileName - The path to the columnar file to load
+	* @param ImportBounds - Optional bounding box to define an import zone. Only points within the Import zone will be imported
+	* @param Warn - Pointer to a FeedbackContext item to provide updates during loading
+	*/
+	virtual bool LoadFromColumnar(const FString& FileName, const FBox& InImportBounds = FBox(EForceInit::ForceInit), ELoadMode Mode = UPointCloud::REPLACE, FFeedbackContext* Warn = nullptr) PURE_VIRTUAL(UPointCloud::LoadFromColumnar, return false;)
+
 	/**
 	* Load a point cloud from structured points.
 	* @return True if the data was loaded successfully, false otherwise
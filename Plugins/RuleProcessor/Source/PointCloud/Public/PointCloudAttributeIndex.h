@@ -0,0 +1,128 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/BitArray.h"
+
+class FPointCloudSpatialIndex;
+
+/**
+* A metadata predicate that can be evaluated directly against an FPointCloudAttributeIndex.
+* These mirror the SQL filters generated by UPointCloudView::FilterOnMetadata and FilterOnMetadataPattern so that either path returns the same points.
+*/
+struct POINTCLOUD_API FPointCloudMetadataFilter
+{
+	FPointCloudMetadataFilter() = default;
+
+	/** Make a filter that accepts points whose value for the key is, or is not if bInvert is set, the given value */
+	static FPointCloudMetadataFilter MakeValue(const FString& Key, const FString& Value, bool bInvert);
+
+	/** Make a filter that accepts points whose value for the key matches, or does not match if bInvert is set, the given GLOB pattern */
+	static FPointCloudMetadataFilter MakePattern(const FString& Key, const FString& Pattern, bool bInvert);
+
+	/** Return true if this filter can be evaluated natively */
+	bool IsValid() const { return !Key.IsEmpty(); }
+
+	/** Test a value against the filter. Points without a value for the key never pass, whether the filter is inverted or not */
+	bool Matches(const FString& Value) const;
+
+	/** Match a value against a pattern with the same rules as the SQL GLOB operator: case sensitive, with *, ? and [...] wildcards */
+	static bool MatchesGlob(const TCHAR* Pattern, const TCHAR* Value);
+
+	FString Key;
+	FString Value;
+	bool bGlob = false;
+	bool bInvert = false;
+};
+
+/**
+* In-memory, typed copy of the values of one metadata key of a point cloud.
+*
+* The distinct values of the key are held in a dictionary, sorted on their AttributeValues rowid, and each point holds the index of its
+* value in that dictionary. Points are in the order of the spatial index the attribute index was built for, so results are bit arrays
+* that can be combined directly with the results of spatial filters. Keys with few distinct values also hold a bit array of the points
+* for each value, so filters and counts become bitwise operations. Keys whose values are all numbers hold them as a numeric column.
+*/
+class POINTCLOUD_API FPointCloudAttributeIndex
+{
+public:
+
+	/** Keys with at most this many distinct values keep a bit array for each value, which takes no more memory than the value index column */
+	static constexpr int32 MaxBitmapValues = 32;
+
+	/**
+	* Build the index
+	* @param InSpatialIndex - The spatial index giving the order of the points
+	* @param InRowIds - The Vertex rowid of each point that has a value for the key
+	* @param InValueIds - The AttributeValues rowid of the value of each of those points
+	* @param InValues - The value for each AttributeValues rowid in InValueIds
+	*/
+	FPointCloudAttributeIndex(const TSharedPtr<const FPointCloudSpatialIndex>& InSpatialIndex, const TArray<int32>& InRowIds, const TArray<int32>& InValueIds, const TMap<int32, FString>& InValues);
+
+	/** Return the spatial index the points are ordered by */
+	const TSharedPtr<const FPointCloudSpatialIndex>& GetSpatialIndex() const { return SpatialIndex; }
+
+	/** Return the number of points, which is the number of points in the spatial index */
+	int32 Num() const { return ValueIndices.Num(); }
+
+	/** Return the number of distinct values */
+	int32 GetNumValues() const { return Values.Num(); }
+
+	/** Return a value from the dictionary */
+	const FString& GetValue(int32 ValueIndex) const { return Values[ValueIndex]; }
+
+	/** Return the AttributeValues rowid of a value from the dictionary */
+	int32 GetValueId(int32 ValueIndex) const { return ValueIds[ValueIndex]; }
+
+	/** Return the dictionary index of the value of a point, or INDEX_NONE if the point has no value for the key */
+	int32 GetValueIndex(int32 PointIndex) const { return ValueIndices[PointIndex]; }
+
+	/** Return true if every value of the key is a number, in which case the values of the points are held as a numeric column */
+	bool IsNumeric() const { return bNumeric; }
+
+	/** Return true if the index holds a bit array of the points for each value */
+	bool HasBitmaps() const { return Bitmaps.Num() > 0; }
+
+	/** Return the value of a point converted to a number, with the same conversion as SQL. The point must have a value for the key */
+	double GetNumber(int32 PointIndex) const { return bNumeric ? PointNumbers[PointIndex] : ValueNumbers[ValueIndices[PointIndex]]; }
+
+	/**
+	* Clear the bits of the points that do not pass the given filter
+	* @param Filter - A metadata filter on the key of this index
+	* @param InOutBits - The current result set, indexed in the order of the spatial index
+	*/
+	void Intersect(const FPointCloudMetadataFilter& Filter, TBitArray<>& InOutBits) const;
+
+	/**
+	* Count the points with each value
+	* @param Bits - The result set to count, or null to count every point
+	* @return The number of points for each value in the dictionary
+	*/
+	TArray<int32> CountValues(const TBitArray<>* Bits) const;
+
+private:
+
+	/** Return a bit array with a set bit for each value in the dictionary that passes the filter */
+	TBitArray<> MatchValues(const FPointCloudMetadataFilter& Filter) const;
+
+private:
+
+	TSharedPtr<const FPointCloudSpatialIndex> SpatialIndex;
+
+	// Dictionary, sorted on the AttributeValues rowid
+	TArray<FString> Values;
+	TArray<int32> ValueIds;
+	TArray<double> ValueNumbers;
+	TArray<int32> ValueCounts;
+
+	// Dictionary index of the value of each point, INDEX_NONE for points without a value
+	TArray<int32> ValueIndices;
+
+	// Points with each value, only held for keys with at most MaxBitmapValues values
+	TArray<TBitArray<>> Bitmaps;
+
+	// Value of each point as a number, only held for numeric keys
+	TArray<double> PointNumbers;
+	bool bNumeric = false;
+};
@@ -0,0 +1,69 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PointCloudStats.h"
+
+/**
+* Repeatable performance measurements of the point cloud and its views.
+*
+* Each run generates a deterministic synthetic point cloud of a given size, then times loading, hashing, serialization, filtering, tile
+* iteration and per point rule iteration on it. Timings and counters are recorded in an FPointCloudStats, which also receives the timings
+* and counters reported by the point cloud itself, and the runs are written out as a JSON report that can be compared across builds.
+*/
+class POINTCLOUD_API FPointCloudBenchmark
+{
+public:
+
+	/** Version of the JSON report, increase when the layout of the report or the meaning of its entries changes */
+	static constexpr int32 ReportVersion = 1;
+
+	struct FSettings
+	{
+		/** Number of points in each synthetic point cloud, one run is made for each */
+		TArray<int32> Sizes = { 10000, 100000, 1000000, 10000000 };
+
+		/** Seed of the synthetic point clouds, the same seed and size always give the same points */
+		int32 Seed = 0x5EED;
+
+		/** Number of tiles along X and Y iterated over in the tile stage */
+		int32 NumTilesPerAxis = 8;
+
+		/** Number of single point views made in the rule iteration stage */
+		int32 NumPointViews = 1000;
+	};
+
+	/** The result of running every stage on one synthetic point cloud */
+	struct FRun
+	{
+		int32 NumPoints = 0;
+		bool bSuccess = false;
+		FPointCloudStatsPtr Stats;
+	};
+
+	/**
+	* Generate a synthetic point cloud in the data layout used by UPointCloud::InitFromPreparedData. Points are spread with a constant density,
+	* and have a Group key with 16 values, a numeric Height key and a Name key with a value per block of about 100 points
+	* @param NumPoints - The number of points to generate
+	* @param Seed - The seed of the random stream the points are generated from
+	*/
+	static void MakeSyntheticCloud(int32 NumPoints, int32 Seed,
+		TArray<FTransform>& OutTransforms,
+		TArray<FString>& OutMetadataColumnNames,
+		TArray<int>& OutMetadataCountPerVertex,
+		TArray<TPair<int, FString>>& OutPreparedMetadata);
+
+	/** Run every stage on a synthetic point cloud of the given size */
+	static FRun RunSize(const FSettings& Settings, int32 NumPoints);
+
+	/** Run every stage on a synthetic point cloud of each size in the settings */
+	static TArray<FRun> Run(const FSettings& Settings);
+
+	/**
+	* Return a JSON report of the given runs. Timers are written in seconds and entries are sorted by name so reports can be diffed
+	* @param Settings - The settings the runs were made with
+	* @param Runs - The runs to report
+	*/
+	static FString MakeReport(const FSettings& Settings, const TArray<FRun>& Runs);
+};
@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "Commandlets/Commandlet.h"
+
+#include "PointCloudBenchmarkCommandlet.generated.h"
+
+POINTCLOUD_API DECLARE_LOG_CATEGORY_EXTERN(LogPointCloudBenchmark, Log, All);
+
+/**
+* Runs FPointCloudBenchmark without a world and saves its JSON report.
+* Usage: -run=PointCloudBenchmark [-Sizes=10000,100000] [-Seed=N] [-Tiles=N] [-PointViews=N] [-Output=Path]
+*/
+UCLASS()
+class POINTCLOUD_API UPointCloudBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+};
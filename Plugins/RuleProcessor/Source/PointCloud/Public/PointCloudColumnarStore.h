@@ -0,0 +1,159 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+* Columnar (structure of arrays) representation of the points held in a point cloud.
+*
+* Positions, orientations and scales are stored as contiguous float columns and each metadata key is dictionary encoded:
+* the distinct values of a key are stored once and each point stores an index into that dictionary.
+*
+* The on-disk format is versioned and laid out so that the columns can be used directly from a memory mapped file
+* without being copied. When a file cannot be mapped the columns are read into memory instead. The header, holding the
+* attribute names and dictionaries, is always deserialized.
+*
+* The store is an interchange format, UPointCloudImpl copies its points into the point cloud database on load.
+*/
+class POINTCLOUD_API FPointCloudColumnarStore
+{
+public:
+
+	/** File format versions. When adding new versions make sure to update LatestVersion below */
+	enum EVersion : uint32
+	{
+		VERSION_INVALID = 0,
+		VERSION_1 = 1,	// Initial version, float position / orientation / scale columns and dictionary encoded attributes
+
+		VERSION_PLUS_ONE,
+		LatestVersion = VERSION_PLUS_ONE - 1
+	};
+
+	/** Magic number written at the start of every columnar file */
+	static constexpr uint32 FileMagic = 0x53434350; // 'PCCS'
+
+	/** Alignment, in bytes, of each column in the file */
+	static constexpr uint64 ColumnAlignment = 16;
+
+	/** Value stored in an attribute column when a point has no value for the attribute */
+	static constexpr int32 NoValue = INDEX_NONE;
+
+	/** A single dictionary encoded metadata attribute */
+	struct FAttributeColumn
+	{
+		/** The name of the metadata key */
+		FString Name;
+
+		/** The distinct values for this key, indexed by the entries in the value id column */
+		TArray<FString> Dictionary;
+	};
+
+	FPointCloudColumnarStore();
+	~FPointCloudColumnarStore();
+
+	FPointCloudColumnarStore(const FPointCloudColumnarStore&) = delete;
+	FPointCloudColumnarStore& operator=(const FPointCloudColumnarStore&) = delete;
+
+	/**
+	* Build the columns from the data layout used by UPointCloud::InitFromPreparedData
+	* @param Transforms - One transform per point
+	* @param MetadataColumnNames - The names of the metadata keys
+	* @param MetadataCountPerVertex - The number of entries in PreparedMetadata associated to a given point
+	* @param PreparedMetadata - Pairs of (index into MetadataColumnNames, value)
+	* @return True if the input was consistent and the store was built
+	*/
+	bool InitFromPreparedData(const TArray<FTransform>& Transforms,
+		const TArray<FString>& MetadataColumnNames,
+		const TArray<int>& MetadataCountPerVertex,
+		const TArray<TPair<int, FString>>& PreparedMetadata);
+
+	/**
+	* Convert the columns back to the data layout used by UPointCloud::InitFromPreparedData
+	* @return True if the store holds data
+	*/
+	bool ToPreparedData(TArray<FTransform>& OutTransforms,
+		TArray<FString>& OutMetadataColumnNames,
+		TArray<int>& OutMetadataCountPerVertex,
+		TArray<TPair<int, FString>>& OutPreparedMetadata) const;
+
+	/**
+	* Write the store to disk
+	* @param FileName - The file to write
+	* @return True on success
+	*/
+	bool SaveToFile(const FString& FileName) const;
+
+	/**
+	* Load a store from disk. The file is memory mapped where the platform supports it, otherwise it is read into memory.
+	* Any previous content of the store is discarded.
+	* @param FileName - The file to read
+	* @return True on success
+	*/
+	bool LoadFromFile(const FString& FileName);
+
+	/** Release all of the columns and any file mapping */
+	void Reset();
+
+	/** Return true if the columns reference a memory mapped file rather than memory owned by this store */
+	bool IsMapped() const { return MappedRegion.IsValid(); }
+
+	/** Return the number of points in the store */
+	int32 Num() const { return NumPoints; }
+
+	/** Return the position column, three floats per point */
+	TArrayView<const FVector3f> GetPositions() const { return Positions; }
+
+	/** Return the orientation column, four floats per point */
+	TArrayView<const FVector4f> GetOrientations() const { return Orientations; }
+
+	/** Return the scale column, three floats per point */
+	TArrayView<const FVector3f> GetScales() const { return Scales; }
+
+	/** Return the metadata attributes held in the store */
+	const TArray<FAttributeColumn>& GetAttributes() const { return Attributes; }
+
+	/**
+	* Return the value id column for the given attribute, one entry per point. Entries are indices into the dictionary of the attribute or NoValue
+	* @param AttributeIndex - Index into GetAttributes()
+	*/
+	TArrayView<const int32> GetValueIds(int32 AttributeIndex) const { return ValueIds[AttributeIndex]; }
+
+	/** Return the transform of a given point */
+	FTransform GetTransform(int32 PointIndex) const;
+
+private:
+
+	/** Point the column views at the owned arrays */
+	void BindOwnedColumns();
+
+	/** Bind the column views to a file image held in memory, either mapped or loaded. Returns false if the image is malformed */
+	bool BindColumns(const uint8* Image, int64 ImageSize);
+
+private:
+
+	int32 NumPoints;
+
+	TArray<FAttributeColumn> Attributes;
+
+	// Views used by the accessors, these reference either the owned arrays below or the mapped file
+	TArrayView<const FVector3f> Positions;
+	TArrayView<const FVector4f> Orientations;
+	TArrayView<const FVector3f> Scales;
+	TArray<TArrayView<const int32>> ValueIds;
+
+	// Storage used when the store was built in memory or the file could not be mapped
+	TArray<FVector3f> OwnedPositions;
+	TArray<FVector4f> OwnedOrientations;
+	TArray<FVector3f> OwnedScales;
+	TArray<TArray<int32>> OwnedValueIds;
+	TArray<uint8> OwnedImage;
+
+	// File mapping, released on Reset
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+};
@@ -35,6 +35,25 @@ public:
 	* @return Warn - Feedback object to retrieve information about the progress
 	*/
 	static FPointCloudCsv Open(const FString& Name, FFeedbackContext* Warn = nullptr);
+
+	/**
+	* Open a new document from a filename, tokenizing the raw bytes of the file in parallel chunks rather than splitting it into lines first.
+	* Columns named in NumericColumns are converted to floats as they are parsed, all other columns are interned so that each distinct value is stored once.
+	* @param Name - The name of the file to open
+	* @param NumericColumns - The names of the columns that should be parsed as numbers
+	* @param Warn - Feedback object to retrieve information about the progress
+	* @return The parsed document, check GetIsOpen to see if parsing succeeded
+	*/
+	static FPointCloudCsv OpenStreaming(const FString& Name, const TSet<FString>& NumericColumns, FFeedbackContext* Warn = nullptr);
+
+	/**
+	* Parse a document from a buffer holding the contents of a CSV file. See OpenStreaming
+	* @param Buffer - The contents of the file
+	* @param NumericColumns - The names of the columns that should be parsed as numbers
+	* @param Warn - Feedback object to retrieve information about the progress
+	* @return The parsed document, check GetIsOpen to see if parsing succeeded
+	*/
+	static FPointCloudCsv ParseStreaming(TArrayView64<const uint8> Buffer, const TSet<FString>& NumericColumns, FFeedbackContext* Warn = nullptr);
 	
 	/**
 	* Query if this document is sucessfully open 	
@@ -55,6 +74,23 @@ public:
 	*/
 	TArray<FString>* GetColumn(const FString& Name);
 	
+	/**
+	* Return the contents of a column that was parsed as numbers by OpenStreaming
+	* @param Name - The name of the column to return
+	* @return Array containing the Columns Contents, or nullptr if the column is not a numeric column
+	*/
+	const TArray<float>* GetNumericColumn(const FString& Name) const;
+	TArray<float>* GetNumericColumn(const FString& Name);
+
+	/**
+	* Return the contents of a column that was interned by OpenStreaming
+	* @param Name - The name of the column to return
+	* @param OutValueIds - Set to an array holding, for each row, the index of the row's value in OutValues
+	* @param OutValues - Set to an array holding the distinct values of the column
+	* @return True if the column is an interned column
+	*/
+	bool GetInternedColumn(const FString& Name, const TArray<int32>*& OutValueIds, const TArray<FString>*& OutValues) const;
+
 	/**
 	* Given an index, return the name column
 	* @param Index - The column index to return 
@@ -84,4 +120,18 @@ private:
 	TMap<FString, TArray<FString>>	Columns;
 	/** The number of rows in this document */
 	int32							RowCount = 0;
+
+	/** A column whose distinct values are stored once */
+	struct FInternedColumn
+	{
+		/** For each row, the index of the value in Values */
+		TArray<int32>	ValueIds;
+		/** The distinct values in the order they were first seen */
+		TArray<FString>	Values;
+	};
+
+	/** Columns parsed as numbers by OpenStreaming */
+	TMap<FString, TArray<float>>	NumericColumns;
+	/** Columns interned by OpenStreaming */
+	TMap<FString, FInternedColumn>	InternedColumns;
 };
@@ -0,0 +1,32 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Guid.h"
+
+// Custom serialization version for changes made to the point cloud assets
+struct POINTCLOUD_API FPointCloudCustomVersion
+{
+	enum Type
+	{
+		// Before any version changes were made
+		BeforeCustomVersionWasAdded = 0,
+
+		// The database is written as independently compressed chunks rather than a single compressed buffer
+		StreamedDatabase,
+
+		// The saved hash is built from per block hashes of the vertices rather than the SHA1 of the serialized database
+		BlockTreeHash,
+
+		// -----<new versions can be added above this line>-------------------------------------------------
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	// The GUID for this custom version number
+	const static FGuid GUID;
+
+private:
+	FPointCloudCustomVersion() {}
+};
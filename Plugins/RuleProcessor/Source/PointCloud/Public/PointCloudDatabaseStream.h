@@ -0,0 +1,90 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Chunked archive format for the serialized point cloud database.
+*
+* The database image is written as a header followed by fixed size chunks, each compressed on its own. Chunks are compressed and
+* decompressed a batch at a time, in parallel, so the memory used on top of the database image is bounded by the size of a batch
+* rather than by the size of the database.
+*/
+class POINTCLOUD_API FPointCloudDatabaseStream
+{
+public:
+
+	/** Largest chunk size a stream can use, which keeps the compression bound of a chunk within an int32 */
+	static constexpr int32 MaxChunkSize = 64 * 1024 * 1024;
+
+	/** Largest number of chunks a stream can hold */
+	static constexpr int64 MaxNumChunks = MAX_int32;
+
+	struct FSettings
+	{
+		/** Size in bytes of the chunks the database image is split into */
+		int32 ChunkSize = 1024 * 1024;
+
+		/** Number of chunks held in memory at once, which bounds the memory used while streaming */
+		int32 MaxChunksInFlight = 8;
+
+		/** Compression used for each chunk, NAME_None stores the chunks as they are */
+		FName CompressionFormat = NAME_Oodle;
+
+		/** If false the chunks of a batch are compressed one after the other on the calling thread */
+		bool bParallel = true;
+	};
+
+	/** Describes the stream that was written or read */
+	struct FStreamStats
+	{
+		int32 NumChunks = 0;
+		int64 CompressedBytes = 0;
+
+		/** Largest number of bytes held for chunks at once, on top of the database image itself */
+		int64 PeakScratchBytes = 0;
+	};
+
+	/** Everything in the stream that isn't chunk data */
+	struct FHeader
+	{
+		int64 Size = 0;
+		int32 ChunkSize = 0;
+		FName CompressionFormat;
+
+		int32 GetNumChunks() const;
+	};
+
+	/**
+	* Write a database image to an archive
+	* @param Ar - The archive to write to
+	* @param Data - The database image
+	* @param Size - The size in bytes of the database image
+	* @param Settings - How to split and compress the image
+	* @param OutStats - If set, receives a description of what was written
+	* @return True on success
+	*/
+	static bool Save(FArchive& Ar, const uint8* Data, int64 Size, const FSettings& Settings = FSettings(), FStreamStats* OutStats = nullptr);
+
+	/**
+	* Read the header of a stream, which gives the size of the buffer LoadChunks needs. The header is rejected if its chunk size or chunk count
+	* is out of range, or if the archive is too small to hold the chunks it describes
+	* @return True if the header is valid
+	*/
+	static bool LoadHeader(FArchive& Ar, FHeader& OutHeader);
+
+	/**
+	* Read the chunks of a stream into a buffer
+	* @param Ar - The archive to read from, positioned after the header
+	* @param Header - The header returned by LoadHeader
+	* @param OutData - A buffer of at least Header.Size bytes
+	* @param MaxChunksInFlight - Number of chunks held in memory at once
+	* @param OutStats - If set, receives a description of what was read
+	* @return True on success
+	*/
+	static bool LoadChunks(FArchive& Ar, const FHeader& Header, uint8* OutData, int32 MaxChunksInFlight = FSettings().MaxChunksInFlight, FStreamStats* OutStats = nullptr);
+
+	/** Return the largest amount of memory that saving with the given settings holds for chunks at once */
+	static int64 GetScratchBudget(const FSettings& Settings);
+};
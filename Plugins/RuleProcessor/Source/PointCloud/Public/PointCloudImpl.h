@@ -3,18 +3,29 @@
 #pragma once
 
 #include "PointCloud.h"
+#include "PointCloudProfiler.h"
+#include "PointCloudQueryPlan.h"
 #include "PointCloudSqliteHelpers.h"
+#include "PointCloudStats.h"
 #include "PointCloudTablesCache.h"
 
 #include "PointCloudImpl.generated.h"
 
 class FPointCloudQuery;
+class FPointCloudSpatialIndex;
+class FPointCloudAttributeIndex;
+class FPointCloudColumnarStore;
 
 namespace PointCloud
 {
 	struct QueryLogger;
 }
 
+namespace PointCloudPrivateNamespace
+{
+	struct FLoadPartition;
+}
+
 /**
 * Private implementation of the UPointCloud class
 */
@@ -157,6 +168,18 @@ public: // I/O Interface
 	*/
 	virtual bool LoadFromAlembic(const FString& FileName, const FBox& InImportBounds = FBox(EForceInit::ForceInit), ELoadMode Mode = UPointCloud::REPLACE, FFeedbackContext* Warn = nullptr) override;
 
+	/**
+	* Load a point cloud from a columnar point cloud file (.pcc).
+	* Every point is still inserted into the point cloud database, which views and queries run against. Compared to a CSV the load skips the
+	* text parsing and only converts the distinct metadata values, but its cost still grows with the number of points.
+	* @return True if the file was loaded successfully, False on failure
+	* @param Mode - Controls if any existing data appended or replaced by the contents of the columnar file
+	* @param FileName - The path to the columnar file to load
+	* @param ImportBounds - Optional bounding box to define an import zone. Only points within the Import zone will be imported
+	* @param Warn - Pointer to a FeedbackContext item to provide updates during loading
+	*/
+	virtual bool LoadFromColumnar(const FString& FileName, const FBox& InImportBounds = FBox(EForceInit::ForceInit), ELoadMode Mode = UPointCloud::REPLACE, FFeedbackContext* Warn = nullptr) override;
+
 	/**
 	* Load a point cloud from structured points.
 	* @return True if the data was loaded successfully, false otherwise
@@ -167,13 +190,21 @@ public: // I/O Interface
 	virtual bool LoadFromStructuredPoints(const TArray<FPointCloudPoint>& InPoints, const FBox& InImportBounds = FBox(EForceInit::ForceInit), FFeedbackContext* Warn = nullptr) override;
 
 	/**
-	* Save this PointCloud to a file on disk. This currently only saves .db files compatible with SQLLITE3. More formats may be added in the future. 
-	* No name or extension checking is performed. You get what you ask for if the file can be written. 
+	* Save this PointCloud to a file on disk. Files with the .pcc extension are written in the columnar point cloud format, anything else is saved as a .db file compatible with SQLLITE3.
+	* No other name or extension checking is performed. You get what you ask for if the file can be written. 
 	* @return True if the file could be saved to disk correctly, False if the saving failed
 	* @param FileName - The name of the file to write
 	*/
 	virtual bool SaveToDisk(const FString& FileName) override;
 
+	/**
+	* Save the points and metadata in this PointCloud to a columnar point cloud file. The file can be loaded with LoadFromColumnar.
+	* The points and metadata are read back from the point cloud database to build the columns.
+	* @return True if the file could be saved to disk correctly, False if the saving failed
+	* @param FileName - The name of the file to write
+	*/
+	bool SaveToColumnar(const FString& FileName);
+
 	/**
 	* Set a file name for an SQL Log. This records all of the queries executed by the database
 	* @return True if the file name is valid, false otherwise
@@ -181,6 +212,15 @@ public: // I/O Interface
 	*/
 	bool SetSqlLog(const FString& FileName);
 
+	/**
+	* Set a stats object used to record the time taken by each phase of a bulk load, and counts of the points and attributes loaded
+	* @param InStats - A pointer to a stats gathering object, or null to stop recording
+	*/
+	void SetStats(FPointCloudStatsPtr InStats) { Stats = InStats; }
+
+	/** Return the stats object used to record load statistics, may be null */
+	FPointCloudStatsPtr GetStats() const { return Stats; }
+
 	/**
 	* Call this function to start logging sql calls
 	* @return True if logging can be started. This may return false if SetSqlLog has not been called with a valid log file name	
@@ -201,8 +241,9 @@ public: // I/O Interface
 
 	/** Invalidate the WholeDb Hash. This will cause it to be recalculated the next time GetHashString() is called. This is expensive so don't do this unless you REALLY need to, and you know
 	* that the Pointcloud database is out of date. In general this will be done automatically and you won't need to be conernced. You'll know if you've done something to invalidate the hash.
+	* @param bContentChanged - If true, the vertex blocks hashed so far are discarded and every block is hashed again
 	*/
-	void InvalidateHash();
+	void InvalidateHash(bool bContentChanged = false);
 
 	/** Return true if the whole DB hash for this object is invalid
 	* @return True if the hash is currently invalid and needs to be recalculated
@@ -214,8 +255,8 @@ public: // I/O Interface
 	*/
 	FString GetHashAsString() const;
 
-	/** Return the SHA256 hash of the entire database. This is calculated when requested and may be stored. Any insert or update calls to the database will invalidate this hash and
-	* it will be recalculated. This is an expensive operation and shouldn't be done on frequently changing data
+	/** Return the SHA1 hash of the entire database. This is calculated when requested and may be stored. Any insert or update calls to the database will invalidate this hash and
+	* it will be recalculated. The hash is built from a hash per block of vertices, so only the blocks that changed since the last calculation are read again
 	* @return The hash of the entire database
 	*/
 	FSHA1 GetHash() const;
@@ -233,9 +274,10 @@ public: // ~ Query interface
 	* @param Query - The SQL query to execute on this pointcloud
 	* @param InOriginatingFile - The filename from which the query is called, used only if RULEPROCESSOR_ENABLE_LOGGING is defined, optional.
 	* @param InOriginatingLine - The line from which the query is called, used only if RULEPROCESSOR_ENABLE_LOGGING is defined, optional.
+	* @param InStatId - The id the query is profiled under, interned once per call site. If INDEX_NONE it is made from the originating file and line, optional.
 	* @return True if query executed correctly
 	*/
-	bool RunQuery(const FString& Query, const FString& InOriginatingFile = FString(), const uint32 InOriginatingLine = 0);
+	bool RunQuery(const FString& Query, const FString& InOriginatingFile = FString(), const uint32 InOriginatingLine = 0, FPointCloudStatId InStatId = INDEX_NONE);
 
 	/**
 	* Run a query over the database and return true if the query executed without error.
@@ -244,9 +286,10 @@ public: // ~ Query interface
 	* @param UsrData - An optional pointer to some user data that will be passed into the callback function (can be null)
 	* @param InOriginatingFile - The filename from which the query is called, used only if RULEPROCESSOR_ENABLE_LOGGING is defined, optional.
 	* @param InOriginatingLine - The line from which the query is called, used only if RULEPROCESSOR_ENABLE_LOGGING is defined, optional.
+	* @param InStatId - The id the query is profiled under, interned once per call site. If INDEX_NONE it is made from the originating file and line, optional.
 	* @return True if query executed correctly
 	*/
-	bool RunQuery(const FString& Query, int (*Callback)(void*, int, char**, char**), void* UsrData, const FString& InOriginatingFile = FString(), const uint32 InOriginatingLine = 0);
+	bool RunQuery(const FString& Query, int (*Callback)(void*, int, char**, char**), void* UsrData, const FString& InOriginatingFile = FString(), const uint32 InOriginatingLine = 0, FPointCloudStatId InStatId = INDEX_NONE);
 
 private:
 
@@ -343,6 +386,33 @@ private:
 	/** Generic method to get values from a query. Contains all the common boilerplate, but the helper functions do the retrieval */
 	void GetValues(const FString& Query, const TArray<FString>& ColumnNames, TFunction<void(sqlite3_stmt*, int*)> Retrieval) const;
 
+	/**
+	* Common part of the bulk loads. Inserts the object and its keys, builds the rows of each partition in parallel and merges them into the database
+	* @param ObjectName - The name to associated with this set of data in the PointCloud
+	* @param Count - The number of incoming points
+	* @param MetadataColumnNames - The names of the metadata keys
+	* @param Partitions - Contiguous ranges of the incoming points, filled in by BuildRows
+	* @param InsertValues - Inserts the distinct metadata values and maps them to database ids, called once the keys are inserted
+	* @param BuildRows - Builds the rows of one partition given the database id of each metadata key, called from worker threads
+	* @param Warn - Optional Feedback context
+	* @return True if the insert succeeds, false otherwise
+	*/
+	bool BulkInsertPartitions(const FString& ObjectName,
+		int32 Count,
+		const TArray<FString>& MetadataColumnNames,
+		TArray<PointCloudPrivateNamespace::FLoadPartition>& Partitions,
+		TFunctionRef<bool()> InsertValues,
+		TFunctionRef<void(PointCloudPrivateNamespace::FLoadPartition&, const TArray<int32>&)> BuildRows,
+		FFeedbackContext* Warn);
+
+	/**
+	* Insert the values of metadata dictionaries, each distinct value once, and map every dictionary entry to its database id
+	* @param Dictionaries - The distinct values of each metadata key
+	* @param OutValueIdFromDictionary - Set to the database id of each dictionary entry, per key
+	* @return True if every value was inserted
+	*/
+	bool InsertDictionaryValues(TArrayView<const TArray<FString>* const> Dictionaries, TArray<TArray<int32>>& OutValueIdFromDictionary);
+
 public:
 
 	/**
@@ -364,6 +434,37 @@ public:
 								FFeedbackContext*					Warn = nullptr
 	) override;
 
+	/**
+	* Initialize From a Columnar Store. The points are read straight from the columns of the store and metadata values are mapped from dictionary ids,
+	* so only the distinct values of each attribute are converted to strings for the database
+	* @param ObjectName - The name to associated with this set of data in the PointCloud
+	* @param Store - The store to read the points from, this must stay valid for the duration of the call
+	* @param ImportBounds - Points outside these bounds are skipped, if they are valid
+	* @param Warn - Optional Feedback context
+	* @return True if the insert succeeds, false otherwise
+	*/
+	bool InitFromColumnarStore(const FString& ObjectName, const FPointCloudColumnarStore& Store, const FBox& ImportBounds, FFeedbackContext* Warn = nullptr);
+
+	/**
+	* Initialize From dictionary encoded metadata columns, such as the interned columns of FPointCloudCsv::OpenStreaming. Every point has a value
+	* for every key, and values are bound through their dictionary id so only the distinct values of each key are converted for the database
+	* @param ObjectName - The name to associated with this set of data in the PointCloud
+	* @param PreparedTransforms - An Array of Transforms, one for each point to be added to the point cloud
+	* @param MetadataColumnNames - The names of the metadata keys
+	* @param ValueIdColumns - For each key, the index into its dictionary of the value of each point
+	* @param Dictionaries - For each key, its distinct values
+	* @param ImportBounds - Points outside these bounds are skipped, if they are valid
+	* @param Warn - Optional Feedback context
+	* @return True if the insert succeeds, false otherwise
+	*/
+	bool InitFromInternedColumns(const FString& ObjectName,
+		const TArray<FTransform>& PreparedTransforms,
+		const TArray<FString>& MetadataColumnNames,
+		TArrayView<const TArray<int32>* const> ValueIdColumns,
+		TArrayView<const TArray<FString>* const> Dictionaries,
+		const FBox& ImportBounds,
+		FFeedbackContext* Warn = nullptr);
+
 	/**
 	* Clear any temporary Tables
 	*/
@@ -374,6 +475,9 @@ public:
 	*/
 	TArray<TPair<FString, int32>> GetQueryCacheMissCounts() const;
 
+	/** Return the hit, miss, eviction and lock contention counters of the temporary table cache */
+	FPointCloudTemporaryTablesCache::FCacheStats GetTemporaryTableCacheStats() const { return TemporaryTables.GetStats(); }
+
 public:
 
 	/** Return the number of temporary tables to keep around, this controls the size of TemporaryTables
@@ -381,6 +485,16 @@ public:
 	*/
 	static int32 GetTemporaryTableCacheSize();
 
+	/** Return the estimated size in bytes of the temporary tables to keep around. Once over this, tables that are cheap to remake are evicted first
+	* @return - The memory budget of TemporaryTables
+	*/
+	static int64 GetTemporaryTableMemoryBudget();
+
+	/** Return the estimated size of a row of a temporary table, used to estimate the size of the tables against GetTemporaryTableMemoryBudget.
+	* This is a heuristic sized for the id tables most filters produce, wider tables are underestimated
+	*/
+	static int64 GetTemporaryTableBytesPerRow();
+
 	/** PointCloud calls Optimize periodically to optimize temporary table usage. This method returns how many tables need to be created for
 	* an optimize run to occur. Well optimized tables are quicker, but optimizing is costly.
 	*/
@@ -434,12 +548,18 @@ private:
 	*/
 	FString SanitizeAndEscapeString(const FString& InString) const;
 
+	/** Calculate the whole DB Hash if it is invalid, from the hashes of the vertex blocks and the objects */
+	void CalculateWholeDbHash() const;
+
+	/** Hash the vertex blocks that are dirty, and any block added since the last call */
+	void UpdateVertexBlockHashes() const;
+
 	/**
-	* Calculate the whole DB Hash
-	* @param Data - A pointer to the serialized data for the this asset
-	* @param Size - The size in bytes of the buffer pointer to by Data
+	* Mark the vertex blocks holding the given rows as needing to be hashed again
+	* @param FirstRowId - The first Vertex rowid that changed
+	* @param LastRowId - The last Vertex rowid that changed
 	*/
-	void CalculateWholeDbHash(void* Data = nullptr, uint64 Size = 0) const;
+	void MarkVertexBlocksDirty(int64 FirstRowId, int64 LastRowId);
 
 private:
 
@@ -479,6 +599,27 @@ private:
 	*/
 	FString GetTemporaryIntersectionTable(EArgumentType ArgumentAType, const FString& ArgumentA, EArgumentType ArgumentBType, const FString& ArgumentB);
 
+	/**
+	* Make a temporary table holding the results of a query plan, which are ordered by Id
+	* @param Plan - The plan to run
+	* @return The name of the temporary table on success, or an empty string otherwise
+	*/
+	FString GetTemporaryQueryPlanTable(const FPointCloudQueryPlan& Plan);
+
+	/**
+	* Return the temporary table holding the results of a query plan if it has already been made, without running any query
+	* @param Plan - The plan to look up
+	* @return The name of the temporary table, or an empty string if the results of the plan are not cached
+	*/
+	FString FindQueryPlanTable(const FPointCloudQueryPlan& Plan);
+
+	/**
+	* Record the temporary table holding the results of a query plan, so that later views with the same plan reuse it
+	* @param Plan - The plan the results are from
+	* @param TableName - The temporary table holding the results, this must be a table made by GetTemporaryQueryTable or GetTemporaryIdTable
+	*/
+	void AddQueryPlanTable(const FPointCloudQueryPlan& Plan, const FString& TableName);
+
 	/**
 	* Query if a temporary lookup table exists for a given Metadata key
 	* @param MetadataKey - The Metadata Key to query
@@ -489,8 +630,44 @@ private:
 	/** Once a temporary table is created this method adds it to the LRU and performs any cache management that is needed
 	* @param Key - The key associated with the temporary table
 	* @param Value - The name of the temporary table
+	* @param BuildSeconds - How long the table took to make, tables that are quick to remake are evicted first
+	* @param NumRows - The number of rows in the table, used to estimate its size
 	*/
-	void AddTemporaryTable(const FString& Key, const FString& Name);
+	void AddTemporaryTable(const FString& Key, const FString& Name, double BuildSeconds, int64 NumRows);
+
+	/** Create a temporary table holding the results of a query
+	* @param Name - The name of the temporary table
+	* @param Query - The query whose results fill the table
+	* @return The number of rows inserted in the table, as reported by the insert, or INDEX_NONE if the table could not be created
+	*/
+	int64 CreateTemporaryTableAs(const FString& Name, const FString& Query);
+
+	/** Create an index on the Id column of a temporary table, once it has been used often enough for the index to pay off */
+	void CreateTemporaryTableIndex(const FString& Key, const FString& Name);
+
+	/**
+	* Make a temporary table holding a given list of ids, with the same layout as the tables made by GetTemporaryQueryTable
+	* @param Key - A key uniquely identifying the contents of the table
+	* @param Ids - The ids to store in the table
+	* @return The name of the temporary table on success, or an empty string otherwise
+	*/
+	FString GetTemporaryIdTable(const FString& Key, const TArray<int32>& Ids);
+
+	/**
+	* Return the in-memory spatial index over the points in this point cloud, building it if required
+	* @return The spatial index, or null if the point cloud is not initialized
+	*/
+	TSharedPtr<const FPointCloudSpatialIndex> GetSpatialIndex() const;
+
+	/** Discard the in-memory spatial index so that it is rebuilt the next time it is needed. This must be done whenever the points change */
+	void InvalidateSpatialIndex() const;
+
+	/**
+	* Return the in-memory index over the values of a metadata key, building it if required. The points are in the order of the current spatial index
+	* @param MetadataKey - The name of the metadata key
+	* @return The attribute index, or null if the point cloud is not initialized or has no such key
+	*/
+	TSharedPtr<const FPointCloudAttributeIndex> GetAttributeIndex(const FString& MetadataKey) const;
 
 private: // Data Section
 
@@ -503,6 +680,19 @@ private: // Data Section
 	// This holds the SHA256 hash of the entire database		
 	mutable FSHA1 WholeDbHash;
 
+	// Hash of each block of vertices and their metadata, which WholeDbHash is built from. Blocks are ranges of Vertex rowids, so loads only
+	// add or touch the last blocks
+	mutable TArray<FSHAHash> VertexBlockHashes;
+
+	// Blocks whose hash needs to be recalculated
+	mutable TBitArray<> DirtyVertexBlocks;
+
+	// False when the block hashes don't match the database, for instance after it was deserialized, in which case they are all recalculated
+	mutable bool bVertexBlockHashesValid = false;
+
+	// Guards the hash and block hashes, which are calculated on demand
+	mutable FCriticalSection HashLock;
+
 	// A handle to the log file to which SQL queries should be written
 	mutable IFileHandle* LogFile;
 
@@ -521,6 +711,23 @@ private: // Data Section
 
 	/** Thread-safe cache for temporary table names in the DB */
 	FPointCloudTemporaryTablesCache TemporaryTables;
+
+	/** Temporary tables holding the results of view filters, keyed on the hash of their query plan */
+	FPointCloudQueryPlanCache QueryPlanTables;
+
+	/** Prepared statements reused by GetValues */
+	mutable FPointCloudStatementCache PreparedStatements;
+
+	/** Optional stats object that bulk loads report their timings and counts to */
+	FPointCloudStatsPtr Stats;
+
+	/** In-memory spatial index used to evaluate spatial view filters without going through SQL, built on demand */
+	mutable TSharedPtr<const FPointCloudSpatialIndex> SpatialIndex;
+	mutable FCriticalSection SpatialIndexLock;
+
+	/** In-memory indices over the values of metadata keys, built on demand and discarded along with the spatial index they are ordered by */
+	mutable TMap<FString, TSharedPtr<const FPointCloudAttributeIndex>> AttributeIndices;
+	mutable FCriticalSection AttributeIndicesLock;
 };
 
 // Template implementations
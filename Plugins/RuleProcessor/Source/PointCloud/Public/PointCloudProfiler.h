@@ -0,0 +1,120 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FPointCloudRuleInstance;
+struct FPointCloudStats;
+
+/** Interned name of a profiled scope or counter. Ids are assigned once per name and are valid for the lifetime of the process */
+using FPointCloudStatId = int32;
+
+/**
+* Low overhead instrumentation of rule execution and of the point cloud.
+*
+* Scopes and counters are identified by interned ids instead of strings, and each thread records them in its own fixed size ring buffer,
+* so recording takes no lock and allocates nothing once a thread has seen a scope. Every scope is recorded against its path in a scope
+* tree, rooted at the chain of rule instances that is executing, so queries and temporary tables are attributed to the rule that caused them
+* whichever thread the rule runs on. When disabled, which is the default, a scope costs a single test of a global flag.
+*
+* Recordings are exported as Chrome trace JSON, which can be opened in chrome://tracing or Perfetto, and as a CSV summary with one line
+* per path. Exports read the buffers of every thread and are meant to be made once the profiled work has finished.
+*/
+class POINTCLOUD_API FPointCloudProfiler
+{
+public:
+
+	/** Return true if scopes and counters are currently recorded, see t.RuleProcessor.Profile */
+	static bool IsEnabled() { return bEnabled; }
+
+	/** Enable or disable recording. Scopes that are open when recording is disabled are still recorded when they close */
+	static void SetEnabled(bool bInEnabled);
+
+	/** Return the id of a name, interning it the first time it is seen */
+	static FPointCloudStatId GetStatId(const FString& Name);
+
+	/** Return the name of an interned id */
+	static FString GetStatName(FPointCloudStatId StatId);
+
+	/** Add a value to a counter, in the scope that is open on the calling thread */
+	static void AddToCounter(FPointCloudStatId StatId, int64 Value);
+
+	/** Discard everything recorded so far. Must not be called while other threads are recording */
+	static void Reset();
+
+	/** Return the number of events that were overwritten because a thread recorded more than its ring buffer holds since the last reset */
+	static int64 GetNumDroppedEvents();
+
+	/** Return the recorded events in the Chrome trace event format */
+	static FString ExportChromeTrace();
+
+	/**
+	* Return a summary of the recorded events with one line per scope path, sorted on the path
+	* Columns are Path, Calls, InclusiveSeconds, ExclusiveSeconds, MaxSeconds and Count, the sum of the counters recorded under that path
+	*/
+	static FString ExportSummaryCsv();
+
+	/** Add the inclusive time and call count of every scope path to the given stats, as "Profile <Path>" timers and counters */
+	static void AddToStats(FPointCloudStats& Stats);
+
+	/**
+	* Save the Chrome trace and the CSV summary next to each other
+	* @param BaseFilename - The path of the files to write, without extension
+	* @return True if both files were written
+	*/
+	static bool SaveReports(const FString& BaseFilename);
+
+private:
+
+	friend class FPointCloudProfileScope;
+
+	static bool bEnabled;
+};
+
+/** Records the time spent between its construction and destruction as a scope of the thread's current path */
+class POINTCLOUD_API FPointCloudProfileScope
+{
+public:
+
+	/** Open a scope nested in the scope that is open on the calling thread */
+	explicit FPointCloudProfileScope(FPointCloudStatId StatId)
+	{
+		if (FPointCloudProfiler::IsEnabled())
+		{
+			Begin(StatId, nullptr);
+		}
+	}
+
+	/** Open a scope nested in the path of a rule instance and its parents, for the given execution phase of that instance */
+	FPointCloudProfileScope(FPointCloudStatId PhaseStatId, const FPointCloudRuleInstance* RuleInstance)
+	{
+		if (FPointCloudProfiler::IsEnabled())
+		{
+			Begin(PhaseStatId, RuleInstance);
+		}
+	}
+
+	~FPointCloudProfileScope()
+	{
+		if (bActive)
+		{
+			End();
+		}
+	}
+
+	UE_NONCOPYABLE(FPointCloudProfileScope);
+
+private:
+
+	void Begin(FPointCloudStatId StatId, const FPointCloudRuleInstance* RuleInstance);
+	void End();
+
+	uint64 BeginCycles = 0;
+	bool bActive = false;
+};
+
+/** Profile the rest of the enclosing block under the given literal name */
+#define POINTCLOUD_PROFILE_SCOPE(Name) \
+	static const FPointCloudStatId PREPROCESSOR_JOIN(PointCloudProfileStatId, __LINE__) = FPointCloudProfiler::GetStatId(TEXT(Name)); \
+	FPointCloudProfileScope PREPROCESSOR_JOIN(PointCloudProfileScope, __LINE__)(PREPROCESSOR_JOIN(PointCloudProfileStatId, __LINE__))
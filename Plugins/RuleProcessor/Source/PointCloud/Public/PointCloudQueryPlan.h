@@ -0,0 +1,120 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Containers/LruCache.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeRWLock.h"
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+/**
+* Normalized form of the filter statements applied to a view. Each filter statement selects a set of ids and the results of the view are the 
+* intersection of those sets, so statements can be deduplicated and run in any order. Statements are ordered so that the most selective ones 
+* are run first, which keeps the intermediate intersection tables small, and views whose filters only differ by order share the same plan
+*/
+struct POINTCLOUD_API FPointCloudQueryPlan
+{
+	/**
+	* Compile a list of filter statements into a plan
+	* @param FilterStatements - The statements, in the order they were applied to the view
+	* @return The normalized plan
+	*/
+	static FPointCloudQueryPlan Compile(const TArray<FString>& FilterStatements);
+
+	/**
+	* Estimate how selective a filter statement is from the statements made by UPointCloudView
+	* @param FilterStatement - The statement to rank
+	* @return The rank of the statement, statements with lower ranks are expected to return fewer points
+	*/
+	static int32 GetSelectivityRank(const FString& FilterStatement);
+
+	/** The normalized statements, in the order they should be run */
+	TArray<FString> Statements;
+
+	/** Text uniquely identifying the plan */
+	FString Key;
+
+	/** Hash of Key, used to look the plan up in FPointCloudQueryPlanCache */
+	uint64 Hash = 0;
+};
+
+/**
+* Cache of the temporary tables holding the results of query plans. Every query on a filtered view looks its plan up, so the cache is split
+* in shards with their own read/write lock rather than going through a single lock. The tables themselves are owned by the temporary tables LRU
+* of the point cloud, which removes them from here when it drops them
+*/
+class POINTCLOUD_API FPointCloudQueryPlanCache
+{
+public:
+
+	/** Return the table holding the results of the given plan, or an empty string if the plan is not cached */
+	FString Find(uint64 PlanHash) const;
+
+	/** Record the table holding the results of the given plan */
+	void Add(uint64 PlanHash, const FString& TableName);
+
+	/**
+	* Forget the plans whose results are held in the given table. This is done when the table is dropped
+	* @return The number of plans removed
+	*/
+	int32 RemoveTable(const FString& TableName);
+
+	/** Forget all plans */
+	void Reset();
+
+	/** Return the number of cached plans */
+	int32 Num() const;
+
+private:
+
+	struct FShard
+	{
+		TMap<uint64, FString> Tables;
+		mutable FRWLock Lock;
+	};
+
+	static constexpr int32 NumShards = 16;
+
+	FShard& GetShard(uint64 PlanHash) { return Shards[PlanHash % NumShards]; }
+	const FShard& GetShard(uint64 PlanHash) const { return Shards[PlanHash % NumShards]; }
+
+	FShard Shards[NumShards];
+};
+
+/**
+* Prepared statements of the queries run through UPointCloudImpl::GetValues, keyed on the query text so that repeated queries skip parsing and 
+* planning. A statement is taken out of the cache while it is being stepped so that it is never shared between threads, and is reset and put 
+* back once done. The least recently used statements are finalized once the cache is full
+*/
+class POINTCLOUD_API FPointCloudStatementCache
+{
+public:
+
+	FPointCloudStatementCache();
+	~FPointCloudStatementCache();
+
+	/**
+	* Return a statement ready to be stepped for the given query, preparing it if it is not cached
+	* @param Database - The database to prepare the statement on
+	* @param Query - The query to prepare
+	* @param OutError - The sqlite error code if the statement could not be prepared
+	* @return The statement, or null on failure
+	*/
+	sqlite3_stmt* Acquire(sqlite3* Database, const FString& Query, int32& OutError);
+
+	/** Return a statement acquired for the given query to the cache */
+	void Release(const FString& Query, sqlite3_stmt* Statement);
+
+	/** Finalize all cached statements. This must be done before the database they were prepared on is closed */
+	void Reset();
+
+private:
+
+	TLruCache<FString, sqlite3_stmt*> Statements;
+
+	int32 MaxStatements;
+
+	FCriticalSection Lock;
+};
@@ -11,6 +11,8 @@ class FPointCloudRuleInstance;
 using FPointCloudRuleInstancePtr = TSharedPtr<FPointCloudRuleInstance>;
 class FSliceAndDiceContext;
 class USliceAndDiceMapping;
+class UPointCloudView;
+struct FScopedSlowTask;
 
 class FSliceAndDiceExecutionContext;
 using FSliceAndDiceExecutionContextPtr = TSharedPtr<FSliceAndDiceExecutionContext>;
@@ -18,6 +20,21 @@ using FSliceAndDiceExecutionContextPtr = TSharedPtr<FSliceAndDiceExecutionContex
 namespace SliceAndDiceExecution
 {
 	void POINTCLOUD_API SingleThreadedRuleInstanceExecute(FPointCloudRuleInstancePtr InRule, FSliceAndDiceExecutionContextPtr Context);
+
+	/**
+	* Executes rule instances once for each point of a view.
+	* The ids and transforms of the points are fetched in a single query, and each point gets a single point view
+	* (see UPointCloudView::MakePointView) that answers the common queries from memory, along with its own duplicate
+	* of the instances. Points are executed in batches on the rule set scheduler, so instances that can be executed
+	* on any thread are run by workers.
+	* @param InInstances - The instances to execute for each point, usually the children of an iterator
+	* @param InView - The view providing the points
+	* @param Context - The execution context
+	* @param InMakePointInstance - Returns the parent of the duplicates for the point with the given id, usually a FPointCloudPointRuleInstance
+	* @param bAllowWorkerThreads - If false, every instance is executed on the game thread
+	* @param SlowTask - Optional, advanced by one unit of work per point and instance
+	*/
+	void POINTCLOUD_API PerPointRuleInstanceExecute(const TArray<FPointCloudRuleInstancePtr>& InInstances, UPointCloudView* InView, FSliceAndDiceExecutionContextPtr Context, TFunctionRef<FPointCloudRuleInstancePtr(int32 PointId)> InMakePointInstance, bool bAllowWorkerThreads, FScopedSlowTask* SlowTask = nullptr);
 }
 
 class POINTCLOUD_API FSliceAndDiceExecutionContext
@@ -135,6 +135,9 @@ public:
 	FPointCloudRuleInstancePtr Parent;
 	TArray<FPointCloudRuleInstancePtr> Children;
 
+	/** Path of this instance in the profiler's scope tree in the low 32 bits, and the path of the parent it was made under in the high 32 bits, see FPointCloudProfiler */
+	mutable std::atomic<uint64> ProfilePath{ MAX_uint64 };
+
 	/** Multithreading convenience methods to trigger post-execution */
 	void ResetExecutingChildCount()
 	{
@@ -280,3 +283,36 @@ protected:
 
 	DataType Data;
 };
+
+/**
+* Stands in for a rule instance while its children are executed for a single point, see SliceAndDiceExecution::PerPointRuleInstanceExecute.
+* It has its own copy of the rule data, so per point values such as the name value don't touch the data shared by every point,
+* and returns the hash of the instance it stands in for so the children map their actors exactly as if they were its children.
+*/
+template<class DataType>
+class FPointCloudPointRuleInstance : public FPointCloudRuleInstanceWithData<FPointCloudPointRuleInstance<DataType>, DataType>
+{
+public:
+	/**
+	* @param InRule - The rule of the instance this stands in for
+	* @param InData - The data of the instance this stands in for
+	* @param InParent - The parent of the instance this stands in for, overrides are applied from it as usual
+	* @param InHash - The hash of the instance this stands in for
+	*/
+	FPointCloudPointRuleInstance(const UPointCloudRule* InRule, const DataType& InData, FPointCloudRuleInstancePtr InParent, const FString& InHash)
+		: FPointCloudRuleInstanceWithData<FPointCloudPointRuleInstance<DataType>, DataType>(InRule, InData), Hash(InHash)
+	{
+		this->SetParent(InParent);
+	}
+
+	DataType& GetData() { return this->Data; }
+
+	/** Never executed by itself, its view is set by the per point execution and its data by the instance it stands in for */
+	virtual bool PreExecute(FSliceAndDiceExecutionContextPtr Context) override { return true; }
+	virtual bool PostExecute(FSliceAndDiceExecutionContextPtr Context) override { return true; }
+
+	virtual FString GetHash() override { return Hash; }
+
+private:
+	FString Hash;
+};
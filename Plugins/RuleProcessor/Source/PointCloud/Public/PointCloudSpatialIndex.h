@@ -0,0 +1,176 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/BitArray.h"
+
+/**
+* A spatial predicate that can be evaluated directly against the positions held in an FPointCloudSpatialIndex.
+* These mirror the SQL filters generated by UPointCloudView so that either path returns the same points.
+*/
+struct POINTCLOUD_API FPointCloudSpatialFilter
+{
+	enum class EType : uint8
+	{
+		None,			// Not a spatial filter, this can only be evaluated in SQL
+		Box,			// Points inside an axis aligned box
+		Sphere,			// Points strictly inside a sphere
+		OrientedBox,	// Points inside a unit box transformed by a given transform
+	};
+
+	/** Result of testing a bounding box against the filter */
+	enum class EOverlap : uint8
+	{
+		Outside,		// No point in the bounding box can pass the filter
+		Inside,			// Every point in the bounding box passes the filter
+		Partial			// Points in the bounding box have to be tested individually
+	};
+
+	FPointCloudSpatialFilter() = default;
+
+	/** Make a filter that accepts points inside, or outside if bInvert is set, of an axis aligned box */
+	static FPointCloudSpatialFilter MakeBox(const FBox& Box, bool bInvert);
+
+	/** Make a filter that accepts points strictly inside a sphere */
+	static FPointCloudSpatialFilter MakeSphere(const FVector& Center, double Radius);
+
+	/** Make a filter that accepts points inside, or outside if bInvert is set, of the unit box transformed by the given transform */
+	static FPointCloudSpatialFilter MakeOrientedBox(const FTransform& Transform, bool bInvert);
+
+	/** Return true if this filter can be evaluated natively */
+	bool IsSpatial() const { return Type != EType::None; }
+
+	/** Test a single point against the filter */
+	bool Contains(const FVector3f& Point) const;
+
+	/**
+	* Test a block of points held as separate X, Y and Z columns against the filter. Points are tested four at a time with SIMD
+	* and give the same result as Contains
+	* @param X, Y, Z - The coordinates of the points
+	* @param Num - The number of points, at most 64
+	* @return A mask with bit N set if point N passes the filter
+	*/
+	uint64 ContainsBlock(const float* X, const float* Y, const float* Z, int32 Num) const;
+
+	/** Classify a bounding box against the filter */
+	EOverlap Classify(const FBox3f& Bounds) const;
+
+private:
+
+	/** Classify a bounding box against the filter, ignoring bInvert */
+	EOverlap ClassifyNonInverted(const FBox3f& Bounds) const;
+
+	/** Test a single point against the filter, ignoring bInvert */
+	bool ContainsNonInverted(const FVector3f& Point) const;
+
+public:
+
+	EType Type = EType::None;
+	bool bInvert = false;
+
+	// Box
+	FBox Box = FBox(EForceInit::ForceInit);
+
+	// Sphere
+	FVector Center = FVector::ZeroVector;
+	double RadiusSquared = 0.0;
+
+	// Oriented box, world to local transform of the box
+	FMatrix WorldToLocal = FMatrix::Identity;
+};
+
+/**
+* In-memory bounding volume hierarchy over the positions of the points in a point cloud.
+*
+* Points are sorted along a Morton curve and the hierarchy is built over contiguous ranges of the sorted points,
+* so every node covers a contiguous range of point indices. Results are expressed as bit arrays indexed by the
+* position of a point in that order, which makes intersecting the results of several filters a bitwise AND.
+*/
+class POINTCLOUD_API FPointCloudSpatialIndex
+{
+public:
+
+	/** Maximum number of points in a leaf. This is a multiple of the bit array word size so that disjoint leaves never share a word */
+	static constexpr int32 LeafSize = 64;
+
+	/**
+	* Build the index
+	* @param InRowIds - The Vertex rowid of each point
+	* @param InPositions - The position of each point, one entry per rowid
+	*/
+	FPointCloudSpatialIndex(const TArray<int32>& InRowIds, const TArray<FVector3f>& InPositions);
+
+	/** Return the number of points in the index */
+	int32 Num() const { return RowIds.Num(); }
+
+	/** Return a bit array with a set bit for each point in the index */
+	TBitArray<> MakeFullSet() const { return TBitArray<>(true, Num()); }
+
+	/**
+	* Clear the bits of the points that do not pass the given filter
+	* @param Filter - A spatial filter
+	* @param InOutBits - The current result set, as returned from MakeFullSet or a previous call to Intersect
+	*/
+	void Intersect(const FPointCloudSpatialFilter& Filter, TBitArray<>& InOutBits) const;
+
+	/**
+	* Clear the bits of the points that are not in the given list of rowids
+	* @param InRowIds - The rowids to keep
+	* @param InOutBits - The current result set
+	*/
+	void IntersectRowIds(const TArray<int32>& InRowIds, TBitArray<>& InOutBits) const;
+
+	/** Return the rowids of the points in the given result set, in ascending order */
+	TArray<int32> GetRowIds(const TBitArray<>& Bits) const;
+
+	/** Return the bounding box of the points in the given result set */
+	FBox GetBounds(const TBitArray<>& Bits) const;
+
+	/** Return the number of points in the given result set that are strictly inside the given box */
+	int32 CountInBox(const TBitArray<>& Bits, const FBox& Box) const;
+
+	/** Return the position of a point in the index */
+	FVector3f GetPosition(int32 Index) const { return FVector3f(PositionsX[Index], PositionsY[Index], PositionsZ[Index]); }
+
+	/** Return the rowid of a point in the index */
+	int32 GetRowId(int32 Index) const { return RowIds[Index]; }
+
+	/** Return the index of the point with the given rowid, or INDEX_NONE if it is not in the index */
+	int32 GetIndexFromRowId(int32 RowId) const { return IndexFromRowId.IsValidIndex(RowId) ? IndexFromRowId[RowId] : INDEX_NONE; }
+
+private:
+
+	struct FNode
+	{
+		FBox3f Bounds;
+
+		// Range of points [Begin, End) covered by this node
+		int32 Begin;
+		int32 End;
+
+		// Children, INDEX_NONE for leaves
+		int32 Left;
+		int32 Right;
+	};
+
+	/** Build the subtree covering [Begin, End) and return the index of its root */
+	int32 BuildNode(int32 Begin, int32 End);
+
+	/** Recursively clear bits of points in the subtree that do not pass the filter */
+	void IntersectNode(int32 NodeIndex, const FPointCloudSpatialFilter& Filter, TBitArray<>& InOutBits) const;
+
+private:
+
+	// Point data in Morton order, positions are held as separate columns so leaves can be tested a block at a time
+	TArray<float> PositionsX;
+	TArray<float> PositionsY;
+	TArray<float> PositionsZ;
+	TArray<int32> RowIds;
+
+	// Map from rowid to the index of the point, INDEX_NONE for rowids not in the index
+	TArray<int32> IndexFromRowId;
+
+	// Hierarchy nodes, the root is the first node
+	TArray<FNode> Nodes;
+};
@@ -10,6 +10,7 @@ struct sqlite3_stmt;
 namespace PointCloudSqliteHelpers
 {
 	void ResultRetrieval(sqlite3_stmt* stmt, int NumElements, int* ColumnIndices, int& ReadColumns, int& Value);
+	void ResultRetrieval(sqlite3_stmt* stmt, int NumElements, int* ColumnIndices, int& ReadColumns, int64& Value);
 	void ResultRetrieval(sqlite3_stmt* stmt, int NumElements, int* ColumnIndices, int& ReadColumns, float& Value);
 	void ResultRetrieval(sqlite3_stmt* stmt, int NumElements, int* ColumnIndices, int& ReadColumns, double& Value);
 	void ResultRetrieval(sqlite3_stmt* stmt, int NumElements, int* ColumnIndices, int& ReadColumns, FString& Value);
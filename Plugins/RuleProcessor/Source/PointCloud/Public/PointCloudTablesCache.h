@@ -4,44 +4,150 @@
 
 #include "Internationalization/Text.h"
 #include "HAL/CriticalSection.h"
-#include "Containers/LruCache.h"
+#include "Templates/UniquePtr.h"
 #include "PointCloudConfig.h"
 
-/** Convenience class to hide multithreading safety */
-class FPointCloudTemporaryTablesCache
+#include <atomic>
+
+/**
+* Convenience class to hide multithreading safety
+*
+* Tables are spread over shards by key, each shard having its own lock, so that threads looking up different tables don't wait on each other.
+* Each shard holds its share of the table count and memory budget. Once over either, the shard evicts tables using GreedyDual-Size-Frequency:
+* tables that are small, were slow to make and are used often are kept longest. Tables with no size or cost information are evicted least
+* recently used first
+*/
+class POINTCLOUD_API FPointCloudTemporaryTablesCache
 {
 public:
+	/** Counters describing how the cache was used */
+	struct FCacheStats
+	{
+		int64 Hits = 0;
+		int64 Misses = 0;
+		int64 Evictions = 0;
+
+		/** The number of times a thread found a shard locked and had to wait for it, and the total time spent waiting */
+		int64 ContendedLocks = 0;
+		double LockWaitSeconds = 0.0;
+
+		/** The number of cached tables and their estimated size */
+		int32 NumTables = 0;
+		int64 SizeBytes = 0;
+	};
+
+	/** Outcome of TryTouch */
+	enum class ETouchResult : uint8
+	{
+		/** The table is cached and was marked as recently used */
+		Touched,
+
+		/** The table is not cached */
+		NotCached,
+
+		/** The lock was busy, so whether the table is cached is unknown */
+		Busy
+	};
+
 	FPointCloudTemporaryTablesCache();
 
+	/**
+	* @param InCacheSize - The number of tables to keep around
+	* @param InMemoryBudget - The estimated size in bytes of the tables to keep around
+	* @param InNumShards - The number of shards to split the tables over
+	*/
+	FPointCloudTemporaryTablesCache(int32 InCacheSize, int64 InMemoryBudget, int32 InNumShards = DefaultNumShards);
+
 	bool Contains(const FString& InKey) const;
 	FString GetFromCache(const FString& InKey, int32* OutCacheHits = nullptr);
-	FString AddToCache(const FString& InKey, const FString& InName);
-	FString RemoveLeastRecentNotThreadSafe();
+
+	/**
+	* Mark a table as recently used without waiting on the cache lock. If the lock is busy nothing is touched, callers that need to know the
+	* table is still cached should fall back to GetFromCache
+	* @param InKey - The key of the table
+	* @param OutCacheHits - Set to the number of times the table was used, or 0 if it was not touched
+	* @return Whether the table was touched, is not cached, or the lock was busy
+	*/
+	ETouchResult TryTouch(const FString& InKey, int32* OutCacheHits = nullptr);
+
+	/**
+	* Add a table to the cache
+	* @param InKey - The key of the table
+	* @param InName - The name of the table
+	* @param InSizeBytes - Estimated size of the table
+	* @param InBuildSeconds - How long the table took to make
+	* @return The names of the tables evicted to make room for this one, which should be dropped
+	*/
+	TArray<FString> AddToCache(const FString& InKey, const FString& InName, int64 InSizeBytes = 0, double InBuildSeconds = 0.0);
+
+	/** Remove all tables from the cache and return their names */
+	TArray<FString> RemoveAll();
+
+	/** Return the counters of this cache */
+	FCacheStats GetStats() const;
 
 #if defined RULEPROCESSOR_ENABLE_LOGGING
-	const TMap<FString, int32>& GetCacheMisses() const { return CacheMisses; }
+	TMap<FString, int32> GetCacheMisses() const;
 #endif
 
+	static constexpr int32 DefaultNumShards = 16;
+
 private:
-	//  Least Recently used cache containing the names of temporary tables created by GetTemporaryAttributeTable or GetTemporaryQueryTable
-	// The size of this cache is controlled by GetTemporaryTableCacheSize, once this number of tables has been created, the least recently used will be 
-	// evicted from memory
-	TLruCache<FString, FString> TemporaryTables;
 
-	// A lock to protect access to this struct's members
-	mutable FCriticalSection CacheLock;
+	struct FEntry
+	{
+		FString Name;
+		int64 SizeBytes = 0;
+		double BuildSeconds = 0.0;
 
-#if defined RULEPROCESSOR_ENABLE_LOGGING
+		// Number of times the table was used since it was added
+		int32 Hits = 1;
+
+		// Eviction priority, lowest is evicted first
+		double Priority = 0.0;
+
+		// Value of UseCount when the table was last used, breaks ties in priority
+		uint64 LastUsed = 0;
+	};
+
+	struct FShard
+	{
+		TMap<FString, FEntry> Entries;
+		int64 SizeBytes = 0;
+
+		// Priority of the last evicted entry, which new and used entries start from so that entries that are not used age out
+		double Inflation = 0.0;
 
-	// Map between Queries and cache miss counts
-	TMap<FString, int32> CacheMisses;
+		int64 Hits = 0;
+		int64 Misses = 0;
+		int64 Evictions = 0;
 
+#if defined RULEPROCESSOR_ENABLE_LOGGING
+		// Map between Queries and cache miss counts
+		TMap<FString, int32> CacheMisses;
 #endif
 
-	// Map between Queries and cache miss counts
-	TMap<FString, int32> CacheHits;
+		// A lock to protect access to this shard's members
+		mutable FCriticalSection Lock;
+	};
+
+	/** Return the shard holding the given key, locked */
+	FShard& LockShard(const FString& InKey) const;
+	void LockShard(const FShard& Shard) const;
+
+	/** Update the priority of an entry after it was added or used */
+	void TouchEntry(FShard& Shard, FEntry& Entry) const;
+
+	TUniquePtr<FShard[]> Shards;
+	int32 NumShards;
+
+	// Each shard holds its share of the total size and budget
+	int32 ShardCacheSize;
+	int64 ShardMemoryBudget;
 
-	int32 CacheSize;
+	// Incremented every time a table is used, to order uses across shards
+	mutable std::atomic<uint64> UseCount;
 
-	int32 EjectedTablesCount;
+	mutable std::atomic<int64> ContendedLocks;
+	mutable std::atomic<uint64> LockWaitCycles;
 };
\ No newline at end of file
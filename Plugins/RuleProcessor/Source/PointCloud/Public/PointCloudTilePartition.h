@@ -0,0 +1,78 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/BitArray.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class FPointCloudSpatialIndex;
+class UPointCloudView;
+struct FPointCloudSpatialFilter;
+
+/**
+* The points of a view bucketed into a regular grid of tiles in a single pass.
+*
+* Each point is tested against the filters of the tiles it can belong to, which are the same filters UPointCloudView::FilterOnTile adds, so a
+* point on the face between two tiles is in both, exactly as if each tile had been filtered on its own. Points are bucketed with a parallel
+* counting sort that keeps the Morton order of the spatial index within each tile. Made by UPointCloudView::MakeTilePartition, and bound
+* to the views of the tiles with UPointCloudView::FilterOnTile.
+*/
+class POINTCLOUD_API FPointCloudTilePartition
+{
+public:
+
+	/**
+	* Build the partition
+	* @param InSpatialIndex - The spatial index the points are taken from
+	* @param Bits - The points to partition, indexed in the order of the spatial index
+	* @param InGridBounds - The bounds of the grid of tiles
+	* @param InNumTiles - The number of tiles along each axis
+	* @param MakeTileFilter - Return the filter of a tile
+	*/
+	FPointCloudTilePartition(const TSharedPtr<const FPointCloudSpatialIndex>& InSpatialIndex, const TBitArray<>& Bits, const FBox& InGridBounds, const FIntVector& InNumTiles, TFunctionRef<FPointCloudSpatialFilter(const FIntVector& Tile)> MakeTileFilter);
+
+	/** Return the spatial index the points are indexed in */
+	const TSharedPtr<const FPointCloudSpatialIndex>& GetSpatialIndex() const { return SpatialIndex; }
+
+	/** Return the bounds of the grid of tiles */
+	const FBox& GetGridBounds() const { return GridBounds; }
+
+	/** Return the number of tiles along each axis */
+	const FIntVector& GetNumTilesPerAxis() const { return NumTiles; }
+
+	/** Return the total number of tiles */
+	int32 GetNumTiles() const { return TileStarts.Num() - 1; }
+
+	/** Return the index of a tile, tiles are ordered on X, then Y, then Z */
+	int32 GetTileIndex(const FIntVector& Tile) const { return (Tile.X * NumTiles.Y + Tile.Y) * NumTiles.Z + Tile.Z; }
+
+	/** Return the number of points in a tile */
+	int32 Num(int32 TileIndex) const { return TileStarts[TileIndex + 1] - TileStarts[TileIndex]; }
+
+	/** Return the points of a tile, as indices in the spatial index in ascending order */
+	TConstArrayView<int32> GetPoints(int32 TileIndex) const { return TConstArrayView<int32>(Points.GetData() + TileStarts[TileIndex], Num(TileIndex)); }
+
+	/** Return the points of a tile as a bit array indexed in the order of the spatial index */
+	TBitArray<> MakeBits(int32 TileIndex) const;
+
+	/** Return true if the partition was made from the results of the given view, and so can be bound to its tiles */
+	bool IsSource(const UPointCloudView* ParentView, const UObject* PointCloud) const;
+
+private:
+
+	friend class UPointCloudView;
+
+	TSharedPtr<const FPointCloudSpatialIndex> SpatialIndex;
+	FBox GridBounds;
+	FIntVector NumTiles;
+
+	// Points of tile N are Points[TileStarts[N], TileStarts[N + 1])
+	TArray<int32> TileStarts;
+	TArray<int32> Points;
+
+	// The parent and the point cloud of the view the partition was made from
+	TWeakObjectPtr<const UPointCloudView> SourceParentView;
+	TWeakObjectPtr<const UObject> SourcePointCloud;
+	bool bHasSourceParentView = false;
+};
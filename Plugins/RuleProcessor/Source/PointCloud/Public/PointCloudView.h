@@ -5,9 +5,47 @@
 #include "UObject/Object.h"
 #include "UObject/ObjectMacros.h"
 #include "PointCloud.h"
+#include "PointCloudAttributeIndex.h"
+#include "PointCloudSpatialIndex.h"
 #include "PointCloudView.generated.h"
 
 class UPointCloudImpl;
+class UPointCloudView;
+class FPointCloudTilePartition;
+
+/**
+ * The ids and transforms of the points of a view, fetched in a single query so that the single point views made from
+ * them with UPointCloudView::MakePointView can answer the common queries without running SQL. Metadata values are
+ * fetched from the source view, one key at a time, the first time a point view asks for them.
+ */
+class POINTCLOUD_API FPointCloudViewPoints
+{
+public:
+	explicit FPointCloudViewPoints(const UPointCloudView* InSourceView);
+
+	int32 Num() const { return Points.Num(); }
+	int32 GetId(int32 PointIndex) const { return Points[PointIndex].Key; }
+	const FTransform& GetTransform(int32 PointIndex) const { return Points[PointIndex].Value; }
+
+	/**
+	* Return the value of a metadata key for a point. Safe to call from any thread
+	* @return True if the point has a value for this key
+	* @param PointIndex - The index of the point in this set
+	* @param Key - The name of the Metadata Item to Query
+	* @param OutValue - The value of the metadata item
+	*/
+	bool GetMetadataValue(int32 PointIndex, const FString& Key, FString& OutValue) const;
+
+private:
+	TWeakObjectPtr<const UPointCloudView> SourceView;
+
+	/** Id and transform of each point, in the order the source view returns them */
+	TArray<TPair<int32, FTransform>> Points;
+
+	/** Metadata key -> values of the points that have that key, filled on demand */
+	mutable TMap<FString, TSharedPtr<const TMap<int, FString>>> MetadataValues;
+	mutable FCriticalSection MetadataValuesLock;
+};
 
 /**
  * Data within a PointCloud cannot be accessed directly. It must be accessed via a PointCloudView. A view encapsualtes the concept of reading from and modifying data in a PointCloud. 
@@ -46,6 +84,16 @@ public:
 	*/
 	void RemoveChildView(UPointCloudView* ChildView);
 
+	/**
+	* Creates a child view holding a single point of this view. The child view has the same filter as FilterOnIndex would
+	* add but answers the count, ids, transforms, metadata values and hash queries from InPoints instead of in SQL, as long
+	* as no other filter is added to it or to its children.
+	* @param InPoints - The points of this view
+	* @param InPointIndex - The index of the point in InPoints
+	* @return A child view to this view
+	*/
+	UPointCloudView* MakePointView(const TSharedPtr<const FPointCloudViewPoints>& InPoints, int32 InPointIndex);
+
 public:	// ~ Transform interface 
 
 	/**
@@ -240,6 +288,24 @@ public: // ~ Filter interface
 	 */
 	void FilterOnTile(int InNumTilesX, int InNumTilesY, int InNumTilesZ, int InTileX, int InTileY, int InTileZ, bool bInvertSelection, EFilterMode Mode = EFilterMode::FILTER_Or);
 
+	/**
+	 * Bucket the results of this view into every tile of a grid at once, so that sibling views filtered on the tiles of the same grid don't each have to evaluate their filter.
+	 * Should be called on a view that has no filters of its own, typically the first of the siblings.
+	 * @param QueryGridBounds - The bounding box that holds the grid
+	 * @param InNumTiles(X|Y|Z) - The number of tiles in each dimension
+	 * @return The partition, or null if the results of this view can't be evaluated against the in-memory spatial index
+	 */
+	TSharedPtr<const FPointCloudTilePartition> MakeTilePartition(const FBox& QueryGridBounds, int InNumTilesX, int InNumTilesY, int InNumTilesZ) const;
+
+	/**
+	 * Add a filter to this view that only includes points that are within a tile of a partition. The filter is the same as the one added by FilterOnTile with the bounds
+	 * of the partition, and when the partition was made from a sibling of this view its points are bound to the view without being evaluated again
+	 * @param Partition - The partition of the grid, as returned by MakeTilePartition
+	 * @param InTile(X|Y|Z) - The tile index per dimension
+	 * @return True if the points of the tile were bound to the view
+	 */
+	bool FilterOnTile(const TSharedPtr<const FPointCloudTilePartition>& Partition, int InTileX, int InTileY, int InTileZ);
+
 	/**
 	* Add a filter to this view that only includes point if the are within a given bounding sphere
 	* @param Center - The center of the bounding sphere
@@ -300,8 +366,36 @@ private:
 	/** Returns whether this contains initialized views (incl. parent view) */
 	bool HasFiltersApplied() const;
 
+	/**
+	* Returns the point this view is reduced to if it, or a parent with no filter in between, was made by MakePointView
+	* @param OutPointIndex - The index of the point in the returned set
+	* @return The set the point comes from, or null if the results of this view have to be queried
+	*/
+	const FPointCloudViewPoints* GetSinglePoint(int32& OutPointIndex) const;
+
 	/** Returns the number of views this contains (incl. parent view) */
 	int GetFilterCount() const;
+
+	/** Returns whether this view or its parents have filters that can be evaluated against the in-memory spatial or attribute indices */
+	bool HasNativeFilters() const;
+
+	/** Returns whether the filters on this view should be evaluated against the in-memory indices rather than in SQL */
+	bool UseNativeFilters() const;
+
+	/**
+	* Return the in-memory index over the values of a metadata key along with the results of this view, if the values can be read from it rather than queried in SQL
+	* @param Key - The name of the metadata key
+	* @param OutBits - The points of the index in the results of this view, or null if the view has no filters
+	* @return The attribute index, or null if the values have to be queried in SQL
+	*/
+	TSharedPtr<const FPointCloudAttributeIndex> GetAttributeIndex(const FString& Key, TSharedPtr<const TBitArray<>>& OutBits) const;
+
+	/**
+	* Evaluate the filters of this view and its parents against the in-memory spatial index. The result is cached until the filters or the point cloud change
+	* @param OutIndex - The spatial index the result refers to
+	* @return A bit array with a set bit for each point in OutIndex that passes the filters, or null if the index is not available
+	*/
+	TSharedPtr<const TBitArray<>> GetFilterResultBits(TSharedPtr<const FPointCloudSpatialIndex>& OutIndex) const;
 	
 public:
 
@@ -321,6 +415,12 @@ private:
 	*/
 	void AddFilterStatement(const FString &Statement);
 
+	/** Add a statement to the list of view creation statements along with an equivalent filter that can be evaluated against the in-memory spatial index */
+	void AddFilterStatement(const FString& Statement, const FPointCloudSpatialFilter& NativeFilter);
+
+	/** Add a statement to the list of view creation statements along with an equivalent filter that can be evaluated against an in-memory attribute index */
+	void AddFilterStatement(const FString& Statement, const FPointCloudMetadataFilter& MetadataFilter);
+
 	/** Clear the list of create view statements */
 	void ClearFilterStatements();
 
@@ -330,6 +430,9 @@ private:
 	/** Performs value retrieval on templated type */
 	template<typename T>
 	TArray<T> GetMetadataValuesArray(const FString& Key) const;
+
+	/** Count the combinations of values of the given keys using the in-memory attribute indices. Returns false if the counts have to be queried in SQL */
+	bool GetUniqueMetadataValuesAndCountsNative(const TArray<FString>& Keys, TArray<TPair<TArray<FString>, int32>>& OutResult) const;
 	
 private: /** Data */
 
@@ -347,6 +450,12 @@ private: /** Data */
 
 	/** The array of Statements required to generate this view. As there are dependencies between the statements these should be executed in order */
 	TArray<FString> FilterStatementList; 
+
+	/** The native equivalent of each entry in FilterStatementList. Statements that can only be run in SQL have a filter of type None */
+	TArray<FPointCloudSpatialFilter> NativeFilterList;
+
+	/** The metadata filter equivalent of each entry in FilterStatementList. Statements that are not metadata filters have an invalid filter */
+	TArray<FPointCloudMetadataFilter> MetadataFilterList;
 	
 	/** A flag to indicate if this view is in GetData State. */
 	bool bInGetDataState;
@@ -359,4 +468,13 @@ private: /** Data */
 
 	/** Contains cached hash of current view results, or empty if not computed */
 	mutable FString CachedResultHash;
+
+	/** Set by MakePointView, the point this view is reduced to. Reset when any other filter is added */
+	TSharedPtr<const FPointCloudViewPoints> SinglePoints;
+	int32 SinglePointIndex = INDEX_NONE;
+
+	/** Cached result of evaluating the filters against the in-memory spatial index, and the index it refers to */
+	mutable TSharedPtr<const TBitArray<>> CachedResultBits;
+	mutable TSharedPtr<const FPointCloudSpatialIndex> CachedResultIndex;
+	mutable FCriticalSection CachedResultBitsLock;
 };
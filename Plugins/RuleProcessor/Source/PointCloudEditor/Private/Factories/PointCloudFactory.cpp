@@ -19,6 +19,7 @@ UPointCloudFactory::UPointCloudFactory( const FObjectInitializer& ObjectInitiali
 	Formats.Add(FString(TEXT("psv;")) + NSLOCTEXT("UPointCloudFactory", "FormatCsv", "CSV File").ToString());
 	Formats.Add(FString(TEXT("psz;")) + NSLOCTEXT("UPointCloudFactory", "FormatPsz", "Zipped PSV File").ToString());
 	Formats.Add(FString(TEXT("pbc;")) + NSLOCTEXT("UPointCloudFactory", "FormatPbc", "Alembic File").ToString());
+	Formats.Add(FString(TEXT("pcc;")) + NSLOCTEXT("UPointCloudFactory", "FormatPcc", "Columnar Point Cloud File").ToString());
 	
 	SupportedClass = UPointCloudImpl::StaticClass();
 	bCreateNew = false;
@@ -64,6 +65,17 @@ UObject* UPointCloudFactory::FactoryCreateFile(UClass* InClass, UObject* InParen
 			bOutOperationCanceled = false;
 		}
 	}
+	else if (Extension == FString("pcc"))
+	{
+		if (!PointCloud->LoadFromColumnar(Filename, FBox(EForceInit::ForceInit), UPointCloud::REPLACE, Warn))
+		{
+			bOutOperationCanceled = true;
+		}
+		else
+		{
+			bOutOperationCanceled = false;
+		}
+	}
 	
 	if (Warn)
 	{
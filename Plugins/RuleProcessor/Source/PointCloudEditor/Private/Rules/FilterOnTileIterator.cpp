@@ -2,6 +2,8 @@
 
 #include "FilterOnTileIterator.h"
 #include "PointCloudView.h"
+#include "PointCloudTilePartition.h"
+#include "HAL/IConsoleManager.h"
 #include "Misc/ScopedSlowTask.h"
 #include "Engine/World.h"
 #include "WorldPartition/WorldPartition.h"
@@ -9,6 +11,11 @@
 
 #define LOCTEXT_NAMESPACE "TileIteratorFilterRule"
 
+static TAutoConsoleVariable<int32> CVarTilePartition(
+	TEXT("t.RuleProcessor.TilePartition"),
+	1,
+	TEXT("If non-zero, the tile iterator buckets the points of its parent into every tile in a single pass instead of filtering them once per tile."));
+
 namespace TileIteratorConstants
 {
 	static const FString Description = LOCTEXT("Description", "Create an N-M Grid of tiles").ToString();
@@ -110,6 +117,8 @@ bool UFilterOnTileIterator::Compile(FSliceAndDiceContext& Context) const
 	{		
 		if (UPointCloudRule* Slot = Instance.GetSlotRule(this, 0))
 		{
+			TSharedPtr<FTileIteratorPartitionCache> PartitionCache = MakeShared<FTileIteratorPartitionCache>();
+
 			for (int x = 0; x < Data.NumTilesX; ++x)
 			{
 				for (int y = 0; y < Data.NumTilesY; ++y)
@@ -117,7 +126,7 @@ bool UFilterOnTileIterator::Compile(FSliceAndDiceContext& Context) const
 					for (int z = 0; z < Data.NumTilesZ; ++z)
 					{
 						// Create instance and push it
-						FPointCloudRuleInstancePtr RuleInstance = MakeShareable(new FTileIteratorFilterInstance(this, x, y, z));
+						FPointCloudRuleInstancePtr RuleInstance = MakeShareable(new FTileIteratorFilterInstance(this, x, y, z, PartitionCache));
 
 						Instance.EmitInstance(RuleInstance, GetSlotName(0));
 						Result |= Slot->Compile(Context);
@@ -132,11 +141,64 @@ bool UFilterOnTileIterator::Compile(FSliceAndDiceContext& Context) const
 }
 
 
+TSharedPtr<const FPointCloudTilePartition> FTileIteratorPartitionCache::Take(const FPointCloudRuleInstance* InParent, const UPointCloudView* View, const FBox* GridBounds, const FIntVector& NumTiles)
+{
+	FScopeLock Lock(&EntriesLock);
+
+	FEntry* Entry = Entries.Find(InParent);
+
+	if (Entry && Entry->Partition.IsValid() && (Entry->Partition->GetNumTilesPerAxis() != NumTiles || (GridBounds && !Entry->Partition->GetGridBounds().Equals(*GridBounds, 0.0))))
+	{
+		// Overrides changed the grid between tiles, don't share it
+		return nullptr;
+	}
+
+	if (!Entry)
+	{
+		// The other tiles wait for the partition rather than filtering their points on their own
+		Entry = &Entries.Add(InParent);
+		Entry->Partition = View->MakeTilePartition(GridBounds ? *GridBounds : View->GetResultsBoundingBox(), NumTiles.X, NumTiles.Y, NumTiles.Z);
+	}
+
+	TSharedPtr<const FPointCloudTilePartition> Partition = Entry->Partition;
+
+	if (++Entry->NumTaken >= NumTiles.X * NumTiles.Y * NumTiles.Z)
+	{
+		Entries.Remove(InParent);
+	}
+
+	return Partition;
+}
+
 bool FTileIteratorFilterInstance::Execute()
 {
 	// Override name
 	Data.OverrideNameValue(TileX, TileY, TileZ);
 
+	if (PartitionCache.IsValid() && CVarTilePartition.GetValueOnAnyThread() != 0)
+	{
+		const FIntVector NumTiles(Data.NumTilesX, Data.NumTilesY, Data.NumTilesZ);
+		const FBox* GridBounds = (Data.BoundsOption == EPointCloudBoundsOption::Compute) ? nullptr : &Data.Bounds;
+
+		if (TSharedPtr<const FPointCloudTilePartition> Partition = PartitionCache->Take(Parent.Get(), GetView(), GridBounds, NumTiles))
+		{
+			if (GetView()->FilterOnTile(Partition, TileX, TileY, TileZ))
+			{
+				// Nothing below an empty tile has points to work on, unless it has to report on them
+				if (Partition->Num(Partition->GetTileIndex(FIntVector(TileX, TileY, TileZ))) == 0 && !GenerateReporting())
+				{
+					SetSkipChildren(true);
+				}
+			}
+			else
+			{
+				GetView()->PreCacheFilters();
+			}
+
+			return true;
+		}
+	}
+
 	FBox BoundsToUse = Data.Bounds;
 
 	if (Data.BoundsOption == EPointCloudBoundsOption::Compute)
@@ -7,6 +7,8 @@
 
 #include "FilterOnTileIterator.generated.h"
 
+class FPointCloudTilePartition;
+
 USTRUCT(BlueprintType)
 struct FFilterOnTileIteratorData : public FPointCloudRuleData
 {
@@ -80,14 +82,43 @@ protected:
 	//~ End UPointCloudRule Interface
 };
 
+/**
+* Shares the points of a parent bucketed into tiles between the tile instances made for it, so the points are partitioned once
+* instead of being filtered once per tile. A partition is released once every tile of its grid has taken it
+*/
+class FTileIteratorPartitionCache
+{
+public:
+	/**
+	* Return the partition of the points of a parent, making it on the first call
+	* @param InParent - The parent instance of the tile instance
+	* @param View - The view of the tile instance, before its tile filter is applied
+	* @param GridBounds - The bounds of the grid, or null to use the bounds of the points of the view
+	* @param NumTiles - The number of tiles along each axis
+	* @return The partition, or null if the points can't be partitioned
+	*/
+	TSharedPtr<const FPointCloudTilePartition> Take(const FPointCloudRuleInstance* InParent, const UPointCloudView* View, const FBox* GridBounds, const FIntVector& NumTiles);
+
+private:
+	struct FEntry
+	{
+		TSharedPtr<const FPointCloudTilePartition> Partition;
+		int32 NumTaken = 0;
+	};
+
+	TMap<const FPointCloudRuleInstance*, FEntry> Entries;
+	FCriticalSection EntriesLock;
+};
+
 class FTileIteratorFilterInstance : public FPointCloudRuleInstanceWithData<FTileIteratorFilterInstance, FFilterOnTileIteratorData>
 {
 public:
-	FTileIteratorFilterInstance(const UFilterOnTileIterator* InRule, int32 InX, int32 InY, int32 InZ)
+	FTileIteratorFilterInstance(const UFilterOnTileIterator* InRule, int32 InX, int32 InY, int32 InZ, const TSharedPtr<FTileIteratorPartitionCache>& InPartitionCache)
 		: FPointCloudRuleInstanceWithData(InRule, InRule->Data)
 		, TileX(InX)
 		, TileY(InY)
 		, TileZ(InZ)
+		, PartitionCache(InPartitionCache)
 	{
 	}
 
@@ -98,6 +129,9 @@ private:
 	int32 TileX;
 	int32 TileY;
 	int32 TileZ;
+
+	/** Shared by the instances of every tile of the iterator */
+	TSharedPtr<FTileIteratorPartitionCache> PartitionCache;
 };
 
 class FTileIteratorFilterFactory : public FSliceAndDiceRuleFactory
@@ -108,41 +108,30 @@ bool FPerPointIteratorFilterInstance::PreExecute(FSliceAndDiceExecutionContextPt
 
 bool FPerPointIteratorFilterInstance::Iterate(FSliceAndDiceExecutionContextPtr Context)
 {		
-	TArray<int32> Points;
-	
-	GetView()->GetIndexes(Points);
-
-	const FString SaveOriginalName = Data.NameValue;
+	UPointCloudView* View = GetView();
 
 	// Make sure that we scope save/unload at this point
 	check(Context);
 	Context->BatchOnRule(this);
 
-	FScopedSlowTask SlowTask(Points.Num() * Children.Num(), LOCTEXT("PerPointIteration", "Iterating on all points"));
+	FScopedSlowTask SlowTask(View->GetCount() * Children.Num(), LOCTEXT("PerPointIteration", "Iterating on all points"));
 	SlowTask.MakeDialog();
 
-	for (FPointCloudRuleInstancePtr Child : Children)
-	{
-		if (!Child)
-		{
-			continue;
-		}
-
-		for (int32 VertexId : Points)
-		{
-			SlowTask.EnterProgressFrame();
-			Data.OverrideNameValue(VertexId);
+	// Children are given a stand-in for this instance per point, which holds the name for that point
+	// and keeps the hash of this instance for the actor mappings
+	const FString Hash = GetHash();
 
-			UPointCloudView* PerChildView = GetView()->MakeChildView();
-			PerChildView->FilterOnIndex(VertexId);
-			Child->SetView(PerChildView);
+	auto MakePointInstance = [this, &Hash](int32 VertexId) -> FPointCloudRuleInstancePtr
+	{
+		TSharedPtr<FPointCloudPointRuleInstance<FPerPointIteratorData>> PointInstance = MakeShareable(new FPointCloudPointRuleInstance<FPerPointIteratorData>(GetRule(), Data, Parent, Hash));
+		PointInstance->GetData().OverrideNameValue(VertexId);
+		return PointInstance;
+	};
 
-			SliceAndDiceExecution::SingleThreadedRuleInstanceExecute(Child, Context);
+	// Report frames are not thread safe
+	const bool bAllowWorkerThreads = !GenerateReporting();
 
-			// And once we're done, reset the Name back to the original
-			Data.NameValue = SaveOriginalName;
-		}
-	}
+	SliceAndDiceExecution::PerPointRuleInstanceExecute(Children, View, Context, MakePointInstance, bAllowWorkerThreads, &SlowTask);
 
 	// Make sure we don't execute child rules, as we already did so
 	SetSkipChildren(true);
@@ -78,6 +78,7 @@ public class MassTraffic : ModuleRules
 				"PhysicsCore",
 				"Chaos",
 				"ChaosCore",
+				"Json",
 			}
 			);
 		
@@ -289,6 +289,30 @@ FAutoConsoleVariableRef CVarMassTrafficControlInputWakeTolerance(
 	ECVF_Scalability
 	);
 
+int32 GMassTrafficSleepIslands = 1;
+FAutoConsoleVariableRef CVarMassTrafficSleepIslands(
+	TEXT("MassTraffic.SleepIslands"),
+	GMassTrafficSleepIslands,
+	TEXT("Whether medium LOD vehicle physics wakes islands of queued vehicles together. The head of a resting island has its inputs checked by its island rather than by itself.\n"),
+	ECVF_Scalability
+	);
+
+float GMassTrafficSleepIslandMaxGap = 500.0f;
+FAutoConsoleVariableRef CVarMassTrafficSleepIslandMaxGap(
+	TEXT("MassTraffic.SleepIslandMaxGap"),
+	GMassTrafficSleepIslandMaxGap,
+	TEXT("Largest gap (cm) between two vehicles on a lane, beyond the space they take, for them to be in the same sleep island.\n"),
+	ECVF_Scalability
+	);
+
+int32 GMassTrafficBatchedSuspensionSolver = 1;
+FAutoConsoleVariableRef CVarMassTrafficBatchedSuspensionSolver(
+	TEXT("MassTraffic.BatchedSuspensionSolver"),
+	GMassTrafficBatchedSuspensionSolver,
+	TEXT("Whether to solve the suspension constraints of medium LOD vehicles without trailers four vehicles at a time with SIMD, rather than one by one.\n"),
+	ECVF_Scalability
+	);
+
 float GMassTrafficDebugForceScaling = 0.0006f;
 FAutoConsoleVariableRef CVarMassTrafficDebugForceScaling(
 	TEXT("MassTraffic.DebugForceScaling"),
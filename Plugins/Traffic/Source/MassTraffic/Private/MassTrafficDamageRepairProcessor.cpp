@@ -2,11 +2,14 @@
 
 #include "MassTrafficDamageRepairProcessor.h"
 #include "MassTraffic.h"
+#include "MassTrafficMovement.h"
+#include "MassTrafficSubsystem.h"
 #include "MassTrafficVehicleInterface.h"
 #include "MassExecutionContext.h"
 #include "GameFramework/PlayerController.h"
 #include "DrawDebugHelpers.h"
 #include "MassActorSubsystem.h"
+#include "MassZoneGraphNavigationFragments.h"
 
 
 UMassTrafficDamageRepairProcessor::UMassTrafficDamageRepairProcessor()
@@ -29,6 +32,7 @@ void UMassTrafficDamageRepairProcessor::ConfigureQueries()
 	DamagedVehicleEntityQuery.AddRequirement<FMassActorFragment>(EMassFragmentAccess::ReadWrite);
 	DamagedVehicleEntityQuery.AddRequirement<FMassTrafficVehicleDamageFragment>(EMassFragmentAccess::ReadWrite);
 	DamagedVehicleEntityQuery.AddRequirement<FMassRepresentationLODFragment>(EMassFragmentAccess::ReadWrite);
+	DamagedVehicleEntityQuery.AddRequirement<FMassZoneGraphLaneLocationFragment>(EMassFragmentAccess::ReadOnly, EMassFragmentPresence::Optional);
 }
 
 void UMassTrafficDamageRepairProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
@@ -39,13 +43,16 @@ void UMassTrafficDamageRepairProcessor::Execute(FMassEntityManager& EntityManage
 		return;
 	}
 	
+	UMassTrafficSubsystem* MassTrafficSubsystem = UWorld::GetSubsystem<UMassTrafficSubsystem>(GetWorld());
+
 	// Block LOD changes to high LOD damaged vehicles, while we repair damage
-	DamagedVehicleEntityQuery.ForEachEntityChunk(EntityManager, Context, [](FMassExecutionContext& Context)
+	DamagedVehicleEntityQuery.ForEachEntityChunk(EntityManager, Context, [MassTrafficSubsystem](FMassExecutionContext& Context)
 	{
 		const int32 NumEntities = Context.GetNumEntities();
 		const TArrayView<FMassActorFragment> ActorFragments = Context.GetMutableFragmentView<FMassActorFragment>();
 		const TArrayView<FMassTrafficVehicleDamageFragment> VehicleDamageFragments = Context.GetMutableFragmentView<FMassTrafficVehicleDamageFragment>();
 		const TArrayView<FMassRepresentationLODFragment> RepresentationLODFragments = Context.GetMutableFragmentView<FMassRepresentationLODFragment>();
+		const TConstArrayView<FMassZoneGraphLaneLocationFragment> LaneLocationFragments = Context.GetFragmentView<FMassZoneGraphLaneLocationFragment>();
 
 		const bool bIsDisturbedVehicle = Context.DoesArchetypeHaveTag<FMassTrafficDisturbedVehicleTag>();
 
@@ -101,6 +108,15 @@ void UMassTrafficDamageRepairProcessor::Execute(FMassEntityManager& EntityManage
 					{
 						// Force LOD to None so the visualization processor releases this actor this frame
 						RepresentationLODFragment.LOD = EMassLOD::Off;
+
+						// Either way the vehicle leaves its lane
+						if (MassTrafficSubsystem && !LaneLocationFragments.IsEmpty() && LaneLocationFragments[EntityIndex].LaneHandle.IsValid())
+						{
+							if (FZoneGraphTrafficLaneData* TrafficLaneData = MassTrafficSubsystem->GetMutableTrafficLaneData(LaneLocationFragments[EntityIndex].LaneHandle))
+							{
+								UE::MassTraffic::DeferRemoveVehicleFromLane(Context.Defer(), Context.GetEntity(EntityIndex), *TrafficLaneData);
+							}
+						}
 						// If the entity is disturbed (a parked vehicle moved from it's spawn location)
 						// then we need to delete it. Otherwise we recycle the entity.
 						if (bIsDisturbedVehicle)
@@ -7,6 +7,8 @@ namespace UE::MassTrafficDelegates
 
 MASSTRAFFIC_API FOnPreTrafficLaneDataChange OnPreTrafficLaneDataChange;
 MASSTRAFFIC_API FOnTrafficLaneDataChanged OnTrafficLaneDataChanged;
+MASSTRAFFIC_API FOnTrafficZoneGraphDataRegistered OnTrafficZoneGraphDataRegistered;
+MASSTRAFFIC_API FOnPreTrafficZoneGraphDataUnregistered OnPreTrafficZoneGraphDataUnregistered;
 MASSTRAFFIC_API FOnPostInitTrafficIntersections OnPostInitTrafficIntersections;
 
 }
@@ -96,11 +96,16 @@ void UMassTrafficFieldComponent::BeginPlay()
 }
 
 void UMassTrafficFieldComponent::UpdateOverlappedLanes(UMassTrafficSubsystem& MassTrafficSubsystem)
+{
+	TrafficLanes.Reset();
+
+	AddOverlappedLanes(MassTrafficSubsystem, FZoneGraphDataHandle());
+}
+
+void UMassTrafficFieldComponent::AddOverlappedLanes(UMassTrafficSubsystem& MassTrafficSubsystem, const FZoneGraphDataHandle DataHandle)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(TEXT("MassTrafficFieldComponent Find Overlapped Lanes"))
 
-	TrafficLanes.Reset();
-	
 	const UZoneGraphSubsystem* ZoneGraphSubsystem = UWorld::GetSubsystem<UZoneGraphSubsystem>(GetWorld());
 
 	// Find overlap zone graph lanes 
@@ -110,6 +115,11 @@ void UMassTrafficFieldComponent::UpdateOverlappedLanes(UMassTrafficSubsystem& Ma
 	
 	for (const FZoneGraphLaneHandle LaneHandle : ZoneGraphLanes)
 	{
+		if (DataHandle.IsValid() && LaneHandle.DataHandle != DataHandle)
+		{
+			continue;
+		}
+
 		if (MassTrafficSubsystem.HasTrafficDataForZoneGraph(LaneHandle.DataHandle))
 		{
 			FZoneGraphTrafficLaneData* TrafficLaneData = MassTrafficSubsystem.GetMutableTrafficLaneData(LaneHandle);
@@ -129,6 +139,32 @@ void UMassTrafficFieldComponent::OnTrafficLaneDataChanged(UMassTrafficSubsystem*
 	UpdateOverlappedLanes(*MassTrafficSubsystem);
 }
 
+void UMassTrafficFieldComponent::OnTrafficZoneGraphDataRegistered(UMassTrafficSubsystem* MassTrafficSubsystem, const FZoneGraphDataHandle DataHandle)
+{
+	// Make sure these are lanes from the same world
+	if (!MassTrafficSubsystem || MassTrafficSubsystem->GetWorld() != GetWorld())
+	{
+		return;
+	}
+
+	AddOverlappedLanes(*MassTrafficSubsystem, DataHandle);
+}
+
+void UMassTrafficFieldComponent::OnPreTrafficZoneGraphDataUnregistered(UMassTrafficSubsystem* MassTrafficSubsystem, const FZoneGraphDataHandle DataHandle)
+{
+	// Make sure these are lanes from the same world
+	if (!MassTrafficSubsystem || MassTrafficSubsystem->GetWorld() != GetWorld())
+	{
+		return;
+	}
+
+	// Drop lanes of the unregistered zone graph before their data is released
+	TrafficLanes.RemoveAll([DataHandle](const FZoneGraphTrafficLaneData* TrafficLaneData)
+	{
+		return TrafficLaneData->LaneHandle.DataHandle == DataHandle;
+	});
+}
+
 void UMassTrafficFieldComponent::UpdateOverlappedIntersections(const UMassTrafficSubsystem& MassTrafficSubsystem)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(TEXT("MassTrafficFieldComponent Find Overlapped Lanes"))
@@ -183,6 +219,10 @@ void UMassTrafficFieldComponent::OnRegister()
 
 		// Wait for OnTrafficLaneDataChanged to cache overlapped lanes
 		UE::MassTrafficDelegates::OnTrafficLaneDataChanged.AddUObject(this, &UMassTrafficFieldComponent::OnTrafficLaneDataChanged);
+
+		// Zone graph data streaming in or out only adds or removes the overlapped lanes of that zone graph
+		UE::MassTrafficDelegates::OnTrafficZoneGraphDataRegistered.AddUObject(this, &UMassTrafficFieldComponent::OnTrafficZoneGraphDataRegistered);
+		UE::MassTrafficDelegates::OnPreTrafficZoneGraphDataUnregistered.AddUObject(this, &UMassTrafficFieldComponent::OnPreTrafficZoneGraphDataUnregistered);
 		
 		// Wait for OnPostInitTrafficIntersections to cache overlapped intersections
 		UE::MassTrafficDelegates::OnPostInitTrafficIntersections.AddUObject(this, &UMassTrafficFieldComponent::OnPostInitTrafficIntersections);
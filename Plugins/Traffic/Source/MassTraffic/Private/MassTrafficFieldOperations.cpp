@@ -45,34 +45,40 @@ void FMassTrafficFieldOperationContext::ForEachTrafficVehicle(FTrafficVehicleOnL
 	const TArray<FZoneGraphTrafficLaneData*>& TrafficLanes = Field.GetTrafficLanes();
 	for (FZoneGraphTrafficLaneData* TrafficLaneData : TrafficLanes)
 	{		
-		// Loop over vehicles on lane
+		// Loop over vehicles on lane. Operations don't depend on the following order, so use the packed vehicle index
+		// rather than walking the NextVehicle links from the tail
 		bool bContinue = true;
 
-		// Filter by transform?
-		if (Field.InclusionMode == EMassTrafficFieldInclusionMode::VehiclesOnLanes)
+		for (const FMassEntityHandle VehicleEntity : TrafficLaneData->Vehicles.GetEntities())
 		{
-			TrafficLaneData->ForEachVehicleOnLane(EntityManager, [&](const FMassEntityView& VehicleEntityView, FMassTrafficNextVehicleFragment& NextVehicleFragment, FMassZoneGraphLaneLocationFragment& LaneLocationFragment)
+			if (!EntityManager.IsEntityValid(VehicleEntity))
+			{
+				continue;
+			}
+
+			const FMassEntityView VehicleEntityView(EntityManager, VehicleEntity);
+			FMassZoneGraphLaneLocationFragment& LaneLocationFragment = VehicleEntityView.GetFragmentData<FMassZoneGraphLaneLocationFragment>();
+			if (LaneLocationFragment.LaneHandle != TrafficLaneData->LaneHandle)
+			{
+				continue;
+			}
+
+			// Filter by transform?
+			if (Field.InclusionMode == EMassTrafficFieldInclusionMode::VehiclesOnLanes)
 			{
 				const FTransformFragment& TransformFragment = VehicleEntityView.GetFragmentData<FTransformFragment>();
-				
-				// Transform filtering
-				if (FieldBounds.IsInside(TransformFragment.GetTransform().GetLocation()))
+				if (!FieldBounds.IsInside(TransformFragment.GetTransform().GetLocation()))
 				{
-					bContinue = ExecuteFunction(*TrafficLaneData, VehicleEntityView, NextVehicleFragment, LaneLocationFragment);
-					return bContinue;
+					continue;
 				}
+			}
 
-				return true;
-			});
-		}
-		else
-		{
-			// ExecuteFunction for all vehicles on lane
-			TrafficLaneData->ForEachVehicleOnLane(EntityManager, [&](const FMassEntityView& VehicleEntityView, FMassTrafficNextVehicleFragment& NextVehicleFragment, FMassZoneGraphLaneLocationFragment& LaneLocationFragment)
+			FMassTrafficNextVehicleFragment& NextVehicleFragment = VehicleEntityView.GetFragmentData<FMassTrafficNextVehicleFragment>();
+			bContinue = ExecuteFunction(*TrafficLaneData, VehicleEntityView, NextVehicleFragment, LaneLocationFragment);
+			if (!bContinue)
 			{
-				bContinue = ExecuteFunction(*TrafficLaneData, VehicleEntityView, NextVehicleFragment, LaneLocationFragment);
-				return bContinue;
-			});
+				break;
+			}
 		}
 
 		if (!bContinue)
@@ -163,6 +169,7 @@ void UMassTrafficSetLaneSpeedLimitFieldOperation::Execute(FMassTrafficFieldOpera
 	Context.ForEachTrafficLane([&Context, SpeedLimit](FZoneGraphTrafficLaneData& TrafficLaneData)
 	{
 		TrafficLaneData.ConstData.SpeedLimit = SpeedLimit;
+		TrafficLaneData.RequestWakeSleepingVehicles();
 
 		// Adjust incoming lane's MinNextLaneSpeedLimit
 		TArray<FZoneGraphLinkedLane> IncomingLanes;
@@ -5,37 +5,18 @@
 #include "MassTrafficUtils.h"
 #include "MassTraffic.h"
 
+#include "Algo/StableSort.h"
 #include "MassCommandBuffer.h"
 #include "MassCommonFragments.h"
 #include "ZoneGraphQuery.h"
 #include "DrawDebugHelpers.h"
 #include "MassEntityView.h"
 #include "MassExecutionContext.h"
+#include "MassMovementFragments.h"
 #include "MassTrafficVehicleSimulationTrait.h"
-#include "ZoneGraphSubsystem.h"
 #include "MassGameplayExternalTraits.h"
 #include "VisualLogger/VisualLogger.h"
 
-void FindNearbyLanes(const FZoneGraphStorage& Storage, const FBox& Bounds, const FZoneGraphTagFilter TagFilter, TArray<int32>& OutLanes)
-{
-	TRACE_CPUPROFILER_EVENT_SCOPE(TEXT("FindNearbyLanes"))
-	
-	for (const FZoneData& Zone : Storage.Zones)
-	{
-		if (Bounds.Intersect(Zone.Bounds))
-		{
-			for (int32 LaneIndex = Zone.LanesBegin; LaneIndex < Zone.LanesEnd; LaneIndex++)
-			{
-				const FZoneLaneData& Lane = Storage.Lanes[LaneIndex];
-				if (TagFilter.Pass(Lane.Tags))
-				{
-					OutLanes.Add(LaneIndex);
-				}
-			}
-		}
-	}
-}
-
 UMassTrafficFindObstaclesProcessor::UMassTrafficFindObstaclesProcessor()
 	: ObstacleEntityQuery(*this)
 	, ObstacleAvoidingEntityQuery(*this)
@@ -52,9 +33,9 @@ void UMassTrafficFindObstaclesProcessor::ConfigureQueries()
 	ObstacleEntityQuery.AddTagRequirement<FMassTrafficObstacleTag>(EMassFragmentPresence::All);
 	ObstacleEntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadOnly);
 	ObstacleEntityQuery.AddRequirement<FAgentRadiusFragment>(EMassFragmentAccess::ReadOnly);
+	ObstacleEntityQuery.AddRequirement<FMassVelocityFragment>(EMassFragmentAccess::ReadOnly, EMassFragmentPresence::Optional);
 	ObstacleEntityQuery.AddConstSharedRequirement<FMassTrafficVehicleSimulationParameters>(EMassFragmentPresence::Optional);
-	ObstacleEntityQuery.AddSubsystemRequirement<UZoneGraphSubsystem>(EMassFragmentAccess::ReadOnly);
-	ObstacleEntityQuery.AddSubsystemRequirement<UMassTrafficSubsystem>(EMassFragmentAccess::ReadOnly);
+	ObstacleEntityQuery.AddSubsystemRequirement<UMassTrafficSubsystem>(EMassFragmentAccess::ReadWrite);
 
 	// Secondary query to find obstacle lists to reset before filling in the main process
 	ObstacleAvoidingEntityQuery.AddRequirement<FMassTrafficObstacleListFragment>(EMassFragmentAccess::ReadWrite);
@@ -80,16 +61,16 @@ void UMassTrafficFindObstaclesProcessor::Execute(FMassEntityManager& EntityManag
 		// Re-bind obstacles to vehicles on nearby lanes
 		TRACE_CPUPROFILER_EVENT_SCOPE(TEXT("FindVehiclesForObstacles"))
 
-		TMap<FMassEntityHandle, TArray<FMassEntityHandle>> ObstacleListsToAdd;
+		ObstacleListsToAdd.Reset();
 		
 		ObstacleEntityQuery.ForEachEntityChunk(EntityManager, Context, [&](FMassExecutionContext& QueryContext)
 		{
-			const UMassTrafficSubsystem& MassTrafficSubsystem = QueryContext.GetSubsystemChecked<UMassTrafficSubsystem>();
-			const UZoneGraphSubsystem& ZoneGraphSubsystem = QueryContext.GetSubsystemChecked<UZoneGraphSubsystem>();
+			UMassTrafficSubsystem& MassTrafficSubsystem = QueryContext.GetMutableSubsystemChecked<UMassTrafficSubsystem>();
 
 			const FMassTrafficVehicleSimulationParameters* VehicleSimulationParams = QueryContext.GetConstSharedFragmentPtr<FMassTrafficVehicleSimulationParameters>();
 			const TConstArrayView<FAgentRadiusFragment> AgentRadiusFragments = QueryContext.GetFragmentView<FAgentRadiusFragment>();
 			const TConstArrayView<FTransformFragment> TransformFragments = QueryContext.GetFragmentView<FTransformFragment>();
+			const TConstArrayView<FMassVelocityFragment> OptionalVelocityFragments = QueryContext.GetFragmentView<FMassVelocityFragment>();
 
 			// Loop obstacles and find affected vehicles
 			const int32 NumEntities = QueryContext.GetNumEntities();
@@ -101,6 +82,9 @@ void UMassTrafficFindObstaclesProcessor::Execute(FMassEntityManager& EntityManag
 
 				const float AgentWidth = VehicleSimulationParams ? VehicleSimulationParams->HalfWidth : AgentRadiusFragment.Radius;
 
+				// Obstacles we can't tell are at rest wake the vehicles they approach
+				const bool bIsObstacleMoving = OptionalVelocityFragments.IsEmpty() || OptionalVelocityFragments[Index].Value.Size() >= GMassTrafficLinearSpeedSleepThreshold;
+
 				// Debug draw obstacle
 				#if WITH_MASSTRAFFIC_DEBUG
 					if (GMassTrafficDebugObstacleAvoidance)
@@ -120,95 +104,109 @@ void UMassTrafficFindObstaclesProcessor::Execute(FMassEntityManager& EntityManag
 					}
 				#endif
 
-				// Find nearby lanes for this obstacle
-				TArray<FZoneGraphLaneHandle> NearbyLanes;
+				// Find nearby traffic lanes, and the nearest point on each of them, for this obstacle
+				NearbyLaneLocations.Reset();
 				FBox SearchBox = FBox::BuildAABB(TransformFragment.GetTransform().GetLocation(), FVector(FVector2D(MassTrafficSettings->ObstacleSearchRadius), MassTrafficSettings->ObstacleSearchHeight));
-				ZoneGraphSubsystem.FindOverlappingLanes(SearchBox, GetDefault<UMassTrafficSettings>()->TrafficLaneFilter, NearbyLanes);
+				for (const FMassTrafficZoneGraphData& TrafficZoneGraphData : MassTrafficSubsystem.GetTrafficZoneGraphData())
+				{
+					TrafficZoneGraphData.LaneSegmentGrid.FindNearestLocationsOnLanes(SearchBox, NearbyLaneLocations);
+				}
 
 				// Loop over nearby lanes
-				for (const FZoneGraphLaneHandle NearbyLane : NearbyLanes)
+				for (const FMassTrafficLaneSegmentGrid::FLaneLocation& NearestLocationOnLane : NearbyLaneLocations)
 				{
-					// Get nearest point on lane
-					FZoneGraphLaneLocation NearestLocationOnLane;
-					float DistanceSq;
-					ZoneGraphSubsystem.FindNearestLocationOnLane(NearbyLane, SearchBox, NearestLocationOnLane, DistanceSq);
-					if (NearestLocationOnLane.IsValid())
+					// Debug draw nearby lanes
+					#if WITH_MASSTRAFFIC_DEBUG
+						if (GMassTrafficDebugObstacleAvoidance)
+						{
+							DrawDebugPoint(GetWorld(), NearestLocationOnLane.Position + FVector(0,0,50), 10.0f, FColor::Magenta);
+						}
+						if (GMassTrafficDebugObstacleAvoidance > 1)
+						{
+							UE_VLOG_LOCATION(&MassTrafficSubsystem, TEXT("MassTraffic Avoidance"), Log, NearestLocationOnLane.Position, 10.0f, FColor::Magenta, TEXT("%d Nearby Lane"), ObstacleEntity.Index);
+						}
+					#endif
+					
+					// Get lane data
+					FZoneGraphTrafficLaneData* NearbyTrafficLane = MassTrafficSubsystem.GetMutableTrafficLaneData(NearestLocationOnLane.LaneHandle);
+					if (!NearbyTrafficLane)
+					{
+						continue;
+					}
+
+					// Find nearest vehicle behind this point on the lane. Distances in the packed vehicle index can be a
+					// frame old, which is close enough to pick the vehicle to avoid us and saves walking the NextVehicle
+					// links from the tail
+					const FMassTrafficLaneVehicles& LaneVehicles = NearbyTrafficLane->Vehicles;
+					const int32 AheadIndex = LaneVehicles.FindFirstAtOrAhead(NearestLocationOnLane.DistanceAlongLane);
+					const FMassEntityHandle PreviousVehicle = AheadIndex > 0 ? LaneVehicles.GetEntities()[AheadIndex - 1] : FMassEntityHandle();
+
+					// Is there a vehicle behind us?
+					if (PreviousVehicle.IsSet() && PreviousVehicle != ObstacleEntity && EntityManager.IsEntityValid(PreviousVehicle))
 					{
-						// Debug draw nearby lanes
+						if (bIsObstacleMoving)
+						{
+							NearbyTrafficLane->RequestWakeSleepingVehicles();
+						}
+
+						// Debug draw line from avoiding vehicle -> obstacle
 						#if WITH_MASSTRAFFIC_DEBUG
 							if (GMassTrafficDebugObstacleAvoidance)
 							{
-								DrawDebugPoint(GetWorld(), NearestLocationOnLane.Position + FVector(0,0,50), 10.0f, FColor::Magenta);
-							}
-							if (GMassTrafficDebugObstacleAvoidance > 1)
-							{
-								UE_VLOG_LOCATION(&MassTrafficSubsystem, TEXT("MassTraffic Avoidance"), Log, NearestLocationOnLane.Position, 10.0f, FColor::Magenta, TEXT("%d Nearby Lane"), ObstacleEntity.Index);
+								FMassEntityView PreviousVehicleEntityView(EntityManager, PreviousVehicle);
+								FVector AvoidingVehicleLocation = PreviousVehicleEntityView.GetFragmentData<FTransformFragment>().GetTransform().GetLocation();
+								DrawDebugLine(GetWorld(), AvoidingVehicleLocation, TransformFragment.GetTransform().GetLocation(), FColor::Yellow, false, -1, 0, /*Thickness*/5.0f);
+								if (GMassTrafficDebugObstacleAvoidance > 1)
+								{
+									UE_VLOG_SEGMENT_THICK(&MassTrafficSubsystem, TEXT("MassTraffic Avoidance"), Log, AvoidingVehicleLocation, TransformFragment.GetTransform().GetLocation(), FColor::Yellow, 5.0f, TEXT("%d Avoiding %d"), PreviousVehicle.Index, ObstacleEntity.Index);
+									const float Radius = PreviousVehicleEntityView.GetFragmentData<FAgentRadiusFragment>().Radius;
+									const float HalfWidth = PreviousVehicleEntityView.GetSharedFragmentData<FMassTrafficVehicleSimulationParameters>().HalfWidth;
+
+									DrawDebugBox(GetWorld(),
+										TransformFragment.GetTransform().GetLocation(),
+										FVector(Radius, HalfWidth, HalfWidth),
+										TransformFragment.GetTransform().GetRotation(),
+										FColor::Orange);
+
+								}
 							}
 						#endif
 						
-						// Get lane data
-						const FZoneGraphTrafficLaneData* NearbyTrafficLane = MassTrafficSubsystem.GetTrafficLaneData(NearbyLane);
-						if (!NearbyTrafficLane)
+						FMassTrafficObstacleListFragment* ExistingObstacleListFragment = EntityManager.GetFragmentDataPtr<FMassTrafficObstacleListFragment>(PreviousVehicle);
+						if (ExistingObstacleListFragment)
 						{
-							continue;
+							ExistingObstacleListFragment->Obstacles.Add(ObstacleEntity);
 						}
-
-						// Find nearest vehicle ahead of and behind this point on the lane
-						FMassEntityHandle PreviousVehicle;
-						FMassEntityHandle NextVehicle;
-						UE::MassTraffic::FindNearestVehiclesInLane(EntityManager, *NearbyTrafficLane, NearestLocationOnLane.DistanceAlongLane, PreviousVehicle, NextVehicle);
-
-						// Is there a vehicle behind us?
-						if (PreviousVehicle.IsSet() && PreviousVehicle != ObstacleEntity)
+						else
 						{
-							// Debug draw line from avoiding vehicle -> obstacle
-							#if WITH_MASSTRAFFIC_DEBUG
-								if (GMassTrafficDebugObstacleAvoidance)
-								{
-									FMassEntityView PreviousVehicleEntityView(EntityManager, PreviousVehicle);
-									FVector AvoidingVehicleLocation = PreviousVehicleEntityView.GetFragmentData<FTransformFragment>().GetTransform().GetLocation();
-									DrawDebugLine(GetWorld(), AvoidingVehicleLocation, TransformFragment.GetTransform().GetLocation(), FColor::Yellow, false, -1, 0, /*Thickness*/5.0f);
-									if (GMassTrafficDebugObstacleAvoidance > 1)
-									{
-										UE_VLOG_SEGMENT_THICK(&MassTrafficSubsystem, TEXT("MassTraffic Avoidance"), Log, AvoidingVehicleLocation, TransformFragment.GetTransform().GetLocation(), FColor::Yellow, 5.0f, TEXT("%d Avoiding %d"), PreviousVehicle.Index, ObstacleEntity.Index);
-										const float Radius = PreviousVehicleEntityView.GetFragmentData<FAgentRadiusFragment>().Radius;
-										const float HalfWidth = PreviousVehicleEntityView.GetSharedFragmentData<FMassTrafficVehicleSimulationParameters>().HalfWidth;
-
-										DrawDebugBox(GetWorld(),
-											TransformFragment.GetTransform().GetLocation(),
-											FVector(Radius, HalfWidth, HalfWidth),
-											TransformFragment.GetTransform().GetRotation(),
-											FColor::Orange);
-
-									}
-								}
-							#endif
-							
-							FMassTrafficObstacleListFragment* ExistingObstacleListFragment = EntityManager.GetFragmentDataPtr<FMassTrafficObstacleListFragment>(PreviousVehicle);
-							if (ExistingObstacleListFragment)
-							{
-								ExistingObstacleListFragment->Obstacles.Add(ObstacleEntity);
-							}
-							else
-							{
-								// We can't use Context.Defer().PushCommand(FMassCommandAddFragmentInstance) here as we
-								// might find multiple obstacles for a single vehicle this frame which would result in
-								// multiple FMassCommandAddFragmentInstance to be queued. So instead we collect all the
-								// obstacles per vehicle and add the compiled list together 
-								ObstacleListsToAdd.FindOrAdd(PreviousVehicle).Add(ObstacleEntity);
-							}
+							// We can't use Context.Defer().PushCommand(FMassCommandAddFragmentInstance) here as we
+							// might find multiple obstacles for a single vehicle this frame which would result in
+							// multiple FMassCommandAddFragmentInstance to be queued. So instead we collect all the
+							// obstacles per vehicle and add the compiled list together 
+							ObstacleListsToAdd.Emplace(PreviousVehicle, ObstacleEntity);
 						}
 					}
 				}
 			}
 		});
 
-		// Add obstacle list fragments
-		for (const auto& VehicleToObstacles : ObstacleListsToAdd)
+		// Add obstacle list fragments, grouping the pairs by vehicle while keeping the order obstacles were found in
+		Algo::StableSortBy(ObstacleListsToAdd, [](const TPair<FMassEntityHandle, FMassEntityHandle>& VehicleToObstacle)
 		{
+			return VehicleToObstacle.Key.AsNumber();
+		});
+
+		for (int32 PairIndex = 0; PairIndex < ObstacleListsToAdd.Num();)
+		{
+			const FMassEntityHandle Vehicle = ObstacleListsToAdd[PairIndex].Key;
+
 			FMassTrafficObstacleListFragment NewObstacleListFragment;
-			NewObstacleListFragment.Obstacles = VehicleToObstacles.Value;
-			Context.Defer().PushCommand<FMassCommandAddFragmentInstances>(VehicleToObstacles.Key, NewObstacleListFragment);
+			for (; PairIndex < ObstacleListsToAdd.Num() && ObstacleListsToAdd[PairIndex].Key == Vehicle; ++PairIndex)
+			{
+				NewObstacleListFragment.Obstacles.Add(ObstacleListsToAdd[PairIndex].Value);
+			}
+
+			Context.Defer().PushCommand<FMassCommandAddFragmentInstances>(Vehicle, NewObstacleListFragment);
 		}
 	}
 }
\ No newline at end of file
@@ -138,6 +138,7 @@ void UMassTrafficInitTrafficVehiclesProcessor::Execute(FMassEntityManager& Entit
 			// Consume available space on the assigned lane
 			const float SpaceTakenByVehicleOnLane = GetSpaceTakenByVehicleOnLane(SimulationParams.HalfLength, RandomFractionFragment.RandomFraction, MassTrafficSettings->MinimumDistanceToNextVehicleRange);
 			TrafficLaneData.AddVehicleOccupancy(SpaceTakenByVehicleOnLane);
+			TrafficLaneData.Vehicles.Add(QueryContext.GetEntity(Index), LaneLocationFragment.DistanceAlongLane, VehicleControlFragment.Speed, SpaceTakenByVehicleOnLane);
 
 			// Init TransformFragment
 			TransformFragment.GetMutableTransform().SetRotation(FRotationMatrix::MakeFromX(LaneLocation.Direction).ToQuat());
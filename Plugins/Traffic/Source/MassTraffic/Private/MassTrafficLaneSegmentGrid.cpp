@@ -0,0 +1,192 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MassTrafficLaneSegmentGrid.h"
+#include "MassTrafficTypes.h"
+
+#include "ZoneGraphTypes.h"
+
+namespace UE::MassTraffic
+{
+	// Cell size is doubled until the grid fits, so huge zone graphs don't allocate huge cell arrays
+	static constexpr int64 MaxLaneSegmentGridCells = 1 << 22;
+}
+
+void FMassTrafficLaneSegmentGrid::Reset()
+{
+	DataHandle.Reset();
+	Origin = FVector2D::ZeroVector;
+	CellSize = 0.0f;
+	NumCells = FIntPoint::ZeroValue;
+	Segments.Reset();
+	CellSegmentsBegin.Reset();
+	CellSegmentIndices.Reset();
+}
+
+void FMassTrafficLaneSegmentGrid::Build(const FZoneGraphStorage& Storage, TConstArrayView<FZoneGraphTrafficLaneData> TrafficLanes, float InCellSize)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(TEXT("MassTraffic BuildLaneSegmentGrid"))
+
+	Reset();
+
+	DataHandle = Storage.DataHandle;
+	CellSize = FMath::Max(InCellSize, 1.0f);
+
+	// Gather segments
+	FBox2D Bounds(ForceInit);
+	for (const FZoneGraphTrafficLaneData& TrafficLaneData : TrafficLanes)
+	{
+		const int32 LaneIndex = TrafficLaneData.LaneHandle.Index;
+		const FZoneLaneData& LaneData = Storage.Lanes[LaneIndex];
+
+		for (int32 PointIndex = LaneData.PointsBegin; PointIndex < LaneData.PointsEnd - 1; ++PointIndex)
+		{
+			FSegment& Segment = Segments.AddDefaulted_GetRef();
+			Segment.Start = Storage.LanePoints[PointIndex];
+			Segment.End = Storage.LanePoints[PointIndex + 1];
+			Segment.StartDistanceAlongLane = Storage.LanePointProgressions[PointIndex];
+			Segment.LaneIndex = LaneIndex;
+
+			Bounds += FVector2D(Segment.Start);
+			Bounds += FVector2D(Segment.End);
+		}
+	}
+
+	if (Segments.IsEmpty())
+	{
+		return;
+	}
+
+	// Size the grid to the segment bounds
+	Origin = Bounds.Min;
+	const FVector2D Size = Bounds.GetSize();
+	do
+	{
+		NumCells.X = FMath::FloorToInt32(Size.X / CellSize) + 1;
+		NumCells.Y = FMath::FloorToInt32(Size.Y / CellSize) + 1;
+		if ((int64)NumCells.X * (int64)NumCells.Y <= UE::MassTraffic::MaxLaneSegmentGridCells)
+		{
+			break;
+		}
+		CellSize *= 2.0f;
+	}
+	while (true);
+
+	// Bucket segments into every cell their bounds overlap, counting first so the cells can be stored as ranges
+	// into a single array
+	const int32 TotalNumCells = NumCells.X * NumCells.Y;
+	CellSegmentsBegin.SetNumZeroed(TotalNumCells + 1);
+
+	auto ForEachSegmentCell = [this](const FSegment& Segment, auto&& Function)
+	{
+		const FIntPoint MinCell = GetCell(Segment.Start.ComponentMin(Segment.End));
+		const FIntPoint MaxCell = GetCell(Segment.Start.ComponentMax(Segment.End));
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+			{
+				Function(X + Y * NumCells.X);
+			}
+		}
+	};
+
+	for (const FSegment& Segment : Segments)
+	{
+		ForEachSegmentCell(Segment, [this](const int32 Cell)
+		{
+			++CellSegmentsBegin[Cell + 1];
+		});
+	}
+
+	for (int32 Cell = 0; Cell < TotalNumCells; ++Cell)
+	{
+		CellSegmentsBegin[Cell + 1] += CellSegmentsBegin[Cell];
+	}
+
+	CellSegmentIndices.SetNumUninitialized(CellSegmentsBegin[TotalNumCells]);
+
+	TArray<int32> CellFill(CellSegmentsBegin.GetData(), TotalNumCells);
+	for (int32 SegmentIndex = 0; SegmentIndex < Segments.Num(); ++SegmentIndex)
+	{
+		ForEachSegmentCell(Segments[SegmentIndex], [this, &CellFill, SegmentIndex](const int32 Cell)
+		{
+			CellSegmentIndices[CellFill[Cell]++] = SegmentIndex;
+		});
+	}
+}
+
+void FMassTrafficLaneSegmentGrid::FindNearestLocationsOnLanes(const FBox& SearchBounds, TArray<FLaneLocation>& OutLocations) const
+{
+	if (Segments.IsEmpty())
+	{
+		return;
+	}
+
+	// Nothing to find outside of the grid
+	const FVector2D GridMax = Origin + FVector2D(NumCells) * CellSize;
+	if (SearchBounds.Max.X < Origin.X || SearchBounds.Max.Y < Origin.Y || SearchBounds.Min.X > GridMax.X || SearchBounds.Min.Y > GridMax.Y)
+	{
+		return;
+	}
+
+	const FVector SearchCenter = SearchBounds.GetCenter();
+	const int32 FirstLocationIndex = OutLocations.Num();
+
+	const FIntPoint MinCell = GetCell(SearchBounds.Min);
+	const FIntPoint MaxCell = GetCell(SearchBounds.Max);
+	for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+	{
+		for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+		{
+			const int32 Cell = X + Y * NumCells.X;
+			for (int32 Index = CellSegmentsBegin[Cell]; Index < CellSegmentsBegin[Cell + 1]; ++Index)
+			{
+				const FSegment& Segment = Segments[CellSegmentIndices[Index]];
+
+				// Same test FindNearestLocationOnLane uses to pick the segments to consider
+				if (!FMath::LineBoxIntersection(SearchBounds, Segment.Start, Segment.End, Segment.End - Segment.Start))
+				{
+					continue;
+				}
+
+				const FVector ClosestPoint = FMath::ClosestPointOnSegment(SearchCenter, Segment.Start, Segment.End);
+				const float DistanceSqr = FVector::DistSquared(SearchCenter, ClosestPoint);
+
+				// Segments of the same lane usually share cells, look for the lane from the most recent locations
+				int32 LocationIndex = OutLocations.Num() - 1;
+				for (; LocationIndex >= FirstLocationIndex; --LocationIndex)
+				{
+					if (OutLocations[LocationIndex].LaneHandle.Index == Segment.LaneIndex)
+					{
+						break;
+					}
+				}
+
+				FLaneLocation* Location = nullptr;
+				if (LocationIndex >= FirstLocationIndex)
+				{
+					Location = &OutLocations[LocationIndex];
+					if (DistanceSqr >= Location->DistanceSqr)
+					{
+						continue;
+					}
+				}
+				else
+				{
+					Location = &OutLocations.AddDefaulted_GetRef();
+					Location->LaneHandle = FZoneGraphLaneHandle(Segment.LaneIndex, DataHandle);
+				}
+
+				Location->Position = ClosestPoint;
+				Location->DistanceAlongLane = Segment.StartDistanceAlongLane + FVector::Dist(Segment.Start, ClosestPoint);
+				Location->DistanceSqr = DistanceSqr;
+			}
+		}
+	}
+}
+
+FIntPoint FMassTrafficLaneSegmentGrid::GetCell(const FVector& Location) const
+{
+	return FIntPoint(
+		FMath::Clamp(FMath::FloorToInt32((Location.X - Origin.X) / CellSize), 0, NumCells.X - 1),
+		FMath::Clamp(FMath::FloorToInt32((Location.Y - Origin.Y) / CellSize), 0, NumCells.Y - 1));
+}
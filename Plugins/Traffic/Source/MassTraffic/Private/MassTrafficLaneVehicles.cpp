@@ -0,0 +1,127 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MassTrafficLaneVehicles.h"
+
+#include "Algo/LowerBound.h"
+#include "Algo/UpperBound.h"
+
+void FMassTrafficLaneVehicles::Reset()
+{
+	Entities.Reset();
+	DistancesAlongLane.Reset();
+	Speeds.Reset();
+	SpacesTaken.Reset();
+}
+
+void FMassTrafficLaneVehicles::Add(const FMassEntityHandle Entity, const float DistanceAlongLane, const float Speed, const float SpaceTaken)
+{
+	// A vehicle should only ever be on a lane once, drop any stale entry first
+	Remove(Entity);
+
+	const int32 Index = FindFirstAhead(DistanceAlongLane);
+	Entities.Insert(Entity, Index);
+	DistancesAlongLane.Insert(DistanceAlongLane, Index);
+	Speeds.Insert(Speed, Index);
+	SpacesTaken.Insert(SpaceTaken, Index);
+}
+
+bool FMassTrafficLaneVehicles::Remove(const FMassEntityHandle Entity)
+{
+	const int32 Index = IndexOf(Entity);
+	if (Index == INDEX_NONE)
+	{
+		return false;
+	}
+
+	RemoveAt(Index);
+	return true;
+}
+
+void FMassTrafficLaneVehicles::FindIndices(TConstArrayView<FMassEntityHandle> InEntities, TArrayView<int32> OutIndices) const
+{
+	check(InEntities.Num() == OutIndices.Num());
+
+	if (InEntities.Num() == 1)
+	{
+		OutIndices[0] = IndexOf(InEntities[0]);
+		return;
+	}
+
+	TMap<FMassEntityHandle, int32, TInlineSetAllocator<32>> PendingEntities;
+	PendingEntities.Reserve(InEntities.Num());
+	for (int32 Index = 0; Index < InEntities.Num(); ++Index)
+	{
+		PendingEntities.Add(InEntities[Index], Index);
+		OutIndices[Index] = INDEX_NONE;
+	}
+
+	for (int32 Index = 0; Index < Entities.Num() && !PendingEntities.IsEmpty(); ++Index)
+	{
+		int32 EntityIndex;
+		if (PendingEntities.RemoveAndCopyValue(Entities[Index], EntityIndex))
+		{
+			OutIndices[EntityIndex] = Index;
+		}
+	}
+}
+
+void FMassTrafficLaneVehicles::RemoveAt(const int32 Index)
+{
+	Entities.RemoveAt(Index, 1, EAllowShrinking::No);
+	DistancesAlongLane.RemoveAt(Index, 1, EAllowShrinking::No);
+	Speeds.RemoveAt(Index, 1, EAllowShrinking::No);
+	SpacesTaken.RemoveAt(Index, 1, EAllowShrinking::No);
+}
+
+void FMassTrafficLaneVehicles::RestoreOrder()
+{
+	// Insertion sort, stable and linear when the vehicles are still in order
+	for (int32 Index = 1; Index < Entities.Num(); ++Index)
+	{
+		const float DistanceAlongLane = DistancesAlongLane[Index];
+		if (DistancesAlongLane[Index - 1] <= DistanceAlongLane)
+		{
+			continue;
+		}
+
+		const FMassEntityHandle Entity = Entities[Index];
+		const float Speed = Speeds[Index];
+		const float SpaceTaken = SpacesTaken[Index];
+
+		int32 InsertIndex = Index;
+		while (InsertIndex > 0 && DistancesAlongLane[InsertIndex - 1] > DistanceAlongLane)
+		{
+			Entities[InsertIndex] = Entities[InsertIndex - 1];
+			DistancesAlongLane[InsertIndex] = DistancesAlongLane[InsertIndex - 1];
+			Speeds[InsertIndex] = Speeds[InsertIndex - 1];
+			SpacesTaken[InsertIndex] = SpacesTaken[InsertIndex - 1];
+			--InsertIndex;
+		}
+
+		Entities[InsertIndex] = Entity;
+		DistancesAlongLane[InsertIndex] = DistanceAlongLane;
+		Speeds[InsertIndex] = Speed;
+		SpacesTaken[InsertIndex] = SpaceTaken;
+	}
+}
+
+int32 FMassTrafficLaneVehicles::FindFirstAhead(const float DistanceAlongLane) const
+{
+	return Algo::UpperBound(DistancesAlongLane, DistanceAlongLane);
+}
+
+int32 FMassTrafficLaneVehicles::FindFirstAtOrAhead(const float DistanceAlongLane) const
+{
+	return Algo::LowerBound(DistancesAlongLane, DistanceAlongLane);
+}
+
+float FMassTrafficLaneVehicles::GetSpaceTaken() const
+{
+	float SpaceTaken = 0.0f;
+	for (const float VehicleSpaceTaken : SpacesTaken)
+	{
+		SpaceTaken += VehicleSpaceTaken;
+	}
+
+	return SpaceTaken;
+}
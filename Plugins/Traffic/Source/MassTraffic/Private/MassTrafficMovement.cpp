@@ -7,6 +7,7 @@
 #include "MassTrafficFragments.h"
 #include "MassTrafficLaneChange.h"
 
+#include "MassCommandBuffer.h"
 #include "MassEntityView.h"
 #include "MassZoneGraphNavigationFragments.h"
 
@@ -248,6 +249,8 @@ void MoveVehicleToNextLane(
 	// Get space taken up by this vehicle to add back to current lane space available and consume from next lane    
 	const float SpaceTakenByVehicleOnLane = GetSpaceTakenByVehicleOnLane(AgentRadiusFragment.Radius, RandomFractionFragment.RandomFraction, MassTrafficSettings->MinimumDistanceToNextVehicleRange);
 	
+	CurrentLane.Vehicles.Remove(VehicleEntity);
+
 	// Reset the tail vehicle if it was us.
 	if (CurrentLane.TailVehicle == VehicleEntity)
 	{
@@ -367,6 +370,7 @@ void MoveVehicleToNextLane(
 	// NOTE - Don't do this if the vehicle has already done it preemptively. This happens if the vehicle on the
 	// previous lane decided it can't stop. (See all CANTSTOPLANEEXIT.)
 	NewCurrentLane.AddVehicleOccupancy(SpaceTakenByVehicleOnLane);
+	NewCurrentLane.Vehicles.Add(VehicleEntity, LaneLocationFragment.DistanceAlongLane, VehicleControlFragment.Speed, SpaceTakenByVehicleOnLane);
 
 
 	// Vehicle is on a new lane. Clear the can't stop flag. (See all CANTSTOPLANEEXIT.)
@@ -794,8 +798,10 @@ bool TeleportVehicleToAnotherLane(
 		const float SpaceTakenByVehicle_Current = GetSpaceTakenByVehicleOnLane(RadiusFragment_Current.Radius, RandomFractionFragment_Current.RandomFraction, MassTrafficSettings.MinimumDistanceToNextVehicleRange);
 
 		TrafficLaneData_Current.RemoveVehicleOccupancy(SpaceTakenByVehicle_Current);
+		TrafficLaneData_Current.Vehicles.Remove(Entity_Current);
 
 		Lane_Chosen.AddVehicleOccupancy(SpaceTakenByVehicle_Current);
+		Lane_Chosen.Vehicles.Add(Entity_Current, DistanceAlongLane_Chosen, VehicleControlFragment_Current.Speed, SpaceTakenByVehicle_Current);
 	}
 
 
@@ -857,4 +863,13 @@ bool TeleportVehicleToAnotherLane(
 	return true;
 }
 
+void DeferRemoveVehicleFromLane(FMassCommandBuffer& CommandBuffer, const FMassEntityHandle VehicleEntity, FZoneGraphTrafficLaneData& TrafficLaneData)
+{
+	// Lane data lives as long as the zone graph data it was built for, which outlives the frame's commands
+	CommandBuffer.PushCommand<FMassDeferredSetCommand>([VehicleEntity, &TrafficLaneData](FMassEntityManager&)
+	{
+		TrafficLaneData.Vehicles.Remove(VehicleEntity);
+	});
+}
+
 }
@@ -7,6 +7,9 @@
 #include "MassRepresentationProcessor.h"
 #include "MassSimulationLOD.h"
 #include "MassTrafficFragments.h"
+#include "MassTrafficMovement.h"
+#include "MassTrafficSubsystem.h"
+#include "MassZoneGraphNavigationFragments.h"
 #include "MassRepresentationSubsystem.h"
 #include "MassRepresentationActorManagement.h"
 #include "Kismet/GameplayStatics.h"
@@ -25,6 +28,7 @@ void UMassTrafficRecycleVehiclesOverlappingPlayersProcessor::ConfigureQueries()
 	EntityQuery.AddRequirement<FMassActorFragment>(EMassFragmentAccess::ReadWrite);
 	EntityQuery.AddRequirement<FMassRepresentationLODFragment>(EMassFragmentAccess::ReadWrite);
 	EntityQuery.AddRequirement<FMassRepresentationFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FMassZoneGraphLaneLocationFragment>(EMassFragmentAccess::ReadOnly, EMassFragmentPresence::Optional);
 
 	EntityQuery.AddTagRequirement<FMassTrafficVehicleTag>(EMassFragmentPresence::Any);
 	EntityQuery.AddTagRequirement<FMassTrafficParkedVehicleTag>(EMassFragmentPresence::Any);
@@ -40,6 +44,8 @@ void UMassTrafficRecycleVehiclesOverlappingPlayersProcessor::Execute(FMassEntity
 		return;
 	}
 
+	UMassTrafficSubsystem* MassTrafficSubsystem = UWorld::GetSubsystem<UMassTrafficSubsystem>(World);
+
 	// Get all the player viewpoints. We'll use that as the player locations to make sure
 	// we're not overlapping. Most likely 1 player.
 	TArray<FVector, TInlineAllocator< 1 > > PlayerLocations;
@@ -58,13 +64,14 @@ void UMassTrafficRecycleVehiclesOverlappingPlayersProcessor::Execute(FMassEntity
 	}
 
 	EntityQuery.ForEachEntityChunk(EntityManager, Context,
-		[&PlayerLocations, &MassRepresentationSubsystem](FMassExecutionContext& Context)
+		[&PlayerLocations, &MassRepresentationSubsystem, MassTrafficSubsystem](FMassExecutionContext& Context)
 	{
 		const TConstArrayView<FAgentRadiusFragment> RadiusFragments = Context.GetFragmentView<FAgentRadiusFragment>();
 		const TConstArrayView<FTransformFragment> TransformFragments = Context.GetFragmentView<FTransformFragment>();
 		const TArrayView<FMassActorFragment> ActorFragments = Context.GetMutableFragmentView<FMassActorFragment>();
 		const TArrayView<FMassRepresentationLODFragment> RepresentationLODFragments = Context.GetMutableFragmentView<FMassRepresentationLODFragment>();
 		const TArrayView<FMassRepresentationFragment> VisualizationFragments = Context.GetMutableFragmentView<FMassRepresentationFragment>();
+		const TConstArrayView<FMassZoneGraphLaneLocationFragment> LaneLocationFragments = Context.GetFragmentView<FMassZoneGraphLaneLocationFragment>();
 
 		const bool bIsParkedVehicle = Context.DoesArchetypeHaveTag<FMassTrafficParkedVehicleTag>();
 
@@ -102,6 +109,15 @@ void UMassTrafficRecycleVehiclesOverlappingPlayersProcessor::Execute(FMassEntity
 				RepresentationLODFragment.LOD = EMassLOD::Off;
 				RepresentationFragment.CurrentRepresentation = EMassRepresentationType::None;
 
+				// Either way the vehicle leaves its lane
+				if (MassTrafficSubsystem && !LaneLocationFragments.IsEmpty() && LaneLocationFragments[EntityIndex].LaneHandle.IsValid())
+				{
+					if (FZoneGraphTrafficLaneData* TrafficLaneData = MassTrafficSubsystem->GetMutableTrafficLaneData(LaneLocationFragments[EntityIndex].LaneHandle))
+					{
+						UE::MassTraffic::DeferRemoveVehicleFromLane(Context.Defer(), Entity, *TrafficLaneData);
+					}
+				}
+
 				if (bIsParkedVehicle)
 				{
 					// We can safely destroy parked vehicles as they don't have references to other entities.
@@ -0,0 +1,862 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MassTrafficSimulationHarness.h"
+#include "MassTraffic.h"
+#include "MassTrafficChooseNextLaneProcessor.h"
+#include "MassTrafficFieldOperations.h"
+#include "MassTrafficFindNextVehicleProcessor.h"
+#include "MassTrafficFragments.h"
+#include "MassTrafficInitInterpolationProcessor.h"
+#include "MassTrafficInitTrafficVehicleSpeedProcessor.h"
+#include "MassTrafficInitTrafficVehiclesProcessor.h"
+#include "MassTrafficPhysics.h"
+#include "MassTrafficProcessorBase.h"
+#include "MassTrafficSettings.h"
+#include "MassTrafficSubsystem.h"
+#include "MassTrafficUpdateDistanceToNearestObstacleProcessor.h"
+#include "MassTrafficUpdateVelocityProcessor.h"
+#include "MassTrafficVehicleSimulationTrait.h"
+#include "MassTrafficVehicleSpawnDataGenerator.h"
+#include "MassTrafficVehicleVisualizationLODProcessor.h"
+#include "MassTrafficVehicleVisualizationTrait.h"
+
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Hash/CityHash.h"
+#include "MassCommonFragments.h"
+#include "MassEntityConfigAsset.h"
+#include "MassEntityTemplateRegistry.h"
+#include "MassEntityUtils.h"
+#include "MassExecutionContext.h"
+#include "MassExecutor.h"
+#include "MassLODFragments.h"
+#include "MassProcessorDependencySolver.h"
+#include "MassSpawnerSubsystem.h"
+#include "MassZoneGraphNavigationFragments.h"
+#include "Misc/App.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/ScopeExit.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "UObject/Package.h"
+#include "UObject/StrongObjectPtr.h"
+#include "UObject/UObjectIterator.h"
+#include "ZoneGraphData.h"
+
+namespace MassTrafficSimulationHarnessPrivate
+{
+	// Number of tags a FZoneGraphTagMask can hold
+	static constexpr uint8 NumTags = 32;
+
+	// Quaternion components are rounded to this before hashing, about a hundredth of a degree
+	static constexpr double RotationTolerance = 1.0e-4;
+
+	// Vehicle state as hashed by HashState. Every member is 64 bits so the struct has no padding
+	struct FVehicleState
+	{
+		int64 Entity = 0;
+		int64 LaneIndex = 0;
+		int64 LOD = 0;
+		int64 DistanceAlongLane = 0;
+		int64 Speed = 0;
+		int64 Location[3] = {};
+		int64 Rotation[4] = {};
+	};
+
+	static int64 Quantize(const double Value, const double Tolerance)
+	{
+		return FMath::RoundToInt64(Value / Tolerance);
+	}
+
+	static FString HashToString(const uint64 Hash)
+	{
+		return FString::Printf(TEXT("%016llx"), Hash);
+	}
+
+	// Gravity the resting suspension forces of the simple physics template are computed for, in cm/s^2
+	static constexpr float Gravity = 980.0f;
+
+	// Fill in the configs of a mid size car the way UChaosWheeledVehicleMovementComponent would, then set up the sims on them the way
+	// UE::MassTraffic::ExtractPhysicsVehicleConfig does. Lengths are in centimeters, masses in kilograms and the actor sits on the ground
+	static void InitSimplePhysicsTemplate(FMassTrafficSimpleVehiclePhysicsTemplate& OutTemplate)
+	{
+		const FVector BodySize(450.0f, 180.0f, 140.0f);
+		const float WheelBase = 270.0f;
+		const float TrackWidth = 160.0f;
+		const float WheelRadius = 35.0f;
+
+		FMassTrafficSimpleVehiclePhysicsConfig& Config = OutTemplate.SimpleVehiclePhysicsConfig;
+		Config.Mass = 1500.0f;
+		Config.CenterOfMass = FVector(0.0f, 0.0f, 50.0f);
+		Config.RotationOfMass = FQuat::Identity;
+		Config.BodyToActor = FTransform::Identity;
+		Config.NumDrivenWheels = 2;
+
+		// Inertia of a solid box of the body's size
+		const FVector SizeSquared = BodySize * BodySize;
+		const FVector MomentOfInertia = Config.Mass / 12.0f * FVector(SizeSquared.Y + SizeSquared.Z, SizeSquared.X + SizeSquared.Z, SizeSquared.X + SizeSquared.Y);
+		Config.InverseMomentOfInertia = FVector(1.0f) / MomentOfInertia;
+
+		Config.EngineConfig.MaxTorque = 400.0f;
+		Config.EngineConfig.MaxRPM = 6000.0f;
+		Config.EngineConfig.EngineIdleRPM = 900.0f;
+		Config.EngineConfig.EngineBrakeEffect = 0.2f;
+		Config.EngineConfig.EngineRevUpMOI = 5.0f;
+		Config.EngineConfig.EngineRevDownRate = 600.0f;
+		Config.EngineConfig.TorqueCurve.Empty();
+		for (const float Torque : { 0.6f, 0.8f, 0.95f, 1.0f, 0.9f, 0.7f })
+		{
+			Config.EngineConfig.TorqueCurve.AddNormalized(Torque);
+		}
+
+		Config.DifferentialConfig.DifferentialType = Chaos::EDifferentialType::FrontWheelDrive;
+		Config.DifferentialConfig.FrontRearSplit = 0.5f;
+
+		Config.TransmissionConfig.TransmissionType = Chaos::ETransmissionType::Automatic;
+		Config.TransmissionConfig.AutoReverse = true;
+		Config.TransmissionConfig.ForwardRatios = { 4.25f, 2.52f, 1.66f, 1.22f, 1.0f };
+		Config.TransmissionConfig.ReverseRatios = { 4.04f };
+		Config.TransmissionConfig.FinalDriveRatio = 3.08f;
+		Config.TransmissionConfig.ChangeUpRPM = 4500.0f;
+		Config.TransmissionConfig.ChangeDownRPM = 2000.0f;
+		Config.TransmissionConfig.GearChangeTime = 0.4f;
+		Config.TransmissionConfig.TransmissionEfficiency = 0.9f;
+
+		Config.SteeringConfig.TrackWidth = TrackWidth;
+		Config.SteeringConfig.WheelBase = WheelBase;
+		Config.SteeringConfig.SpeedVsSteeringCurve.Empty();
+		Config.SteeringConfig.SpeedVsSteeringCurve.Add(FVector2D(0.0f, 1.0f));
+		Config.SteeringConfig.SpeedVsSteeringCurve.Add(FVector2D(40.0f, 0.7f));
+		Config.SteeringConfig.SpeedVsSteeringCurve.Add(FVector2D(120.0f, 0.6f));
+
+		Config.AerodynamicsConfig.AreaMetresSquared = 2.2f;
+		Config.AerodynamicsConfig.DragCoefficient = 0.3f;
+		Config.AerodynamicsConfig.DownforceCoefficient = 0.1f;
+
+		// Wheels in front left, front right, rear left, rear right order, each axle holding a pair
+		static constexpr int32 NumAxles = 2;
+		static constexpr int32 NumWheels = NumAxles * 2;
+		Config.AxleConfigs.SetNum(NumAxles);
+		Config.WheelConfigs.SetNum(NumWheels);
+		Config.SuspensionConfigs.SetNum(NumWheels);
+
+		// Every wheel carries the same share of the mass, the center of mass being halfway between the axles
+		const float SprungMass = Config.Mass / NumWheels;
+		const float SpringRate = 25000.0f;
+
+		FMassTrafficSimpleVehiclePhysicsSim& Sim = OutTemplate.SimpleVehiclePhysicsFragmentTemplate.VehicleSim;
+		Sim = FMassTrafficSimpleVehiclePhysicsSim(&Config, &Config.EngineConfig, &Config.DifferentialConfig, &Config.TransmissionConfig,
+			&Config.SteeringConfig, &Config.AerodynamicsConfig);
+
+		for (int32 AxleIndex = 0; AxleIndex < NumAxles; ++AxleIndex)
+		{
+			const bool bFront = AxleIndex == 0;
+
+			Chaos::FAxleConfig& AxleConfig = Config.AxleConfigs[AxleIndex];
+			AxleConfig.WheelIndex = { (uint16)(AxleIndex * 2), (uint16)(AxleIndex * 2 + 1) };
+			AxleConfig.RollbarScaling = 0.15f;
+
+			Chaos::FAxleSim& AxleSim = Sim.AxleSims.AddDefaulted_GetRef();
+			AxleSim.Setup = AxleConfig;
+			AxleSim.SetupPtr = &AxleConfig;
+
+			for (int32 Side = 0; Side < 2; ++Side)
+			{
+				const int32 WheelIndex = AxleIndex * 2 + Side;
+
+				Chaos::FSimpleWheelConfig& WheelConfig = Config.WheelConfigs[WheelIndex];
+				WheelConfig.AxleType = bFront ? Chaos::FSimpleWheelConfig::EAxleType::Front : Chaos::FSimpleWheelConfig::EAxleType::Rear;
+				WheelConfig.WheelMass = 20.0f;
+				WheelConfig.WheelRadius = WheelRadius;
+				WheelConfig.WheelWidth = 20.0f;
+				WheelConfig.MaxSteeringAngle = bFront ? 40.0f : 0.0f;
+				WheelConfig.MaxBrakeTorque = 1500.0f;
+				WheelConfig.HandbrakeTorque = bFront ? 0.0f : 3000.0f;
+				WheelConfig.SteeringEnabled = bFront;
+				WheelConfig.EngineEnabled = bFront;
+				WheelConfig.BrakeEnabled = true;
+				WheelConfig.HandbrakeEnabled = !bFront;
+
+				Chaos::FSimpleSuspensionConfig& SuspensionConfig = Config.SuspensionConfigs[WheelIndex];
+				SuspensionConfig.SuspensionMaxRaise = 10.0f;
+				SuspensionConfig.SuspensionMaxDrop = 10.0f;
+				SuspensionConfig.SpringRate = SpringRate;
+				SuspensionConfig.SpringPreload = 0.0f;
+				SuspensionConfig.RestingForce = SprungMass * Gravity;
+
+				// Half of critical damping
+				SuspensionConfig.CompressionDamping = FMath::Sqrt(SpringRate * SprungMass);
+				SuspensionConfig.ReboundDamping = SuspensionConfig.CompressionDamping;
+
+				// Same margin as UE::MassTraffic::ExtractPhysicsVehicleConfig
+				SuspensionConfig.RaycastSafetyMargin = 1000.0f;
+
+				Sim.WheelSims.Emplace(&WheelConfig);
+
+				const FVector WheelLocalLocation((bFront ? 0.5f : -0.5f) * WheelBase, (Side == 0 ? -0.5f : 0.5f) * TrackWidth, WheelRadius);
+				Chaos::FSimpleSuspensionSim& SuspensionSim = Sim.SuspensionSims.Emplace_GetRef(&SuspensionConfig);
+				SuspensionSim.SetLocalRestingPosition(WheelLocalLocation);
+				Sim.WheelLocalLocations.Add(WheelLocalLocation);
+
+				Config.MaxSteeringAngle = FMath::Max(Config.MaxSteeringAngle, FMath::DegreesToRadians(WheelConfig.MaxSteeringAngle));
+			}
+		}
+	}
+
+	// Vehicle config used when none are given, the built-in traffic traits without meshes
+	static UMassEntityConfigAsset* MakeDefaultVehicleConfig(const bool bSimplePhysics)
+	{
+		UMassEntityConfigAsset* VehicleConfig = NewObject<UMassEntityConfigAsset>(GetTransientPackage());
+
+		UMassTrafficVehicleSimulationTrait* SimulationTrait = NewObject<UMassTrafficVehicleSimulationTrait>(VehicleConfig);
+		SimulationTrait->Params.HalfLength = 250.0f;
+		SimulationTrait->Params.HalfWidth = 100.0f;
+
+		VehicleConfig->GetMutableConfig().AddTrait(*SimulationTrait);
+		VehicleConfig->GetMutableConfig().AddTrait(*NewObject<UMassTrafficVehicleVisualizationTrait>(VehicleConfig));
+
+		UMassTrafficSimulationHarnessTrait* HarnessTrait = NewObject<UMassTrafficSimulationHarnessTrait>(VehicleConfig);
+		HarnessTrait->bSimplePhysics = bSimplePhysics;
+		VehicleConfig->GetMutableConfig().AddTrait(*HarnessTrait);
+
+		return VehicleConfig;
+	}
+
+	static UMassProcessor* MakeProcessor(UWorld& World, UClass* ProcessorClass, UObject& Owner, const int32 Seed)
+	{
+		UMassProcessor* Processor = NewObject<UMassProcessor>(&World, ProcessorClass);
+		Processor->CallInitialize(&Owner);
+
+		if (UMassTrafficProcessorBase* TrafficProcessor = Cast<UMassTrafficProcessorBase>(Processor))
+		{
+			TrafficProcessor->SetRandomSeed(Seed);
+		}
+
+		return Processor;
+	}
+
+	// Every processor of the MassTraffic module that registers with the processing phases, sorted by name so the dependency solver
+	// always sees them in the same order
+	static TArray<UClass*> FindTrafficProcessorClasses(const EProcessorExecutionFlags ExecutionFlags)
+	{
+		const UPackage* MassTrafficPackage = UMassTrafficProcessorBase::StaticClass()->GetOutermost();
+
+		TArray<UClass*> ProcessorClasses;
+		for (TObjectIterator<UClass> ClassIt; ClassIt; ++ClassIt)
+		{
+			UClass* Class = *ClassIt;
+			if (!Class->IsChildOf(UMassProcessor::StaticClass())
+				|| Class->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated | CLASS_NewerVersionExists)
+				|| Class->GetOutermost() != MassTrafficPackage)
+			{
+				continue;
+			}
+
+			const UMassProcessor* ProcessorCDO = GetDefault<UMassProcessor>(Class);
+			if (ProcessorCDO->ShouldAutoAddToGlobalList() && ProcessorCDO->ShouldExecute(ExecutionFlags))
+			{
+				ProcessorClasses.Add(Class);
+			}
+		}
+
+		ProcessorClasses.Sort([](const UClass& A, const UClass& B)
+		{
+			return A.GetName() < B.GetName();
+		});
+
+		return ProcessorClasses;
+	}
+
+	// Order processors the way the processing phases would, phase by phase
+	static TArray<UMassProcessor*> SortProcessors(TConstArrayView<UMassProcessor*> Processors)
+	{
+		TArray<UMassProcessor*> SortedProcessors;
+		for (int32 Phase = 0; Phase < (int32)EMassProcessingPhase::MAX; ++Phase)
+		{
+			TArray<UMassProcessor*> PhaseProcessors;
+			for (UMassProcessor* Processor : Processors)
+			{
+				if (Processor->GetProcessingPhase() == (EMassProcessingPhase)Phase)
+				{
+					PhaseProcessors.Add(Processor);
+				}
+			}
+
+			if (PhaseProcessors.IsEmpty())
+			{
+				continue;
+			}
+
+			TArray<FMassProcessorOrderInfo> OrderInfos;
+			FMassProcessorDependencySolver Solver(PhaseProcessors);
+			Solver.ResolveDependencies(OrderInfos);
+
+			for (const FMassProcessorOrderInfo& OrderInfo : OrderInfos)
+			{
+				if (OrderInfo.NodeType == FMassProcessorOrderInfo::EDependencyNodeType::Processor)
+				{
+					SortedProcessors.Add(OrderInfo.Processor);
+				}
+			}
+		}
+
+		return SortedProcessors;
+	}
+
+	// Without a player controller there are no LOD viewers, so the harness stands in for one once the LOD collector has run
+	static void UpdateViewerInfo(FMassEntityManager& EntityManager, FMassEntityQuery& ViewerQuery, const FVector& ViewerLocation)
+	{
+		FMassExecutionContext ExecutionContext(EntityManager);
+		ViewerQuery.ForEachEntityChunk(EntityManager, ExecutionContext, [&ViewerLocation](FMassExecutionContext& QueryContext)
+		{
+			const TConstArrayView<FTransformFragment> TransformFragments = QueryContext.GetFragmentView<FTransformFragment>();
+			const TArrayView<FMassViewerInfoFragment> ViewerInfoFragments = QueryContext.GetMutableFragmentView<FMassViewerInfoFragment>();
+
+			for (int32 Index = 0; Index < QueryContext.GetNumEntities(); ++Index)
+			{
+				FMassViewerInfoFragment& ViewerInfoFragment = ViewerInfoFragments[Index];
+				ViewerInfoFragment.ClosestViewerDistanceSq = FVector::DistSquared(ViewerLocation, TransformFragments[Index].GetTransform().GetLocation());
+				ViewerInfoFragment.ClosestDistanceToFrustum = 0.0f;
+			}
+		});
+	}
+}
+
+void UMassTrafficSimulationHarnessTrait::BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const
+{
+	BuildContext.AddFragment<FMassTrafficRandomFractionFragment>();
+	BuildContext.AddFragment<FMassTrafficVehicleLightsFragment>();
+
+	IF_MASSTRAFFIC_ENABLE_DEBUG(BuildContext.AddFragment<FMassTrafficDebugFragment>());
+
+	if (bSimplePhysics)
+	{
+		FMassEntityManager& EntityManager = UE::Mass::Utils::GetEntityManagerChecked(World);
+
+		const FMassTrafficSimpleVehiclePhysicsTemplate& Template = FMassTrafficSimulationHarness::GetSimplePhysicsTemplate();
+		const uint32 TemplateHash = UE::StructUtils::GetStructCrc32(FConstStructView::Make(Template));
+		const FConstSharedStruct PhysicsSharedFragment = EntityManager.GetOrCreateConstSharedFragmentByHash<FMassTrafficVehiclePhysicsSharedParameters>(TemplateHash, &Template);
+		BuildContext.AddConstSharedFragment(PhysicsSharedFragment);
+	}
+}
+
+const FMassTrafficSimpleVehiclePhysicsTemplate& FMassTrafficSimulationHarness::GetSimplePhysicsTemplate()
+{
+	static FMassTrafficSimpleVehiclePhysicsTemplate Template;
+	static bool bInitialized = false;
+	if (!bInitialized)
+	{
+		MassTrafficSimulationHarnessPrivate::InitSimplePhysicsTemplate(Template);
+		bInitialized = true;
+	}
+
+	return Template;
+}
+
+void FMassTrafficSimulationHarness::MakeSyntheticLanes(const FSettings& Settings, const FZoneGraphTagMask LaneTags, FZoneGraphStorage& OutStorage)
+{
+	const int32 NumSegments = FMath::Max(Settings.NumSegmentsPerRoad, 3);
+	const int32 NumLanes = FMath::Max(Settings.NumLanesPerRoad, 1);
+	const float RoadWidth = NumLanes * Settings.LaneWidth;
+	const float OuterRadius = Settings.RoadRadius + 0.5f * Settings.LaneWidth;
+	const float InnerRadius = OuterRadius - RoadWidth;
+
+	// Leave two road widths between neighbouring roads
+	const float RoadSpacing = 2.0f * (OuterRadius + RoadWidth);
+	const float GridOffset = 0.5f * (Settings.NumRoadsPerAxis - 1) * RoadSpacing;
+
+	OutStorage.Bounds.Init();
+
+	for (int32 RoadY = 0; RoadY < Settings.NumRoadsPerAxis; ++RoadY)
+	{
+		for (int32 RoadX = 0; RoadX < Settings.NumRoadsPerAxis; ++RoadX)
+		{
+			const FVector Center(RoadX * RoadSpacing - GridOffset, RoadY * RoadSpacing - GridOffset, 0.0f);
+			const int32 FirstLaneIndex = OutStorage.Lanes.Num();
+
+			auto GetLaneIndex = [FirstLaneIndex, NumSegments, NumLanes](const int32 Segment, const int32 Lane)
+			{
+				return FirstLaneIndex + ((Segment + NumSegments) % NumSegments) * NumLanes + Lane;
+			};
+
+			auto GetRingPoint = [&Center, NumSegments](const int32 Segment, const float Radius)
+			{
+				const float Angle = UE_TWO_PI * Segment / NumSegments;
+				return Center + FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.0f);
+			};
+
+			for (int32 Segment = 0; Segment < NumSegments; ++Segment)
+			{
+				FZoneData& Zone = OutStorage.Zones.AddDefaulted_GetRef();
+				Zone.Tags = LaneTags;
+				Zone.Bounds.Init();
+
+				Zone.BoundaryPointsBegin = OutStorage.BoundaryPoints.Num();
+				OutStorage.BoundaryPoints.Add(GetRingPoint(Segment, OuterRadius));
+				OutStorage.BoundaryPoints.Add(GetRingPoint(Segment + 1, OuterRadius));
+				OutStorage.BoundaryPoints.Add(GetRingPoint(Segment + 1, InnerRadius));
+				OutStorage.BoundaryPoints.Add(GetRingPoint(Segment, InnerRadius));
+				Zone.BoundaryPointsEnd = OutStorage.BoundaryPoints.Num();
+
+				for (int32 PointIndex = Zone.BoundaryPointsBegin; PointIndex < Zone.BoundaryPointsEnd; ++PointIndex)
+				{
+					Zone.Bounds += OutStorage.BoundaryPoints[PointIndex];
+				}
+
+				Zone.LanesBegin = OutStorage.Lanes.Num();
+				for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+				{
+					const float Radius = Settings.RoadRadius - Lane * Settings.LaneWidth;
+					const FVector Start = GetRingPoint(Segment, Radius);
+					const FVector End = GetRingPoint(Segment + 1, Radius);
+					const FVector Tangent = (End - Start).GetSafeNormal();
+
+					FZoneLaneData& LaneData = OutStorage.Lanes.AddDefaulted_GetRef();
+					LaneData.ZoneIndex = OutStorage.Zones.Num() - 1;
+					LaneData.Width = Settings.LaneWidth;
+					LaneData.Tags = LaneTags;
+
+					// Lanes meet the next segment where its lane starts, so that lane's index identifies the entry
+					LaneData.StartEntryId = GetLaneIndex(Segment, Lane);
+					LaneData.EndEntryId = GetLaneIndex(Segment + 1, Lane);
+
+					LaneData.PointsBegin = OutStorage.LanePoints.Num();
+					OutStorage.LanePoints.Add(Start);
+					OutStorage.LanePoints.Add(End);
+					OutStorage.LaneTangentVectors.Add(Tangent);
+					OutStorage.LaneTangentVectors.Add(Tangent);
+					OutStorage.LaneUpVectors.Add(FVector::UpVector);
+					OutStorage.LaneUpVectors.Add(FVector::UpVector);
+					OutStorage.LanePointProgressions.Add(0.0f);
+					OutStorage.LanePointProgressions.Add(FVector::Dist(Start, End));
+					LaneData.PointsEnd = OutStorage.LanePoints.Num();
+
+					LaneData.LinksBegin = OutStorage.LaneLinks.Num();
+					OutStorage.LaneLinks.Emplace(GetLaneIndex(Segment + 1, Lane), EZoneLaneLinkType::Outgoing, EZoneLaneLinkFlags::None);
+					OutStorage.LaneLinks.Emplace(GetLaneIndex(Segment - 1, Lane), EZoneLaneLinkType::Incoming, EZoneLaneLinkFlags::None);
+
+					// Traffic drives counterclockwise, so lanes further in are on the right
+					if (Lane > 0)
+					{
+						OutStorage.LaneLinks.Emplace(GetLaneIndex(Segment, Lane - 1), EZoneLaneLinkType::Adjacent, EZoneLaneLinkFlags::Left);
+					}
+					if (Lane < NumLanes - 1)
+					{
+						OutStorage.LaneLinks.Emplace(GetLaneIndex(Segment, Lane + 1), EZoneLaneLinkType::Adjacent, EZoneLaneLinkFlags::Right);
+					}
+					LaneData.LinksEnd = OutStorage.LaneLinks.Num();
+				}
+				Zone.LanesEnd = OutStorage.Lanes.Num();
+
+				OutStorage.Bounds += Zone.Bounds;
+			}
+		}
+	}
+
+	OutStorage.ZoneBVTree.Build(MakeConstStridedView(OutStorage.Zones, &FZoneData::Bounds));
+}
+
+FZoneGraphTagMask FMassTrafficSimulationHarness::FindTrafficLaneTags(const UMassTrafficSettings& TrafficSettings)
+{
+	using namespace MassTrafficSimulationHarnessPrivate;
+
+	auto IsTrafficLane = [&TrafficSettings](const FZoneGraphTagMask Tags)
+	{
+		return TrafficSettings.TrafficLaneFilter.Pass(Tags) && !TrafficSettings.IntersectionLaneFilter.Pass(Tags);
+	};
+
+	const FZoneGraphTagMask RequiredTags = TrafficSettings.TrafficLaneFilter.AllTags;
+	if (IsTrafficLane(RequiredTags))
+	{
+		return RequiredTags;
+	}
+
+	for (uint8 Bit = 0; Bit < NumTags; ++Bit)
+	{
+		FZoneGraphTagMask Tags = RequiredTags;
+		Tags.Add(FZoneGraphTag(Bit));
+
+		if (IsTrafficLane(Tags))
+		{
+			return Tags;
+		}
+	}
+
+	return FZoneGraphTagMask::None;
+}
+
+uint64 FMassTrafficSimulationHarness::HashState(FMassEntityManager& EntityManager, TConstArrayView<FZoneGraphTrafficLaneData> TrafficLanes, const float Tolerance)
+{
+	using namespace MassTrafficSimulationHarnessPrivate;
+
+	FMassEntityQuery VehicleQuery;
+	VehicleQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadOnly);
+	VehicleQuery.AddRequirement<FMassZoneGraphLaneLocationFragment>(EMassFragmentAccess::ReadOnly);
+	VehicleQuery.AddRequirement<FMassTrafficVehicleControlFragment>(EMassFragmentAccess::ReadOnly);
+	VehicleQuery.AddRequirement<FMassTrafficSimulationLODFragment>(EMassFragmentAccess::ReadOnly);
+
+	TArray<FVehicleState> VehicleStates;
+
+	FMassExecutionContext ExecutionContext(EntityManager);
+	VehicleQuery.ForEachEntityChunk(EntityManager, ExecutionContext, [&VehicleStates, Tolerance](FMassExecutionContext& QueryContext)
+	{
+		const TConstArrayView<FTransformFragment> TransformFragments = QueryContext.GetFragmentView<FTransformFragment>();
+		const TConstArrayView<FMassZoneGraphLaneLocationFragment> LaneLocationFragments = QueryContext.GetFragmentView<FMassZoneGraphLaneLocationFragment>();
+		const TConstArrayView<FMassTrafficVehicleControlFragment> VehicleControlFragments = QueryContext.GetFragmentView<FMassTrafficVehicleControlFragment>();
+		const TConstArrayView<FMassTrafficSimulationLODFragment> SimulationLODFragments = QueryContext.GetFragmentView<FMassTrafficSimulationLODFragment>();
+
+		for (int32 Index = 0; Index < QueryContext.GetNumEntities(); ++Index)
+		{
+			const FMassEntityHandle Entity = QueryContext.GetEntity(Index);
+			const FMassZoneGraphLaneLocationFragment& LaneLocationFragment = LaneLocationFragments[Index];
+			const FVector Location = TransformFragments[Index].GetTransform().GetLocation();
+			const FQuat Rotation = TransformFragments[Index].GetTransform().GetRotation();
+
+			FVehicleState& VehicleState = VehicleStates.AddDefaulted_GetRef();
+			VehicleState.Entity = ((int64)Entity.Index << 32) | (uint32)Entity.SerialNumber;
+			VehicleState.LaneIndex = LaneLocationFragment.LaneHandle.Index;
+			VehicleState.LOD = SimulationLODFragments[Index].LOD;
+			VehicleState.DistanceAlongLane = Quantize(LaneLocationFragment.DistanceAlongLane, Tolerance);
+			VehicleState.Speed = Quantize(VehicleControlFragments[Index].Speed, Tolerance);
+			VehicleState.Location[0] = Quantize(Location.X, Tolerance);
+			VehicleState.Location[1] = Quantize(Location.Y, Tolerance);
+			VehicleState.Location[2] = Quantize(Location.Z, Tolerance);
+			VehicleState.Rotation[0] = Quantize(Rotation.X, RotationTolerance);
+			VehicleState.Rotation[1] = Quantize(Rotation.Y, RotationTolerance);
+			VehicleState.Rotation[2] = Quantize(Rotation.Z, RotationTolerance);
+			VehicleState.Rotation[3] = Quantize(Rotation.W, RotationTolerance);
+		}
+	});
+
+	// Hash vehicles in entity order, which doesn't depend on how they are spread over archetypes and chunks
+	VehicleStates.Sort([](const FVehicleState& A, const FVehicleState& B)
+	{
+		return A.Entity < B.Entity;
+	});
+
+	const uint64 VehiclesHash = CityHash64((const char*)VehicleStates.GetData(), VehicleStates.Num() * sizeof(FVehicleState));
+
+	TArray<int64> LaneStates;
+	LaneStates.Reserve(TrafficLanes.Num() * 2);
+	for (const FZoneGraphTrafficLaneData& TrafficLaneData : TrafficLanes)
+	{
+		LaneStates.Add(TrafficLaneData.Vehicles.Num());
+		LaneStates.Add(Quantize(TrafficLaneData.SpaceAvailable, Tolerance));
+	}
+
+	return CityHash64WithSeed((const char*)LaneStates.GetData(), LaneStates.Num() * sizeof(int64), VehiclesHash);
+}
+
+FMassTrafficSimulationHarness::FRun FMassTrafficSimulationHarness::Run(const FSettings& Settings)
+{
+	using namespace MassTrafficSimulationHarnessPrivate;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(FMassTrafficSimulationHarness::Run);
+
+	FRun Result;
+
+	const UMassTrafficSettings* TrafficSettings = GetDefault<UMassTrafficSettings>();
+	const FZoneGraphTagMask LaneTags = FindTrafficLaneTags(*TrafficSettings);
+	if (LaneTags == FZoneGraphTagMask::None)
+	{
+		UE_LOG(LogMassTraffic, Error, TEXT("No zone graph tags pass the traffic lane filter without passing the intersection lane filter, can't build traffic lanes"));
+		return Result;
+	}
+
+	// A game world that is never ticked, so only the processors run below update the simulation
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, /*bInformEngineOfWorld*/false, MakeUniqueObjectName(GetTransientPackage(), UWorld::StaticClass(), TEXT("MassTrafficSimulationHarness")));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	ON_SCOPE_EXIT
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(/*bInformEngineOfWorld*/false);
+	};
+
+	UMassTrafficSubsystem* TrafficSubsystem = UWorld::GetSubsystem<UMassTrafficSubsystem>(World);
+	UMassSpawnerSubsystem* SpawnerSubsystem = UWorld::GetSubsystem<UMassSpawnerSubsystem>(World);
+	if (!TrafficSubsystem || !SpawnerSubsystem)
+	{
+		UE_LOG(LogMassTraffic, Error, TEXT("The simulation harness world has no traffic or spawner subsystem"));
+		return Result;
+	}
+
+	FMassEntityManager& EntityManager = UE::Mass::Utils::GetEntityManagerChecked(*World);
+
+	// Build the lanes before the actor finishes spawning, spawning registers it with the zone graph subsystem which hands out its data handle
+	AZoneGraphData* ZoneGraphData = World->SpawnActorDeferred<AZoneGraphData>(AZoneGraphData::StaticClass(), FTransform::Identity);
+	MakeSyntheticLanes(Settings, LaneTags, ZoneGraphData->GetStorageMutable());
+	ZoneGraphData->FinishSpawning(FTransform::Identity);
+
+	const FZoneGraphStorage& ZoneGraphStorage = ZoneGraphData->GetStorage();
+	if (!ZoneGraphStorage.DataHandle.IsValid())
+	{
+		UE_LOG(LogMassTraffic, Error, TEXT("The synthetic zone graph data was not registered with the zone graph subsystem"));
+		return Result;
+	}
+
+	// Already done if the traffic subsystem heard about the new data, in which case this is a no-op
+	TrafficSubsystem->RegisterZoneGraphData(ZoneGraphData);
+
+	const FMassTrafficZoneGraphData* TrafficZoneGraphData = TrafficSubsystem->GetTrafficZoneGraphData(ZoneGraphStorage.DataHandle);
+	if (!TrafficZoneGraphData || TrafficZoneGraphData->TrafficLaneDataArray.IsEmpty())
+	{
+		UE_LOG(LogMassTraffic, Error, TEXT("No traffic lanes were built for the synthetic zone graph data"));
+		return Result;
+	}
+	Result.NumLanes = TrafficZoneGraphData->TrafficLaneDataArray.Num();
+
+	TArray<TStrongObjectPtr<UMassEntityConfigAsset>> VehicleConfigs;
+	for (const FSoftObjectPath& VehicleConfigPath : Settings.VehicleConfigs)
+	{
+		UMassEntityConfigAsset* VehicleConfig = Cast<UMassEntityConfigAsset>(VehicleConfigPath.TryLoad());
+		if (!VehicleConfig)
+		{
+			UE_LOG(LogMassTraffic, Error, TEXT("Could not load the vehicle config '%s'"), *VehicleConfigPath.ToString());
+			return Result;
+		}
+
+		VehicleConfigs.Emplace(VehicleConfig);
+	}
+	if (VehicleConfigs.IsEmpty())
+	{
+		VehicleConfigs.Emplace(MakeDefaultVehicleConfig(Settings.bSimplePhysics));
+	}
+
+	// Find spawn locations the way UMassTrafficVehicleSpawnDataGenerator does, from the harness seed
+	const UMassTrafficVehicleSpawnDataGenerator* SpawnDataGenerator = GetDefault<UMassTrafficVehicleSpawnDataGenerator>();
+	const FRandomStream RandomStream(Settings.Seed);
+
+	TArray<FMassTrafficVehicleSpacing> Spacings;
+	FMassTrafficVehicleSpacing& Spacing = Spacings.AddDefaulted_GetRef();
+	Spacing.Space = Settings.VehicleSpace;
+	Spacing.Proportion = 1.0f;
+
+	TArray<TArray<FZoneGraphLaneLocation>> SpawnPointsPerSpacing;
+	UMassTrafficVehicleSpawnDataGenerator::FindNonOverlappingLanePoints(ZoneGraphStorage, TrafficSettings->TrafficLaneFilter, TrafficSettings->LaneDensities, RandomStream,
+		Spacings, SpawnDataGenerator->MinGapBetweenSpaces, SpawnDataGenerator->MaxGapBetweenSpaces, SpawnPointsPerSpacing);
+
+	TArray<FZoneGraphLaneLocation>& SpawnPoints = SpawnPointsPerSpacing[0];
+	SpawnPoints.SetNum(FMath::Min(SpawnPoints.Num(), Settings.NumVehicles));
+
+	// The spawn data and post spawn processors of UMassTrafficVehicleSpawnDataGenerator::Generate, owned by the harness so their random
+	// streams start from its seed
+	UClass* SpawnProcessorClasses[] = {
+		UMassTrafficInitTrafficVehiclesProcessor::StaticClass(),
+		UMassTrafficFindNextVehicleProcessor::StaticClass(),
+		UMassTrafficVisualLoggingFieldOperationProcessor::StaticClass(),
+		UMassTrafficUpdateDistanceToNearestObstacleProcessor::StaticClass(),
+		UMassTrafficChooseNextLaneProcessor::StaticClass(),
+		UMassTrafficInitTrafficVehicleSpeedProcessor::StaticClass(),
+		UMassTrafficInitInterpolationProcessor::StaticClass(),
+		UMassTrafficUpdateVelocityProcessor::StaticClass()
+	};
+
+	TArray<TStrongObjectPtr<UMassProcessor>> SpawnProcessors;
+	for (UClass* ProcessorClass : SpawnProcessorClasses)
+	{
+		SpawnProcessors.Emplace(MakeProcessor(*World, ProcessorClass, *TrafficSubsystem, Settings.Seed));
+	}
+
+	for (int32 ConfigIndex = 0; ConfigIndex < VehicleConfigs.Num(); ++ConfigIndex)
+	{
+		const int32 FirstSpawnPoint = SpawnPoints.Num() * ConfigIndex / VehicleConfigs.Num();
+		const int32 NumToSpawn = SpawnPoints.Num() * (ConfigIndex + 1) / VehicleConfigs.Num() - FirstSpawnPoint;
+		if (NumToSpawn == 0)
+		{
+			continue;
+		}
+
+		const FMassEntityTemplate& EntityTemplate = VehicleConfigs[ConfigIndex]->GetOrCreateEntityTemplate(*World);
+		if (!EntityTemplate.IsValid())
+		{
+			UE_LOG(LogMassTraffic, Error, TEXT("Could not build an entity template from the vehicle config '%s'"), *VehicleConfigs[ConfigIndex]->GetPathName());
+			return Result;
+		}
+
+		TArray<FMassEntityHandle> Entities;
+		SpawnerSubsystem->SpawnEntities(EntityTemplate, NumToSpawn, FConstStructView(), TSubclassOf<UMassProcessor>(), Entities);
+
+		FMassProcessingContext ProcessingContext(EntityManager, /*DeltaSeconds*/0.0f);
+		ProcessingContext.AuxData.InitializeAs<FMassTrafficVehiclesSpawnData>();
+		ProcessingContext.AuxData.GetMutable<FMassTrafficVehiclesSpawnData>().LaneLocations = TArray<FZoneGraphLaneLocation>(SpawnPoints.GetData() + FirstSpawnPoint, NumToSpawn);
+
+		const FMassArchetypeEntityCollection EntityCollection(EntityTemplate.GetArchetype(), Entities, FMassArchetypeEntityCollection::NoDuplicates);
+		for (const TStrongObjectPtr<UMassProcessor>& SpawnProcessor : SpawnProcessors)
+		{
+			UMassProcessor* Processor = SpawnProcessor.Get();
+			UE::Mass::Executor::RunProcessorsView(MakeArrayView(&Processor, 1), ProcessingContext, &EntityCollection);
+		}
+
+		Result.NumVehicles += Entities.Num();
+	}
+
+	TArray<TStrongObjectPtr<UMassProcessor>> ProcessorRefs;
+	TArray<UMassProcessor*> Processors;
+	for (UClass* ProcessorClass : FindTrafficProcessorClasses(UE::Mass::Utils::GetProcessorExecutionFlagsForWorld(*World)))
+	{
+		UMassProcessor* Processor = MakeProcessor(*World, ProcessorClass, *TrafficSubsystem, Settings.Seed);
+		ProcessorRefs.Emplace(Processor);
+		Processors.Add(Processor);
+	}
+	Processors = SortProcessors(Processors);
+
+	Result.ProcessorTimings.SetNum(Processors.Num());
+	for (int32 ProcessorIndex = 0; ProcessorIndex < Processors.Num(); ++ProcessorIndex)
+	{
+		Result.ProcessorTimings[ProcessorIndex].Name = Processors[ProcessorIndex]->GetClass()->GetName();
+	}
+
+	FMassEntityQuery ViewerQuery;
+	ViewerQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadOnly);
+	ViewerQuery.AddRequirement<FMassViewerInfoFragment>(EMassFragmentAccess::ReadWrite);
+
+	FMassEntityQuery PhysicsVehicleQuery;
+	PhysicsVehicleQuery.AddRequirement<FMassTrafficVehiclePhysicsFragment>(EMassFragmentAccess::ReadOnly);
+
+	Result.StepHashes.Reserve(Settings.NumSteps);
+	for (int32 Step = 0; Step < Settings.NumSteps; ++Step)
+	{
+		// Variable tick rates are scheduled from the world time
+		World->TimeSeconds += Settings.DeltaTime;
+		World->RealTimeSeconds += Settings.DeltaTime;
+		World->DeltaTimeSeconds = Settings.DeltaTime;
+
+		for (int32 ProcessorIndex = 0; ProcessorIndex < Processors.Num(); ++ProcessorIndex)
+		{
+			UMassProcessor* Processor = Processors[ProcessorIndex];
+
+			FMassProcessingContext ProcessingContext(EntityManager, Settings.DeltaTime);
+
+			const double StartTime = FPlatformTime::Seconds();
+			UE::Mass::Executor::Run(*Processor, ProcessingContext);
+			const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+			FProcessorTiming& Timing = Result.ProcessorTimings[ProcessorIndex];
+			++Timing.NumRuns;
+			Timing.TotalSeconds += Seconds;
+			Timing.MaxSeconds = FMath::Max(Timing.MaxSeconds, Seconds);
+
+			if (Processor->IsA<UMassTrafficVehicleLODCollectorProcessor>())
+			{
+				UpdateViewerInfo(EntityManager, ViewerQuery, Settings.ViewerLocation);
+			}
+		}
+
+		Result.MaxNumPhysicsVehicles = FMath::Max(Result.MaxNumPhysicsVehicles, PhysicsVehicleQuery.GetNumMatchingEntities(EntityManager));
+		Result.StepHashes.Add(HashState(EntityManager, TrafficZoneGraphData->TrafficLaneDataArray, Settings.HashTolerance));
+	}
+
+	Result.bSuccess = true;
+
+	return Result;
+}
+
+FString FMassTrafficSimulationHarness::MakeReport(const FSettings& Settings, const FRun& Run)
+{
+	using namespace MassTrafficSimulationHarnessPrivate;
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetNumberField(TEXT("Version"), ReportVersion);
+
+	TSharedRef<FJsonObject> Build = MakeShared<FJsonObject>();
+	Build->SetStringField(TEXT("EngineVersion"), FEngineVersion::Current().ToString());
+	Build->SetStringField(TEXT("BuildVersion"), FApp::GetBuildVersion());
+	Build->SetStringField(TEXT("Configuration"), LexToString(FApp::GetBuildConfiguration()));
+	Build->SetStringField(TEXT("Platform"), FPlatformProperties::IniPlatformName());
+	Build->SetNumberField(TEXT("Cores"), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+	Build->SetStringField(TEXT("Date"), FDateTime::UtcNow().ToIso8601());
+	Report->SetObjectField(TEXT("Build"), Build);
+
+	TArray<TSharedPtr<FJsonValue>> VehicleConfigs;
+	for (const FSoftObjectPath& VehicleConfigPath : Settings.VehicleConfigs)
+	{
+		VehicleConfigs.Add(MakeShared<FJsonValueString>(VehicleConfigPath.ToString()));
+	}
+
+	TSharedRef<FJsonObject> SettingsObject = MakeShared<FJsonObject>();
+	SettingsObject->SetNumberField(TEXT("Seed"), Settings.Seed);
+	SettingsObject->SetNumberField(TEXT("NumSteps"), Settings.NumSteps);
+	SettingsObject->SetNumberField(TEXT("DeltaTime"), Settings.DeltaTime);
+	SettingsObject->SetNumberField(TEXT("NumRoadsPerAxis"), Settings.NumRoadsPerAxis);
+	SettingsObject->SetNumberField(TEXT("NumSegmentsPerRoad"), Settings.NumSegmentsPerRoad);
+	SettingsObject->SetNumberField(TEXT("NumLanesPerRoad"), Settings.NumLanesPerRoad);
+	SettingsObject->SetNumberField(TEXT("RoadRadius"), Settings.RoadRadius);
+	SettingsObject->SetNumberField(TEXT("LaneWidth"), Settings.LaneWidth);
+	SettingsObject->SetNumberField(TEXT("NumVehicles"), Settings.NumVehicles);
+	SettingsObject->SetNumberField(TEXT("VehicleSpace"), Settings.VehicleSpace);
+	SettingsObject->SetStringField(TEXT("ViewerLocation"), Settings.ViewerLocation.ToString());
+	SettingsObject->SetArrayField(TEXT("VehicleConfigs"), VehicleConfigs);
+	SettingsObject->SetBoolField(TEXT("SimplePhysics"), Settings.bSimplePhysics);
+	SettingsObject->SetNumberField(TEXT("HashTolerance"), Settings.HashTolerance);
+	Report->SetObjectField(TEXT("Settings"), SettingsObject);
+
+	Report->SetBoolField(TEXT("Success"), Run.bSuccess);
+	Report->SetNumberField(TEXT("NumLanes"), Run.NumLanes);
+	Report->SetNumberField(TEXT("NumVehicles"), Run.NumVehicles);
+	Report->SetNumberField(TEXT("MaxNumPhysicsVehicles"), Run.MaxNumPhysicsVehicles);
+
+	TArray<TSharedPtr<FJsonValue>> ProcessorOrder;
+	for (const FProcessorTiming& Timing : Run.ProcessorTimings)
+	{
+		ProcessorOrder.Add(MakeShared<FJsonValueString>(Timing.Name));
+	}
+	Report->SetArrayField(TEXT("ProcessorOrder"), ProcessorOrder);
+
+	TArray<FProcessorTiming> SortedTimings = Run.ProcessorTimings;
+	SortedTimings.Sort([](const FProcessorTiming& A, const FProcessorTiming& B)
+	{
+		return A.Name < B.Name;
+	});
+
+	TSharedRef<FJsonObject> Processors = MakeShared<FJsonObject>();
+	for (const FProcessorTiming& Timing : SortedTimings)
+	{
+		TSharedRef<FJsonObject> TimingObject = MakeShared<FJsonObject>();
+		TimingObject->SetNumberField(TEXT("Runs"), Timing.NumRuns);
+		TimingObject->SetNumberField(TEXT("Total"), Timing.TotalSeconds);
+		TimingObject->SetNumberField(TEXT("Mean"), Timing.NumRuns > 0 ? Timing.TotalSeconds / Timing.NumRuns : 0.0);
+		TimingObject->SetNumberField(TEXT("Max"), Timing.MaxSeconds);
+		Processors->SetObjectField(Timing.Name, TimingObject);
+	}
+	Report->SetObjectField(TEXT("Processors"), Processors);
+
+	TArray<TSharedPtr<FJsonValue>> StepHashes;
+	for (const uint64 StepHash : Run.StepHashes)
+	{
+		StepHashes.Add(MakeShared<FJsonValueString>(HashToString(StepHash)));
+	}
+	Report->SetArrayField(TEXT("StepHashes"), StepHashes);
+	Report->SetStringField(TEXT("FinalHash"), Run.StepHashes.IsEmpty() ? FString() : HashToString(Run.StepHashes.Last()));
+
+	FString Result;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Result);
+	FJsonSerializer::Serialize(Report, Writer);
+
+	return Result;
+}
+
+int32 FMassTrafficSimulationHarness::FindFirstDivergentStep(const FString& BaselineReport, const FRun& Run)
+{
+	using namespace MassTrafficSimulationHarnessPrivate;
+
+	TSharedPtr<FJsonObject> Root;
+	const TArray<TSharedPtr<FJsonValue>>* BaselineStepHashes = nullptr;
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineReport), Root) || !Root.IsValid() || !Root->TryGetArrayField(TEXT("StepHashes"), BaselineStepHashes))
+	{
+		return 0;
+	}
+
+	const int32 NumSteps = FMath::Min(BaselineStepHashes->Num(), Run.StepHashes.Num());
+	for (int32 Step = 0; Step < NumSteps; ++Step)
+	{
+		if ((*BaselineStepHashes)[Step]->AsString() != HashToString(Run.StepHashes[Step]))
+		{
+			return Step;
+		}
+	}
+
+	return BaselineStepHashes->Num() == Run.StepHashes.Num() ? INDEX_NONE : NumSteps;
+}
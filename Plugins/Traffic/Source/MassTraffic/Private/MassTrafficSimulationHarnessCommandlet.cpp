@@ -0,0 +1,86 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MassTrafficSimulationHarnessCommandlet.h"
+#include "MassTrafficSimulationHarness.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY(LogMassTrafficSimulationHarness);
+
+int32 UMassTrafficSimulationHarnessCommandlet::Main(const FString& Params)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UMassTrafficSimulationHarnessCommandlet::Main);
+
+	FMassTrafficSimulationHarness::FSettings Settings;
+
+	FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+	FParse::Value(*Params, TEXT("Steps="), Settings.NumSteps);
+	FParse::Value(*Params, TEXT("DeltaTime="), Settings.DeltaTime);
+	FParse::Value(*Params, TEXT("Vehicles="), Settings.NumVehicles);
+	FParse::Value(*Params, TEXT("Roads="), Settings.NumRoadsPerAxis);
+	FParse::Value(*Params, TEXT("Segments="), Settings.NumSegmentsPerRoad);
+	FParse::Value(*Params, TEXT("Lanes="), Settings.NumLanesPerRoad);
+	Settings.bSimplePhysics = !FParse::Param(*Params, TEXT("NoPhysics"));
+
+	if (Settings.NumSteps <= 0 || Settings.DeltaTime <= 0.0f || Settings.NumRoadsPerAxis <= 0)
+	{
+		UE_LOG(LogMassTrafficSimulationHarness, Error, TEXT("Steps, DeltaTime and Roads must be greater than zero"));
+		return 1;
+	}
+
+	FString VehicleConfigsParam;
+	if (FParse::Value(*Params, TEXT("VehicleConfigs="), VehicleConfigsParam, /*bShouldStopOnSeparator=*/false))
+	{
+		TArray<FString> VehicleConfigPaths;
+		VehicleConfigsParam.ParseIntoArray(VehicleConfigPaths, TEXT(","));
+
+		for (const FString& VehicleConfigPath : VehicleConfigPaths)
+		{
+			Settings.VehicleConfigs.Emplace(VehicleConfigPath);
+		}
+	}
+
+	FString BaselineReport;
+	FString BaselinePath;
+	if (FParse::Value(*Params, TEXT("Baseline="), BaselinePath) && !FFileHelper::LoadFileToString(BaselineReport, *BaselinePath))
+	{
+		UE_LOG(LogMassTrafficSimulationHarness, Error, TEXT("Failed to read the baseline report '%s'"), *BaselinePath);
+		return 1;
+	}
+
+	FString OutputPath;
+	if (!FParse::Value(*Params, TEXT("Output="), OutputPath))
+	{
+		OutputPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MassTrafficSimulationHarness"), FString::Printf(TEXT("MassTrafficSimulationHarness-%s.json"), *FDateTime::Now().ToString()));
+	}
+
+	const FMassTrafficSimulationHarness::FRun Run = FMassTrafficSimulationHarness::Run(Settings);
+
+	if (!FFileHelper::SaveStringToFile(FMassTrafficSimulationHarness::MakeReport(Settings, Run), *OutputPath))
+	{
+		UE_LOG(LogMassTrafficSimulationHarness, Error, TEXT("Failed to write the report to '%s'"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogMassTrafficSimulationHarness, Display, TEXT("Wrote the traffic simulation report for %d vehicles on %d lanes to '%s'"), Run.NumVehicles, Run.NumLanes, *OutputPath);
+
+	if (!Run.bSuccess)
+	{
+		UE_LOG(LogMassTrafficSimulationHarness, Error, TEXT("The simulation run failed"));
+		return 1;
+	}
+
+	if (!BaselinePath.IsEmpty())
+	{
+		const int32 DivergentStep = FMassTrafficSimulationHarness::FindFirstDivergentStep(BaselineReport, Run);
+		if (DivergentStep != INDEX_NONE)
+		{
+			UE_LOG(LogMassTrafficSimulationHarness, Error, TEXT("The simulation diverges from the baseline '%s' at step %d"), *BaselinePath, DivergentStep);
+			return 1;
+		}
+
+		UE_LOG(LogMassTrafficSimulationHarness, Display, TEXT("All %d steps match the baseline '%s'"), Run.StepHashes.Num(), *BaselinePath);
+	}
+
+	return 0;
+}
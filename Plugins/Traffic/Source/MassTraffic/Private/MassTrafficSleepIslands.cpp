@@ -0,0 +1,100 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MassTrafficSleepIslands.h"
+#include "MassTraffic.h"
+#include "MassTrafficFragments.h"
+#include "MassTrafficLaneVehicles.h"
+#include "MassTrafficPhysics.h"
+#include "MassTrafficTypes.h"
+
+namespace UE::MassTraffic
+{
+
+void ForEachVehicleQueue(const FMassTrafficLaneVehicles& Vehicles, const float MaxGap, TFunctionRef<void(const int32 FirstVehicle, const int32 NumVehicles)> Function)
+{
+	const TConstArrayView<float> Distances = Vehicles.GetDistancesAlongLane();
+	const TConstArrayView<float> SpacesTaken = Vehicles.GetSpacesTaken();
+
+	int32 FirstVehicle = 0;
+	for (int32 VehicleIndex = 1; VehicleIndex <= Distances.Num(); ++VehicleIndex)
+	{
+		// Vehicles are centered in the space they take, so two queued vehicles are half of each of their spaces apart
+		const bool bEndOfQueue = VehicleIndex == Distances.Num()
+			|| Distances[VehicleIndex] - Distances[VehicleIndex - 1] > 0.5f * (SpacesTaken[VehicleIndex] + SpacesTaken[VehicleIndex - 1]) + MaxGap;
+		if (bEndOfQueue)
+		{
+			Function(FirstVehicle, VehicleIndex - FirstVehicle);
+			FirstVehicle = VehicleIndex;
+		}
+	}
+}
+
+void UpdateSleepIslands(FMassEntityManager& EntityManager, TArrayView<FZoneGraphTrafficLaneData> TrafficLanes, const float MaxGap, FMassTrafficSleepIslandStats& InOutStats)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(TEXT("MassTraffic UpdateSleepIslands"))
+
+	for (FZoneGraphTrafficLaneData& TrafficLaneData : TrafficLanes)
+	{
+		const FMassTrafficLaneVehicles& Vehicles = TrafficLaneData.Vehicles;
+		const TConstArrayView<FMassEntityHandle> Entities = Vehicles.GetEntities();
+		const TConstArrayView<float> Speeds = Vehicles.GetSpeeds();
+		const bool bWakeRequested = TrafficLaneData.bIsSleepingVehicleWakeRequested;
+		TrafficLaneData.bIsSleepingVehicleWakeRequested = false;
+
+		ForEachVehicleQueue(Vehicles, MaxGap, [&](const int32 FirstVehicle, const int32 NumVehicles)
+		{
+			bool bAwake = bWakeRequested;
+
+			// Speeds were refreshed at the end of the previous frame, @see UMassTrafficUpdateLaneVehiclesProcessor
+			for (int32 VehicleIndex = FirstVehicle; !bAwake && VehicleIndex < FirstVehicle + NumVehicles; ++VehicleIndex)
+			{
+				bAwake = Speeds[VehicleIndex] >= GMassTrafficLinearSpeedSleepThreshold;
+			}
+
+			// Throttle at the head of the queue wakes the island. Vehicles behind it check their own inputs
+			FMassTrafficVehiclePhysicsFragment* HeadSimplePhysicsVehicleFragment = nullptr;
+			if (!bAwake)
+			{
+				const FMassEntityHandle HeadVehicle = Entities[FirstVehicle + NumVehicles - 1];
+				if (EntityManager.IsEntityValid(HeadVehicle))
+				{
+					const FMassTrafficPIDVehicleControlFragment* PIDVehicleControlFragment = EntityManager.GetFragmentDataPtr<FMassTrafficPIDVehicleControlFragment>(HeadVehicle);
+					bAwake = PIDVehicleControlFragment && PIDVehicleControlFragment->Throttle >= GMassTrafficControlInputWakeTolerance;
+					HeadSimplePhysicsVehicleFragment = PIDVehicleControlFragment ? EntityManager.GetFragmentDataPtr<FMassTrafficVehiclePhysicsFragment>(HeadVehicle) : nullptr;
+				}
+			}
+
+			if (!bAwake)
+			{
+				if (HeadSimplePhysicsVehicleFragment)
+				{
+					HeadSimplePhysicsVehicleFragment->VehicleSim.bSleepCheckedByIsland = true;
+				}
+
+				++InOutStats.NumRestingIslands;
+				InOutStats.NumVehiclesInRestingIslands += NumVehicles;
+				return;
+			}
+
+			++InOutStats.NumAwakeIslands;
+			InOutStats.NumVehiclesInAwakeIslands += NumVehicles;
+
+			// Moving vehicles reset their own sleep counter, so only vehicles at rest need waking
+			for (int32 VehicleIndex = FirstVehicle; VehicleIndex < FirstVehicle + NumVehicles; ++VehicleIndex)
+			{
+				const FMassEntityHandle Vehicle = Entities[VehicleIndex];
+				if (Speeds[VehicleIndex] >= GMassTrafficLinearSpeedSleepThreshold || !EntityManager.IsEntityValid(Vehicle))
+				{
+					continue;
+				}
+
+				if (FMassTrafficVehiclePhysicsFragment* SimplePhysicsVehicleFragment = EntityManager.GetFragmentDataPtr<FMassTrafficVehiclePhysicsFragment>(Vehicle))
+				{
+					SimplePhysicsVehicleFragment->VehicleSim.WakeFromSleep();
+				}
+			}
+		});
+	}
+}
+
+}
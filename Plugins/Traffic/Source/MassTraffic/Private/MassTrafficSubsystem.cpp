@@ -131,44 +131,45 @@ void UMassTrafficSubsystem::Deinitialize()
 
 void UMassTrafficSubsystem::PostZoneGraphDataAdded(const AZoneGraphData* ZoneGraphData)
 {
-	UE::MassTrafficDelegates::OnPreTrafficLaneDataChange.Broadcast(this);
-	
 	// Only consider valid graph from our world
 	if (ZoneGraphData == nullptr || ZoneGraphData->GetWorld() != GetWorld())
 	{
 		return;
 	}
 
-	RegisterZoneGraphData(ZoneGraphData);
-
-	UE::MassTrafficDelegates::OnTrafficLaneDataChanged.Broadcast(this);
+	// Only the added graph's lane data is built, lane data of other graphs is left untouched
+	if (RegisterZoneGraphData(ZoneGraphData))
+	{
+		UE::MassTrafficDelegates::OnTrafficZoneGraphDataRegistered.Broadcast(this, ZoneGraphData->GetStorage().DataHandle);
+	}
 }
 
 void UMassTrafficSubsystem::PreZoneGraphDataRemoved(const AZoneGraphData* ZoneGraphData)
 {
-	UE::MassTrafficDelegates::OnPreTrafficLaneDataChange.Broadcast(this);
-	
 	// Only consider valid graph from our world
 	if (ZoneGraphData == nullptr || ZoneGraphData->GetWorld() != GetWorld())
 	{
 		return;
 	}
 
-	const FZoneGraphStorage& Storage = ZoneGraphData->GetStorage();
-	const int32 Index = Storage.DataHandle.Index;
+	UnregisterZoneGraphData(ZoneGraphData->GetStorage().DataHandle);
+}
 
-	if (!RegisteredTrafficZoneGraphData.IsValidIndex(Index))
+void UMassTrafficSubsystem::UnregisterZoneGraphData(const FZoneGraphDataHandle DataHandle)
+{
+	if (!HasTrafficDataForZoneGraph(DataHandle))
 	{
 		return;
 	}
 
-	FMassTrafficZoneGraphData& LaneData = RegisteredTrafficZoneGraphData[Index];
-	LaneData.Reset();
-	
-	UE::MassTrafficDelegates::OnTrafficLaneDataChanged.Broadcast(this);
+	UE_VLOG_UELOG(this, LogMassTraffic, Verbose, TEXT("%s removing data %d/%d"), *GetWorld()->GetName(), DataHandle.Index, DataHandle.Generation);
+
+	UE::MassTrafficDelegates::OnPreTrafficZoneGraphDataUnregistered.Broadcast(this, DataHandle);
+
+	RegisteredTrafficZoneGraphData[DataHandle.Index].Reset();
 }
 
-void UMassTrafficSubsystem::RegisterZoneGraphData(const AZoneGraphData* ZoneGraphData)
+bool UMassTrafficSubsystem::RegisterZoneGraphData(const AZoneGraphData* ZoneGraphData)
 {
 	const FZoneGraphStorage& Storage = ZoneGraphData->GetStorage();
 	
@@ -184,9 +185,13 @@ void UMassTrafficSubsystem::RegisterZoneGraphData(const AZoneGraphData* ZoneGrap
 	FMassTrafficZoneGraphData& LaneData = RegisteredTrafficZoneGraphData[Index];
 	if (LaneData.DataHandle != Storage.DataHandle)
 	{
-		// Initialize lane data if here the first time.
+		// Initialize lane data if here the first time. This also builds the lane segment grid used to find lanes
+		// near obstacles, which only changes when the lane data is rebuilt.
 		BuildLaneData(LaneData, Storage);
+		return true;
 	}
+
+	return false;
 }
 
 // Returns true if LaneIndex has both a merging and splitting lane that forms a Z shape
@@ -405,15 +410,15 @@ void UMassTrafficSubsystem::BuildLaneData(FMassTrafficZoneGraphData& TrafficZone
 		TrafficLaneData.SpaceAvailable = TrafficLaneData.Length;
 	}
 
-	// Cache zone graph lane index -> TrafficLaneDataArray lookup now that TrafficLaneDataArray addresses are stable
-	// (we're finished modifying the array)        
-	TrafficZoneGraphData.TrafficLaneDataLookup.SetNumZeroed(ZoneGraphStorage.Lanes.Num());
-	for (FZoneGraphTrafficLaneData& TrafficLaneData : TrafficZoneGraphData.TrafficLaneDataArray)
+	// Cache zone graph lane index -> TrafficLaneDataArray index lookup
+	TrafficZoneGraphData.TrafficLaneDataLookup.Init(INDEX_NONE, ZoneGraphStorage.Lanes.Num());
+	for (int32 TrafficLaneIndex = 0; TrafficLaneIndex < TrafficZoneGraphData.TrafficLaneDataArray.Num(); ++TrafficLaneIndex)
 	{
-		TrafficZoneGraphData.TrafficLaneDataLookup[TrafficLaneData.LaneHandle.Index] = &TrafficLaneData;
+		TrafficZoneGraphData.TrafficLaneDataLookup[TrafficZoneGraphData.TrafficLaneDataArray[TrafficLaneIndex].LaneHandle.Index] = TrafficLaneIndex;
 	}
 	
-	// Cache pointers to next, merging, and splitting lane fragments
+	// Cache pointers to next, merging, and splitting lane fragments now that TrafficLaneDataArray addresses are stable
+	// (we're finished modifying the array)        
 	for (FZoneGraphTrafficLaneData& TrafficLaneData : TrafficZoneGraphData.TrafficLaneDataArray)
 	{
 		// Cache next lane fragments
@@ -539,6 +544,10 @@ void UMassTrafficSubsystem::BuildLaneData(FMassTrafficZoneGraphData& TrafficZone
 			TrafficLaneData.ConstData.AverageNextLanesSpeedLimit = 0.0f;
 		}
 	}
+
+	// Bucket the segments of the traffic lanes for obstacle queries. Lanes hidden from the traffic system above
+	// aren't in TrafficLaneDataArray so obstacles won't find them either.
+	TrafficZoneGraphData.LaneSegmentGrid.Build(ZoneGraphStorage, TrafficZoneGraphData.TrafficLaneDataArray, MassTrafficSettings->ObstacleLaneGridCellSize);
 }
 
 void UMassTrafficSubsystem::RegisterField(UMassTrafficFieldComponent* Field)
@@ -803,10 +812,13 @@ void UMassTrafficSubsystem::RebuildLaneData()
 		return;
 	}
 
+	UE::MassTrafficDelegates::OnPreTrafficLaneDataChange.Broadcast(this);
+
 	for (FMassTrafficZoneGraphData& LaneData : RegisteredTrafficZoneGraphData)
 	{
+		// Reset clears the data handle, so look the storage up first
+		const FZoneGraphStorage* Storage = LaneData.DataHandle.IsValid() ? ZoneGraphSubsystem->GetZoneGraphStorage(LaneData.DataHandle) : nullptr;
 		LaneData.Reset();
-		const FZoneGraphStorage* Storage = ZoneGraphSubsystem->GetZoneGraphStorage(LaneData.DataHandle);
 		if (Storage)
 		{
 			BuildLaneData(LaneData, *Storage);
@@ -0,0 +1,470 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MassTrafficSuspensionSolver.h"
+#include "MassTraffic.h"
+
+#include "Chaos/Utilities.h"
+#include "Math/VectorRegister.h"
+#include "VisualLogger/VisualLogger.h"
+
+namespace UE::MassTraffic
+{
+
+void SolveSuspensionConstraintsIteration(
+	const float DeltaTime,
+	const FMassTrafficSimpleVehiclePhysicsSim& VehicleSim,
+	const FVector& Velocity,
+	const FVector& AngularVelocity,
+	FTransform& InOutTransform,
+	const FTransform& VehicleWorldTransform,
+	TConstArrayView<FVector> SuspensionTargets,
+	const UObject* VisLogOwner)
+{
+	// @see FSolverBody::CorrectedP & CorrectedQ
+	const FVector BodyP = InOutTransform.TransformPositionNoScale(VehicleSim.Setup().CenterOfMass);
+	const FQuat BodyQ = InOutTransform.GetRotation() * VehicleSim.Setup().RotationOfMass;
+		
+	for (int WheelIndex = 0; WheelIndex < VehicleSim.WheelSims.Num(); WheelIndex++)
+	{
+		auto& PWheel = VehicleSim.WheelSims[WheelIndex];
+
+		// @see UChaosWheeledVehicleSimulation::ApplySuspensionForces enabling the constraint only when
+		// the wheel is in contact 
+		if (!PWheel.InContact())
+		{
+			continue;
+		}
+
+		auto& PSuspension = VehicleSim.SuspensionSims[WheelIndex];
+		const float MinLength = -PSuspension.Setup().SuspensionMaxRaise;
+		const float& MaxLength = PSuspension.Setup().SuspensionMaxDrop;
+		FVector Axis = -PSuspension.Setup().SuspensionAxis; // @see UChaosWheeledVehicleMovementComponent::FixupSkeletalMesh Constraint->SetAxis
+
+		const FVector& T = SuspensionTargets[WheelIndex];
+
+		// \todo(chaos): we can cache the CoM-relative connector once per frame rather than recalculate per iteration
+		// (we should not be accessing particle state in the solver methods, although this one actually is ok because it only uses frame constrants)
+		const FVector& SuspensionActorOffset = PSuspension.GetLocalRestingPosition();
+		const FVector SuspensionCoMOffset = VehicleSim.Setup().RotationOfMass.UnrotateVector(SuspensionActorOffset - VehicleSim.Setup().CenterOfMass);
+		const FVector SuspensionCoMAxis = VehicleSim.Setup().RotationOfMass.UnrotateVector(Axis);
+
+		const FVector WorldSpaceX = BodyQ.RotateVector(SuspensionCoMOffset) + BodyP;
+
+		FVector AxisWorld = BodyQ.RotateVector(SuspensionCoMAxis);
+
+
+		
+
+		constexpr float MPHToCmS = 100000.f / 2236.94185f;
+		constexpr float SpeedThreshold = 10.0f * MPHToCmS;
+		constexpr float FortyFiveDegreesThreshold = 0.707f;
+
+		if (AxisWorld.Z > FortyFiveDegreesThreshold)
+		{
+			if (Velocity.SquaredLength() < 1.0f)
+			{
+				AxisWorld = FVector(0.f, 0.f, 1.f);
+			}
+			else
+			{
+				const float Speed = FMath::Abs(Velocity.Length());
+				if (Speed < SpeedThreshold)
+				{
+					AxisWorld = FMath::Lerp(FVector(0.f, 0.f, 1.f), AxisWorld, Speed / SpeedThreshold);
+				}
+			}
+		}
+
+		float Distance = FVector::DotProduct(WorldSpaceX - T, AxisWorld);
+		if (Distance >= MaxLength)
+		{
+			// do nothing since the target point is further than the longest extension of the suspension spring
+			continue;
+		}
+
+		if (VisLogOwner)
+		{
+			UE_VLOG_ARROW(VisLogOwner, TEXT("MassTraffic Suspension"), Log, WorldSpaceX, T, FColor::Orange, TEXT("T"));
+		}
+				
+		FVector DX = FVector::ZeroVector;
+
+		// Require the velocity at the WorldSpaceX position - not the velocity of the particle origin
+		const FVector Diff = WorldSpaceX - BodyP;
+		FVector ArmVelocity = Velocity - FVector::CrossProduct(Diff, AngularVelocity);
+
+		// This constraint is causing considerable harm to the steering effect from the tires, using only the z component for damping
+		// makes this issue go away, rather than using DotProduct against the expected AxisWorld vector
+		float PointVelocityAlongAxis = FVector::DotProduct(ArmVelocity, AxisWorld);
+
+		if (Distance < MinLength)
+		{
+			if (VisLogOwner)
+			{
+				UE_VLOG_LOCATION(VisLogOwner, TEXT("MassTraffic Suspension"), Warning, WorldSpaceX + AxisWorld * 100.0f, 5.0f, FColor::Black, TEXT("Susp < Min (%0.2f < %0.2f)"), Distance, -PSuspension.Setup().SuspensionMaxRaise);
+			}
+				
+			// target point distance is less at min compression limit 
+			// - apply distance constraint to try keep a valid min limit
+			// FVector Ts = WorldSpaceX + AxisWorld * (MinLength - Distance);
+			// DX = (Ts - WorldSpaceX) * /*HardstopStiffness*/1.0f;
+				
+			Distance = MinLength;
+				
+			// if (PointVelocityAlongAxis < 0.0f)
+			// {
+			// 	const FVector SpringVelocity = PointVelocityAlongAxis * AxisWorld;
+			// 	DX -= SpringVelocity * /*HardstopVelocityCompensation*/1.0f;
+			// 	PointVelocityAlongAxis = 0.0f; //this Dx will cancel velocity, so don't pass PointVelocityAlongAxis on to suspension force calculation 
+			// }
+		}
+
+		{
+			// then the suspension force on top
+
+			float DLambda = 0.f;
+			{
+				float SpringCompression = (MaxLength - Distance) /*+ Setting.SpringPreload*/;
+
+				float VelDt = PointVelocityAlongAxis;
+
+				const bool bAccelerationMode = false;
+				const float SpringMassScale = (bAccelerationMode) ? VehicleSim.Setup().Mass : 1.0f;
+				const float S = SpringMassScale * /*SpringStiffness*/(PSuspension.Setup().SpringRate * 0.25f) * DeltaTime * DeltaTime; // @see UChaosWheeledVehicleMovementComponent::FixupSkeletalMesh
+				const float D = SpringMassScale * /*SpringDamping*/(PSuspension.Setup().DampingRatio * 5.0f) * DeltaTime; // @see UChaosWheeledVehicleMovementComponent::FixupSkeletalMesh
+				DLambda = (S * SpringCompression - D * VelDt);
+				DX += DLambda * AxisWorld;
+
+				// DX *= ConstraintForceMultiplier;
+			}
+		}
+
+		if (VisLogOwner)
+		{
+			UE_VLOG_SEGMENT(VisLogOwner, TEXT("MassTraffic Suspension"), Log, WorldSpaceX + FVector(5, 10, 10), WorldSpaceX + FVector(15, 10, 10), FColor::Black, TEXT(""));
+			UE_VLOG_ARROW(VisLogOwner, TEXT("MassTraffic Suspension"), Log, WorldSpaceX + FVector(10), WorldSpaceX + DX + FVector(10), FColor::Black, TEXT("DX"));
+		}
+
+		const FVector Arm = WorldSpaceX - BodyP;
+
+		FQuat Q0 = InOutTransform.GetRotation() * VehicleSim.Setup().RotationOfMass;
+		FVector P0 = InOutTransform.TransformPositionNoScale(VehicleSim.Setup().CenterOfMass);
+		const Chaos::FMatrix33 WorldSpaceInvI = Chaos::Utilities::ComputeWorldSpaceInertia(Q0, VehicleSim.Setup().InverseMomentOfInertia);
+
+		FVector DP = DX / VehicleSim.Setup().Mass;
+		FQuat DQ = Chaos::FRotation3::FromElements(WorldSpaceInvI * FVector::CrossProduct(Arm, DX), 0.f) * Q0 * 0.5f;
+
+		P0 += DP;
+		Q0 += DQ;
+		Q0.Normalize();
+
+		// @see FParticleUtilities::SetCoMWorldTransform(Particle, P0, Q0);
+		{
+			FQuat Q = Q0 * VehicleSim.Setup().RotationOfMass.Inverse();
+			FVector P = P0 - Q.RotateVector(VehicleSim.Setup().CenterOfMass);
+			InOutTransform.SetLocation(P);
+			InOutTransform.SetRotation(Q);
+		}
+
+		// NaN check
+		if (!ensure(InOutTransform.IsValid()))
+		{
+			UE_LOG(LogMassTraffic, Error, TEXT("Invalid tranform (contains NaNs or non-normalized rotation) detected in MassTraffic simple vehicle physics suspension constraint solve"))
+			InOutTransform = VehicleWorldTransform;
+		}
+	}
+}
+
+namespace SuspensionSolver
+{
+	// Suspension axis blending below this speed, @see SolveSuspensionConstraintsIteration
+	static constexpr float MPHToCmS = 100000.f / 2236.94185f;
+	static constexpr float SpeedThreshold = 10.0f * MPHToCmS;
+	static constexpr float FortyFiveDegreesThreshold = 0.707f;
+
+	/** Four vectors, one per SIMD lane */
+	struct FVector4x
+	{
+		VectorRegister4Float X, Y, Z;
+	};
+
+	/** Four quaternions, one per SIMD lane */
+	struct FQuat4x
+	{
+		VectorRegister4Float X, Y, Z, W;
+	};
+
+	FORCEINLINE FVector4x Load(const float* X, const float* Y, const float* Z)
+	{
+		return { VectorLoad(X), VectorLoad(Y), VectorLoad(Z) };
+	}
+
+	FORCEINLINE void Store(const FVector4x& V, float* X, float* Y, float* Z)
+	{
+		VectorStore(V.X, X);
+		VectorStore(V.Y, Y);
+		VectorStore(V.Z, Z);
+	}
+
+	FORCEINLINE FVector4x Add(const FVector4x& A, const FVector4x& B)
+	{
+		return { VectorAdd(A.X, B.X), VectorAdd(A.Y, B.Y), VectorAdd(A.Z, B.Z) };
+	}
+
+	FORCEINLINE FVector4x Subtract(const FVector4x& A, const FVector4x& B)
+	{
+		return { VectorSubtract(A.X, B.X), VectorSubtract(A.Y, B.Y), VectorSubtract(A.Z, B.Z) };
+	}
+
+	FORCEINLINE FVector4x Multiply(const FVector4x& A, const FVector4x& B)
+	{
+		return { VectorMultiply(A.X, B.X), VectorMultiply(A.Y, B.Y), VectorMultiply(A.Z, B.Z) };
+	}
+
+	FORCEINLINE FVector4x Scale(const FVector4x& A, const VectorRegister4Float& S)
+	{
+		return { VectorMultiply(A.X, S), VectorMultiply(A.Y, S), VectorMultiply(A.Z, S) };
+	}
+
+	FORCEINLINE FVector4x Mask(const FVector4x& A, const VectorRegister4Float& M)
+	{
+		return { VectorBitwiseAnd(A.X, M), VectorBitwiseAnd(A.Y, M), VectorBitwiseAnd(A.Z, M) };
+	}
+
+	FORCEINLINE VectorRegister4Float Dot(const FVector4x& A, const FVector4x& B)
+	{
+		return VectorMultiplyAdd(A.X, B.X, VectorMultiplyAdd(A.Y, B.Y, VectorMultiply(A.Z, B.Z)));
+	}
+
+	FORCEINLINE FVector4x Cross(const FVector4x& A, const FVector4x& B)
+	{
+		return {
+			VectorSubtract(VectorMultiply(A.Y, B.Z), VectorMultiply(A.Z, B.Y)),
+			VectorSubtract(VectorMultiply(A.Z, B.X), VectorMultiply(A.X, B.Z)),
+			VectorSubtract(VectorMultiply(A.X, B.Y), VectorMultiply(A.Y, B.X))
+		};
+	}
+
+	/** @see FQuat::RotateVector */
+	FORCEINLINE FVector4x Rotate(const FQuat4x& Q, const FVector4x& V)
+	{
+		const FVector4x QV = { Q.X, Q.Y, Q.Z };
+		const FVector4x TT = Scale(Cross(QV, V), VectorSetFloat1(2.0f));
+		return Add(Add(V, Scale(TT, Q.W)), Cross(QV, TT));
+	}
+
+	/** @see FQuat::UnrotateVector */
+	FORCEINLINE FVector4x Unrotate(const FQuat4x& Q, const FVector4x& V)
+	{
+		return Rotate({ VectorNegate(Q.X), VectorNegate(Q.Y), VectorNegate(Q.Z), Q.W }, V);
+	}
+}
+
+}
+
+void FMassTrafficSuspensionSolverBatch::Reset()
+{
+	Packets.Reset();
+	Vehicles.Reset();
+}
+
+int32 FMassTrafficSuspensionSolverBatch::Add(const float DeltaTime, const FMassTrafficSimpleVehiclePhysicsSim& VehicleSim, const FTransform& Transform, const FVector& Velocity, const FVector& AngularVelocity, TConstArrayView<FVector> SuspensionTargets)
+{
+	using namespace UE::MassTraffic::SuspensionSolver;
+
+	check(VehicleSim.WheelSims.Num() <= MaxWheels);
+	check(SuspensionTargets.Num() >= VehicleSim.WheelSims.Num());
+
+	const FMassTrafficSimpleVehiclePhysicsConfig& Setup = VehicleSim.Setup();
+
+	const int32 VehicleIndex = Vehicles.Num();
+	const int32 Lane = VehicleIndex % VehiclesPerPacket;
+
+	// Unused lanes of the last packet have no wheel in contact, and an identity rotation so they stay finite
+	if (Lane == 0)
+	{
+		FPacket& NewPacket = Packets.AddZeroed_GetRef();
+		for (int32 PacketLane = 0; PacketLane < VehiclesPerPacket; ++PacketLane)
+		{
+			NewPacket.QW[PacketLane] = 1.0f;
+		}
+	}
+	FPacket& Packet = Packets.Last();
+
+	// Solve relative to the center of mass, where single precision is plenty
+	FVehicle& Vehicle = Vehicles.AddDefaulted_GetRef();
+	Vehicle.Setup = &Setup;
+	Vehicle.Origin = Transform.TransformPositionNoScale(Setup.CenterOfMass);
+
+	const FQuat BodyQ = Transform.GetRotation() * Setup.RotationOfMass;
+	Packet.QX[Lane] = BodyQ.X;
+	Packet.QY[Lane] = BodyQ.Y;
+	Packet.QZ[Lane] = BodyQ.Z;
+	Packet.QW[Lane] = BodyQ.W;
+
+	Packet.VX[Lane] = Velocity.X;
+	Packet.VY[Lane] = Velocity.Y;
+	Packet.VZ[Lane] = Velocity.Z;
+	Packet.WX[Lane] = AngularVelocity.X;
+	Packet.WY[Lane] = AngularVelocity.Y;
+	Packet.WZ[Lane] = AngularVelocity.Z;
+
+	Packet.InverseMass[Lane] = 1.0f / Setup.Mass;
+	Packet.InverseInertiaX[Lane] = Setup.InverseMomentOfInertia.X;
+	Packet.InverseInertiaY[Lane] = Setup.InverseMomentOfInertia.Y;
+	Packet.InverseInertiaZ[Lane] = Setup.InverseMomentOfInertia.Z;
+
+	// Velocity doesn't change during the solve, so the blend towards the vertical axis is the same for every constraint
+	const float SpeedSquared = Velocity.SquaredLength();
+	Packet.AxisBlend[Lane] = SpeedSquared < 1.0f ? 0.0f : FMath::Min(FMath::Sqrt(SpeedSquared) / SpeedThreshold, 1.0f);
+
+	for (int32 WheelIndex = 0; WheelIndex < VehicleSim.WheelSims.Num(); ++WheelIndex)
+	{
+		const Chaos::FSimpleSuspensionSim& Suspension = VehicleSim.SuspensionSims[WheelIndex];
+		const FVector LocalOffset = Setup.RotationOfMass.UnrotateVector(Suspension.GetLocalRestingPosition() - Setup.CenterOfMass);
+		const FVector LocalAxis = Setup.RotationOfMass.UnrotateVector(-Suspension.Setup().SuspensionAxis);
+		const FVector Target = SuspensionTargets[WheelIndex] - Vehicle.Origin;
+
+		FWheelPacket& Wheel = Packet.Wheels[WheelIndex];
+		Wheel.LocalOffsetX[Lane] = LocalOffset.X;
+		Wheel.LocalOffsetY[Lane] = LocalOffset.Y;
+		Wheel.LocalOffsetZ[Lane] = LocalOffset.Z;
+		Wheel.LocalAxisX[Lane] = LocalAxis.X;
+		Wheel.LocalAxisY[Lane] = LocalAxis.Y;
+		Wheel.LocalAxisZ[Lane] = LocalAxis.Z;
+		Wheel.TargetX[Lane] = Target.X;
+		Wheel.TargetY[Lane] = Target.Y;
+		Wheel.TargetZ[Lane] = Target.Z;
+		Wheel.MinLength[Lane] = -Suspension.Setup().SuspensionMaxRaise;
+		Wheel.MaxLength[Lane] = Suspension.Setup().SuspensionMaxDrop;
+		Wheel.Stiffness[Lane] = (Suspension.Setup().SpringRate * 0.25f) * DeltaTime * DeltaTime;
+		Wheel.Damping[Lane] = (Suspension.Setup().DampingRatio * 5.0f) * DeltaTime;
+		Wheel.Contact[Lane] = VehicleSim.WheelSims[WheelIndex].InContact() ? 1.0f : 0.0f;
+	}
+
+	return VehicleIndex;
+}
+
+void FMassTrafficSuspensionSolverBatch::Solve(const int32 NumIterations)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(TEXT("MassTraffic SolveSuspensionConstraintsBatch"))
+
+	using namespace UE::MassTraffic::SuspensionSolver;
+
+	const VectorRegister4Float Zero = VectorZeroFloat();
+	const VectorRegister4Float One = VectorOneFloat();
+	const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+	const VectorRegister4Float UprightThreshold = VectorSetFloat1(FortyFiveDegreesThreshold);
+
+	for (FPacket& Packet : Packets)
+	{
+		const FVector4x V = Load(Packet.VX, Packet.VY, Packet.VZ);
+		const FVector4x W = Load(Packet.WX, Packet.WY, Packet.WZ);
+		const VectorRegister4Float InverseMass = VectorLoad(Packet.InverseMass);
+		const FVector4x InverseInertia = Load(Packet.InverseInertiaX, Packet.InverseInertiaY, Packet.InverseInertiaZ);
+		const VectorRegister4Float AxisBlend = VectorLoad(Packet.AxisBlend);
+
+		FVector4x P = Load(Packet.PX, Packet.PY, Packet.PZ);
+		FQuat4x Q = { VectorLoad(Packet.QX), VectorLoad(Packet.QY), VectorLoad(Packet.QZ), VectorLoad(Packet.QW) };
+		VectorRegister4Float Moved = VectorLoad(Packet.Moved);
+
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			// Constraints are evaluated from the pose at the start of the iteration, @see FSolverBody::CorrectedP & CorrectedQ
+			const FVector4x BodyP = P;
+			const FQuat4x BodyQ = Q;
+
+			for (const FWheelPacket& Wheel : Packet.Wheels)
+			{
+				const VectorRegister4Float Contact = VectorCompareGT(VectorLoad(Wheel.Contact), Zero);
+				if (VectorMaskBits(Contact) == 0)
+				{
+					continue;
+				}
+
+				const FVector4x Arm = Rotate(BodyQ, Load(Wheel.LocalOffsetX, Wheel.LocalOffsetY, Wheel.LocalOffsetZ));
+				const FVector4x WorldSpaceX = Add(BodyP, Arm);
+
+				// Lean upright suspension axes towards the vertical at low speed
+				FVector4x Axis = Rotate(BodyQ, Load(Wheel.LocalAxisX, Wheel.LocalAxisY, Wheel.LocalAxisZ));
+				const VectorRegister4Float Upright = VectorCompareGT(Axis.Z, UprightThreshold);
+				Axis.X = VectorSelect(Upright, VectorMultiply(Axis.X, AxisBlend), Axis.X);
+				Axis.Y = VectorSelect(Upright, VectorMultiply(Axis.Y, AxisBlend), Axis.Y);
+				Axis.Z = VectorSelect(Upright, VectorMultiplyAdd(VectorSubtract(Axis.Z, One), AxisBlend, One), Axis.Z);
+
+				const VectorRegister4Float MinLength = VectorLoad(Wheel.MinLength);
+				const VectorRegister4Float MaxLength = VectorLoad(Wheel.MaxLength);
+
+				// Constraints are only active while the target is within the longest extension of the suspension
+				VectorRegister4Float Distance = Dot(Subtract(WorldSpaceX, Load(Wheel.TargetX, Wheel.TargetY, Wheel.TargetZ)), Axis);
+				const VectorRegister4Float Active = VectorBitwiseAnd(Contact, VectorCompareLT(Distance, MaxLength));
+				if (VectorMaskBits(Active) == 0)
+				{
+					continue;
+				}
+				Distance = VectorMax(Distance, MinLength);
+
+				const FVector4x ArmVelocity = Subtract(V, Cross(Arm, W));
+				const VectorRegister4Float PointVelocityAlongAxis = Dot(ArmVelocity, Axis);
+
+				const VectorRegister4Float SpringCompression = VectorSubtract(MaxLength, Distance);
+				const VectorRegister4Float DLambda = VectorSubtract(VectorMultiply(VectorLoad(Wheel.Stiffness), SpringCompression), VectorMultiply(VectorLoad(Wheel.Damping), PointVelocityAlongAxis));
+				const FVector4x DX = Mask(Scale(Axis, DLambda), Active);
+
+				P = Add(P, Mask(Scale(DX, InverseMass), Active));
+
+				// Angular correction with the world space inverse inertia of the current rotation, applied as
+				// Q += (AngularDelta, 0) * Q * 0.5
+				const FVector4x AngularDelta = Rotate(Q, Multiply(InverseInertia, Unrotate(Q, Cross(Arm, DX))));
+				const FVector4x QV = { Q.X, Q.Y, Q.Z };
+				const FVector4x DQV = Add(Scale(AngularDelta, Q.W), Cross(AngularDelta, QV));
+				const VectorRegister4Float DQW = VectorNegate(Dot(AngularDelta, QV));
+
+				FQuat4x NewQ = {
+					VectorMultiplyAdd(DQV.X, Half, Q.X),
+					VectorMultiplyAdd(DQV.Y, Half, Q.Y),
+					VectorMultiplyAdd(DQV.Z, Half, Q.Z),
+					VectorMultiplyAdd(DQW, Half, Q.W)
+				};
+				const VectorRegister4Float SquareSum = VectorMultiplyAdd(NewQ.X, NewQ.X, VectorMultiplyAdd(NewQ.Y, NewQ.Y, VectorMultiplyAdd(NewQ.Z, NewQ.Z, VectorMultiply(NewQ.W, NewQ.W))));
+				const VectorRegister4Float InverseLength = VectorReciprocalSqrtAccurate(SquareSum);
+
+				Q.X = VectorSelect(Active, VectorMultiply(NewQ.X, InverseLength), Q.X);
+				Q.Y = VectorSelect(Active, VectorMultiply(NewQ.Y, InverseLength), Q.Y);
+				Q.Z = VectorSelect(Active, VectorMultiply(NewQ.Z, InverseLength), Q.Z);
+				Q.W = VectorSelect(Active, VectorMultiply(NewQ.W, InverseLength), Q.W);
+
+				Moved = VectorBitwiseOr(Moved, VectorBitwiseAnd(Active, One));
+			}
+		}
+
+		Store(P, Packet.PX, Packet.PY, Packet.PZ);
+		VectorStore(Q.X, Packet.QX);
+		VectorStore(Q.Y, Packet.QY);
+		VectorStore(Q.Z, Packet.QZ);
+		VectorStore(Q.W, Packet.QW);
+		VectorStore(Moved, Packet.Moved);
+	}
+}
+
+bool FMassTrafficSuspensionSolverBatch::ApplyToTransform(const int32 VehicleIndex, FTransform& Transform) const
+{
+	const FPacket& Packet = Packets[VehicleIndex / VehiclesPerPacket];
+	const int32 Lane = VehicleIndex % VehiclesPerPacket;
+	if (Packet.Moved[Lane] == 0.0f)
+	{
+		return false;
+	}
+
+	const FVehicle& Vehicle = Vehicles[VehicleIndex];
+	const FVector P0 = Vehicle.Origin + FVector(Packet.PX[Lane], Packet.PY[Lane], Packet.PZ[Lane]);
+	const FQuat Q0(Packet.QX[Lane], Packet.QY[Lane], Packet.QZ[Lane], Packet.QW[Lane]);
+
+	// @see FParticleUtilities::SetCoMWorldTransform(Particle, P0, Q0);
+	const FQuat Q = Q0 * Vehicle.Setup->RotationOfMass.Inverse();
+	const FVector P = P0 - Q.RotateVector(Vehicle.Setup->CenterOfMass);
+	Transform.SetLocation(P);
+	Transform.SetRotation(Q);
+
+	return true;
+}
@@ -19,6 +19,7 @@ FZoneGraphTrafficLaneData::FZoneGraphTrafficLaneData():
 	bIsDownstreamFromIntersection(false),
 	bIsStoppedVehicleInPreviousLaneOverlappingThisLane(false),
 	bIsVehicleReadyToUseLane(false),
+	bIsSleepingVehicleWakeRequested(false),
 	MaxDensity(1.0f)
 {
 }
@@ -26,6 +27,7 @@ FZoneGraphTrafficLaneData::FZoneGraphTrafficLaneData():
 void FZoneGraphTrafficLaneData::ClearVehicles()
 {
 	ClearVehicleOccupancy();
+	Vehicles.Reset();
 		
 	TailVehicle = FMassEntityHandle();
 	GhostTailVehicle_FromLaneChangingVehicle = FMassEntityHandle();
@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MassTrafficUpdateLaneVehiclesProcessor.h"
+#include "MassTraffic.h"
+#include "MassTrafficFragments.h"
+#include "MassTrafficSubsystem.h"
+#include "MassExecutionContext.h"
+#include "MassZoneGraphNavigationFragments.h"
+#include "Algo/Sort.h"
+
+
+UMassTrafficUpdateLaneVehiclesProcessor::UMassTrafficUpdateLaneVehiclesProcessor()
+	: EntityQuery_Conditional(*this)
+{
+	bAutoRegisterWithProcessingPhases = true;
+	ProcessingPhase = EMassProcessingPhase::PostPhysics;
+	ExecutionOrder.ExecuteInGroup = UE::MassTraffic::ProcessorGroupNames::PostPhysicsUpdateLaneVehicles;
+	ExecutionOrder.ExecuteAfter.Add(UE::MassTraffic::ProcessorGroupNames::PostPhysicsUpdateTrafficVehicles);
+}
+
+void UMassTrafficUpdateLaneVehiclesProcessor::ConfigureQueries()
+{
+	EntityQuery_Conditional.AddTagRequirement<FMassTrafficVehicleTag>(EMassFragmentPresence::All);
+	EntityQuery_Conditional.AddRequirement<FMassZoneGraphLaneLocationFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery_Conditional.AddRequirement<FMassTrafficVehicleControlFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery_Conditional.AddSubsystemRequirement<UMassTrafficSubsystem>(EMassFragmentAccess::ReadWrite);
+	EntityQuery_Conditional.AddChunkRequirement<FMassSimulationVariableTickChunkFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery_Conditional.SetChunkFilter(FMassSimulationVariableTickChunkFragment::ShouldTickChunkThisFrame);
+
+	ProcessorRequirements.AddSubsystemRequirement<UMassTrafficSubsystem>(EMassFragmentAccess::ReadWrite);
+}
+
+void UMassTrafficUpdateLaneVehiclesProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	UMassTrafficSubsystem& MassTrafficSubsystem = Context.GetMutableSubsystemChecked<UMassTrafficSubsystem>();
+
+	// Copy distances and speeds of the vehicles that ticked this frame, vehicles in chunks that didn't tick haven't moved
+	EntityQuery_Conditional.ForEachEntityChunk(EntityManager, Context, [&MassTrafficSubsystem](FMassExecutionContext& QueryContext)
+	{
+		const int32 NumEntities = QueryContext.GetNumEntities();
+		const TConstArrayView<FMassZoneGraphLaneLocationFragment> LaneLocationFragments = QueryContext.GetFragmentView<FMassZoneGraphLaneLocationFragment>();
+		const TConstArrayView<FMassTrafficVehicleControlFragment> VehicleControlFragments = QueryContext.GetFragmentView<FMassTrafficVehicleControlFragment>();
+
+		// Group the chunk's vehicles by lane so each lane's vehicle index is searched once per chunk, rather than once
+		// per vehicle
+		TArray<TPair<FZoneGraphTrafficLaneData*, int32>, TInlineAllocator<128>> LaneEntityIndices;
+		LaneEntityIndices.Reserve(NumEntities);
+		for (int32 Index = 0; Index < NumEntities; ++Index)
+		{
+			if (FZoneGraphTrafficLaneData* TrafficLaneData = MassTrafficSubsystem.GetMutableTrafficLaneData(LaneLocationFragments[Index].LaneHandle))
+			{
+				LaneEntityIndices.Emplace(TrafficLaneData, Index);
+			}
+		}
+
+		Algo::Sort(LaneEntityIndices, [](const TPair<FZoneGraphTrafficLaneData*, int32>& A, const TPair<FZoneGraphTrafficLaneData*, int32>& B)
+		{
+			return A.Key < B.Key;
+		});
+
+		TArray<FMassEntityHandle, TInlineAllocator<32>> LaneEntities;
+		TArray<int32, TInlineAllocator<32>> VehicleIndices;
+		for (int32 RunStart = 0; RunStart < LaneEntityIndices.Num(); )
+		{
+			FZoneGraphTrafficLaneData* TrafficLaneData = LaneEntityIndices[RunStart].Key;
+
+			int32 RunEnd = RunStart + 1;
+			while (RunEnd < LaneEntityIndices.Num() && LaneEntityIndices[RunEnd].Key == TrafficLaneData)
+			{
+				++RunEnd;
+			}
+
+			LaneEntities.Reset();
+			for (int32 RunIndex = RunStart; RunIndex < RunEnd; ++RunIndex)
+			{
+				LaneEntities.Add(QueryContext.GetEntity(LaneEntityIndices[RunIndex].Value));
+			}
+			VehicleIndices.SetNumUninitialized(LaneEntities.Num());
+			TrafficLaneData->Vehicles.FindIndices(LaneEntities, VehicleIndices);
+
+			for (int32 RunIndex = RunStart; RunIndex < RunEnd; ++RunIndex)
+			{
+				const int32 VehicleIndex = VehicleIndices[RunIndex - RunStart];
+				if (VehicleIndex != INDEX_NONE)
+				{
+					const int32 Index = LaneEntityIndices[RunIndex].Value;
+					TrafficLaneData->Vehicles.Set(VehicleIndex, LaneLocationFragments[Index].DistanceAlongLane, VehicleControlFragments[Index].Speed);
+				}
+			}
+
+			RunStart = RunEnd;
+		}
+	});
+
+	// Vehicles rarely overtake each other on a lane, so this is a single pass over each lane's distances
+	for (FMassTrafficZoneGraphData* TrafficZoneGraphData : MassTrafficSubsystem.GetMutableTrafficZoneGraphData())
+	{
+		for (FZoneGraphTrafficLaneData& TrafficLaneData : TrafficZoneGraphData->TrafficLaneDataArray)
+		{
+			TrafficLaneData.Vehicles.RestoreOrder();
+		}
+	}
+}
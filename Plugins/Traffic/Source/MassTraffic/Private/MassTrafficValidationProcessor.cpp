@@ -122,6 +122,20 @@ void UMassTrafficValidationProcessor::Execute(FMassEntityManager& EntityManager,
 			}
 			
 
+			// Check the packed vehicle index only holds vehicles on this lane
+			for (const FMassEntityHandle VehicleEntity : TrafficLaneData.Vehicles.GetEntities())
+			{
+				const FMassZoneGraphLaneLocationFragment* VehicleLaneLocationFragment = EntityManager.IsEntityValid(VehicleEntity) ? EntityManager.GetFragmentDataPtr<FMassZoneGraphLaneLocationFragment>(VehicleEntity) : nullptr;
+				if (!ensure(VehicleLaneLocationFragment && VehicleLaneLocationFragment->LaneHandle == TrafficLaneData.LaneHandle))
+				{
+					FVector LaneBeginPoint = GetLaneBeginPoint(TrafficLaneData.LaneHandle.Index, *ZoneGraphStorage);
+					#if ENABLE_VISUAL_LOG
+						UE_VLOG_LOCATION(LogOwner, TEXT("MassTraffic Validation"), Warning, LaneBeginPoint, 10.0f, FColor::Red, TEXT("%s packed vehicle index holds vehicle %d which isn't on the lane"), *TrafficLaneData.LaneHandle.ToString(), VehicleEntity.Index);
+					#endif
+				}
+			}
+
+
 			// Check space available
 			if (TrafficLaneData.SpaceAvailable < TrafficLaneData.Length - 1.0f && !TrafficLaneData.TailVehicle.IsSet())
 			{
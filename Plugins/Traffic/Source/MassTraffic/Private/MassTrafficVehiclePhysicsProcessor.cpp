@@ -8,6 +8,8 @@
 #include "MassTrafficInterpolation.h"
 #include "MassTrafficLaneChange.h"
 #include "MassTrafficParkedVehicleVisualizationProcessor.h"
+#include "MassTrafficSleepIslands.h"
+#include "MassTrafficSuspensionSolver.h"
 #include "MassTrafficTrailerSimulationTrait.h"
 #include "MassTrafficVehicleControlProcessor.h"
 #include "MassExecutionContext.h"
@@ -22,6 +24,11 @@
 #include "ZoneGraphTypes.h"
 #include "MassGameplayExternalTraits.h"
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Awake Sleep Islands"), STAT_Traffic_AwakeSleepIslands, STATGROUP_Traffic);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Resting Sleep Islands"), STAT_Traffic_RestingSleepIslands, STATGROUP_Traffic);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Vehicles In Awake Sleep Islands"), STAT_Traffic_VehiclesInAwakeSleepIslands, STATGROUP_Traffic);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Vehicles In Resting Sleep Islands"), STAT_Traffic_VehiclesInRestingSleepIslands, STATGROUP_Traffic);
+
 
 template<typename FormatType>
 void AddForceAtPosition(const FVector& WorldCenterOfMass, const FVector& Force, const FVector& Position, FVector& InOutTotalForce, FVector& InOutTotalTorque, bool bVisLog, UObject* VisLogOwner, const FormatType& VisLogFormat)
@@ -75,6 +82,8 @@ void UMassTrafficVehiclePhysicsProcessor::ConfigureQueries()
 	SimplePhysicsVehiclesQuery.AddRequirement<FMassTrafficDebugFragment>(EMassFragmentAccess::ReadOnly, EMassFragmentPresence::Optional);
 	SimplePhysicsVehiclesQuery.AddSubsystemRequirement<UZoneGraphSubsystem>(EMassFragmentAccess::ReadOnly);
 
+	ProcessorRequirements.AddSubsystemRequirement<UMassTrafficSubsystem>(EMassFragmentAccess::ReadWrite);
+
 	// Init chaos constraint solver settings
 	// 
 	// Note: Technically Chaos supports changing these per frame but for simplicity we don't support that to avoid
@@ -112,6 +121,28 @@ void UMassTrafficVehiclePhysicsProcessor::Execute(FMassEntityManager& EntityMana
 
 		// Get gravity from world
 		float GravityZ = GetWorld()->GetGravityZ();
+
+		// Wake islands of sleeping vehicles. The heads of islands left sleeping are then skipped without checking their inputs
+		const bool bSleepIslands = GMassTrafficSleepEnabled && GMassTrafficSleepIslands;
+		if (bSleepIslands)
+		{
+			UMassTrafficSubsystem& MassTrafficSubsystem = Context.GetMutableSubsystemChecked<UMassTrafficSubsystem>();
+
+			FMassTrafficSleepIslandStats SleepIslandStats;
+			for (FMassTrafficZoneGraphData* TrafficZoneGraphData : MassTrafficSubsystem.GetMutableTrafficZoneGraphData())
+			{
+				UE::MassTraffic::UpdateSleepIslands(EntityManager, TrafficZoneGraphData->TrafficLaneDataArray, GMassTrafficSleepIslandMaxGap, SleepIslandStats);
+			}
+
+			SET_DWORD_STAT(STAT_Traffic_AwakeSleepIslands, SleepIslandStats.NumAwakeIslands);
+			SET_DWORD_STAT(STAT_Traffic_RestingSleepIslands, SleepIslandStats.NumRestingIslands);
+			SET_DWORD_STAT(STAT_Traffic_VehiclesInAwakeSleepIslands, SleepIslandStats.NumVehiclesInAwakeIslands);
+			SET_DWORD_STAT(STAT_Traffic_VehiclesInRestingSleepIslands, SleepIslandStats.NumVehiclesInRestingIslands);
+		}
+
+		const bool bBatchSuspensionConstraints = GMassTrafficBatchedSuspensionSolver > 0;
+		SuspensionSolverBatch.Reset();
+		BatchedVehicles.Reset();
 		
 		SimplePhysicsVehiclesQuery.ForEachEntityChunk(EntityManager, Context, [&](FMassExecutionContext& QueryContext)
 		{
@@ -149,6 +180,17 @@ void UMassTrafficVehiclePhysicsProcessor::Execute(FMassEntityManager& EntityMana
 				const FMassTrafficLaneOffsetFragment& LaneOffsetFragment = LaneOffsetFragments[Index];
 				FMassTrafficInterpolationFragment& InterpolationFragment = InterpolationFragments[Index];
 
+				// Still sleeping after its island checked its inputs?
+				const bool bSleepCheckedByIsland = SimplePhysicsVehicleFragment.VehicleSim.bSleepCheckedByIsland;
+				SimplePhysicsVehicleFragment.VehicleSim.bSleepCheckedByIsland = false;
+				if (bSleepIslands && bSleepCheckedByIsland && SimplePhysicsVehicleFragment.VehicleSim.IsSleeping())
+				{
+#if WITH_MASSTRAFFIC_DEBUG
+					UE::MassTraffic::DrawDebugSleepState(GetWorld(), TransformFragment.GetTransform().GetLocation(), true, DebugFragments.IsEmpty() ? false : DebugFragments[Index].bVisLog > 0, LogOwner);
+#endif
+					continue;
+				}
+
 				const FZoneGraphStorage* ZoneGraphStorage = ZoneGraphSubsystem.GetZoneGraphStorage(LaneLocationFragment.LaneHandle.DataHandle);
 				check(ZoneGraphStorage);
 
@@ -284,10 +326,10 @@ void UMassTrafficVehiclePhysicsProcessor::Execute(FMassEntityManager& EntityMana
 							for (int Iteration = 0; Iteration < NumChaosConstraintSolverIterations; ++Iteration)
 							{
 								// Vehicle suspension constraints
-								SolveSuspensionConstraintsIteration(DeltaTime, SimplePhysicsVehicleFragment, VelocityFragment, AngularVelocityFragment, TransformFragment, VehicleWorldTransform, SuspensionTargets, bVisLog);
+								UE::MassTraffic::SolveSuspensionConstraintsIteration(DeltaTime, SimplePhysicsVehicleFragment.VehicleSim, VelocityFragment.Value, AngularVelocityFragment.AngularVelocity, TransformFragment.GetMutableTransform(), VehicleWorldTransform, SuspensionTargets, bVisLog ? LogOwner : nullptr);
 								
 								// Trailer suspension constraints
-								SolveSuspensionConstraintsIteration(DeltaTime, TrailerSimplePhysicsVehicleFragment, TrailerVelocityFragment, TrailerAngularVelocityFragment, TrailerTransformFragment, TrailerWorldTransform, TrailerSuspensionTargets, bVisLog);
+								UE::MassTraffic::SolveSuspensionConstraintsIteration(DeltaTime, TrailerSimplePhysicsVehicleFragment.VehicleSim, TrailerVelocityFragment.Value, TrailerAngularVelocityFragment.AngularVelocity, TrailerTransformFragment.GetMutableTransform(), TrailerWorldTransform, TrailerSuspensionTargets, bVisLog ? LogOwner : nullptr);
 					
 								// Trailer attachment constraint 
 								TrailerConstraintSolver.Update(
@@ -328,27 +370,71 @@ void UMassTrafficVehiclePhysicsProcessor::Execute(FMassEntityManager& EntityMana
 				// No trailer, we can just simulate our own suspension constraints by ourself
 				if (!bHasTrailer)
 				{
+					// Solve along with the other vehicles without trailers once every chunk is simulated. Visual logged
+					// vehicles are solved on their own so their constraints are logged
+					if (bBatchSuspensionConstraints && !bVisLog)
+					{
+						SuspensionSolverBatch.Add(DeltaTime, SimplePhysicsVehicleFragment.VehicleSim, TransformFragment.GetTransform(), VelocityFragment.Value, AngularVelocityFragment.AngularVelocity, SuspensionTargets);
+						BatchedVehicles.Add({ &VehicleControlFragment, &SimplePhysicsVehicleFragment, &VelocityFragment, &AngularVelocityFragment, &TransformFragment, VehicleWorldTransform, RawLaneLocationTransform });
+						continue;
+					}
 
 					// Suspension Constraints
 					for (int Iteration = 0; Iteration < NumChaosConstraintSolverIterations; ++Iteration)
 					{
-						SolveSuspensionConstraintsIteration(DeltaTime, SimplePhysicsVehicleFragment, VelocityFragment, AngularVelocityFragment, TransformFragment, VehicleWorldTransform, SuspensionTargets, bVisLog);
+						UE::MassTraffic::SolveSuspensionConstraintsIteration(DeltaTime, SimplePhysicsVehicleFragment.VehicleSim, VelocityFragment.Value, AngularVelocityFragment.AngularVelocity, TransformFragment.GetMutableTransform(), VehicleWorldTransform, SuspensionTargets, bVisLog ? LogOwner : nullptr);
 					}
 				}
 				
-				// Clamp vehicle position to limit deviation from RawLaneLocation
-				ClampLateralDeviation(TransformFragment, RawLaneLocationTransform);
+				FinishVehicle(DeltaTime, VehicleControlFragment, SimplePhysicsVehicleFragment, VelocityFragment, AngularVelocityFragment, TransformFragment, VehicleWorldTransform, RawLaneLocationTransform);
+			}
+		});
 
-				// Update velocity of vehicle
-				UpdateCoMVelocity(DeltaTime, SimplePhysicsVehicleFragment, TransformFragment, VelocityFragment, AngularVelocityFragment, VehicleWorldTransform);
+		// Suspension constraints of the vehicles without trailers
+		if (!SuspensionSolverBatch.IsEmpty())
+		{
+			SuspensionSolverBatch.Solve(NumChaosConstraintSolverIterations);
 
-				// Update speed from velocity 
-				VehicleControlFragment.Speed = VelocityFragment.Value.Size();
+			for (int32 BatchIndex = 0; BatchIndex < BatchedVehicles.Num(); ++BatchIndex)
+			{
+				const FBatchedVehicle& BatchedVehicle = BatchedVehicles[BatchIndex];
+				FTransform& Transform = BatchedVehicle.TransformFragment->GetMutableTransform();
+				if (SuspensionSolverBatch.ApplyToTransform(BatchIndex, Transform))
+				{
+					// NaN check
+					if (!ensure(Transform.IsValid()))
+					{
+						UE_LOG(LogMassTraffic, Error, TEXT("Invalid tranform (contains NaNs or non-normalized rotation) detected in MassTraffic simple vehicle physics batched suspension constraint solve"))
+						Transform = BatchedVehicle.VehicleWorldTransform;
+					}
+				}
+
+				FinishVehicle(DeltaTime, *BatchedVehicle.VehicleControlFragment, *BatchedVehicle.SimplePhysicsVehicleFragment, *BatchedVehicle.VelocityFragment, *BatchedVehicle.AngularVelocityFragment, *BatchedVehicle.TransformFragment, BatchedVehicle.VehicleWorldTransform, BatchedVehicle.RawLaneLocationTransform);
 			}
-		});
+		}
 	}
 }
 
+void UMassTrafficVehiclePhysicsProcessor::FinishVehicle(
+	const float DeltaTime,
+	FMassTrafficVehicleControlFragment& VehicleControlFragment,
+	const FMassTrafficVehiclePhysicsFragment& SimplePhysicsVehicleFragment,
+	FMassVelocityFragment& VelocityFragment,
+	FMassTrafficAngularVelocityFragment& AngularVelocityFragment,
+	FTransformFragment& TransformFragment,
+	const FTransform& VehicleWorldTransform,
+	const FTransform& RawLaneLocationTransform)
+{
+	// Clamp vehicle position to limit deviation from RawLaneLocation
+	ClampLateralDeviation(TransformFragment, RawLaneLocationTransform);
+
+	// Update velocity of vehicle
+	UpdateCoMVelocity(DeltaTime, SimplePhysicsVehicleFragment, TransformFragment, VelocityFragment, AngularVelocityFragment, VehicleWorldTransform);
+
+	// Update speed from velocity 
+	VehicleControlFragment.Speed = VelocityFragment.Value.Size();
+}
+
 bool UMassTrafficVehiclePhysicsProcessor::ProcessSleeping(
 	const FMassTrafficVehicleControlFragment& VehicleControlFragment,
 	const FMassTrafficPIDVehicleControlFragment& PIDVehicleControlFragment,
@@ -883,172 +969,6 @@ void UMassTrafficVehiclePhysicsProcessor::SimulateDriveForces(
 	}
 }
 
-void UMassTrafficVehiclePhysicsProcessor::SolveSuspensionConstraintsIteration(
-	const float DeltaTime,
-	FMassTrafficVehiclePhysicsFragment& SimplePhysicsVehicleFragment,
-	FMassVelocityFragment& VelocityFragment,
-	FMassTrafficAngularVelocityFragment& AngularVelocityFragment,
-	FTransformFragment& TransformFragment,
-	const FTransform& VehicleWorldTransform,
-	const TArray<FVector, TFixedAllocator<FMassTrafficSimpleVehiclePhysicsSim::MaxWheels>>& SuspensionTargets,
-	bool bVisLog
-)
-{
-	// @see FSolverBody::CorrectedP & CorrectedQ
-	const FVector BodyP = TransformFragment.GetTransform().TransformPositionNoScale(SimplePhysicsVehicleFragment.VehicleSim.Setup().CenterOfMass);
-	const FQuat BodyQ = TransformFragment.GetTransform().GetRotation() * SimplePhysicsVehicleFragment.VehicleSim.Setup().RotationOfMass;
-		
-	for (int WheelIndex = 0; WheelIndex < SimplePhysicsVehicleFragment.VehicleSim.WheelSims.Num(); WheelIndex++)
-	{
-		auto& PWheel = SimplePhysicsVehicleFragment.VehicleSim.WheelSims[WheelIndex];
-
-		// @see UChaosWheeledVehicleSimulation::ApplySuspensionForces enabling the constraint only when
-		// the wheel is in contact 
-		if (!PWheel.InContact())
-		{
-			continue;
-		}
-
-		auto& PSuspension = SimplePhysicsVehicleFragment.VehicleSim.SuspensionSims[WheelIndex];
-		const float MinLength = -PSuspension.Setup().SuspensionMaxRaise;
-		const float& MaxLength = PSuspension.Setup().SuspensionMaxDrop;
-		FVector Axis = -PSuspension.Setup().SuspensionAxis; // @see UChaosWheeledVehicleMovementComponent::FixupSkeletalMesh Constraint->SetAxis
-
-		const FVector& T = SuspensionTargets[WheelIndex];
-
-		// \todo(chaos): we can cache the CoM-relative connector once per frame rather than recalculate per iteration
-		// (we should not be accessing particle state in the solver methods, although this one actually is ok because it only uses frame constrants)
-		const FVector& SuspensionActorOffset = PSuspension.GetLocalRestingPosition();
-		const FVector SuspensionCoMOffset = SimplePhysicsVehicleFragment.VehicleSim.Setup().RotationOfMass.UnrotateVector(SuspensionActorOffset - SimplePhysicsVehicleFragment.VehicleSim.Setup().CenterOfMass);
-		const FVector SuspensionCoMAxis = SimplePhysicsVehicleFragment.VehicleSim.Setup().RotationOfMass.UnrotateVector(Axis);
-
-		const FVector WorldSpaceX = BodyQ.RotateVector(SuspensionCoMOffset) + BodyP;
-
-		FVector AxisWorld = BodyQ.RotateVector(SuspensionCoMAxis);
-
-
-		
-
-		constexpr float MPHToCmS = 100000.f / 2236.94185f;
-		constexpr float SpeedThreshold = 10.0f * MPHToCmS;
-		constexpr float FortyFiveDegreesThreshold = 0.707f;
-
-		if (AxisWorld.Z > FortyFiveDegreesThreshold)
-		{
-			if (VelocityFragment.Value.SquaredLength() < 1.0f)
-			{
-				AxisWorld = FVector(0.f, 0.f, 1.f);
-			}
-			else
-			{
-				const float Speed = FMath::Abs(VelocityFragment.Value.Length());
-				if (Speed < SpeedThreshold)
-				{
-					AxisWorld = FMath::Lerp(FVector(0.f, 0.f, 1.f), AxisWorld, Speed / SpeedThreshold);
-				}
-			}
-		}
-
-		float Distance = FVector::DotProduct(WorldSpaceX - T, AxisWorld);
-		if (Distance >= MaxLength)
-		{
-			// do nothing since the target point is further than the longest extension of the suspension spring
-			continue;
-		}
-
-		if (bVisLog)
-		{
-			UE_VLOG_ARROW(LogOwner, TEXT("MassTraffic Suspension"), Log, WorldSpaceX, T, FColor::Orange, TEXT("T"));
-		}
-				
-		FVector DX = FVector::ZeroVector;
-
-		// Require the velocity at the WorldSpaceX position - not the velocity of the particle origin
-		const FVector Diff = WorldSpaceX - BodyP;
-		FVector ArmVelocity = VelocityFragment.Value - FVector::CrossProduct(Diff, AngularVelocityFragment.AngularVelocity);
-
-		// This constraint is causing considerable harm to the steering effect from the tires, using only the z component for damping
-		// makes this issue go away, rather than using DotProduct against the expected AxisWorld vector
-		float PointVelocityAlongAxis = FVector::DotProduct(ArmVelocity, AxisWorld);
-
-		if (Distance < MinLength)
-		{
-			if (bVisLog)
-			{
-				UE_VLOG_LOCATION(LogOwner, TEXT("MassTraffic Suspension"), Warning, WorldSpaceX + AxisWorld * 100.0f, 5.0f, FColor::Black, TEXT("Susp < Min (%0.2f < %0.2f)"), Distance, -PSuspension.Setup().SuspensionMaxRaise);
-			}
-				
-			// target point distance is less at min compression limit 
-			// - apply distance constraint to try keep a valid min limit
-			// FVector Ts = WorldSpaceX + AxisWorld * (MinLength - Distance);
-			// DX = (Ts - WorldSpaceX) * /*HardstopStiffness*/1.0f;
-				
-			Distance = MinLength;
-				
-			// if (PointVelocityAlongAxis < 0.0f)
-			// {
-			// 	const FVector SpringVelocity = PointVelocityAlongAxis * AxisWorld;
-			// 	DX -= SpringVelocity * /*HardstopVelocityCompensation*/1.0f;
-			// 	PointVelocityAlongAxis = 0.0f; //this Dx will cancel velocity, so don't pass PointVelocityAlongAxis on to suspension force calculation 
-			// }
-		}
-
-		{
-			// then the suspension force on top
-
-			float DLambda = 0.f;
-			{
-				float SpringCompression = (MaxLength - Distance) /*+ Setting.SpringPreload*/;
-
-				float VelDt = PointVelocityAlongAxis;
-
-				const bool bAccelerationMode = false;
-				const float SpringMassScale = (bAccelerationMode) ? SimplePhysicsVehicleFragment.VehicleSim.Setup().Mass : 1.0f;
-				const float S = SpringMassScale * /*SpringStiffness*/(PSuspension.Setup().SpringRate * 0.25f) * DeltaTime * DeltaTime; // @see UChaosWheeledVehicleMovementComponent::FixupSkeletalMesh
-				const float D = SpringMassScale * /*SpringDamping*/(PSuspension.Setup().DampingRatio * 5.0f) * DeltaTime; // @see UChaosWheeledVehicleMovementComponent::FixupSkeletalMesh
-				DLambda = (S * SpringCompression - D * VelDt);
-				DX += DLambda * AxisWorld;
-
-				// DX *= ConstraintForceMultiplier;
-			}
-		}
-
-		if (bVisLog)
-		{
-			UE_VLOG_SEGMENT(LogOwner, TEXT("MassTraffic Suspension"), Log, WorldSpaceX + FVector(5, 10, 10), WorldSpaceX + FVector(15, 10, 10), FColor::Black, TEXT(""));
-			UE_VLOG_ARROW(LogOwner, TEXT("MassTraffic Suspension"), Log, WorldSpaceX + FVector(10), WorldSpaceX + DX + FVector(10), FColor::Black, TEXT("DX"));
-		}
-
-		const FVector Arm = WorldSpaceX - BodyP;
-
-		FQuat Q0 = TransformFragment.GetTransform().GetRotation() * SimplePhysicsVehicleFragment.VehicleSim.Setup().RotationOfMass;
-		FVector P0 = TransformFragment.GetTransform().TransformPositionNoScale(SimplePhysicsVehicleFragment.VehicleSim.Setup().CenterOfMass);
-		const Chaos::FMatrix33 WorldSpaceInvI = Chaos::Utilities::ComputeWorldSpaceInertia(Q0, SimplePhysicsVehicleFragment.VehicleSim.Setup().InverseMomentOfInertia);
-
-		FVector DP = DX / SimplePhysicsVehicleFragment.VehicleSim.Setup().Mass;
-		FQuat DQ = Chaos::FRotation3::FromElements(WorldSpaceInvI * FVector::CrossProduct(Arm, DX), 0.f) * Q0 * 0.5f;
-
-		P0 += DP;
-		Q0 += DQ;
-		Q0.Normalize();
-
-		// @see FParticleUtilities::SetCoMWorldTransform(Particle, P0, Q0);
-		{
-			FQuat Q = Q0 * SimplePhysicsVehicleFragment.VehicleSim.Setup().RotationOfMass.Inverse();
-			FVector P = P0 - Q.RotateVector(SimplePhysicsVehicleFragment.VehicleSim.Setup().CenterOfMass);
-			TransformFragment.GetMutableTransform().SetLocation(P);
-			TransformFragment.GetMutableTransform().SetRotation(Q);
-		}
-
-		// NaN check
-		if (!ensure(TransformFragment.GetTransform().IsValid()))
-		{
-			UE_LOG(LogMassTraffic, Error, TEXT("Invalid tranform (contains NaNs or non-normalized rotation) detected in MassTraffic simple vehicle physics suspension constraint solve"))
-			TransformFragment.GetMutableTransform() = VehicleWorldTransform;
-		}
-	}
-}
-
 void UMassTrafficVehiclePhysicsProcessor::UpdateCoMVelocity(
 	const float DeltaTime,
 	const FMassTrafficVehiclePhysicsFragment& SimplePhysicsVehicleFragment,
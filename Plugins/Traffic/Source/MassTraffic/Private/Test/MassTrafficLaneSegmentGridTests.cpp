@@ -0,0 +1,220 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#include "MassTrafficLaneSegmentGrid.h"
+#include "MassTrafficTypes.h"
+#include "ZoneGraphQuery.h"
+#include "ZoneGraphTypes.h"
+
+namespace MassTrafficLaneSegmentGridTests
+{
+	static const int32 NumBlocks = 20;
+	static const float BlockSize = 10000.0f;
+	static const float LaneOffset = 175.0f;
+	static const int32 NumPointsPerLane = 5;
+
+	// Default obstacle search settings from UMassTrafficSettings
+	static const float ObstacleSearchRadius = 10000.0f;
+	static const float ObstacleSearchHeight = 500.0f;
+	static const float CellSize = 2500.0f;
+
+	static void AddLane(FZoneGraphStorage& Storage, FZoneData& Zone, const FVector& Start, const FVector& End)
+	{
+		FZoneLaneData& Lane = Storage.Lanes.AddDefaulted_GetRef();
+		Lane.ZoneIndex = Storage.Zones.Num();
+		Lane.Width = 2.0f * LaneOffset;
+		Lane.PointsBegin = Storage.LanePoints.Num();
+
+		const FVector Direction = (End - Start).GetSafeNormal();
+		float Progression = 0.0f;
+		for (int32 PointIndex = 0; PointIndex < NumPointsPerLane; ++PointIndex)
+		{
+			const FVector Point = FMath::Lerp(Start, End, (float)PointIndex / (NumPointsPerLane - 1));
+			if (PointIndex > 0)
+			{
+				Progression += FVector::Dist(Storage.LanePoints.Last(), Point);
+			}
+
+			Storage.LanePoints.Add(Point);
+			Storage.LaneTangentVectors.Add(Direction);
+			Storage.LaneUpVectors.Add(FVector::UpVector);
+			Storage.LanePointProgressions.Add(Progression);
+			Zone.Bounds += Point;
+		}
+
+		Lane.PointsEnd = Storage.LanePoints.Num();
+		Lane.LinksBegin = Storage.LaneLinks.Num();
+		Lane.LinksEnd = Storage.LaneLinks.Num();
+	}
+
+	static void AddRoad(FZoneGraphStorage& Storage, const FVector& Start, const FVector& End)
+	{
+		const FVector Side = FVector::CrossProduct((End - Start).GetSafeNormal(), FVector::UpVector) * LaneOffset;
+
+		FZoneData Zone;
+		Zone.Bounds.Init();
+		Zone.LanesBegin = Storage.Lanes.Num();
+		AddLane(Storage, Zone, Start + Side, End + Side);
+		AddLane(Storage, Zone, End - Side, Start - Side);
+		Zone.LanesEnd = Storage.Lanes.Num();
+		Zone.Bounds = Zone.Bounds.ExpandBy(LaneOffset);
+
+		Storage.Bounds += Zone.Bounds;
+		Storage.Zones.Add(Zone);
+	}
+
+	// Manhattan style city made of two way roads between every intersection
+	static void BuildCity(FZoneGraphStorage& Storage, TArray<FZoneGraphTrafficLaneData>& OutTrafficLanes)
+	{
+		Storage.DataHandle = FZoneGraphDataHandle(0, 1);
+		Storage.Bounds.Init();
+
+		for (int32 Row = 0; Row <= NumBlocks; ++Row)
+		{
+			for (int32 Block = 0; Block < NumBlocks; ++Block)
+			{
+				AddRoad(Storage, FVector(Block * BlockSize, Row * BlockSize, 0.0f), FVector((Block + 1) * BlockSize, Row * BlockSize, 0.0f));
+				AddRoad(Storage, FVector(Row * BlockSize, Block * BlockSize, 0.0f), FVector(Row * BlockSize, (Block + 1) * BlockSize, 0.0f));
+			}
+		}
+
+		Storage.ZoneBVTree.Build(MakeConstStridedView(Storage.Zones, &FZoneData::Bounds));
+
+		for (int32 LaneIndex = 0; LaneIndex < Storage.Lanes.Num(); ++LaneIndex)
+		{
+			OutTrafficLanes.AddDefaulted_GetRef().LaneHandle = FZoneGraphLaneHandle(LaneIndex, Storage.DataHandle);
+		}
+	}
+
+	static FBox MakeSearchBox(const FVector& Location)
+	{
+		return FBox::BuildAABB(Location, FVector(FVector2D(ObstacleSearchRadius), ObstacleSearchHeight));
+	}
+
+	// What UMassTrafficFindObstaclesProcessor did before the lane segment grid
+	static void FindNearestLocationsOnLanes(const FZoneGraphStorage& Storage, const FBox& SearchBox, TArray<FZoneGraphLaneHandle>& NearbyLanes, TArray<FZoneGraphLaneLocation>& OutLocations)
+	{
+		NearbyLanes.Reset();
+		UE::ZoneGraph::Query::FindOverlappingLanes(Storage, SearchBox, FZoneGraphTagFilter(), NearbyLanes);
+
+		for (const FZoneGraphLaneHandle NearbyLane : NearbyLanes)
+		{
+			FZoneGraphLaneLocation NearestLocationOnLane;
+			float DistanceSq;
+			UE::ZoneGraph::Query::FindNearestLocationOnLane(Storage, NearbyLane, SearchBox, NearestLocationOnLane, DistanceSq);
+			if (NearestLocationOnLane.IsValid())
+			{
+				OutLocations.Add(NearestLocationOnLane);
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMassTrafficLaneSegmentGridBenchmark, "MassTraffic.LaneSegmentGrid.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+// Compare finding the lanes near obstacles through the zone graph queries and through the lane segment grid, as the
+// number of obstacles grows
+bool FMassTrafficLaneSegmentGridBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace MassTrafficLaneSegmentGridTests;
+
+	FZoneGraphStorage Storage;
+	TArray<FZoneGraphTrafficLaneData> TrafficLanes;
+	BuildCity(Storage, TrafficLanes);
+
+	double StartTime = FPlatformTime::Seconds();
+	FMassTrafficLaneSegmentGrid Grid;
+	Grid.Build(Storage, TrafficLanes, CellSize);
+	const double BuildTime = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("%d lanes, %d segments, %dx%d cells, built in %.3fms"), Storage.Lanes.Num(), Grid.GetNumSegments(), Grid.GetNumCells().X, Grid.GetNumCells().Y, BuildTime * 1000.0));
+
+	FRandomStream Random(0x0B57AC1E);
+
+	for (const int32 NumObstacles : { 100, 1000, 10000 })
+	{
+		// Obstacles are mostly on the road, and some are on the sidewalks or in the middle of the blocks
+		TArray<FVector> ObstacleLocations;
+		ObstacleLocations.SetNumUninitialized(NumObstacles);
+		for (FVector& Location : ObstacleLocations)
+		{
+			const float Along = Random.FRandRange(0.0f, NumBlocks * BlockSize);
+			const float Across = Random.RandRange(0, NumBlocks) * BlockSize + Random.FRandRange(-1000.0f, 1000.0f);
+			Location = Random.FRand() < 0.5f ? FVector(Along, Across, 0.0f) : FVector(Across, Along, 0.0f);
+		}
+
+		TArray<FZoneGraphLaneHandle> NearbyLanes;
+		TArray<FZoneGraphLaneLocation> ZoneGraphLocations;
+		TArray<FMassTrafficLaneSegmentGrid::FLaneLocation> GridLocations;
+
+		// Sum the distances so the queries can't be optimized away
+		double ZoneGraphChecksum = 0.0;
+		double GridChecksum = 0.0;
+
+		StartTime = FPlatformTime::Seconds();
+		for (const FVector& Location : ObstacleLocations)
+		{
+			ZoneGraphLocations.Reset();
+			FindNearestLocationsOnLanes(Storage, MakeSearchBox(Location), NearbyLanes, ZoneGraphLocations);
+			for (const FZoneGraphLaneLocation& LaneLocation : ZoneGraphLocations)
+			{
+				ZoneGraphChecksum += LaneLocation.DistanceAlongLane;
+			}
+		}
+		const double ZoneGraphTime = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (const FVector& Location : ObstacleLocations)
+		{
+			GridLocations.Reset();
+			Grid.FindNearestLocationsOnLanes(MakeSearchBox(Location), GridLocations);
+			for (const FMassTrafficLaneSegmentGrid::FLaneLocation& LaneLocation : GridLocations)
+			{
+				GridChecksum += LaneLocation.DistanceAlongLane;
+			}
+		}
+		const double GridTime = FPlatformTime::Seconds() - StartTime;
+
+		// Both paths must find the same lanes at the same distances
+		int32 Mismatches = 0;
+		for (const FVector& Location : ObstacleLocations)
+		{
+			const FBox SearchBox = MakeSearchBox(Location);
+
+			ZoneGraphLocations.Reset();
+			FindNearestLocationsOnLanes(Storage, SearchBox, NearbyLanes, ZoneGraphLocations);
+
+			GridLocations.Reset();
+			Grid.FindNearestLocationsOnLanes(SearchBox, GridLocations);
+
+			if (ZoneGraphLocations.Num() != GridLocations.Num())
+			{
+				++Mismatches;
+				continue;
+			}
+
+			for (const FZoneGraphLaneLocation& LaneLocation : ZoneGraphLocations)
+			{
+				const FMassTrafficLaneSegmentGrid::FLaneLocation* GridLocation = GridLocations.FindByPredicate([&LaneLocation](const FMassTrafficLaneSegmentGrid::FLaneLocation& Candidate)
+				{
+					return Candidate.LaneHandle == LaneLocation.LaneHandle;
+				});
+
+				if (!GridLocation || !FMath::IsNearlyEqual(GridLocation->DistanceAlongLane, LaneLocation.DistanceAlongLane, 1.0f))
+				{
+					++Mismatches;
+					break;
+				}
+			}
+		}
+
+		TestEqual(FString::Printf(TEXT("%d obstacles: queries that differ from the zone graph"), NumObstacles), Mismatches, 0);
+
+		AddInfo(FString::Printf(TEXT("%d obstacles: zone graph %.3fms, lane segment grid %.3fms (%.2fx) (checksums %.1f, %.1f)"),
+			NumObstacles, ZoneGraphTime * 1000.0, GridTime * 1000.0, GridTime > 0.0 ? ZoneGraphTime / GridTime : 0.0, ZoneGraphChecksum, GridChecksum));
+	}
+
+	return true;
+}
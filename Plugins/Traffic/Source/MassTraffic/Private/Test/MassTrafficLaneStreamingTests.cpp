@@ -0,0 +1,167 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#include "MassTrafficSettings.h"
+#include "MassTrafficSimulationHarness.h"
+#include "MassTrafficSubsystem.h"
+#include "MassTrafficTypes.h"
+#include "ZoneGraphData.h"
+
+namespace MassTrafficLaneStreamingTests
+{
+	// World partition cells, each holding its own zone graph data
+	static const int32 NumCells = 9;
+	static const int32 NumStreamingEvents = 200;
+
+	struct FCell
+	{
+		AZoneGraphData* ZoneGraphData = nullptr;
+
+		// Handle and lane data address of the cell's last registration
+		FZoneGraphDataHandle DataHandle;
+		const FZoneGraphTrafficLaneData* TrafficLaneData = nullptr;
+	};
+
+	static bool IsInTrafficLaneData(const FMassTrafficZoneGraphData& TrafficZoneGraphData, const FZoneGraphTrafficLaneData* TrafficLaneData)
+	{
+		const FZoneGraphTrafficLaneData* Begin = TrafficZoneGraphData.TrafficLaneDataArray.GetData();
+		return TrafficLaneData >= Begin && TrafficLaneData < Begin + TrafficZoneGraphData.TrafficLaneDataArray.Num();
+	}
+
+	static bool IsLinked(const FZoneGraphStorage& Storage, const FMassTrafficZoneGraphData& TrafficZoneGraphData, const int32 LaneIndex, const EZoneLaneLinkType Type, const FZoneGraphTrafficLaneData* LinkedTrafficLaneData)
+	{
+		const FZoneLaneData& Lane = Storage.Lanes[LaneIndex];
+		for (int32 LinkIndex = Lane.LinksBegin; LinkIndex < Lane.LinksEnd; ++LinkIndex)
+		{
+			const FZoneLaneLinkData& Link = Storage.LaneLinks[LinkIndex];
+			if (Link.Type == Type && TrafficZoneGraphData.GetTrafficLaneData(Link.DestLaneIndex) == LinkedTrafficLaneData)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Check the lane data of a registered cell matches its storage, and that its lane links never leave it
+	static void TestCellLaneData(FAutomationTestBase& Test, const FZoneGraphStorage& Storage, const FMassTrafficZoneGraphData& TrafficZoneGraphData)
+	{
+		Test.TestEqual(TEXT("Lookup size"), TrafficZoneGraphData.TrafficLaneDataLookup.Num(), Storage.Lanes.Num());
+		Test.TestEqual(TEXT("Traffic lanes"), TrafficZoneGraphData.TrafficLaneDataArray.Num(), Storage.Lanes.Num());
+
+		for (int32 LaneIndex = 0; LaneIndex < Storage.Lanes.Num(); ++LaneIndex)
+		{
+			const FZoneGraphTrafficLaneData* TrafficLaneData = TrafficZoneGraphData.GetTrafficLaneData(LaneIndex);
+			if (!Test.TestNotNull(TEXT("Traffic lane data"), TrafficLaneData))
+			{
+				continue;
+			}
+
+			Test.TestTrue(TEXT("Lookup resolves to the lane"), TrafficLaneData->LaneHandle == FZoneGraphLaneHandle(LaneIndex, Storage.DataHandle));
+
+			Test.TestEqual(TEXT("Next lanes"), TrafficLaneData->NextLanes.Num(), 1);
+			for (const FZoneGraphTrafficLaneData* NextLane : TrafficLaneData->NextLanes)
+			{
+				Test.TestTrue(TEXT("Next lanes stay in the cell"), IsInTrafficLaneData(TrafficZoneGraphData, NextLane));
+				Test.TestTrue(TEXT("Next lanes are outgoing links"), IsLinked(Storage, TrafficZoneGraphData, LaneIndex, EZoneLaneLinkType::Outgoing, NextLane));
+			}
+
+			for (const FZoneGraphTrafficLaneData* AdjacentLane : { TrafficLaneData->LeftLane, TrafficLaneData->RightLane })
+			{
+				if (AdjacentLane)
+				{
+					Test.TestTrue(TEXT("Adjacent lanes stay in the cell"), IsInTrafficLaneData(TrafficZoneGraphData, AdjacentLane));
+					Test.TestTrue(TEXT("Adjacent lanes are adjacent links"), IsLinked(Storage, TrafficZoneGraphData, LaneIndex, EZoneLaneLinkType::Adjacent, AdjacentLane));
+				}
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMassTrafficLaneStreamingTest, "MassTraffic.LaneStreaming.Integrity", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Stream cells in and out in random order, checking each cell's lane data is built and released on its own and that
+// lane links stay intact
+bool FMassTrafficLaneStreamingTest::RunTest(const FString& Parameters)
+{
+	using namespace MassTrafficLaneStreamingTests;
+
+	const FZoneGraphTagMask LaneTags = FMassTrafficSimulationHarness::FindTrafficLaneTags(*GetDefault<UMassTrafficSettings>());
+	if (!TestTrue(TEXT("Traffic lane tags"), LaneTags != FZoneGraphTagMask::None))
+	{
+		return false;
+	}
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, /*bInformEngineOfWorld*/false, MakeUniqueObjectName(GetTransientPackage(), UWorld::StaticClass(), TEXT("MassTrafficLaneStreamingTest")));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	const UMassTrafficSubsystem* TrafficSubsystem = UWorld::GetSubsystem<UMassTrafficSubsystem>(World);
+	if (TestNotNull(TEXT("Traffic subsystem"), TrafficSubsystem))
+	{
+		FRandomStream RandomStream(0x57AE);
+		TArray<FCell> Cells;
+		Cells.SetNum(NumCells);
+
+		for (int32 Event = 0; Event < NumStreamingEvents; ++Event)
+		{
+			const int32 CellIndex = RandomStream.RandRange(0, NumCells - 1);
+			FCell& StreamedCell = Cells[CellIndex];
+
+			if (StreamedCell.ZoneGraphData)
+			{
+				World->DestroyActor(StreamedCell.ZoneGraphData);
+				StreamedCell.ZoneGraphData = nullptr;
+			}
+			else
+			{
+				// Vary the lane count so cells have different lane layouts
+				FMassTrafficSimulationHarness::FSettings CellSettings;
+				CellSettings.NumRoadsPerAxis = 1;
+				CellSettings.NumSegmentsPerRoad = 8 + CellIndex;
+				CellSettings.NumLanesPerRoad = 1 + CellIndex % 3;
+
+				StreamedCell.ZoneGraphData = World->SpawnActorDeferred<AZoneGraphData>(AZoneGraphData::StaticClass(), FTransform::Identity);
+				FMassTrafficSimulationHarness::MakeSyntheticLanes(CellSettings, LaneTags, StreamedCell.ZoneGraphData->GetStorageMutable());
+				StreamedCell.ZoneGraphData->FinishSpawning(FTransform::Identity);
+
+				StreamedCell.DataHandle = StreamedCell.ZoneGraphData->GetStorage().DataHandle;
+				StreamedCell.TrafficLaneData = TrafficSubsystem->HasTrafficDataForZoneGraph(StreamedCell.DataHandle) ?
+					TrafficSubsystem->GetTrafficZoneGraphData(StreamedCell.DataHandle)->TrafficLaneDataArray.GetData() : nullptr;
+			}
+
+			for (const FCell& Cell : Cells)
+			{
+				if (!Cell.DataHandle.IsValid())
+				{
+					continue;
+				}
+
+				if (!Cell.ZoneGraphData)
+				{
+					TestFalse(TEXT("Unloaded cells have no lane data"), TrafficSubsystem->HasTrafficDataForZoneGraph(Cell.DataHandle));
+					continue;
+				}
+
+				if (!TestTrue(TEXT("Loaded cells have lane data"), TrafficSubsystem->HasTrafficDataForZoneGraph(Cell.DataHandle)))
+				{
+					continue;
+				}
+
+				const FMassTrafficZoneGraphData& TrafficZoneGraphData = *TrafficSubsystem->GetTrafficZoneGraphData(Cell.DataHandle);
+				TestTrue(TEXT("Lane data isn't rebuilt when other cells stream"), TrafficZoneGraphData.TrafficLaneDataArray.GetData() == Cell.TrafficLaneData);
+				TestCellLaneData(*this, Cell.ZoneGraphData->GetStorage(), TrafficZoneGraphData);
+			}
+		}
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(/*bInformEngineOfWorld*/false);
+
+	return true;
+}
@@ -0,0 +1,275 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#include "MassCommandBuffer.h"
+#include "MassEntityManager.h"
+#include "MassTrafficFragments.h"
+#include "MassTrafficLaneVehicles.h"
+#include "MassTrafficMovement.h"
+#include "MassTrafficTypes.h"
+#include "MassTrafficUtils.h"
+#include "MassZoneGraphNavigationFragments.h"
+
+namespace MassTrafficLaneVehiclesTests
+{
+	// Downtown blocks are short and packed with slow traffic
+	static const int32 NumLanes = 4000;
+	static const int32 VehiclesPerLane = 16;
+	static const float LaneLength = 10000.0f;
+	static const float SpaceTaken = 600.0f;
+
+	static const int32 NumQueriesPerLane = 8;
+
+	// Lanes of a dense downtown graph with every vehicle linked to the one ahead of it, and the front vehicle of each lane
+	// linked to the tail of the next lane. Entities are shuffled so, like in a running simulation, following vehicles
+	// aren't next to each other in memory.
+	static void BuildDowntown(FMassEntityManager& EntityManager, TArray<FZoneGraphTrafficLaneData>& OutTrafficLanes, FRandomStream& Random)
+	{
+		TArray<const UScriptStruct*> FragmentTypes = { FMassZoneGraphLaneLocationFragment::StaticStruct(), FMassTrafficNextVehicleFragment::StaticStruct() };
+		const FMassArchetypeHandle Archetype = EntityManager.CreateArchetype(MakeArrayView(FragmentTypes));
+
+		TArray<FMassEntityHandle> Entities;
+		EntityManager.BatchCreateEntities(Archetype, NumLanes * VehiclesPerLane, Entities);
+
+		for (int32 Index = Entities.Num() - 1; Index > 0; --Index)
+		{
+			Entities.Swap(Index, Random.RandRange(0, Index));
+		}
+
+		OutTrafficLanes.SetNum(NumLanes);
+		for (int32 LaneIndex = 0; LaneIndex < NumLanes; ++LaneIndex)
+		{
+			FZoneGraphTrafficLaneData& TrafficLaneData = OutTrafficLanes[LaneIndex];
+			TrafficLaneData.LaneHandle = FZoneGraphLaneHandle(LaneIndex, FZoneGraphDataHandle(0, 1));
+			TrafficLaneData.Length = LaneLength;
+			TrafficLaneData.ClearVehicles();
+
+			for (int32 VehicleIndex = 0; VehicleIndex < VehiclesPerLane; ++VehicleIndex)
+			{
+				const FMassEntityHandle Entity = Entities[LaneIndex * VehiclesPerLane + VehicleIndex];
+				const float DistanceAlongLane = (VehicleIndex + Random.FRand()) * (LaneLength / VehiclesPerLane);
+				const float Speed = Random.FRandRange(0.0f, 1500.0f);
+
+				FMassZoneGraphLaneLocationFragment& LaneLocationFragment = EntityManager.GetFragmentDataChecked<FMassZoneGraphLaneLocationFragment>(Entity);
+				LaneLocationFragment.LaneHandle = TrafficLaneData.LaneHandle;
+				LaneLocationFragment.DistanceAlongLane = DistanceAlongLane;
+				LaneLocationFragment.LaneLength = LaneLength;
+
+				const int32 NextIndex = VehicleIndex < VehiclesPerLane - 1 ? LaneIndex * VehiclesPerLane + VehicleIndex + 1 : ((LaneIndex + 1) % NumLanes) * VehiclesPerLane;
+				EntityManager.GetFragmentDataChecked<FMassTrafficNextVehicleFragment>(Entity).SetNextVehicle(Entity, Entities[NextIndex]);
+
+				TrafficLaneData.AddVehicleOccupancy(SpaceTaken);
+				TrafficLaneData.Vehicles.Add(Entity, DistanceAlongLane, Speed, SpaceTaken);
+			}
+
+			TrafficLaneData.TailVehicle = Entities[LaneIndex * VehiclesPerLane];
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMassTrafficLaneVehiclesRecycleTest, "MassTraffic.LaneVehicles.Recycle", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Check vehicles recycled or destroyed leave the index of their lane along with their deferred tag change or destruction
+bool FMassTrafficLaneVehiclesRecycleTest::RunTest(const FString& Parameters)
+{
+	using namespace MassTrafficLaneVehiclesTests;
+
+	TSharedPtr<FMassEntityManager> EntityManager = MakeShareable(new FMassEntityManager());
+	EntityManager->Initialize();
+
+	TArray<const UScriptStruct*> FragmentAndTagTypes = { FMassZoneGraphLaneLocationFragment::StaticStruct(), FMassTrafficVehicleTag::StaticStruct() };
+	TArray<FMassEntityHandle> Vehicles;
+	EntityManager->BatchCreateEntities(EntityManager->CreateArchetype(MakeArrayView(FragmentAndTagTypes)), 4, Vehicles);
+
+	FZoneGraphTrafficLaneData TrafficLaneData;
+	TrafficLaneData.LaneHandle = FZoneGraphLaneHandle(0, FZoneGraphDataHandle(0, 1));
+	TrafficLaneData.Length = LaneLength;
+	for (int32 VehicleIndex = 0; VehicleIndex < Vehicles.Num(); ++VehicleIndex)
+	{
+		TrafficLaneData.Vehicles.Add(Vehicles[VehicleIndex], (VehicleIndex + 0.5f) * SpaceTaken, 0.0f, SpaceTaken);
+	}
+
+	// Vehicle 1 is recycled and vehicle 2 destroyed, as by UMassTrafficRecycleVehiclesOverlappingPlayersProcessor
+	EntityManager->Defer().SwapTags<FMassTrafficVehicleTag, FMassTrafficRecyclableVehicleTag>(Vehicles[1]);
+	UE::MassTraffic::DeferRemoveVehicleFromLane(EntityManager->Defer(), Vehicles[1], TrafficLaneData);
+	EntityManager->Defer().DestroyEntity(Vehicles[2]);
+	UE::MassTraffic::DeferRemoveVehicleFromLane(EntityManager->Defer(), Vehicles[2], TrafficLaneData);
+
+	TestEqual(TEXT("Vehicles stay on the lane until the commands are flushed"), TrafficLaneData.Vehicles.Num(), 4);
+
+	EntityManager->FlushCommands();
+
+	TestTrue(TEXT("The recycled vehicle is recyclable"), EntityManager->GetArchetypeComposition(EntityManager->GetArchetypeForEntity(Vehicles[1])).Tags.Contains<FMassTrafficRecyclableVehicleTag>());
+	TestFalse(TEXT("The destroyed vehicle is gone"), EntityManager->IsEntityValid(Vehicles[2]));
+	TestEqual(TEXT("Recycled and destroyed vehicles leave the lane"), TrafficLaneData.Vehicles.Num(), 2);
+	TestEqual(TEXT("The recycled vehicle isn't on the lane"), TrafficLaneData.Vehicles.IndexOf(Vehicles[1]), (int32)INDEX_NONE);
+	TestEqual(TEXT("The destroyed vehicle isn't on the lane"), TrafficLaneData.Vehicles.IndexOf(Vehicles[2]), (int32)INDEX_NONE);
+
+	// The vehicle ahead of the first one is now the last one
+	const int32 AheadIndex = TrafficLaneData.Vehicles.FindFirstAhead(0.5f * SpaceTaken);
+	TestTrue(TEXT("Lane queries skip vehicles that left"), AheadIndex < TrafficLaneData.Vehicles.Num() && TrafficLaneData.Vehicles.GetEntities()[AheadIndex] == Vehicles[3]);
+
+	// Teleporting the recycled vehicle later removes it from a lane it already left
+	TestFalse(TEXT("Removing a vehicle that already left is harmless"), TrafficLaneData.Vehicles.Remove(Vehicles[1]));
+	TestEqual(TEXT("Other vehicles stay on the lane"), TrafficLaneData.Vehicles.Num(), 2);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMassTrafficLaneVehiclesBenchmark, "MassTraffic.LaneVehicles.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+// Compare walking the vehicles of dense lanes along their NextVehicle links with scanning the packed vehicle index, for
+// whole lane scans and for finding the vehicles around a distance along a lane
+bool FMassTrafficLaneVehiclesBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace MassTrafficLaneVehiclesTests;
+
+	TSharedPtr<FMassEntityManager> EntityManager = MakeShareable(new FMassEntityManager());
+	EntityManager->Initialize();
+
+	FRandomStream Random(0x0B57AC1E);
+
+	TArray<FZoneGraphTrafficLaneData> TrafficLanes;
+	BuildDowntown(*EntityManager, TrafficLanes, Random);
+
+	AddInfo(FString::Printf(TEXT("%d lanes, %d vehicles per lane"), NumLanes, VehiclesPerLane));
+
+	// Sum the distances so the scans can't be optimized away
+	double LinkedChecksum = 0.0;
+	double PackedChecksum = 0.0;
+	int32 NumLinkedVehicles = 0;
+
+	double StartTime = FPlatformTime::Seconds();
+	for (const FZoneGraphTrafficLaneData& TrafficLaneData : TrafficLanes)
+	{
+		TrafficLaneData.ForEachVehicleOnLane(*EntityManager, [&](const FMassEntityView& VehicleEntityView, FMassTrafficNextVehicleFragment& NextVehicleFragment, FMassZoneGraphLaneLocationFragment& LaneLocationFragment)
+		{
+			LinkedChecksum += LaneLocationFragment.DistanceAlongLane;
+			++NumLinkedVehicles;
+			return true;
+		});
+	}
+	const double LinkedScanTime = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for (const FZoneGraphTrafficLaneData& TrafficLaneData : TrafficLanes)
+	{
+		for (const float DistanceAlongLane : TrafficLaneData.Vehicles.GetDistancesAlongLane())
+		{
+			PackedChecksum += DistanceAlongLane;
+		}
+	}
+	const double PackedScanTime = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("Lane scans: linked %.3fms, packed %.3fms"), LinkedScanTime * 1000.0, PackedScanTime * 1000.0));
+
+	TestEqual(TEXT("Both scans visit every vehicle"), NumLinkedVehicles, NumLanes * VehiclesPerLane);
+	TestEqual(TEXT("Both scans visit the same distances"), (float)LinkedChecksum, (float)PackedChecksum);
+
+	// Find the vehicles behind and ahead of random distances along each lane
+	TArray<float> QueryDistances;
+	QueryDistances.SetNumUninitialized(NumLanes * NumQueriesPerLane);
+	for (float& Distance : QueryDistances)
+	{
+		Distance = Random.FRandRange(0.0f, LaneLength);
+	}
+
+	TArray<FMassEntityHandle> LinkedBehind;
+	LinkedBehind.SetNumUninitialized(QueryDistances.Num());
+	TArray<FMassEntityHandle> LinkedAhead;
+	LinkedAhead.SetNumUninitialized(QueryDistances.Num());
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 QueryIndex = 0; QueryIndex < QueryDistances.Num(); ++QueryIndex)
+	{
+		UE::MassTraffic::FindNearestVehiclesInLane(*EntityManager, TrafficLanes[QueryIndex / NumQueriesPerLane], QueryDistances[QueryIndex], LinkedBehind[QueryIndex], LinkedAhead[QueryIndex]);
+	}
+	const double LinkedQueryTime = FPlatformTime::Seconds() - StartTime;
+
+	TArray<FMassEntityHandle> PackedAhead;
+	PackedAhead.SetNumUninitialized(QueryDistances.Num());
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 QueryIndex = 0; QueryIndex < QueryDistances.Num(); ++QueryIndex)
+	{
+		const FMassTrafficLaneVehicles& Vehicles = TrafficLanes[QueryIndex / NumQueriesPerLane].Vehicles;
+		const int32 AheadIndex = Vehicles.FindFirstAhead(QueryDistances[QueryIndex]);
+		PackedAhead[QueryIndex] = AheadIndex < Vehicles.Num() ? Vehicles.GetEntities()[AheadIndex] : FMassEntityHandle();
+	}
+	const double PackedQueryTime = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("%d vehicle ahead queries: linked %.3fms, packed %.3fms"), QueryDistances.Num(), LinkedQueryTime * 1000.0, PackedQueryTime * 1000.0));
+
+	int32 Mismatches = 0;
+	for (int32 QueryIndex = 0; QueryIndex < QueryDistances.Num(); ++QueryIndex)
+	{
+		Mismatches += LinkedAhead[QueryIndex] != PackedAhead[QueryIndex] ? 1 : 0;
+	}
+	TestEqual(TEXT("Both paths find the same vehicle ahead"), Mismatches, 0);
+
+	// The obstacle search takes the vehicle behind from the index instead
+	Mismatches = 0;
+	for (int32 QueryIndex = 0; QueryIndex < QueryDistances.Num(); ++QueryIndex)
+	{
+		const FMassTrafficLaneVehicles& Vehicles = TrafficLanes[QueryIndex / NumQueriesPerLane].Vehicles;
+		const int32 AheadIndex = Vehicles.FindFirstAtOrAhead(QueryDistances[QueryIndex]);
+		const FMassEntityHandle PackedBehind = AheadIndex > 0 ? Vehicles.GetEntities()[AheadIndex - 1] : FMassEntityHandle();
+		Mismatches += LinkedBehind[QueryIndex] != PackedBehind ? 1 : 0;
+	}
+	TestEqual(TEXT("Both paths find the same vehicle behind"), Mismatches, 0);
+
+	// Resolve the index of every vehicle as the refresh does, a lane at a time with vehicles in no particular order
+	Mismatches = 0;
+	TArray<FMassEntityHandle> LaneEntities;
+	TArray<int32> VehicleIndices;
+	for (const FZoneGraphTrafficLaneData& TrafficLaneData : TrafficLanes)
+	{
+		const TConstArrayView<FMassEntityHandle> Entities = TrafficLaneData.Vehicles.GetEntities();
+		LaneEntities.Reset();
+		LaneEntities.Append(Entities.GetData(), Entities.Num());
+		for (int32 Index = LaneEntities.Num() - 1; Index > 0; --Index)
+		{
+			LaneEntities.Swap(Index, Random.RandRange(0, Index));
+		}
+		LaneEntities.Add(FMassEntityHandle());
+
+		VehicleIndices.SetNumUninitialized(LaneEntities.Num());
+		TrafficLaneData.Vehicles.FindIndices(LaneEntities, VehicleIndices);
+		for (int32 Index = 0; Index < LaneEntities.Num(); ++Index)
+		{
+			Mismatches += VehicleIndices[Index] != TrafficLaneData.Vehicles.IndexOf(LaneEntities[Index]) ? 1 : 0;
+		}
+	}
+	TestEqual(TEXT("Resolving indices per lane matches IndexOf"), Mismatches, 0);
+
+	// Move every vehicle as a frame would and refresh the packed index, with a few vehicles overtaking
+	StartTime = FPlatformTime::Seconds();
+	for (FZoneGraphTrafficLaneData& TrafficLaneData : TrafficLanes)
+	{
+		const TConstArrayView<float> Distances = TrafficLaneData.Vehicles.GetDistancesAlongLane();
+		const TConstArrayView<float> Speeds = TrafficLaneData.Vehicles.GetSpeeds();
+		for (int32 VehicleIndex = 0; VehicleIndex < TrafficLaneData.Vehicles.Num(); ++VehicleIndex)
+		{
+			TrafficLaneData.Vehicles.Set(VehicleIndex, Distances[VehicleIndex] + Speeds[VehicleIndex] * 0.5f, Speeds[VehicleIndex]);
+		}
+		TrafficLaneData.Vehicles.RestoreOrder();
+	}
+	const double RefreshTime = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("Refreshing every lane: %.3fms"), RefreshTime * 1000.0));
+
+	int32 NumOutOfOrder = 0;
+	for (const FZoneGraphTrafficLaneData& TrafficLaneData : TrafficLanes)
+	{
+		const TConstArrayView<float> Distances = TrafficLaneData.Vehicles.GetDistancesAlongLane();
+		for (int32 VehicleIndex = 1; VehicleIndex < Distances.Num(); ++VehicleIndex)
+		{
+			NumOutOfOrder += Distances[VehicleIndex - 1] > Distances[VehicleIndex] ? 1 : 0;
+		}
+	}
+	TestEqual(TEXT("Vehicles are back in distance order"), NumOutOfOrder, 0);
+
+	return true;
+}
@@ -0,0 +1,126 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Dom/JsonObject.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+#include "MassTrafficSimulationHarness.h"
+#include "ZoneGraphTypes.h"
+
+namespace MassTrafficSimulationHarnessTests
+{
+	// A single small ring road, enough for vehicles to queue, follow and change lanes in a few seconds
+	static FMassTrafficSimulationHarness::FSettings MakeSettings()
+	{
+		FMassTrafficSimulationHarness::FSettings Settings;
+		Settings.NumSteps = 90;
+		Settings.NumRoadsPerAxis = 1;
+		Settings.NumSegmentsPerRoad = 16;
+		Settings.NumLanesPerRoad = 2;
+		Settings.RoadRadius = 8000.0f;
+		Settings.NumVehicles = 60;
+
+		return Settings;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMassTrafficSimulationHarnessLanesTest, "MassTraffic.SimulationHarness.Lanes", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Check the synthetic lanes form closed loops whose links agree with each other
+bool FMassTrafficSimulationHarnessLanesTest::RunTest(const FString& Parameters)
+{
+	using namespace MassTrafficSimulationHarnessTests;
+
+	const FMassTrafficSimulationHarness::FSettings Settings = MakeSettings();
+
+	FZoneGraphStorage Storage;
+	FMassTrafficSimulationHarness::MakeSyntheticLanes(Settings, FZoneGraphTagMask::All, Storage);
+
+	TestEqual(TEXT("Number of lanes"), Storage.Lanes.Num(), Settings.NumSegmentsPerRoad * Settings.NumLanesPerRoad);
+	TestEqual(TEXT("Number of zones"), Storage.Zones.Num(), Settings.NumSegmentsPerRoad);
+
+	for (int32 LaneIndex = 0; LaneIndex < Storage.Lanes.Num(); ++LaneIndex)
+	{
+		const FZoneLaneData& Lane = Storage.Lanes[LaneIndex];
+
+		int32 NumOutgoing = 0;
+		for (int32 LinkIndex = Lane.LinksBegin; LinkIndex < Lane.LinksEnd; ++LinkIndex)
+		{
+			const FZoneLaneLinkData& Link = Storage.LaneLinks[LinkIndex];
+			const FZoneLaneData& DestLane = Storage.Lanes[Link.DestLaneIndex];
+
+			if (Link.Type == EZoneLaneLinkType::Outgoing)
+			{
+				++NumOutgoing;
+				TestEqual(TEXT("Lanes end where their outgoing lane starts"), Storage.LanePoints[Lane.PointsEnd - 1], Storage.LanePoints[DestLane.PointsBegin]);
+				TestEqual(TEXT("Lanes end at their outgoing lane's entry"), Lane.EndEntryId, DestLane.StartEntryId);
+
+				bool bHasIncoming = false;
+				for (int32 DestLinkIndex = DestLane.LinksBegin; DestLinkIndex < DestLane.LinksEnd; ++DestLinkIndex)
+				{
+					const FZoneLaneLinkData& DestLink = Storage.LaneLinks[DestLinkIndex];
+					bHasIncoming |= DestLink.Type == EZoneLaneLinkType::Incoming && DestLink.DestLaneIndex == LaneIndex;
+				}
+				TestTrue(TEXT("Outgoing lanes link back as incoming"), bHasIncoming);
+			}
+			else if (Link.Type == EZoneLaneLinkType::Adjacent)
+			{
+				TestEqual(TEXT("Adjacent lanes share a zone"), DestLane.ZoneIndex, Lane.ZoneIndex);
+			}
+		}
+
+		TestEqual(TEXT("Outgoing lanes"), NumOutgoing, 1);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMassTrafficSimulationHarnessDeterminismTest, "MassTraffic.SimulationHarness.Determinism", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Run the simulation twice with the same seed and once with another, and compare the step hashes. Vehicles near the viewer have
+// simple physics, so the physics processor's sims are covered too
+bool FMassTrafficSimulationHarnessDeterminismTest::RunTest(const FString& Parameters)
+{
+	using namespace MassTrafficSimulationHarnessTests;
+
+	FMassTrafficSimulationHarness::FSettings Settings = MakeSettings();
+
+	const FMassTrafficSimulationHarness::FRun FirstRun = FMassTrafficSimulationHarness::Run(Settings);
+	const FMassTrafficSimulationHarness::FRun SecondRun = FMassTrafficSimulationHarness::Run(Settings);
+
+	if (!TestTrue(TEXT("First run succeeded"), FirstRun.bSuccess) || !TestTrue(TEXT("Second run succeeded"), SecondRun.bSuccess))
+	{
+		return false;
+	}
+
+	TestTrue(TEXT("Vehicles were spawned"), FirstRun.NumVehicles > 0);
+	TestEqual(TEXT("Number of step hashes"), FirstRun.StepHashes.Num(), Settings.NumSteps);
+	TestTrue(TEXT("Same step hashes"), SecondRun.StepHashes == FirstRun.StepHashes);
+	TestTrue(TEXT("Vehicles moved"), FirstRun.StepHashes[0] != FirstRun.StepHashes.Last());
+	TestTrue(TEXT("Vehicles were simulated with physics"), FirstRun.MaxNumPhysicsVehicles > 0);
+
+	const FString Report = FMassTrafficSimulationHarness::MakeReport(Settings, FirstRun);
+	TestEqual(TEXT("Divergent step of an identical run"), FMassTrafficSimulationHarness::FindFirstDivergentStep(Report, SecondRun), (int32)INDEX_NONE);
+
+	TSharedPtr<FJsonObject> Root;
+	if (!TestTrue(TEXT("Report is valid JSON"), FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Report), Root) && Root.IsValid()))
+	{
+		return false;
+	}
+
+	TestEqual(TEXT("Report version"), (int32)Root->GetNumberField(TEXT("Version")), FMassTrafficSimulationHarness::ReportVersion);
+	TestEqual(TEXT("Reported step hashes"), Root->GetArrayField(TEXT("StepHashes")).Num(), Settings.NumSteps);
+	TestTrue(TEXT("Report has processor timings"), Root->GetObjectField(TEXT("Processors"))->HasField(TEXT("MassTrafficVehicleControlProcessor")));
+
+	Settings.Seed += 1;
+	const FMassTrafficSimulationHarness::FRun OtherSeedRun = FMassTrafficSimulationHarness::Run(Settings);
+	TestEqual(TEXT("Divergent step of another seed"), FMassTrafficSimulationHarness::FindFirstDivergentStep(Report, OtherSeedRun), 0);
+
+	Settings.bSimplePhysics = false;
+	const FMassTrafficSimulationHarness::FRun NoPhysicsRun = FMassTrafficSimulationHarness::Run(Settings);
+	TestTrue(TEXT("Run without physics succeeded"), NoPhysicsRun.bSuccess);
+	TestEqual(TEXT("Vehicles simulated with physics without it"), NoPhysicsRun.MaxNumPhysicsVehicles, 0);
+
+	return true;
+}
@@ -0,0 +1,316 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#include "MassCommonFragments.h"
+#include "MassEntityManager.h"
+#include "MassEntityQuery.h"
+#include "MassExecutionContext.h"
+#include "MassTraffic.h"
+#include "MassTrafficFragments.h"
+#include "MassTrafficPhysics.h"
+#include "MassTrafficSleepIslands.h"
+#include "MassTrafficTypes.h"
+
+namespace MassTrafficSleepIslandsTests
+{
+	// A gridlocked downtown, every lane backed up with stopped traffic
+	static const int32 NumLanes = 4000;
+	static const int32 VehiclesPerLane = 16;
+	static const float SpaceTaken = 600.0f;
+
+	// Lanes whose light turns green this frame
+	static const float ReleasedLaneFraction = 0.05f;
+
+	static FMassArchetypeHandle CreateVehicleArchetype(FMassEntityManager& EntityManager)
+	{
+		TArray<const UScriptStruct*> FragmentTypes = {
+			FMassTrafficPIDVehicleControlFragment::StaticStruct(),
+			FMassTrafficVehicleControlFragment::StaticStruct(),
+			FMassTrafficVehiclePhysicsFragment::StaticStruct(),
+			FTransformFragment::StaticStruct()
+		};
+		return EntityManager.CreateArchetype(MakeArrayView(FragmentTypes));
+	}
+
+	static void PutToSleep(FMassEntityManager& EntityManager, const FMassEntityHandle Vehicle)
+	{
+		EntityManager.GetFragmentDataChecked<FMassTrafficVehiclePhysicsFragment>(Vehicle).VehicleSim.SleepCounter = GMassTrafficSleepCounterThreshold;
+	}
+
+	static bool IsSleeping(FMassEntityManager& EntityManager, const FMassEntityHandle Vehicle)
+	{
+		return EntityManager.GetFragmentDataChecked<FMassTrafficVehiclePhysicsFragment>(Vehicle).VehicleSim.IsSleeping();
+	}
+
+	// Sleeping vehicles queued bumper to bumper on every lane, with the vehicles at the head of some lanes given throttle
+	static void BuildGridlock(FMassEntityManager& EntityManager, TArray<FZoneGraphTrafficLaneData>& OutTrafficLanes, FRandomStream& Random)
+	{
+		TArray<FMassEntityHandle> Entities;
+		EntityManager.BatchCreateEntities(CreateVehicleArchetype(EntityManager), NumLanes * VehiclesPerLane, Entities);
+
+		for (int32 Index = Entities.Num() - 1; Index > 0; --Index)
+		{
+			Entities.Swap(Index, Random.RandRange(0, Index));
+		}
+
+		OutTrafficLanes.SetNum(NumLanes);
+		for (int32 LaneIndex = 0; LaneIndex < NumLanes; ++LaneIndex)
+		{
+			FZoneGraphTrafficLaneData& TrafficLaneData = OutTrafficLanes[LaneIndex];
+			TrafficLaneData.LaneHandle = FZoneGraphLaneHandle(LaneIndex, FZoneGraphDataHandle(0, 1));
+			TrafficLaneData.Length = VehiclesPerLane * SpaceTaken;
+
+			for (int32 VehicleIndex = 0; VehicleIndex < VehiclesPerLane; ++VehicleIndex)
+			{
+				const FMassEntityHandle Vehicle = Entities[LaneIndex * VehiclesPerLane + VehicleIndex];
+				TrafficLaneData.Vehicles.Add(Vehicle, (VehicleIndex + 0.5f) * SpaceTaken, 0.0f, SpaceTaken);
+				PutToSleep(EntityManager, Vehicle);
+			}
+
+			if (Random.FRand() < ReleasedLaneFraction)
+			{
+				const FMassEntityHandle HeadVehicle = TrafficLaneData.Vehicles.GetEntities().Last();
+				EntityManager.GetFragmentDataChecked<FMassTrafficPIDVehicleControlFragment>(HeadVehicle).Throttle = 1.0f;
+			}
+		}
+	}
+
+	// @see UMassTrafficVehiclePhysicsProcessor::ProcessSleeping
+	static bool ProcessSleeping(const FMassTrafficVehicleControlFragment& VehicleControlFragment, const FMassTrafficPIDVehicleControlFragment& PIDVehicleControlFragment, FMassTrafficVehiclePhysicsFragment& SimplePhysicsVehicleFragment)
+	{
+		const bool bControlInputPressed = PIDVehicleControlFragment.Throttle >= GMassTrafficControlInputWakeTolerance;
+		if (SimplePhysicsVehicleFragment.VehicleSim.IsSleeping())
+		{
+			if (!bControlInputPressed)
+			{
+				return true;
+			}
+			SimplePhysicsVehicleFragment.VehicleSim.WakeFromSleep();
+			return false;
+		}
+
+		if (!bControlInputPressed && VehicleControlFragment.Speed < GMassTrafficLinearSpeedSleepThreshold)
+		{
+			return SimplePhysicsVehicleFragment.VehicleSim.IncrementSleepCounter();
+		}
+
+		SimplePhysicsVehicleFragment.VehicleSim.WakeFromSleep();
+		return false;
+	}
+
+	// The per vehicle part of a simple vehicle physics frame up to the point sleeping vehicles are skipped. With sleep
+	// islands, the heads of islands left sleeping are skipped before their inputs are read.
+	static int32 RunSleepPass(FMassEntityManager& EntityManager, FMassEntityQuery& Query, const bool bSleepIslands, double& OutChecksum)
+	{
+		int32 NumSimulated = 0;
+
+		FMassExecutionContext ExecutionContext(EntityManager);
+		Query.ForEachEntityChunk(EntityManager, ExecutionContext, [&](FMassExecutionContext& QueryContext)
+		{
+			const TConstArrayView<FMassTrafficPIDVehicleControlFragment> PIDVehicleControlFragments = QueryContext.GetFragmentView<FMassTrafficPIDVehicleControlFragment>();
+			const TConstArrayView<FMassTrafficVehicleControlFragment> VehicleControlFragments = QueryContext.GetFragmentView<FMassTrafficVehicleControlFragment>();
+			const TArrayView<FMassTrafficVehiclePhysicsFragment> SimplePhysicsVehicleFragments = QueryContext.GetMutableFragmentView<FMassTrafficVehiclePhysicsFragment>();
+			const TConstArrayView<FTransformFragment> TransformFragments = QueryContext.GetFragmentView<FTransformFragment>();
+
+			for (int32 Index = 0; Index < QueryContext.GetNumEntities(); ++Index)
+			{
+				FMassTrafficVehiclePhysicsFragment& SimplePhysicsVehicleFragment = SimplePhysicsVehicleFragments[Index];
+				const bool bSleepCheckedByIsland = SimplePhysicsVehicleFragment.VehicleSim.bSleepCheckedByIsland;
+				SimplePhysicsVehicleFragment.VehicleSim.bSleepCheckedByIsland = false;
+				if (bSleepIslands && bSleepCheckedByIsland && SimplePhysicsVehicleFragment.VehicleSim.IsSleeping())
+				{
+					continue;
+				}
+
+				const FTransform VehicleWorldTransform = TransformFragments[Index].GetTransform();
+				if (ProcessSleeping(VehicleControlFragments[Index], PIDVehicleControlFragments[Index], SimplePhysicsVehicleFragment))
+				{
+					continue;
+				}
+
+				OutChecksum += VehicleWorldTransform.GetLocation().X;
+				++NumSimulated;
+			}
+		});
+
+		return NumSimulated;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMassTrafficSleepIslandsTest, "MassTraffic.SleepIslands.Wake", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Check islands follow queues, and wake together on throttle at their head, a moving vehicle or a lane wake request,
+// while other sleeping vehicles still wake on their own throttle
+bool FMassTrafficSleepIslandsTest::RunTest(const FString& Parameters)
+{
+	using namespace MassTrafficSleepIslandsTests;
+
+	TSharedPtr<FMassEntityManager> EntityManager = MakeShareable(new FMassEntityManager());
+	EntityManager->Initialize();
+
+	TArray<FMassEntityHandle> Vehicles;
+	EntityManager->BatchCreateEntities(CreateVehicleArchetype(*EntityManager), 6, Vehicles);
+
+	// A vehicle in no lane index, such as one waiting to be recycled
+	TArray<FMassEntityHandle> LaneLessVehicles;
+	EntityManager->BatchCreateEntities(CreateVehicleArchetype(*EntityManager), 1, LaneLessVehicles);
+	const FMassEntityHandle LaneLessVehicle = LaneLessVehicles[0];
+
+	FMassEntityQuery Query(EntityManager);
+	Query.AddRequirement<FMassTrafficPIDVehicleControlFragment>(EMassFragmentAccess::ReadOnly);
+	Query.AddRequirement<FMassTrafficVehicleControlFragment>(EMassFragmentAccess::ReadOnly);
+	Query.AddRequirement<FMassTrafficVehiclePhysicsFragment>(EMassFragmentAccess::ReadWrite);
+	Query.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadOnly);
+	double Checksum = 0.0;
+
+	// Two queues of three vehicles, far apart on the same lane
+	TArray<FZoneGraphTrafficLaneData> TrafficLanes;
+	FZoneGraphTrafficLaneData& TrafficLaneData = TrafficLanes.AddDefaulted_GetRef();
+	const float Distances[] = { 300.0f, 900.0f, 1550.0f, 5000.0f, 5600.0f, 6200.0f };
+	for (int32 VehicleIndex = 0; VehicleIndex < Vehicles.Num(); ++VehicleIndex)
+	{
+		TrafficLaneData.Vehicles.Add(Vehicles[VehicleIndex], Distances[VehicleIndex], 0.0f, SpaceTaken);
+	}
+
+	TArray<TPair<int32, int32>> Queues;
+	UE::MassTraffic::ForEachVehicleQueue(TrafficLaneData.Vehicles, 100.0f, [&Queues](const int32 FirstVehicle, const int32 NumVehicles)
+	{
+		Queues.Emplace(FirstVehicle, NumVehicles);
+	});
+	TestEqual(TEXT("Vehicles further apart than the gap start a new queue"), Queues.Num(), 2);
+	TestTrue(TEXT("Queues are runs of consecutive vehicles"), Queues.Num() == 2 && Queues[0] == TPair<int32, int32>(0, 3) && Queues[1] == TPair<int32, int32>(3, 3));
+
+	auto PutAllToSleep = [&]()
+	{
+		for (const FMassEntityHandle Vehicle : Vehicles)
+		{
+			PutToSleep(*EntityManager, Vehicle);
+		}
+		PutToSleep(*EntityManager, LaneLessVehicle);
+	};
+
+	auto CountSleeping = [&](const int32 FirstVehicle, const int32 NumVehicles)
+	{
+		int32 NumSleeping = 0;
+		for (int32 VehicleIndex = FirstVehicle; VehicleIndex < FirstVehicle + NumVehicles; ++VehicleIndex)
+		{
+			NumSleeping += IsSleeping(*EntityManager, Vehicles[VehicleIndex]) ? 1 : 0;
+		}
+		return NumSleeping;
+	};
+
+	// At rest, nothing wakes
+	PutAllToSleep();
+	FMassTrafficSleepIslandStats Stats;
+	UE::MassTraffic::UpdateSleepIslands(*EntityManager, TrafficLanes, 100.0f, Stats);
+	TestEqual(TEXT("Islands at rest stay asleep"), CountSleeping(0, 6), 6);
+	TestEqual(TEXT("Both islands are resting"), Stats.NumRestingIslands, 2);
+	TestEqual(TEXT("Every vehicle is in a resting island"), Stats.NumVehiclesInRestingIslands, 6);
+	TestEqual(TEXT("Sleeping vehicles without throttle stay asleep"), RunSleepPass(*EntityManager, Query, /*bSleepIslands*/true, Checksum), 0);
+	TestEqual(TEXT("Islands at rest stay asleep after the physics pass"), CountSleeping(0, 6), 6);
+
+	// Throttle at the head of the front queue wakes only that queue
+	EntityManager->GetFragmentDataChecked<FMassTrafficPIDVehicleControlFragment>(Vehicles[5]).Throttle = 1.0f;
+	Stats = FMassTrafficSleepIslandStats();
+	UE::MassTraffic::UpdateSleepIslands(*EntityManager, TrafficLanes, 100.0f, Stats);
+	TestEqual(TEXT("Throttle at its head wakes the whole island"), CountSleeping(3, 3), 0);
+	TestEqual(TEXT("Other islands stay asleep"), CountSleeping(0, 3), 3);
+	TestEqual(TEXT("One island is awake"), Stats.NumAwakeIslands, 1);
+	EntityManager->GetFragmentDataChecked<FMassTrafficPIDVehicleControlFragment>(Vehicles[5]).Throttle = 0.0f;
+
+	// Throttle behind the head doesn't wake the island, but the vehicle still checks its own inputs and wakes
+	PutAllToSleep();
+	EntityManager->GetFragmentDataChecked<FMassTrafficPIDVehicleControlFragment>(Vehicles[1]).Throttle = 1.0f;
+	UE::MassTraffic::UpdateSleepIslands(*EntityManager, TrafficLanes, 100.0f, Stats);
+	TestEqual(TEXT("Throttle behind the head leaves the island asleep"), CountSleeping(0, 6), 6);
+	TestEqual(TEXT("Only the vehicle with throttle is simulated"), RunSleepPass(*EntityManager, Query, /*bSleepIslands*/true, Checksum), 1);
+	TestFalse(TEXT("Throttle behind the head wakes that vehicle"), IsSleeping(*EntityManager, Vehicles[1]));
+	TestEqual(TEXT("The rest of its island stays asleep"), CountSleeping(0, 6), 5);
+	EntityManager->GetFragmentDataChecked<FMassTrafficPIDVehicleControlFragment>(Vehicles[1]).Throttle = 0.0f;
+
+	// A vehicle in no lane index isn't in any island, and wakes on its own throttle
+	PutAllToSleep();
+	EntityManager->GetFragmentDataChecked<FMassTrafficPIDVehicleControlFragment>(LaneLessVehicle).Throttle = 1.0f;
+	UE::MassTraffic::UpdateSleepIslands(*EntityManager, TrafficLanes, 100.0f, Stats);
+	TestEqual(TEXT("Only the vehicle in no lane is simulated"), RunSleepPass(*EntityManager, Query, /*bSleepIslands*/true, Checksum), 1);
+	TestFalse(TEXT("Throttle wakes a vehicle in no lane"), IsSleeping(*EntityManager, LaneLessVehicle));
+	EntityManager->GetFragmentDataChecked<FMassTrafficPIDVehicleControlFragment>(LaneLessVehicle).Throttle = 0.0f;
+
+	// A moving vehicle keeps its island awake
+	PutAllToSleep();
+	TrafficLaneData.Vehicles.Set(0, Distances[0], 100.0f);
+	UE::MassTraffic::UpdateSleepIslands(*EntityManager, TrafficLanes, 100.0f, Stats);
+	TestEqual(TEXT("A moving vehicle wakes the rest of its island"), CountSleeping(1, 2), 0);
+	TestEqual(TEXT("Islands without moving vehicles stay asleep"), CountSleeping(3, 3), 3);
+	TrafficLaneData.Vehicles.Set(0, Distances[0], 0.0f);
+
+	// A wake request wakes every island on the lane, once
+	PutAllToSleep();
+	TrafficLaneData.RequestWakeSleepingVehicles();
+	UE::MassTraffic::UpdateSleepIslands(*EntityManager, TrafficLanes, 100.0f, Stats);
+	TestEqual(TEXT("Wake requests wake the whole lane"), CountSleeping(0, 6), 0);
+	TestFalse(TEXT("Wake requests are cleared"), (bool)TrafficLaneData.bIsSleepingVehicleWakeRequested);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMassTrafficSleepIslandsBenchmark, "MassTraffic.SleepIslands.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+// Compare a frame of gridlock with every sleeping vehicle checking its own inputs, and with sleep islands
+bool FMassTrafficSleepIslandsBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace MassTrafficSleepIslandsTests;
+
+	TSharedPtr<FMassEntityManager> EntityManager = MakeShareable(new FMassEntityManager());
+	EntityManager->Initialize();
+
+	FRandomStream Random(0x0B57AC1E);
+
+	TArray<FZoneGraphTrafficLaneData> TrafficLanes;
+	BuildGridlock(*EntityManager, TrafficLanes, Random);
+
+	FMassEntityQuery Query(EntityManager);
+	Query.AddRequirement<FMassTrafficPIDVehicleControlFragment>(EMassFragmentAccess::ReadOnly);
+	Query.AddRequirement<FMassTrafficVehicleControlFragment>(EMassFragmentAccess::ReadOnly);
+	Query.AddRequirement<FMassTrafficVehiclePhysicsFragment>(EMassFragmentAccess::ReadWrite);
+	Query.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadOnly);
+
+	AddInfo(FString::Printf(TEXT("%d lanes, %d stopped vehicles per lane, %.0f%% of lanes released"), NumLanes, VehiclesPerLane, ReleasedLaneFraction * 100.0f));
+
+	// Sum the locations of simulated vehicles so the transform copies can't be optimized away
+	double Checksum = 0.0;
+
+	// Each vehicle checks its own inputs
+	double StartTime = FPlatformTime::Seconds();
+	const int32 NumSimulatedPerVehicle = RunSleepPass(*EntityManager, Query, /*bSleepIslands*/false, Checksum);
+	const double PerVehicleTime = FPlatformTime::Seconds() - StartTime;
+
+	// Back to sleep, then islands decide who wakes
+	for (const FZoneGraphTrafficLaneData& TrafficLaneData : TrafficLanes)
+	{
+		for (const FMassEntityHandle Vehicle : TrafficLaneData.Vehicles.GetEntities())
+		{
+			PutToSleep(*EntityManager, Vehicle);
+		}
+	}
+
+	FMassTrafficSleepIslandStats Stats;
+	StartTime = FPlatformTime::Seconds();
+	UE::MassTraffic::UpdateSleepIslands(*EntityManager, TrafficLanes, GMassTrafficSleepIslandMaxGap, Stats);
+	const double IslandTime = FPlatformTime::Seconds() - StartTime;
+	const int32 NumSimulatedIslands = RunSleepPass(*EntityManager, Query, /*bSleepIslands*/true, Checksum);
+	const double IslandFrameTime = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("Per vehicle sleeping: %.3fms, %d vehicles simulated"), PerVehicleTime * 1000.0, NumSimulatedPerVehicle));
+	AddInfo(FString::Printf(TEXT("Sleep islands: %.3fms (%.3fms updating islands), %d vehicles simulated, %d awake islands, %d resting islands"),
+		IslandFrameTime * 1000.0, IslandTime * 1000.0, NumSimulatedIslands, Stats.NumAwakeIslands, Stats.NumRestingIslands));
+	AddInfo(FString::Printf(TEXT("Frame time saved: %.3fms (checksum %.1f)"), (PerVehicleTime - IslandFrameTime) * 1000.0, Checksum));
+
+	TestEqual(TEXT("Every released lane is one awake island"), Stats.NumAwakeIslands, NumSimulatedPerVehicle);
+	TestEqual(TEXT("Released islands wake as a whole"), NumSimulatedIslands, Stats.NumVehiclesInAwakeIslands);
+	TestEqual(TEXT("Every vehicle is in an island"), Stats.NumVehiclesInAwakeIslands + Stats.NumVehiclesInRestingIslands, NumLanes * VehiclesPerLane);
+
+	return true;
+}
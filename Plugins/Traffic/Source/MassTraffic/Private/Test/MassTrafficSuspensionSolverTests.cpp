@@ -0,0 +1,289 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#include "MassTrafficPhysics.h"
+#include "MassTrafficSuspensionSolver.h"
+
+namespace MassTrafficSuspensionSolverTests
+{
+	static const int32 NumVehicleTypes = 3;
+	static const int32 NumIterations = 8;
+	static const float DeltaTime = 1.0f / 30.0f;
+	static const float GravityZ = -980.0f;
+
+	// Four wheeled vehicles of a few sizes, some with their mass rotated away from the actor
+	static void BuildVehicleConfigs(TArray<FMassTrafficSimpleVehiclePhysicsConfig>& OutConfigs)
+	{
+		OutConfigs.SetNum(NumVehicleTypes);
+		for (int32 TypeIndex = 0; TypeIndex < NumVehicleTypes; ++TypeIndex)
+		{
+			FMassTrafficSimpleVehiclePhysicsConfig& Config = OutConfigs[TypeIndex];
+
+			const float HalfLength = 130.0f + TypeIndex * 40.0f;
+			const float HalfWidth = 80.0f + TypeIndex * 10.0f;
+
+			Config.Mass = 1200.0f + TypeIndex * 800.0f;
+			Config.InverseMomentOfInertia = FVector(1.0f / (Config.Mass * HalfWidth * HalfWidth), 1.0f / (Config.Mass * HalfLength * HalfLength), 1.0f / (Config.Mass * (HalfLength * HalfLength + HalfWidth * HalfWidth)));
+			Config.CenterOfMass = FVector(10.0f * TypeIndex, 0.0f, 30.0f);
+			Config.RotationOfMass = FQuat(FVector::UpVector, 0.05f * TypeIndex);
+
+			Config.WheelConfigs.SetNum(4);
+			Config.SuspensionConfigs.SetNum(4);
+			for (int32 WheelIndex = 0; WheelIndex < 4; ++WheelIndex)
+			{
+				Chaos::FSimpleSuspensionConfig& SuspensionConfig = Config.SuspensionConfigs[WheelIndex];
+				SuspensionConfig.SuspensionAxis = FVector(0.0f, 0.0f, -1.0f);
+				SuspensionConfig.SuspensionMaxRaise = 10.0f;
+				SuspensionConfig.SuspensionMaxDrop = 10.0f;
+				SuspensionConfig.SpringRate = Config.Mass * 150.0f;
+				SuspensionConfig.DampingRatio = Config.Mass * 0.05f;
+			}
+		}
+	}
+
+	static void BuildVehicleSim(const FMassTrafficSimpleVehiclePhysicsConfig& Config, FMassTrafficSimpleVehiclePhysicsSim& OutVehicleSim)
+	{
+		for (int32 WheelIndex = 0; WheelIndex < Config.WheelConfigs.Num(); ++WheelIndex)
+		{
+			const float HalfLength = FMath::Abs(Config.CenterOfMass.X) + 130.0f;
+			const FVector LocalRestingPosition((WheelIndex < 2 ? 1.0f : -1.0f) * HalfLength, (WheelIndex % 2 ? 1.0f : -1.0f) * 80.0f, -20.0f);
+
+			OutVehicleSim.WheelSims.Emplace_GetRef(&Config.WheelConfigs[WheelIndex]).SetOnGround(true);
+			OutVehicleSim.SuspensionSims.Emplace_GetRef(&Config.SuspensionConfigs[WheelIndex]).SetLocalRestingPosition(LocalRestingPosition);
+			OutVehicleSim.WheelLocalLocations.Add(LocalRestingPosition);
+		}
+	}
+
+	// Rolling hills for the wheels to follow
+	static float GroundHeight(const FVector& Location)
+	{
+		return 30.0f * FMath::Sin(Location.X * 0.002f) + 20.0f * FMath::Cos(Location.Y * 0.003f);
+	}
+
+	struct FVehicleState
+	{
+		FTransform Transform;
+		FVector Velocity = FVector::ZeroVector;
+		FVector AngularVelocity = FVector::ZeroVector;
+	};
+
+	struct FFleet
+	{
+		TArray<FMassTrafficSimpleVehiclePhysicsConfig> Configs;
+		TArray<FMassTrafficSimpleVehiclePhysicsSim> VehicleSims;
+		TArray<FVehicleState> InitialStates;
+	};
+
+	static void BuildFleet(const int32 NumVehicles, FFleet& OutFleet, FRandomStream& Random)
+	{
+		// Sims point at their configs, which must not move once the sims are built
+		BuildVehicleConfigs(OutFleet.Configs);
+
+		OutFleet.VehicleSims.Reserve(NumVehicles);
+		OutFleet.InitialStates.SetNum(NumVehicles);
+		for (int32 VehicleIndex = 0; VehicleIndex < NumVehicles; ++VehicleIndex)
+		{
+			const FMassTrafficSimpleVehiclePhysicsConfig& Config = OutFleet.Configs[VehicleIndex % NumVehicleTypes];
+			FMassTrafficSimpleVehiclePhysicsSim& VehicleSim = OutFleet.VehicleSims.Emplace_GetRef(&Config);
+			BuildVehicleSim(Config, VehicleSim);
+
+			FVehicleState& State = OutFleet.InitialStates[VehicleIndex];
+			const float Yaw = Random.FRandRange(-PI, PI);
+			FVector Location(Random.FRandRange(-50000.0f, 50000.0f), Random.FRandRange(-50000.0f, 50000.0f), 0.0f);
+			Location.Z = GroundHeight(Location) + Random.FRandRange(10.0f, 40.0f);
+
+			State.Transform = FTransform(FQuat(FVector::UpVector, Yaw), Location);
+			State.Velocity = State.Transform.GetRotation().GetForwardVector() * Random.FRandRange(0.0f, 2000.0f);
+		}
+	}
+
+	// Stands in for the drive forces and suspension traces: falls and rolls forward, then finds the ground under each wheel.
+	// Occasionally lifts a wheel off the ground so some constraints are disabled.
+	static void PrepareFrame(TArray<FVehicleState>& States, TArray<FMassTrafficSimpleVehiclePhysicsSim>& VehicleSims, TArray<FVector>& OutSuspensionTargets, FRandomStream& Random)
+	{
+		OutSuspensionTargets.SetNumUninitialized(States.Num() * 4);
+		for (int32 VehicleIndex = 0; VehicleIndex < States.Num(); ++VehicleIndex)
+		{
+			FVehicleState& State = States[VehicleIndex];
+			State.Velocity.Z += GravityZ * DeltaTime;
+			State.Transform.AddToTranslation(State.Velocity * DeltaTime);
+
+			FMassTrafficSimpleVehiclePhysicsSim& VehicleSim = VehicleSims[VehicleIndex];
+			for (int32 WheelIndex = 0; WheelIndex < 4; ++WheelIndex)
+			{
+				FVector Target = State.Transform.TransformPositionNoScale(VehicleSim.SuspensionSims[WheelIndex].GetLocalRestingPosition());
+				Target.Z = GroundHeight(Target);
+				OutSuspensionTargets[VehicleIndex * 4 + WheelIndex] = Target;
+
+				VehicleSim.WheelSims[WheelIndex].SetOnGround(Random.FRand() > 0.05f);
+			}
+		}
+	}
+
+	// @see UMassTrafficVehiclePhysicsProcessor::UpdateCoMVelocity
+	static void UpdateVelocity(const FMassTrafficSimpleVehiclePhysicsSim& VehicleSim, const FTransform& PreviousTransform, FVehicleState& State)
+	{
+		const FVector PreviousCenterOfMass = PreviousTransform.TransformPositionNoScale(VehicleSim.Setup().CenterOfMass);
+		const FVector CenterOfMass = State.Transform.TransformPositionNoScale(VehicleSim.Setup().CenterOfMass);
+		State.Velocity = (CenterOfMass - PreviousCenterOfMass) / DeltaTime;
+
+		FQuat Delta = State.Transform.GetRotation() * PreviousTransform.GetRotation().Inverse();
+		Delta.EnforceShortestArcWith(FQuat::Identity);
+		FVector Axis;
+		float Angle;
+		Delta.ToAxisAndAngle(Axis, Angle);
+		State.AngularVelocity = Axis * (Angle / DeltaTime);
+	}
+
+	static void SolveScalar(const TArray<FMassTrafficSimpleVehiclePhysicsSim>& VehicleSims, TConstArrayView<FVector> SuspensionTargets, TArray<FVehicleState>& States)
+	{
+		for (int32 VehicleIndex = 0; VehicleIndex < States.Num(); ++VehicleIndex)
+		{
+			FVehicleState& State = States[VehicleIndex];
+			const FTransform PreviousTransform = State.Transform;
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				UE::MassTraffic::SolveSuspensionConstraintsIteration(DeltaTime, VehicleSims[VehicleIndex], State.Velocity, State.AngularVelocity, State.Transform, PreviousTransform, SuspensionTargets.Slice(VehicleIndex * 4, 4));
+			}
+		}
+	}
+
+	static void SolveBatched(FMassTrafficSuspensionSolverBatch& Batch, const TArray<FMassTrafficSimpleVehiclePhysicsSim>& VehicleSims, TConstArrayView<FVector> SuspensionTargets, TArray<FVehicleState>& States)
+	{
+		Batch.Reset();
+		for (int32 VehicleIndex = 0; VehicleIndex < States.Num(); ++VehicleIndex)
+		{
+			const FVehicleState& State = States[VehicleIndex];
+			Batch.Add(DeltaTime, VehicleSims[VehicleIndex], State.Transform, State.Velocity, State.AngularVelocity, SuspensionTargets.Slice(VehicleIndex * 4, 4));
+		}
+
+		Batch.Solve(NumIterations);
+
+		for (int32 VehicleIndex = 0; VehicleIndex < States.Num(); ++VehicleIndex)
+		{
+			Batch.ApplyToTransform(VehicleIndex, States[VehicleIndex].Transform);
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMassTrafficSuspensionSolverReplayTest, "MassTraffic.SuspensionSolver.Replay", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Replay the same frames through the per vehicle and the batched suspension solvers and compare the trajectories
+bool FMassTrafficSuspensionSolverReplayTest::RunTest(const FString& Parameters)
+{
+	using namespace MassTrafficSuspensionSolverTests;
+
+	// Not a multiple of the packet size, so the last packet is partially filled
+	const int32 NumVehicles = 101;
+	const int32 NumFrames = 90;
+
+	FRandomStream Random(0x5B5E7510);
+
+	FFleet Fleet;
+	BuildFleet(NumVehicles, Fleet, Random);
+
+	TArray<FVehicleState> ScalarStates = Fleet.InitialStates;
+	TArray<FVehicleState> BatchedStates = Fleet.InitialStates;
+
+	FMassTrafficSuspensionSolverBatch Batch;
+
+	float MaxLocationError = 0.0f;
+	float MaxRotationError = 0.0f;
+	int32 NonDeterministicFrames = 0;
+
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		// Each path finds its own suspension targets, with the same wheels lifted off the ground
+		const int32 FrameSeed = Random.GetUnsignedInt();
+		TArray<FVector> ScalarSuspensionTargets;
+		{
+			FRandomStream FrameRandom(FrameSeed);
+			PrepareFrame(ScalarStates, Fleet.VehicleSims, ScalarSuspensionTargets, FrameRandom);
+		}
+		const TArray<FVehicleState> PreviousScalarStates = ScalarStates;
+		SolveScalar(Fleet.VehicleSims, ScalarSuspensionTargets, ScalarStates);
+
+		TArray<FVector> BatchedSuspensionTargets;
+		{
+			FRandomStream FrameRandom(FrameSeed);
+			PrepareFrame(BatchedStates, Fleet.VehicleSims, BatchedSuspensionTargets, FrameRandom);
+		}
+		const TArray<FVehicleState> PreviousBatchedStates = BatchedStates;
+		SolveBatched(Batch, Fleet.VehicleSims, BatchedSuspensionTargets, BatchedStates);
+
+		// Running the same batched frame again must give exactly the same poses
+		TArray<FVehicleState> ReplayStates = PreviousBatchedStates;
+		SolveBatched(Batch, Fleet.VehicleSims, BatchedSuspensionTargets, ReplayStates);
+
+		for (int32 VehicleIndex = 0; VehicleIndex < NumVehicles; ++VehicleIndex)
+		{
+			const FTransform& ScalarTransform = ScalarStates[VehicleIndex].Transform;
+			const FTransform& BatchedTransform = BatchedStates[VehicleIndex].Transform;
+
+			MaxLocationError = FMath::Max(MaxLocationError, (float)FVector::Dist(ScalarTransform.GetLocation(), BatchedTransform.GetLocation()));
+			MaxRotationError = FMath::Max(MaxRotationError, (float)ScalarTransform.GetRotation().AngularDistance(BatchedTransform.GetRotation()));
+
+			if (!ReplayStates[VehicleIndex].Transform.Equals(BatchedTransform, 0.0))
+			{
+				++NonDeterministicFrames;
+			}
+
+			UpdateVelocity(Fleet.VehicleSims[VehicleIndex], PreviousScalarStates[VehicleIndex].Transform, ScalarStates[VehicleIndex]);
+			UpdateVelocity(Fleet.VehicleSims[VehicleIndex], PreviousBatchedStates[VehicleIndex].Transform, BatchedStates[VehicleIndex]);
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("%d vehicles over %d frames: max location error %.4fcm, max rotation error %.5f degrees"), NumVehicles, NumFrames, MaxLocationError, FMath::RadiansToDegrees(MaxRotationError)));
+
+	TestTrue(TEXT("Batched locations follow the per vehicle solve"), MaxLocationError < 0.5f);
+	TestTrue(TEXT("Batched rotations follow the per vehicle solve"), MaxRotationError < FMath::DegreesToRadians(0.1f));
+	TestEqual(TEXT("Batched solve is deterministic"), NonDeterministicFrames, 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMassTrafficSuspensionSolverBenchmark, "MassTraffic.SuspensionSolver.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+// Compare the throughput of solving the suspension constraints one vehicle at a time and four vehicles at a time
+bool FMassTrafficSuspensionSolverBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace MassTrafficSuspensionSolverTests;
+
+	const int32 NumVehicles = 20000;
+
+	FRandomStream Random(0x0B57AC1E);
+
+	FFleet Fleet;
+	BuildFleet(NumVehicles, Fleet, Random);
+
+	TArray<FVehicleState> States = Fleet.InitialStates;
+	TArray<FVector> SuspensionTargets;
+	PrepareFrame(States, Fleet.VehicleSims, SuspensionTargets, Random);
+
+	TArray<FVehicleState> ScalarStates = States;
+	double StartTime = FPlatformTime::Seconds();
+	SolveScalar(Fleet.VehicleSims, SuspensionTargets, ScalarStates);
+	const double ScalarTime = FPlatformTime::Seconds() - StartTime;
+
+	FMassTrafficSuspensionSolverBatch Batch;
+	TArray<FVehicleState> BatchedStates = States;
+	StartTime = FPlatformTime::Seconds();
+	SolveBatched(Batch, Fleet.VehicleSims, SuspensionTargets, BatchedStates);
+	const double BatchedTime = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("%d vehicles, %d iterations: per vehicle %.3fms (%.1f vehicles/ms), batched %.3fms (%.1f vehicles/ms)"),
+		NumVehicles, NumIterations,
+		ScalarTime * 1000.0, NumVehicles / FMath::Max(ScalarTime * 1000.0, UE_DOUBLE_SMALL_NUMBER),
+		BatchedTime * 1000.0, NumVehicles / FMath::Max(BatchedTime * 1000.0, UE_DOUBLE_SMALL_NUMBER)));
+
+	int32 Mismatches = 0;
+	for (int32 VehicleIndex = 0; VehicleIndex < NumVehicles; ++VehicleIndex)
+	{
+		Mismatches += FVector::Dist(ScalarStates[VehicleIndex].Transform.GetLocation(), BatchedStates[VehicleIndex].Transform.GetLocation()) < 0.1f ? 0 : 1;
+	}
+	TestEqual(TEXT("Both solvers agree"), Mismatches, 0);
+
+	return true;
+}
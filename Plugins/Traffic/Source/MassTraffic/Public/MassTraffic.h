@@ -69,6 +69,9 @@ extern int32 GMassTrafficSleepEnabled;
 extern int32 GMassTrafficSleepCounterThreshold;
 extern float GMassTrafficLinearSpeedSleepThreshold;
 extern float GMassTrafficControlInputWakeTolerance;
+extern int32 GMassTrafficSleepIslands;
+extern float GMassTrafficSleepIslandMaxGap;
+extern int32 GMassTrafficBatchedSuspensionSolver;
 
 extern float GMassTrafficSpeedLimitScale;
 
@@ -89,6 +92,7 @@ namespace UE::MassTraffic::ProcessorGroupNames
 	const FName EndPhysicsIntersectionBehavior = FName(TEXT("TrafficEndPhysics.IntersectionBehavior"));
 	const FName PostPhysicsDriverVisualization = FName(TEXT("TrafficPostPhysics.DriverVisualization"));
 	const FName PostPhysicsUpdateDistanceToNearestObstacle = FName(TEXT("TrafficPostPhysics.UpdateDistanceToNearestObstacle"));
+	const FName PostPhysicsUpdateLaneVehicles = FName(TEXT("TrafficPostPhysics.UpdateLaneVehicles"));
 	const FName PostPhysicsUpdateTrafficVehicles = FName(TEXT("TrafficPostPhysics.UpdateTrafficVehicles"));
 }
 
@@ -8,12 +8,21 @@ class AMassTrafficCoordinator;
 namespace UE::MassTrafficDelegates
 {
 
+		// Broadcast around changes that may affect the lane data of every registered zone graph
 		DECLARE_MULTICAST_DELEGATE_OneParam(FOnPreTrafficLaneDataChange, UMassTrafficSubsystem* /*MassTrafficSubsystem*/);
 		extern MASSTRAFFIC_API FOnPreTrafficLaneDataChange OnPreTrafficLaneDataChange;
 
 		DECLARE_MULTICAST_DELEGATE_OneParam(FOnTrafficLaneDataChanged, UMassTrafficSubsystem* /*MassTrafficSubsystem*/);
 		extern MASSTRAFFIC_API FOnTrafficLaneDataChanged OnTrafficLaneDataChanged;
 
+		// Broadcast when the lane data of a single zone graph is built, e.g. as its cell streams in
+		DECLARE_MULTICAST_DELEGATE_TwoParams(FOnTrafficZoneGraphDataRegistered, UMassTrafficSubsystem* /*MassTrafficSubsystem*/, const FZoneGraphDataHandle /*DataHandle*/);
+		extern MASSTRAFFIC_API FOnTrafficZoneGraphDataRegistered OnTrafficZoneGraphDataRegistered;
+
+		// Broadcast before the lane data of a single zone graph is released, e.g. as its cell streams out
+		DECLARE_MULTICAST_DELEGATE_TwoParams(FOnPreTrafficZoneGraphDataUnregistered, UMassTrafficSubsystem* /*MassTrafficSubsystem*/, const FZoneGraphDataHandle /*DataHandle*/);
+		extern MASSTRAFFIC_API FOnPreTrafficZoneGraphDataUnregistered OnPreTrafficZoneGraphDataUnregistered;
+
 		DECLARE_MULTICAST_DELEGATE_OneParam(FOnPostInitTrafficIntersections, UMassTrafficSubsystem* /*MassTrafficSubsystem*/);
 		extern MASSTRAFFIC_API FOnPostInitTrafficIntersections OnPostInitTrafficIntersections;
 
@@ -88,6 +88,11 @@ public:
 protected:
 	
 	void OnTrafficLaneDataChanged(UMassTrafficSubsystem* MassTrafficSubsystem);
+	void OnTrafficZoneGraphDataRegistered(UMassTrafficSubsystem* MassTrafficSubsystem, const FZoneGraphDataHandle DataHandle);
+	void OnPreTrafficZoneGraphDataUnregistered(UMassTrafficSubsystem* MassTrafficSubsystem, const FZoneGraphDataHandle DataHandle);
+
+	/** Adds the traffic lanes overlapping the field, only those of DataHandle if it is valid */
+	void AddOverlappedLanes(UMassTrafficSubsystem& MassTrafficSubsystem, const FZoneGraphDataHandle DataHandle);
 	void OnPostInitTrafficIntersections(UMassTrafficSubsystem* MassTrafficSubsystem);
 
 	TArray<FZoneGraphTrafficLaneData*> TrafficLanes;
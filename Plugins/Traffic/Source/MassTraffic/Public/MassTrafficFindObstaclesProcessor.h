@@ -4,6 +4,7 @@
 
 #include "MassTrafficProcessorBase.h"
 #include "MassTrafficFragments.h"
+#include "MassTrafficLaneSegmentGrid.h"
 #include "MassTrafficFindObstaclesProcessor.generated.h"
 
 
@@ -21,4 +22,13 @@ protected:
 
 	FMassEntityQuery ObstacleEntityQuery;
 	FMassEntityQuery ObstacleAvoidingEntityQuery;
+
+	/** Lanes found near the obstacle being processed. Kept between executions to reuse the allocation. */
+	TArray<FMassTrafficLaneSegmentGrid::FLaneLocation> NearbyLaneLocations;
+
+	/**
+	 * (Vehicle, Obstacle) pairs for vehicles that don't have an obstacle list fragment yet. Kept between executions
+	 * to reuse the allocation.
+	 */
+	TArray<TPair<FMassEntityHandle, FMassEntityHandle>> ObstacleListsToAdd;
 };
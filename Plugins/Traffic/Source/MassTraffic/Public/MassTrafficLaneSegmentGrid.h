@@ -0,0 +1,74 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ZoneGraphTypes.h"
+
+struct FZoneGraphStorage;
+struct FZoneGraphTrafficLaneData;
+
+/**
+ * Flat 2D grid of the lane segments of a zone graph's traffic lanes, used to find the lanes near obstacles without
+ * going through the zone BV tree and every lane of the overlapping zones.
+ *
+ * Segments are bucketed into every cell their XY bounds overlap. Cells are stored as ranges into a single array of
+ * segment indices, and segments store their end points so queries never need to touch the zone graph storage.
+ */
+struct MASSTRAFFIC_API FMassTrafficLaneSegmentGrid
+{
+	/** Nearest location on a lane, found by FindNearestLocationsOnLanes */
+	struct FLaneLocation
+	{
+		FZoneGraphLaneHandle LaneHandle;
+		FVector Position = FVector::ZeroVector;
+		float DistanceAlongLane = 0.0f;
+		float DistanceSqr = 0.0f;
+	};
+
+	void Reset();
+
+	/**
+	 * (Re)builds the grid from the lanes in TrafficLanes.
+	 * @param Storage Zone graph storage the traffic lanes were built from
+	 * @param TrafficLanes Lanes to add to the grid, any other lane from Storage is ignored
+	 * @param InCellSize Size of the grid cells, in cm
+	 */
+	void Build(const FZoneGraphStorage& Storage, TConstArrayView<FZoneGraphTrafficLaneData> TrafficLanes, float InCellSize);
+
+	/**
+	 * Finds, for each lane with a segment crossing SearchBounds, the location on those segments that is nearest to the
+	 * center of SearchBounds. Matches FindOverlappingLanes followed by FindNearestLocationOnLane on each lane.
+	 * @param SearchBounds Bounds to search in
+	 * @param OutLocations One location per lane is appended
+	 */
+	void FindNearestLocationsOnLanes(const FBox& SearchBounds, TArray<FLaneLocation>& OutLocations) const;
+
+	bool IsEmpty() const { return Segments.IsEmpty(); }
+	int32 GetNumSegments() const { return Segments.Num(); }
+	FIntPoint GetNumCells() const { return NumCells; }
+
+private:
+
+	struct FSegment
+	{
+		FVector Start;
+		FVector End;
+		float StartDistanceAlongLane;
+		int32 LaneIndex;
+	};
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	FZoneGraphDataHandle DataHandle;
+
+	FVector2D Origin = FVector2D::ZeroVector;
+	float CellSize = 0.0f;
+	FIntPoint NumCells = FIntPoint::ZeroValue;
+
+	TArray<FSegment> Segments;
+
+	/** Cell (X + Y * NumCells.X) -> range in CellSegmentIndices, CellSegmentsBegin[Cell + 1] ends the range */
+	TArray<int32> CellSegmentsBegin;
+
+	TArray<int32> CellSegmentIndices;
+};
@@ -0,0 +1,76 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "MassEntityTypes.h"
+
+/**
+ * Packed index of the vehicles on a traffic lane, sorted from the start of the lane to its end.
+ *
+ * Entities, distances along the lane, speeds and the space each vehicle takes on the lane are kept in parallel arrays
+ * so code that only needs those values can scan a lane without resolving an entity view per vehicle or following the
+ * NextVehicle links. Membership is updated as vehicles join and leave the lane, and distances and speeds are refreshed
+ * once per frame by UMassTrafficUpdateLaneVehiclesProcessor.
+ *
+ * The NextVehicle links remain the reference for the following order of vehicles. Between refreshes the distances
+ * here can be a frame old, so code inserting vehicles into the links or removing them must still walk them.
+ */
+struct MASSTRAFFIC_API FMassTrafficLaneVehicles
+{
+	void Reset();
+
+	int32 Num() const { return Entities.Num(); }
+	bool IsEmpty() const { return Entities.IsEmpty(); }
+
+	/** Adds a vehicle, keeping vehicles sorted on their distance along the lane */
+	void Add(const FMassEntityHandle Entity, const float DistanceAlongLane, const float Speed, const float SpaceTaken);
+
+	/**
+	 * Removes a vehicle, keeping the order of the others.
+	 * @return Whether the vehicle was on the lane
+	 */
+	bool Remove(const FMassEntityHandle Entity);
+
+	/** @return Index of the vehicle, or INDEX_NONE if it isn't on the lane. Linear in the number of vehicles on the lane */
+	int32 IndexOf(const FMassEntityHandle Entity) const { return Entities.Find(Entity); }
+
+	/**
+	 * Finds the indices of several vehicles with a single pass over the lane, rather than one IndexOf per vehicle.
+	 * @param InEntities Vehicles to look for
+	 * @param OutIndices Receives the index of each vehicle in InEntities, or INDEX_NONE if it isn't on the lane
+	 */
+	void FindIndices(TConstArrayView<FMassEntityHandle> InEntities, TArrayView<int32> OutIndices) const;
+
+	/** Updates the distance and speed of the vehicle at Index. Call RestoreOrder once every vehicle is updated */
+	void Set(const int32 Index, const float DistanceAlongLane, const float Speed)
+	{
+		DistancesAlongLane[Index] = DistanceAlongLane;
+		Speeds[Index] = Speed;
+	}
+
+	/** Sorts vehicles on their distance along the lane again after Set. Vehicles rarely overtake, so this is usually a single pass */
+	void RestoreOrder();
+
+	/** @return Index of the first vehicle strictly ahead of DistanceAlongLane, or Num() if there is none */
+	int32 FindFirstAhead(const float DistanceAlongLane) const;
+
+	/** @return Index of the first vehicle at or ahead of DistanceAlongLane, or Num() if there is none */
+	int32 FindFirstAtOrAhead(const float DistanceAlongLane) const;
+
+	/** @return Sum of the space taken by the vehicles on the lane */
+	float GetSpaceTaken() const;
+
+	TConstArrayView<FMassEntityHandle> GetEntities() const { return Entities; }
+	TConstArrayView<float> GetDistancesAlongLane() const { return DistancesAlongLane; }
+	TConstArrayView<float> GetSpeeds() const { return Speeds; }
+	TConstArrayView<float> GetSpacesTaken() const { return SpacesTaken; }
+
+private:
+
+	void RemoveAt(const int32 Index);
+
+	TArray<FMassEntityHandle> Entities;
+	TArray<float> DistancesAlongLane;
+	TArray<float> Speeds;
+	TArray<float> SpacesTaken;
+};
@@ -14,6 +14,7 @@
 
 
 /** Forward declarations */
+struct FMassCommandBuffer;
 struct FZoneGraphTrafficLaneData;
 class UMassTrafficSubsystem;
 
@@ -242,4 +243,11 @@ MASSTRAFFIC_API bool TeleportVehicleToAnotherLane(
 	const UMassTrafficSettings& MassTrafficSettings,
 	const FMassEntityManager& EntityManager);
 
+/**
+ * Defers removing a vehicle leaving the lanes, because it is recycled or destroyed, from the index of the vehicles on
+ * its lane (@see FZoneGraphTrafficLaneData::Vehicles), along with the commands changing its tags or destroying it.
+ * Lane queries would otherwise keep finding it until it is teleported.
+ */
+MASSTRAFFIC_API void DeferRemoveVehicleFromLane(FMassCommandBuffer& CommandBuffer, const FMassEntityHandle VehicleEntity, FZoneGraphTrafficLaneData& TrafficLaneData);
+
 }
@@ -124,6 +124,12 @@ public:
 
 	uint8 SleepCounter = 0;
 
+	/**
+	 * Set by UE::MassTraffic::UpdateSleepIslands when this vehicle is the head of an island left at rest, whose inputs
+	 * the island already checked this frame. Sleeping vehicles without it check their own inputs.
+	 */
+	bool bSleepCheckedByIsland = false;
+
 	/**
 	 * @see IncrSleepCounter
 	 * @return true if SleepCounter >= SleepCounterThreshold
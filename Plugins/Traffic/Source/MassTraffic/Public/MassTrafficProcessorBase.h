@@ -17,6 +17,12 @@ class MASSTRAFFIC_API UMassTrafficProcessorBase : public UMassProcessor
 public:
 	
 	virtual void Initialize(UObject& InOwner) override;
+
+	/** Restarts the random stream from Seed, used to replay a run with a given seed */
+	void SetRandomSeed(const int32 Seed)
+	{
+		RandomStream.Initialize(Seed);
+	}
 	
 protected:
 
@@ -306,6 +306,14 @@ public:
 	UPROPERTY(EditAnywhere, Config, Category="Obstacle Avoidance")
 	float ObstacleSearchHeight = 500.0f;
 	
+	/**
+	 * Size of the cells of the 2D lane segment grid built for each zone graph and used to find the lanes near each
+	 * obstacle. Smaller cells test fewer segments per query at the cost of more cells to visit and more memory.
+	 * @see FMassTrafficLaneSegmentGrid
+	 */
+	UPROPERTY(EditAnywhere, Config, Category="Obstacle Avoidance", meta=(ClampMin="100.0", UIMin="100.0"))
+	float ObstacleLaneGridCellSize = 2500.0f;
+	
 	UPROPERTY(EditAnywhere, Config, Category="Obstacle Avoidance")
 	FVector2D ObstacleAvoidanceBrakingTimeRange = {1.5f,  3.0f};
 	
@@ -0,0 +1,163 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTraitBase.h"
+#include "MassTrafficTypes.h"
+#include "UObject/SoftObjectPath.h"
+
+#include "MassTrafficSimulationHarness.generated.h"
+
+struct FMassEntityManager;
+struct FMassTrafficSimpleVehiclePhysicsTemplate;
+class UMassTrafficSettings;
+
+/**
+* Replayable runs of the traffic simulation without a level.
+*
+* Each run creates a game world that is never ticked, builds a synthetic network of multi lane ring roads in an AZoneGraphData actor,
+* registers it with UMassTrafficSubsystem::RegisterZoneGraphData and spawns vehicles on it from a seeded random stream. Every traffic
+* processor that registers with the processing phases is then run in dependency order for a number of fixed steps, with the world time
+* advanced by the same delta time each step so variable LOD ticking is repeatable. The time taken by each processor is recorded, and the
+* state of every vehicle and lane is hashed after each step so two runs can be compared step by step.
+*
+* By default vehicles get a synthetic simple physics template, so those near the viewer run UMassTrafficVehiclePhysicsProcessor and the
+* Chaos wheel, suspension and drivetrain sims as they would with a physics vehicle actor.
+*/
+class MASSTRAFFIC_API FMassTrafficSimulationHarness
+{
+public:
+
+	/** Version of the JSON report, increase when the layout of the report or the meaning of its entries changes */
+	static constexpr int32 ReportVersion = 2;
+
+	struct FSettings
+	{
+		/** Seed of the spawn locations and of the random streams of the traffic processors */
+		int32 Seed = 0x5EED;
+
+		/** Number of fixed steps to simulate */
+		int32 NumSteps = 300;
+
+		/** Simulated seconds per step */
+		float DeltaTime = 1.0f / 30.0f;
+
+		/** Number of ring roads along X and Y, the roads are laid out on a grid centered on the origin */
+		int32 NumRoadsPerAxis = 2;
+
+		/** Number of straight segments, and zones, around each ring road */
+		int32 NumSegmentsPerRoad = 32;
+
+		/** Number of lanes on each ring road, all driving counterclockwise */
+		int32 NumLanesPerRoad = 3;
+
+		/** Radius of the outer lane of each ring road */
+		float RoadRadius = 15000.0f;
+
+		float LaneWidth = 350.0f;
+
+		/** Number of vehicles to spawn, fewer are spawned if the lanes run out of space */
+		int32 NumVehicles = 800;
+
+		/** Lane length each spawned vehicle takes */
+		float VehicleSpace = 600.0f;
+
+		/** Location of the viewer the simulation and visualization LODs are computed from */
+		FVector ViewerLocation = FVector::ZeroVector;
+
+		/** Vehicle entity configs to spawn, vehicles are split evenly between them. If empty, a config without meshes is used */
+		TArray<FSoftObjectPath> VehicleConfigs;
+
+		/**
+		* Whether the default vehicle config uses GetSimplePhysicsTemplate, so vehicles at medium and high simulation LOD are driven by
+		* UMassTrafficVehiclePhysicsProcessor. Without it every vehicle follows its lane without physics. Ignored with VehicleConfigs.
+		*/
+		bool bSimplePhysics = true;
+
+		/** Positions and distances are rounded to this many centimeters before hashing, speeds to this many centimeters per second */
+		float HashTolerance = 0.1f;
+	};
+
+	struct FProcessorTiming
+	{
+		FString Name;
+		int32 NumRuns = 0;
+		double TotalSeconds = 0.0;
+		double MaxSeconds = 0.0;
+	};
+
+	/** The result of a run */
+	struct FRun
+	{
+		bool bSuccess = false;
+		int32 NumLanes = 0;
+		int32 NumVehicles = 0;
+
+		/** Largest number of vehicles simulated with simple physics after any step */
+		int32 MaxNumPhysicsVehicles = 0;
+
+		/** Timings of each processor, in execution order */
+		TArray<FProcessorTiming> ProcessorTimings;
+
+		/** Hash of the vehicle and lane state after each step */
+		TArray<uint64> StepHashes;
+	};
+
+	/**
+	* Build the synthetic ring roads into a zone graph storage. Each segment of a road is a zone holding one straight lane per road lane,
+	* linked to the lanes before and after it and to the lanes on either side.
+	* @param Settings - The settings describing the roads
+	* @param LaneTags - The tags of every lane and zone
+	* @param OutStorage - The storage to build, its data handle is left untouched
+	*/
+	static void MakeSyntheticLanes(const FSettings& Settings, const FZoneGraphTagMask LaneTags, FZoneGraphStorage& OutStorage);
+
+	/** @return Tags that pass the traffic lane filter of the settings without passing its intersection lane filter, or None if there are none */
+	static FZoneGraphTagMask FindTrafficLaneTags(const UMassTrafficSettings& TrafficSettings);
+
+	/** @return Hash of the lane location, speed, transform and simulation LOD of every traffic vehicle, and of the occupancy of every traffic lane */
+	static uint64 HashState(FMassEntityManager& EntityManager, TConstArrayView<FZoneGraphTrafficLaneData> TrafficLanes, const float Tolerance);
+
+	/**
+	* @return Simple physics of a front wheel drive mid size car, built without a physics vehicle actor. Its sims point at the configs
+	* stored next to them, so it is built once in place and lives until exit.
+	*/
+	static const FMassTrafficSimpleVehiclePhysicsTemplate& GetSimplePhysicsTemplate();
+
+	/** Simulate the synthetic roads with the given settings */
+	static FRun Run(const FSettings& Settings);
+
+	/**
+	* Return a JSON report of the given run. Processor timings are written in seconds, sorted by name, and step hashes as hexadecimal strings
+	* @param Settings - The settings the run was made with
+	* @param Run - The run to report
+	*/
+	static FString MakeReport(const FSettings& Settings, const FRun& Run);
+
+	/**
+	* Compare the step hashes of a run with those in a previous report.
+	* @return The first step whose hash differs or that is missing from either run, or INDEX_NONE if every step matches
+	*/
+	static int32 FindFirstDivergentStep(const FString& BaselineReport, const FRun& Run);
+};
+
+/**
+* Adds the fragments UMassTrafficVehicleSimulationTrait and UMassTrafficVehicleVisualizationTrait require, which vehicle configs
+* otherwise add with an assorted fragments trait. Used by the default vehicle config of FMassTrafficSimulationHarness.
+*/
+UCLASS(meta=(DisplayName="Traffic Simulation Harness Fragments"))
+class MASSTRAFFIC_API UMassTrafficSimulationHarnessTrait : public UMassEntityTraitBase
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Give vehicles FMassTrafficSimulationHarness::GetSimplePhysicsTemplate, for configs whose simulation trait has no physics vehicle actor */
+	UPROPERTY(EditAnywhere, Category = "Physics")
+	bool bSimplePhysics = false;
+
+protected:
+
+	virtual void BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const override;
+};
@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "Commandlets/Commandlet.h"
+
+#include "MassTrafficSimulationHarnessCommandlet.generated.h"
+
+MASSTRAFFIC_API DECLARE_LOG_CATEGORY_EXTERN(LogMassTrafficSimulationHarness, Log, All);
+
+/**
+* Runs FMassTrafficSimulationHarness and saves its JSON report. With -Baseline, the step hashes are compared with those of a previous
+* report and the commandlet fails at the first step that differs. With -NoPhysics, the default vehicle config has no simple physics.
+* Usage: -run=MassTrafficSimulationHarness [-Seed=N] [-Steps=N] [-DeltaTime=S] [-Vehicles=N] [-Roads=N] [-Segments=N] [-Lanes=N]
+*        [-VehicleConfigs=/Game/A.A,/Game/B.B] [-NoPhysics] [-Output=Path] [-Baseline=Path]
+*/
+UCLASS()
+class MASSTRAFFIC_API UMassTrafficSimulationHarnessCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+};
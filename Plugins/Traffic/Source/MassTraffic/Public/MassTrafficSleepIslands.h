@@ -0,0 +1,46 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "MassEntityManager.h"
+
+struct FMassTrafficLaneVehicles;
+struct FZoneGraphTrafficLaneData;
+
+/** Number of sleep islands and of the vehicles in them, as of the last UE::MassTraffic::UpdateSleepIslands */
+struct MASSTRAFFIC_API FMassTrafficSleepIslandStats
+{
+	int32 NumAwakeIslands = 0;
+	int32 NumRestingIslands = 0;
+	int32 NumVehiclesInAwakeIslands = 0;
+	int32 NumVehiclesInRestingIslands = 0;
+};
+
+namespace UE::MassTraffic
+{
+
+/**
+ * Splits the vehicles of a lane into queues, runs of consecutive vehicles no further than MaxGap apart once the space
+ * each takes on the lane is accounted for.
+ * @param Function Called with the index of the first vehicle of each queue in Vehicles, and its number of vehicles
+ */
+MASSTRAFFIC_API void ForEachVehicleQueue(const FMassTrafficLaneVehicles& Vehicles, const float MaxGap, TFunctionRef<void(const int32 FirstVehicle, const int32 NumVehicles)> Function);
+
+/**
+ * Broad phase of simple vehicle physics sleeping, which wakes sleeping vehicles an island at a time.
+ *
+ * An island is a queue of vehicles on a lane, @see ForEachVehicleQueue. Trailers are simulated along with the vehicle
+ * towing them so they belong to its island. A vehicle in a queue can't start moving before the one ahead of it does,
+ * so an island stays at rest until one of its vehicles moves, the vehicle at its head gets throttle input, or something
+ * wakes its lane (@see FZoneGraphTrafficLaneData::RequestWakeSleepingVehicles). The vehicles at rest of islands that
+ * aren't are woken, so every vehicle in an island counts towards sleep from the same frame.
+ *
+ * The head of an island left at rest is marked with FMassTrafficSimpleVehiclePhysicsSim::bSleepCheckedByIsland and
+ * doesn't need to check its own inputs this frame. Every other sleeping vehicle, behind a head or in no lane index,
+ * still does, so its own throttle wakes it.
+ *
+ * Clears the wake requests of the lanes.
+ */
+MASSTRAFFIC_API void UpdateSleepIslands(FMassEntityManager& EntityManager, TArrayView<FZoneGraphTrafficLaneData> TrafficLanes, const float MaxGap, FMassTrafficSleepIslandStats& InOutStats);
+
+}
@@ -141,6 +141,7 @@ protected:
 	
 	friend class UMassTrafficFieldComponent;
 	friend class UMassTrafficInitIntersectionsProcessor;
+	friend class FMassTrafficSimulationHarness;
 
 	void RegisterField(UMassTrafficFieldComponent* Field);
 	void UnregisterField(UMassTrafficFieldComponent* Field);
@@ -155,7 +156,15 @@ protected:
 	void PostZoneGraphDataAdded(const AZoneGraphData* ZoneGraphData);
 	void PreZoneGraphDataRemoved(const AZoneGraphData* ZoneGraphData);
 
-	void RegisterZoneGraphData(const AZoneGraphData* ZoneGraphData);
+	/**
+	 * Builds the lane data of ZoneGraphData, leaving the lane data of other registered zone graphs untouched.
+	 * @return true if the lane data was built, false if it was already registered
+	 */
+	bool RegisterZoneGraphData(const AZoneGraphData* ZoneGraphData);
+
+	/** Releases the lane data of a single zone graph, leaving the lane data of other registered zone graphs untouched */
+	void UnregisterZoneGraphData(const FZoneGraphDataHandle DataHandle);
+
 	void BuildLaneData(FMassTrafficZoneGraphData& TrafficZoneGraphData, const FZoneGraphStorage& ZoneGraphStorage);
 
 	FMassTrafficZoneGraphData* GetMutableTrafficZoneGraphData(const FZoneGraphDataHandle DataHandle);
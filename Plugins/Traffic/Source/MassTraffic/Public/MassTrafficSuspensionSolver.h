@@ -0,0 +1,112 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "MassTrafficPhysics.h"
+
+namespace UE::MassTraffic
+{
+
+/**
+ * Runs one iteration of the suspension constraints of a simple physics vehicle, moving InOutTransform towards the
+ * suspension targets found by the suspension traces.
+ * @param Velocity Linear velocity of the vehicle after its drive forces were simulated
+ * @param AngularVelocity Angular velocity of the vehicle after its drive forces were simulated
+ * @param InOutTransform Vehicle transform being solved
+ * @param VehicleWorldTransform Vehicle transform at the start of the frame, restored if the solve produces NaNs
+ * @param VisLogOwner If set, the constraints are visual logged against it
+ */
+MASSTRAFFIC_API void SolveSuspensionConstraintsIteration(
+	const float DeltaTime,
+	const FMassTrafficSimpleVehiclePhysicsSim& VehicleSim,
+	const FVector& Velocity,
+	const FVector& AngularVelocity,
+	FTransform& InOutTransform,
+	const FTransform& VehicleWorldTransform,
+	TConstArrayView<FVector> SuspensionTargets,
+	const UObject* VisLogOwner = nullptr);
+
+}
+
+/**
+ * Solves the suspension constraints of many simple physics vehicles together, four vehicles to a SIMD register.
+ *
+ * Gives the same results as running UE::MassTraffic::SolveSuspensionConstraintsIteration NumIterations times on each
+ * vehicle: every iteration evaluates the constraints from the pose at the start of the iteration and applies the wheel
+ * corrections one after the other. Poses are solved in single precision, relative to each vehicle's center of mass at
+ * the start of the solve, so results stay well within a millimeter of the double precision solve.
+ */
+struct MASSTRAFFIC_API FMassTrafficSuspensionSolverBatch
+{
+	static constexpr int32 VehiclesPerPacket = 4;
+	static constexpr int32 MaxWheels = FMassTrafficSimpleVehiclePhysicsSim::MaxWheels;
+
+	void Reset();
+
+	int32 Num() const { return Vehicles.Num(); }
+	bool IsEmpty() const { return Vehicles.IsEmpty(); }
+
+	/**
+	 * Adds a vehicle whose drive forces have been simulated this frame.
+	 * @param VehicleSim Vehicle to solve, its wheel contacts must be up to date
+	 * @param Transform Current vehicle transform
+	 * @param Velocity Linear velocity of the vehicle after its drive forces were simulated
+	 * @param AngularVelocity Angular velocity of the vehicle after its drive forces were simulated
+	 * @param SuspensionTargets Suspension targets found by the suspension traces, one per wheel
+	 * @return Index of the vehicle in the batch
+	 */
+	int32 Add(const float DeltaTime, const FMassTrafficSimpleVehiclePhysicsSim& VehicleSim, const FTransform& Transform, const FVector& Velocity, const FVector& AngularVelocity, TConstArrayView<FVector> SuspensionTargets);
+
+	/** Runs NumIterations iterations of the suspension constraints of every vehicle */
+	void Solve(const int32 NumIterations);
+
+	/**
+	 * Writes the solved location and rotation of a vehicle into Transform.
+	 * @return Whether any constraint moved the vehicle. If not, Transform is left untouched
+	 */
+	bool ApplyToTransform(const int32 VehicleIndex, FTransform& Transform) const;
+
+private:
+
+	// Structure of arrays for four vehicles, one float per vehicle
+	struct alignas(16) FWheelPacket
+	{
+		float LocalOffsetX[4], LocalOffsetY[4], LocalOffsetZ[4];
+		float LocalAxisX[4], LocalAxisY[4], LocalAxisZ[4];
+		float TargetX[4], TargetY[4], TargetZ[4];
+		float MinLength[4];
+		float MaxLength[4];
+		float Stiffness[4];
+		float Damping[4];
+		float Contact[4];
+	};
+
+	struct alignas(16) FPacket
+	{
+		// Center of mass relative to FVehicle::Origin, and rotation of mass
+		float PX[4], PY[4], PZ[4];
+		float QX[4], QY[4], QZ[4], QW[4];
+
+		float VX[4], VY[4], VZ[4];
+		float WX[4], WY[4], WZ[4];
+		float InverseMass[4];
+		float InverseInertiaX[4], InverseInertiaY[4], InverseInertiaZ[4];
+
+		// How much of the suspension axis to keep over the vertical when the suspension is upright, at low speed
+		float AxisBlend[4];
+
+		// Non zero once a constraint moved the vehicle
+		float Moved[4];
+
+		FWheelPacket Wheels[MaxWheels];
+	};
+
+	struct FVehicle
+	{
+		const FMassTrafficSimpleVehiclePhysicsConfig* Setup = nullptr;
+		FVector Origin = FVector::ZeroVector;
+	};
+
+	TArray<FPacket> Packets;
+	TArray<FVehicle> Vehicles;
+};
@@ -4,6 +4,8 @@
 #pragma once
 
 #include "MassTraffic.h"
+#include "MassTrafficLaneSegmentGrid.h"
+#include "MassTrafficLaneVehicles.h"
 #include "ZoneGraphTypes.h"
 
 #include "HierarchicalHashGrid2D.h"
@@ -469,6 +471,7 @@ struct MASSTRAFFIC_API FZoneGraphTrafficLaneData
 	bool bIsDownstreamFromIntersection : 1;
 	bool bIsStoppedVehicleInPreviousLaneOverlappingThisLane : 1; // (See all CROSSWALKOVERLAP.)
 	bool bIsVehicleReadyToUseLane : 1; // (See all READYLANE.)
+	bool bIsSleepingVehicleWakeRequested : 1; // @see RequestWakeSleepingVehicles
 
 	UE::MassTraffic::TFraction<true, uint8> FractionUntilClosed;
 
@@ -491,6 +494,9 @@ struct MASSTRAFFIC_API FZoneGraphTrafficLaneData
 	uint8 NumVehiclesOnLane = 0;
 	uint8 NumVehiclesApproachingLane = 0; 
 	uint8 NumReservedVehiclesOnLane = 0; // See all CANTSTOPLANEEXIT.
+
+	/** Vehicles on this lane packed in distance order, for scans that don't need to follow the NextVehicle links */
+	FMassTrafficLaneVehicles Vehicles;
 	
 	FZoneGraphTrafficLaneData* LeftLane = nullptr; // ..non-merging non-splitting same-direction lane on left 
 	FZoneGraphTrafficLaneData* RightLane = nullptr; // ..non-merging non-splitting same-direction lane on right
@@ -514,6 +520,12 @@ struct MASSTRAFFIC_API FZoneGraphTrafficLaneData
 	/** Clears all references to vehicles on this lane and reset all vehicle counters */  
 	void ClearVehicles();
 
+	/** Wakes the sleeping simple physics vehicles on this lane next frame, @see UE::MassTraffic::UpdateSleepIslands */
+	FORCEINLINE void RequestWakeSleepingVehicles()
+	{
+		bIsSleepingVehicleWakeRequested = true;
+	}
+
 	/**
 	 * Walks along the vehicles on this lane starting from TailVehicle and following the NextVehicle links,
 	 * calling Function on each vehicle, until we reach a vehicle on another lane or we loop back to TailVehicle.
@@ -566,34 +578,43 @@ struct MASSTRAFFIC_API FMassTrafficZoneGraphData
 		DataHandle.Reset();
 		TrafficLaneDataArray.Reset();
 		TrafficLaneDataLookup.Reset();
+		LaneSegmentGrid.Reset();
 	}
 
 	/* Handle of the storage the data was initialized from. */
 	FZoneGraphDataHandle DataHandle;
 
-	/* Runtime data for traffic lanes */ 
+	/*
+	 * Runtime data for traffic lanes. Built once when the storage is registered and never resized until it is
+	 * unregistered, so the lane pointers in FZoneGraphTrafficLaneData, which never leave the storage, stay valid.
+	 */ 
 	TArray<FZoneGraphTrafficLaneData> TrafficLaneDataArray;
 
-	/* ZoneGraph lane index -> TrafficLaneDataArray entry. Array size matches ZoneGraph storage */   
-	TArray<FZoneGraphTrafficLaneData*> TrafficLaneDataLookup;
+	/* ZoneGraph lane index -> TrafficLaneDataArray index, INDEX_NONE for lanes that aren't traffic lanes. Array size matches ZoneGraph storage */   
+	TArray<int32> TrafficLaneDataLookup;
+
+	/* Segments of the traffic lanes bucketed in a 2D grid, used to find lanes near obstacles */
+	FMassTrafficLaneSegmentGrid LaneSegmentGrid;
 
 	FORCEINLINE const FZoneGraphTrafficLaneData* GetTrafficLaneData(const FZoneGraphLaneHandle LaneHandle) const
 	{
-		return TrafficLaneDataLookup[LaneHandle.Index];
+		return GetTrafficLaneData(LaneHandle.Index);
 	}
 	
 	FORCEINLINE const FZoneGraphTrafficLaneData* GetTrafficLaneData(const int32 LaneIndex) const
 	{
-		return TrafficLaneDataLookup[LaneIndex];
+		const int32 TrafficLaneIndex = TrafficLaneDataLookup[LaneIndex];
+		return TrafficLaneIndex != INDEX_NONE ? &TrafficLaneDataArray[TrafficLaneIndex] : nullptr;
 	}
 
 	FORCEINLINE FZoneGraphTrafficLaneData* GetMutableTrafficLaneData(const FZoneGraphLaneHandle LaneHandle)
 	{
-		return TrafficLaneDataLookup[LaneHandle.Index];
+		return GetMutableTrafficLaneData(LaneHandle.Index);
 	}
 	
 	FORCEINLINE FZoneGraphTrafficLaneData* GetMutableTrafficLaneData(const int32 LaneIndex)
 	{
-		return TrafficLaneDataLookup[LaneIndex];
+		const int32 TrafficLaneIndex = TrafficLaneDataLookup[LaneIndex];
+		return TrafficLaneIndex != INDEX_NONE ? &TrafficLaneDataArray[TrafficLaneIndex] : nullptr;
 	}
 };
@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "MassTrafficProcessorBase.h"
+#include "MassTrafficFragments.h"
+#include "MassTrafficUpdateLaneVehiclesProcessor.generated.h"
+
+
+/**
+ * Copies the distance along lane and speed of every traffic vehicle that moved this frame into the packed vehicle index
+ * of its lane, then restores the distance order of each lane.
+ * @see FMassTrafficLaneVehicles
+ */
+UCLASS()
+class MASSTRAFFIC_API UMassTrafficUpdateLaneVehiclesProcessor : public UMassTrafficProcessorBase
+{
+	GENERATED_BODY()
+
+public:
+	UMassTrafficUpdateLaneVehiclesProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+	FMassEntityQuery EntityQuery_Conditional;
+};
@@ -4,6 +4,7 @@
 
 #include "MassTrafficProcessorBase.h"
 #include "MassTrafficFragments.h"
+#include "MassTrafficSuspensionSolver.h"
 #include "MassActorSubsystem.h"
 #include "MassTrafficVehiclePhysicsProcessor.generated.h"
 
@@ -51,15 +52,15 @@ protected:
 		bool bVisLog
 	);
 
-	void SolveSuspensionConstraintsIteration(
+	void FinishVehicle(
 		const float DeltaTime,
-		FMassTrafficVehiclePhysicsFragment& SimplePhysicsVehicleFragment,
+		FMassTrafficVehicleControlFragment& VehicleControlFragment,
+		const FMassTrafficVehiclePhysicsFragment& SimplePhysicsVehicleFragment,
 		FMassVelocityFragment& VelocityFragment,
 		FMassTrafficAngularVelocityFragment& AngularVelocityFragment,
 		FTransformFragment& TransformFragment,
 		const FTransform& VehicleWorldTransform,
-		const TArray<FVector, TFixedAllocator<FMassTrafficSimpleVehiclePhysicsSim::MaxWheels>>& SuspensionTargets,
-		bool bVisLog
+		const FTransform& RawLaneLocationTransform
 	);
 
 	void ClampLateralDeviation(
@@ -86,4 +87,19 @@ protected:
 
 	Chaos::FPBDJointSolverSettings ChaosConstraintSolverSettings;
 	FMassTrafficSimpleTrailerConstraintSolver TrailerConstraintSolver;
+
+	// Vehicles without a trailer whose suspension constraints are solved together once every chunk is simulated
+	struct FBatchedVehicle
+	{
+		FMassTrafficVehicleControlFragment* VehicleControlFragment = nullptr;
+		FMassTrafficVehiclePhysicsFragment* SimplePhysicsVehicleFragment = nullptr;
+		FMassVelocityFragment* VelocityFragment = nullptr;
+		FMassTrafficAngularVelocityFragment* AngularVelocityFragment = nullptr;
+		FTransformFragment* TransformFragment = nullptr;
+		FTransform VehicleWorldTransform;
+		FTransform RawLaneLocationTransform;
+	};
+
+	FMassTrafficSuspensionSolverBatch SuspensionSolverBatch;
+	TArray<FBatchedVehicle> BatchedVehicles;
 };
@@ -7,6 +7,8 @@
 
 #include "SecretIdentity/UE_Helpers.h"
 #include "SecretIdentity/Characters/EnemyCharacter.h"
+#include "SecretIdentity/UObjects/CombatTargetSubsystem.h"
+#include "SecretIdentity/UObjects/EnemyPoolSubsystem.h"
 
 ACrisisSpawnPoint::ACrisisSpawnPoint()
 {
@@ -29,6 +31,21 @@ void ACrisisSpawnPoint::BeginPlay()
 
 	bIsCrisisActive = false;
 	WARN_IF(TypeToSpawn >= CrisisType::Count);
+
+	if (UCombatTargetSubsystem* CombatTargets = UWorld::GetSubsystem<UCombatTargetSubsystem>(GetWorld()))
+	{
+		CombatTargets->RegisterTarget(this, ECombatTargetType::CrisisSpawnPoint);
+	}
+}
+
+void ACrisisSpawnPoint::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UCombatTargetSubsystem* CombatTargets = UWorld::GetSubsystem<UCombatTargetSubsystem>(GetWorld()))
+	{
+		CombatTargets->UnregisterTarget(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void ACrisisSpawnPoint::Tick(float DeltaTime)
@@ -98,7 +115,15 @@ void ACrisisSpawnPoint::SpawnCrisis(TSubclassOf<ACharacter> ThugCharacterBP)
 	AEnemyCharacter* ThugCharacter = nullptr;
 	if (GetWorld() != nullptr && ThugCharacterBP != nullptr)
 	{
-		ThugCharacter = Cast<AEnemyCharacter>(GetWorld()->SpawnActor(ThugCharacterBP, &CurrentLocation, &CurrentRotation));
+		UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+		if (EnemyPool != nullptr)
+		{
+			ThugCharacter = EnemyPool->AcquireEnemy(ThugCharacterBP, CurrentLocation, CurrentRotation);
+		}
+		else
+		{
+			ThugCharacter = Cast<AEnemyCharacter>(GetWorld()->SpawnActor(ThugCharacterBP, &CurrentLocation, &CurrentRotation));
+		}
 	}
 	else if (ThugCharacterBP != nullptr)
 	{
@@ -124,18 +149,20 @@ void ACrisisSpawnPoint::ForceCleanupNow()
 		return;
 	}
 
-	for (AActor* A : tCrisisActors)
+	TArray<AActor*> ActorsToRelease = tCrisisActors;
+	tCrisisActors.Empty();
+
+	for (AActor* A : ActorsToRelease)
 	{
 		WARN_IF_NULL(A);
-		if (IsValid(A) && A != nullptr)
-		{
-			A->SetLifeSpan(0.001f);
-		}
+		ReleaseCrisisActor(A);
 	}
 
-	tCrisisActors.Empty();
-
-	fCooldownTimerHandle.Invalidate();
+	if (GetWorld() != nullptr)
+	{
+		GetWorld()->GetTimerManager().ClearTimer(fDespawnTimerHandle);
+		GetWorld()->GetTimerManager().ClearTimer(fCooldownTimerHandle);
+	}
 
 	bIsCrisisActive = false;
 	bIsActiveCrisisResolved = false;
@@ -148,19 +175,29 @@ void ACrisisSpawnPoint::OnCrisisActorEndPlay(AActor* ActorDestroyed, EEndPlayRea
 	WARN_IF_NULL(GetWorld());
 
 	tCrisisActors.Remove(ActorDestroyed);
-	if (tCrisisActors.IsEmpty() && GetWorld() != nullptr)
+	if (tCrisisActors.IsEmpty())
 	{
-		if (fCooldownTimerHandle.IsValid())
-		{
-			fCooldownTimerHandle.Invalidate();
-		}
+		StartCooldown();
+	}
+}
 
-		GetWorld()->GetTimerManager().SetTimer(fCooldownTimerHandle, FTimerDelegate::CreateLambda([&]
-		{
-			bIsCrisisActive = false;
-			bIsCleaningUp = false;
-		}), CooldownTime, false);
+void ACrisisSpawnPoint::StartCooldown()
+{
+	if (GetWorld() == nullptr)
+	{
+		return;
+	}
+
+	if (fCooldownTimerHandle.IsValid())
+	{
+		fCooldownTimerHandle.Invalidate();
 	}
+
+	GetWorld()->GetTimerManager().SetTimer(fCooldownTimerHandle, FTimerDelegate::CreateLambda([&]
+	{
+		bIsCrisisActive = false;
+		bIsCleaningUp = false;
+	}), CooldownTime, false);
 }
 
 double ACrisisSpawnPoint::GetSecondsSinceCrisisStarted() const
@@ -170,8 +207,12 @@ double ACrisisSpawnPoint::GetSecondsSinceCrisisStarted() const
 		return 0.0f;
 	}
 
-	FDateTime Now = FDateTime::UtcNow();
-	return UE_Helpers::GetDifferenceInSeconds(fActiveCrisisStartTime, Now);
+	if (GetWorld() == nullptr)
+	{
+		return 0.0f;
+	}
+
+	return FMath::Max(GetWorld()->GetTimeSeconds() - fActiveCrisisStartTime, 0.0);
 }
 
 FVector ACrisisSpawnPoint::GetAverageCrisisActorLocation() const
@@ -200,24 +241,67 @@ void ACrisisSpawnPoint::ActivateCrisis()
 	bIsCrisisActive = true;
 	bIsActiveCrisisResolved = false;
 	bIsCleaningUp = false;
-	fActiveCrisisStartTime = FDateTime::UtcNow();
+	fActiveCrisisStartTime = GetWorld() != nullptr ? GetWorld()->GetTimeSeconds() : 0.0;
 
 #if !UE_BUILD_SHIPPING
 	bHasSpawnedOneCrisis = true;
 #endif //!UE_BUILD_SHIPPING
+
+	OnCrisisStarted.Broadcast(this);
 }
 
 void ACrisisSpawnPoint::ResolveCrisis()
 {
 	bIsActiveCrisisResolved = true;
-	fActiveCrisisStartTime = FDateTime();
+	fActiveCrisisStartTime = 0.0;
 }
 
 void ACrisisSpawnPoint::DespawnAllCrisisActors()
 {
-	for (const auto& A : tCrisisActors)
+	WARN_IF_NULL(GetWorld());
+	if (GetWorld() != nullptr)
+	{
+		GetWorld()->GetTimerManager().SetTimer(fDespawnTimerHandle, this, &ACrisisSpawnPoint::ReleaseAllCrisisActors, 1.0f, false);
+	}
+}
+
+void ACrisisSpawnPoint::ReleaseAllCrisisActors()
+{
+	TArray<AActor*> ActorsToRelease = tCrisisActors;
+	tCrisisActors.Empty();
+
+	for (AActor* A : ActorsToRelease)
+	{
+		ReleaseCrisisActor(A);
+	}
+
+	StartCooldown();
+}
+
+void ACrisisSpawnPoint::ReleaseCrisisActor(AActor* Actor)
+{
+	if (!IsValid(Actor))
+	{
+		return;
+	}
+
+	//We're done with this actor, so we don't want to hear about it being destroyed or reused by another crisis
+	Actor->OnEndPlay.RemoveDynamic(this, &ACrisisSpawnPoint::OnCrisisActorEndPlay);
+
+	AEnemyCharacter* Enemy = Cast<AEnemyCharacter>(Actor);
+	if (Enemy != nullptr)
+	{
+		Enemy->OnDeathDelegate.RemoveAll(this);
+	}
+
+	UEnemyPoolSubsystem* EnemyPool = GetWorld() != nullptr ? GetWorld()->GetSubsystem<UEnemyPoolSubsystem>() : nullptr;
+	if (EnemyPool != nullptr && Enemy != nullptr)
+	{
+		EnemyPool->ReleaseEnemy(Enemy);
+	}
+	else
 	{
-		A->SetLifeSpan(1.0f);
+		Actor->Destroy();
 	}
 }
 
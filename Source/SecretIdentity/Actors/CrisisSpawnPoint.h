@@ -19,6 +19,7 @@ enum class CrisisType : uint8{
 	Count UMETA(Hidden)
 };
 
+DECLARE_MULTICAST_DELEGATE_OneParam(FCrisisStartedDelegate, ACrisisSpawnPoint*);
 DECLARE_MULTICAST_DELEGATE_OneParam(FCrisisResolvedDelegate, ACrisisSpawnPoint*);
 
 //Spawn Point for Crisis Events
@@ -52,16 +53,19 @@ public:
 	UFUNCTION()
 	void OnPlayStateBegins(APawn* NewPawn);
 
-	double GetSecondsSinceCrisisStarted() const;
+	double GetSecondsSinceCrisisStarted() const; //In game time, so pausing and time dilation are respected
+	FORCEINLINE double GetActiveCrisisStartTime() const { return fActiveCrisisStartTime; } //World time seconds when the active crisis started
 	FVector GetAverageCrisisActorLocation() const;
 
 	UFUNCTION(BlueprintCallable)
 	TArray<FVector> GetAllCrisisActorPositions() const;
 
+	FCrisisStartedDelegate OnCrisisStarted;
 	FCrisisResolvedDelegate OnCrisisResolved;
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crisis", meta = (AllowPrivateAccess = "true"))
@@ -79,10 +83,11 @@ private:
 	bool bIsCrisisActive = false;
 	bool bIsActiveCrisisResolved = false;
 	bool bIsCleaningUp = false;
-	FDateTime fActiveCrisisStartTime;
+	double fActiveCrisisStartTime = 0.0;
 	TArray<AActor*> tCrisisActors;
 	APawn* aPlayerPawn;
 	FTimerHandle fCooldownTimerHandle;
+	FTimerHandle fDespawnTimerHandle;
 
 #if !UE_BUILD_SHIPPING
 	bool bHasSpawnedOneCrisis = false;
@@ -91,4 +96,7 @@ private:
 	void ActivateCrisis();
 	void ResolveCrisis();
 	void DespawnAllCrisisActors();
+	void ReleaseAllCrisisActors(); //Returns the crisis actors to the enemy pool (or destroys them) and starts the cooldown
+	void ReleaseCrisisActor(AActor* Actor);
+	void StartCooldown();
 };
@@ -3,10 +3,13 @@
 #include "EnemyCharacter.h"
 
 #include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
 #include "GameFramework/CharacterMovementComponent.h"
 
 #include "SecretIdentity/UE_Helpers.h"
 #include "SecretIdentity/Components/CombatSkeletalMeshComponent.h"
+#include "SecretIdentity/Controllers/EnemyAIController.h"
+#include "SecretIdentity/UObjects/CombatTargetSubsystem.h"
 #include "SecretIdentity/UObjects/PlayableAnimInstance.h"
 
 AEnemyCharacter::AEnemyCharacter(const FObjectInitializer& ObjectInitializer)
@@ -33,12 +36,39 @@ void AEnemyCharacter::BeginPlay()
 		uAnimInstance = Cast<UPlayableAnimInstance>(GetMesh()->GetAnimInstance());
 	}
 
+	if (GetCapsuleComponent() != nullptr)
+	{
+		eCapsuleCollision = GetCapsuleComponent()->GetCollisionEnabled();
+	}
+
 	WARN_IF_NULL(GetCharacterMovement());
 	WARN_IF_NULL(GetController());
 	WARN_IF_NULL(GetCapsuleComponent());
 	WARN_IF_NULL(GetMesh());
 	WARN_IF_NULL(uCombatMeshComponent);
 	WARN_IF_NULL(uAnimInstance);
+
+	if (UCombatTargetSubsystem* CombatTargets = UWorld::GetSubsystem<UCombatTargetSubsystem>(GetWorld()))
+	{
+		CombatTargets->RegisterTarget(this, ECombatTargetType::Enemy);
+	}
+}
+
+void AEnemyCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UCombatTargetSubsystem* CombatTargets = UWorld::GetSubsystem<UCombatTargetSubsystem>(GetWorld()))
+	{
+		CombatTargets->UnregisterTarget(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AEnemyCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	aAIController = NewController;
 }
 
 void AEnemyCharacter::NotifyActorBeginOverlap(AActor* OtherActor)
@@ -106,6 +136,105 @@ void AEnemyCharacter::OnDeath()
 		GetCapsuleComponent()->Deactivate();
 	}
 
+	//Dead enemies are no longer combat targets
+	if (UCombatTargetSubsystem* CombatTargets = UWorld::GetSubsystem<UCombatTargetSubsystem>(GetWorld()))
+	{
+		CombatTargets->UnregisterTarget(this);
+	}
+
 	bIsDead = true;
 	OnDeathDelegate.Broadcast(this);
+}
+
+void AEnemyCharacter::DeactivateForPool()
+{
+	bIsInPool = true;
+
+	//OnDeathDelegate is left alone, whoever acquired this enemy removes its own binding before releasing it to the pool
+
+	if (UCombatTargetSubsystem* CombatTargets = UWorld::GetSubsystem<UCombatTargetSubsystem>(GetWorld()))
+	{
+		CombatTargets->UnregisterTarget(this);
+	}
+
+	if (GetController() != nullptr)
+	{
+		GetController()->UnPossess();
+	}
+
+	if (AEnemyAIController* EnemyController = Cast<AEnemyAIController>(aAIController))
+	{
+		EnemyController->ResetForReuse();
+	}
+
+	//Stop simulating the ragdoll, nobody will see it
+	if (uCombatMeshComponent != nullptr)
+	{
+		uCombatMeshComponent->DisableRagdoll();
+	}
+
+	if (GetCharacterMovement() != nullptr)
+	{
+		GetCharacterMovement()->StopMovementImmediately();
+		GetCharacterMovement()->SetMovementMode(EMovementMode::MOVE_None);
+	}
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+}
+
+void AEnemyCharacter::ReactivateFromPool(const FVector& Location, const FRotator& Rotation)
+{
+	WARN_IF_MSG(!bIsInPool, "ReactivateFromPool called on an enemy that is not in the pool!");
+
+	bIsInPool = false;
+	bIsDead = false;
+
+	if (uCombatMeshComponent != nullptr)
+	{
+		uCombatMeshComponent->DisableRagdoll();
+	}
+
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+
+	if (GetCapsuleComponent() != nullptr)
+	{
+		GetCapsuleComponent()->Activate();
+		GetCapsuleComponent()->SetCollisionEnabled(eCapsuleCollision);
+	}
+
+	SetActorEnableCollision(true);
+	SetActorHiddenInGame(false);
+
+	if (GetCharacterMovement() != nullptr)
+	{
+		GetCharacterMovement()->SetDefaultMovementMode();
+	}
+
+	//Possessing restarts the behavior tree, see AEnemyAIController::OnPossess
+	if (aAIController != nullptr && GetController() == nullptr)
+	{
+		aAIController->Possess(this);
+	}
+	else if (GetController() == nullptr && (AutoPossessAI == EAutoPossessAI::Spawned || AutoPossessAI == EAutoPossessAI::PlacedInWorldOrSpawned))
+	{
+		SpawnDefaultController();
+	}
+
+	//Back to the state we were spawned in
+	const AEnemyCharacter* DefaultEnemy = GetClass()->GetDefaultObject<AEnemyCharacter>();
+	if (DefaultEnemy != nullptr && DefaultEnemy->GetCharacterMovement() != nullptr)
+	{
+		UpdateWalkSpeed(DefaultEnemy->GetCharacterMovement()->MaxWalkSpeed);
+	}
+
+	if (uAnimInstance != nullptr)
+	{
+		uAnimInstance->IsShooting = false;
+	}
+
+	if (UCombatTargetSubsystem* CombatTargets = UWorld::GetSubsystem<UCombatTargetSubsystem>(GetWorld()))
+	{
+		CombatTargets->RegisterTarget(this, ECombatTargetType::Enemy);
+	}
 }
\ No newline at end of file
@@ -38,10 +38,17 @@ public:
 
 	bool IsDead() const{ return bIsDead; }
 
+	//Object pooling, see UEnemyPoolSubsystem
+	void DeactivateForPool(); //Hides the enemy and stops everything that costs time while it waits in the pool
+	void ReactivateFromPool(const FVector& Location, const FRotator& Rotation); //Undoes death and DeactivateForPool so the enemy is as good as newly spawned
+	bool IsInPool() const{ return bIsInPool; }
+
 	FEnemyCharacterDeathDelegate OnDeathDelegate;
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void PossessedBy(AController* NewController) override;
 
 private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement", meta = (AllowPrivateAccess = "true"))
@@ -58,7 +65,14 @@ private:
 
 	UCombatSkeletalMeshComponent* uCombatMeshComponent = nullptr;
 	UPlayableAnimInstance* uAnimInstance = nullptr;
-	bool bIsDead;
+	bool bIsDead = false;
+	bool bIsInPool = false;
+
+	//The controller is unpossessed on death, keep it so it can possess us again when we're reused from the pool
+	UPROPERTY()
+	AController* aAIController = nullptr;
+
+	ECollisionEnabled::Type eCapsuleCollision = ECollisionEnabled::QueryAndPhysics;
 
 	void OnDeath();
 };
\ No newline at end of file
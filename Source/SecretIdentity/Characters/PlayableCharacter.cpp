@@ -30,6 +30,7 @@
 #include "SecretIdentity/Controllers/PlayableCharacterController.h"
 #include "SecretIdentity/GameModes/ArcadeGameMode.h"
 #include "SecretIdentity/SceneComponents/MusicPlayer.h"
+#include "SecretIdentity/UObjects/CombatTargetSubsystem.h"
 #include "SecretIdentity/UObjects/PlayableAnimInstance.h"
 
 APlayableCharacter::APlayableCharacter(const FObjectInitializer& ObjectInitializer) :
@@ -471,27 +472,14 @@ void APlayableCharacter::OnSwitchToPunchState()
 		uAnimInstance->IsPunching = true;
 	}
 
-	TArray<AActor*> Enemies;
-	UGameplayStatics::GetAllActorsOfClass(this, AEnemyCharacter::StaticClass(), Enemies);
-
+	//Only live enemies are registered, see AEnemyCharacter
 	AActor* NearestEnemy = nullptr;
-	float NearestDistance = std::numeric_limits<float>::infinity();
-
-	for (AActor* Actor : Enemies)
+	if (UCombatTargetSubsystem* CombatTargets = UWorld::GetSubsystem<UCombatTargetSubsystem>(GetWorld()))
 	{
-		AEnemyCharacter* Enemy = Cast<AEnemyCharacter>(Actor);
-		if (Enemy != nullptr && IsValid(Enemy) && !Enemy->IsDead())
-		{
-			float Distance = FVector::Distance(Enemy->GetActorLocation(), GetActorLocation());
-			if (NearestEnemy == nullptr || Distance < NearestDistance)
-			{
-				NearestEnemy = Enemy;
-				NearestDistance = Distance;
-			}
-		}
+		NearestEnemy = CombatTargets->FindNearestTarget(ECombatTargetType::Enemy, GetActorLocation(), PunchMagnetRange);
 	}
 
-	if (NearestEnemy != nullptr && IsValid(NearestEnemy) && NearestDistance <= PunchMagnetRange)
+	if (NearestEnemy != nullptr && IsValid(NearestEnemy))
 	{
 		SetTargetActor(NearestEnemy);
 	}
@@ -16,5 +16,34 @@ UCombatSkeletalMeshComponent::UCombatSkeletalMeshComponent()
 
 void UCombatSkeletalMeshComponent::EnableRagdoll()
 {
+	if (!IsSimulatingPhysics())
+	{
+		uPreRagdollParent = GetAttachParent();
+		fPreRagdollRelativeTransform = GetRelativeTransform();
+	}
+
 	SetSimulatePhysics(true);
+}
+
+void UCombatSkeletalMeshComponent::DisableRagdoll()
+{
+	if (!IsSimulatingPhysics() && uPreRagdollParent == nullptr)
+	{
+		return;
+	}
+
+	SetSimulatePhysics(false);
+	ResetAllBodiesSimulatePhysics();
+
+	//Simulating can detach us from the capsule, put the mesh back where it was
+	if (uPreRagdollParent != nullptr)
+	{
+		if (GetAttachParent() != uPreRagdollParent)
+		{
+			AttachToComponent(uPreRagdollParent, FAttachmentTransformRules::KeepRelativeTransform);
+		}
+
+		SetRelativeTransform(fPreRagdollRelativeTransform, false, nullptr, ETeleportType::ResetPhysics);
+		uPreRagdollParent = nullptr;
+	}
 }
\ No newline at end of file
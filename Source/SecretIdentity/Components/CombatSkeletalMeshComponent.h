@@ -16,4 +16,9 @@ public:
 	UCombatSkeletalMeshComponent();
 
 	void EnableRagdoll();
+	void DisableRagdoll(); //Stops simulating and snaps the mesh back to where it was attached before EnableRagdoll
+
+private:
+	USceneComponent* uPreRagdollParent = nullptr;
+	FTransform fPreRagdollRelativeTransform = FTransform::Identity;
 };
@@ -4,6 +4,7 @@
 
 #include "Kismet/GameplayStatics.h"
 
+#include "BrainComponent.h"
 #include "BehaviorTree/BlackboardComponent.h"
 #include "Perception/AIPerceptionComponent.h"
 #include "Perception/AIPerceptionTypes.h"
@@ -105,6 +106,31 @@ void AEnemyAIController::OnStartEnemyTimer()
 	SetBlackboardValues(false, nullptr);
 }
 
+void AEnemyAIController::ResetForReuse()
+{
+	if (GetWorld() != nullptr)
+	{
+		GetWorld()->GetTimerManager().ClearTimer(EnemyTimerHandle);
+	}
+
+	StopMovement();
+
+	if (BrainComponent != nullptr)
+	{
+		BrainComponent->StopLogic(TEXT("Returned to pool"));
+	}
+
+	if (PerceptionComponent != nullptr)
+	{
+		PerceptionComponent->ForgetAll();
+	}
+
+	if (Blackboard != nullptr)
+	{
+		SetBlackboardValues(false, nullptr);
+	}
+}
+
 void AEnemyAIController::SetBlackboardValues(bool HasLineOfSight, AActor* TargetActor)
 {
 	WARN_IF_NULL(Blackboard);
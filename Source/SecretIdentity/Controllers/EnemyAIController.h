@@ -28,6 +28,9 @@ public:
 	UFUNCTION()
 	void OnStartEnemyTimer();
 
+	//Called when our pawn goes back to the enemy pool. Stops the behavior tree and forgets the target so the next possession starts fresh
+	void ResetForReuse();
+
 private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI", meta = (AllowPrivateAccess = "true"))
 	UBehaviorTree* EnemyBehaviorTree = nullptr;
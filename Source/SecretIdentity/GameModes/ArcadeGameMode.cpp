@@ -8,6 +8,8 @@
 #include "SecretIdentity/UE_Helpers.h"
 #include "SecretIdentity/Actors/ArcadePlayerStart.h"
 #include "SecretIdentity/Actors/CrisisSpawnPoint.h"
+#include "SecretIdentity/UObjects/CombatTargetSubsystem.h"
+#include "SecretIdentity/UObjects/EnemyPoolSubsystem.h"
 
 AArcadeGameMode::AArcadeGameMode()
 {
@@ -105,14 +107,14 @@ void AArcadeGameMode::Tick(float DeltaTime)
 	}
 
 	fCurrentFearPercentage = GetFearPercentage();
-	OnUpdateFearMeter.Broadcast(static_cast<float>(fCurrentFearPercentage)); //This is mainly for UI so we're okay with lower precision
+	BroadcastFearMeterIfChanged(static_cast<float>(fCurrentFearPercentage)); //This is mainly for UI so we're okay with lower precision
 
 	if (fCurrentFearPercentage >= 1.0f)
 	{
 		GameOver();
 	}
 
-	OnUpdateSessionTimer.Broadcast(fPlayStateTimer);
+	BroadcastSessionTimerIfChanged(fPlayStateTimer);
 }
 
 void AArcadeGameMode::StartMenuState()
@@ -143,9 +145,20 @@ void AArcadeGameMode::StartPlayState()
 
 		//Get all the Crisis Spawn Points
 		CrisisSpawnPoints.Empty();
+		CrisisLedger.Reset();
+
+		//Forget what the last session broadcast so the first values of this one always go out
+		fLastBroadcastFearPercentage = -1.0f;
+		fLastBroadcastSessionTime = -1.0f;
 
+		//Spawn points register themselves in BeginPlay, which has run for every actor in the level by now
 		TArray<AActor*> FoundActors;
-		UGameplayStatics::GetAllActorsOfClass(GetWorld(), ACrisisSpawnPoint::StaticClass(), FoundActors);
+		UCombatTargetSubsystem* CombatTargets = GetWorld()->GetSubsystem<UCombatTargetSubsystem>();
+		WARN_IF_NULL(CombatTargets);
+		if (CombatTargets != nullptr)
+		{
+			CombatTargets->GetAllTargets(ECombatTargetType::CrisisSpawnPoint, FoundActors);
+		}
 		WARN_IF(FoundActors.IsEmpty());
 
 		for (const auto& A : FoundActors)
@@ -156,6 +169,7 @@ void AArcadeGameMode::StartPlayState()
 			{
 				CrisisSpawnPoints.Add(CSP);
 				OnStartPlayState.AddDynamic(CSP, &ACrisisSpawnPoint::OnPlayStateBegins);
+				CSP->OnCrisisStarted.AddUObject(this, &AArcadeGameMode::OnCrisisStarted);
 				CSP->OnCrisisResolved.AddUObject(this, &AArcadeGameMode::OnCrisisResolved);
 			}
 		}
@@ -170,6 +184,11 @@ void AArcadeGameMode::StartPlayState()
 		if (ThugEnemyClass != nullptr)
 		{
 			ThugEnemyClass->GetDefaultObject(true); //Create the default object upfront so it's ready to be spawned in later
+
+			if (UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>())
+			{
+				EnemyPool->Prewarm(ThugEnemyClass, NumEnemiesToPrewarm);
+			}
 		}
 
 		OnStartPlayState.Broadcast(aPlayStatePawn);
@@ -337,58 +356,30 @@ void AArcadeGameMode::SpawnCrisis()
 	}
 }
 
-int AArcadeGameMode::GetNumActiveCrises()
+int AArcadeGameMode::GetNumActiveCrises() const
 {
-	int ActiveCrises = 0;
-
-	for (const auto& CSP : CrisisSpawnPoints)
-	{
-		WARN_IF_NULL(CSP);
-		if (CSP == nullptr)
-		{
-			continue;
-		}
-
-		if (CSP->IsCrisisActiveAndNotResolved())
-		{
-			ActiveCrises++;
-		}
-	}
-
-	return ActiveCrises;
+	return CrisisLedger.GetNumActiveCrises();
 }
 
-double AArcadeGameMode::GetTotalFear()
+double AArcadeGameMode::GetTotalFear() const
 {
-	double FearTotal = 0.0f;
-
-	for (const auto& CSP : CrisisSpawnPoints)
+	if (DebugDisableFearMeter || GetWorld() == nullptr)
 	{
-		WARN_IF_NULL(CSP);
-		if (CSP == nullptr)
-		{
-			continue;
-		}
-
-		double FearAmount = CSP->GetSecondsSinceCrisisStarted() / 5.0f; //Every 5 seconds a crisis is active, it increases our fear total by one
-		WARN_IF(FearAmount < 0.0f);
-		FearTotal += FMath::Clamp(FearAmount, 0.0, std::numeric_limits<double>::infinity());
+		return 0.0f;
 	}
 
+	double FearTotal = CrisisLedger.GetTotalFear(GetWorld()->GetTimeSeconds(), SecondsPerFearPoint);
+	WARN_IF(FearTotal < 0.0f);
+
 	if (DebugFastFearMeter)
 	{
 		FearTotal *= 10.0f;
 	}
 
-	if (DebugDisableFearMeter)
-	{
-		FearTotal = 0.0f;
-	}
-
 	return FearTotal;
 }
 
-double AArcadeGameMode::GetFearPercentage()
+double AArcadeGameMode::GetFearPercentage() const
 {
 	if (CrisisSpawnPoints.IsEmpty())
 	{
@@ -400,11 +391,44 @@ double AArcadeGameMode::GetFearPercentage()
 	return FMath::Clamp(FearPercentage, 0.0f, 1.0f); 
 }
 
+void AArcadeGameMode::BroadcastFearMeterIfChanged(float FearPercentage)
+{
+	if (FearPercentage != fLastBroadcastFearPercentage)
+	{
+		fLastBroadcastFearPercentage = FearPercentage;
+		OnUpdateFearMeter.Broadcast(FearPercentage);
+	}
+}
+
+void AArcadeGameMode::BroadcastSessionTimerIfChanged(float SessionTime)
+{
+	if (SessionTime != fLastBroadcastSessionTime)
+	{
+		fLastBroadcastSessionTime = SessionTime;
+		OnUpdateSessionTimer.Broadcast(SessionTime);
+	}
+}
+
+void AArcadeGameMode::OnCrisisStarted(ACrisisSpawnPoint* CSP)
+{
+	WARN_IF_NULL(CSP);
+	if (CSP != nullptr)
+	{
+		CrisisLedger.StartCrisis(CSP->GetUniqueID(), CSP->GetActiveCrisisStartTime());
+	}
+}
+
 void AArcadeGameMode::OnCrisisResolved(ACrisisSpawnPoint* CSP)
 {
+	WARN_IF_NULL(CSP);
+	if (CSP != nullptr)
+	{
+		CrisisLedger.EndCrisis(CSP->GetUniqueID());
+	}
+
 	fNumCrisesResolved++;
 	OnUpdateCrisisCount.Broadcast(GetNumActiveCrises());
-	OnUpdateFearMeter.Broadcast(GetFearPercentage());
+	BroadcastFearMeterIfChanged(static_cast<float>(GetFearPercentage()));
 
 	//Clamp the time value so the next crisis doesn't spawn immediately after solving one
 	if (GetNumActiveCrises() * 5.0f < fCurrentSpawnTime && fTimer > (GetNumActiveCrises() * 5.0f) - 5.0f)
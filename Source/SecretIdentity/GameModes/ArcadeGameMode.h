@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 
 #include "SecretIdentity/Actors/CrisisSpawnPoint.h"
+#include "SecretIdentity/GameModes/CrisisLedger.h"
 #include "SecretIdentity/GameModes/DefaultGameMode.h"
 
 #include "ArcadeGameMode.generated.h"
@@ -40,6 +41,9 @@ class SECRETIDENTITY_API AArcadeGameMode : public ADefaultGameMode
 public:
 	AArcadeGameMode();
 
+	UFUNCTION()
+	void OnCrisisStarted(ACrisisSpawnPoint* CSP);
+
 	UFUNCTION()
 	void OnCrisisResolved(ACrisisSpawnPoint* CSP);
 
@@ -113,6 +117,14 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crisis", meta = (AllowPrivateAccess = "true"))
 	TSubclassOf<ACharacter> ThugEnemyClass;
 
+	//Number of thugs spawned into the enemy pool when the play state starts, so the first crises don't spawn any actors
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crisis", meta = (AllowPrivateAccess = "true", ClampMin = "0"))
+	int NumEnemiesToPrewarm = 4;
+
+	//Every this many seconds (in game time) a crisis is active, it increases the fear total by one
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crisis", meta = (AllowPrivateAccess = "true", ClampMin = "0.01"))
+	float SecondsPerFearPoint = 0.5f;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crisis", meta = (AllowPrivateAccess = "true"))
 	int NumActiveCrises = 0;
 
@@ -152,13 +164,21 @@ private:
 	bool bIsPaused = false;
 	int fNumCrisesResolved = 0;
 
+	//Last values sent to the UI, so we only broadcast when they change
+	float fLastBroadcastFearPercentage = -1.0f;
+	float fLastBroadcastSessionTime = -1.0f;
+
 	TArray<ACrisisSpawnPoint*> CrisisSpawnPoints;
+	FCrisisLedger CrisisLedger;
 
 	void SpawnCrisis();
 
-	int GetNumActiveCrises();
-	double GetTotalFear();
-	double GetFearPercentage();
+	int GetNumActiveCrises() const;
+	double GetTotalFear() const;
+	double GetFearPercentage() const;
+
+	void BroadcastFearMeterIfChanged(float FearPercentage);
+	void BroadcastSessionTimerIfChanged(float SessionTime);
 
 	void GameOver();
 
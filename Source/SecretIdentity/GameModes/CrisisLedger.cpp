@@ -0,0 +1,48 @@
+// Copyright Carter Rennick, 2024. All Rights Reserved.
+
+#include "SecretIdentity/GameModes/CrisisLedger.h"
+
+#include "SecretIdentity/UE_Helpers.h"
+
+void FCrisisLedger::StartCrisis(uint32 CrisisId, double StartGameTime)
+{
+	WARN_IF_MSG(tStartGameTimes.Contains(CrisisId), "StartCrisis called on a crisis that is already active!");
+
+	EndCrisis(CrisisId); //Keep the totals consistent if a crisis is restarted without ending
+	tStartGameTimes.Add(CrisisId, StartGameTime);
+	fSumOfStartGameTimes += StartGameTime;
+}
+
+void FCrisisLedger::EndCrisis(uint32 CrisisId)
+{
+	double StartGameTime = 0.0;
+	if (tStartGameTimes.RemoveAndCopyValue(CrisisId, StartGameTime))
+	{
+		fSumOfStartGameTimes -= StartGameTime;
+	}
+
+	if (tStartGameTimes.IsEmpty())
+	{
+		fSumOfStartGameTimes = 0.0; //Don't let rounding errors accumulate over a long session
+	}
+}
+
+void FCrisisLedger::Reset()
+{
+	tStartGameTimes.Empty();
+	fSumOfStartGameTimes = 0.0;
+}
+
+double FCrisisLedger::GetTotalFear(double GameTime, double SecondsPerFearPoint) const
+{
+	if (tStartGameTimes.IsEmpty() || SecondsPerFearPoint <= 0.0)
+	{
+		return 0.0;
+	}
+
+	//Sum of (GameTime - StartTime) over every active crisis, without visiting each of them
+	double SecondsActive = GetNumActiveCrises() * GameTime - fSumOfStartGameTimes;
+	WARN_IF(SecondsActive < -UE_KINDA_SMALL_NUMBER);
+
+	return FMath::Max(SecondsActive, 0.0) / SecondsPerFearPoint;
+}
@@ -0,0 +1,25 @@
+// Copyright Carter Rennick, 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Running totals of the active (not yet resolved) crises, kept up to date as crises start and end
+//This lets the game mode answer "how many crises" and "how much fear" without scanning every spawn point each frame
+//All times are in game time (world time seconds) so pausing and time dilation are respected
+class SECRETIDENTITY_API FCrisisLedger
+{
+public:
+	void StartCrisis(uint32 CrisisId, double StartGameTime);
+	void EndCrisis(uint32 CrisisId); //Does nothing if the crisis already ended
+	void Reset();
+
+	FORCEINLINE int GetNumActiveCrises() const { return tStartGameTimes.Num(); }
+
+	//Every SecondsPerFearPoint a crisis is active, it increases the fear total by one
+	double GetTotalFear(double GameTime, double SecondsPerFearPoint) const;
+
+private:
+	TMap<uint32, double> tStartGameTimes;
+	double fSumOfStartGameTimes = 0.0;
+};
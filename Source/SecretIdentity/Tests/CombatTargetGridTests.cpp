@@ -0,0 +1,201 @@
+// Copyright Carter Rennick, 2024. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#include "Math/RandomStream.h"
+
+#include "SecretIdentity/UObjects/CombatTargetGrid.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace CombatTargetGridTests
+{
+	//Roughly the size of the playable city
+	static constexpr double WorldExtent = 50000.0;
+
+	static FVector RandomLocation(FRandomStream& Random)
+	{
+		return FVector(Random.FRandRange(-WorldExtent, WorldExtent), Random.FRandRange(-WorldExtent, WorldExtent), Random.FRandRange(0.0, 2000.0));
+	}
+
+	static void FillGrid(FCombatTargetGrid& Grid, TMap<uint32, FVector>& Locations, FRandomStream& Random, int NumTargets)
+	{
+		for (int i = 0; i < NumTargets; i++)
+		{
+			const FVector Location = RandomLocation(Random);
+			Grid.Add(static_cast<uint32>(i), Location);
+			Locations.Add(static_cast<uint32>(i), Location);
+		}
+	}
+
+	//What APlayableCharacter used to do with GetAllActorsOfClass, minus the actor iteration
+	static double LinearNearestDistance(const TMap<uint32, FVector>& Locations, const FVector& Origin, double Radius, const FVector* ConeDirection = nullptr, double MinCosAngle = -1.0)
+	{
+		double NearestDistance = -1.0;
+		for (const TPair<uint32, FVector>& Target : Locations)
+		{
+			const double Distance = FVector::Distance(Origin, Target.Value);
+			if (Distance > Radius || (NearestDistance >= 0.0 && Distance >= NearestDistance))
+			{
+				continue;
+			}
+
+			if (ConeDirection != nullptr && FVector::DotProduct((Target.Value - Origin).GetSafeNormal(), *ConeDirection) < MinCosAngle)
+			{
+				continue;
+			}
+
+			NearestDistance = Distance;
+		}
+
+		return NearestDistance;
+	}
+
+	static double GridNearestDistance(const FCombatTargetGrid& Grid, const TMap<uint32, FVector>& Locations, const FVector& Origin, double Radius)
+	{
+		uint32 Id = 0;
+		return Grid.FindNearest(Origin, Radius, Id) ? FVector::Distance(Origin, Locations[Id]) : -1.0;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatTargetGridQueryTest, "SecretIdentity.CombatTargetGrid.Queries", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FCombatTargetGridQueryTest::RunTest(const FString& Parameters)
+{
+	using namespace CombatTargetGridTests;
+
+	FRandomStream Random(1234);
+	FCombatTargetGrid Grid;
+	TMap<uint32, FVector> Locations;
+	FillGrid(Grid, Locations, Random, 2000);
+
+	//Move and remove some targets so the cell bookkeeping gets exercised
+	for (uint32 Id = 0; Id < 2000; Id += 3)
+	{
+		const FVector Location = RandomLocation(Random);
+		Grid.Move(Id, Location);
+		Locations[Id] = Location;
+	}
+
+	for (uint32 Id = 1; Id < 2000; Id += 7)
+	{
+		Grid.Remove(Id);
+		Locations.Remove(Id);
+	}
+
+	TestEqual(TEXT("Number of targets"), Grid.Num(), Locations.Num());
+
+	const double Radii[] = { 0.0, 200.0, 1500.0, 12000.0, std::numeric_limits<double>::infinity() };
+	bool bNearestMatches = true;
+	bool bConeMatches = true;
+	bool bRadiusMatches = true;
+
+	for (int Query = 0; Query < 500; Query++)
+	{
+		const FVector Origin = RandomLocation(Random);
+		const double Radius = Radii[Query % UE_ARRAY_COUNT(Radii)];
+
+		bNearestMatches &= GridNearestDistance(Grid, Locations, Origin, Radius) == LinearNearestDistance(Locations, Origin, Radius);
+
+		const FVector Direction = FVector(Random.FRandRange(-1.0, 1.0), Random.FRandRange(-1.0, 1.0), 0.0).GetSafeNormal();
+		const double HalfAngleDegrees = 45.0;
+		const double MinCosAngle = FMath::Cos(FMath::DegreesToRadians(HalfAngleDegrees));
+
+		uint32 ConeId = 0;
+		const double ConeDistance = Grid.FindNearestInCone(Origin, Direction, HalfAngleDegrees, Radius, ConeId) ? FVector::Distance(Origin, Locations[ConeId]) : -1.0;
+		bConeMatches &= ConeDistance == LinearNearestDistance(Locations, Origin, Radius, &Direction, MinCosAngle);
+
+		TArray<uint32> InRadius;
+		Grid.FindInRadius(Origin, Radius, InRadius);
+
+		TArray<uint32> ExpectedInRadius;
+		for (const TPair<uint32, FVector>& Target : Locations)
+		{
+			if (FVector::DistSquared(Origin, Target.Value) <= FMath::Square(Radius))
+			{
+				ExpectedInRadius.Add(Target.Key);
+			}
+		}
+
+		InRadius.Sort();
+		ExpectedInRadius.Sort();
+		bRadiusMatches &= InRadius == ExpectedInRadius;
+	}
+
+	TestTrue(TEXT("Nearest target matches a linear search"), bNearestMatches);
+	TestTrue(TEXT("Nearest target in a cone matches a linear search"), bConeMatches);
+	TestTrue(TEXT("Targets in radius match a linear search"), bRadiusMatches);
+
+	//Filters are respected, and nothing is found once everything is gone
+	uint32 Id = 0;
+	TestFalse(TEXT("Filter rejecting everything finds nothing"), Grid.FindNearest(FVector::ZeroVector, 100000.0, Id, [](uint32, const FVector&) { return false; }));
+
+	Grid.Reset();
+	TestFalse(TEXT("Empty grid finds nothing"), Grid.FindNearest(FVector::ZeroVector, 100000.0, Id));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatTargetGridBenchmark, "SecretIdentity.CombatTargetGrid.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FCombatTargetGridBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace CombatTargetGridTests;
+
+	const int NumQueries = 10000;
+	const double PunchMagnetRange = 200.0; //APlayableCharacter's default
+	const double ConeRadius = 2000.0;
+
+	for (int NumTargets : { 1000, 10000 })
+	{
+		FRandomStream Random(NumTargets);
+		FCombatTargetGrid Grid;
+		TMap<uint32, FVector> Locations;
+		FillGrid(Grid, Locations, Random, NumTargets);
+
+		TArray<FVector> Origins;
+		for (int i = 0; i < NumQueries; i++)
+		{
+			Origins.Add(RandomLocation(Random));
+		}
+
+		//Sum the results so the queries can't be optimized away
+		double Checksum = 0.0;
+
+		double StartTime = FPlatformTime::Seconds();
+		for (const FVector& Origin : Origins)
+		{
+			Checksum += LinearNearestDistance(Locations, Origin, PunchMagnetRange);
+		}
+		const double LinearSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (const FVector& Origin : Origins)
+		{
+			Checksum += GridNearestDistance(Grid, Locations, Origin, PunchMagnetRange);
+		}
+		const double GridSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (const FVector& Origin : Origins)
+		{
+			uint32 Id = 0;
+			Checksum += Grid.FindNearestInCone(Origin, FVector::ForwardVector, 45.0, ConeRadius, Id) ? 1.0 : 0.0;
+		}
+		const double ConeSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int i = 0; i < NumTargets; i++)
+		{
+			Grid.Move(static_cast<uint32>(i), Locations[static_cast<uint32>(i)] + FVector(150.0, 0.0, 0.0));
+		}
+		const double MoveSeconds = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(TEXT("%d targets, %d nearest queries: linear %.3fms, grid %.3fms, grid cone %.3fms, moving every target %.3fms (checksum %.1f)"),
+			NumTargets, NumQueries, LinearSeconds * 1000.0, GridSeconds * 1000.0, ConeSeconds * 1000.0, MoveSeconds * 1000.0, Checksum));
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,128 @@
+// Copyright Carter Rennick, 2024. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#include "SecretIdentity/GameModes/CrisisLedger.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace CrisisLedgerTests
+{
+	struct FCrisisEvent
+	{
+		double GameTime;
+		uint32 CrisisId;
+		bool bStart;
+	};
+
+	//Crises starting and ending on whole game seconds, so every simulated clock below hits them exactly
+	static const TArray<FCrisisEvent> Events =
+	{
+		{ 1.0, 1, true },
+		{ 3.0, 2, true },
+		{ 4.0, 3, true },
+		{ 6.0, 2, false },
+		{ 9.0, 1, false },
+		{ 10.0, 1, true },
+		{ 12.0, 3, false },
+	};
+
+	static constexpr double SecondsPerFearPoint = 5.0;
+	static constexpr int NumSamples = 15;
+
+	//Advances a game clock the way the world does (real delta time scaled by time dilation) and samples the fear total on every whole game second
+	//Step sizes and dilations are powers of two so the game clock is exact and the results can be compared bit for bit
+	static TArray<double> SimulateFearCurve(double RealDeltaTime, double TimeDilation, int PauseEveryNthFrame)
+	{
+		FCrisisLedger Ledger;
+		TArray<double> Samples;
+
+		double GameTime = 0.0;
+		int NextEvent = 0;
+
+		for (int Frame = 0; Samples.Num() < NumSamples; Frame++)
+		{
+			const bool bPaused = PauseEveryNthFrame > 0 && (Frame % PauseEveryNthFrame) == 0;
+			GameTime += RealDeltaTime * (bPaused ? 0.0 : TimeDilation);
+
+			while (NextEvent < Events.Num() && Events[NextEvent].GameTime <= GameTime)
+			{
+				const FCrisisEvent& Event = Events[NextEvent++];
+				if (Event.bStart)
+				{
+					Ledger.StartCrisis(Event.CrisisId, GameTime); //Stamped with the frame time, like ACrisisSpawnPoint does
+				}
+				else
+				{
+					Ledger.EndCrisis(Event.CrisisId);
+				}
+			}
+
+			if (GameTime >= Samples.Num() + 1)
+			{
+				Samples.Add(Ledger.GetTotalFear(GameTime, SecondsPerFearPoint));
+			}
+		}
+
+		return Samples;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCrisisLedgerFearCurveTest, "SecretIdentity.CrisisLedger.FearCurve", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FCrisisLedgerFearCurveTest::RunTest(const FString& Parameters)
+{
+	using namespace CrisisLedgerTests;
+
+	const TArray<double> Reference = SimulateFearCurve(1.0 / 64.0, 1.0, 0);
+
+	TestEqual(TEXT("Half speed"), SimulateFearCurve(1.0 / 64.0, 0.5, 0), Reference);
+	TestEqual(TEXT("Slow motion at a lower frame rate"), SimulateFearCurve(1.0 / 32.0, 0.125, 0), Reference);
+	TestEqual(TEXT("Fast forward"), SimulateFearCurve(1.0 / 128.0, 4.0, 0), Reference);
+	TestEqual(TEXT("Intermittent pauses"), SimulateFearCurve(1.0 / 64.0, 1.0, 3), Reference);
+
+	//Compare against fear summed crisis by crisis, the way the game mode used to compute it
+	for (int Sample = 0; Sample < Reference.Num(); Sample++)
+	{
+		const double GameTime = Sample + 1;
+		double ExpectedFear = 0.0;
+
+		TMap<uint32, double> StartTimes;
+		for (const FCrisisEvent& Event : Events)
+		{
+			if (Event.GameTime > GameTime)
+			{
+				break;
+			}
+
+			if (Event.bStart)
+			{
+				StartTimes.Add(Event.CrisisId, Event.GameTime);
+			}
+			else
+			{
+				StartTimes.Remove(Event.CrisisId);
+			}
+		}
+
+		for (const TPair<uint32, double>& Crisis : StartTimes)
+		{
+			ExpectedFear += (GameTime - Crisis.Value) / SecondsPerFearPoint;
+		}
+
+		TestEqual(FString::Printf(TEXT("Fear at %.0f seconds"), GameTime), Reference[Sample], ExpectedFear, UE_KINDA_SMALL_NUMBER);
+	}
+
+	//Ending a crisis twice or one that never started must not change the totals
+	FCrisisLedger Ledger;
+	Ledger.StartCrisis(1, 2.0);
+	Ledger.EndCrisis(1);
+	Ledger.EndCrisis(1);
+	Ledger.EndCrisis(7);
+	TestEqual(TEXT("No active crises"), Ledger.GetNumActiveCrises(), 0);
+	TestEqual(TEXT("No fear"), Ledger.GetTotalFear(100.0, SecondsPerFearPoint), 0.0);
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
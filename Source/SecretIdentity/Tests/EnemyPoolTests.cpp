@@ -0,0 +1,175 @@
+// Copyright Carter Rennick, 2024. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#include "Components/CapsuleComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "UObject/UObjectGlobals.h"
+
+#include "SecretIdentity/Characters/EnemyCharacter.h"
+#include "SecretIdentity/UObjects/EnemyPoolSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace EnemyPoolTests
+{
+	//A game world that lives for the duration of a test, so actors can be spawned without starting PIE
+	struct FScopedTestWorld
+	{
+		UWorld* World = nullptr;
+
+		FScopedTestWorld()
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("EnemyPoolTestWorld"));
+
+			FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+			WorldContext.SetCurrentWorld(World);
+
+			World->InitializeActorsForPlay(FURL());
+			World->BeginPlay();
+		}
+
+		~FScopedTestWorld()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+	};
+
+	//Kill an enemy the same way gameplay does, through an overlap
+	static void KillEnemy(UWorld* World, AEnemyCharacter* Enemy)
+	{
+		Enemy->NotifyActorBeginOverlap(World->GetWorldSettings());
+	}
+
+	struct FSoakResult
+	{
+		double TotalSeconds = 0.0;
+		double WorstSeconds = 0.0;
+		double P99Seconds = 0.0;
+	};
+
+	//Runs a series of crises (spawn, kill and clean up every thug) and times each one, including the GC runs that spawning and destroying actors leads to
+	static FSoakResult RunSoak(UWorld* World, bool bPooling, int NumCrises, int ThugsPerCrisis)
+	{
+		UEnemyPoolSubsystem* EnemyPool = World->GetSubsystem<UEnemyPoolSubsystem>();
+		EnemyPool->SetPoolingEnabled(bPooling);
+
+		//Let the first crisis pay for the pool, like the game mode's prewarm would
+		EnemyPool->Prewarm(AEnemyCharacter::StaticClass(), ThugsPerCrisis);
+
+		TArray<double> CrisisSeconds;
+		TArray<AEnemyCharacter*> Thugs;
+
+		for (int Crisis = 0; Crisis < NumCrises; Crisis++)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			Thugs.Reset();
+			for (int Thug = 0; Thug < ThugsPerCrisis; Thug++)
+			{
+				const FVector Location(Crisis * 1000.0, Thug * 200.0, 100.0);
+				Thugs.Add(EnemyPool->AcquireEnemy(AEnemyCharacter::StaticClass(), Location, FRotator::ZeroRotator));
+			}
+
+			for (AEnemyCharacter* Enemy : Thugs)
+			{
+				if (Enemy != nullptr)
+				{
+					KillEnemy(World, Enemy);
+					EnemyPool->ReleaseEnemy(Enemy);
+				}
+			}
+
+			if ((Crisis % 8) == 7)
+			{
+				CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+			}
+
+			CrisisSeconds.Add(FPlatformTime::Seconds() - StartTime);
+		}
+
+		FSoakResult Result;
+		for (double Seconds : CrisisSeconds)
+		{
+			Result.TotalSeconds += Seconds;
+		}
+
+		CrisisSeconds.Sort();
+		Result.WorstSeconds = CrisisSeconds.Last();
+		Result.P99Seconds = CrisisSeconds[FMath::Min(CrisisSeconds.Num() - 1, (CrisisSeconds.Num() * 99) / 100)];
+
+		EnemyPool->SetPoolingEnabled(true);
+		return Result;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEnemyPoolReuseTest, "SecretIdentity.EnemyPool.Reuse", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FEnemyPoolReuseTest::RunTest(const FString& Parameters)
+{
+	using namespace EnemyPoolTests;
+
+	FScopedTestWorld TestWorld;
+	UEnemyPoolSubsystem* EnemyPool = TestWorld.World->GetSubsystem<UEnemyPoolSubsystem>();
+	if (!TestNotNull(TEXT("Enemy pool subsystem"), EnemyPool))
+	{
+		return false;
+	}
+
+	AEnemyCharacter* Enemy = EnemyPool->AcquireEnemy(AEnemyCharacter::StaticClass(), FVector::ZeroVector, FRotator::ZeroRotator);
+	if (!TestNotNull(TEXT("Spawned enemy"), Enemy))
+	{
+		return false;
+	}
+
+	const ECollisionEnabled::Type CapsuleCollision = Enemy->GetCapsuleComponent()->GetCollisionEnabled();
+
+	KillEnemy(TestWorld.World, Enemy);
+	TestTrue(TEXT("Enemy is dead"), Enemy->IsDead());
+
+	EnemyPool->ReleaseEnemy(Enemy);
+	TestTrue(TEXT("Enemy is in the pool"), Enemy->IsInPool());
+	TestTrue(TEXT("Pooled enemy is hidden"), Enemy->IsHidden());
+	TestEqual(TEXT("Pool size"), EnemyPool->GetNumPooledEnemies(AEnemyCharacter::StaticClass()), 1);
+
+	const FVector NewLocation(500.0, 0.0, 100.0);
+	AEnemyCharacter* Reused = EnemyPool->AcquireEnemy(AEnemyCharacter::StaticClass(), NewLocation, FRotator::ZeroRotator);
+	TestTrue(TEXT("Enemy was reused"), Reused == Enemy);
+	TestFalse(TEXT("Reused enemy is alive"), Reused->IsDead());
+	TestFalse(TEXT("Reused enemy is out of the pool"), Reused->IsInPool());
+	TestFalse(TEXT("Reused enemy is visible"), Reused->IsHidden());
+	TestFalse(TEXT("Reused enemy is not a ragdoll"), Reused->GetMesh()->IsSimulatingPhysics());
+	TestEqual(TEXT("Capsule collision is restored"), Reused->GetCapsuleComponent()->GetCollisionEnabled(), CapsuleCollision);
+	TestTrue(TEXT("Reused enemy was moved"), Reused->GetActorLocation().Equals(NewLocation, 1.0));
+
+	EnemyPool->SetPoolingEnabled(false);
+	EnemyPool->ReleaseEnemy(Reused);
+	TestTrue(TEXT("Released enemy is destroyed when pooling is disabled"), !IsValid(Reused));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEnemyPoolSoakBenchmark, "SecretIdentity.EnemyPool.SoakBenchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FEnemyPoolSoakBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace EnemyPoolTests;
+
+	const int NumCrises = 256;
+	const int ThugsPerCrisis = 4;
+
+	FScopedTestWorld TestWorld;
+
+	const FSoakResult Spawned = RunSoak(TestWorld.World, false, NumCrises, ThugsPerCrisis);
+	const FSoakResult Pooled = RunSoak(TestWorld.World, true, NumCrises, ThugsPerCrisis);
+
+	AddInfo(FString::Printf(TEXT("%d crises of %d thugs, spawn/destroy: total %.2fms, p99 %.3fms, worst %.3fms"), NumCrises, ThugsPerCrisis, Spawned.TotalSeconds * 1000.0, Spawned.P99Seconds * 1000.0, Spawned.WorstSeconds * 1000.0));
+	AddInfo(FString::Printf(TEXT("%d crises of %d thugs, pooled: total %.2fms, p99 %.3fms, worst %.3fms"), NumCrises, ThugsPerCrisis, Pooled.TotalSeconds * 1000.0, Pooled.P99Seconds * 1000.0, Pooled.WorstSeconds * 1000.0));
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
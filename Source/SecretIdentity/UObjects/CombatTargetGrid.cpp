@@ -0,0 +1,237 @@
+// Copyright Carter Rennick, 2024. All Rights Reserved.
+
+#include "SecretIdentity/UObjects/CombatTargetGrid.h"
+
+#include "SecretIdentity/UE_Helpers.h"
+
+FCombatTargetGrid::FCombatTargetGrid(double InCellSize)
+	: fCellSize(InCellSize)
+{
+	WARN_IF(fCellSize <= 0.0);
+	if (fCellSize <= 0.0)
+	{
+		fCellSize = 1000.0;
+	}
+}
+
+void FCombatTargetGrid::Add(uint32 Id, const FVector& Location)
+{
+	if (tTargets.Contains(Id))
+	{
+		Move(Id, Location);
+		return;
+	}
+
+	const FIntPoint Cell = GetCell(Location);
+	tTargets.Add(Id, { Location, Cell });
+	AddToCell(Id, Cell);
+}
+
+void FCombatTargetGrid::Move(uint32 Id, const FVector& Location)
+{
+	FTarget* Target = tTargets.Find(Id);
+	if (Target == nullptr)
+	{
+		return;
+	}
+
+	Target->Location = Location;
+
+	//Most moves stay inside the same cell, only touch the cells when they don't
+	const FIntPoint Cell = GetCell(Location);
+	if (Cell != Target->Cell)
+	{
+		RemoveFromCell(Id, Target->Cell);
+		AddToCell(Id, Cell);
+		Target->Cell = Cell;
+	}
+}
+
+void FCombatTargetGrid::Remove(uint32 Id)
+{
+	FTarget Target;
+	if (tTargets.RemoveAndCopyValue(Id, Target))
+	{
+		RemoveFromCell(Id, Target.Cell);
+	}
+}
+
+void FCombatTargetGrid::Reset()
+{
+	tTargets.Reset();
+	tCells.Reset();
+}
+
+bool FCombatTargetGrid::FindNearest(const FVector& Origin, double Radius, uint32& OutId, TFunctionRef<bool(uint32 Id, const FVector& Location)> Filter) const
+{
+	if (tTargets.IsEmpty() || Radius < 0.0)
+	{
+		return false;
+	}
+
+	const FIntPoint Center = GetCell(Origin);
+	double BestDistanceSquared = FMath::Square(Radius);
+	bool bFound = false;
+
+	auto VisitCell = [&](const TArray<uint32>& Ids)
+	{
+		for (uint32 Id : Ids)
+		{
+			const FVector& Location = tTargets.FindChecked(Id).Location;
+			const double DistanceSquared = FVector::DistSquared(Origin, Location);
+			if ((DistanceSquared < BestDistanceSquared || (!bFound && DistanceSquared <= BestDistanceSquared)) && Filter(Id, Location))
+			{
+				OutId = Id;
+				BestDistanceSquared = DistanceSquared;
+				bFound = true;
+			}
+		}
+	};
+
+	const int MaxRing = static_cast<int>(FMath::Min(FMath::CeilToDouble(Radius / fCellSize), static_cast<double>(MAX_int32 / 4)));
+
+	for (int Ring = 0; Ring <= MaxRing; Ring++)
+	{
+		//Origin can be anywhere in its cell, so the cells in this ring are at least (Ring - 1) cells away
+		if (Ring > 0 && FMath::Square((Ring - 1) * fCellSize) > BestDistanceSquared)
+		{
+			break;
+		}
+
+		//Once the rings cover more cells than there are occupied ones, it's cheaper to look at the remaining occupied cells directly
+		const int64 RingSide = 2 * static_cast<int64>(Ring) + 1;
+		if (RingSide * RingSide > tCells.Num())
+		{
+			for (const TPair<FIntPoint, TArray<uint32>>& Cell : tCells)
+			{
+				const int CellRing = FMath::Max(FMath::Abs(Cell.Key.X - Center.X), FMath::Abs(Cell.Key.Y - Center.Y));
+				if (CellRing >= Ring && CellRing <= MaxRing)
+				{
+					VisitCell(Cell.Value);
+				}
+			}
+			break;
+		}
+
+		//Walk the border of the square of cells Ring cells away from the center
+		for (int X = -Ring; X <= Ring; X++)
+		{
+			const bool bFullColumn = (X == -Ring || X == Ring);
+			const int Step = bFullColumn ? 1 : FMath::Max(2 * Ring, 1);
+			for (int Y = -Ring; Y <= Ring; Y += Step)
+			{
+				if (const TArray<uint32>* Ids = tCells.Find(FIntPoint(Center.X + X, Center.Y + Y)))
+				{
+					VisitCell(*Ids);
+				}
+			}
+		}
+	}
+
+	return bFound;
+}
+
+bool FCombatTargetGrid::FindNearest(const FVector& Origin, double Radius, uint32& OutId) const
+{
+	return FindNearest(Origin, Radius, OutId, [](uint32, const FVector&) { return true; });
+}
+
+bool FCombatTargetGrid::FindNearestInCone(const FVector& Origin, const FVector& Direction, double HalfAngleDegrees, double Radius, uint32& OutId, TFunctionRef<bool(uint32 Id, const FVector& Location)> Filter) const
+{
+	const FVector ConeDirection = Direction.GetSafeNormal();
+	WARN_IF_MSG(ConeDirection.IsZero(), "FindNearestInCone called without a direction");
+
+	const double MinCosAngle = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(HalfAngleDegrees, 0.0, 180.0)));
+
+	return FindNearest(Origin, Radius, OutId, [&](uint32 Id, const FVector& Location)
+	{
+		return FVector::DotProduct((Location - Origin).GetSafeNormal(), ConeDirection) >= MinCosAngle && Filter(Id, Location);
+	});
+}
+
+bool FCombatTargetGrid::FindNearestInCone(const FVector& Origin, const FVector& Direction, double HalfAngleDegrees, double Radius, uint32& OutId) const
+{
+	return FindNearestInCone(Origin, Direction, HalfAngleDegrees, Radius, OutId, [](uint32, const FVector&) { return true; });
+}
+
+void FCombatTargetGrid::FindInRadius(const FVector& Origin, double Radius, TArray<uint32>& OutIds) const
+{
+	if (tTargets.IsEmpty() || Radius < 0.0)
+	{
+		return;
+	}
+
+	const double RadiusSquared = FMath::Square(Radius);
+	auto VisitCell = [&](const TArray<uint32>& Ids)
+	{
+		for (uint32 Id : Ids)
+		{
+			if (FVector::DistSquared(Origin, tTargets.FindChecked(Id).Location) <= RadiusSquared)
+			{
+				OutIds.Add(Id);
+			}
+		}
+	};
+
+	//Same as FindNearest, when the search box is bigger than the number of occupied cells just look at those
+	const double NumCellsAcross = 2.0 * Radius / fCellSize + 2.0;
+	if (FMath::Square(NumCellsAcross) > tCells.Num())
+	{
+		for (const TPair<FIntPoint, TArray<uint32>>& Cell : tCells)
+		{
+			VisitCell(Cell.Value);
+		}
+		return;
+	}
+
+	const FIntPoint MinCell = GetCell(Origin - FVector(Radius, Radius, 0.0));
+	const FIntPoint MaxCell = GetCell(Origin + FVector(Radius, Radius, 0.0));
+
+	for (int X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			if (const TArray<uint32>* Ids = tCells.Find(FIntPoint(X, Y)))
+			{
+				VisitCell(*Ids);
+			}
+		}
+	}
+}
+
+void FCombatTargetGrid::GetAll(TArray<uint32>& OutIds) const
+{
+	OutIds.Reserve(OutIds.Num() + tTargets.Num());
+	for (const TPair<uint32, FTarget>& Target : tTargets)
+	{
+		OutIds.Add(Target.Key);
+	}
+}
+
+FIntPoint FCombatTargetGrid::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / fCellSize), FMath::FloorToInt32(Location.Y / fCellSize));
+}
+
+void FCombatTargetGrid::AddToCell(uint32 Id, const FIntPoint& Cell)
+{
+	tCells.FindOrAdd(Cell).Add(Id);
+}
+
+void FCombatTargetGrid::RemoveFromCell(uint32 Id, const FIntPoint& Cell)
+{
+	TArray<uint32>* Ids = tCells.Find(Cell);
+	WARN_IF_NULL(Ids);
+	if (Ids == nullptr)
+	{
+		return;
+	}
+
+	Ids->RemoveSingleSwap(Id, EAllowShrinking::No);
+
+	//Only keep occupied cells, searches rely on the number of cells to decide how to look through them
+	if (Ids->IsEmpty())
+	{
+		tCells.Remove(Cell);
+	}
+}
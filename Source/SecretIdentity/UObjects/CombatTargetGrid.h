@@ -0,0 +1,51 @@
+// Copyright Carter Rennick, 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Uniform grid of points on the XY plane, used to find combat targets near a location without looking at every target in the level
+//Targets are identified by an id chosen by the caller (see UCombatTargetSubsystem), distances are measured in 3D
+class SECRETIDENTITY_API FCombatTargetGrid
+{
+public:
+	explicit FCombatTargetGrid(double InCellSize = 1000.0);
+
+	void Add(uint32 Id, const FVector& Location); //Moves the target if it was already added
+	void Move(uint32 Id, const FVector& Location); //Does nothing if the target was never added
+	void Remove(uint32 Id); //Does nothing if the target was never added
+	void Reset();
+
+	FORCEINLINE bool Contains(uint32 Id) const { return tTargets.Contains(Id); }
+	FORCEINLINE int Num() const { return tTargets.Num(); }
+	FORCEINLINE double GetCellSize() const { return fCellSize; }
+
+	//Nearest target within Radius of Origin that passes the filter, returns false if there is none
+	//Searches outwards from the cell containing Origin one ring of cells at a time, and stops as soon as no unvisited cell can hold anything nearer
+	bool FindNearest(const FVector& Origin, double Radius, uint32& OutId, TFunctionRef<bool(uint32 Id, const FVector& Location)> Filter) const;
+	bool FindNearest(const FVector& Origin, double Radius, uint32& OutId) const;
+
+	//Nearest target within Radius of Origin and within HalfAngleDegrees of Direction, returns false if there is none
+	bool FindNearestInCone(const FVector& Origin, const FVector& Direction, double HalfAngleDegrees, double Radius, uint32& OutId, TFunctionRef<bool(uint32 Id, const FVector& Location)> Filter) const;
+	bool FindNearestInCone(const FVector& Origin, const FVector& Direction, double HalfAngleDegrees, double Radius, uint32& OutId) const;
+
+	//Every target within Radius of Origin, in no particular order
+	void FindInRadius(const FVector& Origin, double Radius, TArray<uint32>& OutIds) const;
+
+	void GetAll(TArray<uint32>& OutIds) const;
+
+private:
+	struct FTarget
+	{
+		FVector Location;
+		FIntPoint Cell;
+	};
+
+	double fCellSize;
+	TMap<uint32, FTarget> tTargets;
+	TMap<FIntPoint, TArray<uint32>> tCells;
+
+	FIntPoint GetCell(const FVector& Location) const;
+	void AddToCell(uint32 Id, const FIntPoint& Cell);
+	void RemoveFromCell(uint32 Id, const FIntPoint& Cell);
+};
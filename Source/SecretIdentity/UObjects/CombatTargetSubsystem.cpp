@@ -0,0 +1,177 @@
+// Copyright Carter Rennick, 2024. All Rights Reserved.
+
+#include "SecretIdentity/UObjects/CombatTargetSubsystem.h"
+
+#include "Components/SceneComponent.h"
+#include "GameFramework/Actor.h"
+
+#include "SecretIdentity/UE_Helpers.h"
+
+void UCombatTargetSubsystem::Deinitialize()
+{
+	for (const TPair<uint32, FRegisteredTarget>& Target : tRegisteredTargets)
+	{
+		if (USceneComponent* RootComponent = Target.Value.RootComponent.Get())
+		{
+			RootComponent->TransformUpdated.Remove(Target.Value.TransformUpdatedHandle);
+		}
+	}
+
+	tRegisteredTargets.Empty();
+	for (FCombatTargetGrid& Grid : Grids)
+	{
+		Grid.Reset();
+	}
+
+	Super::Deinitialize();
+}
+
+void UCombatTargetSubsystem::RegisterTarget(AActor* Actor, ECombatTargetType Type)
+{
+	WARN_IF_NULL(Actor);
+	WARN_IF(Type >= ECombatTargetType::Count);
+	if (Actor == nullptr || Type >= ECombatTargetType::Count)
+	{
+		return;
+	}
+
+	UnregisterTarget(Actor);
+
+	FRegisteredTarget& Target = tRegisteredTargets.Add(Actor->GetUniqueID());
+	Target.Actor = Actor;
+	Target.Type = Type;
+
+	//Follow the root component so moving targets stay in the right cell, actors without one never move
+	if (USceneComponent* RootComponent = Actor->GetRootComponent())
+	{
+		Target.RootComponent = RootComponent;
+		Target.TransformUpdatedHandle = RootComponent->TransformUpdated.AddUObject(this, &UCombatTargetSubsystem::OnTargetTransformUpdated);
+	}
+
+	Grids[static_cast<int>(Type)].Add(Actor->GetUniqueID(), Actor->GetActorLocation());
+}
+
+void UCombatTargetSubsystem::UnregisterTarget(AActor* Actor)
+{
+	if (Actor == nullptr)
+	{
+		return;
+	}
+
+	FRegisteredTarget Target;
+	if (!tRegisteredTargets.RemoveAndCopyValue(Actor->GetUniqueID(), Target))
+	{
+		return;
+	}
+
+	if (USceneComponent* RootComponent = Target.RootComponent.Get())
+	{
+		RootComponent->TransformUpdated.Remove(Target.TransformUpdatedHandle);
+	}
+
+	Grids[static_cast<int>(Target.Type)].Remove(Actor->GetUniqueID());
+}
+
+bool UCombatTargetSubsystem::IsTargetRegistered(const AActor* Actor) const
+{
+	return Actor != nullptr && tRegisteredTargets.Contains(Actor->GetUniqueID());
+}
+
+int UCombatTargetSubsystem::GetNumTargets(ECombatTargetType Type) const
+{
+	WARN_IF(Type >= ECombatTargetType::Count);
+	return Type < ECombatTargetType::Count ? Grids[static_cast<int>(Type)].Num() : 0;
+}
+
+AActor* UCombatTargetSubsystem::FindNearestTarget(ECombatTargetType Type, const FVector& Origin, double Radius) const
+{
+	WARN_IF(Type >= ECombatTargetType::Count);
+	if (Type >= ECombatTargetType::Count)
+	{
+		return nullptr;
+	}
+
+	//Skip targets that were destroyed without unregistering, rather than returning nothing
+	uint32 Id = 0;
+	const bool bFound = Grids[static_cast<int>(Type)].FindNearest(Origin, Radius, Id, [this](uint32 CandidateId, const FVector&)
+	{
+		return GetTargetActor(CandidateId) != nullptr;
+	});
+
+	return bFound ? GetTargetActor(Id) : nullptr;
+}
+
+AActor* UCombatTargetSubsystem::FindNearestTargetInCone(ECombatTargetType Type, const FVector& Origin, const FVector& Direction, double HalfAngleDegrees, double Radius) const
+{
+	WARN_IF(Type >= ECombatTargetType::Count);
+	if (Type >= ECombatTargetType::Count)
+	{
+		return nullptr;
+	}
+
+	uint32 Id = 0;
+	const bool bFound = Grids[static_cast<int>(Type)].FindNearestInCone(Origin, Direction, HalfAngleDegrees, Radius, Id, [this](uint32 CandidateId, const FVector&)
+	{
+		return GetTargetActor(CandidateId) != nullptr;
+	});
+
+	return bFound ? GetTargetActor(Id) : nullptr;
+}
+
+void UCombatTargetSubsystem::FindTargetsInRadius(ECombatTargetType Type, const FVector& Origin, double Radius, TArray<AActor*>& OutActors) const
+{
+	WARN_IF(Type >= ECombatTargetType::Count);
+	if (Type >= ECombatTargetType::Count)
+	{
+		return;
+	}
+
+	TArray<uint32> Ids;
+	Grids[static_cast<int>(Type)].FindInRadius(Origin, Radius, Ids);
+	GetTargetActors(Ids, OutActors);
+}
+
+void UCombatTargetSubsystem::GetAllTargets(ECombatTargetType Type, TArray<AActor*>& OutActors) const
+{
+	WARN_IF(Type >= ECombatTargetType::Count);
+	if (Type >= ECombatTargetType::Count)
+	{
+		return;
+	}
+
+	TArray<uint32> Ids;
+	Grids[static_cast<int>(Type)].GetAll(Ids);
+	GetTargetActors(Ids, OutActors);
+}
+
+void UCombatTargetSubsystem::OnTargetTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	AActor* Actor = UpdatedComponent != nullptr ? UpdatedComponent->GetOwner() : nullptr;
+	if (Actor == nullptr)
+	{
+		return;
+	}
+
+	if (const FRegisteredTarget* Target = tRegisteredTargets.Find(Actor->GetUniqueID()))
+	{
+		Grids[static_cast<int>(Target->Type)].Move(Actor->GetUniqueID(), UpdatedComponent->GetComponentLocation());
+	}
+}
+
+AActor* UCombatTargetSubsystem::GetTargetActor(uint32 Id) const
+{
+	const FRegisteredTarget* Target = tRegisteredTargets.Find(Id);
+	return Target != nullptr ? Target->Actor.Get() : nullptr;
+}
+
+void UCombatTargetSubsystem::GetTargetActors(const TArray<uint32>& Ids, TArray<AActor*>& OutActors) const
+{
+	OutActors.Reserve(OutActors.Num() + Ids.Num());
+	for (uint32 Id : Ids)
+	{
+		if (AActor* Actor = GetTargetActor(Id))
+		{
+			OutActors.Add(Actor);
+		}
+	}
+}
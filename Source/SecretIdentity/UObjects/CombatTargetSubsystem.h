@@ -0,0 +1,57 @@
+// Copyright Carter Rennick, 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "SecretIdentity/UObjects/CombatTargetGrid.h"
+
+#include "CombatTargetSubsystem.generated.h"
+
+UENUM()
+enum class ECombatTargetType : uint8
+{
+	Enemy,
+	CrisisSpawnPoint,
+
+	Count UMETA(Hidden)
+};
+
+//Keeps track of where the live combat-relevant actors are, so gameplay code can find them without GetAllActorsOfClass
+//Actors register themselves (see AEnemyCharacter and ACrisisSpawnPoint) and are kept up to date as their root component moves
+UCLASS()
+class SECRETIDENTITY_API UCombatTargetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	void RegisterTarget(AActor* Actor, ECombatTargetType Type); //Registering again changes the type
+	void UnregisterTarget(AActor* Actor); //Does nothing if the actor is not registered
+
+	bool IsTargetRegistered(const AActor* Actor) const;
+	int GetNumTargets(ECombatTargetType Type) const;
+
+	AActor* FindNearestTarget(ECombatTargetType Type, const FVector& Origin, double Radius) const; //Nullptr if there's nothing within Radius
+	AActor* FindNearestTargetInCone(ECombatTargetType Type, const FVector& Origin, const FVector& Direction, double HalfAngleDegrees, double Radius) const;
+	void FindTargetsInRadius(ECombatTargetType Type, const FVector& Origin, double Radius, TArray<AActor*>& OutActors) const;
+	void GetAllTargets(ECombatTargetType Type, TArray<AActor*>& OutActors) const;
+
+private:
+	struct FRegisteredTarget
+	{
+		TWeakObjectPtr<AActor> Actor;
+		TWeakObjectPtr<USceneComponent> RootComponent;
+		ECombatTargetType Type;
+		FDelegateHandle TransformUpdatedHandle;
+	};
+
+	FCombatTargetGrid Grids[static_cast<int>(ECombatTargetType::Count)];
+	TMap<uint32, FRegisteredTarget> tRegisteredTargets; //Keyed on the actor's unique id, which is also the id used in the grids
+
+	void OnTargetTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+	AActor* GetTargetActor(uint32 Id) const;
+	void GetTargetActors(const TArray<uint32>& Ids, TArray<AActor*>& OutActors) const;
+};
@@ -0,0 +1,109 @@
+// Copyright Carter Rennick, 2024. All Rights Reserved.
+
+#include "SecretIdentity/UObjects/EnemyPoolSubsystem.h"
+
+#include "Engine/World.h"
+
+#include "SecretIdentity/UE_Helpers.h"
+#include "SecretIdentity/Characters/EnemyCharacter.h"
+
+AEnemyCharacter* UEnemyPoolSubsystem::AcquireEnemy(TSubclassOf<ACharacter> EnemyClass, const FVector& Location, const FRotator& Rotation)
+{
+	WARN_IF_NULL(EnemyClass);
+	if (EnemyClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (FEnemyPoolBucket* Bucket = tPooledEnemies.Find(EnemyClass))
+	{
+		//Most recently released first, it's the most likely to still be warm in the cache
+		while (!Bucket->Enemies.IsEmpty())
+		{
+			AEnemyCharacter* Enemy = Bucket->Enemies.Pop();
+			if (IsValid(Enemy))
+			{
+				Enemy->ReactivateFromPool(Location, Rotation);
+				return Enemy;
+			}
+		}
+	}
+
+	return SpawnEnemy(EnemyClass, Location, Rotation);
+}
+
+void UEnemyPoolSubsystem::ReleaseEnemy(AEnemyCharacter* Enemy)
+{
+	if (!IsValid(Enemy) || Enemy->IsInPool())
+	{
+		return;
+	}
+
+	FEnemyPoolBucket& Bucket = tPooledEnemies.FindOrAdd(Enemy->GetClass());
+	if (!bPoolingEnabled || Bucket.Enemies.Num() >= MaxPooledEnemiesPerClass)
+	{
+		Enemy->Destroy();
+		return;
+	}
+
+	Enemy->DeactivateForPool();
+	Bucket.Enemies.Add(Enemy);
+}
+
+void UEnemyPoolSubsystem::Prewarm(TSubclassOf<ACharacter> EnemyClass, int Count)
+{
+	if (!bPoolingEnabled || EnemyClass == nullptr)
+	{
+		return;
+	}
+
+	const int NumToSpawn = FMath::Min(Count, MaxPooledEnemiesPerClass) - GetNumPooledEnemies(EnemyClass);
+	for (int i = 0; i < NumToSpawn; i++)
+	{
+		ReleaseEnemy(SpawnEnemy(EnemyClass, FVector::ZeroVector, FRotator::ZeroRotator));
+	}
+}
+
+void UEnemyPoolSubsystem::SetPoolingEnabled(bool bEnabled)
+{
+	bPoolingEnabled = bEnabled;
+
+	if (!bPoolingEnabled)
+	{
+		for (TPair<UClass*, FEnemyPoolBucket>& Pair : tPooledEnemies)
+		{
+			for (AEnemyCharacter* Enemy : Pair.Value.Enemies)
+			{
+				if (IsValid(Enemy))
+				{
+					Enemy->Destroy();
+				}
+			}
+		}
+
+		tPooledEnemies.Empty();
+	}
+}
+
+int UEnemyPoolSubsystem::GetNumPooledEnemies(TSubclassOf<ACharacter> EnemyClass) const
+{
+	const FEnemyPoolBucket* Bucket = tPooledEnemies.Find(EnemyClass);
+	return Bucket != nullptr ? Bucket->Enemies.Num() : 0;
+}
+
+AEnemyCharacter* UEnemyPoolSubsystem::SpawnEnemy(TSubclassOf<ACharacter> EnemyClass, const FVector& Location, const FRotator& Rotation)
+{
+	WARN_IF_NULL(GetWorld());
+	if (GetWorld() == nullptr)
+	{
+		return nullptr;
+	}
+
+	AEnemyCharacter* Enemy = Cast<AEnemyCharacter>(GetWorld()->SpawnActor(EnemyClass, &Location, &Rotation));
+	if (Enemy == nullptr)
+	{
+		LOG_MSG_WARNING("EnemyClass is not an AEnemyCharacter or could not be spawned");
+	}
+
+	return Enemy;
+}
@@ -0,0 +1,54 @@
+// Copyright Carter Rennick, 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "EnemyPoolSubsystem.generated.h"
+
+class ACharacter;
+class AEnemyCharacter;
+
+USTRUCT()
+struct FEnemyPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<AEnemyCharacter*> Enemies;
+};
+
+//Keeps defeated enemies around and hands them back out instead of spawning and destroying an actor for every thug
+//Crises spawn enemies exactly when the game is busiest, so this avoids actor construction, component registration and GC churn at that time
+UCLASS()
+class SECRETIDENTITY_API UEnemyPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//Returns a pooled enemy of the given class moved to the given location, or spawns a new one if none are available
+	AEnemyCharacter* AcquireEnemy(TSubclassOf<ACharacter> EnemyClass, const FVector& Location, const FRotator& Rotation);
+
+	//Hides the enemy and keeps it for a later AcquireEnemy call. Destroys it if pooling is disabled or the pool is full
+	void ReleaseEnemy(AEnemyCharacter* Enemy);
+
+	//Spawns enemies up front so the first crises don't pay for it
+	void Prewarm(TSubclassOf<ACharacter> EnemyClass, int Count);
+
+	//Mostly for benchmarking, with pooling disabled enemies are always spawned and destroyed
+	void SetPoolingEnabled(bool bEnabled);
+	FORCEINLINE bool IsPoolingEnabled() const { return bPoolingEnabled; }
+
+	int GetNumPooledEnemies(TSubclassOf<ACharacter> EnemyClass) const;
+
+	static constexpr int MaxPooledEnemiesPerClass = 64;
+
+private:
+	UPROPERTY()
+	TMap<UClass*, FEnemyPoolBucket> tPooledEnemies;
+
+	bool bPoolingEnabled = true;
+
+	AEnemyCharacter* SpawnEnemy(TSubclassOf<ACharacter> EnemyClass, const FVector& Location, const FRotator& Rotation);
+};